@@ -23,6 +23,7 @@
 #include "itkImageSamplerBase.h"
 #include "itkGradientImageFilter.h"
 #include "itkBSplineInterpolateImageFunction.h"
+#include "itkBrickedBSplineInterpolateImageFunction.h"
 #include "itkReducedDimensionBSplineInterpolateImageFunction.h"
 #include "itkAdvancedLinearInterpolateImageFunction.h"
 #include "itkLimiterFunctionBase.h"
@@ -37,6 +38,7 @@
 #include "itkAdvancedCombinationTransform.h"
 
 #include "itkMultiThreader.h"
+#include "itkWorkStealingThreadPool.h"
 
 namespace itk
 {
@@ -144,6 +146,8 @@ public:
   typedef typename ImageSamplerType::Pointer                      ImageSamplerPointer;
   typedef typename ImageSamplerType::OutputVectorContainerType    ImageSampleContainerType;
   typedef typename ImageSamplerType::OutputVectorContainerPointer ImageSampleContainerPointer;
+  typedef typename
+    ImageSamplerType::ImageSampleStructureOfArraysType ImageSampleStructureOfArraysType;
 
   /** Typedefs for Limiter support. */
   typedef LimiterFunctionBase< RealType, FixedImageDimension >  FixedImageLimiterType;
@@ -283,6 +287,24 @@ public:
   itkGetConstReferenceMacro( UseMultiThread, bool );
   itkBooleanMacro( UseMultiThread );
 
+  /** Select the use of the elastix-wide WorkStealingThreadPool, instead of
+   * creating and joining a new set of threads at every metric evaluation.
+   * Default: false.
+   */
+  itkSetMacro( UseThreadPool, bool );
+  itkGetConstReferenceMacro( UseThreadPool, bool );
+  itkBooleanMacro( UseThreadPool );
+
+  /** Select dynamic load balancing of the image samples over the threads.
+   * Only has effect when the thread pool is used, and the metric supports it.
+   * The samples are then processed in chunks, and idle threads steal chunks
+   * from busy threads. Note that the order of summation then depends on the
+   * thread scheduling, so results are not bitwise reproducible. Default: false.
+   */
+  itkSetMacro( UseDynamicLoadBalancing, bool );
+  itkGetConstReferenceMacro( UseDynamicLoadBalancing, bool );
+  itkBooleanMacro( UseDynamicLoadBalancing );
+
   /** Contains calls from GetValueAndDerivative that are thread-unsafe,
    * together with preparation for multi-threading.
    * Note that the only reason why this function is not protected, is
@@ -291,6 +313,20 @@ public:
   virtual void BeforeThreadedGetValueAndDerivative(
     const TransformParametersType & parameters ) const;
 
+  /** Get whether GetValueAndDerivative() may run concurrently with that of
+   * other metrics that share the transform, as the CombinationImageToImageMetric
+   * does. This is the case when, after BeforeThreadedGetValueAndDerivative()
+   * was called with UseMetricSingleThreaded on and this flag was switched off,
+   * GetValueAndDerivative() does not modify the transform, nor any other
+   * object that it shares with other metrics. Metrics that guarantee this
+   * override this function. Default: false.
+   */
+  virtual bool GetSupportsConcurrentGetValueAndDerivative( void ) const
+  {
+    return false;
+  }
+
+
 protected:
 
   /** Constructor. */
@@ -319,6 +355,12 @@ protected:
   typedef BSplineInterpolateImageFunction<
     MovingImageType, CoordinateRepresentationType, float >       BSplineInterpolatorFloatType;
   typedef typename BSplineInterpolatorFloatType::Pointer BSplineInterpolatorFloatPointer;
+  typedef BrickedBSplineInterpolateImageFunction<
+    MovingImageType, CoordinateRepresentationType, double >      BrickedBSplineInterpolatorType;
+  typedef typename BrickedBSplineInterpolatorType::Pointer BrickedBSplineInterpolatorPointer;
+  typedef BrickedBSplineInterpolateImageFunction<
+    MovingImageType, CoordinateRepresentationType, float >       BrickedBSplineInterpolatorFloatType;
+  typedef typename BrickedBSplineInterpolatorFloatType::Pointer BrickedBSplineInterpolatorFloatPointer;
   typedef ReducedDimensionBSplineInterpolateImageFunction<
     MovingImageType, CoordinateRepresentationType, double >      ReducedBSplineInterpolatorType;
   typedef typename ReducedBSplineInterpolatorType::Pointer ReducedBSplineInterpolatorPointer;
@@ -333,6 +375,15 @@ protected:
   /** Typedefs for support of sparse Jacobians and compact support of transformations. */
   typedef typename
     AdvancedTransformType::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
+  typedef typename
+    AdvancedTransformType::NonZeroJacobianIndicesValueType NonZeroJacobianIndicesValueType;
+  typedef typename
+    AdvancedTransformType::MovingImageGradientType TransformMovingImageGradientType;
+
+  /** The number of samples that the threaded functions process as a block,
+   * using the batch functions of the transform.
+   */
+  itkStaticConstMacro( SampleBlockSize, unsigned int, 64 );
 
   /** Protected Variables **************/
 
@@ -341,6 +392,15 @@ protected:
    */
   mutable ImageSamplerPointer m_ImageSampler;
 
+  /** The samples of the image sampler as contiguous coordinate and value arrays.
+   * Set in BeforeThreadedGetValueAndDerivative(), for use in the threaded functions,
+   * if m_UseImageSampleStructureOfArrays is true. Metrics that read these arrays
+   * should set it to true in their constructor; the image sampler then fills
+   * the arrays while sampling. Default: false, which saves their memory.
+   */
+  mutable typename ImageSampleStructureOfArraysType::ConstPointer m_ImageSampleStructureOfArrays;
+  bool                                                            m_UseImageSampleStructureOfArrays;
+
   /** Variables for image derivative computation. */
   bool                                   m_InterpolatorIsLinear;
   bool                                   m_InterpolatorIsBSpline;
@@ -351,6 +411,10 @@ protected:
   BSplineInterpolatorFloatPointer        m_BSplineInterpolatorFloat;
   ReducedBSplineInterpolatorPointer      m_ReducedBSplineInterpolator;
 
+  /** The B-spline interpolators again, if they support bricked coefficients. */
+  BrickedBSplineInterpolatorPointer      m_BrickedBSplineInterpolator;
+  BrickedBSplineInterpolatorFloatPointer m_BrickedBSplineInterpolatorFloat;
+
   CentralDifferenceGradientFilterPointer m_CentralDifferenceGradientFilter;
 
   /** Variables to store the AdvancedTransform. */
@@ -406,13 +470,32 @@ protected:
   /** Launch MultiThread GetValueAndDerivative. */
   void LaunchGetValueAndDerivativeThreaderCallback( void ) const;
 
+  /** Multi-threaded version of GetValueAndDerivative(), restricted to the
+   * samples [begin, end) of the sample container. The results should be
+   * added to the per-thread variables of threadID, since a thread may
+   * process several ranges. Metrics that implement this function should set
+   * m_SupportsDynamicLoadBalancing to true in their constructor.
+   */
+  virtual inline void ThreadedGetValueAndDerivativeForSampleRange(
+    ThreadIdType itkNotUsed( threadID ), SizeValueType itkNotUsed( begin ),
+    SizeValueType itkNotUsed( end ) ){}
+
   /** AccumulateDerivatives threader callback function. */
   static ITK_THREAD_RETURN_TYPE AccumulateDerivativesThreaderCallback( void * arg );
 
+  /** Launch a threader callback for all threads, either on the elastix-wide
+   * thread pool or on m_Threader. The callback receives a ThreadInfoType
+   * with the ThreadID, NumberOfThreads and UserData filled in.
+   */
+  void LaunchThreaderCallback( ThreadFunctionType callback, void * userData ) const;
+
   /** Variables for multi-threading. */
   bool m_UseMetricSingleThreaded;
   bool m_UseMultiThread;
   bool m_UseOpenMP;
+  bool m_UseThreadPool;
+  bool m_UseDynamicLoadBalancing;
+  bool m_SupportsDynamicLoadBalancing;
 
   /** Helper structs that multi-threads the computation of
    * the metric derivative using ITK threads.
@@ -529,6 +612,14 @@ protected:
     const FixedImagePointType & fixedImagePoint,
     MovingImagePointType & mappedPoint ) const;
 
+  /** Transform a block of points from FixedImage domain to MovingImage domain,
+   * using a single call to the batch TransformPoints() of an advanced transform.
+   */
+  virtual void TransformPoints(
+    const FixedImagePointType * fixedImagePoints,
+    MovingImagePointType * mappedPoints,
+    const SizeValueType numberOfPoints ) const;
+
   /** This function returns a reference to the transform Jacobians.
    * This is either a reference to the full TransformJacobian or
    * a reference to a sparse Jacobians.
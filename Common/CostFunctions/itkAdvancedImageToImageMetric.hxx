@@ -28,6 +28,7 @@
 #endif
 
 #include "itkTimeProbe.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -48,14 +49,17 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
    */
   this->SetComputeGradient( false );
 
-  this->m_ImageSampler                = 0;
-  this->m_UseImageSampler             = false;
+  this->m_ImageSampler                    = 0;
+  this->m_UseImageSampler                 = false;
+  this->m_UseImageSampleStructureOfArrays = false;
   this->m_RequiredRatioOfValidSamples = 0.25;
 
   this->m_LinearInterpolator              = 0;
   this->m_BSplineInterpolator             = 0;
   this->m_BSplineInterpolatorFloat        = 0;
   this->m_ReducedBSplineInterpolator      = 0;
+  this->m_BrickedBSplineInterpolator      = 0;
+  this->m_BrickedBSplineInterpolatorFloat = 0;
   this->m_InterpolatorIsLinear            = false;
   this->m_InterpolatorIsBSpline           = false;
   this->m_InterpolatorIsBSplineFloat      = false;
@@ -85,8 +89,11 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
   this->m_MovingImageMaxLimit   = NumericTraits< MovingImageLimiterOutputType >::One;
 
   /** Threading related variables. */
-  this->m_UseMetricSingleThreaded = true;
-  this->m_UseMultiThread = false;
+  this->m_UseMetricSingleThreaded      = true;
+  this->m_UseMultiThread               = false;
+  this->m_UseThreadPool                = false;
+  this->m_UseDynamicLoadBalancing      = false;
+  this->m_SupportsDynamicLoadBalancing = false;
 
 #if ITK_VERSION_MAJOR < 5
   // Note: This `#if` is a workaround for ITK5, which no longer supports calling
@@ -434,6 +441,12 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
     itkDebugMacro( "Interpolator is not BSplineFloat" );
   }
 
+  /** Check if the B-spline interpolators support bricked coefficients. */
+  this->m_BrickedBSplineInterpolator
+    = dynamic_cast< BrickedBSplineInterpolatorType * >( this->m_Interpolator.GetPointer() );
+  this->m_BrickedBSplineInterpolatorFloat
+    = dynamic_cast< BrickedBSplineInterpolatorFloatType * >( this->m_Interpolator.GetPointer() );
+
   this->m_InterpolatorIsReducedBSpline = false;
   ReducedBSplineInterpolatorType * testPtr3
     = dynamic_cast< ReducedBSplineInterpolatorType * >( this->m_Interpolator.GetPointer() );
@@ -606,7 +619,23 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
     /** Compute value and possibly derivative. */
     if( gradient )
     {
-      if( this->m_InterpolatorIsBSpline && !this->GetComputeGradient() )
+      if( this->m_BrickedBSplineInterpolator.IsNotNull() && !this->GetComputeGradient() )
+      {
+        /** Compute moving image value and gradient using the B-spline kernel,
+         * from the bricked coefficients if they are available.
+         */
+        this->m_BrickedBSplineInterpolator->EvaluateValueAndDerivativeAtContinuousIndex(
+          cindex, movingImageValue, *gradient );
+      }
+      else if( this->m_BrickedBSplineInterpolatorFloat.IsNotNull() && !this->GetComputeGradient() )
+      {
+        /** Compute moving image value and gradient using the B-spline kernel,
+         * from the bricked coefficients if they are available.
+         */
+        this->m_BrickedBSplineInterpolatorFloat->EvaluateValueAndDerivativeAtContinuousIndex(
+          cindex, movingImageValue, *gradient );
+      }
+      else if( this->m_InterpolatorIsBSpline && !this->GetComputeGradient() )
       {
         /** Compute moving image value and gradient using the B-spline kernel. */
         this->m_BSplineInterpolator->EvaluateValueAndDerivativeAtContinuousIndex(
@@ -780,6 +809,34 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 } // end TransformPoint()
 
 
+/**
+ * *************** TransformPoints ****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::TransformPoints(
+  const FixedImagePointType * fixedImagePoints,
+  MovingImagePointType * mappedPoints,
+  const SizeValueType numberOfPoints ) const
+{
+  if( this->m_TransformIsAdvanced )
+  {
+    this->m_AdvancedTransform->TransformPoints(
+      fixedImagePoints, mappedPoints, numberOfPoints );
+  }
+  else
+  {
+    for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+      mappedPoints[ i ] = this->m_Transform->TransformPoint( fixedImagePoints[ i ] );
+    }
+  }
+
+} // end TransformPoints()
+
+
 /**
  * *************** EvaluateTransformJacobian ****************
  */
@@ -865,7 +922,16 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
     this->SetTransformParameters( parameters );
     if( this->m_UseImageSampler )
     {
+      if( this->m_UseImageSampleStructureOfArrays )
+      {
+        this->GetImageSampler()->SetGenerateStructureOfArrays( true );
+      }
       this->GetImageSampler()->Update();
+      if( this->m_UseImageSampleStructureOfArrays )
+      {
+        this->m_ImageSampleStructureOfArrays
+          = this->GetImageSampler()->GetOutputAsStructureOfArrays();
+      }
     }
   }
 
@@ -907,13 +973,9 @@ void
 AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 ::LaunchGetValueThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->GetValueThreaderCallback,
+  this->LaunchThreaderCallback( this->GetValueThreaderCallback,
     const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
-
 } // end LaunchGetValueThreaderCallback()
 
 
@@ -952,16 +1014,65 @@ void
 AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 ::LaunchGetValueAndDerivativeThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->GetValueAndDerivativeThreaderCallback,
-    const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
+  /** Dynamic load balancing: distribute chunks of samples over the threads. */
+  if( this->m_UseThreadPool && this->m_UseDynamicLoadBalancing
+    && this->m_SupportsDynamicLoadBalancing && this->m_UseImageSampler )
+  {
+    const ThreadIdType  numberOfThreads = Self::GetNumberOfThreads();
+    const SizeValueType numberOfSamples = this->GetImageSampler()->GetOutput()->Size();
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
+    /** Aim at a few chunks per thread, but avoid tiny chunks. */
+    const SizeValueType chunkSize = std::max< SizeValueType >( 32,
+      numberOfSamples / ( 8 * static_cast< SizeValueType >( numberOfThreads ) ) );
+
+    Self * self = const_cast< Self * >( this );
+    WorkStealingThreadPool::GetInstance()->ParallelForChunks(
+      numberOfThreads, numberOfSamples, chunkSize,
+      [ self ]( ThreadIdType threadID, SizeValueType begin, SizeValueType end )
+      {
+        self->ThreadedGetValueAndDerivativeForSampleRange( threadID, begin, end );
+      } );
+    return;
+  }
+
+  this->LaunchThreaderCallback( this->GetValueAndDerivativeThreaderCallback,
+    const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
 
 } // end LaunchGetValueAndDerivativeThreaderCallback()
 
 
+/**
+ * *********************** LaunchThreaderCallback ***************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::LaunchThreaderCallback( ThreadFunctionType callback, void * userData ) const
+{
+  /** Launch new threads, the classic way. */
+  if( !this->m_UseThreadPool )
+  {
+    this->m_Threader->SetSingleMethod( callback, userData );
+    this->m_Threader->SingleMethodExecute();
+    return;
+  }
+
+  /** Run the callback once for each thread id on the persistent thread pool. */
+  const ThreadIdType numberOfThreads = Self::GetNumberOfThreads();
+  WorkStealingThreadPool::GetInstance()->ParallelForSlots( numberOfThreads,
+    [ callback, userData, numberOfThreads ]( ThreadIdType threadID )
+    {
+      ThreadInfoType infoStruct;
+      infoStruct.ThreadID        = threadID;
+      infoStruct.NumberOfThreads = numberOfThreads;
+      infoStruct.UserData        = userData;
+      callback( &infoStruct );
+    } );
+
+} // end LaunchThreaderCallback()
+
+
 /**
  *********** AccumulateDerivativesThreaderCallback *************
  */
@@ -1050,6 +1161,17 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
      << this->m_ImageSampler.GetPointer() << std::endl;
   os << indent.GetNextIndent() << "UseImageSampler: "
      << this->m_UseImageSampler << std::endl;
+  os << indent.GetNextIndent() << "UseImageSampleStructureOfArrays: "
+     << this->m_UseImageSampleStructureOfArrays << std::endl;
+
+  /** Variables related to multi-threading. */
+  os << indent << "Variables related to multi-threading: " << std::endl;
+  os << indent.GetNextIndent() << "UseMultiThread: "
+     << this->m_UseMultiThread << std::endl;
+  os << indent.GetNextIndent() << "UseThreadPool: "
+     << this->m_UseThreadPool << std::endl;
+  os << indent.GetNextIndent() << "UseDynamicLoadBalancing: "
+     << this->m_UseDynamicLoadBalancing << std::endl;
 
   /** Variables for the Limiters. */
   os << indent << "Variables related to the Limiters: " << std::endl;
@@ -1092,6 +1214,10 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
      << this->m_InterpolatorIsBSplineFloat << std::endl;
   os << indent.GetNextIndent() << "BSplineInterpolatorFloat: "
      << this->m_BSplineInterpolatorFloat.GetPointer() << std::endl;
+  os << indent.GetNextIndent() << "BrickedBSplineInterpolator: "
+     << this->m_BrickedBSplineInterpolator.GetPointer() << std::endl;
+  os << indent.GetNextIndent() << "BrickedBSplineInterpolatorFloat: "
+     << this->m_BrickedBSplineInterpolatorFloat.GetPointer() << std::endl;
   os << indent.GetNextIndent() << "CentralDifferenceGradientFilter: "
      << this->m_CentralDifferenceGradientFilter.GetPointer() << std::endl;
 
@@ -215,6 +215,26 @@ public:
   itkSetMacro( FiniteDifferencePerturbation, double );
   itkGetConstMacro( FiniteDifferencePerturbation, double );
 
+  /** The ways to reduce the per-thread joint histograms to one joint histogram.
+   * SerialReduction: the histograms are summed by a single thread.
+   * TreeReduction: every thread owns a band of histogram rows, and sums that
+   * band over the per-thread histograms pairwise, in a tree. It also clears
+   * the band for the next iteration, so that the threads do not need to.
+   */
+  typedef enum {
+    SerialReduction = 0,
+    TreeReduction   = 1
+  } JointHistogramReductionType;
+
+  /** Select how the per-thread joint histograms are reduced; default: SerialReduction. */
+  itkSetMacro( JointHistogramReduction, JointHistogramReductionType );
+  itkGetConstMacro( JointHistogramReduction, JointHistogramReductionType );
+
+  /** Select the reduction by its name, "Serial" or "Tree", as used in the
+   * parameter files. Throws an exception for other names.
+   */
+  virtual void SetJointHistogramReductionByName( const std::string & name );
+
 protected:
 
   /** The constructor. */
@@ -313,6 +333,7 @@ protected:
   {
     SizeValueType   st_NumberOfPixelsCounted;
     JointPDFPointer st_JointPDF;
+    bool            st_JointPDFIsZero;
   };
   itkPadStruct( ITK_CACHE_LINE_ALIGNMENT, ParzenWindowHistogramGetValueAndDerivativePerThreadStruct,
     PaddedParzenWindowHistogramGetValueAndDerivativePerThreadStruct );
@@ -330,6 +351,12 @@ protected:
   /** Single-threadedly accumulate results. */
   inline void AfterThreadedComputePDFs( void ) const;
 
+  /** Multi-threaded tree reduction of a band of the per-thread joint PDFs. */
+  inline void ThreadedReduceJointPDFs( ThreadIdType threadId );
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_TYPE ReduceJointPDFsThreaderCallback( void * arg );
+
   /** Helper function to launch the threads. */
   static ITK_THREAD_RETURN_TYPE ComputePDFsThreaderCallback( void * arg );
 
@@ -498,6 +525,8 @@ private:
   bool          m_UseFiniteDifferenceDerivative;
   double        m_FiniteDifferencePerturbation;
 
+  JointHistogramReductionType m_JointHistogramReduction;
+
 };
 
 } // end namespace itk
@@ -26,6 +26,8 @@
 #include "itkImageScanlineIterator.h"
 #include "vnl/vnl_math.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -68,6 +70,7 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   this->SetUseMovingImageLimiter( true );
 
   this->m_UseExplicitPDFDerivatives = true;
+  this->m_JointHistogramReduction   = SerialReduction;
 
   /** Initialize the m_ParzenWindowHistogramThreaderParameters */
   this->m_ParzenWindowHistogramThreaderParameters.m_Metric = this;
@@ -112,6 +115,8 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
      << this->m_FixedKernelBSplineOrder << std::endl;
   os << indent << "MovingKernelBSplineOrder: "
      << this->m_MovingKernelBSplineOrder << std::endl;
+  os << indent << "JointHistogramReduction: "
+     << ( this->m_JointHistogramReduction == TreeReduction ? "Tree" : "Serial" ) << std::endl;
 
   /*double m_MovingImageNormalizedMin;
   double m_FixedImageNormalizedMin;
@@ -129,6 +134,32 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 } // end PrintSelf()
 
 
+/**
+ * ********************* SetJointHistogramReductionByName ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::SetJointHistogramReductionByName( const std::string & name )
+{
+  if( name == "Tree" )
+  {
+    this->SetJointHistogramReduction( TreeReduction );
+  }
+  else if( name == "Serial" )
+  {
+    this->SetJointHistogramReduction( SerialReduction );
+  }
+  else
+  {
+    itkExceptionMacro( << "ERROR: JointHistogramReduction should be \"Serial\" or \"Tree\", not \""
+                       << name << "\"." );
+  }
+
+} // end SetJointHistogramReductionByName()
+
+
 /**
  * ********************* Initialize *****************************
  */
@@ -495,6 +526,7 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
       jointPDF->SetRegions( jointPDFRegion );
       jointPDF->Allocate();
     }
+    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ i ].st_JointPDFIsZero = false;
   }
 
 } // end InitializeThreadingParameters()
@@ -1161,7 +1193,12 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
    * instead of sequentially in InitializeThreadingParameters().
    */
   JointPDFPointer & jointPDF = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ threadId ].st_JointPDF;
-  jointPDF->FillBuffer( NumericTraits< PDFValueType >::ZeroValue() );
+  bool &            isZero   = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ threadId ].st_JointPDFIsZero;
+  if( !isZero )
+  {
+    jointPDF->FillBuffer( NumericTraits< PDFValueType >::ZeroValue() );
+  }
+  isZero = false;
 
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
@@ -1268,8 +1305,22 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   /** Compute alpha. */
   this->m_Alpha = 1.0 / static_cast< double >( this->m_NumberOfPixelsCounted );
 
-  /** Accumulate joint histogram. */
-  // could be multi-threaded too, by each thread updating only a part of the JointPDF.
+  /** Accumulate joint histogram, multi-threaded by a tree reduction per band of rows. */
+  if( this->m_JointHistogramReduction == TreeReduction && numberOfThreads > 1 )
+  {
+    this->LaunchThreaderCallback( this->ReduceJointPDFsThreaderCallback,
+      const_cast< void * >( static_cast< const void * >(
+      &this->m_ParzenWindowHistogramThreaderParameters ) ) );
+
+    /** The reduction has cleared the per-thread joint PDFs. */
+    for( ThreadIdType i = 0; i < numberOfThreads; ++i )
+    {
+      this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ i ].st_JointPDFIsZero = true;
+    }
+    return;
+  }
+
+  /** Accumulate joint histogram, single-threaded. */
   typedef ImageScanlineIterator< JointPDFType > JointPDFIteratorType;
   JointPDFIteratorType                it( this->m_JointPDF, this->m_JointPDF->GetBufferedRegion() );
   std::vector< JointPDFIteratorType > itT( numberOfThreads );
@@ -1304,6 +1355,90 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 } // end AfterThreadedComputePDFs()
 
 
+/**
+ * ******************* ThreadedReduceJointPDFs *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedReduceJointPDFs( ThreadIdType threadId )
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfThreads();
+
+  /** Determine the band of rows of this thread. A row contains the moving
+   * histogram bins of one fixed histogram bin. A band spans at least a cache
+   * line, to prevent false sharing between the threads.
+   */
+  const SizeValueType numberOfColumns    = this->m_NumberOfMovingHistogramBins;
+  const SizeValueType numberOfRows       = this->m_NumberOfFixedHistogramBins;
+  const SizeValueType valuesPerCacheLine = ITK_CACHE_LINE_ALIGNMENT / sizeof( PDFValueType );
+  const SizeValueType rowsPerBand        = std::max(
+    ( valuesPerCacheLine + numberOfColumns - 1 ) / numberOfColumns,
+    ( numberOfRows + numberOfThreads - 1 ) / numberOfThreads );
+  const SizeValueType rowBegin = std::min< SizeValueType >( threadId * rowsPerBand, numberOfRows );
+  const SizeValueType rowEnd   = std::min< SizeValueType >( rowBegin + rowsPerBand, numberOfRows );
+  const SizeValueType begin    = rowBegin * numberOfColumns;
+  const SizeValueType end      = rowEnd * numberOfColumns;
+  if( begin == end ) { return; }
+
+  /** Sum the band pairwise: in each round, the histogram of thread i
+   * accumulates the one of thread i + stride, which is cleared.
+   */
+  AlignedParzenWindowHistogramGetValueAndDerivativePerThreadStruct * perThread
+    = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables;
+  for( ThreadIdType stride = 1; stride < numberOfThreads; stride *= 2 )
+  {
+    for( ThreadIdType i = 0; i + stride < numberOfThreads; i += 2 * stride )
+    {
+      PDFValueType * target = perThread[ i ].st_JointPDF->GetBufferPointer();
+      PDFValueType * source = perThread[ i + stride ].st_JointPDF->GetBufferPointer();
+      for( SizeValueType k = begin; k < end; ++k )
+      {
+        target[ k ] += source[ k ];
+        source[ k ]  = NumericTraits< PDFValueType >::ZeroValue();
+      }
+    }
+  }
+
+  /** Store the band in the joint PDF, and clear the last per-thread histogram. */
+  PDFValueType * jointPDF = this->m_JointPDF->GetBufferPointer();
+  PDFValueType * sum      = perThread[ 0 ].st_JointPDF->GetBufferPointer();
+  for( SizeValueType k = begin; k < end; ++k )
+  {
+    jointPDF[ k ] = sum[ k ];
+    sum[ k ]      = NumericTraits< PDFValueType >::ZeroValue();
+  }
+
+} // end ThreadedReduceJointPDFs()
+
+
+/**
+ * **************** ReduceJointPDFsThreaderCallback *******
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::ReduceJointPDFsThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadId   = infoStruct->ThreadID;
+
+  ParzenWindowHistogramMultiThreaderParameterType * temp
+    = static_cast< ParzenWindowHistogramMultiThreaderParameterType * >( infoStruct->UserData );
+
+  temp->m_Metric->ThreadedReduceJointPDFs( threadId );
+
+#if ITK_VERSION_MAJOR >= 5
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+#else
+  return ITK_THREAD_RETURN_VALUE;
+#endif
+
+} // end ReduceJointPDFsThreaderCallback()
+
+
 /**
  * **************** ComputePDFsThreaderCallback *******
  */
@@ -1339,14 +1474,10 @@ void
 ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 ::LaunchComputePDFsThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->ComputePDFsThreaderCallback,
+  this->LaunchThreaderCallback( this->ComputePDFsThreaderCallback,
     const_cast< void * >( static_cast< const void * >(
       &this->m_ParzenWindowHistogramThreaderParameters ) ) );
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
-
 } // end LaunchComputePDFsThreaderCallback()
 
 
@@ -171,6 +171,16 @@ public:
   itkGetConstReferenceMacro( UseMetricSingleThreaded, bool );
   itkBooleanMacro( UseMetricSingleThreaded );
 
+  /** Get whether GetValueAndDerivative() may run concurrently with that of
+   * other metrics that share the transform, see the AdvancedImageToImageMetric.
+   * Default: false.
+   */
+  virtual bool GetSupportsConcurrentGetValueAndDerivative( void ) const
+  {
+    return false;
+  }
+
+
 protected:
 
   SingleValuedPointSetToPointSetMetric();
@@ -37,6 +37,21 @@ ImageFullSampler< TInputImage >
   /** If desired we exercise a multi-threaded version. */
   if( this->m_UseMultiThread )
   {
+    /** Without a mask, the threads know where their samples end up, and fill
+     * the structure-of-arrays output directly. With a mask, this is only known
+     * when all threads are done, so then the arrays are left empty, which
+     * makes GetOutputAsStructureOfArrays() fill them from the sample container.
+     */
+    if( this->GetMask().IsNull() )
+    {
+      this->InitializeOutputAsStructureOfArrays(
+        this->GetInput()->GetRequestedRegion().GetNumberOfPixels() );
+    }
+    else
+    {
+      this->InitializeOutputAsStructureOfArrays( 0 );
+    }
+
     /** Calls ThreadedGenerateData(). */
     return Superclass::GenerateData();
   }
@@ -49,6 +64,11 @@ ImageFullSampler< TInputImage >
   /** Clear the container. */
   sampleContainer->Initialize();
 
+  /** Both loops below also fill the structure-of-arrays output, if requested.
+   * With a mask, the number of samples is only known afterwards.
+   */
+  this->InitializeOutputAsStructureOfArrays( this->GetCroppedInputImageRegion().GetNumberOfPixels() );
+
   /** Set up a region iterator within the user specified image region. */
   typedef ImageRegionConstIteratorWithIndex< InputImageType > InputImageIterator;
   InputImageIterator iter( inputImage, this->GetCroppedInputImageRegion() );
@@ -94,6 +114,8 @@ ImageFullSampler< TInputImage >
 
       /** Store in container */
       sampleContainer->SetElement( ind, tempSample );
+      this->SetOutputAsStructureOfArraysSample( ind,
+        tempSample.m_ImageCoordinates, tempSample.m_ImageValue );
 
     } // end for
   } // end if no mask
@@ -121,12 +143,16 @@ ImageFullSampler< TInputImage >
         tempSample.m_ImageValue = iter.Get();
 
         /** Store in container. */
+        this->SetOutputAsStructureOfArraysSample( sampleContainer->Size(),
+          tempSample.m_ImageCoordinates, tempSample.m_ImageValue );
         sampleContainer->push_back( tempSample );
 
       } // end if
     } // end for
   }     // end else (if mask exists)
 
+  this->TruncateOutputAsStructureOfArrays( sampleContainer->Size() );
+
 } // end GenerateData()
 
 
@@ -175,6 +201,19 @@ ImageFullSampler< TInputImage >
       itkExceptionMacro( << "ERROR: failed to allocate memory for the sample container." );
     }
 
+    /** The requested region is split along its outermost dimension, so the
+     * samples of this thread start at the position of the first voxel of
+     * its region in the requested region.
+     */
+    const InputImageRegionType & requestedRegion = inputImage->GetRequestedRegion();
+    SizeValueType                sampleOffset    = 0;
+    SizeValueType                stride          = 1;
+    for( unsigned int dim = 0; dim < InputImageDimension; ++dim )
+    {
+      sampleOffset += ( inputRegionForThread.GetIndex()[ dim ] - requestedRegion.GetIndex()[ dim ] ) * stride;
+      stride       *= requestedRegion.GetSize()[ dim ];
+    }
+
     /** Simply loop over the image and store all samples in the container. */
     ImageSampleType tempSample;
     unsigned long   ind = 0;
@@ -192,6 +231,8 @@ ImageFullSampler< TInputImage >
 
       /** Store in container. */
       sampleContainerThisThread->SetElement( ind, tempSample );
+      this->SetOutputAsStructureOfArraysSample( sampleOffset + ind,
+        tempSample.m_ImageCoordinates, tempSample.m_ImageValue );
 
     } // end for
   } // end if no mask
@@ -105,6 +105,11 @@ ImageGridSampler< TInputImage >
     numberOfSamplesOnGrid *= sampleGridSize[ dim ];
   }
 
+  /** Both loops below also fill the structure-of-arrays output, if requested.
+   * With a mask, the number of samples is only known afterwards.
+   */
+  this->InitializeOutputAsStructureOfArrays( numberOfSamplesOnGrid );
+
   /** Prepare for looping over the grid. */
   unsigned int dim_z = 1;
   unsigned int dim_t = 1;
@@ -142,6 +147,8 @@ ImageGridSampler< TInputImage >
             index[ 0 ] += this->m_SampleGridSpacing[ 0 ];
 
             // Store sample in container.
+            this->SetOutputAsStructureOfArraysSample( sampleContainer->Size(),
+              tempsample.m_ImageCoordinates, tempsample.m_ImageValue );
             sampleContainer->push_back( tempsample );
 
           } // end x
@@ -190,6 +197,8 @@ ImageGridSampler< TInputImage >
               tempsample.m_ImageValue = inputImage->GetPixel( index );
 
               // Store sample in container.
+              this->SetOutputAsStructureOfArraysSample( sampleContainer->Size(),
+                tempsample.m_ImageCoordinates, tempsample.m_ImageValue );
               sampleContainer->push_back( tempsample );
 
             } // end if in mask
@@ -215,6 +224,8 @@ ImageGridSampler< TInputImage >
     } // end t
   }   // else (if mask exists)
 
+  this->TruncateOutputAsStructureOfArrays( sampleContainer->Size() );
+
 } // end GenerateData()
 
 
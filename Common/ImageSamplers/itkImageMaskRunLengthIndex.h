@@ -0,0 +1,146 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkImageMaskRunLengthIndex_h
+#define __itkImageMaskRunLengthIndex_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkSpatialObject.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class ImageMaskRunLengthIndex
+ *
+ * \brief An index of the voxels of an image region that are inside a mask.
+ *
+ * The voxels are stored as runs along the first dimension: per run the index
+ * of its first voxel, and the number of voxels in the runs up to and including
+ * it. The k-th voxel inside the mask is then found by a binary search over the
+ * runs, so that a uniformly distributed voxel inside the mask is drawn in
+ * O(log #runs) time, independent of the fraction of the region that the mask
+ * covers. A voxel is inside when the mask contains its center.
+ *
+ * Build() is cheap when the image, the region and the mask did not change
+ * since the previous call, so the samplers can call it at every selection of
+ * samples; in practice the index is then built once per resolution. The index
+ * is built with multiple threads.
+ *
+ * \ingroup ImageSamplers
+ */
+
+template< class TInputImage >
+class ImageMaskRunLengthIndex : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef ImageMaskRunLengthIndex    Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ImageMaskRunLengthIndex, Object );
+
+  /** The image dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TInputImage::ImageDimension );
+
+  /** Typedefs. */
+  typedef TInputImage                                               ImageType;
+  typedef typename ImageType::RegionType                            RegionType;
+  typedef typename ImageType::IndexType                             IndexType;
+  typedef typename ImageType::SizeType                              SizeType;
+  typedef typename ImageType::PointType                             PointType;
+  typedef SpatialObject< itkGetStaticConstMacro( ImageDimension ) > MaskType;
+
+  /** Build the index of the voxels of the region of the image that are
+   * inside the mask, unless it is up to date already.
+   */
+  void Build( const ImageType * image, const RegionType & region, const MaskType * mask );
+
+  /** Get whether the index was built for this image, region and mask, in their current state. */
+  bool IsUpToDate( const ImageType * image, const RegionType & region, const MaskType * mask ) const;
+
+  /** Get the number of voxels inside the mask. */
+  SizeValueType GetNumberOfVoxels( void ) const
+  {
+    return this->m_RunEnds.empty() ? 0 : this->m_RunEnds.back();
+  }
+
+
+  /** Get the index of voxel k, 0 <= k < GetNumberOfVoxels(). */
+  IndexType GetIndex( const SizeValueType k ) const;
+
+  /** Get the index of the voxel selected by a uniform random number u in [0,1]. */
+  IndexType GetIndexOfUniformVariate( const double u ) const
+  {
+    const SizeValueType n = this->GetNumberOfVoxels();
+    const SizeValueType k = static_cast< SizeValueType >( u * static_cast< double >( n ) );
+    return this->GetIndex( k < n ? k : n - 1 );
+  }
+
+
+  /** Get the number of runs. */
+  SizeValueType GetNumberOfRuns( void ) const
+  {
+    return this->m_RunEnds.size();
+  }
+
+
+protected:
+
+  ImageMaskRunLengthIndex();
+  ~ImageMaskRunLengthIndex() override {}
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const override;
+
+private:
+
+  ImageMaskRunLengthIndex( const Self & ); // purposely not implemented
+  void operator=( const Self & );          // purposely not implemented
+
+  /** The number of rows that a thread processes at a time. */
+  itkStaticConstMacro( RowsPerBlock, unsigned int, 64 );
+
+  /** Per run the index of the first voxel, and the number of voxels in the runs up to and including it. */
+  std::vector< IndexType >     m_RunStartIndices;
+  std::vector< SizeValueType > m_RunEnds;
+
+  /** The state for which the index was built. */
+  const ImageType * m_Image;
+  ModifiedTimeType  m_ImageMTime;
+  const MaskType *  m_Mask;
+  ModifiedTimeType  m_MaskMTime;
+  RegionType        m_Region;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkImageMaskRunLengthIndex.hxx"
+#endif
+
+#endif // end #ifndef __itkImageMaskRunLengthIndex_h
@@ -0,0 +1,214 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkImageMaskRunLengthIndex_hxx
+#define __itkImageMaskRunLengthIndex_hxx
+
+#include "itkImageMaskRunLengthIndex.h"
+#include "itkMultiThreader.h"
+#include "itkWorkStealingThreadPool.h"
+
+#include <algorithm>
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template< class TInputImage >
+ImageMaskRunLengthIndex< TInputImage >
+::ImageMaskRunLengthIndex()
+{
+  this->m_Image      = nullptr;
+  this->m_ImageMTime = 0;
+  this->m_Mask       = nullptr;
+  this->m_MaskMTime  = 0;
+
+} // end Constructor
+
+
+/**
+ * ******************* IsUpToDate *******************
+ */
+
+template< class TInputImage >
+bool
+ImageMaskRunLengthIndex< TInputImage >
+::IsUpToDate( const ImageType * image, const RegionType & region, const MaskType * mask ) const
+{
+  return image == this->m_Image && image != nullptr
+         && image->GetMTime() == this->m_ImageMTime
+         && mask == this->m_Mask && mask != nullptr
+         && mask->GetMTime() == this->m_MaskMTime
+         && region == this->m_Region;
+
+} // end IsUpToDate()
+
+
+/**
+ * ******************* Build *******************
+ */
+
+template< class TInputImage >
+void
+ImageMaskRunLengthIndex< TInputImage >
+::Build( const ImageType * image, const RegionType & region, const MaskType * mask )
+{
+  if( this->IsUpToDate( image, region, mask ) )
+  {
+    return;
+  }
+  if( image == nullptr || mask == nullptr )
+  {
+    itkExceptionMacro( << "ERROR: an image and a mask are required." );
+  }
+
+  /** The rows along the first dimension, divided in blocks. */
+  const SizeType      size           = region.GetSize();
+  const IndexType     start          = region.GetIndex();
+  const SizeValueType rowLength      = size[ 0 ];
+  const SizeValueType numberOfRows   = rowLength > 0 ? region.GetNumberOfPixels() / rowLength : 0;
+  const SizeValueType rowsPerBlock   = Self::RowsPerBlock;
+  const SizeValueType numberOfBlocks = ( numberOfRows + rowsPerBlock - 1 ) / rowsPerBlock;
+
+  /** Per block the start indices and lengths of its runs. */
+  std::vector< std::vector< IndexType > >     blockRunStarts( numberOfBlocks );
+  std::vector< std::vector< SizeValueType > > blockRunLengths( numberOfBlocks );
+
+  WorkStealingThreadPool::GetInstance()->ParallelForChunks(
+    MultiThreader::GetGlobalDefaultNumberOfThreads(), numberOfBlocks, 1,
+    [ & ]( ThreadIdType, SizeValueType beginBlock, SizeValueType endBlock )
+    {
+      PointType point;
+      for( SizeValueType b = beginBlock; b < endBlock; ++b )
+      {
+        const SizeValueType endRow = std::min( ( b + 1 ) * rowsPerBlock, numberOfRows );
+        for( SizeValueType row = b * rowsPerBlock; row < endRow; ++row )
+        {
+          /** The index of the first voxel of the row. */
+          IndexType     index     = start;
+          SizeValueType remainder = row;
+          for( unsigned int d = 1; d < ImageDimension; ++d )
+          {
+            index[ d ] += static_cast< IndexValueType >( remainder % size[ d ] );
+            remainder  /= size[ d ];
+          }
+
+          /** Find the runs of voxels inside the mask. */
+          SizeValueType runLength = 0;
+          for( SizeValueType x = 0; x <= rowLength; ++x )
+          {
+            bool inside = false;
+            if( x < rowLength )
+            {
+              index[ 0 ] = start[ 0 ] + static_cast< IndexValueType >( x );
+              image->TransformIndexToPhysicalPoint( index, point );
+              inside = mask->IsInside( point );
+            }
+            if( inside )
+            {
+              ++runLength;
+            }
+            else if( runLength > 0 )
+            {
+              IndexType runStart = index;
+              runStart[ 0 ] = start[ 0 ] + static_cast< IndexValueType >( x - runLength );
+              blockRunStarts[ b ].push_back( runStart );
+              blockRunLengths[ b ].push_back( runLength );
+              runLength = 0;
+            }
+          }
+        }
+      }
+    } );
+
+  /** Concatenate the runs of the blocks in order. */
+  SizeValueType numberOfRuns = 0;
+  for( SizeValueType b = 0; b < numberOfBlocks; ++b )
+  {
+    numberOfRuns += blockRunStarts[ b ].size();
+  }
+  this->m_RunStartIndices.clear();
+  this->m_RunEnds.clear();
+  this->m_RunStartIndices.reserve( numberOfRuns );
+  this->m_RunEnds.reserve( numberOfRuns );
+  SizeValueType numberOfVoxels = 0;
+  for( SizeValueType b = 0; b < numberOfBlocks; ++b )
+  {
+    for( std::size_t r = 0; r < blockRunStarts[ b ].size(); ++r )
+    {
+      numberOfVoxels += blockRunLengths[ b ][ r ];
+      this->m_RunStartIndices.push_back( blockRunStarts[ b ][ r ] );
+      this->m_RunEnds.push_back( numberOfVoxels );
+    }
+  }
+
+  /** Remember the state. */
+  this->m_Image      = image;
+  this->m_ImageMTime = image->GetMTime();
+  this->m_Mask       = mask;
+  this->m_MaskMTime  = mask->GetMTime();
+  this->m_Region     = region;
+  this->Modified();
+
+} // end Build()
+
+
+/**
+ * ******************* GetIndex *******************
+ */
+
+template< class TInputImage >
+typename ImageMaskRunLengthIndex< TInputImage >::IndexType
+ImageMaskRunLengthIndex< TInputImage >
+::GetIndex( const SizeValueType k ) const
+{
+  /** The first run that ends after k. */
+  const std::size_t run = std::upper_bound(
+    this->m_RunEnds.begin(), this->m_RunEnds.end(), k ) - this->m_RunEnds.begin();
+  const SizeValueType runBegin = run > 0 ? this->m_RunEnds[ run - 1 ] : 0;
+
+  IndexType index = this->m_RunStartIndices[ run ];
+  index[ 0 ] += static_cast< IndexValueType >( k - runBegin );
+  return index;
+
+} // end GetIndex()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TInputImage >
+void
+ImageMaskRunLengthIndex< TInputImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "NumberOfVoxels: " << this->GetNumberOfVoxels() << std::endl;
+  os << indent << "NumberOfRuns: " << this->GetNumberOfRuns() << std::endl;
+  os << indent << "Region: " << this->m_Region << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkImageMaskRunLengthIndex_hxx
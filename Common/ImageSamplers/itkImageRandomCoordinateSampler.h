@@ -90,6 +90,8 @@ public:
   /** The random number generator used to generate random coordinates. */
   typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
   typedef typename RandomGeneratorType::Pointer                  RandomGeneratorPointer;
+  typedef typename Superclass::CounterBasedGeneratorType         CounterBasedGeneratorType;
+  typedef typename Superclass::MaskIndexType                     MaskIndexType;
 
   /** Set/Get the interpolator. A 3rd order B-spline interpolator is used by default. */
   itkSetObjectMacro( Interpolator, InterpolatorType );
@@ -133,6 +135,14 @@ protected:
     const InputImageContinuousIndexType & largestContIndex,
     InputImageContinuousIndexType &       randomContIndex );
 
+  /** Generate point i of a counter-based generator randomly in a bounding box. */
+  virtual void GenerateCounterBasedRandomCoordinate(
+    const CounterBasedGeneratorType &     generator,
+    const unsigned long                   i,
+    const InputImageContinuousIndexType & smallestContIndex,
+    const InputImageContinuousIndexType & largestContIndex,
+    InputImageContinuousIndexType &       randomContIndex ) const;
+
   InterpolatorPointer    m_Interpolator;
   RandomGeneratorPointer m_RandomGenerator;
   InputImageSpacingType  m_SampleRegionSize;
@@ -157,6 +167,10 @@ private:
 
   bool m_UseRandomSampleRegion;
 
+  /** The sample region of the current counter-based selection, for the threads. */
+  InputImageContinuousIndexType m_CounterBasedSmallestContIndex;
+  InputImageContinuousIndexType m_CounterBasedLargestContIndex;
+
 };
 
 } // end namespace itk
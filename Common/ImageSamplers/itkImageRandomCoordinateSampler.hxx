@@ -56,6 +56,9 @@ void
 ImageRandomCoordinateSampler< TInputImage >
 ::GenerateData( void )
 {
+  /** All code paths below also fill the structure-of-arrays output, if requested. */
+  this->InitializeOutputAsStructureOfArrays( this->GetNumberOfSamples() );
+
   /** Get a handle to the mask. If there was no mask supplied we exercise a multi-threaded version. */
   typename MaskType::ConstPointer mask = this->GetMask();
   if( mask.IsNull() && this->m_UseMultiThread )
@@ -72,6 +75,15 @@ ImageRandomCoordinateSampler< TInputImage >
   /** Set up the interpolator. */
   interpolator->SetInputImage( inputImage ); // only once?
 
+  /** Start a new counter-based selection, before the sample region is generated. */
+  const bool useCounterBasedRandomNumbers = this->GetUseCounterBasedRandomNumbers();
+  if( useCounterBasedRandomNumbers )
+  {
+    this->BeginCounterBasedSampleSelection();
+  }
+  const CounterBasedGeneratorType generator = this->GetCounterBasedGenerator();
+  unsigned long                   randomNumber = 0;
+
   /** Convert inputImageRegion to bounding box in physical space. */
   InputImageSizeType unitSize;
   unitSize.Fill( 1 );
@@ -105,7 +117,15 @@ ImageRandomCoordinateSampler< TInputImage >
       ImageSampleValueType & sampleValue = ( *iter ).Value().m_ImageValue;
 
       /** Walk over the image until we find a valid point. */
-      this->GenerateRandomCoordinate( smallestContIndex, largestContIndex, sampleContIndex );
+      if( useCounterBasedRandomNumbers )
+      {
+        this->GenerateCounterBasedRandomCoordinate( generator, randomNumber++,
+          smallestContIndex, largestContIndex, sampleContIndex );
+      }
+      else
+      {
+        this->GenerateRandomCoordinate( smallestContIndex, largestContIndex, sampleContIndex );
+      }
 
       /** Convert to point */
       inputImage->TransformContinuousIndexToPhysicalPoint( sampleContIndex, samplePoint );
@@ -113,6 +133,7 @@ ImageRandomCoordinateSampler< TInputImage >
       /** Compute the value at the continuous index. */
       sampleValue = static_cast< ImageSampleValueType >(
         this->m_Interpolator->EvaluateAtContinuousIndex( sampleContIndex ) );
+      this->SetOutputAsStructureOfArraysSample( iter.Index(), samplePoint, sampleValue );
 
     } // end for loop
   } // end if no mask
@@ -128,6 +149,16 @@ ImageRandomCoordinateSampler< TInputImage >
     unsigned long numberOfSamplesTried        = 0;
     unsigned long maximumNumberOfSamplesToTry = 10 * this->GetNumberOfSamples();
 
+    /** Draw the points from the voxels inside the mask, if desired. The
+     * index covers the whole input image region, so not with a random
+     * sample region.
+     */
+    const MaskIndexType * maskIndex = 0;
+    if( this->GetUseMaskIndex() && !this->GetUseRandomSampleRegion() )
+    {
+      maskIndex = this->GetUpToDateMaskIndex();
+    }
+
     /** Start looping over the sample container */
     for( iter = sampleContainer->Begin(); iter != end; ++iter )
     {
@@ -152,16 +183,38 @@ ImageRandomCoordinateSampler< TInputImage >
         }
 
         /** Generate a point in the input image region. */
-        this->GenerateRandomCoordinate( smallestContIndex, largestContIndex, sampleContIndex );
+        bool insideRegion = true;
+        if( maskIndex )
+        {
+          /** The voxels at the border of the region stick out half a voxel. */
+          this->GenerateRandomContinuousIndexInMask( *maskIndex,
+            useCounterBasedRandomNumbers ? &generator : 0, randomNumber++, sampleContIndex );
+          for( unsigned int d = 0; d < InputImageDimension; ++d )
+          {
+            insideRegion &= sampleContIndex[ d ] >= smallestContIndex[ d ]
+              && sampleContIndex[ d ] <= largestContIndex[ d ];
+          }
+        }
+        else if( useCounterBasedRandomNumbers )
+        {
+          this->GenerateCounterBasedRandomCoordinate( generator, randomNumber++,
+            smallestContIndex, largestContIndex, sampleContIndex );
+        }
+        else
+        {
+          this->GenerateRandomCoordinate( smallestContIndex, largestContIndex, sampleContIndex );
+        }
         inputImage->TransformContinuousIndexToPhysicalPoint( sampleContIndex, samplePoint );
 
       }
-      while( !interpolator->IsInsideBuffer( sampleContIndex )
+      while( !insideRegion
+        || !interpolator->IsInsideBuffer( sampleContIndex )
         || !mask->IsInside( samplePoint ) );
 
       /** Compute the value at the point. */
       sampleValue = static_cast< ImageSampleValueType >(
         this->m_Interpolator->EvaluateAtContinuousIndex( sampleContIndex ) );
+      this->SetOutputAsStructureOfArraysSample( iter.Index(), samplePoint, sampleValue );
 
     } // end for loop
   } // end if mask
@@ -182,6 +235,12 @@ ImageRandomCoordinateSampler< TInputImage >
   typename InterpolatorType::Pointer interpolator = this->GetModifiableInterpolator();
   interpolator->SetInputImage( this->GetInput() ); // only once per resolution?
 
+  /** Start a new counter-based selection, before the sample region is generated. */
+  if( this->GetUseCounterBasedRandomNumbers() )
+  {
+    this->BeginCounterBasedSampleSelection();
+  }
+
   /** Clear the random number list. */
   this->m_RandomNumberList.resize( 0 );
   this->m_RandomNumberList.reserve( this->m_NumberOfSamples * InputImageDimension );
@@ -198,13 +257,23 @@ ImageRandomCoordinateSampler< TInputImage >
   this->GenerateSampleRegion( smallestImageCIndex, largestImageCIndex,
     smallestCIndex, largestCIndex );
 
-  /** Fill the list with random numbers. */
-  for( unsigned long i = 0; i < this->m_NumberOfSamples; i++ )
+  /** Fill the list with random numbers. Counter-based random numbers are
+   * computed by the threads, which only need the sample region.
+   */
+  if( this->GetUseCounterBasedRandomNumbers() )
+  {
+    this->m_CounterBasedSmallestContIndex = smallestCIndex;
+    this->m_CounterBasedLargestContIndex  = largestCIndex;
+  }
+  else
   {
-    this->GenerateRandomCoordinate( smallestCIndex, largestCIndex, randomCIndex );
-    for( unsigned int j = 0; j < InputImageDimension; ++j )
+    for( unsigned long i = 0; i < this->m_NumberOfSamples; i++ )
     {
-      this->m_RandomNumberList.push_back( randomCIndex[ j ] );
+      this->GenerateRandomCoordinate( smallestCIndex, largestCIndex, randomCIndex );
+      for( unsigned int j = 0; j < InputImageDimension; ++j )
+      {
+        this->m_RandomNumberList.push_back( randomCIndex[ j ] );
+      }
     }
   }
 
@@ -239,8 +308,9 @@ ImageRandomCoordinateSampler< TInputImage >
   InputImageConstPointer inputImage = this->GetInput();
 
   /** Figure out which samples to process. */
-  unsigned long chunkSize   = this->GetNumberOfSamples() / this->GetNumberOfThreads();
-  unsigned long sampleStart = threadId * chunkSize * InputImageDimension;
+  unsigned long       chunkSize   = this->GetNumberOfSamples() / this->GetNumberOfThreads();
+  unsigned long       sampleStart = threadId * chunkSize * InputImageDimension;
+  const unsigned long firstSample = threadId * chunkSize;
   if( threadId == this->GetNumberOfThreads() - 1 )
   {
     chunkSize = this->GetNumberOfSamples()
@@ -257,14 +327,25 @@ ImageRandomCoordinateSampler< TInputImage >
   typename ImageSampleContainerType::ConstIterator end = sampleContainerThisThread->End();
 
   /** Fill the local sample container. */
-  InputImageContinuousIndexType sampleCIndex;
-  unsigned long                 sampleId = sampleStart;
+  const bool                      useCounterBasedRandomNumbers = this->GetUseCounterBasedRandomNumbers();
+  const CounterBasedGeneratorType generator                    = this->GetCounterBasedGenerator();
+  InputImageContinuousIndexType   sampleCIndex;
+  unsigned long                   sampleId = sampleStart;
   for( iter = sampleContainerThisThread->Begin(); iter != end; ++iter )
   {
     /** Create a random point out of InputImageDimension random numbers. */
-    for( unsigned int j = 0; j < InputImageDimension; ++j, sampleId++ )
+    if( useCounterBasedRandomNumbers )
     {
-      sampleCIndex[ j ] = this->m_RandomNumberList[ sampleId ];
+      this->GenerateCounterBasedRandomCoordinate( generator, sampleId / InputImageDimension,
+        this->m_CounterBasedSmallestContIndex, this->m_CounterBasedLargestContIndex, sampleCIndex );
+      sampleId += InputImageDimension;
+    }
+    else
+    {
+      for( unsigned int j = 0; j < InputImageDimension; ++j, sampleId++ )
+      {
+        sampleCIndex[ j ] = this->m_RandomNumberList[ sampleId ];
+      }
     }
 
     /** Make a reference to the current sample in the container. */
@@ -277,6 +358,7 @@ ImageRandomCoordinateSampler< TInputImage >
     /** Compute the value at the contindex. */
     sampleValue = static_cast< ImageSampleValueType >(
       this->m_Interpolator->EvaluateAtContinuousIndex( sampleCIndex ) );
+    this->SetOutputAsStructureOfArraysSample( firstSample + iter.Index(), samplePoint, sampleValue );
 
   } // end for loop
 
@@ -304,6 +386,31 @@ ImageRandomCoordinateSampler< TInputImage >
 } // end GenerateRandomCoordinate()
 
 
+/**
+ * ******************* GenerateCounterBasedRandomCoordinate *******************
+ */
+
+template< class TInputImage >
+void
+ImageRandomCoordinateSampler< TInputImage >
+::GenerateCounterBasedRandomCoordinate(
+  const CounterBasedGeneratorType &     generator,
+  const unsigned long                   i,
+  const InputImageContinuousIndexType & smallestContIndex,
+  const InputImageContinuousIndexType & largestContIndex,
+  InputImageContinuousIndexType &       randomContIndex ) const
+{
+  /** Each block of the generator gives two coordinates. */
+  const unsigned long blocksPerPoint = ( InputImageDimension + 1 ) / 2;
+  for( unsigned int d = 0; d < InputImageDimension; ++d )
+  {
+    randomContIndex[ d ] = static_cast< InputImagePointValueType >(
+      generator.GetUniformVariate( i * blocksPerPoint + d / 2, d % 2,
+      smallestContIndex[ d ], largestContIndex[ d ] ) );
+  }
+} // end GenerateCounterBasedRandomCoordinate()
+
+
 /**
  * ******************* GenerateSampleRegion *******************
  */
@@ -341,7 +448,15 @@ ImageRandomCoordinateSampler< TInputImage >
     maxSmallestContIndex[ i ] = vnl_math_max( maxSmallestContIndex[ i ], smallestImageContIndex[ i ] );
   }
 
-  this->GenerateRandomCoordinate( smallestImageContIndex, maxSmallestContIndex, smallestContIndex );
+  if( this->GetUseCounterBasedRandomNumbers() )
+  {
+    this->GenerateCounterBasedRandomCoordinate( this->GetCounterBasedGenerator( 1 ), 0,
+      smallestImageContIndex, maxSmallestContIndex, smallestContIndex );
+  }
+  else
+  {
+    this->GenerateRandomCoordinate( smallestImageContIndex, maxSmallestContIndex, smallestContIndex );
+  }
   largestContIndex  = smallestContIndex;
   largestContIndex += sampleRegionSize;
 
@@ -76,6 +76,7 @@ public:
   /** Other typedefs. */
   typedef typename InputImageType::IndexType InputImageIndexType;
   typedef typename InputImageType::PointType InputImagePointType;
+  typedef typename Superclass::CounterBasedGeneratorType CounterBasedGeneratorType;
 
 protected:
 
@@ -91,6 +92,15 @@ protected:
     const InputImageRegionType & inputRegionForThread,
     ThreadIdType threadId ) override;
 
+  /** Get the index of random number i of a counter-based generator,
+   * uniformly distributed over the cropped input image region.
+   */
+  InputImageIndexType GetCounterBasedIndex(
+    const CounterBasedGeneratorType & generator, const unsigned long i ) const;
+
+  /** Select the samples with counter-based random numbers, single-threaded. */
+  virtual void GenerateDataCounterBased( void );
+
 private:
 
   /** The private constructor. */
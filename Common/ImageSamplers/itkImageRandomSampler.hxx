@@ -23,6 +23,8 @@
 #include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkImageRandomConstIteratorWithIndex.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -35,6 +37,9 @@ void
 ImageRandomSampler< TInputImage >
 ::GenerateData( void )
 {
+  /** All code paths below also fill the structure-of-arrays output, if requested. */
+  this->InitializeOutputAsStructureOfArrays( this->GetNumberOfSamples() );
+
   /** Get a handle to the mask. If there was no mask supplied we exercise a multi-threaded version. */
   typename MaskType::ConstPointer mask = this->GetMask();
   if( mask.IsNull() && this->m_UseMultiThread )
@@ -43,6 +48,12 @@ ImageRandomSampler< TInputImage >
     return Superclass::GenerateData();
   }
 
+  /** The counter-based samples are a function of their number only. */
+  if( this->GetUseCounterBasedRandomNumbers() )
+  {
+    return this->GenerateDataCounterBased();
+  }
+
   /** Get handles to the input image, output sample container. */
   InputImageConstPointer inputImage = this->GetInput();
   typename ImageSampleContainerType::Pointer sampleContainer = this->GetOutput();
@@ -73,6 +84,8 @@ ImageRandomSampler< TInputImage >
         ( *iter ).Value().m_ImageCoordinates );
       /** Get the value and put it in the sample. */
       ( *iter ).Value().m_ImageValue = randIter.Get();
+      this->SetOutputAsStructureOfArraysSample( iter.Index(),
+        ( *iter ).Value().m_ImageCoordinates, ( *iter ).Value().m_ImageValue );
       /** Jump to a random position. */
       ++randIter;
 
@@ -121,6 +134,8 @@ ImageRandomSampler< TInputImage >
       /** Put the coordinates and the value in the sample. */
       ( *iter ).Value().m_ImageCoordinates = inputPoint;
       ( *iter ).Value().m_ImageValue       = randIter.Get();
+      this->SetOutputAsStructureOfArraysSample( iter.Index(),
+        inputPoint, ( *iter ).Value().m_ImageValue );
 
     } // end for loop
 
@@ -170,6 +185,22 @@ ImageRandomSampler< TInputImage >
   typename ImageSampleContainerType::Iterator iter;
   typename ImageSampleContainerType::ConstIterator end = sampleContainerThisThread->End();
 
+  /** Compute the samples directly from their number, or from the list of random numbers. */
+  if( this->GetUseCounterBasedRandomNumbers() )
+  {
+    const CounterBasedGeneratorType generator = this->GetCounterBasedGenerator();
+    unsigned long                   sampleId  = sampleStart;
+    for( iter = sampleContainerThisThread->Begin(); iter != end; ++iter, sampleId++ )
+    {
+      const InputImageIndexType index = this->GetCounterBasedIndex( generator, sampleId );
+      inputImage->TransformIndexToPhysicalPoint( index, ( *iter ).Value().m_ImageCoordinates );
+      ( *iter ).Value().m_ImageValue = static_cast< ImageSampleValueType >( inputImage->GetPixel( index ) );
+      this->SetOutputAsStructureOfArraysSample( sampleId,
+        ( *iter ).Value().m_ImageCoordinates, ( *iter ).Value().m_ImageValue );
+    }
+    return;
+  }
+
   /** Fill the local sample container. */
   unsigned long       sampleId    = sampleStart;
   InputImageSizeType  regionSize  = this->GetCroppedInputImageRegion().GetSize();
@@ -196,12 +227,120 @@ ImageRandomSampler< TInputImage >
 
     /** Get the value and put it in the sample. */
     ( *iter ).Value().m_ImageValue = static_cast< ImageSampleValueType >( inputImage->GetPixel( positionIndex ) );
+    this->SetOutputAsStructureOfArraysSample( sampleId,
+      ( *iter ).Value().m_ImageCoordinates, ( *iter ).Value().m_ImageValue );
 
   } // end for loop
 
 } // end ThreadedGenerateData()
 
 
+/**
+ * ******************* GetCounterBasedIndex *******************
+ */
+
+template< class TInputImage >
+typename ImageRandomSampler< TInputImage >::InputImageIndexType
+ImageRandomSampler< TInputImage >
+::GetCounterBasedIndex( const CounterBasedGeneratorType & generator, const unsigned long i ) const
+{
+  /** Each block of the generator gives two random numbers. */
+  const InputImageRegionType & region    = this->GetCroppedInputImageRegion();
+  const unsigned long          numPixels = region.GetNumberOfPixels();
+  unsigned long                randomPosition
+    = static_cast< unsigned long >( generator.GetUniformVariate( i / 2, i % 2 ) * numPixels );
+  randomPosition = std::min( randomPosition, numPixels - 1 );
+
+  /** Translate randomPosition to an index, as in ThreadedGenerateData(). */
+  InputImageIndexType positionIndex;
+  for( unsigned int dim = 0; dim < InputImageDimension; dim++ )
+  {
+    const unsigned long sizeInThisDimension = region.GetSize()[ dim ];
+    const unsigned long residual            = randomPosition % sizeInThisDimension;
+    positionIndex[ dim ] = residual + region.GetIndex()[ dim ];
+    randomPosition      /= sizeInThisDimension;
+  }
+  return positionIndex;
+
+} // end GetCounterBasedIndex()
+
+
+/**
+ * ******************* GenerateDataCounterBased *******************
+ */
+
+template< class TInputImage >
+void
+ImageRandomSampler< TInputImage >
+::GenerateDataCounterBased( void )
+{
+  /** Get handles to the input image, output sample container and mask. */
+  InputImageConstPointer inputImage = this->GetInput();
+  typename ImageSampleContainerType::Pointer sampleContainer = this->GetOutput();
+  typename MaskType::ConstPointer mask = this->GetMask();
+
+  /** Start a new selection. */
+  this->BeginCounterBasedSampleSelection();
+  const CounterBasedGeneratorType generator = this->GetCounterBasedGenerator();
+
+  /** Reserve memory for the output. */
+  sampleContainer->Reserve( this->GetNumberOfSamples() );
+  typename ImageSampleContainerType::Iterator iter;
+  typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
+
+  if( mask.IsNull() )
+  {
+    /** Sample i is computed from random number i, as in ThreadedGenerateData(). */
+    unsigned long i = 0;
+    for( iter = sampleContainer->Begin(); iter != end; ++iter, ++i )
+    {
+      const InputImageIndexType index = this->GetCounterBasedIndex( generator, i );
+      inputImage->TransformIndexToPhysicalPoint( index, ( *iter ).Value().m_ImageCoordinates );
+      ( *iter ).Value().m_ImageValue = static_cast< ImageSampleValueType >( inputImage->GetPixel( index ) );
+      this->SetOutputAsStructureOfArraysSample( i,
+        ( *iter ).Value().m_ImageCoordinates, ( *iter ).Value().m_ImageValue );
+    }
+    return;
+  }
+
+  /** Update the mask. */
+  if( mask->GetSource() )
+  {
+    mask->GetSource()->Update();
+  }
+
+  /** Try the random numbers in order, at most 10 per sample, and keep those inside the mask. */
+  const unsigned long maximumNumberOfSamplesToTry = 10 * this->GetNumberOfSamples();
+  unsigned long       candidate                   = 0;
+  InputImagePointType inputPoint;
+  for( iter = sampleContainer->Begin(); iter != end; ++iter )
+  {
+    InputImageIndexType index;
+    do
+    {
+      if( candidate == maximumNumberOfSamplesToTry )
+      {
+        /** Squeeze the sample container to the size that is still valid. */
+        typename ImageSampleContainerType::iterator stlnow = sampleContainer->begin();
+        typename ImageSampleContainerType::iterator stlend = sampleContainer->end();
+        stlnow                                            += iter.Index();
+        sampleContainer->erase( stlnow, stlend );
+        itkExceptionMacro( << "Could not find enough image samples within "
+                           << "reasonable time. Probably the mask is too small" );
+      }
+      index = this->GetCounterBasedIndex( generator, candidate++ );
+      inputImage->TransformIndexToPhysicalPoint( index, inputPoint );
+    }
+    while( !mask->IsInside( inputPoint ) );
+
+    ( *iter ).Value().m_ImageCoordinates = inputPoint;
+    ( *iter ).Value().m_ImageValue       = static_cast< ImageSampleValueType >( inputImage->GetPixel( index ) );
+    this->SetOutputAsStructureOfArraysSample( iter.Index(), inputPoint, ( *iter ).Value().m_ImageValue );
+  }
+
+} // end GenerateDataCounterBased()
+
+
 } // end namespace itk
 
 #endif // end #ifndef __ImageRandomSampler_hxx
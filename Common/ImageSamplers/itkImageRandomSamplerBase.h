@@ -19,6 +19,8 @@
 #define __ImageRandomSamplerBase_h
 
 #include "itkImageSamplerBase.h"
+#include "itkImageMaskRunLengthIndex.h"
+#include "itkPhiloxRandomNumberGenerator.h"
 
 namespace itk
 {
@@ -29,6 +31,21 @@ namespace itk
  *
  * It adds the Set/GetNumberOfSamples function.
  *
+ * By default the random numbers are drawn from the global Mersenne twister,
+ * in sequence, before the (multi-threaded) generation of the samples. When
+ * UseCounterBasedRandomNumbers is on, the subclasses that support it instead
+ * derive the random numbers of sample i from a PhiloxRandomNumberGenerator,
+ * as a function of (Seed, Iteration, i) only. Every thread can then draw its
+ * own numbers, and the samples do not depend on the number of threads, nor on
+ * whether the multi-threaded version is used. Iteration counts the selections
+ * of samples; it is incremented before each one.
+ *
+ * The samplers that select continuous coordinates inside a mask normally try
+ * random points until one is inside. For small masks most points are
+ * rejected. When UseMaskIndex is on, they instead draw a voxel from an
+ * ImageMaskRunLengthIndex of the voxels inside the mask, and a random offset
+ * within that voxel, so that nearly every point is accepted.
+ *
  * \ingroup ImageSamplers
  */
 
@@ -71,6 +88,37 @@ public:
   /** Set the number of samples. */
   itkSetClampMacro( NumberOfSamples, unsigned long, 1, NumericTraits< unsigned long >::max() );
 
+  /** Set/Get whether to use counter-based random numbers. Default: false. */
+  itkSetMacro( UseCounterBasedRandomNumbers, bool );
+  itkGetConstMacro( UseCounterBasedRandomNumbers, bool );
+  itkBooleanMacro( UseCounterBasedRandomNumbers );
+
+  /** Set/Get the seed of the counter-based random numbers. If it is not set,
+   * it is drawn from the global Mersenne twister at the first selection.
+   */
+  virtual void SetSeed( const SizeValueType seed );
+
+  itkGetConstMacro( Seed, SizeValueType );
+
+  /** Set/Get the number of the last selection of counter-based samples. */
+  itkSetMacro( Iteration, SizeValueType );
+  itkGetConstMacro( Iteration, SizeValueType );
+
+  /** The counter-based random number generator. */
+  typedef PhiloxRandomNumberGenerator CounterBasedGeneratorType;
+
+  /** Set/Get whether to select masked samples with the mask index. Default: false. */
+  itkSetMacro( UseMaskIndex, bool );
+  itkGetConstMacro( UseMaskIndex, bool );
+  itkBooleanMacro( UseMaskIndex );
+
+  /** Set/Get the index of the voxels inside the mask. It is (re)built when
+   * needed, so samplers of the same image and mask can share one.
+   */
+  typedef ImageMaskRunLengthIndex< InputImageType > MaskIndexType;
+  itkSetObjectMacro( MaskIndex, MaskIndexType );
+  itkGetModifiableObjectMacro( MaskIndex, MaskIndexType );
+
 protected:
 
   /** The constructor. */
@@ -85,6 +133,36 @@ protected:
   /** PrintSelf. */
   void PrintSelf( std::ostream & os, Indent indent ) const override;
 
+  /** Start a new selection of counter-based samples: select the seed if
+   * it is not set, and increment the Iteration.
+   */
+  virtual void BeginCounterBasedSampleSelection( void );
+
+  /** Get the counter-based generator of the current selection. Different
+   * streams give independent random numbers, for example for the samples and
+   * for the sample region.
+   */
+  CounterBasedGeneratorType GetCounterBasedGenerator( const unsigned int stream = 0 ) const;
+
+  /** Get the mask index of the input image, the cropped input image region
+   * and the mask, after building it if necessary.
+   */
+  const MaskIndexType * GetUpToDateMaskIndex( void );
+
+  /** Generate a continuous index uniformly in the voxels of the mask index,
+   * from random number i of the counter-based generator, or from the global
+   * Mersenne twister if the generator is null.
+   */
+  template< class TContinuousIndex >
+  void GenerateRandomContinuousIndexInMask(
+    const MaskIndexType & maskIndex,
+    const CounterBasedGeneratorType * generator,
+    const unsigned long i,
+    TContinuousIndex & randomContIndex ) const;
+
+  /** The mask index. */
+  typename MaskIndexType::Pointer m_MaskIndex;
+
   /** Member variable used when threading. */
   std::vector< double > m_RandomNumberList;
 
@@ -95,6 +173,13 @@ private:
   /** The private copy constructor. */
   void operator=( const Self & );             // purposely not implemented
 
+  /** The counter-based random number settings. */
+  bool          m_UseMaskIndex;
+  bool          m_UseCounterBasedRandomNumbers;
+  bool          m_SeedIsSet;
+  SizeValueType m_Seed;
+  SizeValueType m_Iteration;
+
 };
 
 } // end namespace itk
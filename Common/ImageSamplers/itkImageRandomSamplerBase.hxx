@@ -36,9 +36,137 @@ ImageRandomSamplerBase< TInputImage >
 {
   this->m_NumberOfSamples = 1000;
 
+  this->m_UseCounterBasedRandomNumbers = false;
+  this->m_SeedIsSet                    = false;
+  this->m_Seed                         = 0;
+  this->m_Iteration                    = 0;
+
+  this->m_UseMaskIndex = false;
+  this->m_MaskIndex    = MaskIndexType::New();
+
 } // end Constructor
 
 
+/**
+ * ******************* SetSeed *******************
+ */
+
+template< class TInputImage >
+void
+ImageRandomSamplerBase< TInputImage >
+::SetSeed( const SizeValueType seed )
+{
+  if( !this->m_SeedIsSet || this->m_Seed != seed )
+  {
+    this->m_Seed      = seed;
+    this->m_SeedIsSet = true;
+    this->Modified();
+  }
+
+} // end SetSeed()
+
+
+/**
+ * ******************* BeginCounterBasedSampleSelection *******************
+ */
+
+template< class TInputImage >
+void
+ImageRandomSamplerBase< TInputImage >
+::BeginCounterBasedSampleSelection( void )
+{
+  /** Draw the seed once, so that it follows the global random seed. */
+  if( !this->m_SeedIsSet )
+  {
+    this->m_Seed = Statistics::MersenneTwisterRandomVariateGenerator::GetInstance()
+      ->GetIntegerVariate();
+    this->m_SeedIsSet = true;
+  }
+  ++this->m_Iteration;
+
+} // end BeginCounterBasedSampleSelection()
+
+
+/**
+ * ******************* GetCounterBasedGenerator *******************
+ */
+
+template< class TInputImage >
+typename ImageRandomSamplerBase< TInputImage >::CounterBasedGeneratorType
+ImageRandomSamplerBase< TInputImage >
+::GetCounterBasedGenerator( const unsigned int stream ) const
+{
+  /** The upper 16 bits of the counter stream select the stream, the rest the iteration. */
+  const uint64_t iteration = static_cast< uint64_t >( this->m_Iteration ) & ( ( uint64_t( 1 ) << 48 ) - 1 );
+  return CounterBasedGeneratorType( this->m_Seed,
+    ( static_cast< uint64_t >( stream ) << 48 ) | iteration );
+
+} // end GetCounterBasedGenerator()
+
+
+/**
+ * ******************* GetUpToDateMaskIndex *******************
+ */
+
+template< class TInputImage >
+const typename ImageRandomSamplerBase< TInputImage >::MaskIndexType *
+ImageRandomSamplerBase< TInputImage >
+::GetUpToDateMaskIndex( void )
+{
+  this->m_MaskIndex->Build( this->GetInput(), this->GetCroppedInputImageRegion(), this->GetMask() );
+  if( this->m_MaskIndex->GetNumberOfVoxels() == 0 )
+  {
+    itkExceptionMacro( << "ERROR: the mask contains no voxels of the input image region." );
+  }
+  return this->m_MaskIndex.GetPointer();
+
+} // end GetUpToDateMaskIndex()
+
+
+/**
+ * ******************* GenerateRandomContinuousIndexInMask *******************
+ */
+
+template< class TInputImage >
+template< class TContinuousIndex >
+void
+ImageRandomSamplerBase< TInputImage >
+::GenerateRandomContinuousIndexInMask(
+  const MaskIndexType & maskIndex,
+  const CounterBasedGeneratorType * generator,
+  const unsigned long i,
+  TContinuousIndex & randomContIndex ) const
+{
+  /** One random number selects the voxel, the others the offset within it. */
+  double u[ InputImageDimension + 1 ];
+  if( generator )
+  {
+    const unsigned long blocksPerPoint = ( InputImageDimension + 2 ) / 2;
+    for( unsigned int j = 0; j <= InputImageDimension; ++j )
+    {
+      u[ j ] = generator->GetUniformVariate( i * blocksPerPoint + j / 2, j % 2 );
+    }
+  }
+  else
+  {
+    typedef Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+    RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::GetInstance();
+    for( unsigned int j = 0; j <= InputImageDimension; ++j )
+    {
+      u[ j ] = randomGenerator->GetUniformVariate( 0.0, 1.0 );
+    }
+  }
+
+  const typename MaskIndexType::IndexType index = maskIndex.GetIndexOfUniformVariate( u[ 0 ] );
+  for( unsigned int d = 0; d < InputImageDimension; ++d )
+  {
+    randomContIndex[ d ] = static_cast< typename TContinuousIndex::ValueType >(
+      static_cast< double >( index[ d ] ) - 0.5 + u[ d + 1 ] );
+  }
+
+} // end GenerateRandomContinuousIndexInMask()
+
+
 /**
  * ******************* BeforeThreadedGenerateData *******************
  */
@@ -48,6 +176,15 @@ void
 ImageRandomSamplerBase< TInputImage >
 ::BeforeThreadedGenerateData( void )
 {
+  /** Counter-based random numbers are computed by the threads themselves. */
+  if( this->m_UseCounterBasedRandomNumbers )
+  {
+    this->BeginCounterBasedSampleSelection();
+    this->m_RandomNumberList.resize( 0 );
+    Superclass::BeforeThreadedGenerateData();
+    return;
+  }
+
   /** Create a random number generator. Also used in the ImageRandomConstIteratorWithIndex. */
   typedef typename Statistics::MersenneTwisterRandomVariateGenerator::Pointer GeneratorPointer;
   GeneratorPointer localGenerator = Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
@@ -86,6 +223,11 @@ ImageRandomSamplerBase< TInputImage >
   Superclass::PrintSelf( os, indent );
 
   os << indent << "NumberOfSamples: " << this->m_NumberOfSamples << std::endl;
+  os << indent << "UseCounterBasedRandomNumbers: " << this->m_UseCounterBasedRandomNumbers << std::endl;
+  os << indent << "Seed: " << this->m_Seed << std::endl;
+  os << indent << "Iteration: " << this->m_Iteration << std::endl;
+  os << indent << "UseMaskIndex: " << this->m_UseMaskIndex << std::endl;
+  os << indent << "MaskIndex: " << this->m_MaskIndex.GetPointer() << std::endl;
 
 } // end PrintSelf()
 
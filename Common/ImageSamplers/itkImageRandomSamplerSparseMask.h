@@ -20,7 +20,6 @@
 
 #include "itkImageRandomSamplerBase.h"
 #include "itkMersenneTwisterRandomVariateGenerator.h"
-#include "itkImageFullSampler.h"
 
 namespace itk
 {
@@ -31,6 +30,15 @@ namespace itk
  * This version takes into account that the mask may be very small.
  * Also, it may be more efficient when very many different sample sets
  * of the same input image are required, because it does some precomputation.
+ *
+ * The precomputation is the ImageMaskRunLengthIndex of the superclass, which
+ * enumerates the voxels inside the mask as runs along the first dimension. It
+ * is only rebuilt when the input image, the mask or the region change, so
+ * normally once per resolution. Each selection draws random voxel numbers and
+ * gathers the corresponding voxels. The voxels are numbered in the same order
+ * as by the ImageFullSampler, which this class used before, so the selected
+ * samples are the same as well.
+ *
  * \ingroup ImageSamplers
  */
 
@@ -64,7 +72,9 @@ public:
   typedef typename Superclass::ImageSampleType              ImageSampleType;
   typedef typename Superclass::ImageSampleContainerType     ImageSampleContainerType;
   typedef typename Superclass::ImageSampleContainerPointer  ImageSampleContainerPointer;
+  typedef typename Superclass::ImageSampleValueType         ImageSampleValueType;
   typedef typename Superclass::MaskType                     MaskType;
+  typedef typename Superclass::MaskIndexType                MaskIndexType;
 
   /** The input image dimension. */
   itkStaticConstMacro( InputImageDimension, unsigned int,
@@ -80,9 +90,6 @@ public:
 
 protected:
 
-  typedef itk::ImageFullSampler< InputImageType >   InternalFullSamplerType;
-  typedef typename InternalFullSamplerType::Pointer InternalFullSamplerPointer;
-
   /** The constructor. */
   ImageRandomSamplerSparseMask();
   /** The destructor. */
@@ -101,8 +108,7 @@ protected:
     const InputImageRegionType & inputRegionForThread,
     ThreadIdType threadId ) override;
 
-  RandomGeneratorPointer     m_RandomGenerator;
-  InternalFullSamplerPointer m_InternalFullSampler;
+  RandomGeneratorPointer m_RandomGenerator;
 
 private:
 
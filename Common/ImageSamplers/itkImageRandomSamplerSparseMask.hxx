@@ -34,8 +34,6 @@ ImageRandomSamplerSparseMask< TInputImage >
   /** Setup random generator. */
   this->m_RandomGenerator = RandomGeneratorType::GetInstance();
 
-  this->m_InternalFullSampler = InternalFullSamplerType::New();
-
 } // end Constructor
 
 
@@ -64,37 +62,20 @@ ImageRandomSamplerSparseMask< TInputImage >
   /** Clear the container. */
   sampleContainer->Initialize();
 
-  /** Make sure the internal full sampler is up-to-date. */
-  this->m_InternalFullSampler->SetInput( inputImage );
-  this->m_InternalFullSampler->SetMask( mask );
-  this->m_InternalFullSampler->SetInputImageRegion( this->GetCroppedInputImageRegion() );
+  /** Both code paths below also fill the structure-of-arrays output, if requested. */
+  this->InitializeOutputAsStructureOfArrays( this->GetNumberOfSamples() );
 
-  /** Use try/catch, since the full sampler may crash, due to insufficient memory. */
-  try
-  {
-    this->m_InternalFullSampler->Update();
-  }
-  catch( ExceptionObject & err )
+  /** Update the mask. */
+  if( mask->GetSource() )
   {
-    std::string message = "ERROR: This ImageSampler internally uses the "
-      "ImageFullSampler. Updating of this internal sampler raised the "
-      "exception:\n";
-    message += err.GetDescription();
-
-    std::string            fullSamplerMessage = err.GetDescription();
-    std::string::size_type loc                = fullSamplerMessage.find(
-      "ERROR: failed to allocate memory for the sample container", 0 );
-    if( loc != std::string::npos && this->GetMask() == 0 )
-    {
-      message += "\nYou are using the ImageRandomSamplerSparseMask sampler, "
-        "but you did not set a mask. The internal ImageFullSampler therefore "
-        "requires a lot of memory. Consider using the ImageRandomSampler "
-        "instead.";
-    }
-    const char * message2 = message.c_str();
-    itkExceptionMacro( << message2 );
+    mask->GetSource()->Update();
   }
 
+  /** Make sure the index of the voxels inside the mask is up-to-date.
+   * It is only rebuilt when the input image, the mask or the region changed.
+   */
+  const MaskIndexType * maskIndex = this->GetUpToDateMaskIndex();
+
   /** If desired we exercise a multi-threaded version. */
   if( this->m_UseMultiThread )
   {
@@ -102,17 +83,23 @@ ImageRandomSamplerSparseMask< TInputImage >
     return Superclass::GenerateData();
   }
 
-  /** Get a handle to the full sampler output. */
-  typename ImageSampleContainerType::Pointer allValidSamples
-    = this->m_InternalFullSampler->GetOutput();
-  unsigned long numberOfValidSamples = allValidSamples->Size();
+  const unsigned long numberOfValidSamples = maskIndex->GetNumberOfVoxels();
 
-  /** Take random samples from the allValidSamples-container. */
-  for( unsigned int i = 0; i < this->GetNumberOfSamples(); ++i )
+  /** Reserve memory for the output. */
+  sampleContainer->Reserve( this->GetNumberOfSamples() );
+
+  /** Take random voxels from the mask index. */
+  typename ImageSampleContainerType::Iterator iter;
+  typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
+  for( iter = sampleContainer->Begin(); iter != end; ++iter )
   {
-    unsigned long randomIndex
+    const unsigned long randomIndex
       = this->m_RandomGenerator->GetIntegerVariate( numberOfValidSamples - 1 );
-    sampleContainer->push_back( allValidSamples->ElementAt( randomIndex ) );
+    const InputImageIndexType index = maskIndex->GetIndex( randomIndex );
+    inputImage->TransformIndexToPhysicalPoint( index, ( *iter ).Value().m_ImageCoordinates );
+    ( *iter ).Value().m_ImageValue = static_cast< ImageSampleValueType >( inputImage->GetPixel( index ) );
+    this->SetOutputAsStructureOfArraysSample( iter.Index(),
+      ( *iter ).Value().m_ImageCoordinates, ( *iter ).Value().m_ImageValue );
   }
 
 } // end GenerateData()
@@ -131,9 +118,8 @@ ImageRandomSamplerSparseMask< TInputImage >
   this->m_RandomNumberList.resize( 0 );
   this->m_RandomNumberList.reserve( this->m_NumberOfSamples );
 
-  /** Get a handle to the full sampler output size. */
-  const unsigned long numberOfValidSamples
-    = this->m_InternalFullSampler->GetOutput()->Size();
+  /** Get the number of voxels in the mask index, which GenerateData() updated. */
+  const unsigned long numberOfValidSamples = this->GetMaskIndex()->GetNumberOfVoxels();
 
   /** Fill the list with random numbers. */
   for( unsigned int i = 0; i < this->GetNumberOfSamples(); ++i )
@@ -163,9 +149,9 @@ void
 ImageRandomSamplerSparseMask< TInputImage >
 ::ThreadedGenerateData( const InputImageRegionType &, ThreadIdType threadId )
 {
-  /** Get a handle to the full sampler output. */
-  typename ImageSampleContainerType::Pointer allValidSamples
-    = this->m_InternalFullSampler->GetOutput();
+  /** Get handles to the input image and the mask index. */
+  InputImageConstPointer inputImage = this->GetInput();
+  const MaskIndexType *  maskIndex  = this->GetMaskIndex();
 
   /** Figure out which samples to process. */
   unsigned long chunkSize   = this->GetNumberOfSamples() / this->GetNumberOfThreads();
@@ -185,12 +171,16 @@ ImageRandomSamplerSparseMask< TInputImage >
   typename ImageSampleContainerType::Iterator iter;
   typename ImageSampleContainerType::ConstIterator end = sampleContainerThisThread->End();
 
-  /** Take random samples from the allValidSamples-container. */
+  /** Gather the random voxels from the mask index. */
   unsigned long sampleId = sampleStart;
   for( iter = sampleContainerThisThread->Begin(); iter != end; ++iter, sampleId++ )
   {
-    unsigned long randomIndex = static_cast< unsigned long >( this->m_RandomNumberList[ sampleId ] );
-    ( *iter ).Value() = allValidSamples->ElementAt( randomIndex );
+    const unsigned long randomIndex = static_cast< unsigned long >( this->m_RandomNumberList[ sampleId ] );
+    const InputImageIndexType index = maskIndex->GetIndex( randomIndex );
+    inputImage->TransformIndexToPhysicalPoint( index, ( *iter ).Value().m_ImageCoordinates );
+    ( *iter ).Value().m_ImageValue = static_cast< ImageSampleValueType >( inputImage->GetPixel( index ) );
+    this->SetOutputAsStructureOfArraysSample( sampleId,
+      ( *iter ).Value().m_ImageCoordinates, ( *iter ).Value().m_ImageValue );
   }
 
 } // end ThreadedGenerateData()
@@ -207,7 +197,6 @@ ImageRandomSamplerSparseMask< TInputImage >
 {
   Superclass::PrintSelf( os, indent );
 
-  os << indent << "InternalFullSampler: " << this->m_InternalFullSampler.GetPointer() << std::endl;
   os << indent << "RandomGenerator: " << this->m_RandomGenerator.GetPointer() << std::endl;
 
 } // end PrintSelf()
@@ -0,0 +1,210 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkImageSampleStructureOfArrays_h
+#define __itkImageSampleStructureOfArrays_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImageSample.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class ImageSampleStructureOfArrays
+ *
+ * \brief A structure-of-arrays representation of a set of image samples.
+ *
+ * The image samplers output an array of ImageSample structs, i.e. per sample
+ * a point followed by its value. This class stores the same samples as
+ * one contiguous array per coordinate (x, y, z, ...) and one array with the
+ * image values. Each array starts at a 64-byte boundary, so that kernels
+ * processing a batch of consecutive samples, such as transforming points or
+ * interpolating, can use aligned vector loads.
+ *
+ * The arrays are padded up to a multiple of the alignment. The padding is
+ * zero-initialized, so a kernel may safely read a full vector beyond the last
+ * sample.
+ *
+ * \ingroup ImageSamplers
+ */
+
+template< class TImage >
+class ImageSampleStructureOfArrays : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef ImageSampleStructureOfArrays Self;
+  typedef Object                       Superclass;
+  typedef SmartPointer< Self >         Pointer;
+  typedef SmartPointer< const Self >   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ImageSampleStructureOfArrays, Object );
+
+  /** Typedefs. */
+  typedef ImageSample< TImage >                  ImageSampleType;
+  typedef typename ImageSampleType::PointType    PointType;
+  typedef typename PointType::ValueType          CoordinateType;
+  typedef typename ImageSampleType::RealType     RealType;
+
+  /** The image dimension. */
+  itkStaticConstMacro( Dimension, unsigned int, PointType::PointDimension );
+
+  /** The alignment of the arrays, in bytes. */
+  itkStaticConstMacro( Alignment, unsigned int, 64 );
+
+  /** Set the number of samples. Existing samples are not preserved. */
+  void SetSize( const SizeValueType size );
+
+  /** Reduce the number of samples to size, keeping the first samples. The
+   * padding behind the remaining samples is zeroed again.
+   */
+  void Truncate( const SizeValueType size );
+
+  /** Get the number of samples. */
+  SizeValueType Size( void ) const { return this->m_Size; }
+
+  /** Get the distance in elements between the start of two consecutive
+   * coordinate arrays, i.e. the padded size of a single array.
+   */
+  SizeValueType GetCoordinateStride( void ) const { return this->m_CoordinateStride; }
+
+  /** Get a pointer to the contiguous array of the d-th coordinate. */
+  CoordinateType * GetCoordinates( const unsigned int d )
+  {
+    return this->m_CoordinatesBegin + d * this->m_CoordinateStride;
+  }
+
+
+  const CoordinateType * GetCoordinates( const unsigned int d ) const
+  {
+    return this->m_CoordinatesBegin + d * this->m_CoordinateStride;
+  }
+
+
+  /** Get a pointer to the contiguous array of image values. */
+  RealType * GetValues( void ) { return this->m_ValuesBegin; }
+  const RealType * GetValues( void ) const { return this->m_ValuesBegin; }
+
+  /** Gather the point of sample i. */
+  void GetPoint( const SizeValueType i, PointType & point ) const
+  {
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      point[ d ] = this->GetCoordinates( d )[ i ];
+    }
+  }
+
+
+  /** Gather the points of the samples [begin, begin + count). The arrays are
+   * read per coordinate, so that the loads are contiguous.
+   */
+  void GetPoints( const SizeValueType begin, const SizeValueType count, PointType * points ) const
+  {
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      const CoordinateType * coordinates = this->GetCoordinates( d ) + begin;
+      for( SizeValueType i = 0; i < count; ++i )
+      {
+        points[ i ][ d ] = coordinates[ i ];
+      }
+    }
+  }
+
+
+  /** Get the image value of sample i. */
+  const RealType & GetValue( const SizeValueType i ) const
+  {
+    return this->m_ValuesBegin[ i ];
+  }
+
+
+  /** Scatter a sample into the arrays at position i. */
+  void SetSample( const SizeValueType i, const ImageSampleType & sample )
+  {
+    this->SetSample( i, sample.m_ImageCoordinates, sample.m_ImageValue );
+  }
+
+
+  /** Scatter a point and image value into the arrays at position i. */
+  void SetSample( const SizeValueType i, const PointType & point, const RealType & value )
+  {
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      this->GetCoordinates( d )[ i ] = point[ d ];
+    }
+    this->m_ValuesBegin[ i ] = value;
+  }
+
+
+  /** Gather sample i into an ImageSample struct. */
+  void GetSample( const SizeValueType i, ImageSampleType & sample ) const
+  {
+    this->GetPoint( i, sample.m_ImageCoordinates );
+    sample.m_ImageValue = this->m_ValuesBegin[ i ];
+  }
+
+
+  /** Fill the arrays from an array-of-structs sample container, such as the
+   * output of the image samplers.
+   */
+  template< class TSampleContainer >
+  void CopyFrom( const TSampleContainer & container );
+
+protected:
+
+  ImageSampleStructureOfArrays();
+  ~ImageSampleStructureOfArrays() override {}
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const override;
+
+private:
+
+  ImageSampleStructureOfArrays( const Self & ); // purposely not implemented
+  void operator=( const Self & );               // purposely not implemented
+
+  /** Return the first element of the buffer that starts at an aligned address. */
+  template< class T >
+  static T * AlignPointer( std::vector< T > & buffer );
+
+  /** Member variables. The buffers are over-allocated by one alignment, and the
+   * Begin pointers point to the first aligned element in them.
+   */
+  SizeValueType                 m_Size;
+  SizeValueType                 m_CoordinateStride;
+  std::vector< CoordinateType > m_CoordinatesBuffer;
+  std::vector< RealType >       m_ValuesBuffer;
+  CoordinateType *              m_CoordinatesBegin;
+  RealType *                    m_ValuesBegin;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkImageSampleStructureOfArrays.hxx"
+#endif
+
+#endif // end #ifndef __itkImageSampleStructureOfArrays_h
@@ -0,0 +1,181 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkImageSampleStructureOfArrays_hxx
+#define __itkImageSampleStructureOfArrays_hxx
+
+#include "itkImageSampleStructureOfArrays.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template< class TImage >
+ImageSampleStructureOfArrays< TImage >
+::ImageSampleStructureOfArrays()
+{
+  this->m_Size             = 0;
+  this->m_CoordinateStride = 0;
+  this->m_CoordinatesBegin = 0;
+  this->m_ValuesBegin      = 0;
+
+} // end Constructor()
+
+
+/**
+ * ******************* AlignPointer *******************
+ */
+
+template< class TImage >
+template< class T >
+T *
+ImageSampleStructureOfArrays< TImage >
+::AlignPointer( std::vector< T > & buffer )
+{
+  if( buffer.empty() ) { return 0; }
+
+  const std::uintptr_t address = reinterpret_cast< std::uintptr_t >( &buffer[ 0 ] );
+  const std::uintptr_t offset  = ( Alignment - address % Alignment ) % Alignment;
+  return reinterpret_cast< T * >( address + offset );
+
+} // end AlignPointer()
+
+
+/**
+ * ******************* SetSize *******************
+ */
+
+template< class TImage >
+void
+ImageSampleStructureOfArrays< TImage >
+::SetSize( const SizeValueType size )
+{
+  /** Round the length of the arrays up to a multiple of the alignment. */
+  const SizeValueType coordinatesPerAlignment
+    = std::max< SizeValueType >( Alignment / sizeof( CoordinateType ), 1 );
+  const SizeValueType valuesPerAlignment
+    = std::max< SizeValueType >( Alignment / sizeof( RealType ), 1 );
+  const SizeValueType coordinateStride
+    = ( ( size + coordinatesPerAlignment - 1 ) / coordinatesPerAlignment ) * coordinatesPerAlignment;
+  const SizeValueType valueStride
+    = ( ( size + valuesPerAlignment - 1 ) / valuesPerAlignment ) * valuesPerAlignment;
+
+  /** Allocate one extra alignment, to be able to shift the start of the
+   * arrays to an aligned address. The assign() zeroes the padding.
+   */
+  this->m_CoordinatesBuffer.assign( Dimension * coordinateStride + coordinatesPerAlignment, CoordinateType() );
+  this->m_ValuesBuffer.assign( valueStride + valuesPerAlignment, RealType() );
+
+  this->m_Size             = size;
+  this->m_CoordinateStride = coordinateStride;
+  this->m_CoordinatesBegin = AlignPointer( this->m_CoordinatesBuffer );
+  this->m_ValuesBegin      = AlignPointer( this->m_ValuesBuffer );
+
+  this->Modified();
+
+} // end SetSize()
+
+
+/**
+ * ******************* Truncate *******************
+ */
+
+template< class TImage >
+void
+ImageSampleStructureOfArrays< TImage >
+::Truncate( const SizeValueType size )
+{
+  if( size >= this->m_Size )
+  {
+    return;
+  }
+
+  /** The strides are kept, only the tails of the arrays are cleared. */
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    std::fill( this->GetCoordinates( d ) + size,
+      this->GetCoordinates( d ) + this->m_CoordinateStride, CoordinateType() );
+  }
+  std::fill( this->m_ValuesBegin + size, this->m_ValuesBegin + this->m_Size, RealType() );
+  this->m_Size = size;
+
+  this->Modified();
+
+} // end Truncate()
+
+
+/**
+ * ******************* CopyFrom *******************
+ */
+
+template< class TImage >
+template< class TSampleContainer >
+void
+ImageSampleStructureOfArrays< TImage >
+::CopyFrom( const TSampleContainer & container )
+{
+  const SizeValueType size = container.Size();
+  if( size != this->m_Size )
+  {
+    this->SetSize( size );
+  }
+
+  /** Transpose per coordinate, so that every store is contiguous. */
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    CoordinateType * coordinates = this->GetCoordinates( d );
+    for( SizeValueType i = 0; i < size; ++i )
+    {
+      coordinates[ i ] = container.ElementAt( i ).m_ImageCoordinates[ d ];
+    }
+  }
+  for( SizeValueType i = 0; i < size; ++i )
+  {
+    this->m_ValuesBegin[ i ] = container.ElementAt( i ).m_ImageValue;
+  }
+
+  this->Modified();
+
+} // end CopyFrom()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TImage >
+void
+ImageSampleStructureOfArrays< TImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Size: " << this->m_Size << std::endl;
+  os << indent << "CoordinateStride: " << this->m_CoordinateStride << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkImageSampleStructureOfArrays_hxx
@@ -20,6 +20,7 @@
 
 #include "itkImageToVectorContainerFilter.h"
 #include "itkImageSample.h"
+#include "itkImageSampleStructureOfArrays.h"
 #include "itkVectorDataContainer.h"
 #include "itkSpatialObject.h"
 
@@ -29,6 +30,14 @@ namespace itk
  *
  * \brief This class is a base class for any image sampler.
  *
+ * The output of an image sampler is a container of ImageSample structs. The
+ * same samples are also available as a structure of arrays, see
+ * GetOutputAsStructureOfArrays(), which allows metrics to process batches of
+ * samples with vectorized kernels. Samplers that support it fill these arrays
+ * directly while sampling, when SetGenerateStructureOfArrays( true ) has been
+ * called. This costs the memory of a second copy of the samples, so only
+ * metrics that read the arrays switch it on.
+ *
  * \parameter ImageSampler: The way samples are taken from the fixed image in
  *    order to compute the metric value and its derivative in each iteration.
  *    Can be given for each resolution. Select one of {Random, Full, Grid, RandomCoordinate}.\n
@@ -87,6 +96,8 @@ public:
   typedef typename MaskType::ConstPointer                       MaskConstPointer;
   typedef std::vector< MaskConstPointer >                       MaskVectorType;
   typedef std::vector< InputImageRegionType >                   InputImageRegionVectorType;
+  typedef ImageSampleStructureOfArrays< InputImageType >        ImageSampleStructureOfArraysType;
+  typedef typename ImageSampleStructureOfArraysType::Pointer    ImageSampleStructureOfArraysPointer;
 
   /** ******************** Masks ******************** */
 
@@ -171,6 +182,23 @@ public:
   /** \todo: Temporary, should think about interface. */
   itkSetMacro( UseMultiThread, bool );
 
+  /** Let the samplers that support it also store the samples as a structure
+   * of arrays while sampling. Default: false.
+   */
+  itkSetMacro( GenerateStructureOfArrays, bool );
+  itkGetConstMacro( GenerateStructureOfArrays, bool );
+  itkBooleanMacro( GenerateStructureOfArrays );
+
+  /** Get the output samples as a structure of arrays, i.e. with contiguous
+   * coordinate and value arrays. If the sampler has not filled the arrays
+   * while sampling, they are copied from the output container when the output
+   * has been regenerated since the last call. So call this after Update(),
+   * and not concurrently from several threads. The ImageSample container
+   * returned by GetOutput() remains the primary output, so that existing
+   * components are not affected.
+   */
+  virtual const ImageSampleStructureOfArraysType * GetOutputAsStructureOfArrays( void ) const;
+
 protected:
 
   /** The constructor. */
@@ -211,6 +239,29 @@ protected:
   //tmp?
   bool m_UseMultiThread;
 
+  /** To be called by the samplers that fill the structure of arrays directly,
+   * at the start of every GenerateData(), with the (maximum) number of
+   * samples. When the structure of arrays is not generated, this only
+   * releases the arrays of an earlier run.
+   */
+  void InitializeOutputAsStructureOfArrays( const SizeValueType size );
+
+  /** Store sample i also in the structure of arrays, if it is generated. */
+  void SetOutputAsStructureOfArraysSample( const SizeValueType i,
+    const InputImagePointType & point, const ImageSampleValueType & value )
+  {
+    if( this->m_OutputAsStructureOfArraysIsFilled )
+    {
+      this->m_OutputAsStructureOfArrays->SetSample( i, point, value );
+    }
+  }
+
+
+  /** Reduce the structure of arrays to the final number of samples, for
+   * samplers that do not know the number of samples in advance.
+   */
+  void TruncateOutputAsStructureOfArrays( const SizeValueType size );
+
 private:
 
   /** The private constructor. */
@@ -229,6 +280,15 @@ private:
   InputImageRegionType m_CroppedInputImageRegion;
   InputImageRegionType m_DummyInputImageRegion;
 
+  /** The structure-of-arrays version of the output, whether the sampler has
+   * filled it directly, and otherwise the update time of the output at the
+   * moment it was copied.
+   */
+  bool                                        m_GenerateStructureOfArrays;
+  bool                                        m_OutputAsStructureOfArraysIsFilled;
+  mutable ImageSampleStructureOfArraysPointer m_OutputAsStructureOfArrays;
+  mutable ModifiedTimeType                    m_OutputAsStructureOfArraysTime;
+
 };
 
 } // end namespace itk
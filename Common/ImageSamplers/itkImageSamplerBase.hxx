@@ -39,6 +39,11 @@ ImageSamplerBase< TInputImage >
   //tmp?
   this->m_UseMultiThread = false;
 
+  this->m_GenerateStructureOfArrays         = false;
+  this->m_OutputAsStructureOfArraysIsFilled = false;
+  this->m_OutputAsStructureOfArrays         = ImageSampleStructureOfArraysType::New();
+  this->m_OutputAsStructureOfArraysTime     = 0;
+
 } // end Constructor()
 
 
@@ -458,6 +463,78 @@ ImageSamplerBase< TInputImage >
 } // end AfterThreadedGenerateData()
 
 
+/**
+ * ******************* GetOutputAsStructureOfArrays *******************
+ */
+
+template< class TInputImage >
+const typename ImageSamplerBase< TInputImage >::ImageSampleStructureOfArraysType *
+ImageSamplerBase< TInputImage >
+::GetOutputAsStructureOfArrays( void ) const
+{
+  /** The arrays that have been filled while sampling are always up-to-date. */
+  const OutputVectorContainerType * sampleContainer = const_cast< Self * >( this )->GetOutput();
+  if( this->m_OutputAsStructureOfArraysIsFilled
+    && sampleContainer->Size() == this->m_OutputAsStructureOfArrays->Size() )
+  {
+    return this->m_OutputAsStructureOfArrays.GetPointer();
+  }
+
+  /** Otherwise, only transpose when new samples have been generated. */
+  const ModifiedTimeType            updateTime      = sampleContainer->GetUpdateMTime();
+  if( updateTime != this->m_OutputAsStructureOfArraysTime
+    || sampleContainer->Size() != this->m_OutputAsStructureOfArrays->Size() )
+  {
+    this->m_OutputAsStructureOfArrays->CopyFrom( *sampleContainer );
+    this->m_OutputAsStructureOfArraysTime = updateTime;
+  }
+
+  return this->m_OutputAsStructureOfArrays.GetPointer();
+
+} // end GetOutputAsStructureOfArrays()
+
+
+/**
+ * ******************* InitializeOutputAsStructureOfArrays *******************
+ */
+
+template< class TInputImage >
+void
+ImageSamplerBase< TInputImage >
+::InitializeOutputAsStructureOfArrays( const SizeValueType size )
+{
+  this->m_OutputAsStructureOfArraysIsFilled = this->m_GenerateStructureOfArrays;
+  if( this->m_OutputAsStructureOfArraysIsFilled )
+  {
+    this->m_OutputAsStructureOfArrays->SetSize( size );
+  }
+  else if( this->m_OutputAsStructureOfArrays->Size() > 0 )
+  {
+    /** Release the arrays of an earlier run. */
+    this->m_OutputAsStructureOfArrays = ImageSampleStructureOfArraysType::New();
+  }
+  this->m_OutputAsStructureOfArraysTime = 0;
+
+} // end InitializeOutputAsStructureOfArrays()
+
+
+/**
+ * ******************* TruncateOutputAsStructureOfArrays *******************
+ */
+
+template< class TInputImage >
+void
+ImageSamplerBase< TInputImage >
+::TruncateOutputAsStructureOfArrays( const SizeValueType size )
+{
+  if( this->m_OutputAsStructureOfArraysIsFilled )
+  {
+    this->m_OutputAsStructureOfArrays->Truncate( size );
+  }
+
+} // end TruncateOutputAsStructureOfArrays()
+
+
 /**
  * ******************* PrintSelf *******************
  */
@@ -485,6 +562,7 @@ ImageSamplerBase< TInputImage >
     os << indent.GetNextIndent() << this->m_InputImageRegionVector[ i ] << std::endl;
   }
   os << indent << "CroppedInputImageRegion" << this->m_CroppedInputImageRegion << std::endl;
+  os << indent << "GenerateStructureOfArrays: " << this->m_GenerateStructureOfArrays << std::endl;
 
 } // end PrintSelf()
 
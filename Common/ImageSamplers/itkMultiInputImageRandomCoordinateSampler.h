@@ -72,6 +72,7 @@ public:
   typedef typename Superclass::InputImagePointType          InputImagePointType;
   typedef typename Superclass::InputImagePointValueType     InputImagePointValueType;
   typedef typename Superclass::ImageSampleValueType         ImageSampleValueType;
+  typedef typename Superclass::MaskIndexType                MaskIndexType;
 
   /** The input image dimension. */
   itkStaticConstMacro( InputImageDimension, unsigned int,
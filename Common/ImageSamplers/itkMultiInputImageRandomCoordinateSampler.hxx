@@ -120,6 +120,13 @@ MultiInputImageRandomCoordinateSampler< TInputImage >
     unsigned long numberOfSamplesTried        = 0;
     unsigned long maximumNumberOfSamplesToTry = 10 * this->GetNumberOfSamples();
 
+    /** Draw the points from the voxels inside the first mask, if desired. */
+    const MaskIndexType * maskIndex = 0;
+    if( this->GetUseMaskIndex() && !this->GetUseRandomSampleRegion() )
+    {
+      maskIndex = this->GetUpToDateMaskIndex();
+    }
+
     /** Start looping over the sample container. */
     for( iter = sampleContainer->Begin(); iter != end; ++iter )
     {
@@ -143,11 +150,24 @@ MultiInputImageRandomCoordinateSampler< TInputImage >
                              << "reasonable time. Probably the mask is too small" );
         }
 
-        /** Generate a point in the input image region. */
-        this->GenerateRandomCoordinate( smallestContIndex, largestContIndex, sampleContIndex );
+        /** Generate a point in the input image region, or in the first mask. */
+        bool insideRegion = true;
+        if( maskIndex )
+        {
+          this->GenerateRandomContinuousIndexInMask( *maskIndex, 0, 0, sampleContIndex );
+          for( unsigned int d = 0; d < InputImageDimension; ++d )
+          {
+            insideRegion &= sampleContIndex[ d ] >= smallestContIndex[ d ]
+              && sampleContIndex[ d ] <= largestContIndex[ d ];
+          }
+        }
+        else
+        {
+          this->GenerateRandomCoordinate( smallestContIndex, largestContIndex, sampleContIndex );
+        }
         inputImage->TransformContinuousIndexToPhysicalPoint( sampleContIndex, samplePoint );
       }
-      while( !this->IsInsideAllMasks( samplePoint ) );
+      while( !insideRegion || !this->IsInsideAllMasks( samplePoint ) );
 
       /** Compute the value at the contindex. */
       sampleValue = static_cast< ImageSampleValueType >(
@@ -24,6 +24,7 @@
 #include "itkMetaDataObject.h"
 #include "itkVersion.h"
 #include "itkNumericTraits.h"
+#include "itkByteSwapper.h"
 
 // developed using gdcm 2.0 and libtiff 3.8.2
 #include "gdcmAttribute.h"
@@ -809,11 +810,77 @@ MevisDicomTiffImageIO::ReadImageInformation()
     this->SetUseCompression( false );
     //m_UseCompression = false;
   }
+
+  this->PublishRawDataLocation();
   return;
 
 }
 
 
+// publish raw data location
+void
+MevisDicomTiffImageIO::PublishRawDataLocation()
+{
+  // an empty file name means that the data can not be mapped
+  MetaDataDictionary & dic = this->GetMetaDataDictionary();
+  EncapsulateMetaData< std::string >( dic, "RawDataFileName", std::string() );
+
+  short int p;
+  if( m_Compression != 1 || m_BitsPerSample % 8 != 0
+    || !TIFFGetField( m_TIFFImage, TIFFTAG_PLANARCONFIG, &p ) || p != 1
+    || TIFFIsByteSwapped( m_TIFFImage ) )
+  {
+    return;
+  }
+
+  // the strips are in scanline order; tiles only if every tile is a whole slice
+  toff_t *           offsets = NULL;
+  unsigned int       number;
+  unsigned long long size;
+  if( m_IsTiled )
+  {
+    if( m_TileWidth != m_Width || m_TileLength != m_Length
+      || ( m_TIFFDimension == 3 && m_TileDepth != 1 )
+      || !TIFFGetField( m_TIFFImage, TIFFTAG_TILEOFFSETS, &offsets ) )
+    {
+      return;
+    }
+    number = TIFFNumberOfTiles( m_TIFFImage );
+    size   = TIFFTileSize( m_TIFFImage );
+  }
+  else
+  {
+    if( !TIFFGetField( m_TIFFImage, TIFFTAG_STRIPOFFSETS, &offsets ) )
+    {
+      return;
+    }
+    number = TIFFNumberOfStrips( m_TIFFImage );
+    size   = TIFFStripSize( m_TIFFImage );
+  }
+
+  // the strips or tiles should follow each other without gaps
+  if( offsets == NULL || number == 0 )
+  {
+    return;
+  }
+  for( unsigned int i = 1; i < number; ++i )
+  {
+    if( static_cast< unsigned long long >( offsets[ i ] )
+      != static_cast< unsigned long long >( offsets[ i - 1 ] ) + size )
+    {
+      return;
+    }
+  }
+
+  EncapsulateMetaData< std::string >( dic, "RawDataFileName", m_TiffFileName );
+  EncapsulateMetaData< SizeValueType >( dic, "RawDataOffset",
+    static_cast< SizeValueType >( offsets[ 0 ] ) );
+  EncapsulateMetaData< bool >( dic, "RawDataIsBigEndian",
+    ByteSwapper< char >::SystemIsBigEndian() );
+
+}
+
+
 // read
 void
 MevisDicomTiffImageIO::Read( void * buffer )
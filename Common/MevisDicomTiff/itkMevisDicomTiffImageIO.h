@@ -158,6 +158,12 @@ private:
   bool FindElement( const gdcm::DataSet ds, const gdcm::Tag tag, gdcm::DataElement & de,
     const bool breadthfirstsearch );
 
+  // publishes the location of the pixel data in the tiff file in the meta
+  // dictionary (RawDataFileName, RawDataOffset, RawDataIsBigEndian), if it
+  // is uncompressed and stored contiguously in scanline order, so that it
+  // can be mapped into memory; see itk::RawImageDataLocator
+  void PublishRawDataLocation();
+
   // the following may include the pathname
   std::string m_DcmFileName;
   std::string m_TiffFileName;
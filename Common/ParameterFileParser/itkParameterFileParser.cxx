@@ -22,7 +22,12 @@
 #include "itkParameterFileParser.h"
 
 #include <itksys/SystemTools.hxx>
-#include <itksys/RegularExpression.hxx>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
 
 namespace itk
 {
@@ -36,6 +41,8 @@ ParameterFileParser
 {
   this->m_ParameterFileName = "";
   this->m_ParameterMap.clear();
+  this->m_ParseCacheDirectory         = "";
+  this->m_ParameterMapIsReadFromCache = false;
 
 } // end Constructor()
 
@@ -79,48 +86,83 @@ ParameterFileParser
   /** Perform some basic checks. */
   this->BasicFileChecking();
 
-  /** Open the parameter file for reading. */
-  if( this->m_ParameterFile.is_open() )
-  {
-    this->m_ParameterFile.clear();
-    this->m_ParameterFile.close();
-  }
-  this->m_ParameterFile.open( this->m_ParameterFileName.c_str(), std::fstream::in );
+  /** Clear the map. */
+  this->m_ParameterMap.clear();
+  this->m_ParameterMapIsReadFromCache = false;
+
+  /** Read the parameter file at once. */
+  std::ifstream file( this->m_ParameterFileName.c_str(),
+    std::ios_base::in | std::ios_base::binary );
 
   /** Check if it opened. */
-  if( !this->m_ParameterFile.is_open() )
+  if( !file.is_open() )
   {
     itkExceptionMacro( << "ERROR: could not open "
                        << this->m_ParameterFileName
                        << " for reading." );
   }
 
-  /** Clear the map. */
-  this->m_ParameterMap.clear();
+  std::string content;
+  file.seekg( 0, std::ios_base::end );
+  const std::streamoff fileSize = file.tellg();
+  file.seekg( 0, std::ios_base::beg );
+  if( fileSize > 0 )
+  {
+    content.resize( static_cast< std::size_t >( fileSize ) );
+    file.read( &content[ 0 ], fileSize );
+    content.resize( static_cast< std::size_t >( file.gcount() ) );
+  }
+  file.close();
 
-  /** Loop over the parameter file, line by line. */
-  std::string lineIn  = "";
-  std::string lineOut = "";
-  while( this->m_ParameterFile.good() )
+  /** Try the parse cache. */
+  std::string    cacheFileName = "";
+  const uint64_t contentHash   = ComputeContentHash( content );
+  if( !this->m_ParseCacheDirectory.empty() )
   {
-    /** Extract a line. */
-    itksys::SystemTools::GetLineFromStream( this->m_ParameterFile, lineIn );
+    std::ostringstream name;
+    name << this->m_ParseCacheDirectory << "/ParameterFile_"
+         << std::hex << std::setw( 16 ) << std::setfill( '0' )
+         << contentHash << ".bin";
+    cacheFileName = name.str();
 
-    /** Check this line. */
-    bool validLine = this->CheckLine( lineIn, lineOut );
+    if( this->ReadParseCache( cacheFileName, contentHash, content ) )
+    {
+      this->m_ParameterMapIsReadFromCache = true;
+      return;
+    }
+  }
 
-    if( validLine )
+  /** Loop over the content, line by line. */
+  const char *       lineBegin  = content.data();
+  const char * const contentEnd = lineBegin + content.size();
+  while( lineBegin < contentEnd )
+  {
+    /** Find the end of the line, and strip a carriage return. */
+    const char * lineEnd = std::find( lineBegin, contentEnd, '\n' );
+    const char * next    = lineEnd < contentEnd ? lineEnd + 1 : contentEnd;
+    if( lineEnd > lineBegin && *( lineEnd - 1 ) == '\r' )
+    {
+      --lineEnd;
+    }
+
+    /** Check this line. */
+    const char * begin = lineBegin;
+    const char * end   = lineEnd;
+    if( this->CheckLine( lineBegin, lineEnd, begin, end ) )
     {
       /** Get the parameter name from this line and store it. */
-      this->GetParameterFromLine( lineIn, lineOut );
+      this->GetParameterFromLine( lineBegin, lineEnd, begin, end );
     }
     // Otherwise, we simply ignore this line
 
+    lineBegin = next;
   }
 
-  /** Close the parameter file. */
-  this->m_ParameterFile.clear();
-  this->m_ParameterFile.close();
+  /** Store the map for a next time. */
+  if( !cacheFileName.empty() )
+  {
+    this->WriteParseCache( cacheFileName, contentHash, content );
+  }
 
 } // end ReadParameterFile()
 
@@ -178,78 +220,59 @@ ParameterFileParser
 
 bool
 ParameterFileParser
-::CheckLine( const std::string & lineIn, std::string & lineOut ) const
+::CheckLine( const char * lineBegin, const char * lineEnd,
+  const char * & begin, const char * & end ) const
 {
-  /** Preprocessing of lineIn:
-   * 1) Replace tabs with spaces
-   * 2) Remove everything after comment sign //
-   * 3) Remove leading spaces
-   * 4) Remove trailing spaces
+  /** Preprocessing of the line, treating tabs as spaces:
+   * 1) Remove everything after comment sign //
+   * 2) Remove leading spaces
+   * 3) Remove trailing spaces
    */
-  lineOut = lineIn;
-  itksys::SystemTools::ReplaceString( lineOut, "\t", " " );
-
-  itksys::RegularExpression commentPart( "//" );
-  if( commentPart.find( lineOut ) )
+  begin = lineBegin;
+  end   = lineEnd;
+  for( const char * it = begin; it + 1 < end; ++it )
   {
-    lineOut = lineOut.substr( 0, commentPart.start() );
+    if( it[ 0 ] == '/' && it[ 1 ] == '/' )
+    {
+      end = it;
+      break;
+    }
   }
 
-  itksys::RegularExpression leadingSpaces( "^[ ]*(.*)" );
-  leadingSpaces.find( lineOut );
-  lineOut = leadingSpaces.match( 1 );
-
-  itksys::RegularExpression trailingSpaces( "[ \t]+$" );
-  if( trailingSpaces.find( lineOut ) )
+  while( begin < end && ( *begin == ' ' || *begin == '\t' ) )
   {
-    lineOut = lineOut.substr( 0, trailingSpaces.start() );
+    ++begin;
+  }
+  while( end > begin && ( *( end - 1 ) == ' ' || *( end - 1 ) == '\t' ) )
+  {
+    --end;
   }
 
   /**
    * Checks:
-   * 1. Empty line -> false
-   * 2. Comment (line starts with "//") -> false
-   * 3. Line is not between brackets (...) -> exception
-   * 4. Line contains less than two words -> exception
+   * 1. Empty line or comment -> false
+   * 2. Line is not between brackets (...) -> exception
    *
-   * Otherwise return true.
+   * Otherwise return true. The check that the line contains at least two
+   * words is done while splitting it, in GetParameterFromLine().
    */
 
-  /** 1. Check for non-empty lines. */
-  itksys::RegularExpression reNonEmptyLine( "[^ ]+" );
-  bool                      match1 = reNonEmptyLine.find( lineOut );
-  if( !match1 )
+  /** 1. Check for non-empty lines. Comments are empty at this point. */
+  if( begin == end )
   {
     return false;
   }
 
-  /** 2. Check for comments. */
-  itksys::RegularExpression reComment( "^//" );
-  bool                      match2 = reComment.find( lineOut );
-  if( match2 )
-  {
-    return false;
-  }
-
-  /** 3. Check if line is between brackets. */
-  if( !itksys::SystemTools::StringStartsWith( lineOut.c_str(), "(" )
-    || !itksys::SystemTools::StringEndsWith( lineOut.c_str(), ")" ) )
+  /** 2. Check if line is between brackets. */
+  if( *begin != '(' || *( end - 1 ) != ')' )
   {
     std::string hint = "Line is not between brackets: \"(...)\".";
-    this->ThrowException( lineIn, hint );
+    this->ThrowException( std::string( lineBegin, lineEnd ), hint );
   }
 
   /** Remove brackets. */
-  lineOut = lineOut.substr( 1, lineOut.size() - 2 );
-
-  /** 4. Check: the line should contain at least two words. */
-  itksys::RegularExpression reTwoWords( "([ ]+)([^ ]+)" );
-  bool                      match4 = reTwoWords.find( lineOut );
-  if( !match4 )
-  {
-    std::string hint = "Line does not contain a parameter name and value.";
-    this->ThrowException( lineIn, hint );
-  }
+  ++begin;
+  --end;
 
   /** At this point we know its at least a line containing a parameter.
    * However, this line can still be invalid, for example:
@@ -262,46 +285,152 @@ ParameterFileParser
 } // end CheckLine()
 
 
+/**
+ * **************** IsInvalidParameterNameCharacter ***************
+ */
+
+/** The characters of the regular expression [.,:;!@#$%^&-+|<>?], in which
+ * &-+ is the range of & ' ( ) * +.
+ */
+static inline bool
+IsInvalidParameterNameCharacter( const char c )
+{
+  switch( c )
+  {
+    case '.': case ',': case ':': case ';': case '!': case '@': case '#':
+    case '$': case '%': case '^': case '&': case '\'': case '(': case ')':
+    case '*': case '+': case '|': case '<': case '>': case '?':
+      return true;
+    default:
+      return false;
+  }
+} // end IsInvalidParameterNameCharacter()
+
+
+/**
+ * **************** IsInvalidParameterValueCharacter ***************
+ */
+
+/** The characters of the regular expression [,;!@#$%&|<>?]. */
+static inline bool
+IsInvalidParameterValueCharacter( const char c )
+{
+  switch( c )
+  {
+    case ',': case ';': case '!': case '@': case '#': case '$': case '%':
+    case '&': case '|': case '<': case '>': case '?':
+      return true;
+    default:
+      return false;
+  }
+} // end IsInvalidParameterValueCharacter()
+
+
 /**
  * **************** GetParameterFromLine ***************
  */
 
 void
 ParameterFileParser
-::GetParameterFromLine( const std::string & fullLine,
-  const std::string & line )
+::GetParameterFromLine( const char * lineBegin, const char * lineEnd,
+  const char * begin, const char * end )
 {
   /** A line has a parameter name followed by one or more parameters.
-   * They are all separated by one or more spaces (all tabs have been
-   * removed previously) or by quotes in case of strings. So,
+   * They are all separated by one or more spaces or tabs, or by quotes in
+   * case of strings. So, in a single pass over the line,
    * 1) we split the line at the spaces or quotes
-   * 2) the first one is the parameter name
-   * 3) the other strings that are not a series of spaces, are parameter values
+   * 2) the first element is the parameter name
+   * 3) the other elements that are not empty, are parameter values
+   * and we check for invalid characters on the fly.
    */
+  std::string                parameterName;
+  std::vector< std::string > parameterValues;
+  std::string                element;
+  std::size_t                elementNumber  = 0;
+  std::size_t                numQuotes      = 0;
+  bool                       invalidName    = false;
+  bool                       invalidElement = false;
+  std::size_t                invalidValue   = 0; // one-based, 0 means none
+  bool                       sawSpace       = false;
+  bool                       twoWords       = false;
+
+  for( const char * it = begin; it <= end; ++it )
+  {
+    /** The end of the line also ends an element. */
+    const char c         = it < end ? ( *it == '\t' ? ' ' : *it ) : '\0';
+    bool       endElement = it == end || c == '"';
+    if( c == ' ' )
+    {
+      sawSpace = true;
 
-  /** 1) Split the line. */
-  std::vector< std::string > splittedLine;
-  this->SplitLine( fullLine, line, splittedLine );
+      /** Only end the element if it is not a quote, otherwise just add
+       * the space to the string.
+       */
+      if( numQuotes % 2 == 0 )
+      {
+        endElement = true;
+      }
+    }
+    else if( sawSpace && it < end )
+    {
+      twoWords = true;
+    }
 
-  /** 2) Get the parameter name. */
-  std::string parameterName = splittedLine[ 0 ];
-  itksys::SystemTools::ReplaceString( parameterName, " ", "" );
-  splittedLine.erase( splittedLine.begin() );
+    if( !endElement )
+    {
+      /** Add this character to the element. */
+      element.push_back( c );
+      invalidElement |= elementNumber == 0
+        ? IsInvalidParameterNameCharacter( c )
+        : IsInvalidParameterValueCharacter( c );
+      continue;
+    }
 
-  /** 3) Get the parameter values. */
-  std::vector< std::string > parameterValues;
-  for( unsigned int i = 0; i < splittedLine.size(); ++i )
-  {
-    if( splittedLine[ i ] != "" )
+    /** Store the element. */
+    if( elementNumber == 0 )
+    {
+      parameterName.swap( element );
+      invalidName = invalidElement;
+    }
+    else if( !element.empty() )
     {
-      parameterValues.push_back( splittedLine[ i ] );
+      parameterValues.push_back( element );
+      if( invalidElement && invalidValue == 0 )
+      {
+        invalidValue = parameterValues.size();
+      }
+    }
+    element.clear();
+    invalidElement = false;
+    ++elementNumber;
+    if( c == '"' )
+    {
+      ++numQuotes;
     }
   }
 
-  /** 4) Perform some checks on the parameter name. */
-  itksys::RegularExpression reInvalidCharacters1( "[.,:;!@#$%^&-+|<>?]" );
-  bool                      match = reInvalidCharacters1.find( parameterName );
-  if( match )
+  /** Report the errors in the order of the checks. */
+  const std::string fullLine( lineBegin, lineEnd );
+
+  /** 4) The line should contain at least two words. */
+  if( !twoWords )
+  {
+    std::string hint = "Line does not contain a parameter name and value.";
+    this->ThrowException( fullLine, hint );
+  }
+
+  /** 5) Strings should start and end with a quote, so the total number of
+   * quotes should be even.
+   */
+  if( numQuotes % 2 == 1 )
+  {
+    /** An invalid parameter line. */
+    std::string hint = "This line has an odd number of quotes (\").";
+    this->ThrowException( fullLine, hint );
+  }
+
+  /** 6) Perform some checks on the parameter name. */
+  if( invalidName )
   {
     std::string hint = "The parameter \""
       + parameterName
@@ -309,96 +438,227 @@ ParameterFileParser
     this->ThrowException( fullLine, hint );
   }
 
-  /** 5) Perform checks on the parameter values. */
-  itksys::RegularExpression reInvalidCharacters2( "[,;!@#$%&|<>?]" );
-  for( unsigned int i = 0; i < parameterValues.size(); ++i )
+  /** 7) Perform checks on the parameter values. */
+  if( invalidValue > 0 )
   {
-    /** For all entries some characters are not allowed. */
-    if( reInvalidCharacters2.find( parameterValues[ i ] ) )
-    {
-      std::string hint = "The parameter value \""
-        + parameterValues[ i ]
-        + "\" contains invalid characters (,;!@#$%&|<>?).";
-      this->ThrowException( fullLine, hint );
-    }
+    std::string hint = "The parameter value \""
+      + parameterValues[ invalidValue - 1 ]
+      + "\" contains invalid characters (,;!@#$%&|<>?).";
+    this->ThrowException( fullLine, hint );
   }
 
-  /** 6) Insert this combination in the parameter map. */
-  if( this->m_ParameterMap.count( parameterName ) )
+  /** 8) Insert this combination in the parameter map. */
+  std::pair< ParameterMapType::iterator, bool > inserted
+    = this->m_ParameterMap.insert( std::make_pair( parameterName, ParameterValuesType() ) );
+  if( !inserted.second )
   {
     std::string hint = "The parameter \""
       + parameterName
       + "\" is specified more than once.";
     this->ThrowException( fullLine, hint );
   }
-  else
+  inserted.first->second.swap( parameterValues );
+
+} // end GetParameterFromLine()
+
+
+/**
+ * **************** ComputeContentHash ***************
+ */
+
+uint64_t
+ParameterFileParser
+::ComputeContentHash( const std::string & content )
+{
+  uint64_t hash = 14695981039346656037ULL;
+  for( std::string::const_iterator it = content.begin(); it != content.end(); ++it )
   {
-    this->m_ParameterMap.insert( make_pair( parameterName, parameterValues ) );
+    hash ^= static_cast< unsigned char >( *it );
+    hash *= 1099511628211ULL;
   }
+  return hash;
 
-} // end GetParameterFromLine()
+} // end ComputeContentHash()
 
 
 /**
- * **************** SplitLine ***************
+ * **************** Binary cache helpers ***************
  */
 
-void
+/** The first bytes of a cache file. Change the version when the format
+ * or the parsing changes, to invalidate old cache files.
+ */
+static const char     ParseCacheMagic[ 8 ]  = { 'E', 'L', 'X', 'P', 'A', 'R', '0', '2' };
+static const uint32_t ParseCacheByteOrder   = 0x01020304;
+
+static void
+WriteParseCacheString( std::ostream & os, const std::string & s )
+{
+  const uint32_t length = static_cast< uint32_t >( s.size() );
+  os.write( reinterpret_cast< const char * >( &length ), sizeof( length ) );
+  os.write( s.data(), length );
+}
+
+
+static bool
+ReadParseCacheString( std::istream & is, std::string & s, const uint64_t maximumLength )
+{
+  uint32_t length = 0;
+  is.read( reinterpret_cast< char * >( &length ), sizeof( length ) );
+  if( !is || length > maximumLength )
+  {
+    return false;
+  }
+  s.resize( length );
+  if( length > 0 )
+  {
+    is.read( &s[ 0 ], length );
+  }
+  return static_cast< bool >( is );
+}
+
+
+/**
+ * **************** ReadParseCache ***************
+ */
+
+bool
 ParameterFileParser
-::SplitLine( const std::string & fullLine, const std::string & line,
-  std::vector< std::string > & splittedLine ) const
+::ReadParseCache( const std::string & cacheFileName,
+  const uint64_t contentHash, const std::string & content )
 {
-  splittedLine.clear();
-  splittedLine.resize( 1 );
+  const uint64_t contentSize = content.size();
+  std::ifstream cache( cacheFileName.c_str(),
+    std::ios_base::in | std::ios_base::binary );
+  if( !cache.is_open() )
+  {
+    return false;
+  }
 
-  /** Count the number of quotes in the line. If it is an odd value, the
-   * line contains an error; strings should start and end with a quote, so
-   * the total number of quotes is even.
-   */
-  std::size_t numQuotes = itksys::SystemTools::CountChar( line.c_str(), '"' );
-  if( numQuotes % 2 == 1 )
+  /** Check the header. */
+  char     magic[ 8 ];
+  uint32_t byteOrder = 0;
+  uint64_t hash      = 0;
+  uint64_t size      = 0;
+  uint64_t numberOfParameters = 0;
+  cache.read( magic, sizeof( magic ) );
+  cache.read( reinterpret_cast< char * >( &byteOrder ), sizeof( byteOrder ) );
+  cache.read( reinterpret_cast< char * >( &hash ), sizeof( hash ) );
+  cache.read( reinterpret_cast< char * >( &size ), sizeof( size ) );
+  cache.read( reinterpret_cast< char * >( &numberOfParameters ), sizeof( numberOfParameters ) );
+  if( !cache || !std::equal( magic, magic + sizeof( magic ), ParseCacheMagic )
+    || byteOrder != ParseCacheByteOrder || hash != contentHash
+    || size != contentSize || numberOfParameters > contentSize )
   {
-    /** An invalid parameter line. */
-    std::string hint = "This line has an odd number of quotes (\").";
-    this->ThrowException( fullLine, hint );
+    return false;
+  }
+
+  /** Compare the full content, so that a hash collision is never mistaken for a hit. */
+  std::string cachedContent( static_cast< std::size_t >( contentSize ), '\0' );
+  if( contentSize > 0 )
+  {
+    cache.read( &cachedContent[ 0 ], contentSize );
+  }
+  if( !cache || cachedContent != content )
+  {
+    return false;
   }
 
-  /** Loop over the line. */
-  std::string::const_iterator it;
-  unsigned int                index = 0;
-  numQuotes = 0;
-  for( it = line.begin(); it < line.end(); ++it )
+  /** Read the entries. No name or value is longer than the parameter file. */
+  ParameterMapType map;
+  for( uint64_t i = 0; i < numberOfParameters; ++i )
   {
-    if( *it == '"' )
+    std::string name;
+    uint32_t    numberOfValues = 0;
+    if( !ReadParseCacheString( cache, name, contentSize ) )
     {
-      /** Start a new element. */
-      splittedLine.push_back( "" );
-      index++;
-      numQuotes++;
+      return false;
     }
-    else if( *it == ' ' )
+    cache.read( reinterpret_cast< char * >( &numberOfValues ), sizeof( numberOfValues ) );
+    if( !cache || numberOfValues > contentSize )
     {
-      /** Only start a new element if it is not a quote, otherwise just add
-       * the space to the string.
-       */
-      if( numQuotes % 2 == 0 )
+      return false;
+    }
+    ParameterValuesType & values = map[ name ];
+    values.resize( numberOfValues );
+    for( uint32_t j = 0; j < numberOfValues; ++j )
+    {
+      if( !ReadParseCacheString( cache, values[ j ], contentSize ) )
       {
-        splittedLine.push_back( "" );
-        index++;
+        return false;
       }
-      else
+    }
+  }
+
+  this->m_ParameterMap.swap( map );
+  return true;
+
+} // end ReadParseCache()
+
+
+/**
+ * **************** WriteParseCache ***************
+ */
+
+void
+ParameterFileParser
+::WriteParseCache( const std::string & cacheFileName,
+  const uint64_t contentHash, const std::string & content ) const
+{
+  const uint64_t contentSize = content.size();
+  itksys::SystemTools::MakeDirectory( this->m_ParseCacheDirectory );
+
+  /** Write to a temporary file first, so that a concurrent elastix never
+   * reads a partially written cache file.
+   */
+  std::ostringstream tempName;
+  tempName << cacheFileName << "." << std::hex
+           << reinterpret_cast< std::size_t >( this ) << "."
+           << std::chrono::high_resolution_clock::now().time_since_epoch().count()
+           << ".tmp";
+  {
+    std::ofstream cache( tempName.str().c_str(),
+      std::ios_base::out | std::ios_base::binary | std::ios_base::trunc );
+    if( !cache.is_open() )
+    {
+      return;
+    }
+
+    const uint64_t numberOfParameters = this->m_ParameterMap.size();
+    cache.write( ParseCacheMagic, sizeof( ParseCacheMagic ) );
+    cache.write( reinterpret_cast< const char * >( &ParseCacheByteOrder ), sizeof( ParseCacheByteOrder ) );
+    cache.write( reinterpret_cast< const char * >( &contentHash ), sizeof( contentHash ) );
+    cache.write( reinterpret_cast< const char * >( &contentSize ), sizeof( contentSize ) );
+    cache.write( reinterpret_cast< const char * >( &numberOfParameters ), sizeof( numberOfParameters ) );
+    cache.write( content.data(), contentSize );
+
+    ParameterMapType::const_iterator it;
+    for( it = this->m_ParameterMap.begin(); it != this->m_ParameterMap.end(); ++it )
+    {
+      WriteParseCacheString( cache, it->first );
+      const uint32_t numberOfValues = static_cast< uint32_t >( it->second.size() );
+      cache.write( reinterpret_cast< const char * >( &numberOfValues ), sizeof( numberOfValues ) );
+      for( uint32_t j = 0; j < numberOfValues; ++j )
       {
-        splittedLine[ index ].push_back( *it );
+        WriteParseCacheString( cache, it->second[ j ] );
       }
     }
-    else
+
+    if( !cache )
     {
-      /** Add this character to the element. */
-      splittedLine[ index ].push_back( *it );
+      cache.close();
+      std::remove( tempName.str().c_str() );
+      return;
     }
   }
 
-} // end SplitLine()
+  /** Replace an existing cache file, which has the same content. */
+  if( std::rename( tempName.str().c_str(), cacheFileName.c_str() ) != 0 )
+  {
+    std::remove( tempName.str().c_str() );
+  }
+
+} // end WriteParseCache()
 
 
 /**
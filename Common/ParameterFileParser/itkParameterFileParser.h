@@ -21,6 +21,7 @@
 #include "itkObject.h"
 #include "itkObjectFactory.h"
 #include "itkMacro.h"
+#include "itkIntTypes.h"
 
 #include <map>
 #include <string>
@@ -73,6 +74,18 @@ namespace itk
  *
  * parser->GetParameterMap();
  *
+ * The file is read at once, and each line is tokenized in a single pass
+ * over its characters, which also checks for the invalid characters.
+ *
+ * Optionally, the parsed map is cached in a binary file in the directory set
+ * by SetParseCacheDirectory(). The name of that file is a hash of the content
+ * of the parameter file, so that a next parse of a file with the same content,
+ * for example by a next call of elastix or transformix with the same parameter
+ * file, reads the map from the cache. The cache file also stores the content
+ * itself, which is compared in full, so that a hash collision can not return
+ * the map of another file. Parameter files that contain errors are
+ * never cached, so the exceptions are the same with and without the cache.
+ *
  * \sa itk::ParameterMapInterface
  */
 
@@ -102,6 +115,15 @@ public:
   itkSetStringMacro( ParameterFileName );
   itkGetStringMacro( ParameterFileName );
 
+  /** Set/Get the directory of the binary parse cache. Default: "", which
+   * means that no cache is used. The directory is created when needed.
+   */
+  itkSetStringMacro( ParseCacheDirectory );
+  itkGetStringMacro( ParseCacheDirectory );
+
+  /** Get whether the last ReadParameterFile() got the map from the parse cache. */
+  itkGetConstMacro( ParameterMapIsReadFromCache, bool );
+
   /** Return the parameter map. */
   virtual const ParameterMapType & GetParameterMap( void ) const;
 
@@ -131,20 +153,34 @@ private:
    */
   void BasicFileChecking( void ) const;
 
-  /** Checks a line.
+  /** Checks a line, given by the characters [lineBegin, lineEnd) without the line end.
    * - Returns  true if it is a valid line: containing a parameter.
    * - Returns false if it is a valid line: empty or comment.
    * - Throws an exception if it is not a valid line.
+   * If true, [begin, end) is narrowed to the text between the brackets.
+   */
+  bool CheckLine( const char * lineBegin, const char * lineEnd,
+    const char * & begin, const char * & end ) const;
+
+  /** Splits the text between the brackets in parameter name and values in a
+   * single pass, checks them, and fills m_ParameterMap with the entry.
+   */
+  void GetParameterFromLine( const char * lineBegin, const char * lineEnd,
+    const char * begin, const char * end );
+
+  /** Read the binary parse cache file of a parameter file with the given
+   * content hash and content. Returns false if it does not exist, or if the
+   * content stored in it differs.
    */
-  bool CheckLine( const std::string & line, std::string & lineOut ) const;
+  bool ReadParseCache( const std::string & cacheFileName,
+    const uint64_t contentHash, const std::string & content );
 
-  /** Fills m_ParameterMap with valid entries. */
-  void GetParameterFromLine( const std::string & fullLine,
-    const std::string & line );
+  /** Write the content and m_ParameterMap to the binary parse cache. Failures are ignored. */
+  void WriteParseCache( const std::string & cacheFileName,
+    const uint64_t contentHash, const std::string & content ) const;
 
-  /** Splits a line in parameter name and values. */
-  void SplitLine( const std::string & fullLine, const std::string & line,
-    std::vector< std::string > & splittedLine ) const;
+  /** Compute the 64 bits FNV-1a hash of the content of a file. */
+  static uint64_t ComputeContentHash( const std::string & content );
 
   /** Uniform way to throw exceptions when the parameter file appears to be
    * invalid.
@@ -155,6 +191,8 @@ private:
   std::string      m_ParameterFileName;
   std::ifstream    m_ParameterFile;
   ParameterMapType m_ParameterMap;
+  std::string      m_ParseCacheDirectory;
+  bool             m_ParameterMapIsReadFromCache;
 
 };
 
@@ -56,6 +56,10 @@ ParameterMapInterface
   if( !parMap.empty() )
   {
     this->m_ParameterMap = parMap;
+
+    /** The cached values belong to the previous map. */
+    std::lock_guard< std::mutex > lock( this->m_CacheMutex );
+    this->m_Cache.clear();
   }
 
 } // end SetParameterMap()
@@ -146,6 +150,21 @@ ParameterMapInterface
 } // end StringCast()
 
 
+/**
+ * **************** CachedStringCast ***************
+ */
+
+bool
+ParameterMapInterface
+::CachedStringCast( const std::string & itkNotUsed( parameterName ),
+  const ParameterValuesType & vec, const unsigned int entry_nr,
+  std::string & casted ) const
+{
+  casted = vec[ entry_nr ];
+  return true;
+} // end CachedStringCast()
+
+
 /**
  * **************** ReadParameter ***************
  */
@@ -27,6 +27,10 @@
 #include "itkParameterFileParser.h"
 
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <typeindex>
+#include <unordered_map>
 
 namespace itk
 {
@@ -67,6 +71,11 @@ namespace itk
  * Note that some of the templated functions are defined in the header to
  * get it compiling on some platforms.
  *
+ * The values are converted from strings only once per type: the converted
+ * values are cached per parameter name and type, so that repeated calls of
+ * ReadParameter(), for example for every resolution, do not parse the strings
+ * again. The cache is cleared by SetParameterMap().
+ *
  * \sa itk::ParameterFileParser
  */
 
@@ -169,7 +178,7 @@ public:
     }
 
     /** Cast the string to type T. */
-    bool castSuccesful = this->StringCast( vec[ entry_nr ], parameterValue );
+    bool castSuccesful = this->CachedStringCast( parameterName, vec, entry_nr, parameterValue );
 
     /** Check if the cast was successful. */
     if( !castSuccesful )
@@ -353,7 +362,7 @@ public:
     for( unsigned int i = entry_nr_start; i < entry_nr_end + 1; ++i )
     {
       /** Cast the string to type T. */
-      bool castSuccesful = this->StringCast( vec[ i ], parameterValues[ j ] );
+      bool castSuccesful = this->CachedStringCast( parameterName, vec, i, parameterValues[ j ] );
       j++;
 
       /** Check if the cast was successful. */
@@ -399,6 +408,83 @@ private:
 
   bool m_PrintErrorMessages;
 
+  /** The cache of the converted values of a parameter, for one type T.
+   * Per entry it is stored whether the string is converted already.
+   */
+  class CachedValuesBase
+  {
+public:
+
+    virtual ~CachedValuesBase() {}
+  };
+
+  template< class T >
+  class CachedValues : public CachedValuesBase
+  {
+public:
+
+    std::vector< T >    m_Values;
+    std::vector< bool > m_IsConverted;
+  };
+
+  /** The cache is indexed by the parameter name and the type. */
+  typedef std::pair< std::string, std::type_index > CacheKeyType;
+  struct CacheKeyHash
+  {
+    std::size_t operator()( const CacheKeyType & key ) const
+    {
+      return std::hash< std::string >()( key.first ) ^ ( key.second.hash_code() * 31 );
+    }
+  };
+
+  typedef std::unordered_map< CacheKeyType,
+    std::unique_ptr< CachedValuesBase >, CacheKeyHash >  CacheType;
+
+  /** The cache is filled by the const ReadParameter() functions. */
+  mutable CacheType  m_Cache;
+  mutable std::mutex m_CacheMutex;
+
+  /** Cast entry entry_nr of the values vec of parameterName to type T,
+   * through the cache. Returns false if the cast fails, which is not cached.
+   */
+  template< class T >
+  bool CachedStringCast( const std::string & parameterName,
+    const ParameterValuesType & vec, const unsigned int entry_nr, T & casted ) const
+  {
+    std::lock_guard< std::mutex > lock( this->m_CacheMutex );
+
+    std::unique_ptr< CachedValuesBase > & base
+      = this->m_Cache[ CacheKeyType( parameterName, std::type_index( typeid( T ) ) ) ];
+    if( !base )
+    {
+      CachedValues< T > * values = new CachedValues< T >;
+      values->m_Values.resize( vec.size() );
+      values->m_IsConverted.assign( vec.size(), false );
+      base.reset( values );
+    }
+    CachedValues< T > & values = static_cast< CachedValues< T > & >( *base );
+
+    if( !values.m_IsConverted[ entry_nr ] )
+    {
+      if( !this->StringCast( vec[ entry_nr ], values.m_Values[ entry_nr ] ) )
+      {
+        casted = values.m_Values[ entry_nr ];
+        return false;
+      }
+      values.m_IsConverted[ entry_nr ] = true;
+    }
+    casted = values.m_Values[ entry_nr ];
+    return true;
+
+  } // end CachedStringCast()
+
+
+  /** Strings need no conversion, so they are not cached. */
+  bool CachedStringCast( const std::string & parameterName,
+    const ParameterValuesType & vec, const unsigned int entry_nr,
+    std::string & casted ) const;
+
+
   /** A templated function to cast strings to a type T.
    * Returns true when casting was successful and false otherwise.
    * We make use of the casting functionality of string streams.
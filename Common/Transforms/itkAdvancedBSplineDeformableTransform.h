@@ -175,6 +175,8 @@ public:
 
   typedef typename Superclass
     ::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
+  typedef typename Superclass
+    ::NonZeroJacobianIndicesValueType NonZeroJacobianIndicesValueType;
   typedef typename Superclass::SpatialJacobianType SpatialJacobianType;
   typedef typename Superclass
     ::JacobianOfSpatialJacobianType JacobianOfSpatialJacobianType;
@@ -267,6 +269,28 @@ public:
     DerivativeType & imageJacobian,
     NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const override;
 
+  /** Batch versions of TransformPoint(), GetJacobian() and
+   * EvaluateJacobianWithImageGradientProduct(). The weights and the index
+   * arrays are set up once for the whole block of points.
+   */
+  void TransformPoints(
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    const SizeValueType numberOfPoints ) const override;
+
+  void GetJacobians(
+    const InputPointType * inputPoints,
+    const SizeValueType numberOfPoints,
+    ParametersValueType * jacobians,
+    NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const override;
+
+  void EvaluateJacobianWithImageGradientProducts(
+    const InputPointType * inputPoints,
+    const MovingImageGradientType * movingImageGradients,
+    const SizeValueType numberOfPoints,
+    ParametersValueType * imageJacobians,
+    NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void GetSpatialJacobian(
     const InputPointType & ipp,
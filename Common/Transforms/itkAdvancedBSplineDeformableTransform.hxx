@@ -517,6 +517,175 @@ AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* TransformPoints ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  const SizeValueType numberOfPoints ) const
+{
+  /** Allocate memory on the stack, once for all points. */
+  const unsigned long numberOfWeights = WeightsFunctionType::NumberOfWeights;
+  typename WeightsType::ValueType weightsArray[ numberOfWeights ];
+  typename ParameterIndexArrayType::ValueType indicesArray[ numberOfWeights ];
+  WeightsType             weights( weightsArray, numberOfWeights, false );
+  ParameterIndexArrayType indices( indicesArray, numberOfWeights, false );
+
+  bool inside;
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    /** Copy the input point, to allow inputPoints == outputPoints. */
+    const InputPointType point = inputPoints[ i ];
+    this->TransformPoint( point, outputPoints[ i ], weights, indices, inside );
+  }
+
+} // end TransformPoints()
+
+
+/**
+ * ********************* GetJacobians ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::GetJacobians(
+  const InputPointType * inputPoints,
+  const SizeValueType numberOfPoints,
+  ParametersValueType * jacobians,
+  NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const
+{
+  /** Sanity check. */
+  if( this->m_InputParametersPointer == NULL )
+  {
+    itkExceptionMacro( << "Cannot compute Jacobian: parameters not set" );
+  }
+
+  /** Initialize some helper variables, once for all points. */
+  const unsigned long          numberOfWeights = WeightsFunctionType::NumberOfWeights;
+  const NumberOfParametersType nnzji           = this->GetNumberOfNonZeroJacobianIndices();
+  const SizeValueType          jacobianSize    = SpaceDimension * nnzji;
+  typename WeightsType::ValueType weightsArray[ numberOfWeights ];
+  WeightsType                weights( weightsArray, numberOfWeights, false );
+  NonZeroJacobianIndicesType nzji( nnzji );
+  RegionType                 supportRegion;
+  supportRegion.SetSize( this->m_SupportSize );
+
+  /** Only the diagonal blocks are nonzero. */
+  std::fill( jacobians, jacobians + numberOfPoints * jacobianSize, 0.0 );
+
+  for( SizeValueType p = 0; p < numberOfPoints; ++p )
+  {
+    ParametersValueType *             jacobianPointer = jacobians + p * jacobianSize;
+    NonZeroJacobianIndicesValueType * nzjiPointer     = nonZeroJacobianIndices + p * nnzji;
+
+    ContinuousIndexType cindex;
+    this->TransformPointToContinuousGridIndex( inputPoints[ p ], cindex );
+
+    /** NOTE: if the support region does not lie totally within the grid
+     * we assume zero displacement and zero Jacobian.
+     */
+    if( !this->InsideValidRegion( cindex ) )
+    {
+      for( NumberOfParametersType i = 0; i < nnzji; ++i )
+      {
+        nzjiPointer[ i ] = i;
+      }
+      continue;
+    }
+
+    /** Compute the weights and put them at the right positions. */
+    IndexType supportIndex;
+    this->m_WeightsFunction->ComputeStartIndex( cindex, supportIndex );
+    this->m_WeightsFunction->Evaluate( cindex, supportIndex, weights );
+    for( unsigned int d = 0; d < SpaceDimension; ++d )
+    {
+      const unsigned long offset = d * SpaceDimension * numberOfWeights + d * numberOfWeights;
+      std::copy( weightsArray, weightsArray + numberOfWeights, jacobianPointer + offset );
+    }
+
+    /** Compute the nonzero Jacobian indices. */
+    supportRegion.SetIndex( supportIndex );
+    this->ComputeNonZeroJacobianIndices( nzji, supportRegion );
+    std::copy( nzji.begin(), nzji.end(), nzjiPointer );
+  }
+
+} // end GetJacobians()
+
+
+/**
+ * ********************* EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType * inputPoints,
+  const MovingImageGradientType * movingImageGradients,
+  const SizeValueType numberOfPoints,
+  ParametersValueType * imageJacobians,
+  NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const
+{
+  /** Initialize some helper variables, once for all points. */
+  const unsigned long          numberOfWeights = WeightsFunctionType::NumberOfWeights;
+  const NumberOfParametersType nnzji           = this->GetNumberOfNonZeroJacobianIndices();
+  typename WeightsType::ValueType weightsArray[ numberOfWeights ];
+  WeightsType                weights( weightsArray, numberOfWeights, false );
+  NonZeroJacobianIndicesType nzji( nnzji );
+  RegionType                 supportRegion;
+  supportRegion.SetSize( this->m_SupportSize );
+
+  for( SizeValueType p = 0; p < numberOfPoints; ++p )
+  {
+    ParametersValueType *             imageJacobian = imageJacobians + p * nnzji;
+    NonZeroJacobianIndicesValueType * nzjiPointer   = nonZeroJacobianIndices + p * nnzji;
+
+    ContinuousIndexType cindex;
+    this->TransformPointToContinuousGridIndex( inputPoints[ p ], cindex );
+
+    /** NOTE: if the support region does not lie totally within the grid
+     * we assume zero displacement and zero Jacobian.
+     */
+    if( !this->InsideValidRegion( cindex ) )
+    {
+      for( NumberOfParametersType i = 0; i < nnzji; ++i )
+      {
+        nzjiPointer[ i ]   = i;
+        imageJacobian[ i ] = 0.0;
+      }
+      continue;
+    }
+
+    /** Compute the B-spline weights. */
+    IndexType supportIndex;
+    this->m_WeightsFunction->ComputeStartIndex( cindex, supportIndex );
+    this->m_WeightsFunction->Evaluate( cindex, supportIndex, weights );
+
+    /** Compute the inner product. */
+    for( unsigned int d = 0; d < SpaceDimension; ++d )
+    {
+      const MovingImageGradientValueType mig = movingImageGradients[ p ][ d ];
+      for( unsigned long i = 0; i < numberOfWeights; ++i )
+      {
+        imageJacobian[ d * numberOfWeights + i ] = weightsArray[ i ] * mig;
+      }
+    }
+
+    /** Compute the nonzero Jacobian indices. */
+    supportRegion.SetIndex( supportIndex );
+    this->ComputeNonZeroJacobianIndices( nzji, supportRegion );
+    std::copy( nzji.begin(), nzji.end(), nzjiPointer );
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
 /**
  * ********************* GetSpatialJacobian ****************************
  */
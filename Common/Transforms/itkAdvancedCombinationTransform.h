@@ -21,6 +21,8 @@
 #include "itkAdvancedTransform.h"
 #include "itkExceptionObject.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -91,6 +93,7 @@ public:
   typedef typename Superclass::InputPointType                InputPointType;
   typedef typename Superclass::OutputPointType               OutputPointType;
   typedef typename Superclass::NonZeroJacobianIndicesType    NonZeroJacobianIndicesType;
+  typedef typename Superclass::NonZeroJacobianIndicesValueType NonZeroJacobianIndicesValueType;
   typedef typename Superclass::SpatialJacobianType           SpatialJacobianType;
   typedef typename Superclass::JacobianOfSpatialJacobianType JacobianOfSpatialJacobianType;
   typedef typename Superclass::SpatialHessianType            SpatialHessianType;
@@ -157,6 +160,37 @@ public:
 
   itkGetConstMacro( UseAddition, bool );
 
+  /** Fold the chain of transforms, for a faster TransformPoint() and
+   * TransformPoints(). The chain of initial transforms, as read from a
+   * series of transform parameter files, is flattened into a list of stages.
+   * Consecutive linear transforms, such as the AdvancedMatrixOffsetTransformBase
+   * subclasses and the AdvancedTranslationTransform, are multiplied into a
+   * single affine map, which is applied just before the next non-linear
+   * transform. The cost per point then scales with the number of non-linear
+   * transforms only. Transforms that are combined by addition are not folded.
+   *
+   * The folded chain is a snapshot: it is dropped by the setters of this
+   * transform, but not by changes of the parameters of the initial transforms.
+   * Call FoldTransformChain() again after such changes. The other functions,
+   * like GetJacobian(), always use the original chain.
+   */
+  virtual void FoldTransformChain( void );
+
+  /** Return to the original chain of transforms. */
+  virtual void UnfoldTransformChain( void );
+
+  /** Get whether the chain of transforms is folded. */
+  itkGetConstMacro( TransformChainIsFolded, bool );
+
+  /** Get the number of stages of the folded chain, i.e. the number of
+   * non-linear transforms, plus one if the chain ends with a linear one.
+   */
+  virtual SizeValueType GetNumberOfFoldedStages( void ) const
+  {
+    return static_cast< SizeValueType >( this->m_FoldedChain.size() );
+  }
+
+
   /**  Method to transform a point. */
   OutputPointType TransformPoint( const InputPointType  & point ) const override;
 
@@ -251,6 +285,28 @@ public:
     DerivativeType & imageJacobian,
     NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const override;
 
+  /** Batch versions of TransformPoint(), GetJacobian() and
+   * EvaluateJacobianWithImageGradientProduct(). The initial and current
+   * transform are each called once for the whole batch.
+   */
+  void TransformPoints(
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    const SizeValueType numberOfPoints ) const override;
+
+  void GetJacobians(
+    const InputPointType * inputPoints,
+    const SizeValueType numberOfPoints,
+    ParametersValueType * jacobians,
+    NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const override;
+
+  void EvaluateJacobianWithImageGradientProducts(
+    const InputPointType * inputPoints,
+    const MovingImageGradientType * movingImageGradients,
+    const SizeValueType numberOfPoints,
+    ParametersValueType * imageJacobians,
+    NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void GetSpatialJacobian(
     const InputPointType & ipp,
@@ -395,6 +451,18 @@ protected:
   inline OutputPointType TransformPointNoCurrentTransform(
     const InputPointType & point ) const;
 
+  /** FOLDED CHAIN: \f$T(x) = T_n( A_n ( \cdots T_1( A_1 x + b_1 ) \cdots ) + b_n )\f$ */
+  inline OutputPointType TransformPointUseFoldedChain(
+    const InputPointType & point ) const;
+
+  /** Whether TransformPoint() of this transform is the combination of its
+   * initial and current transform, so that FoldTransformChain() may look
+   * inside it. Subclasses that override TransformPoint() should return false.
+   * The batch functions, like TransformPoints(), then call the single point
+   * versions of the subclass for every point.
+   */
+  virtual bool GetTransformChainIsFoldable( void ) const { return true; }
+
   /** ************************************************
    * Methods to compute the sparse Jacobian.
    */
@@ -625,6 +693,32 @@ protected:
 
 private:
 
+  /** A stage of the folded chain: an optional affine map, followed by an
+   * optional non-linear transform.
+   */
+  struct FoldedStageType
+  {
+    bool                         m_HasAffine;
+    SpatialJacobianType          m_Matrix;
+    OutputVectorType             m_Offset;
+    CurrentTransformConstPointer m_Transform;
+  };
+
+  typedef std::vector< FoldedStageType > FoldedChainType;
+
+  /** Append a transform to the folded chain, looking inside combination
+   * transforms, and multiplying linear transforms into the pending affine map.
+   */
+  void AppendToFoldedChain( const CurrentTransformType * transform,
+    FoldedStageType & pending, FoldedChainType & chain ) const;
+
+  /** Reset a stage to the identity without a transform. */
+  static void ResetFoldedStage( FoldedStageType & stage );
+
+  /** The folded chain. */
+  FoldedChainType m_FoldedChain;
+  bool            m_TransformChainIsFolded;
+
   AdvancedCombinationTransform( const Self & ); // purposely not implemented
   void operator=( const Self & );               // purposely not implemented
 
@@ -19,6 +19,10 @@
 #define __itkAdvancedCombinationTransform_hxx
 
 #include "itkAdvancedCombinationTransform.h"
+#include "itkAdvancedMatrixOffsetTransformBase.h"
+
+#include <algorithm>
+#include <vector>
 
 namespace itk
 {
@@ -39,6 +43,9 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
   this->m_UseAddition    = false;
   this->m_UseComposition = true;
 
+  /** The chain is not folded by default. */
+  this->m_TransformChainIsFolded = false;
+
   /** Set everything to have no current transform. */
   this->m_SelectedTransformPointFunction
     = &Self::TransformPointNoCurrentTransform;
@@ -325,6 +332,10 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
   if( this->m_CurrentTransform.IsNotNull() )
   {
     this->Modified();
+    if( this->m_TransformChainIsFolded )
+    {
+      this->UnfoldTransformChain();
+    }
     this->m_CurrentTransform->SetParameters( param );
   }
   else
@@ -349,6 +360,10 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
   if( this->m_CurrentTransform.IsNotNull() )
   {
     this->Modified();
+    if( this->m_TransformChainIsFolded )
+    {
+      this->UnfoldTransformChain();
+    }
     this->m_CurrentTransform->SetFixedParameters( param );
   }
   else
@@ -373,6 +388,10 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
   if( this->m_CurrentTransform.IsNotNull() )
   {
     this->Modified();
+    if( this->m_TransformChainIsFolded )
+    {
+      this->UnfoldTransformChain();
+    }
     this->m_CurrentTransform->SetParametersByValue( param );
   }
   else
@@ -626,6 +645,10 @@ void
 AdvancedCombinationTransform< TScalarType, NDimensions >
 ::UpdateCombinationMethod( void )
 {
+  /** Drop the folded chain, if any. */
+  this->m_FoldedChain.clear();
+  this->m_TransformChainIsFolded = false;
+
   /** Update the m_SelectedTransformPointFunction and
    * the m_SelectedGetJacobianFunction
    */
@@ -725,6 +748,142 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
 } // end UpdateCombinationMethod()
 
 
+/**
+ * ****************** FoldTransformChain ********************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::FoldTransformChain( void )
+{
+  /** Start from the original chain. */
+  this->UpdateCombinationMethod();
+  if( this->m_CurrentTransform.IsNull() )
+  {
+    this->NoCurrentTransformSet();
+  }
+  if( !this->GetTransformChainIsFoldable() )
+  {
+    return;
+  }
+
+  /** Flatten the chain, and append the trailing affine map, if any. */
+  FoldedChainType chain;
+  FoldedStageType pending;
+  ResetFoldedStage( pending );
+  this->AppendToFoldedChain( this, pending, chain );
+  if( pending.m_HasAffine )
+  {
+    chain.push_back( pending );
+  }
+
+  this->m_FoldedChain                    = chain;
+  this->m_TransformChainIsFolded         = true;
+  this->m_SelectedTransformPointFunction = &Self::TransformPointUseFoldedChain;
+
+} // end FoldTransformChain()
+
+
+/**
+ * ****************** UnfoldTransformChain ********************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::UnfoldTransformChain( void )
+{
+  this->UpdateCombinationMethod();
+
+} // end UnfoldTransformChain()
+
+
+/**
+ * ****************** AppendToFoldedChain ********************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::AppendToFoldedChain( const CurrentTransformType * transform,
+  FoldedStageType & pending, FoldedChainType & chain ) const
+{
+  /** Look inside combination transforms that use composition. */
+  const Self * combination = dynamic_cast< const Self * >( transform );
+  if( combination != 0 && combination->GetTransformChainIsFoldable()
+    && combination->m_CurrentTransform.IsNotNull()
+    && ( combination->m_InitialTransform.IsNull() || combination->m_UseComposition ) )
+  {
+    if( combination->m_InitialTransform.IsNotNull() )
+    {
+      this->AppendToFoldedChain( combination->m_InitialTransform.GetPointer(), pending, chain );
+    }
+    this->AppendToFoldedChain( combination->m_CurrentTransform.GetPointer(), pending, chain );
+    return;
+  }
+
+  /** A non-linear transform closes the pending stage. */
+  if( !transform->IsLinear() )
+  {
+    pending.m_Transform = transform;
+    chain.push_back( pending );
+    ResetFoldedStage( pending );
+    return;
+  }
+
+  /** Get the affine map A x + b of the linear transform. The matrix-offset
+   * transforms provide it, for other ones evaluate it at the origin.
+   */
+  typedef AdvancedMatrixOffsetTransformBase< ScalarType, SpaceDimension, SpaceDimension >
+    MatrixOffsetTransformType;
+  const MatrixOffsetTransformType * matrixOffsetTransform
+    = dynamic_cast< const MatrixOffsetTransformType * >( transform );
+
+  SpatialJacobianType matrix;
+  OutputVectorType    offset;
+  if( matrixOffsetTransform != 0 )
+  {
+    matrix = matrixOffsetTransform->GetMatrix();
+    offset = matrixOffsetTransform->GetOffset();
+  }
+  else
+  {
+    InputPointType origin;
+    origin.Fill( NumericTraits< ScalarType >::ZeroValue() );
+    transform->GetSpatialJacobian( origin, matrix );
+    const OutputPointType mappedOrigin = transform->TransformPoint( origin );
+    for( unsigned int i = 0; i < SpaceDimension; ++i )
+    {
+      offset[ i ] = mappedOrigin[ i ];
+    }
+  }
+
+  /** Multiply it into the pending affine map: A (A_p x + b_p) + b. */
+  pending.m_Offset    = matrix * pending.m_Offset + offset;
+  pending.m_Matrix    = matrix * pending.m_Matrix;
+  pending.m_HasAffine = true;
+
+} // end AppendToFoldedChain()
+
+
+/**
+ * ****************** ResetFoldedStage ********************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::ResetFoldedStage( FoldedStageType & stage )
+{
+  stage.m_HasAffine = false;
+  stage.m_Matrix.SetIdentity();
+  stage.m_Offset.Fill( NumericTraits< ScalarType >::ZeroValue() );
+  stage.m_Transform = 0;
+
+} // end ResetFoldedStage()
+
+
 /**
  * ************* NoCurrentTransformSet **********************
  */
@@ -817,6 +976,34 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
 } // end TransformPointNoInitialTransform()
 
 
+/**
+ * ******** TransformPointUseFoldedChain ******************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+typename AdvancedCombinationTransform< TScalarType, NDimensions >::OutputPointType
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::TransformPointUseFoldedChain( const InputPointType & point ) const
+{
+  OutputPointType out = point;
+  for( typename FoldedChainType::const_iterator stage = this->m_FoldedChain.begin();
+    stage != this->m_FoldedChain.end(); ++stage )
+  {
+    if( stage->m_HasAffine )
+    {
+      out = stage->m_Matrix * out + stage->m_Offset;
+    }
+    if( stage->m_Transform.IsNotNull() )
+    {
+      out = stage->m_Transform->TransformPoint( out );
+    }
+  }
+
+  return out;
+
+} // end TransformPointUseFoldedChain()
+
+
 /**
  * ******** TransformPointNoCurrentTransform ******************
  */
@@ -1652,6 +1839,153 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ****************** TransformPoints ****************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  const SizeValueType numberOfPoints ) const
+{
+  if( this->m_CurrentTransform.IsNull() )
+  {
+    /** Throw an exception. */
+    this->NoCurrentTransformSet();
+  }
+  else if( !this->GetTransformChainIsFoldable() )
+  {
+    /** A subclass overrides TransformPoint(): call it for every point. */
+    Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+  }
+  else if( this->m_TransformChainIsFolded )
+  {
+    /** Folded chain: every stage works in place on the output. */
+    std::copy( inputPoints, inputPoints + numberOfPoints, outputPoints );
+    for( typename FoldedChainType::const_iterator stage = this->m_FoldedChain.begin();
+      stage != this->m_FoldedChain.end(); ++stage )
+    {
+      if( stage->m_HasAffine )
+      {
+        for( SizeValueType i = 0; i < numberOfPoints; ++i )
+        {
+          outputPoints[ i ] = stage->m_Matrix * outputPoints[ i ] + stage->m_Offset;
+        }
+      }
+      if( stage->m_Transform.IsNotNull() )
+      {
+        stage->m_Transform->TransformPoints( outputPoints, outputPoints, numberOfPoints );
+      }
+    }
+  }
+  else if( this->m_InitialTransform.IsNull() )
+  {
+    this->m_CurrentTransform->TransformPoints( inputPoints, outputPoints, numberOfPoints );
+  }
+  else if( this->m_UseAddition )
+  {
+    for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+      outputPoints[ i ] = this->TransformPointUseAddition( inputPoints[ i ] );
+    }
+  }
+  else
+  {
+    /** Composition: the current transform works in place on the output. */
+    this->m_InitialTransform->TransformPoints( inputPoints, outputPoints, numberOfPoints );
+    this->m_CurrentTransform->TransformPoints( outputPoints, outputPoints, numberOfPoints );
+  }
+
+} // end TransformPoints()
+
+
+/**
+ * ****************** GetJacobians ****************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::GetJacobians(
+  const InputPointType * inputPoints,
+  const SizeValueType numberOfPoints,
+  ParametersValueType * jacobians,
+  NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const
+{
+  if( this->m_CurrentTransform.IsNull() )
+  {
+    /** Throw an exception. */
+    this->NoCurrentTransformSet();
+  }
+  else if( !this->GetTransformChainIsFoldable() )
+  {
+    /** A subclass may override the single point version: call it for every point. */
+    Superclass::GetJacobians( inputPoints, numberOfPoints, jacobians, nonZeroJacobianIndices );
+  }
+  else if( this->m_InitialTransform.IsNull() || this->m_UseAddition )
+  {
+    this->m_CurrentTransform->GetJacobians(
+      inputPoints, numberOfPoints, jacobians, nonZeroJacobianIndices );
+  }
+  else if( numberOfPoints > 0 )
+  {
+    /** Composition: evaluate the current transform at the mapped points. */
+    std::vector< OutputPointType > mappedPoints( numberOfPoints );
+    this->m_InitialTransform->TransformPoints( inputPoints, &mappedPoints[ 0 ], numberOfPoints );
+    this->m_CurrentTransform->GetJacobians(
+      &mappedPoints[ 0 ], numberOfPoints, jacobians, nonZeroJacobianIndices );
+  }
+
+} // end GetJacobians()
+
+
+/**
+ * ****************** EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType * inputPoints,
+  const MovingImageGradientType * movingImageGradients,
+  const SizeValueType numberOfPoints,
+  ParametersValueType * imageJacobians,
+  NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const
+{
+  if( this->m_CurrentTransform.IsNull() )
+  {
+    /** Throw an exception. */
+    this->NoCurrentTransformSet();
+  }
+  else if( !this->GetTransformChainIsFoldable() )
+  {
+    /** A subclass may override the single point version: call it for every point. */
+    Superclass::EvaluateJacobianWithImageGradientProducts( inputPoints, movingImageGradients,
+      numberOfPoints, imageJacobians, nonZeroJacobianIndices );
+  }
+  else if( this->m_InitialTransform.IsNull() || this->m_UseAddition )
+  {
+    this->m_CurrentTransform->EvaluateJacobianWithImageGradientProducts(
+      inputPoints, movingImageGradients, numberOfPoints,
+      imageJacobians, nonZeroJacobianIndices );
+  }
+  else if( numberOfPoints > 0 )
+  {
+    /** Composition: evaluate the current transform at the mapped points. */
+    std::vector< OutputPointType > mappedPoints( numberOfPoints );
+    this->m_InitialTransform->TransformPoints( inputPoints, &mappedPoints[ 0 ], numberOfPoints );
+    this->m_CurrentTransform->EvaluateJacobianWithImageGradientProducts(
+      &mappedPoints[ 0 ], movingImageGradients, numberOfPoints,
+      imageJacobians, nonZeroJacobianIndices );
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
 /**
  * ****************** GetSpatialJacobian ****************************
  */
@@ -343,6 +343,10 @@ public:
    */
   OutputPointType     TransformPoint( const InputPointType & point ) const override;
 
+  /** Transform a block of points, with the matrix and offset loaded only once. */
+  void TransformPoints( const InputPointType * inputPoints,
+    OutputPointType * outputPoints, const SizeValueType numberOfPoints ) const override;
+
   OutputVectorType    TransformVector( const InputVectorType & vector ) const override;
 
   OutputVnlVectorType TransformVector( const InputVnlVectorType & vector ) const override;
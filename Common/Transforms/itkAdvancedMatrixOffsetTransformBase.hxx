@@ -264,6 +264,50 @@ AdvancedMatrixOffsetTransformBase< TScalarType, NInputDimensions, NOutputDimensi
 }
 
 
+// Transform a block of points
+template< class TScalarType, unsigned int NInputDimensions,
+unsigned int NOutputDimensions >
+void
+AdvancedMatrixOffsetTransformBase< TScalarType, NInputDimensions, NOutputDimensions >
+::TransformPoints( const InputPointType * inputPoints,
+  OutputPointType * outputPoints, const SizeValueType numberOfPoints ) const
+{
+  /** Copy the matrix and offset to plain local arrays, so that the compiler
+   * can keep them in registers and vectorize the loop over the points.
+   */
+  ScalarType matrix[ NOutputDimensions ][ NInputDimensions ];
+  ScalarType offset[ NOutputDimensions ];
+  for( unsigned int i = 0; i < NOutputDimensions; ++i )
+  {
+    for( unsigned int j = 0; j < NInputDimensions; ++j )
+    {
+      matrix[ i ][ j ] = this->m_Matrix( i, j );
+    }
+    offset[ i ] = this->m_Offset[ i ];
+  }
+
+  for( SizeValueType n = 0; n < numberOfPoints; ++n )
+  {
+    /** Read the input first, to allow inputPoints == outputPoints. */
+    ScalarType in[ NInputDimensions ];
+    for( unsigned int j = 0; j < NInputDimensions; ++j )
+    {
+      in[ j ] = inputPoints[ n ][ j ];
+    }
+    for( unsigned int i = 0; i < NOutputDimensions; ++i )
+    {
+      ScalarType out = offset[ i ];
+      for( unsigned int j = 0; j < NInputDimensions; ++j )
+      {
+        out += matrix[ i ][ j ] * in[ j ];
+      }
+      outputPoints[ n ][ i ] = out;
+    }
+  }
+
+} // end TransformPoints()
+
+
 // Transform a vector
 template< class TScalarType, unsigned int NInputDimensions,
 unsigned int NOutputDimensions >
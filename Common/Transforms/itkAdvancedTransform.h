@@ -158,6 +158,9 @@ public:
   typedef OutputCovariantVectorType                   MovingImageGradientType;
   typedef typename MovingImageGradientType::ValueType MovingImageGradientValueType;
 
+  /** Typedef for the caller-owned buffers of the batch functions. */
+  typedef typename NonZeroJacobianIndicesType::value_type NonZeroJacobianIndicesValueType;
+
   /** Get the number of nonzero Jacobian indices. By default all. */
   virtual NumberOfParametersType GetNumberOfNonZeroJacobianIndices( void ) const;
 
@@ -205,6 +208,42 @@ public:
     DerivativeType & imageJacobian,
     NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const;
 
+  /** Batch versions of TransformPoint(), GetJacobian() and
+   * EvaluateJacobianWithImageGradientProduct().
+   *
+   * These functions evaluate a block of numberOfPoints points in a single
+   * (virtual) call, and write the results into buffers owned by the caller.
+   * Transforms override them with tight loops, so that per point there is no
+   * virtual call, no resizing of NonZeroJacobianIndicesType vectors, and the
+   * loop invariants are set up only once. The default implementations simply
+   * call the single point versions.
+   *
+   * With nnzji = GetNumberOfNonZeroJacobianIndices(), the buffers are laid out
+   * as follows:
+   * \li outputPoints: numberOfPoints points. It may be the same buffer as inputPoints.
+   * \li jacobians: for every point an OutputSpaceDimension x nnzji block,
+   *   stored row by row, as in JacobianType.
+   * \li imageJacobians: for every point a block of nnzji values.
+   * \li nonZeroJacobianIndices: for every point a block of nnzji indices.
+   */
+  virtual void TransformPoints(
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    const SizeValueType numberOfPoints ) const;
+
+  virtual void GetJacobians(
+    const InputPointType * inputPoints,
+    const SizeValueType numberOfPoints,
+    ParametersValueType * jacobians,
+    NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const;
+
+  virtual void EvaluateJacobianWithImageGradientProducts(
+    const InputPointType * inputPoints,
+    const MovingImageGradientType * movingImageGradients,
+    const SizeValueType numberOfPoints,
+    ParametersValueType * imageJacobians,
+    NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const;
+
   /** Compute the spatial Jacobian of the transformation.
    *
    * The spatial Jacobian is expressed as a vector of partial derivatives of the
@@ -36,6 +36,8 @@
 
 #include "itkAdvancedTransform.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -107,6 +109,93 @@ AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* TransformPoints ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  const SizeValueType numberOfPoints ) const
+{
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    outputPoints[ i ] = this->TransformPoint( inputPoints[ i ] );
+  }
+
+} // end TransformPoints()
+
+
+/**
+ * ********************* GetJacobians ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::GetJacobians(
+  const InputPointType * inputPoints,
+  const SizeValueType numberOfPoints,
+  ParametersValueType * jacobians,
+  NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const
+{
+  const NumberOfParametersType nnzji = this->GetNumberOfNonZeroJacobianIndices();
+  const SizeValueType          jacobianSize = OutputSpaceDimension * nnzji;
+
+  /** Reuse the same temporaries for all points. */
+  JacobianType               jacobian;
+  NonZeroJacobianIndicesType nzji( nnzji );
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    this->GetJacobian( inputPoints[ i ], jacobian, nzji );
+    if( nzji.size() != nnzji || jacobian.size() != jacobianSize )
+    {
+      itkExceptionMacro( << "GetJacobian() does not return "
+                         << "GetNumberOfNonZeroJacobianIndices() columns." );
+    }
+    std::copy( jacobian.data_block(), jacobian.data_block() + jacobianSize,
+      jacobians + i * jacobianSize );
+    std::copy( nzji.begin(), nzji.end(), nonZeroJacobianIndices + i * nnzji );
+  }
+
+} // end GetJacobians()
+
+
+/**
+ * ********************* EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType * inputPoints,
+  const MovingImageGradientType * movingImageGradients,
+  const SizeValueType numberOfPoints,
+  ParametersValueType * imageJacobians,
+  NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const
+{
+  const NumberOfParametersType nnzji = this->GetNumberOfNonZeroJacobianIndices();
+
+  /** The image Jacobian of each point is written directly in the caller's
+   * buffer, by letting a DerivativeType point to it.
+   */
+  DerivativeType             imageJacobian;
+  NonZeroJacobianIndicesType nzji( nnzji );
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    imageJacobian.SetData( imageJacobians + i * nnzji, nnzji, false );
+    this->EvaluateJacobianWithImageGradientProduct(
+      inputPoints[ i ], movingImageGradients[ i ], imageJacobian, nzji );
+    std::copy( nzji.begin(), nzji.end(), nonZeroJacobianIndices + i * nnzji );
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
 /**
  * ********************* GetNumberOfNonZeroJacobianIndices ****************************
  */
@@ -0,0 +1,186 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkAdvancedTransformToDisplacementFieldSource_h
+#define __itkAdvancedTransformToDisplacementFieldSource_h
+
+#include "itkAdvancedTransform.h"
+#include "itkImageSource.h"
+
+namespace itk
+{
+
+/** \class AdvancedTransformToDisplacementFieldSource
+ * \brief Generate a displacement field from an advanced coordinate transform.
+ *
+ * The output is an image of vectors, with at every pixel \f$T(x) - x\f$.
+ * This class is similar to the itk::TransformToDisplacementFieldFilter, but
+ * transforms the points of the output image row by row, with the
+ * TransformPoints() function of the AdvancedTransform. This batched function
+ * is faster than TransformPoint() per pixel for the B-spline transforms, and for
+ * folded chains of transforms.
+ *
+ * Output information (spacing, size and direction) for the output
+ * image should be set. This information has the normal defaults of
+ * unit spacing, zero origin and identity direction.
+ *
+ * The filter generates only the requested region of the output, so it can
+ * be streamed, for example by an ImageFileWriter with a number of stream
+ * divisions. The row by row computation is multithreaded.
+ *
+ * \ingroup GeometricTransforms
+ */
+template< class TOutputImage,
+class TTransformPrecisionType = double >
+class AdvancedTransformToDisplacementFieldSource :
+  public ImageSource< TOutputImage >
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef AdvancedTransformToDisplacementFieldSource Self;
+  typedef ImageSource< TOutputImage >                Superclass;
+  typedef SmartPointer< Self >                       Pointer;
+  typedef SmartPointer< const Self >                 ConstPointer;
+
+  typedef TOutputImage                           OutputImageType;
+  typedef typename OutputImageType::Pointer      OutputImagePointer;
+  typedef typename OutputImageType::ConstPointer OutputImageConstPointer;
+  typedef typename OutputImageType::RegionType   OutputImageRegionType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( AdvancedTransformToDisplacementFieldSource, ImageSource );
+
+  /** Number of dimensions. */
+  itkStaticConstMacro( ImageDimension, unsigned int,
+    TOutputImage::ImageDimension );
+
+  /** Typedefs for transform. */
+  typedef AdvancedTransform< TTransformPrecisionType,
+    itkGetStaticConstMacro( ImageDimension ),
+    itkGetStaticConstMacro( ImageDimension ) >  TransformType;
+  typedef typename TransformType::ConstPointer     TransformPointerType;
+  typedef typename TransformType::InputPointType   InputPointType;
+  typedef typename TransformType::OutputPointType  OutputPointType;
+
+  /** Typedefs for output image. */
+  typedef typename OutputImageType::PixelType      PixelType;
+  typedef typename PixelType::ValueType            PixelValueType;
+  typedef typename OutputImageType::RegionType     RegionType;
+  typedef typename RegionType::SizeType            SizeType;
+  typedef typename OutputImageType::IndexType      IndexType;
+  typedef typename OutputImageType::PointType      PointType;
+  typedef typename OutputImageType::SpacingType    SpacingType;
+  typedef typename OutputImageType::PointType      OriginType;
+  typedef typename OutputImageType::DirectionType  DirectionType;
+
+  /** Typedefs for base image. */
+  typedef ImageBase< itkGetStaticConstMacro( ImageDimension ) > ImageBaseType;
+
+  /** Set the coordinate transformation. Note that this is the
+   * output-to-input transform, like in the ResampleImageFilter.
+   * By default the filter uses an identity transform.
+   */
+  itkSetConstObjectMacro( Transform, TransformType );
+
+  /** Get a pointer to the coordinate transform. */
+  itkGetConstObjectMacro( Transform, TransformType );
+
+  /** Set the size of the output image. */
+  virtual void SetOutputSize( const SizeType & size );
+
+  /** Get the size of the output image. */
+  virtual const SizeType & GetOutputSize();
+
+  /** Set the start index of the output largest possible region.
+   * The default is an index of all zeros.
+   */
+  virtual void SetOutputIndex( const IndexType & index );
+
+  /** Get the start index of the output largest possible region. */
+  virtual const IndexType & GetOutputIndex();
+
+  /** Set the region of the output image. */
+  itkSetMacro( OutputRegion, OutputImageRegionType );
+
+  /** Get the region of the output image. */
+  itkGetConstReferenceMacro( OutputRegion, OutputImageRegionType );
+
+  /** Set the output image spacing. */
+  itkSetMacro( OutputSpacing, SpacingType );
+
+  /** Get the output image spacing. */
+  itkGetConstReferenceMacro( OutputSpacing, SpacingType );
+
+  /** Set the output image origin. */
+  itkSetMacro( OutputOrigin, OriginType );
+
+  /** Get the output image origin. */
+  itkGetConstReferenceMacro( OutputOrigin, OriginType );
+
+  /** Set the output direction cosine matrix. */
+  itkSetMacro( OutputDirection, DirectionType );
+  itkGetConstReferenceMacro( OutputDirection, DirectionType );
+
+  /** Helper method to set the output parameters based on this image. */
+  void SetOutputParametersFromImage( const ImageBaseType * image );
+
+  /** Set the output information: the largest region, spacing, origin and direction. */
+  void GenerateOutputInformation( void ) override;
+
+  /** Checking if transform is set. */
+  void BeforeThreadedGenerateData( void ) override;
+
+  /** Compute the Modified Time based on changes to the components. */
+  ModifiedTimeType GetMTime( void ) const override;
+
+protected:
+
+  AdvancedTransformToDisplacementFieldSource();
+  ~AdvancedTransformToDisplacementFieldSource() override {}
+
+  void PrintSelf( std::ostream & os, Indent indent ) const override;
+
+  /** Compute the displacements of the rows of the output region for the thread. */
+  void ThreadedGenerateData(
+    const OutputImageRegionType & outputRegionForThread,
+    ThreadIdType threadId ) override;
+
+private:
+
+  AdvancedTransformToDisplacementFieldSource( const Self & ); // purposely not implemented
+  void operator=( const Self & );                             // purposely not implemented
+
+  /** Member variables. */
+  RegionType           m_OutputRegion;         // region of the output image
+  TransformPointerType m_Transform;            // Coordinate transform to use
+  SpacingType          m_OutputSpacing;        // output image spacing
+  OriginType           m_OutputOrigin;         // output image origin
+  DirectionType        m_OutputDirection;      // output image direction cosines
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAdvancedTransformToDisplacementFieldSource.hxx"
+#endif
+
+#endif // end #ifndef __itkAdvancedTransformToDisplacementFieldSource_h
@@ -0,0 +1,284 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkAdvancedTransformToDisplacementFieldSource_hxx
+#define __itkAdvancedTransformToDisplacementFieldSource_hxx
+
+#include "itkAdvancedTransformToDisplacementFieldSource.h"
+
+#include "itkAdvancedIdentityTransform.h"
+#include "itkProgressReporter.h"
+#include "itkImageLinearIteratorWithIndex.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/**
+ * Constructor
+ */
+template< class TOutputImage, class TTransformPrecisionType >
+AdvancedTransformToDisplacementFieldSource< TOutputImage, TTransformPrecisionType >
+::AdvancedTransformToDisplacementFieldSource()
+{
+  this->m_OutputSpacing.Fill( 1.0 );
+  this->m_OutputOrigin.Fill( 0.0 );
+  this->m_OutputDirection.SetIdentity();
+
+  SizeType size;
+  size.Fill( 0 );
+  this->m_OutputRegion.SetSize( size );
+
+  IndexType index;
+  index.Fill( 0 );
+  this->m_OutputRegion.SetIndex( index );
+
+  this->m_Transform = AdvancedIdentityTransform< TTransformPrecisionType, ImageDimension >::New();
+
+#if ITK_VERSION_MAJOR >= 5
+  // Use the classic (ITK4) threading model, to ensure ThreadedGenerateData is being called.
+  this->itk::ImageSource<TOutputImage>::DynamicMultiThreadingOff();
+#endif
+
+} // end Constructor
+
+
+/**
+ * Print out a description of self
+ */
+template< class TOutputImage, class TTransformPrecisionType >
+void
+AdvancedTransformToDisplacementFieldSource< TOutputImage, TTransformPrecisionType >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "OutputRegion: " << this->m_OutputRegion << std::endl;
+  os << indent << "OutputSpacing: " << this->m_OutputSpacing << std::endl;
+  os << indent << "OutputOrigin: " << this->m_OutputOrigin << std::endl;
+  os << indent << "OutputDirection: " << this->m_OutputDirection << std::endl;
+  os << indent << "Transform: " << this->m_Transform.GetPointer() << std::endl;
+
+} // end PrintSelf()
+
+
+/**
+ * Set the output image size.
+ */
+template< class TOutputImage, class TTransformPrecisionType >
+void
+AdvancedTransformToDisplacementFieldSource< TOutputImage, TTransformPrecisionType >
+::SetOutputSize( const SizeType & size )
+{
+  this->m_OutputRegion.SetSize( size );
+  this->Modified();
+}
+
+
+/**
+ * Get the output image size.
+ */
+template< class TOutputImage, class TTransformPrecisionType >
+const typename AdvancedTransformToDisplacementFieldSource< TOutputImage, TTransformPrecisionType >
+::SizeType
+& AdvancedTransformToDisplacementFieldSource< TOutputImage, TTransformPrecisionType >
+::GetOutputSize()
+{
+  return this->m_OutputRegion.GetSize();
+}
+
+
+/**
+ * Set the output image index.
+ */
+template< class TOutputImage, class TTransformPrecisionType >
+void
+AdvancedTransformToDisplacementFieldSource< TOutputImage, TTransformPrecisionType >
+::SetOutputIndex( const IndexType & index )
+{
+  this->m_OutputRegion.SetIndex( index );
+  this->Modified();
+}
+
+
+/**
+ * Get the output image index.
+ */
+template< class TOutputImage, class TTransformPrecisionType >
+const typename AdvancedTransformToDisplacementFieldSource< TOutputImage, TTransformPrecisionType >
+::IndexType
+& AdvancedTransformToDisplacementFieldSource< TOutputImage, TTransformPrecisionType >
+::GetOutputIndex()
+{
+  return this->m_OutputRegion.GetIndex();
+}
+
+
+/** Helper method to set the output parameters based on this image */
+template< class TOutputImage, class TTransformPrecisionType >
+void
+AdvancedTransformToDisplacementFieldSource< TOutputImage, TTransformPrecisionType >
+::SetOutputParametersFromImage( const ImageBaseType * image )
+{
+  if( !image )
+  {
+    itkExceptionMacro( << "Cannot use a null image reference" );
+  }
+
+  this->SetOutputOrigin( image->GetOrigin() );
+  this->SetOutputSpacing( image->GetSpacing() );
+  this->SetOutputDirection( image->GetDirection() );
+  this->SetOutputRegion( image->GetLargestPossibleRegion() );
+
+} // end SetOutputParametersFromImage()
+
+
+/**
+ * Check the transform before multi-threading.
+ */
+template< class TOutputImage, class TTransformPrecisionType >
+void
+AdvancedTransformToDisplacementFieldSource< TOutputImage, TTransformPrecisionType >
+::BeforeThreadedGenerateData( void )
+{
+  if( !this->m_Transform )
+  {
+    itkExceptionMacro( << "Transform not set" );
+  }
+
+} // end BeforeThreadedGenerateData()
+
+
+/**
+ * ThreadedGenerateData
+ */
+template< class TOutputImage, class TTransformPrecisionType >
+void
+AdvancedTransformToDisplacementFieldSource< TOutputImage, TTransformPrecisionType >
+::ThreadedGenerateData(
+  const OutputImageRegionType & outputRegionForThread,
+  ThreadIdType threadId )
+{
+  // Get the output pointer
+  OutputImagePointer outputPtr = this->GetOutput();
+
+  // Walk the output region for this thread row by row.
+  typedef ImageLinearIteratorWithIndex< TOutputImage > OutputIteratorType;
+  OutputIteratorType it( outputPtr, outputRegionForThread );
+  it.SetDirection( 0 );
+  it.GoToBegin();
+
+  // Support for progress methods/callbacks
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  // The step in physical space from one pixel in a row to the next.
+  const SizeValueType rowLength = outputRegionForThread.GetSize( 0 );
+  double              step[ ImageDimension ];
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    step[ d ] = outputPtr->GetDirection()[ d ][ 0 ] * outputPtr->GetSpacing()[ 0 ];
+  }
+
+  std::vector< InputPointType >  points( rowLength );
+  std::vector< OutputPointType > mappedPoints( rowLength );
+  while( !it.IsAtEnd() )
+  {
+    // Determine the coordinates of the voxels of the row.
+    InputPointType firstPoint;
+    outputPtr->TransformIndexToPhysicalPoint( it.GetIndex(), firstPoint );
+    for( SizeValueType i = 0; i < rowLength; ++i )
+    {
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        points[ i ][ d ] = firstPoint[ d ] + static_cast< double >( i ) * step[ d ];
+      }
+    }
+
+    // Transform the whole row at once.
+    this->m_Transform->TransformPoints( &points[ 0 ], &mappedPoints[ 0 ], rowLength );
+
+    // Compute and set the displacements.
+    PixelType displacement;
+    for( SizeValueType i = 0; !it.IsAtEndOfLine(); ++i, ++it )
+    {
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        displacement[ d ] = static_cast< PixelValueType >( mappedPoints[ i ][ d ] - points[ i ][ d ] );
+      }
+      it.Set( displacement );
+      progress.CompletedPixel();
+    }
+
+    it.NextLine();
+  }
+
+} // end ThreadedGenerateData()
+
+
+/**
+ * Inform pipeline of required output region
+ */
+template< class TOutputImage, class TTransformPrecisionType >
+void
+AdvancedTransformToDisplacementFieldSource< TOutputImage, TTransformPrecisionType >
+::GenerateOutputInformation( void )
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateOutputInformation();
+
+  // get pointer to the output
+  OutputImagePointer outputPtr = this->GetOutput();
+  if( !outputPtr )
+  {
+    return;
+  }
+
+  outputPtr->SetLargestPossibleRegion( this->m_OutputRegion );
+  outputPtr->SetSpacing( this->m_OutputSpacing );
+  outputPtr->SetOrigin( this->m_OutputOrigin );
+  outputPtr->SetDirection( this->m_OutputDirection );
+
+} // end GenerateOutputInformation()
+
+
+/**
+ * Verify if any of the components has been modified.
+ */
+template< class TOutputImage, class TTransformPrecisionType >
+ModifiedTimeType
+AdvancedTransformToDisplacementFieldSource< TOutputImage, TTransformPrecisionType >
+::GetMTime( void ) const
+{
+  ModifiedTimeType latestTime = Object::GetMTime();
+
+  if( this->m_Transform )
+  {
+    if( latestTime < this->m_Transform->GetMTime() )
+    {
+      latestTime = this->m_Transform->GetMTime();
+    }
+  }
+
+  return latestTime;
+
+} // end GetMTime()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkAdvancedTransformToDisplacementFieldSource_hxx
@@ -93,6 +93,7 @@ public:
   typedef typename GridOffsetType::OffsetValueType OffsetValueType;
 
   typedef typename Superclass::NonZeroJacobianIndicesType    NonZeroJacobianIndicesType;
+  typedef typename Superclass::NonZeroJacobianIndicesValueType NonZeroJacobianIndicesValueType;
   typedef typename Superclass::SpatialJacobianType           SpatialJacobianType;
   typedef typename Superclass::JacobianOfSpatialJacobianType JacobianOfSpatialJacobianType;
   typedef typename Superclass::SpatialHessianType            SpatialHessianType;
@@ -148,6 +149,39 @@ public:
     DerivativeType & imageJacobian,
     NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const override;
 
+  /** Batch versions of TransformPoint(), GetJacobian() and
+   * EvaluateJacobianWithImageGradientProduct(). The recursive implementation
+   * writes the Jacobians and nonzero indices directly in the caller's buffers.
+   * By default the results are identical to those of the single point versions.
+   */
+  void TransformPoints(
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    const SizeValueType numberOfPoints ) const override;
+
+  void GetJacobians(
+    const InputPointType * inputPoints,
+    const SizeValueType numberOfPoints,
+    ParametersValueType * jacobians,
+    NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const override;
+
+  void EvaluateJacobianWithImageGradientProducts(
+    const InputPointType * inputPoints,
+    const MovingImageGradientType * movingImageGradients,
+    const SizeValueType numberOfPoints,
+    ParametersValueType * imageJacobians,
+    NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const override;
+
+  /** Whether the batch functions use the vectorized RecursiveBSplineTransformSIMDKernels,
+   * for cubic B-splines in 3D with double precision. The kernels use a different
+   * summation order, and FMA instructions depending on the processor, so that
+   * the results differ slightly from the single point versions and from
+   * machine to machine. Default: false.
+   */
+  itkSetMacro( UseSIMDKernels, bool );
+  itkGetConstMacro( UseSIMDKernels, bool );
+  itkBooleanMacro( UseSIMDKernels );
+
   /** Compute the spatial Jacobian of the transformation. */
   void GetSpatialJacobian(
     const InputPointType & ipp,
@@ -198,6 +232,8 @@ protected:
 
   typename RecursiveBSplineWeightFunctionType::Pointer m_RecursiveBSplineWeightFunction;
 
+  bool m_UseSIMDKernels;
+
   /** Compute the nonzero Jacobian indices. */
   void ComputeNonZeroJacobianIndices(
     NonZeroJacobianIndicesType & nonZeroJacobianIndices,
@@ -22,6 +22,8 @@
 
 #include "itkRecursiveBSplineTransformImplementation.h"
 
+#include <algorithm>
+
 
 namespace itk
 {
@@ -38,6 +40,7 @@ RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
   this->m_Kernel                         = KernelType::New();
   this->m_DerivativeKernel               = DerivativeKernelType::New();
   this->m_SecondOrderDerivativeKernel    = SecondOrderDerivativeKernelType::New();
+  this->m_UseSIMDKernels                 = false;
 } // end Constructor()
 
 
@@ -250,6 +253,278 @@ RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* TransformPoints ****************************
+ */
+
+template< typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
+::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  const SizeValueType numberOfPoints ) const
+{
+  /** Check if the coefficient image has been set. */
+  if( !this->m_CoefficientImages[ 0 ] )
+  {
+    itkWarningMacro( << "B-spline coefficients have not been set" );
+    std::copy( inputPoints, inputPoints + numberOfPoints, outputPoints );
+    return;
+  }
+
+  /** Initialize some helper variables, once for all points. */
+  typedef RecursiveBSplineTransformBlockImplementation<
+    SpaceDimension, SplineOrder, TScalar >                  BlockImplementationType;
+  const unsigned int blockSize       = BlockImplementationType::MaximumBlockSize;
+  const unsigned int numberOfWeights = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+
+  ContinuousIndexType             cindices[ blockSize ];
+  IndexType                       supportIndices[ blockSize ];
+  SizeValueType                   validPoints[ blockSize ];
+  OffsetValueType                 supportOffsets[ blockSize ];
+  typename WeightsType::ValueType weightsArray1D[ blockSize * numberOfWeights ];
+  ScalarType                      displacements[ blockSize * SpaceDimension ];
+
+  const OffsetValueType * bsplineOffsetTable = this->m_CoefficientImages[ 0 ]->GetOffsetTable();
+  ScalarType *            basePointers[ SpaceDimension ];
+  for( unsigned int j = 0; j < SpaceDimension; ++j )
+  {
+    basePointers[ j ] = this->m_CoefficientImages[ j ]->GetBufferPointer();
+  }
+
+  for( SizeValueType begin = 0; begin < numberOfPoints; begin += blockSize )
+  {
+    const SizeValueType end = std::min< SizeValueType >( begin + blockSize, numberOfPoints );
+
+    /** Collect the points of this block of which the support region lies
+     * within the grid. For the other points we assume zero displacement and
+     * return the input point.
+     */
+    unsigned int numberOfValidPoints = 0;
+    for( SizeValueType p = begin; p < end; ++p )
+    {
+      this->TransformPointToContinuousGridIndex( inputPoints[ p ], cindices[ numberOfValidPoints ] );
+      if( this->InsideValidRegion( cindices[ numberOfValidPoints ] ) )
+      {
+        validPoints[ numberOfValidPoints++ ] = p;
+      }
+      else
+      {
+        outputPoints[ p ] = inputPoints[ p ];
+      }
+    }
+
+    /** Compute the interpolation weights and the offsets to the support regions. */
+    this->m_RecursiveBSplineWeightFunction->Evaluate(
+      cindices, numberOfValidPoints, weightsArray1D, supportIndices );
+    for( unsigned int i = 0; i < numberOfValidPoints; ++i )
+    {
+      supportOffsets[ i ] = 0;
+      for( unsigned int j = 0; j < SpaceDimension; ++j )
+      {
+        supportOffsets[ i ] += supportIndices[ i ][ j ] * bsplineOffsetTable[ j ];
+      }
+    }
+
+    /** Compute the displacements of the block. */
+    BlockImplementationType::TransformPoints( numberOfValidPoints,
+      basePointers, bsplineOffsetTable, supportOffsets, weightsArray1D, displacements,
+      this->m_UseSIMDKernels );
+
+    /** The output point is the start point + displacement. This is safe for
+     * inputPoints == outputPoints, since every coordinate is read before it is written.
+     */
+    for( unsigned int i = 0; i < numberOfValidPoints; ++i )
+    {
+      const SizeValueType p = validPoints[ i ];
+      for( unsigned int j = 0; j < SpaceDimension; ++j )
+      {
+        outputPoints[ p ][ j ] = displacements[ i * SpaceDimension + j ] + inputPoints[ p ][ j ];
+      }
+    }
+  }
+
+} // end TransformPoints()
+
+
+/**
+ * ********************* GetJacobians ****************************
+ */
+
+template< class TScalar, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
+::GetJacobians(
+  const InputPointType * inputPoints,
+  const SizeValueType numberOfPoints,
+  ParametersValueType * jacobians,
+  NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const
+{
+  /** Initialize some helper variables, once for all points. */
+  typedef RecursiveBSplineTransformBlockImplementation<
+    SpaceDimension, SplineOrder, TScalar >                  BlockImplementationType;
+  const unsigned int blockSize       = BlockImplementationType::MaximumBlockSize;
+  const unsigned int numberOfWeights = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+
+  ContinuousIndexType             cindices[ blockSize ];
+  IndexType                       supportIndices[ blockSize ];
+  SizeValueType                   validPoints[ blockSize ];
+  ParametersValueType *           jacobianPointers[ blockSize ];
+  typename WeightsType::ValueType weightsArray1D[ blockSize * numberOfWeights ];
+
+  const NumberOfParametersType nnzji            = this->GetNumberOfNonZeroJacobianIndices();
+  const SizeValueType          jacobianSize     = SpaceDimension * nnzji;
+  const unsigned long          parametersPerDim = this->GetNumberOfParametersPerDimension();
+  const OffsetValueType *      gridOffsetTable  = this->m_CoefficientImages[ 0 ]->GetOffsetTable();
+
+  /** The implementation only writes the diagonal blocks. */
+  std::fill( jacobians, jacobians + numberOfPoints * jacobianSize, 0.0 );
+
+  for( SizeValueType begin = 0; begin < numberOfPoints; begin += blockSize )
+  {
+    const SizeValueType end = std::min< SizeValueType >( begin + blockSize, numberOfPoints );
+
+    /** Collect the points of this block of which the support region lies
+     * within the grid. For the other points we assume zero displacement and
+     * zero Jacobian.
+     */
+    unsigned int numberOfValidPoints = 0;
+    for( SizeValueType p = begin; p < end; ++p )
+    {
+      this->TransformPointToContinuousGridIndex( inputPoints[ p ], cindices[ numberOfValidPoints ] );
+      if( this->InsideValidRegion( cindices[ numberOfValidPoints ] ) )
+      {
+        jacobianPointers[ numberOfValidPoints ] = jacobians + p * jacobianSize;
+        validPoints[ numberOfValidPoints++ ]    = p;
+      }
+      else
+      {
+        NonZeroJacobianIndicesValueType * nzjiPointer = nonZeroJacobianIndices + p * nnzji;
+        for( NumberOfParametersType i = 0; i < nnzji; ++i )
+        {
+          nzjiPointer[ i ] = i;
+        }
+      }
+    }
+
+    /** Compute the interpolation weights and the Jacobians of the block,
+     * directly in the output blocks.
+     */
+    this->m_RecursiveBSplineWeightFunction->Evaluate(
+      cindices, numberOfValidPoints, weightsArray1D, supportIndices );
+    BlockImplementationType::GetJacobians( numberOfValidPoints, weightsArray1D, jacobianPointers,
+      this->m_UseSIMDKernels );
+
+    /** Recursively compute the nonzero Jacobian indices, directly in the output blocks. */
+    for( unsigned int i = 0; i < numberOfValidPoints; ++i )
+    {
+      NonZeroJacobianIndicesValueType * nzjiPointer = nonZeroJacobianIndices + validPoints[ i ] * nnzji;
+      OffsetValueType totalOffsetToSupportIndex = 0;
+      for( unsigned int j = 0; j < SpaceDimension; ++j )
+      {
+        totalOffsetToSupportIndex += supportIndices[ i ][ j ] * gridOffsetTable[ j ];
+      }
+      RecursiveBSplineTransformImplementation< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
+        ::ComputeNonZeroJacobianIndices( nzjiPointer,
+        parametersPerDim, totalOffsetToSupportIndex, gridOffsetTable );
+    }
+  }
+
+} // end GetJacobians()
+
+
+/**
+ * ********************* EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template< class TScalar, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
+::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType * inputPoints,
+  const MovingImageGradientType * movingImageGradients,
+  const SizeValueType numberOfPoints,
+  ParametersValueType * imageJacobians,
+  NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const
+{
+  /** Initialize some helper variables, once for all points. */
+  typedef RecursiveBSplineTransformBlockImplementation<
+    SpaceDimension, SplineOrder, TScalar >                  BlockImplementationType;
+  const unsigned int blockSize       = BlockImplementationType::MaximumBlockSize;
+  const unsigned int numberOfWeights = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+
+  ContinuousIndexType             cindices[ blockSize ];
+  IndexType                       supportIndices[ blockSize ];
+  SizeValueType                   validPoints[ blockSize ];
+  ParametersValueType *           imageJacobianPointers[ blockSize ];
+  double                          migArray[ blockSize * SpaceDimension ]; //InternalFloatType
+  typename WeightsType::ValueType weightsArray1D[ blockSize * numberOfWeights ];
+
+  const NumberOfParametersType nnzji            = this->GetNumberOfNonZeroJacobianIndices();
+  const unsigned long          parametersPerDim = this->GetNumberOfParametersPerDimension();
+  const OffsetValueType *      gridOffsetTable  = this->m_CoefficientImages[ 0 ]->GetOffsetTable();
+
+  for( SizeValueType begin = 0; begin < numberOfPoints; begin += blockSize )
+  {
+    const SizeValueType end = std::min< SizeValueType >( begin + blockSize, numberOfPoints );
+
+    /** Collect the points of this block of which the support region lies
+     * within the grid. For the other points we assume zero displacement and
+     * zero Jacobian.
+     */
+    unsigned int numberOfValidPoints = 0;
+    for( SizeValueType p = begin; p < end; ++p )
+    {
+      this->TransformPointToContinuousGridIndex( inputPoints[ p ], cindices[ numberOfValidPoints ] );
+      if( this->InsideValidRegion( cindices[ numberOfValidPoints ] ) )
+      {
+        for( unsigned int j = 0; j < SpaceDimension; ++j )
+        {
+          migArray[ numberOfValidPoints * SpaceDimension + j ] = movingImageGradients[ p ][ j ];
+        }
+        imageJacobianPointers[ numberOfValidPoints ] = imageJacobians + p * nnzji;
+        validPoints[ numberOfValidPoints++ ]         = p;
+      }
+      else
+      {
+        ParametersValueType *             imageJacobianPointer = imageJacobians + p * nnzji;
+        NonZeroJacobianIndicesValueType * nzjiPointer          = nonZeroJacobianIndices + p * nnzji;
+        for( NumberOfParametersType i = 0; i < nnzji; ++i )
+        {
+          nzjiPointer[ i ]          = i;
+          imageJacobianPointer[ i ] = 0.0;
+        }
+      }
+    }
+
+    /** Compute the interpolation weights and the inner products of the
+     * Jacobians and the moving image gradients, directly in the output blocks.
+     */
+    this->m_RecursiveBSplineWeightFunction->Evaluate(
+      cindices, numberOfValidPoints, weightsArray1D, supportIndices );
+    BlockImplementationType::EvaluateJacobianWithImageGradientProducts(
+      numberOfValidPoints, weightsArray1D, migArray, imageJacobianPointers,
+      this->m_UseSIMDKernels );
+
+    /** Recursively compute the nonzero Jacobian indices, directly in the output blocks. */
+    for( unsigned int i = 0; i < numberOfValidPoints; ++i )
+    {
+      NonZeroJacobianIndicesValueType * nzjiPointer = nonZeroJacobianIndices + validPoints[ i ] * nnzji;
+      OffsetValueType totalOffsetToSupportIndex = 0;
+      for( unsigned int j = 0; j < SpaceDimension; ++j )
+      {
+        totalOffsetToSupportIndex += supportIndices[ i ][ j ] * gridOffsetTable[ j ];
+      }
+      RecursiveBSplineTransformImplementation< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
+        ::ComputeNonZeroJacobianIndices( nzjiPointer,
+        parametersPerDim, totalOffsetToSupportIndex, gridOffsetTable );
+    }
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
 /**
  * ********************* GetSpatialJacobian ****************************
  */
@@ -19,6 +19,7 @@
 #define __itkRecursiveBSplineTransformImplementation_h
 
 #include "itkRecursiveBSplineInterpolationWeightFunction.h"
+#include "itkRecursiveBSplineTransformSIMDKernels.h"
 
 namespace itk
 {
@@ -607,6 +608,200 @@ public:
 };
 
 
+/** \class RecursiveBSplineTransformGenericBlockImplementation
+ *
+ * \brief Evaluates the recursive B-spline transform for a block of points.
+ *
+ * Per point the 1D weights, as returned by the batched Evaluate() of the
+ * RecursiveBSplineInterpolationWeightFunction, are stored consecutively.
+ * This version calls the RecursiveBSplineTransformImplementation per point,
+ * so the results are identical to those of the single point functions.
+ *
+ * \ingroup ITKTransform
+ */
+
+template< unsigned int SpaceDimension, unsigned int SplineOrder, class TScalar >
+class RecursiveBSplineTransformGenericBlockImplementation
+{
+public:
+
+  typedef TScalar ScalarType;
+  typedef RecursiveBSplineTransformImplementation<
+    SpaceDimension, SpaceDimension, SplineOrder, TScalar > ImplementationType;
+
+  /** The number of 1D weights per point. */
+  itkStaticConstMacro( NumberOfWeights, unsigned int, SpaceDimension * ( SplineOrder + 1 ) );
+
+  /** The maximum number of points that is processed per call. */
+  itkStaticConstMacro( MaximumBlockSize, unsigned int, 8 );
+
+  /** Compute the displacements of a block of points. */
+  static inline void TransformPoints(
+    const unsigned int numberOfPoints,
+    ScalarType * const * coefficients,
+    const OffsetValueType * gridOffsetTable,
+    const OffsetValueType * supportOffsets,
+    const double * weights1D,
+    ScalarType * displacements,
+    const bool itkNotUsed( useSIMDKernels ) = false )
+  {
+    for( unsigned int p = 0; p < numberOfPoints; ++p )
+    {
+      ScalarType * mu[ SpaceDimension ];
+      for( unsigned int j = 0; j < SpaceDimension; ++j )
+      {
+        mu[ j ] = coefficients[ j ] + supportOffsets[ p ];
+      }
+      ImplementationType::TransformPoint( displacements + p * SpaceDimension,
+        mu, gridOffsetTable, weights1D + p * NumberOfWeights );
+    }
+  } // end TransformPoints()
+
+
+  /** Compute the Jacobians of a block of points. Only the diagonal blocks are written. */
+  static inline void GetJacobians(
+    const unsigned int numberOfPoints,
+    const double * weights1D,
+    ScalarType * const * jacobians,
+    const bool itkNotUsed( useSIMDKernels ) = false )
+  {
+    for( unsigned int p = 0; p < numberOfPoints; ++p )
+    {
+      /** The recursive implementation moves the pointer. */
+      ScalarType * jacobianPointer = jacobians[ p ];
+      ImplementationType::GetJacobian( jacobianPointer, weights1D + p * NumberOfWeights, 1.0 );
+    }
+  } // end GetJacobians()
+
+
+  /** Compute the inner products of the Jacobians with the moving image gradients of a block of points. */
+  static inline void EvaluateJacobianWithImageGradientProducts(
+    const unsigned int numberOfPoints,
+    const double * weights1D,
+    const double * movingImageGradients,
+    ScalarType * const * imageJacobians,
+    const bool itkNotUsed( useSIMDKernels ) = false )
+  {
+    for( unsigned int p = 0; p < numberOfPoints; ++p )
+    {
+      /** The recursive implementation moves the pointer. */
+      ScalarType * imageJacobianPointer = imageJacobians[ p ];
+      ImplementationType::EvaluateJacobianWithImageGradientProduct( imageJacobianPointer,
+        movingImageGradients + p * SpaceDimension, weights1D + p * NumberOfWeights, 1.0 );
+    }
+  } // end EvaluateJacobianWithImageGradientProducts()
+
+
+};
+
+
+/** \class RecursiveBSplineTransformBlockImplementation
+ *
+ * \brief Evaluates the recursive B-spline transform for a block of points.
+ *
+ * In general the RecursiveBSplineTransformGenericBlockImplementation is used.
+ * The cubic 3D double precision case is specialized below, to optionally use
+ * the vectorized RecursiveBSplineTransformSIMDKernels.
+ *
+ * \ingroup ITKTransform
+ */
+
+template< unsigned int SpaceDimension, unsigned int SplineOrder, class TScalar >
+class RecursiveBSplineTransformBlockImplementation :
+  public RecursiveBSplineTransformGenericBlockImplementation< SpaceDimension, SplineOrder, TScalar >
+{
+};
+
+
+/** \class RecursiveBSplineTransformBlockImplementation
+ *
+ * \brief Specialization for cubic B-splines in 3D with double precision,
+ * which uses the run-time selected SIMD kernels if useSIMDKernels is true.
+ * The kernels vectorize over the support region of a single point.
+ * Otherwise the generic implementation is used.
+ */
+
+template< >
+class RecursiveBSplineTransformBlockImplementation< 3, 3, double >
+{
+public:
+
+  typedef double                               ScalarType;
+  typedef RecursiveBSplineTransformSIMDKernels KernelsType;
+  typedef RecursiveBSplineTransformGenericBlockImplementation<
+    3, 3, double >                             GenericType;
+
+  /** The number of 1D weights per point. */
+  itkStaticConstMacro( NumberOfWeights, unsigned int, KernelsType::NumberOfWeights );
+
+  /** The maximum number of points that is processed per call. */
+  itkStaticConstMacro( MaximumBlockSize, unsigned int, KernelsType::MaximumBlockSize );
+
+  /** Compute the displacements of a block of points. */
+  static inline void TransformPoints(
+    const unsigned int numberOfPoints,
+    ScalarType * const * coefficients,
+    const OffsetValueType * gridOffsetTable,
+    const OffsetValueType * supportOffsets,
+    const double * weights1D,
+    ScalarType * displacements,
+    const bool useSIMDKernels = false )
+  {
+    if( useSIMDKernels )
+    {
+      KernelsType::TransformPoints( numberOfPoints, coefficients,
+        gridOffsetTable, supportOffsets, weights1D, displacements );
+    }
+    else
+    {
+      GenericType::TransformPoints( numberOfPoints, coefficients,
+        gridOffsetTable, supportOffsets, weights1D, displacements );
+    }
+  } // end TransformPoints()
+
+
+  /** Compute the Jacobians of a block of points. Only the diagonal blocks are written. */
+  static inline void GetJacobians(
+    const unsigned int numberOfPoints,
+    const double * weights1D,
+    ScalarType * const * jacobians,
+    const bool useSIMDKernels = false )
+  {
+    if( useSIMDKernels )
+    {
+      KernelsType::GetJacobians( numberOfPoints, weights1D, jacobians );
+    }
+    else
+    {
+      GenericType::GetJacobians( numberOfPoints, weights1D, jacobians );
+    }
+  } // end GetJacobians()
+
+
+  /** Compute the inner products of the Jacobians with the moving image gradients of a block of points. */
+  static inline void EvaluateJacobianWithImageGradientProducts(
+    const unsigned int numberOfPoints,
+    const double * weights1D,
+    const double * movingImageGradients,
+    ScalarType * const * imageJacobians,
+    const bool useSIMDKernels = false )
+  {
+    if( useSIMDKernels )
+    {
+      KernelsType::EvaluateJacobianWithImageGradientProducts( numberOfPoints,
+        weights1D, movingImageGradients, imageJacobians );
+    }
+    else
+    {
+      GenericType::EvaluateJacobianWithImageGradientProducts( numberOfPoints,
+        weights1D, movingImageGradients, imageJacobians );
+    }
+  } // end EvaluateJacobianWithImageGradientProducts()
+
+
+};
+
+
 } // end namespace itk
 
 #endif /* __itkRecursiveBSplineTransformImplementation_h */
@@ -0,0 +1,703 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRecursiveBSplineTransformSIMDKernels_cxx
+#define __itkRecursiveBSplineTransformSIMDKernels_cxx
+
+#include "itkRecursiveBSplineTransformSIMDKernels.h"
+
+#include <atomic>
+
+/** The vectorized kernels are only compiled for x86. With GCC and Clang each
+ * kernel is compiled for its own instruction set through a target attribute,
+ * so that the rest of elastix does not need to be compiled with e.g. -mavx2.
+ * MSVC allows all intrinsics without special flags.
+ */
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+#if defined( __GNUC__ ) || defined( __clang__ )
+#define ELX_SIMD_X86
+#define ELX_SIMD_AVX512
+#define ELX_SIMD_TARGET( isa ) __attribute__( ( target( isa ) ) )
+#include <immintrin.h>
+#elif defined( _MSC_VER )
+#define ELX_SIMD_X86
+#if _MSC_VER >= 1911
+#define ELX_SIMD_AVX512
+#endif
+#define ELX_SIMD_TARGET( isa )
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif
+
+namespace itk
+{
+
+namespace
+{
+
+typedef RecursiveBSplineTransformSIMDKernels KernelsType;
+
+/**
+ * ****************** DetectInstructionSet *********************************
+ */
+
+KernelsType::InstructionSetType
+DetectInstructionSet( void )
+{
+#if defined( ELX_SIMD_X86 ) && defined( _MSC_VER ) && !defined( __clang__ )
+  int info[ 4 ];
+  __cpuid( info, 0 );
+  const int maximumLeaf = info[ 0 ];
+
+  __cpuid( info, 1 );
+  const bool sse41   = ( info[ 2 ] & ( 1 << 19 ) ) != 0;
+  const bool fma     = ( info[ 2 ] & ( 1 << 12 ) ) != 0;
+  const bool osxsave = ( info[ 2 ] & ( 1 << 27 ) ) != 0;
+
+  /** Check that the operating system saves the ymm and zmm registers. */
+  const unsigned long long xcr0 = osxsave ? _xgetbv( 0 ) : 0;
+  const bool               ymm  = ( xcr0 & 0x06 ) == 0x06;
+  const bool               zmm  = ( xcr0 & 0xe6 ) == 0xe6;
+
+  bool avx2 = false, avx512f = false;
+  if( maximumLeaf >= 7 )
+  {
+    __cpuidex( info, 7, 0 );
+    avx2    = ( info[ 1 ] & ( 1 << 5 ) ) != 0;
+    avx512f = ( info[ 1 ] & ( 1 << 16 ) ) != 0;
+  }
+
+#if defined( ELX_SIMD_AVX512 )
+  if( avx512f && zmm ) { return KernelsType::AVX512; }
+#endif
+  if( avx2 && fma && ymm ) { return KernelsType::AVX2; }
+  if( sse41 ) { return KernelsType::SSE41; }
+#elif defined( ELX_SIMD_X86 )
+  __builtin_cpu_init();
+#if defined( ELX_SIMD_AVX512 )
+  if( __builtin_cpu_supports( "avx512f" ) ) { return KernelsType::AVX512; }
+#endif
+  if( __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" ) ) { return KernelsType::AVX2; }
+  if( __builtin_cpu_supports( "sse4.1" ) ) { return KernelsType::SSE41; }
+#endif
+  return KernelsType::Scalar;
+
+} // end DetectInstructionSet()
+
+
+/** The instruction set that is currently used. */
+std::atomic< int > &
+CurrentInstructionSet( void )
+{
+  static std::atomic< int > current( KernelsType::GetMaximumInstructionSet() );
+  return current;
+}
+
+
+/**
+ * ******************* Scalar kernels *******************
+ *
+ * Portable versions. The summation order differs from that of the
+ * RecursiveBSplineTransformImplementation, and the vectorized versions use a
+ * different order again, as well as FMA instructions. So the results of the
+ * instruction sets differ in the last bits.
+ */
+
+void
+TransformPointsScalar(
+  const unsigned int numberOfPoints,
+  const double * const * coefficients,
+  const OffsetValueType * gridOffsetTable,
+  const OffsetValueType * supportOffsets,
+  const double * weights1D,
+  double * displacements )
+{
+  for( unsigned int p = 0; p < numberOfPoints; ++p )
+  {
+    const double * wx = weights1D + p * 12;
+    const double * wy = wx + 4;
+    const double * wz = wx + 8;
+
+    double acc[ 3 ][ 4 ] = { { 0.0 } };
+    for( unsigned int z = 0; z < 4; ++z )
+    {
+      for( unsigned int y = 0; y < 4; ++y )
+      {
+        const double          s      = wz[ z ] * wy[ y ];
+        const OffsetValueType offset = supportOffsets[ p ]
+          + y * gridOffsetTable[ 1 ] + z * gridOffsetTable[ 2 ];
+        for( unsigned int j = 0; j < 3; ++j )
+        {
+          for( unsigned int x = 0; x < 4; ++x )
+          {
+            acc[ j ][ x ] += s * coefficients[ j ][ offset + x ];
+          }
+        }
+      }
+    }
+
+    for( unsigned int j = 0; j < 3; ++j )
+    {
+      displacements[ p * 3 + j ] = acc[ j ][ 0 ] * wx[ 0 ] + acc[ j ][ 1 ] * wx[ 1 ]
+        + acc[ j ][ 2 ] * wx[ 2 ] + acc[ j ][ 3 ] * wx[ 3 ];
+    }
+  }
+
+} // end TransformPointsScalar()
+
+
+/** Write per point the 64 tensor product weights times a factor per output
+ * dimension, at stride apart. Used for both the Jacobian and the image Jacobian.
+ */
+void
+ScaledWeightsScalar(
+  const unsigned int numberOfPoints,
+  const double * weights1D,
+  const double * factors,
+  const unsigned int factorStride,
+  const unsigned int stride,
+  double * const * outputs )
+{
+  for( unsigned int p = 0; p < numberOfPoints; ++p )
+  {
+    const double * wx = weights1D + p * 12;
+    const double * wy = wx + 4;
+    const double * wz = wx + 8;
+    const double * f  = factors + p * factorStride;
+    double *       out = outputs[ p ];
+
+    for( unsigned int z = 0; z < 4; ++z )
+    {
+      for( unsigned int y = 0; y < 4; ++y )
+      {
+        const double s = wz[ z ] * wy[ y ];
+        for( unsigned int x = 0; x < 4; ++x )
+        {
+          const double w = s * wx[ x ];
+          for( unsigned int j = 0; j < 3; ++j )
+          {
+            out[ j * stride + z * 16 + y * 4 + x ] = w * f[ j ];
+          }
+        }
+      }
+    }
+  }
+
+} // end ScaledWeightsScalar()
+
+
+#if defined( ELX_SIMD_X86 )
+
+/**
+ * ******************* SSE4.1 kernels *******************
+ */
+
+ELX_SIMD_TARGET( "sse4.1" )
+void
+TransformPointsSSE41(
+  const unsigned int numberOfPoints,
+  const double * const * coefficients,
+  const OffsetValueType * gridOffsetTable,
+  const OffsetValueType * supportOffsets,
+  const double * weights1D,
+  double * displacements )
+{
+  for( unsigned int p = 0; p < numberOfPoints; ++p )
+  {
+    const double * wx = weights1D + p * 12;
+    const double * wy = wx + 4;
+    const double * wz = wx + 8;
+
+    __m128d acc[ 3 ][ 2 ];
+    for( unsigned int j = 0; j < 3; ++j )
+    {
+      acc[ j ][ 0 ] = _mm_setzero_pd();
+      acc[ j ][ 1 ] = _mm_setzero_pd();
+    }
+
+    for( unsigned int z = 0; z < 4; ++z )
+    {
+      for( unsigned int y = 0; y < 4; ++y )
+      {
+        const __m128d         s      = _mm_set1_pd( wz[ z ] * wy[ y ] );
+        const OffsetValueType offset = supportOffsets[ p ]
+          + y * gridOffsetTable[ 1 ] + z * gridOffsetTable[ 2 ];
+        for( unsigned int j = 0; j < 3; ++j )
+        {
+          const double * c = coefficients[ j ] + offset;
+          acc[ j ][ 0 ] = _mm_add_pd( acc[ j ][ 0 ], _mm_mul_pd( s, _mm_loadu_pd( c ) ) );
+          acc[ j ][ 1 ] = _mm_add_pd( acc[ j ][ 1 ], _mm_mul_pd( s, _mm_loadu_pd( c + 2 ) ) );
+        }
+      }
+    }
+
+    /** Dot products with the x weights. */
+    const __m128d wx0 = _mm_loadu_pd( wx );
+    const __m128d wx1 = _mm_loadu_pd( wx + 2 );
+    for( unsigned int j = 0; j < 3; ++j )
+    {
+      const __m128d d = _mm_add_pd( _mm_dp_pd( acc[ j ][ 0 ], wx0, 0x31 ), _mm_dp_pd( acc[ j ][ 1 ], wx1, 0x31 ) );
+      displacements[ p * 3 + j ] = _mm_cvtsd_f64( d );
+    }
+  }
+
+} // end TransformPointsSSE41()
+
+
+ELX_SIMD_TARGET( "sse4.1" )
+void
+ScaledWeightsSSE41(
+  const unsigned int numberOfPoints,
+  const double * weights1D,
+  const double * factors,
+  const unsigned int factorStride,
+  const unsigned int stride,
+  double * const * outputs )
+{
+  for( unsigned int p = 0; p < numberOfPoints; ++p )
+  {
+    const double * wy  = weights1D + p * 12 + 4;
+    const double * wz  = wy + 4;
+    const double * f   = factors + p * factorStride;
+    double *       out = outputs[ p ];
+
+    const __m128d wx0 = _mm_loadu_pd( weights1D + p * 12 );
+    const __m128d wx1 = _mm_loadu_pd( weights1D + p * 12 + 2 );
+    const __m128d f0  = _mm_set1_pd( f[ 0 ] );
+    const __m128d f1  = _mm_set1_pd( f[ 1 ] );
+    const __m128d f2  = _mm_set1_pd( f[ 2 ] );
+
+    for( unsigned int z = 0; z < 4; ++z )
+    {
+      for( unsigned int y = 0; y < 4; ++y )
+      {
+        const __m128d s  = _mm_set1_pd( wz[ z ] * wy[ y ] );
+        const __m128d w0 = _mm_mul_pd( s, wx0 );
+        const __m128d w1 = _mm_mul_pd( s, wx1 );
+        double *      o  = out + z * 16 + y * 4;
+        _mm_storeu_pd( o, _mm_mul_pd( w0, f0 ) );
+        _mm_storeu_pd( o + 2, _mm_mul_pd( w1, f0 ) );
+        _mm_storeu_pd( o + stride, _mm_mul_pd( w0, f1 ) );
+        _mm_storeu_pd( o + stride + 2, _mm_mul_pd( w1, f1 ) );
+        _mm_storeu_pd( o + 2 * stride, _mm_mul_pd( w0, f2 ) );
+        _mm_storeu_pd( o + 2 * stride + 2, _mm_mul_pd( w1, f2 ) );
+      }
+    }
+  }
+
+} // end ScaledWeightsSSE41()
+
+
+/**
+ * ******************* AVX2 kernels *******************
+ */
+
+ELX_SIMD_TARGET( "avx2,fma" )
+inline double
+DotProductAVX2( const __m256d a, const __m256d b )
+{
+  const __m256d ab = _mm256_mul_pd( a, b );
+  __m128d       lo = _mm256_castpd256_pd128( ab );
+  const __m128d hi = _mm256_extractf128_pd( ab, 1 );
+  lo = _mm_add_pd( lo, hi );
+  return _mm_cvtsd_f64( _mm_add_sd( lo, _mm_unpackhi_pd( lo, lo ) ) );
+}
+
+
+ELX_SIMD_TARGET( "avx2,fma" )
+void
+TransformPointsAVX2(
+  const unsigned int numberOfPoints,
+  const double * const * coefficients,
+  const OffsetValueType * gridOffsetTable,
+  const OffsetValueType * supportOffsets,
+  const double * weights1D,
+  double * displacements )
+{
+  for( unsigned int p = 0; p < numberOfPoints; ++p )
+  {
+    const double * wx = weights1D + p * 12;
+    const double * wy = wx + 4;
+    const double * wz = wx + 8;
+
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    for( unsigned int z = 0; z < 4; ++z )
+    {
+      for( unsigned int y = 0; y < 4; ++y )
+      {
+        const __m256d         s      = _mm256_set1_pd( wz[ z ] * wy[ y ] );
+        const OffsetValueType offset = supportOffsets[ p ]
+          + y * gridOffsetTable[ 1 ] + z * gridOffsetTable[ 2 ];
+        acc0 = _mm256_fmadd_pd( s, _mm256_loadu_pd( coefficients[ 0 ] + offset ), acc0 );
+        acc1 = _mm256_fmadd_pd( s, _mm256_loadu_pd( coefficients[ 1 ] + offset ), acc1 );
+        acc2 = _mm256_fmadd_pd( s, _mm256_loadu_pd( coefficients[ 2 ] + offset ), acc2 );
+      }
+    }
+
+    /** Dot products with the x weights. */
+    const __m256d wxv = _mm256_loadu_pd( wx );
+    displacements[ p * 3 ]     = DotProductAVX2( acc0, wxv );
+    displacements[ p * 3 + 1 ] = DotProductAVX2( acc1, wxv );
+    displacements[ p * 3 + 2 ] = DotProductAVX2( acc2, wxv );
+  }
+
+} // end TransformPointsAVX2()
+
+
+ELX_SIMD_TARGET( "avx2,fma" )
+void
+ScaledWeightsAVX2(
+  const unsigned int numberOfPoints,
+  const double * weights1D,
+  const double * factors,
+  const unsigned int factorStride,
+  const unsigned int stride,
+  double * const * outputs )
+{
+  for( unsigned int p = 0; p < numberOfPoints; ++p )
+  {
+    const double * wy  = weights1D + p * 12 + 4;
+    const double * wz  = wy + 4;
+    const double * f   = factors + p * factorStride;
+    double *       out = outputs[ p ];
+
+    const __m256d wxv = _mm256_loadu_pd( weights1D + p * 12 );
+    const __m256d f0  = _mm256_set1_pd( f[ 0 ] );
+    const __m256d f1  = _mm256_set1_pd( f[ 1 ] );
+    const __m256d f2  = _mm256_set1_pd( f[ 2 ] );
+
+    for( unsigned int z = 0; z < 4; ++z )
+    {
+      for( unsigned int y = 0; y < 4; ++y )
+      {
+        const __m256d w = _mm256_mul_pd( _mm256_set1_pd( wz[ z ] * wy[ y ] ), wxv );
+        double *      o = out + z * 16 + y * 4;
+        _mm256_storeu_pd( o, _mm256_mul_pd( w, f0 ) );
+        _mm256_storeu_pd( o + stride, _mm256_mul_pd( w, f1 ) );
+        _mm256_storeu_pd( o + 2 * stride, _mm256_mul_pd( w, f2 ) );
+      }
+    }
+  }
+
+} // end ScaledWeightsAVX2()
+
+
+#if defined( ELX_SIMD_AVX512 )
+
+/**
+ * ******************* AVX-512 kernels *******************
+ *
+ * Two consecutive rows in the y dimension are combined in one register.
+ */
+
+/** The GCC AVX-512 headers trigger false maybe-uninitialized warnings. */
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+ELX_SIMD_TARGET( "avx512f" )
+inline __m512d
+CombineAVX512( const __m256d lo, const __m256d hi )
+{
+  return _mm512_insertf64x4( _mm512_castpd256_pd512( lo ), hi, 1 );
+}
+
+
+ELX_SIMD_TARGET( "avx512f" )
+inline double
+DotProductAVX512( const __m512d a, const __m256d b )
+{
+  const __m256d sum = _mm256_add_pd( _mm512_castpd512_pd256( a ), _mm512_extractf64x4_pd( a, 1 ) );
+  const __m256d ab  = _mm256_mul_pd( sum, b );
+  __m128d       lo  = _mm256_castpd256_pd128( ab );
+  const __m128d hi  = _mm256_extractf128_pd( ab, 1 );
+  lo = _mm_add_pd( lo, hi );
+  return _mm_cvtsd_f64( _mm_add_sd( lo, _mm_unpackhi_pd( lo, lo ) ) );
+}
+
+
+ELX_SIMD_TARGET( "avx512f" )
+void
+TransformPointsAVX512(
+  const unsigned int numberOfPoints,
+  const double * const * coefficients,
+  const OffsetValueType * gridOffsetTable,
+  const OffsetValueType * supportOffsets,
+  const double * weights1D,
+  double * displacements )
+{
+  for( unsigned int p = 0; p < numberOfPoints; ++p )
+  {
+    const double * wx = weights1D + p * 12;
+    const double * wy = wx + 4;
+    const double * wz = wx + 8;
+
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    __m512d acc2 = _mm512_setzero_pd();
+    for( unsigned int z = 0; z < 4; ++z )
+    {
+      for( unsigned int y = 0; y < 4; y += 2 )
+      {
+        const __m512d s = CombineAVX512(
+          _mm256_set1_pd( wz[ z ] * wy[ y ] ), _mm256_set1_pd( wz[ z ] * wy[ y + 1 ] ) );
+        const OffsetValueType offset0 = supportOffsets[ p ]
+          + y * gridOffsetTable[ 1 ] + z * gridOffsetTable[ 2 ];
+        const OffsetValueType offset1 = offset0 + gridOffsetTable[ 1 ];
+        acc0 = _mm512_fmadd_pd( s, CombineAVX512(
+          _mm256_loadu_pd( coefficients[ 0 ] + offset0 ), _mm256_loadu_pd( coefficients[ 0 ] + offset1 ) ), acc0 );
+        acc1 = _mm512_fmadd_pd( s, CombineAVX512(
+          _mm256_loadu_pd( coefficients[ 1 ] + offset0 ), _mm256_loadu_pd( coefficients[ 1 ] + offset1 ) ), acc1 );
+        acc2 = _mm512_fmadd_pd( s, CombineAVX512(
+          _mm256_loadu_pd( coefficients[ 2 ] + offset0 ), _mm256_loadu_pd( coefficients[ 2 ] + offset1 ) ), acc2 );
+      }
+    }
+
+    /** Dot products with the x weights. */
+    const __m256d wxv = _mm256_loadu_pd( wx );
+    displacements[ p * 3 ]     = DotProductAVX512( acc0, wxv );
+    displacements[ p * 3 + 1 ] = DotProductAVX512( acc1, wxv );
+    displacements[ p * 3 + 2 ] = DotProductAVX512( acc2, wxv );
+  }
+
+} // end TransformPointsAVX512()
+
+
+ELX_SIMD_TARGET( "avx512f" )
+void
+ScaledWeightsAVX512(
+  const unsigned int numberOfPoints,
+  const double * weights1D,
+  const double * factors,
+  const unsigned int factorStride,
+  const unsigned int stride,
+  double * const * outputs )
+{
+  for( unsigned int p = 0; p < numberOfPoints; ++p )
+  {
+    const double * wy  = weights1D + p * 12 + 4;
+    const double * wz  = wy + 4;
+    const double * f   = factors + p * factorStride;
+    double *       out = outputs[ p ];
+
+    const __m256d wx4 = _mm256_loadu_pd( weights1D + p * 12 );
+    const __m512d wxv = CombineAVX512( wx4, wx4 );
+    const __m512d f0  = _mm512_set1_pd( f[ 0 ] );
+    const __m512d f1  = _mm512_set1_pd( f[ 1 ] );
+    const __m512d f2  = _mm512_set1_pd( f[ 2 ] );
+
+    for( unsigned int z = 0; z < 4; ++z )
+    {
+      for( unsigned int y = 0; y < 4; y += 2 )
+      {
+        const __m512d s = CombineAVX512(
+          _mm256_set1_pd( wz[ z ] * wy[ y ] ), _mm256_set1_pd( wz[ z ] * wy[ y + 1 ] ) );
+        const __m512d w = _mm512_mul_pd( s, wxv );
+        double *      o = out + z * 16 + y * 4;
+        _mm512_storeu_pd( o, _mm512_mul_pd( w, f0 ) );
+        _mm512_storeu_pd( o + stride, _mm512_mul_pd( w, f1 ) );
+        _mm512_storeu_pd( o + 2 * stride, _mm512_mul_pd( w, f2 ) );
+      }
+    }
+  }
+
+} // end ScaledWeightsAVX512()
+
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#pragma GCC diagnostic pop
+#endif
+
+#endif // ELX_SIMD_AVX512
+
+#endif // ELX_SIMD_X86
+
+
+/** Select the kernel for the current instruction set. */
+void
+ScaledWeights(
+  const unsigned int numberOfPoints,
+  const double * weights1D,
+  const double * factors,
+  const unsigned int factorStride,
+  const unsigned int stride,
+  double * const * outputs )
+{
+  switch( CurrentInstructionSet().load( std::memory_order_relaxed ) )
+  {
+#if defined( ELX_SIMD_X86 )
+#if defined( ELX_SIMD_AVX512 )
+    case KernelsType::AVX512:
+      ScaledWeightsAVX512( numberOfPoints, weights1D, factors, factorStride, stride, outputs );
+      break;
+#endif
+    case KernelsType::AVX2:
+      ScaledWeightsAVX2( numberOfPoints, weights1D, factors, factorStride, stride, outputs );
+      break;
+    case KernelsType::SSE41:
+      ScaledWeightsSSE41( numberOfPoints, weights1D, factors, factorStride, stride, outputs );
+      break;
+#endif
+    default:
+      ScaledWeightsScalar( numberOfPoints, weights1D, factors, factorStride, stride, outputs );
+  }
+
+} // end ScaledWeights()
+
+
+} // end namespace
+
+
+/**
+ * ******************* GetMaximumInstructionSet *******************
+ */
+
+RecursiveBSplineTransformSIMDKernels::InstructionSetType
+RecursiveBSplineTransformSIMDKernels
+::GetMaximumInstructionSet( void )
+{
+  static const InstructionSetType maximum = DetectInstructionSet();
+  return maximum;
+
+} // end GetMaximumInstructionSet()
+
+
+/**
+ * ******************* GetInstructionSet *******************
+ */
+
+RecursiveBSplineTransformSIMDKernels::InstructionSetType
+RecursiveBSplineTransformSIMDKernels
+::GetInstructionSet( void )
+{
+  return static_cast< InstructionSetType >( CurrentInstructionSet().load() );
+
+} // end GetInstructionSet()
+
+
+/**
+ * ******************* SetInstructionSet *******************
+ */
+
+void
+RecursiveBSplineTransformSIMDKernels
+::SetInstructionSet( const InstructionSetType instructionSet )
+{
+  const InstructionSetType maximum = GetMaximumInstructionSet();
+  CurrentInstructionSet().store( instructionSet < maximum ? instructionSet : maximum );
+
+} // end SetInstructionSet()
+
+
+/**
+ * ******************* GetInstructionSetName *******************
+ */
+
+const char *
+RecursiveBSplineTransformSIMDKernels
+::GetInstructionSetName( const InstructionSetType instructionSet )
+{
+  switch( instructionSet )
+  {
+    case SSE41:  return "SSE4.1";
+    case AVX2:   return "AVX2";
+    case AVX512: return "AVX-512";
+    default:     return "scalar";
+  }
+
+} // end GetInstructionSetName()
+
+
+/**
+ * ******************* TransformPoints *******************
+ */
+
+void
+RecursiveBSplineTransformSIMDKernels
+::TransformPoints(
+  const unsigned int numberOfPoints,
+  const double * const * coefficients,
+  const OffsetValueType * gridOffsetTable,
+  const OffsetValueType * supportOffsets,
+  const double * weights1D,
+  double * displacements )
+{
+  switch( CurrentInstructionSet().load( std::memory_order_relaxed ) )
+  {
+#if defined( ELX_SIMD_X86 )
+#if defined( ELX_SIMD_AVX512 )
+    case AVX512:
+      TransformPointsAVX512( numberOfPoints, coefficients, gridOffsetTable, supportOffsets, weights1D, displacements );
+      break;
+#endif
+    case AVX2:
+      TransformPointsAVX2( numberOfPoints, coefficients, gridOffsetTable, supportOffsets, weights1D, displacements );
+      break;
+    case SSE41:
+      TransformPointsSSE41( numberOfPoints, coefficients, gridOffsetTable, supportOffsets, weights1D, displacements );
+      break;
+#endif
+    default:
+      TransformPointsScalar( numberOfPoints, coefficients, gridOffsetTable, supportOffsets, weights1D, displacements );
+  }
+
+} // end TransformPoints()
+
+
+/**
+ * ******************* GetJacobians *******************
+ */
+
+void
+RecursiveBSplineTransformSIMDKernels
+::GetJacobians(
+  const unsigned int numberOfPoints,
+  const double * weights1D,
+  double * const * jacobians )
+{
+  /** The diagonal blocks of the 3 x 192 Jacobian are 4 * 64 values apart. */
+  const double ones[ 3 ] = { 1.0, 1.0, 1.0 };
+  ScaledWeights( numberOfPoints, weights1D, ones, 0,
+    ( SpaceDimension + 1 ) * NumberOfIndices, jacobians );
+
+} // end GetJacobians()
+
+
+/**
+ * ******************* EvaluateJacobianWithImageGradientProducts *******************
+ */
+
+void
+RecursiveBSplineTransformSIMDKernels
+::EvaluateJacobianWithImageGradientProducts(
+  const unsigned int numberOfPoints,
+  const double * weights1D,
+  const double * movingImageGradients,
+  double * const * imageJacobians )
+{
+  ScaledWeights( numberOfPoints, weights1D, movingImageGradients, SpaceDimension,
+    NumberOfIndices, imageJacobians );
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkRecursiveBSplineTransformSIMDKernels_cxx
@@ -0,0 +1,138 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRecursiveBSplineTransformSIMDKernels_h
+#define __itkRecursiveBSplineTransformSIMDKernels_h
+
+#include "itkIntTypes.h"
+#include "itkMacro.h"
+
+namespace itk
+{
+
+/** \class RecursiveBSplineTransformSIMDKernels
+ *
+ * \brief Explicitly vectorized kernels of the recursive B-spline transform,
+ * for cubic B-splines in 3D with double precision.
+ *
+ * The kernels process a block of at most MaximumBlockSize points per call.
+ * Per point they take the 1D B-spline weights as computed by the
+ * RecursiveBSplineInterpolationWeightFunction, i.e. the 4 weights of the x
+ * dimension, followed by the 4 weights of y and the 4 weights of z. The results
+ * equal those of the RecursiveBSplineTransformImplementation, up to rounding
+ * differences: the summation order is different, and depends on the
+ * instruction set, and AVX2 and AVX-512 use fused multiply-add. Results may
+ * therefore differ between processors. The RecursiveBSplineTransform only uses
+ * these kernels when its UseSIMDKernels flag is set.
+ *
+ * Vectorization is over the 4 consecutive coefficients in the x dimension of
+ * the support region of a single point, which are contiguous in memory, not
+ * across points. AVX-512 additionally combines two rows in the y dimension.
+ *
+ * Unlike the header-only transforms, the kernels are compiled in elxCommon,
+ * which users of the RecursiveBSplineTransform should link.
+ *
+ * The instruction set is selected at run time: AVX-512, AVX2 with FMA, or
+ * SSE4.1 on x86 processors that support them, and portable scalar code
+ * otherwise. SetInstructionSet() selects a lower instruction set, for
+ * example to measure the speedup.
+ *
+ * \ingroup ITKTransform
+ */
+
+class RecursiveBSplineTransformSIMDKernels
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef RecursiveBSplineTransformSIMDKernels Self;
+
+  /** The supported instruction sets, in increasing order. */
+  typedef enum {
+    Scalar = 0,
+    SSE41  = 1,
+    AVX2   = 2,
+    AVX512 = 3
+  } InstructionSetType;
+
+  /** The dimension and spline order of the kernels. */
+  itkStaticConstMacro( SpaceDimension, unsigned int, 3 );
+  itkStaticConstMacro( SplineOrder, unsigned int, 3 );
+
+  /** The number of 1D weights per point, and the number of coefficients in a support region. */
+  itkStaticConstMacro( NumberOfWeights, unsigned int, 12 );
+  itkStaticConstMacro( NumberOfIndices, unsigned int, 64 );
+
+  /** The maximum number of points that a kernel processes per call. */
+  itkStaticConstMacro( MaximumBlockSize, unsigned int, 8 );
+
+  /** Get the best instruction set that is supported by the processor. */
+  static InstructionSetType GetMaximumInstructionSet( void );
+
+  /** Get/Set the instruction set that is used. By default the maximum.
+   * Set values above the maximum are clamped.
+   */
+  static InstructionSetType GetInstructionSet( void );
+
+  static void SetInstructionSet( const InstructionSetType instructionSet );
+
+  /** Get a printable name of an instruction set. */
+  static const char * GetInstructionSetName( const InstructionSetType instructionSet );
+
+  /** Compute the displacements of a block of points.
+   * \param coefficients The buffers of the 3 coefficient images.
+   * \param gridOffsetTable The offset table of the coefficient images.
+   * \param supportOffsets Per point the offset of the start of its support region.
+   * \param weights1D Per point the 12 1D weights.
+   * \param displacements Output: per point the 3 components of the displacement.
+   */
+  static void TransformPoints(
+    const unsigned int numberOfPoints,
+    const double * const * coefficients,
+    const OffsetValueType * gridOffsetTable,
+    const OffsetValueType * supportOffsets,
+    const double * weights1D,
+    double * displacements );
+
+  /** Compute the sparse Jacobians of a block of points. Per point only the
+   * 3 diagonal blocks of the 3 x 192 Jacobian are written, the caller should
+   * have zeroed the rest.
+   */
+  static void GetJacobians(
+    const unsigned int numberOfPoints,
+    const double * weights1D,
+    double * const * jacobians );
+
+  /** Compute the inner products of the sparse Jacobians with the moving image
+   * gradients, 3 per point, of a block of points. Per point 192 values are written.
+   */
+  static void EvaluateJacobianWithImageGradientProducts(
+    const unsigned int numberOfPoints,
+    const double * weights1D,
+    const double * movingImageGradients,
+    double * const * imageJacobians );
+
+private:
+
+  RecursiveBSplineTransformSIMDKernels();   // purposely not implemented
+  ~RecursiveBSplineTransformSIMDKernels();  // purposely not implemented
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkRecursiveBSplineTransformSIMDKernels_h
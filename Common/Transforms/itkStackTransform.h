@@ -77,6 +77,9 @@ public:
     JacobianOfSpatialHessianType;
   typedef typename
     Superclass::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
+  typedef typename
+    Superclass::NonZeroJacobianIndicesValueType NonZeroJacobianIndicesValueType;
+  typedef typename Superclass::MovingImageGradientType MovingImageGradientType;
   typedef typename Superclass::InputPointType      InputPointType;
   typedef typename Superclass::InputVectorType     InputVectorType;
   typedef typename Superclass::OutputVectorType    OutputVectorType;
@@ -101,6 +104,7 @@ public:
   /** Dimension - 1 point types. */
   typedef typename SubTransformType::InputPointType  SubTransformInputPointType;
   typedef typename SubTransformType::OutputPointType SubTransformOutputPointType;
+  typedef typename SubTransformType::MovingImageGradientType SubTransformMovingImageGradientType;
 
   /** Array type for parameter vector instantiation. */
   typedef typename ParametersType::ArrayType ParametersArrayType;
@@ -143,6 +147,28 @@ public:
     JacobianType & jac,
     NonZeroJacobianIndicesType & nzji ) const override;
 
+  /** Batch versions of TransformPoint(), GetJacobian() and
+   * EvaluateJacobianWithImageGradientProduct(). Consecutive points that
+   * belong to the same sub transform are passed to it as a single block.
+   */
+  void TransformPoints(
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    const SizeValueType numberOfPoints ) const override;
+
+  void GetJacobians(
+    const InputPointType * inputPoints,
+    const SizeValueType numberOfPoints,
+    ParametersValueType * jacobians,
+    NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const override;
+
+  void EvaluateJacobianWithImageGradientProducts(
+    const InputPointType * inputPoints,
+    const MovingImageGradientType * movingImageGradients,
+    const SizeValueType numberOfPoints,
+    ParametersValueType * imageJacobians,
+    NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const override;
+
   /** Set the parameters. Checks if the number of parameters
    * is correct and sets parameters of sub transforms. */
   void SetParameters( const ParametersType & param ) override;
@@ -285,6 +311,34 @@ public:
 
 protected:
 
+  /** The maximum number of points passed to a sub transform at once by the batch functions. */
+  itkStaticConstMacro( SubTransformBlockSize, unsigned int, 64 );
+
+  /** Get the index of the sub transform that is used for the given point. */
+  unsigned int GetSubTransformIndex( const InputPointType & ipp ) const
+  {
+    return vnl_math_min( this->m_NumberOfSubTransforms - 1, static_cast< unsigned int >(
+      vnl_math_max( 0,
+      vnl_math_rnd( ( ipp[ ReducedInputSpaceDimension ] - m_StackOrigin ) / m_StackSpacing ) ) ) );
+  }
+
+
+  /** Get the number of consecutive points, starting at the first one and at most
+   * SubTransformBlockSize, that use the same sub transform.
+   */
+  SizeValueType GetSubTransformRunLength( const InputPointType * inputPoints,
+    const SizeValueType numberOfPoints, const unsigned int subt ) const
+  {
+    SizeValueType length = 1;
+    while( length < numberOfPoints && length < SubTransformBlockSize
+      && this->GetSubTransformIndex( inputPoints[ length ] ) == subt )
+    {
+      ++length;
+    }
+    return length;
+  }
+
+
   StackTransform();
   ~StackTransform() override {}
 
@@ -20,6 +20,9 @@
 
 #include "itkStackTransform.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace itk
 {
 
@@ -114,10 +117,7 @@ StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
 
   /** Transform point using right subtransform. */
   SubTransformOutputPointType oppr;
-  const unsigned int          subt
-    = vnl_math_min( this->m_NumberOfSubTransforms - 1, static_cast< unsigned int >(
-      vnl_math_max( 0,
-      vnl_math_rnd( ( ipp[ ReducedInputSpaceDimension ] - m_StackOrigin ) / m_StackSpacing ) ) ) );
+  const unsigned int          subt = this->GetSubTransformIndex( ipp );
   oppr = this->m_SubTransformContainer[ subt ]->TransformPoint( ippr );
 
   /** Increase dimension of input point. */
@@ -153,10 +153,7 @@ StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
   }
 
   /** Get Jacobian from right subtransform. */
-  const unsigned int subt
-    = vnl_math_min( this->m_NumberOfSubTransforms - 1, static_cast< unsigned int >(
-      vnl_math_max( 0,
-      vnl_math_rnd( ( ipp[ ReducedInputSpaceDimension ] - m_StackOrigin ) / m_StackSpacing ) ) ) );
+  const unsigned int subt = this->GetSubTransformIndex( ipp );
   SubTransformJacobianType subjac;
   this->m_SubTransformContainer[ subt ]->GetJacobian( ippr, subjac, nzji );
 
@@ -180,6 +177,184 @@ StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
 } // end GetJacobian()
 
 
+/**
+ * ********************* TransformPoints ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  const SizeValueType numberOfPoints ) const
+{
+  SubTransformInputPointType  ippr[ SubTransformBlockSize ];
+  SubTransformOutputPointType oppr[ SubTransformBlockSize ];
+
+  SizeValueType begin = 0;
+  while( begin < numberOfPoints )
+  {
+    /** Find the consecutive points that use the same subtransform. */
+    const unsigned int  subt   = this->GetSubTransformIndex( inputPoints[ begin ] );
+    const SizeValueType length = this->GetSubTransformRunLength(
+      inputPoints + begin, numberOfPoints - begin, subt );
+
+    /** Reduce dimension of input points. */
+    for( SizeValueType i = 0; i < length; ++i )
+    {
+      for( unsigned int d = 0; d < ReducedInputSpaceDimension; ++d )
+      {
+        ippr[ i ][ d ] = inputPoints[ begin + i ][ d ];
+      }
+    }
+
+    /** Transform the points using the right subtransform. */
+    this->m_SubTransformContainer[ subt ]->TransformPoints( ippr, oppr, length );
+
+    /** Increase dimension of the output points. */
+    for( SizeValueType i = 0; i < length; ++i )
+    {
+      const TScalarType lastCoordinate = inputPoints[ begin + i ][ ReducedInputSpaceDimension ];
+      for( unsigned int d = 0; d < ReducedOutputSpaceDimension; ++d )
+      {
+        outputPoints[ begin + i ][ d ] = oppr[ i ][ d ];
+      }
+      outputPoints[ begin + i ][ ReducedOutputSpaceDimension ] = lastCoordinate;
+    }
+
+    begin += length;
+  }
+
+} // end TransformPoints()
+
+
+/**
+ * ********************* GetJacobians ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::GetJacobians(
+  const InputPointType * inputPoints,
+  const SizeValueType numberOfPoints,
+  ParametersValueType * jacobians,
+  NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const
+{
+  const NumberOfParametersType nnzji = this->GetNumberOfNonZeroJacobianIndices();
+  const NumberOfParametersType numberOfSubTransformParameters
+    = this->m_SubTransformContainer[ 0 ]->GetNumberOfParameters();
+  const SizeValueType subJacobianSize = ReducedOutputSpaceDimension * nnzji;
+  const SizeValueType jacobianSize    = OutputSpaceDimension * nnzji;
+
+  SubTransformInputPointType          ippr[ SubTransformBlockSize ];
+  std::vector< ParametersValueType >  subjac( SubTransformBlockSize * subJacobianSize );
+
+  SizeValueType begin = 0;
+  while( begin < numberOfPoints )
+  {
+    /** Find the consecutive points that use the same subtransform. */
+    const unsigned int  subt   = this->GetSubTransformIndex( inputPoints[ begin ] );
+    const SizeValueType length = this->GetSubTransformRunLength(
+      inputPoints + begin, numberOfPoints - begin, subt );
+
+    /** Reduce dimension of input points. */
+    for( SizeValueType i = 0; i < length; ++i )
+    {
+      for( unsigned int d = 0; d < ReducedInputSpaceDimension; ++d )
+      {
+        ippr[ i ][ d ] = inputPoints[ begin + i ][ d ];
+      }
+    }
+
+    /** Get the Jacobians from the right subtransform. The nonzero Jacobian
+     * indices are written directly in the output buffer.
+     */
+    NonZeroJacobianIndicesValueType * nzji = nonZeroJacobianIndices + begin * nnzji;
+    this->m_SubTransformContainer[ subt ]->GetJacobians( ippr, length, &subjac[ 0 ], nzji );
+
+    /** Fill the output Jacobians: the last row is zero. */
+    for( SizeValueType i = 0; i < length; ++i )
+    {
+      ParametersValueType * jac = jacobians + ( begin + i ) * jacobianSize;
+      std::copy( &subjac[ i * subJacobianSize ], &subjac[ i * subJacobianSize ] + subJacobianSize, jac );
+      std::fill( jac + subJacobianSize, jac + jacobianSize, 0.0 );
+    }
+
+    /** Update non zero Jacobian indices. */
+    for( SizeValueType i = 0; i < length * nnzji; ++i )
+    {
+      nzji[ i ] += subt * numberOfSubTransformParameters;
+    }
+
+    begin += length;
+  }
+
+} // end GetJacobians()
+
+
+/**
+ * ********************* EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType * inputPoints,
+  const MovingImageGradientType * movingImageGradients,
+  const SizeValueType numberOfPoints,
+  ParametersValueType * imageJacobians,
+  NonZeroJacobianIndicesValueType * nonZeroJacobianIndices ) const
+{
+  const NumberOfParametersType nnzji = this->GetNumberOfNonZeroJacobianIndices();
+  const NumberOfParametersType numberOfSubTransformParameters
+    = this->m_SubTransformContainer[ 0 ]->GetNumberOfParameters();
+
+  SubTransformInputPointType          ippr[ SubTransformBlockSize ];
+  SubTransformMovingImageGradientType migr[ SubTransformBlockSize ];
+
+  SizeValueType begin = 0;
+  while( begin < numberOfPoints )
+  {
+    /** Find the consecutive points that use the same subtransform. */
+    const unsigned int  subt   = this->GetSubTransformIndex( inputPoints[ begin ] );
+    const SizeValueType length = this->GetSubTransformRunLength(
+      inputPoints + begin, numberOfPoints - begin, subt );
+
+    /** Reduce dimension of input points and gradients. The last row of the
+     * Jacobian is zero, so the last gradient component does not contribute.
+     */
+    for( SizeValueType i = 0; i < length; ++i )
+    {
+      for( unsigned int d = 0; d < ReducedInputSpaceDimension; ++d )
+      {
+        ippr[ i ][ d ] = inputPoints[ begin + i ][ d ];
+      }
+      for( unsigned int d = 0; d < ReducedOutputSpaceDimension; ++d )
+      {
+        migr[ i ][ d ] = movingImageGradients[ begin + i ][ d ];
+      }
+    }
+
+    /** Let the right subtransform write directly in the output buffers. */
+    NonZeroJacobianIndicesValueType * nzji = nonZeroJacobianIndices + begin * nnzji;
+    this->m_SubTransformContainer[ subt ]->EvaluateJacobianWithImageGradientProducts(
+      ippr, migr, length, imageJacobians + begin * nnzji, nzji );
+
+    /** Update non zero Jacobian indices. */
+    for( SizeValueType i = 0; i < length * nnzji; ++i )
+    {
+      nzji[ i ] += subt * numberOfSubTransformParameters;
+    }
+
+    begin += length;
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
 /**
  * ********************* GetNumberOfNonZeroJacobianIndices ****************************
  */
@@ -328,7 +328,6 @@ TransformToDeterminantOfSpatialJacobianSource< TOutputImage, TTransformPrecision
   outputPtr->SetSpacing( m_OutputSpacing );
   outputPtr->SetOrigin( m_OutputOrigin );
   outputPtr->SetDirection( m_OutputDirection );
-  outputPtr->Allocate();
 
 } // end GenerateOutputInformation()
 
@@ -0,0 +1,300 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkBackgroundTaskQueue_cxx
+#define __itkBackgroundTaskQueue_cxx
+
+#include "itkBackgroundTaskQueue.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace itk
+{
+
+/**
+ * ****************** Constructor *********************************
+ */
+
+BackgroundTaskQueue
+::BackgroundTaskQueue()
+{
+  this->m_Capacity             = 1;
+  this->m_NumberOfDroppedTasks = 0;
+  this->m_TaskIsRunning        = false;
+  this->m_Stop                 = false;
+
+} // end Constructor
+
+
+/**
+ * ****************** Destructor *********************************
+ */
+
+BackgroundTaskQueue
+::~BackgroundTaskQueue()
+{
+  {
+    std::lock_guard< std::mutex > lock( this->m_Mutex );
+    this->m_Stop = true;
+  }
+  this->m_TaskPushed.notify_all();
+
+  /** The thread finishes the pending tasks before it stops. */
+  if( this->m_Thread.joinable() )
+  {
+    this->m_Thread.join();
+  }
+
+} // end Destructor
+
+
+/**
+ * ****************** SetCapacity *********************************
+ */
+
+void
+BackgroundTaskQueue
+::SetCapacity( const SizeValueType capacity )
+{
+  {
+    std::lock_guard< std::mutex > lock( this->m_Mutex );
+    this->m_Capacity = std::max< SizeValueType >( capacity, 1 );
+  }
+
+  /** A larger capacity may release a blocked Push(). */
+  this->m_TaskFinished.notify_all();
+
+} // end SetCapacity()
+
+
+/**
+ * ****************** GetCapacity *********************************
+ */
+
+SizeValueType
+BackgroundTaskQueue
+::GetCapacity( void ) const
+{
+  std::lock_guard< std::mutex > lock( this->m_Mutex );
+  return this->m_Capacity;
+
+} // end GetCapacity()
+
+
+/**
+ * ****************** Push *********************************
+ */
+
+void
+BackgroundTaskQueue
+::Push( const TaskType & task )
+{
+  {
+    std::unique_lock< std::mutex > lock( this->m_Mutex );
+    this->StartThread();
+    this->m_TaskFinished.wait( lock, [ this ]()
+      {
+        return this->m_PendingTasks.size() < this->m_Capacity;
+      } );
+    this->m_PendingTasks.push_back( PendingTaskType{ task, false } );
+  }
+  this->m_TaskPushed.notify_one();
+
+} // end Push()
+
+
+/**
+ * ****************** PushOrReplaceNewest *********************************
+ */
+
+bool
+BackgroundTaskQueue
+::PushOrReplaceNewest( const TaskType & task )
+{
+  bool dropped = false;
+  {
+    std::lock_guard< std::mutex > lock( this->m_Mutex );
+    this->StartThread();
+    if( this->m_PendingTasks.size() >= this->m_Capacity )
+    {
+      /** Drop the newest task that may be dropped, if any. The new task is
+       * appended, so that the tasks still run in the order of pushing.
+       */
+      const auto newest = std::find_if( this->m_PendingTasks.rbegin(), this->m_PendingTasks.rend(),
+        []( const PendingTaskType & pending ) { return pending.m_MayBeDropped; } );
+      if( newest != this->m_PendingTasks.rend() )
+      {
+        this->m_PendingTasks.erase( std::next( newest ).base() );
+        ++this->m_NumberOfDroppedTasks;
+        dropped = true;
+      }
+    }
+    this->m_PendingTasks.push_back( PendingTaskType{ task, true } );
+  }
+  this->m_TaskPushed.notify_one();
+
+  return !dropped;
+
+} // end PushOrReplaceNewest()
+
+
+/**
+ * ****************** Wait *********************************
+ */
+
+void
+BackgroundTaskQueue
+::Wait( void )
+{
+  std::exception_ptr exception;
+  {
+    std::unique_lock< std::mutex > lock( this->m_Mutex );
+    this->m_TaskFinished.wait( lock, [ this ]()
+      {
+        return this->m_PendingTasks.empty() && !this->m_TaskIsRunning;
+      } );
+    std::swap( exception, this->m_Exception );
+  }
+
+  if( exception )
+  {
+    std::rethrow_exception( exception );
+  }
+
+} // end Wait()
+
+
+/**
+ * ****************** GetNumberOfPendingTasks *********************************
+ */
+
+SizeValueType
+BackgroundTaskQueue
+::GetNumberOfPendingTasks( void ) const
+{
+  std::lock_guard< std::mutex > lock( this->m_Mutex );
+  return this->m_PendingTasks.size();
+
+} // end GetNumberOfPendingTasks()
+
+
+/**
+ * ****************** GetNumberOfDroppedTasks *********************************
+ */
+
+SizeValueType
+BackgroundTaskQueue
+::GetNumberOfDroppedTasks( void ) const
+{
+  std::lock_guard< std::mutex > lock( this->m_Mutex );
+  return this->m_NumberOfDroppedTasks;
+
+} // end GetNumberOfDroppedTasks()
+
+
+/**
+ * ****************** StartThread *********************************
+ */
+
+void
+BackgroundTaskQueue
+::StartThread( void )
+{
+  if( !this->m_Thread.joinable() )
+  {
+    this->m_Thread = std::thread( &Self::ThreadLoop, this );
+  }
+
+} // end StartThread()
+
+
+/**
+ * ****************** ThreadLoop *********************************
+ */
+
+void
+BackgroundTaskQueue
+::ThreadLoop( void )
+{
+  std::unique_lock< std::mutex > lock( this->m_Mutex );
+  while( true )
+  {
+    this->m_TaskPushed.wait( lock, [ this ]()
+      {
+        return this->m_Stop || !this->m_PendingTasks.empty();
+      } );
+    if( this->m_PendingTasks.empty() )
+    {
+      return;
+    }
+
+    /** Take the oldest task, which frees a place in the queue. */
+    TaskType task = this->m_PendingTasks.front().m_Task;
+    this->m_PendingTasks.pop_front();
+    this->m_TaskIsRunning = true;
+    lock.unlock();
+    this->m_TaskFinished.notify_all();
+
+    /** Run the task without holding the lock. Only the first exception is kept. */
+    std::exception_ptr exception;
+    try
+    {
+      task();
+    }
+    catch( ... )
+    {
+      exception = std::current_exception();
+    }
+
+    /** Release the data of the task before a waiting thread continues. */
+    task = TaskType();
+
+    lock.lock();
+    if( exception && !this->m_Exception )
+    {
+      this->m_Exception = exception;
+    }
+    this->m_TaskIsRunning = false;
+    this->m_TaskFinished.notify_all();
+  }
+
+} // end ThreadLoop()
+
+
+/**
+ * ****************** PrintSelf *********************************
+ */
+
+void
+BackgroundTaskQueue
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Capacity: " << this->GetCapacity() << std::endl;
+  os << indent << "NumberOfPendingTasks: "
+     << this->GetNumberOfPendingTasks() << std::endl;
+  os << indent << "NumberOfDroppedTasks: "
+     << this->GetNumberOfDroppedTasks() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkBackgroundTaskQueue_cxx
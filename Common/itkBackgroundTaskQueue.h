@@ -0,0 +1,146 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkBackgroundTaskQueue_h
+#define __itkBackgroundTaskQueue_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkIntTypes.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace itk
+{
+
+/** \class BackgroundTaskQueue
+ *
+ * \brief Executes tasks, in the order in which they are pushed, on a
+ * single background thread.
+ *
+ * This class is meant for I/O that may overlap with computations, such as
+ * writing slab k of an image while slab k+1 is being resampled. The queue
+ * holds at most Capacity pending tasks, besides the task that is running.
+ * When the queue is full:
+ *
+ * \li Push() blocks until a task has been taken from the queue. This
+ *   bounds the memory of the data that the pending tasks hold on to.
+ * \li PushOrReplaceNewest() drops the newest pending task that was also
+ *   pushed by PushOrReplaceNewest(), without executing it, and appends the
+ *   new task. Tasks pushed by Push() are never dropped; if all pending tasks
+ *   are such tasks, the new task is appended anyway, so that the queue then
+ *   holds one task more than its capacity. This never blocks, so that a
+ *   producer that must not stall, such as the optimizer loop, can push tasks
+ *   that are allowed to be skipped when the background thread falls behind.
+ *
+ * An exception thrown by a task is kept, and rethrown by the next call of
+ * Wait(). The background thread is started at the first push and stopped
+ * by the destructor, after the pending tasks have finished.
+ *
+ * \ingroup Common
+ */
+
+class BackgroundTaskQueue : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef BackgroundTaskQueue        Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( BackgroundTaskQueue, Object );
+
+  /** Typedef for the tasks. */
+  typedef std::function< void ( void ) > TaskType;
+
+  /** Set/Get the maximum number of pending tasks. Default: 1. */
+  void SetCapacity( const SizeValueType capacity );
+
+  SizeValueType GetCapacity( void ) const;
+
+  /** Push a task, blocking while the queue is full. */
+  void Push( const TaskType & task );
+
+  /** Push a task that may be dropped. If the queue is full, the newest
+   * pending task that may be dropped is replaced. Returns false if a task
+   * was dropped.
+   */
+  bool PushOrReplaceNewest( const TaskType & task );
+
+  /** Block until all pushed tasks have finished. Rethrows the first exception
+   * that a task threw since the previous call, if any.
+   */
+  void Wait( void );
+
+  /** Get the number of pending tasks, excluding the running one. */
+  SizeValueType GetNumberOfPendingTasks( void ) const;
+
+  /** Get the number of tasks that were dropped by PushOrReplaceNewest(). */
+  SizeValueType GetNumberOfDroppedTasks( void ) const;
+
+protected:
+
+  BackgroundTaskQueue();
+  ~BackgroundTaskQueue() override;
+
+  void PrintSelf( std::ostream & os, Indent indent ) const override;
+
+private:
+
+  BackgroundTaskQueue( const Self & ); // purposely not implemented
+  void operator=( const Self & );      // purposely not implemented
+
+  /** Start the background thread, if it is not running yet. Requires the lock. */
+  void StartThread( void );
+
+  /** The main loop of the background thread. */
+  void ThreadLoop( void );
+
+  /** A pending task, and whether PushOrReplaceNewest() may drop it. */
+  struct PendingTaskType
+  {
+    TaskType m_Task;
+    bool     m_MayBeDropped;
+  };
+
+  std::thread                   m_Thread;
+  std::deque< PendingTaskType > m_PendingTasks;
+  mutable std::mutex            m_Mutex;
+  std::condition_variable       m_TaskPushed;
+  std::condition_variable       m_TaskFinished;
+  SizeValueType                 m_Capacity;
+  SizeValueType                 m_NumberOfDroppedTasks;
+  bool                          m_TaskIsRunning;
+  bool                          m_Stop;
+  std::exception_ptr            m_Exception;
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkBackgroundTaskQueue_h
@@ -0,0 +1,215 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkBrickedBSplineInterpolateImageFunction_h
+#define __itkBrickedBSplineInterpolateImageFunction_h
+
+#include "itkBSplineInterpolateImageFunction.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class BrickedBSplineInterpolateImageFunction
+ * \brief B-spline interpolation of an image, using a bricked copy of the
+ * B-spline coefficients.
+ *
+ * The BSplineInterpolateImageFunction gathers (SplineOrder+1)^ImageDimension
+ * coefficients per evaluation from a coefficient image in the usual row by
+ * row layout. For a cubic spline in 3D these are 16 rows of 4 values, 16
+ * cache lines that are far apart in a large image. With random samples
+ * hardly any of them is still in the cache from a previous evaluation.
+ *
+ * When UseBrickedCoefficients is on, this class copies the coefficients in
+ * SetInputImage() to bricks of BrickSize^ImageDimension values, for example
+ * 8 x 8 x 8 values (4 kB) in 3D. The bricks are stored along a Morton
+ * (Z-order) curve, so that nearby bricks are also nearby in memory. A support
+ * region then mostly falls inside one brick, or a few adjacent ones. The
+ * bricks include a border of padding values, filled with the mirror boundary
+ * conditions of the superclass, so that an evaluation needs no boundary
+ * checks.
+ *
+ * EvaluateAtContinuousIndex() and EvaluateValueAndDerivativeAtContinuousIndex()
+ * then read from the bricks. Their results equal those of the superclass, up
+ * to rounding. Note that the latter function hides the non-virtual function
+ * of the superclass, so it has to be called through a pointer to this class.
+ *
+ * Memory: the coefficient image is kept, because the other functions of the
+ * superclass, such as EvaluateDerivativeAtContinuousIndex(), use it. The bricks
+ * are a second copy, which is larger than the coefficient image: per dimension
+ * the size grows by twice the padding of SplineOrder/2 + 2 values, rounded up
+ * to a multiple of BrickSize. For a cubic spline and a 256^3 image of doubles
+ * that is 264^3 values, i.e. 147 MB in addition to the 134 MB of the
+ * coefficient image. For small images the relative overhead is larger.
+ * GetBrickedCoefficientsMemorySize() returns the actual size.
+ * The bricks are not used for images that are smaller than the padding in
+ * some dimension, or for spline orders above 5.
+ *
+ * \sa BSplineInterpolateImageFunction
+ * \ingroup ImageFunctions ImageInterpolators
+ */
+
+template<
+class TImageType,
+class TCoordRep        = double,
+class TCoefficientType = double >
+class BrickedBSplineInterpolateImageFunction :
+  public BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef BrickedBSplineInterpolateImageFunction Self;
+  typedef BSplineInterpolateImageFunction<
+    TImageType, TCoordRep, TCoefficientType >    Superclass;
+  typedef SmartPointer< Self >                   Pointer;
+  typedef SmartPointer< const Self >             ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( BrickedBSplineInterpolateImageFunction, BSplineInterpolateImageFunction );
+
+  /** Dimension underlying input image. */
+  itkStaticConstMacro( ImageDimension, unsigned int, Superclass::ImageDimension );
+
+  /** Typedefs inherited from the superclass. */
+  typedef typename Superclass::OutputType           OutputType;
+  typedef typename Superclass::InputImageType       InputImageType;
+  typedef typename Superclass::IndexType            IndexType;
+  typedef typename Superclass::ContinuousIndexType  ContinuousIndexType;
+  typedef typename Superclass::PointType            PointType;
+  typedef typename Superclass::CoefficientDataType  CoefficientDataType;
+  typedef typename Superclass::CoefficientImageType CoefficientImageType;
+  typedef typename Superclass::CovariantVectorType  CovariantVectorType;
+
+  /** The edge length of a brick. */
+  itkStaticConstMacro( BrickSize, unsigned int, 8 );
+
+  /** The maximum number of coefficients in the support region in one dimension. */
+  itkStaticConstMacro( MaximumSupportSize, unsigned int, 6 );
+
+  /** Set/get whether to use the bricked coefficients. Default: false.
+   * Takes effect at the next SetInputImage().
+   */
+  itkSetMacro( UseBrickedCoefficients, bool );
+  itkGetConstMacro( UseBrickedCoefficients, bool );
+  itkBooleanMacro( UseBrickedCoefficients );
+
+  /** Get whether the bricked coefficients are available for the current input and spline order. */
+  bool GetBrickedCoefficientsAreValid( void ) const
+  {
+    return this->m_BrickedCoefficientsAreValid
+           && this->m_BrickedSplineOrder == this->GetSplineOrder();
+  }
+
+
+  /** Get the memory taken by the bricks, in bytes. Zero if they are not used. */
+  SizeValueType GetBrickedCoefficientsMemorySize( void ) const
+  {
+    return this->m_BrickedCoefficients.size() * sizeof( CoefficientDataType )
+           + this->m_BrickOffsets.size() * sizeof( OffsetValueType );
+  }
+
+
+  /** Set the input image, compute the coefficients, and, if requested, copy them to bricks. */
+  void SetInputImage( const TImageType * inputData ) override;
+
+  /** Evaluate the function at a ContinuousIndex position, see the superclass.
+   * Uses the bricked coefficients if they are valid.
+   */
+  using Superclass::EvaluateAtContinuousIndex;
+  OutputType EvaluateAtContinuousIndex( const ContinuousIndexType & x ) const override;
+
+  /** Evaluate the function and its derivative at a ContinuousIndex position,
+   * see the superclass. Uses the bricked coefficients if they are valid.
+   */
+  using Superclass::EvaluateValueAndDerivativeAtContinuousIndex;
+  void EvaluateValueAndDerivativeAtContinuousIndex(
+    const ContinuousIndexType & x,
+    OutputType & value,
+    CovariantVectorType & derivative ) const;
+
+protected:
+
+  BrickedBSplineInterpolateImageFunction();
+  ~BrickedBSplineInterpolateImageFunction() override {}
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const override;
+
+  /** Copy the coefficients of the superclass to the bricks. */
+  virtual void ComputeBrickedCoefficients( void );
+
+private:
+
+  BrickedBSplineInterpolateImageFunction( const Self & ); // purposely not implemented
+  void operator=( const Self & );                         // purposely not implemented
+
+  /** Typedefs for the per dimension arrays of the support region. */
+  typedef FixedArray< OffsetValueType, itkGetStaticConstMacro( ImageDimension ) > OffsetArrayType;
+  typedef double SupportWeightsType[ ImageDimension ][ MaximumSupportSize ];
+  typedef OffsetValueType SupportOffsetsType[ ImageDimension ][ MaximumSupportSize ];
+
+  /** Determine the support region of x, as in the superclass, and per
+   * dimension the offsets of its coefficients in the brick grid and in the
+   * brick. Optionally compute the weights and the derivative weights.
+   */
+  void DetermineBrickedRegionOfSupport(
+    const ContinuousIndexType & x,
+    SupportOffsetsType & brickOffsets,
+    SupportOffsetsType & elementOffsets,
+    SupportWeightsType & weights,
+    SupportWeightsType * derivativeWeights ) const;
+
+  /** Compute the 1D B-spline weights of x, for the support region that starts at firstIndex. */
+  static void ComputeWeights( const double x, const OffsetValueType firstIndex,
+    const unsigned int splineOrder, double * weights );
+
+  /** Compute the 1D B-spline derivative weights of x, for the support region that starts at firstIndex. */
+  static void ComputeDerivativeWeights( const double x, const OffsetValueType firstIndex,
+    const unsigned int splineOrder, double * weights );
+
+  /** The setting. */
+  bool m_UseBrickedCoefficients;
+
+  /** The bricks, and per brick in the brick grid the offset of its first value. */
+  std::vector< CoefficientDataType > m_BrickedCoefficients;
+  std::vector< OffsetValueType >     m_BrickOffsets;
+
+  /** The index of the first value in the brick grid, which includes the padding. */
+  OffsetArrayType m_BrickedStartIndex;
+
+  /** The strides of the brick grid, and of the values in a brick. */
+  OffsetArrayType m_BrickGridStrides;
+  OffsetArrayType m_BrickElementStrides;
+
+  /** The spline order of the bricked coefficients, and whether they are valid. */
+  unsigned int m_BrickedSplineOrder;
+  bool         m_BrickedCoefficientsAreValid;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBrickedBSplineInterpolateImageFunction.hxx"
+#endif
+
+#endif // end #ifndef __itkBrickedBSplineInterpolateImageFunction_h
@@ -0,0 +1,564 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkBrickedBSplineInterpolateImageFunction_hxx
+#define __itkBrickedBSplineInterpolateImageFunction_hxx
+
+#include "itkBrickedBSplineInterpolateImageFunction.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+BrickedBSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::BrickedBSplineInterpolateImageFunction()
+{
+  this->m_UseBrickedCoefficients      = false;
+  this->m_BrickedSplineOrder          = 0;
+  this->m_BrickedCoefficientsAreValid = false;
+  this->m_BrickedStartIndex.Fill( 0 );
+  this->m_BrickGridStrides.Fill( 0 );
+  this->m_BrickElementStrides.Fill( 0 );
+
+} // end Constructor
+
+
+/**
+ * ******************* SetInputImage ***********************
+ */
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+void
+BrickedBSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::SetInputImage( const TImageType * inputData )
+{
+  /** Compute the B-spline coefficients. */
+  this->Superclass::SetInputImage( inputData );
+
+  /** Copy them to the bricks, if requested. */
+  this->ComputeBrickedCoefficients();
+
+} // end SetInputImage()
+
+
+/**
+ * ******************* ComputeBrickedCoefficients ***********************
+ */
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+void
+BrickedBSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::ComputeBrickedCoefficients( void )
+{
+  /** Release the previous bricks. */
+  this->m_BrickedCoefficientsAreValid = false;
+  std::vector< CoefficientDataType >().swap( this->m_BrickedCoefficients );
+  std::vector< OffsetValueType >().swap( this->m_BrickOffsets );
+
+  const unsigned int splineOrder = this->m_SplineOrder;
+  if( !this->m_UseBrickedCoefficients || this->m_Coefficients.IsNull()
+    || splineOrder + 1 > MaximumSupportSize )
+  {
+    return;
+  }
+
+  /** The padding covers the support regions of all points inside the buffer,
+   * see ImageFunction::IsInsideBuffer(), which may be half a pixel outside.
+   */
+  const OffsetValueType padding = splineOrder / 2 + 2;
+  const typename CoefficientImageType::RegionType region
+    = this->m_Coefficients->GetBufferedRegion();
+  const OffsetValueType * offsetTable = this->m_Coefficients->GetOffsetTable();
+
+  /** Set up the brick grid. Per dimension, compute for all positions in the
+   * brick grid the offset of the coefficient in the coefficient image, using
+   * the mirror boundary conditions of the superclass. The single reflection
+   * is only correct if the padding is smaller than the image.
+   */
+  OffsetArrayType                numberOfBricks;
+  SizeValueType                  totalNumberOfBricks = 1;
+  std::vector< OffsetValueType > sourceOffsets[ ImageDimension ];
+  for( unsigned int n = 0; n < ImageDimension; ++n )
+  {
+    const OffsetValueType start = region.GetIndex()[ n ];
+    const OffsetValueType size  = static_cast< OffsetValueType >( region.GetSize()[ n ] );
+    const OffsetValueType end   = start + size - 1;
+    if( size > 1 && size <= padding ) { return; }
+
+    numberOfBricks[ n ]            = ( size + 2 * padding + BrickSize - 1 ) / BrickSize;
+    this->m_BrickedStartIndex[ n ] = start - padding;
+    this->m_BrickGridStrides[ n ]
+      = ( n == 0 ) ? 1 : this->m_BrickGridStrides[ n - 1 ] * numberOfBricks[ n - 1 ];
+    this->m_BrickElementStrides[ n ]
+      = ( n == 0 ) ? 1 : this->m_BrickElementStrides[ n - 1 ] * BrickSize;
+    totalNumberOfBricks *= numberOfBricks[ n ];
+
+    sourceOffsets[ n ].resize( numberOfBricks[ n ] * BrickSize );
+    for( OffsetValueType q = 0; q < numberOfBricks[ n ] * BrickSize; ++q )
+    {
+      OffsetValueType index = this->m_BrickedStartIndex[ n ] + q;
+      if( size == 1 )
+      {
+        index = start;
+      }
+      else
+      {
+        if( index < start ) { index = 2 * start - index; }
+        if( index > end ) { index = 2 * end - index; }
+        index = std::max( start, std::min( end, index ) );
+      }
+      sourceOffsets[ n ][ q ] = ( index - start ) * offsetTable[ n ];
+    }
+  }
+  const SizeValueType numberOfValuesPerBrick
+    = this->m_BrickElementStrides[ ImageDimension - 1 ] * BrickSize;
+
+  /** Order the bricks along a Morton curve, by interleaving the bits of their
+   * indices in the brick grid.
+   */
+  std::vector< std::pair< uint64_t, SizeValueType > > mortonCodes( totalNumberOfBricks );
+  for( SizeValueType b = 0; b < totalNumberOfBricks; ++b )
+  {
+    SizeValueType remainder = b;
+    uint64_t      code      = 0;
+    for( int n = ImageDimension - 1; n >= 0; --n )
+    {
+      const SizeValueType brickIndex = remainder / this->m_BrickGridStrides[ n ];
+      remainder -= brickIndex * this->m_BrickGridStrides[ n ];
+      for( unsigned int bit = 0; bit * ImageDimension + static_cast< unsigned int >( n ) < 64; ++bit )
+      {
+        code |= static_cast< uint64_t >( ( brickIndex >> bit ) & 1 )
+          << ( bit * ImageDimension + static_cast< unsigned int >( n ) );
+      }
+    }
+    mortonCodes[ b ] = std::make_pair( code, b );
+  }
+  std::sort( mortonCodes.begin(), mortonCodes.end() );
+
+  this->m_BrickOffsets.resize( totalNumberOfBricks );
+  for( SizeValueType r = 0; r < totalNumberOfBricks; ++r )
+  {
+    this->m_BrickOffsets[ mortonCodes[ r ].second ] = r * numberOfValuesPerBrick;
+  }
+
+  /** Fill the bricks. Inside a brick, dimension 0 runs fastest. */
+  this->m_BrickedCoefficients.resize( totalNumberOfBricks * numberOfValuesPerBrick );
+  const CoefficientDataType * coefficients = this->m_Coefficients->GetBufferPointer();
+  for( SizeValueType b = 0; b < totalNumberOfBricks; ++b )
+  {
+    OffsetArrayType firstPosition;
+    SizeValueType   remainder = b;
+    for( int n = ImageDimension - 1; n >= 0; --n )
+    {
+      const SizeValueType brickIndex = remainder / this->m_BrickGridStrides[ n ];
+      remainder          -= brickIndex * this->m_BrickGridStrides[ n ];
+      firstPosition[ n ]  = brickIndex * BrickSize;
+    }
+
+    CoefficientDataType * brick = &this->m_BrickedCoefficients[ this->m_BrickOffsets[ b ] ];
+    unsigned int          k[ ImageDimension ];
+    std::fill( k, k + ImageDimension, 0 );
+    for( SizeValueType e = 0; e < numberOfValuesPerBrick; ++e )
+    {
+      OffsetValueType sourceOffset = 0;
+      for( unsigned int n = 0; n < ImageDimension; ++n )
+      {
+        sourceOffset += sourceOffsets[ n ][ firstPosition[ n ] + k[ n ] ];
+      }
+      brick[ e ] = coefficients[ sourceOffset ];
+
+      for( unsigned int n = 0; n < ImageDimension; ++n )
+      {
+        if( ++k[ n ] < BrickSize ) { break; }
+        k[ n ] = 0;
+      }
+    }
+  }
+
+  this->m_BrickedSplineOrder          = splineOrder;
+  this->m_BrickedCoefficientsAreValid = true;
+
+} // end ComputeBrickedCoefficients()
+
+
+/**
+ * ******************* EvaluateAtContinuousIndex ***********************
+ */
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+typename BrickedBSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >::OutputType
+BrickedBSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::EvaluateAtContinuousIndex( const ContinuousIndexType & x ) const
+{
+  if( !this->GetBrickedCoefficientsAreValid() )
+  {
+    return this->Superclass::EvaluateAtContinuousIndex( x );
+  }
+
+  /** Determine the support region and the weights. */
+  SupportOffsetsType brickOffsets, elementOffsets;
+  SupportWeightsType weights;
+  this->DetermineBrickedRegionOfSupport( x, brickOffsets, elementOffsets, weights, 0 );
+
+  /** Loop over the support region, dimension 0 fastest, as in the superclass. */
+  const unsigned int          supportSize = this->m_SplineOrder + 1;
+  const CoefficientDataType * bricks      = &this->m_BrickedCoefficients[ 0 ];
+  const OffsetValueType *     brickTable  = &this->m_BrickOffsets[ 0 ];
+  unsigned long               numberOfPoints = 1;
+  unsigned int                k[ ImageDimension ];
+  for( unsigned int n = 0; n < ImageDimension; ++n )
+  {
+    numberOfPoints *= supportSize;
+    k[ n ]          = 0;
+  }
+  double value = 0.0;
+  for( unsigned long p = 0; p < numberOfPoints; ++p )
+  {
+    double          w             = 1.0;
+    OffsetValueType brickOffset   = 0;
+    OffsetValueType elementOffset = 0;
+    for( unsigned int n = 0; n < ImageDimension; ++n )
+    {
+      w             *= weights[ n ][ k[ n ] ];
+      brickOffset   += brickOffsets[ n ][ k[ n ] ];
+      elementOffset += elementOffsets[ n ][ k[ n ] ];
+    }
+    value += w * bricks[ brickTable[ brickOffset ] + elementOffset ];
+
+    for( unsigned int n = 0; n < ImageDimension; ++n )
+    {
+      if( ++k[ n ] < supportSize ) { break; }
+      k[ n ] = 0;
+    }
+  }
+
+  return static_cast< OutputType >( value );
+
+} // end EvaluateAtContinuousIndex()
+
+
+/**
+ * ******************* EvaluateValueAndDerivativeAtContinuousIndex ***********************
+ */
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+void
+BrickedBSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::EvaluateValueAndDerivativeAtContinuousIndex(
+  const ContinuousIndexType & x,
+  OutputType & value,
+  CovariantVectorType & derivative ) const
+{
+  if( !this->GetBrickedCoefficientsAreValid() )
+  {
+    return this->Superclass::EvaluateValueAndDerivativeAtContinuousIndex( x, value, derivative );
+  }
+
+  /** Determine the support region, the weights and the derivative weights. */
+  SupportOffsetsType brickOffsets, elementOffsets;
+  SupportWeightsType weights, derivativeWeights;
+  this->DetermineBrickedRegionOfSupport( x, brickOffsets, elementOffsets, weights, &derivativeWeights );
+
+  /** Loop over the support region, dimension 0 fastest, as in the superclass. */
+  const unsigned int          supportSize = this->m_SplineOrder + 1;
+  const CoefficientDataType * bricks      = &this->m_BrickedCoefficients[ 0 ];
+  const OffsetValueType *     brickTable  = &this->m_BrickOffsets[ 0 ];
+  unsigned long               numberOfPoints = 1;
+  unsigned int                k[ ImageDimension ];
+  for( unsigned int n = 0; n < ImageDimension; ++n )
+  {
+    numberOfPoints *= supportSize;
+    k[ n ]          = 0;
+  }
+  double valueSum = 0.0;
+  double derivativeSum[ ImageDimension ];
+  std::fill( derivativeSum, derivativeSum + ImageDimension, 0.0 );
+  for( unsigned long p = 0; p < numberOfPoints; ++p )
+  {
+    /** The product of the weights of the dimensions below n, for every n. */
+    double          lowerProducts[ ImageDimension ];
+    double          w             = 1.0;
+    OffsetValueType brickOffset   = 0;
+    OffsetValueType elementOffset = 0;
+    for( unsigned int n = 0; n < ImageDimension; ++n )
+    {
+      lowerProducts[ n ] = w;
+      w             *= weights[ n ][ k[ n ] ];
+      brickOffset   += brickOffsets[ n ][ k[ n ] ];
+      elementOffset += elementOffsets[ n ][ k[ n ] ];
+    }
+    const double coefficient = bricks[ brickTable[ brickOffset ] + elementOffset ];
+    valueSum += w * coefficient;
+
+    /** Combine with the product of the weights of the dimensions above n,
+     * so that the derivative weights take O(ImageDimension) per point.
+     */
+    double upperProduct = coefficient;
+    for( int n = ImageDimension - 1; n >= 0; --n )
+    {
+      derivativeSum[ n ] += derivativeWeights[ n ][ k[ n ] ] * lowerProducts[ n ] * upperProduct;
+      upperProduct       *= weights[ n ][ k[ n ] ];
+    }
+
+    for( unsigned int n = 0; n < ImageDimension; ++n )
+    {
+      if( ++k[ n ] < supportSize ) { break; }
+      k[ n ] = 0;
+    }
+  }
+
+  /** Express the derivative in physical space, as in the superclass. */
+  value = static_cast< OutputType >( valueSum );
+  const typename InputImageType::SpacingType & spacing = this->GetInputImage()->GetSpacing();
+  for( unsigned int n = 0; n < ImageDimension; ++n )
+  {
+    derivative[ n ] = derivativeSum[ n ] / spacing[ n ];
+  }
+  if( this->GetUseImageDirection() )
+  {
+    CovariantVectorType orientedDerivative;
+    this->GetInputImage()->TransformLocalVectorToPhysicalVector( derivative, orientedDerivative );
+    derivative = orientedDerivative;
+  }
+
+} // end EvaluateValueAndDerivativeAtContinuousIndex()
+
+
+/**
+ * ******************* DetermineBrickedRegionOfSupport ***********************
+ */
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+void
+BrickedBSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::DetermineBrickedRegionOfSupport(
+  const ContinuousIndexType & x,
+  SupportOffsetsType & brickOffsets,
+  SupportOffsetsType & elementOffsets,
+  SupportWeightsType & weights,
+  SupportWeightsType * derivativeWeights ) const
+{
+  const unsigned int splineOrder = this->m_SplineOrder;
+  const double       halfOffset  = ( splineOrder & 1 ) ? 0.0 : 0.5;
+  for( unsigned int n = 0; n < ImageDimension; ++n )
+  {
+    const OffsetValueType firstIndex
+      = static_cast< OffsetValueType >( std::floor( x[ n ] + halfOffset ) ) - splineOrder / 2;
+
+    Self::ComputeWeights( x[ n ], firstIndex, splineOrder, weights[ n ] );
+    if( derivativeWeights )
+    {
+      Self::ComputeDerivativeWeights( x[ n ], firstIndex, splineOrder, ( *derivativeWeights )[ n ] );
+    }
+
+    /** The padding makes sure that the relative index is not negative. */
+    for( unsigned int k = 0; k <= splineOrder; ++k )
+    {
+      const OffsetValueType relativeIndex = firstIndex + k - this->m_BrickedStartIndex[ n ];
+      brickOffsets[ n ][ k ]   = ( relativeIndex / BrickSize ) * this->m_BrickGridStrides[ n ];
+      elementOffsets[ n ][ k ] = ( relativeIndex % BrickSize ) * this->m_BrickElementStrides[ n ];
+    }
+  }
+
+} // end DetermineBrickedRegionOfSupport()
+
+
+/**
+ * ******************* ComputeWeights ***********************
+ */
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+void
+BrickedBSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::ComputeWeights( const double x, const OffsetValueType firstIndex,
+  const unsigned int splineOrder, double * weights )
+{
+  /** The same expressions as in BSplineInterpolateImageFunction::SetInterpolationWeights(). */
+  double w, w2, w4, t, t0, t1;
+  switch( splineOrder )
+  {
+    case 0:
+      weights[ 0 ] = 1.0;
+      break;
+    case 1:
+      w            = x - static_cast< double >( firstIndex );
+      weights[ 1 ] = w;
+      weights[ 0 ] = 1.0 - w;
+      break;
+    case 2:
+      w            = x - static_cast< double >( firstIndex + 1 );
+      weights[ 1 ] = 0.75 - w * w;
+      weights[ 2 ] = 0.5 * ( w - weights[ 1 ] + 1.0 );
+      weights[ 0 ] = 1.0 - weights[ 1 ] - weights[ 2 ];
+      break;
+    case 3:
+      w            = x - static_cast< double >( firstIndex + 1 );
+      weights[ 3 ] = ( 1.0 / 6.0 ) * w * w * w;
+      weights[ 0 ] = ( 1.0 / 6.0 ) + 0.5 * w * ( w - 1.0 ) - weights[ 3 ];
+      weights[ 2 ] = w + weights[ 0 ] - 2.0 * weights[ 3 ];
+      weights[ 1 ] = 1.0 - weights[ 0 ] - weights[ 2 ] - weights[ 3 ];
+      break;
+    case 4:
+      w             = x - static_cast< double >( firstIndex + 2 );
+      w2            = w * w;
+      t             = ( 1.0 / 6.0 ) * w2;
+      weights[ 0 ]  = 0.5 - w;
+      weights[ 0 ] *= weights[ 0 ];
+      weights[ 0 ] *= ( 1.0 / 24.0 ) * weights[ 0 ];
+      t0            = w * ( t - 11.0 / 24.0 );
+      t1            = 19.0 / 96.0 + w2 * ( 0.25 - t );
+      weights[ 1 ]  = t1 + t0;
+      weights[ 3 ]  = t1 - t0;
+      weights[ 4 ]  = weights[ 0 ] + t0 + 0.5 * w;
+      weights[ 2 ]  = 1.0 - weights[ 0 ] - weights[ 1 ] - weights[ 3 ] - weights[ 4 ];
+      break;
+    case 5:
+      w            = x - static_cast< double >( firstIndex + 2 );
+      w2           = w * w;
+      weights[ 5 ] = ( 1.0 / 120.0 ) * w * w2 * w2;
+      w2          -= w;
+      w4           = w2 * w2;
+      w           -= 0.5;
+      t            = w2 * ( w2 - 3.0 );
+      weights[ 0 ] = ( 1.0 / 24.0 ) * ( 1.0 / 5.0 + w2 + w4 ) - weights[ 5 ];
+      t0           = ( 1.0 / 24.0 ) * ( w2 * ( w2 - 5.0 ) + 46.0 / 5.0 );
+      t1           = ( -1.0 / 12.0 ) * w * ( t + 4.0 );
+      weights[ 2 ] = t0 + t1;
+      weights[ 3 ] = t0 - t1;
+      t0           = ( 1.0 / 16.0 ) * ( 9.0 / 5.0 - t );
+      t1           = ( 1.0 / 24.0 ) * w * ( w4 - w2 - 5.0 );
+      weights[ 1 ] = t0 + t1;
+      weights[ 4 ] = t0 - t1;
+      break;
+    default:
+      itkGenericExceptionMacro( << "SplineOrder must be between 0 and 5. Requested spline order has not been implemented yet." );
+  }
+
+} // end ComputeWeights()
+
+
+/**
+ * ******************* ComputeDerivativeWeights ***********************
+ */
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+void
+BrickedBSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::ComputeDerivativeWeights( const double x, const OffsetValueType firstIndex,
+  const unsigned int splineOrder, double * weights )
+{
+  /** The same expressions as in BSplineInterpolateImageFunction::SetDerivativeWeights(),
+   * i.e. the differences of the weights of order splineOrder - 1 at x + 1/2.
+   */
+  double w, w1, w2, w3, w4, w5, t, t0, t1, t2;
+  switch( splineOrder )
+  {
+    case 0:
+      weights[ 0 ] = 0.0;
+      break;
+    case 1:
+      weights[ 0 ] = -1.0;
+      weights[ 1 ] =  1.0;
+      break;
+    case 2:
+      w            = x + 0.5 - static_cast< double >( firstIndex + 1 );
+      w1           = 1.0 - w;
+      weights[ 0 ] = 0.0 - w1;
+      weights[ 1 ] = w1 - w;
+      weights[ 2 ] = w;
+      break;
+    case 3:
+      w            = x + 0.5 - static_cast< double >( firstIndex + 2 );
+      w2           = 0.75 - w * w;
+      w3           = 0.5 * ( w - w2 + 1.0 );
+      w1           = 1.0 - w2 - w3;
+      weights[ 0 ] = 0.0 - w1;
+      weights[ 1 ] = w1 - w2;
+      weights[ 2 ] = w2 - w3;
+      weights[ 3 ] = w3;
+      break;
+    case 4:
+      w            = x + 0.5 - static_cast< double >( firstIndex + 2 );
+      w4           = ( 1.0 / 6.0 ) * w * w * w;
+      w1           = ( 1.0 / 6.0 ) + 0.5 * w * ( w - 1.0 ) - w4;
+      w3           = w + w1 - 2.0 * w4;
+      w2           = 1.0 - w1 - w3 - w4;
+      weights[ 0 ] = 0.0 - w1;
+      weights[ 1 ] = w1 - w2;
+      weights[ 2 ] = w2 - w3;
+      weights[ 3 ] = w3 - w4;
+      weights[ 4 ] = w4;
+      break;
+    case 5:
+      w            = x + 0.5 - static_cast< double >( firstIndex + 3 );
+      t2           = w * w;
+      t            = ( 1.0 / 6.0 ) * t2;
+      w1           = 0.5 - w;
+      w1          *= w1;
+      w1          *= ( 1.0 / 24.0 ) * w1;
+      t0           = w * ( t - 11.0 / 24.0 );
+      t1           = 19.0 / 96.0 + t2 * ( 0.25 - t );
+      w2           = t1 + t0;
+      w4           = t1 - t0;
+      w5           = w1 + t0 + 0.5 * w;
+      w3           = 1.0 - w1 - w2 - w4 - w5;
+      weights[ 0 ] = 0.0 - w1;
+      weights[ 1 ] = w1 - w2;
+      weights[ 2 ] = w2 - w3;
+      weights[ 3 ] = w3 - w4;
+      weights[ 4 ] = w4 - w5;
+      weights[ 5 ] = w5;
+      break;
+    default:
+      itkGenericExceptionMacro( << "SplineOrder (for derivatives) must be between 1 and 5. Requested spline order has not been implemented yet." );
+  }
+
+} // end ComputeDerivativeWeights()
+
+
+/**
+ * ******************* PrintSelf ***********************
+ */
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+void
+BrickedBSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "UseBrickedCoefficients: " << this->m_UseBrickedCoefficients << std::endl;
+  os << indent << "BrickedCoefficientsAreValid: " << this->m_BrickedCoefficientsAreValid << std::endl;
+  os << indent << "BrickedSplineOrder: " << this->m_BrickedSplineOrder << std::endl;
+  os << indent << "NumberOfBricks: " << this->m_BrickOffsets.size() << std::endl;
+  os << indent << "BrickedCoefficientsMemorySize: " << this->GetBrickedCoefficientsMemorySize() << std::endl;
+  os << indent << "BrickedStartIndex: " << this->m_BrickedStartIndex << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkBrickedBSplineInterpolateImageFunction_hxx
@@ -22,6 +22,7 @@
 #include "itkImageRandomSamplerBase.h"
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkScaledSingleValuedNonLinearOptimizer.h"
+#include "itkMultiThreader.h"
 
 namespace itk
 {
@@ -90,6 +91,12 @@ public:
   itkSetMacro( NumberOfBandStructureSamples, unsigned int );
   itkSetMacro( NumberOfJacobianMeasurements, SizeValueType );
 
+  /** Set/Get the number of threads. Default: the global default number of
+   * threads of the MultiThreader. The results do not depend on it.
+   */
+  itkSetMacro( NumberOfThreads, ThreadIdType );
+  itkGetConstMacro( NumberOfThreads, ThreadIdType );
+
   /** Set the region over which the metric will be computed. */
   void SetFixedImageRegion( const FixedImageRegionType & region )
   {
@@ -122,6 +129,7 @@ protected:
   unsigned int  m_MaxBandCovSize;
   unsigned int  m_NumberOfBandStructureSamples;
   SizeValueType m_NumberOfJacobianMeasurements;
+  ThreadIdType  m_NumberOfThreads;
 
   typedef typename  FixedImageType::IndexType   FixedImageIndexType;
   typedef typename  FixedImageType::PointType   FixedImagePointType;
@@ -156,6 +164,9 @@ private:
   ComputeJacobianTerms( const Self & ); // purposely not implemented
   void operator=( const Self & );       // purposely not implemented
 
+  /** The number of samples per thread in a batch of the computation of C. */
+  itkStaticConstMacro( SamplesPerThreadPerBatch, unsigned int, 16 );
+
 };
 
 } // end namespace itk
@@ -24,6 +24,10 @@
 #include "vnl/vnl_fastops.h"
 #include "vnl/vnl_diag_matrix.h"
 #include "vnl/vnl_sparse_matrix.h"
+#include "itkWorkStealingThreadPool.h"
+
+#include <algorithm>
+#include <utility>
 
 namespace itk
 {
@@ -44,6 +48,7 @@ ComputeJacobianTerms< TFixedImage, TTransform >
   this->m_MaxBandCovSize               = 0;
   this->m_NumberOfBandStructureSamples = 0;
   this->m_NumberOfJacobianMeasurements = 0;
+  this->m_NumberOfThreads              = MultiThreader::GetGlobalDefaultNumberOfThreads();
 
 } // end Constructor
 
@@ -77,7 +82,6 @@ ComputeJacobianTerms< TFixedImage, TTransform >
   typedef itk::Array2D< CovarianceValueType >      CovarianceMatrixType;
   typedef vnl_sparse_matrix< CovarianceValueType > SparseCovarianceMatrixType;
   typedef SparseCovarianceMatrixType::row          SparseRowType;
-  typedef itk::Array< SizeValueType >              NonZeroJacobianIndicesExpandedType;
   typedef vnl_diag_matrix< CovarianceValueType >   DiagCovarianceMatrixType;
 
   /** Initialize. */
@@ -101,12 +105,6 @@ ComputeJacobianTerms< TFixedImage, TTransform >
   /** Get scales vector */
   const ScalesType & scales = this->m_Scales;
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator iter;
-  typename ImageSampleContainerType::ConstIterator begin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator end   = sampleContainer->End();
-  unsigned int samplenr = 0;
-
   /** Variables for nonzerojacobian indices and the Jacobian. */
   NumberOfParametersType sizejacind
     = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
@@ -226,98 +224,178 @@ ComputeJacobianTerms< TFixedImage, TTransform >
    * Loop over image and compute Jacobian.
    * Compute C = 1/n \sum_i J_i^T J_i
    * Possibly apply scaling afterwards.
+   *
+   * Consecutive valid samples with the same nonzero Jacobian indices form a
+   * segment, for which J_j^T J_j is summed before it is added to cov.
+   * The samples are processed in batches, in three parallel steps: compute
+   * the Jacobians, sum J_j^T J_j per segment, and add the segments to cov,
+   * where each thread owns a fixed set of rows of cov and bandcov. The last
+   * segment of a batch may continue in the next batch, so it is kept in
+   * jactjac and prevjacind. All sums are formed in the order of the samples,
+   * like in a single thread, so the result does not depend on the number of
+   * threads.
    */
-  jacind[ 0 ] = 0;
-  if( sizejacind > 1 ) { jacind[ 1 ] = 0; }
-  for( iter = begin; iter != end; ++iter )
+  const ThreadIdType  numberOfThreads = std::max< ThreadIdType >( 1, this->m_NumberOfThreads );
+  const SizeValueType batchSize       = numberOfThreads * Self::SamplesPerThreadPerBatch;
+  WorkStealingThreadPool::Pointer pool = WorkStealingThreadPool::GetInstance();
+
+  std::vector< JacobianType >               batchJacobians( batchSize, jacj );
+  std::vector< NonZeroJacobianIndicesType > batchJacobianIndices( batchSize, jacind );
+  std::vector< unsigned char >              batchIsValid( batchSize, 0 );
+  std::vector< SizeValueType >              validSamples;
+  std::vector< SizeValueType >              segmentStarts;
+  std::vector< CovarianceMatrixType >       segmentJacTJac;
+  bool                                      hasOpenSegment = false;
+
+  /** Add J^T J of a segment with nonzero Jacobian indices ind to the rows of cov owned by slot. */
+  auto addToCovariance = [ & ]( const CovarianceMatrixType & jtj,
+    const NonZeroJacobianIndicesType & ind, const ThreadIdType slot )
+    {
+      for( unsigned int pi = 0; pi < sizejacind; ++pi )
+      {
+        const unsigned int p = ind[ pi ];
+        if( p % numberOfThreads != slot ) { continue; }
+
+        for( unsigned int qi = 0; qi < sizejacind; ++qi )
+        {
+          const unsigned int q = ind[ qi ];
+          if( q >= p )
+          {
+            const double tempval = jtj( pi, qi ) / n;
+            if( std::abs( tempval ) > 1e-14 )
+            {
+              const unsigned int bandindex = bandcovMap[ q - p ];
+              if( bandindex < bandcovsize )
+              {
+                bandcov( p, bandindex ) += tempval;
+              }
+              else
+              {
+                cov( p, q ) += tempval;
+              }
+            }
+          }
+        } // qi
+      }   // pi
+    };
+
+  for( SizeValueType batchBegin = 0; batchBegin < nrofsamples; batchBegin += batchSize )
   {
-    /** Print progress 0-50%.
-     *progressObserver->UpdateAndPrintProgress( samplenr );*/
-    ++samplenr;
+    const SizeValueType batchCount = std::min( batchSize, nrofsamples - batchBegin );
 
-    /** Read fixed coordinates and get Jacobian J_j. */
-    const FixedImagePointType & point = ( *iter ).Value().m_ImageCoordinates;
-    this->m_Transform->GetJacobian( point, jacj, jacind  );
+    /** Read fixed coordinates and get Jacobian J_j, for all samples of the batch. */
+    pool->ParallelForChunks( numberOfThreads, batchCount, Self::SamplesPerThreadPerBatch,
+      [ & ]( ThreadIdType, SizeValueType chunkBegin, SizeValueType chunkEnd )
+      {
+        for( SizeValueType k = chunkBegin; k < chunkEnd; ++k )
+        {
+          const FixedImagePointType & point
+            = sampleContainer->GetElement( batchBegin + k ).m_ImageCoordinates;
+          this->m_Transform->GetJacobian( point, batchJacobians[ k ], batchJacobianIndices[ k ] );
 
-    /** Skip invalid Jacobians in the beginning, if any. */
-    if( sizejacind > 1 )
+          /** Skip invalid Jacobians in the beginning, if any. */
+          const NonZeroJacobianIndicesType & ind = batchJacobianIndices[ k ];
+          batchIsValid[ k ] = !( sizejacind > 1 && ind[ 0 ] == ind[ 1 ] );
+        }
+      } );
+
+    /** Determine the segments. The first one may continue the open segment. */
+    validSamples.clear();
+    segmentStarts.clear();
+    bool continuesOpenSegment = false;
+    for( SizeValueType k = 0; k < batchCount; ++k )
     {
-      if( jacind[ 0 ] == jacind[ 1 ] ) { continue; }
+      if( !batchIsValid[ k ] ) { continue; }
+
+      if( validSamples.empty() )
+      {
+        continuesOpenSegment = hasOpenSegment && batchJacobianIndices[ k ] == prevjacind;
+        segmentStarts.push_back( 0 );
+      }
+      else if( batchJacobianIndices[ k ] != batchJacobianIndices[ validSamples.back() ] )
+      {
+        segmentStarts.push_back( validSamples.size() );
+      }
+      validSamples.push_back( k );
     }
+    if( validSamples.empty() ) { continue; }
 
-    if( jacind == prevjacind )
+    const SizeValueType numberOfSegments = segmentStarts.size();
+    segmentStarts.push_back( validSamples.size() );
+    if( segmentJacTJac.size() < numberOfSegments )
     {
-      /** Update sum of J_j^T J_j. */
-      vnl_fastops::inc_X_by_AtA( jactjac, jacj );
+      segmentJacTJac.resize( numberOfSegments, jactjac );
     }
-    else
-    {
-      /** The following should only be done after the first sample. */
-      if( iter != begin )
+
+    /** The segment sums, stored in jactjac for a continued open segment. */
+    auto segmentSum = [ & ]( const SizeValueType s ) -> CovarianceMatrixType &
       {
-        /** Update covariance matrix. */
-        for( unsigned int pi = 0; pi < sizejacind; ++pi )
+        return ( s == 0 && continuesOpenSegment ) ? jactjac : segmentJacTJac[ s ];
+      };
+    auto segmentIndices = [ & ]( const SizeValueType s ) -> const NonZeroJacobianIndicesType &
+      {
+        return batchJacobianIndices[ validSamples[ segmentStarts[ s ] ] ];
+      };
+
+    /** Compute the sum of J_j^T J_j per segment. */
+    pool->ParallelForChunks( numberOfThreads, numberOfSegments, 1,
+      [ & ]( ThreadIdType, SizeValueType segmentBegin, SizeValueType segmentEnd )
+      {
+        for( SizeValueType s = segmentBegin; s < segmentEnd; ++s )
         {
-          const unsigned int p = prevjacind[ pi ];
-          for( unsigned int qi = 0; qi < sizejacind; ++qi )
+          CovarianceMatrixType & jtj = segmentSum( s );
+          for( SizeValueType v = segmentStarts[ s ]; v < segmentStarts[ s + 1 ]; ++v )
           {
-            const unsigned int q = prevjacind[ qi ];
-            if( q >= p )
+            const JacobianType & jac = batchJacobians[ validSamples[ v ] ];
+            if( v == segmentStarts[ s ] && !( s == 0 && continuesOpenSegment ) )
             {
-              const double tempval = jactjac( pi, qi ) / n;
-              if( std::abs( tempval ) > 1e-14 )
-              {
-                const unsigned int bandindex = bandcovMap[ q - p ];
-                if( bandindex < bandcovsize )
-                {
-                  bandcov( p, bandindex ) += tempval;
-                }
-                else
-                {
-                  cov( p, q ) += tempval;
-                }
-              }
+              /** Initialize jactjac by J_j^T J_j. */
+              vnl_fastops::AtA( jtj, jac );
             }
-          } // qi
-        }   // pi
-      }     // end if
+            else
+            {
+              /** Update sum of J_j^T J_j. */
+              vnl_fastops::inc_X_by_AtA( jtj, jac );
+            }
+          }
+        }
+      } );
 
-      /** Initialize jactjac by J_j^T J_j. */
-      vnl_fastops::AtA( jactjac, jacj );
+    /** Update covariance matrix with the completed segments: the open segment
+     * of the previous batch, if it ended, and all but the last segment of this batch.
+     */
+    const bool closesOpenSegment = hasOpenSegment && !continuesOpenSegment;
+    pool->ParallelForSlots( numberOfThreads, [ & ]( ThreadIdType slot )
+      {
+        if( closesOpenSegment )
+        {
+          addToCovariance( jactjac, prevjacind, slot );
+        }
+        for( SizeValueType s = 0; s + 1 < numberOfSegments; ++s )
+        {
+          addToCovariance( segmentSum( s ), segmentIndices( s ), slot );
+        }
+      } );
 
-      /** Remember nonzerojacobian indices. */
-      prevjacind = jacind;
-    } // end else
+    /** Remember the last segment, which may continue in the next batch. */
+    const SizeValueType lastSegment = numberOfSegments - 1;
+    if( !( lastSegment == 0 && continuesOpenSegment ) )
+    {
+      jactjac    = segmentJacTJac[ lastSegment ];
+      prevjacind = segmentIndices( lastSegment );
+    }
+    hasOpenSegment = true;
 
-  } // end iter loop: end computation of covariance matrix
+  } // end batch loop: end computation of covariance matrix
 
-  /** Update covariance matrix once again to include last jactjac updates
-   * \todo: a bit ugly that this loop is copied from above.
-   */
-  for( unsigned int pi = 0; pi < sizejacind; ++pi )
+  /** Update covariance matrix once again to include the last segment. */
+  if( hasOpenSegment )
   {
-    const unsigned int p = prevjacind[ pi ];
-    for( unsigned int qi = 0; qi < sizejacind; ++qi )
-    {
-      const unsigned int q = prevjacind[ qi ];
-      if( q >= p )
+    pool->ParallelForSlots( numberOfThreads, [ & ]( ThreadIdType slot )
       {
-        const double tempval = jactjac( pi, qi ) / n;
-        if( std::abs( tempval ) > 1e-14 )
-        {
-          const unsigned int bandindex = bandcovMap[ q - p ];
-          if( bandindex < bandcovsize )
-          {
-            bandcov( p, bandindex ) += tempval;
-          }
-          else
-          {
-            cov( p, q ) += tempval;
-          }
-        }
-      }
-    } // qi
-  }   // pi
+        addToCovariance( jactjac, prevjacind, slot );
+      } );
+  }
 
   /** Copy the bandmatrix into the sparse matrix and empty the bandcov matrix.
    * \todo: perhaps work further with this bandmatrix instead.
@@ -389,127 +467,178 @@ ComputeJacobianTerms< TFixedImage, TTransform >
    * Compute maxJJ and maxJCJ
    * \li maxJJ = max_j [ ||J_j||_F^2 + 2\sqrt{2} || J_j J_j^T ||_F ]
    * \li maxJCJ = max_j [ Tr( J_j C J_j^T ) + 2\sqrt{2} || J_j C J_j^T ||_F ]
+   *
+   * The samples are independent, so they are distributed over the threads.
+   * Each thread has its own temporaries and maxima.
    */
   maxJJ  = 0.0;
   maxJCJ = 0.0;
   const double sqrt2 = std::sqrt( static_cast< double >( 2.0 ) );
 
-  JacobianType                       jacjjacj( outdim, outdim );
-  JacobianType                       jacjcov( outdim, sizejacind );
-  DiagCovarianceMatrixType           diagcovsparse( sizejacind );
-  JacobianType                       jacjdiagcov( outdim, sizejacind );
-  JacobianType                       jacjdiagcovjacj( outdim, outdim );
-  JacobianType                       jacjcovjacj( outdim, outdim );
-  NonZeroJacobianIndicesExpandedType jacindExpanded( P );
-
-  samplenr = 0;
-  for( iter = begin; iter != end; ++iter )
+  typedef std::vector< std::pair< SizeValueType, unsigned int > > SortedJacobianIndicesType;
+  struct JacobianTermsPerThreadStruct
+  {
+    JacobianType               st_Jacobian;
+    NonZeroJacobianIndicesType st_JacobianIndices;
+    SortedJacobianIndicesType  st_SortedJacobianIndices;
+    JacobianType               st_JacobianJacobian;
+    JacobianType               st_JacobianCov;
+    DiagCovarianceMatrixType   st_DiagCovSparse;
+    JacobianType               st_JacobianDiagCov;
+    JacobianType               st_JacobianDiagCovJacobian;
+    JacobianType               st_JacobianCovJacobian;
+    double                     st_MaxJJ;
+    double                     st_MaxJCJ;
+  };
+  std::vector< JacobianTermsPerThreadStruct > perThreadVariables( numberOfThreads );
+  for( ThreadIdType t = 0; t < numberOfThreads; ++t )
   {
-    /** Read fixed coordinates and get Jacobian. */
-    const FixedImagePointType & point = ( *iter ).Value().m_ImageCoordinates;
-    this->m_Transform->GetJacobian( point, jacj, jacind  );
+    JacobianTermsPerThreadStruct & ptv = perThreadVariables[ t ];
+    ptv.st_Jacobian.set_size( outdim, sizejacind );
+    ptv.st_JacobianIndices.resize( sizejacind );
+    ptv.st_SortedJacobianIndices.resize( sizejacind );
+    ptv.st_JacobianJacobian.set_size( outdim, outdim );
+    ptv.st_JacobianCov.set_size( outdim, sizejacind );
+    ptv.st_DiagCovSparse.set_size( sizejacind );
+    ptv.st_JacobianDiagCov.set_size( outdim, sizejacind );
+    ptv.st_JacobianDiagCovJacobian.set_size( outdim, outdim );
+    ptv.st_JacobianCovJacobian.set_size( outdim, outdim );
+    ptv.st_MaxJJ  = 0.0;
+    ptv.st_MaxJCJ = 0.0;
+  }
 
-    /** Apply scales, if necessary. */
-    if( this->m_UseScales )
+  const SizeValueType chunkSize = std::max< SizeValueType >( 16,
+    nrofsamples / ( 8 * static_cast< SizeValueType >( numberOfThreads ) ) );
+  pool->ParallelForChunks( numberOfThreads, nrofsamples, chunkSize,
+    [ & ]( ThreadIdType slot, SizeValueType chunkBegin, SizeValueType chunkEnd )
     {
-      for( unsigned int pi = 0; pi < sizejacind; ++pi )
+      JacobianTermsPerThreadStruct & ptv             = perThreadVariables[ slot ];
+      JacobianType &                 jacjt           = ptv.st_Jacobian;
+      NonZeroJacobianIndicesType &   jacindt         = ptv.st_JacobianIndices;
+      SortedJacobianIndicesType &    sortedjacind    = ptv.st_SortedJacobianIndices;
+      JacobianType &                 jacjjacj        = ptv.st_JacobianJacobian;
+      JacobianType &                 jacjcov         = ptv.st_JacobianCov;
+      DiagCovarianceMatrixType &     diagcovsparse   = ptv.st_DiagCovSparse;
+      JacobianType &                 jacjdiagcov     = ptv.st_JacobianDiagCov;
+      JacobianType &                 jacjdiagcovjacj = ptv.st_JacobianDiagCovJacobian;
+      JacobianType &                 jacjcovjacj     = ptv.st_JacobianCovJacobian;
+
+      for( SizeValueType samplenr = chunkBegin; samplenr < chunkEnd; ++samplenr )
       {
-        const unsigned int p = jacind[ pi ];
-        jacj.scale_column( pi, 1.0 / scales[ p ] );
-      }
-    }
-
-    /** Compute 1st part of JJ: ||J_j||_F^2. */
-    double JJ_j = vnl_math_sqr( jacj.frobenius_norm() );
+        /** Read fixed coordinates and get Jacobian. */
+        const FixedImagePointType & point
+          = sampleContainer->GetElement( samplenr ).m_ImageCoordinates;
+        this->m_Transform->GetJacobian( point, jacjt, jacindt );
 
-    /** Compute 2nd part of JJ: 2\sqrt{2} || J_j J_j^T ||_F. */
-    vnl_fastops::ABt( jacjjacj, jacj, jacj );
-    JJ_j += 2.0 * sqrt2 * jacjjacj.frobenius_norm();
+        /** Apply scales, if necessary. */
+        if( this->m_UseScales )
+        {
+          for( unsigned int pi = 0; pi < sizejacind; ++pi )
+          {
+            const unsigned int p = jacindt[ pi ];
+            jacjt.scale_column( pi, 1.0 / scales[ p ] );
+          }
+        }
 
-    /** Max_j [JJ_j]. */
-    maxJJ = vnl_math_max( maxJJ, JJ_j );
+        /** Compute 1st part of JJ: ||J_j||_F^2. */
+        double JJ_j = vnl_math_sqr( jacjt.frobenius_norm() );
 
-    /** Compute JCJ_j. */
-    double JCJ_j = 0.0;
+        /** Compute 2nd part of JJ: 2\sqrt{2} || J_j J_j^T ||_F. */
+        vnl_fastops::ABt( jacjjacj, jacjt, jacjt );
+        JJ_j += 2.0 * sqrt2 * jacjjacj.frobenius_norm();
 
-    /** J_j C = jacjC. */
-    jacjcov.Fill( 0.0 );
+        /** Max_j [JJ_j]. */
+        ptv.st_MaxJJ = vnl_math_max( ptv.st_MaxJJ, JJ_j );
 
-    /** Store the nonzero Jacobian indices in a different format
-     * and create the sparse diagcov.
-     */
-    jacindExpanded.Fill( sizejacind );
-    for( unsigned int pi = 0; pi < sizejacind; ++pi )
-    {
-      const unsigned int p = jacind[ pi ];
-      jacindExpanded[ p ] = pi;
-      diagcovsparse[ pi ] = diagcov[ p ];
-    }
+        /** Compute JCJ_j. */
+        double JCJ_j = 0.0;
 
-    /** We below calculate jacjC = J_j cov^T, but later we will correct
-     * for this using:
-     * J C J' = J (cov + cov' - diag(cov')) J'.
-     * (NB: cov now still contains only the upper triangular part of C)
-     */
-    for( unsigned int pi = 0; pi < sizejacind; ++pi )
-    {
-      const unsigned int p = jacind[ pi ];
-      if( !cov.empty_row( p ) )
-      {
-        SparseRowType & covrowp = cov.get_row( p );
-        typename SparseRowType::iterator covrowpit;
+        /** J_j C = jacjC. */
+        jacjcov.Fill( 0.0 );
 
-        /** Loop over row p of the sparse cov matrix. */
-        for( covrowpit = covrowp.begin(); covrowpit != covrowp.end(); ++covrowpit )
+        /** Store the nonzero Jacobian indices sorted, together with their
+         * position, and create the sparse diagcov.
+         */
+        for( unsigned int pi = 0; pi < sizejacind; ++pi )
         {
-          const unsigned int q  = ( *covrowpit ).first;
-          const unsigned int qi = jacindExpanded[ q ];
+          const unsigned int p = jacindt[ pi ];
+          sortedjacind[ pi ] = std::make_pair( jacindt[ pi ], pi );
+          diagcovsparse[ pi ] = diagcov[ p ];
+        }
+        std::sort( sortedjacind.begin(), sortedjacind.end() );
 
-          if( qi < sizejacind )
+        /** We below calculate jacjC = J_j cov^T, but later we will correct
+         * for this using:
+         * J C J' = J (cov + cov' - diag(cov')) J'.
+         * (NB: cov now still contains only the upper triangular part of C)
+         */
+        for( unsigned int pi = 0; pi < sizejacind; ++pi )
+        {
+          const unsigned int p = jacindt[ pi ];
+          if( !cov.empty_row( p ) )
           {
-            /** If found, update the jacjC matrix. */
-            const CovarianceValueType covElement = ( *covrowpit ).second;
-            for( unsigned int dx = 0; dx < outdim; ++dx )
+            SparseRowType & covrowp = cov.get_row( p );
+            typename SparseRowType::iterator covrowpit;
+            typename SortedJacobianIndicesType::const_iterator sortedit = sortedjacind.begin();
+
+            /** Loop over row p of the sparse cov matrix. Its columns are
+             * sorted, so the matching Jacobian indices are found by a merge.
+             */
+            for( covrowpit = covrowp.begin(); covrowpit != covrowp.end(); ++covrowpit )
             {
-              jacjcov[ dx ][ pi ] += jacj[ dx ][ qi ] * covElement;
-            } //dx
-          }   // if qi < sizejacind
-        }     // for covrow
+              const unsigned int q = ( *covrowpit ).first;
+              while( sortedit != sortedjacind.end() && sortedit->first < q ) { ++sortedit; }
+              if( sortedit == sortedjacind.end() ) { break; }
+              if( sortedit->first != q ) { continue; }
+
+              /** A repeated index refers to its last position in jacind. */
+              typename SortedJacobianIndicesType::const_iterator lastit = sortedit;
+              while( lastit + 1 != sortedjacind.end() && ( lastit + 1 )->first == q ) { ++lastit; }
+              const unsigned int qi = lastit->second;
+
+              /** If found, update the jacjC matrix. */
+              const CovarianceValueType covElement = ( *covrowpit ).second;
+              for( unsigned int dx = 0; dx < outdim; ++dx )
+              {
+                jacjcov[ dx ][ pi ] += jacjt[ dx ][ qi ] * covElement;
+              } //dx
+            }   // for covrow
 
-      } // if not empty row
-    }   // pi
+          } // if not empty row
+        }   // pi
 
-    /** J_j C J_j^T  = jacjCjacj.
-     * But note that we actually compute J_j cov' J_j^T
-     */
-    vnl_fastops::ABt( jacjcovjacj, jacjcov, jacj );
+        /** J_j C J_j^T  = jacjCjacj.
+         * But note that we actually compute J_j cov' J_j^T
+         */
+        vnl_fastops::ABt( jacjcovjacj, jacjcov, jacjt );
 
-    /** jacjCjacj = jacjCjacj+ jacjCjacj' - jacjdiagcovjacj */
-    jacjdiagcov = jacj * diagcovsparse;
-    vnl_fastops::ABt( jacjdiagcovjacj, jacjdiagcov, jacj );
-    jacjcovjacj += jacjcovjacj.transpose();
-    jacjcovjacj -= jacjdiagcovjacj;
+        /** jacjCjacj = jacjCjacj+ jacjCjacj' - jacjdiagcovjacj */
+        jacjdiagcov = jacjt * diagcovsparse;
+        vnl_fastops::ABt( jacjdiagcovjacj, jacjdiagcov, jacjt );
+        jacjcovjacj += jacjcovjacj.transpose();
+        jacjcovjacj -= jacjdiagcovjacj;
 
-    /** Compute 1st part of JCJ: Tr( J_j C J_j^T ). */
-    for( unsigned int d = 0; d < outdim; ++d )
-    {
-      JCJ_j += jacjcovjacj[ d ][ d ];
-    }
-
-    /** Compute 2nd part of JCJ_j: 2 \sqrt{2} || J_j C J_j^T ||_F. */
-    JCJ_j += 2.0 * sqrt2 * jacjcovjacj.frobenius_norm();
+        /** Compute 1st part of JCJ: Tr( J_j C J_j^T ). */
+        for( unsigned int d = 0; d < outdim; ++d )
+        {
+          JCJ_j += jacjcovjacj[ d ][ d ];
+        }
 
-    /** Max_j [JCJ_j]. */
-    maxJCJ = vnl_math_max( maxJCJ, JCJ_j );
+        /** Compute 2nd part of JCJ_j: 2 \sqrt{2} || J_j C J_j^T ||_F. */
+        JCJ_j += 2.0 * sqrt2 * jacjcovjacj.frobenius_norm();
 
-    /** Show progress 50-100%. */
-    //progressObserver->UpdateAndPrintProgress( samplenr + nrofsamples );
-    ++samplenr;
+        /** Max_j [JCJ_j]. */
+        ptv.st_MaxJCJ = vnl_math_max( ptv.st_MaxJCJ, JCJ_j );
 
-  } // end loop over sample container
+      } // end loop over the samples of this chunk
+    } );
 
-  /** Finalize progress information. */
-  //progressObserver->PrintProgress( 1.0 );
+  /** Gather the maxima of all threads. */
+  for( ThreadIdType t = 0; t < numberOfThreads; ++t )
+  {
+    maxJJ  = vnl_math_max( maxJJ, perThreadVariables[ t ].st_MaxJJ );
+    maxJCJ = vnl_math_max( maxJCJ, perThreadVariables[ t ].st_MaxJCJ );
+  }
 
 } // end Compute()
 
@@ -148,6 +148,9 @@ private:
   ComputePreconditionerUsingDisplacementDistribution( const Self & ); // purposely not implemented
   void operator=( const Self & );                  // purposely not implemented
 
+  /** The number of samples per thread in a batch of Compute(). */
+  itkStaticConstMacro( SamplesPerThreadPerBatch, unsigned int, 64 );
+
 };
 
 } // end namespace itk
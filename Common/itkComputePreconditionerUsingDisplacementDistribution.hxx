@@ -21,6 +21,9 @@
 #include "itkComputePreconditionerUsingDisplacementDistribution.h"
 
 #include "vnl/vnl_math.h"
+#include "itkWorkStealingThreadPool.h"
+
+#include <algorithm>
 
 #include "itkImageScanlineIterator.h"
 #include "itkImageSliceIteratorWithIndex.h"
@@ -364,162 +367,222 @@ ComputePreconditionerUsingDisplacementDistribution< TFixedImage, TTransform >
   typename TransformType::Pointer transform = this->m_Transform;
   const unsigned int outdim = this->m_Transform->GetOutputSpaceDimension();
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator iter;
-  typename ImageSampleContainerType::ConstIterator begin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator end   = sampleContainer->End();
+  /** The samples are processed in batches. Per batch, the Jacobians and the
+   * displacements per sample are computed in parallel, and then added to the
+   * preconditioner in parallel, where each thread owns a fixed set of
+   * parameters. The sums are formed in the order of the samples, so the
+   * result does not depend on the number of threads.
+   */
+  const ThreadIdType numberOfThreads = this->m_UseMultiThread
+    ? std::max< ThreadIdType >( 1, this->m_Threader->GetNumberOfThreads() ) : 1;
+  const SizeValueType batchSize = numberOfThreads * Self::SamplesPerThreadPerBatch;
+  WorkStealingThreadPool::Pointer pool = WorkStealingThreadPool::GetInstance();
 
   /** Variables for nonzerojacobian indices and the Jacobian. */
   const SizeValueType sizejacind = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
-  JacobianType jacj( outdim, sizejacind );
-  jacj.Fill( 0.0 );
-  NonZeroJacobianIndicesType jacind( sizejacind );
+  std::vector< NonZeroJacobianIndicesType > batchJacobianIndices(
+    batchSize, NonZeroJacobianIndicesType( sizejacind ) );
+  std::vector< double > batchDisplacements( batchSize * sizejacind, 0.0 );
 
-  /** Declare temporary variables. Not needed for all methods. check later */
-  DerivativeType jacj_g( outdim );
-  jacj_g.Fill( 0.0 );
-  JacobianType          jacjjacj( outdim, outdim );
+  /** Declare temporary variables, per thread. Not needed for all methods. check later */
+  struct PreconditionerPerThreadStruct
+  {
+    JacobianType   st_Jacobian;
+    JacobianType   st_JacobianJacobian;
+    DerivativeType st_JacobianGradient;
+    double         st_MaxJJ;
+  };
+  std::vector< PreconditionerPerThreadStruct > perThreadVariables( numberOfThreads );
+  for( ThreadIdType t = 0; t < numberOfThreads; ++t )
+  {
+    perThreadVariables[ t ].st_Jacobian.SetSize( outdim, sizejacind );
+    perThreadVariables[ t ].st_Jacobian.Fill( 0.0 );
+    perThreadVariables[ t ].st_JacobianJacobian.SetSize( outdim, outdim );
+    perThreadVariables[ t ].st_JacobianGradient.SetSize( outdim );
+    perThreadVariables[ t ].st_JacobianGradient.Fill( 0.0 );
+    perThreadVariables[ t ].st_MaxJJ = 0.0;
+  }
   const double          sqrt2 = std::sqrt( static_cast< double >( 2.0 ) );
   std::vector< double > localStepSizeSquared( P, 0.0 );
   ParametersType binCount( P );
   binCount.Fill( 0.0 );
 
-  /** Loop over all voxels in the sample container. */
-  for( iter = begin; iter != end; ++iter )
+  /** Loop over all voxels in the sample container, in batches. */
+  for( SizeValueType batchBegin = 0; batchBegin < nrofsamples; batchBegin += batchSize )
   {
-    /** Read fixed coordinates and get Jacobian. */
-    const FixedImagePointType & point = ( *iter ).Value().m_ImageCoordinates;
-    this->m_Transform->GetJacobian( point, jacj, jacind );
-
-    /** Compute 1st part of JJ: ||J_j||_F^2. */
-    double JJ_j = vnl_math_sqr( jacj.frobenius_norm() );
-
-    /** Compute 2nd part of JJ: 2\sqrt{2} || J_j J_j^T ||_F. */
-    vnl_fastops::ABt( jacjjacj, jacj, jacj );
-    JJ_j += 2.0 * sqrt2 * jacjjacj.frobenius_norm();
+    const SizeValueType batchCount = std::min( batchSize, nrofsamples - batchBegin );
 
-    /** Max_j [JJ_j]. */
-    maxJJ = vnl_math_max( maxJJ, JJ_j );
-
-    double displacement2_j = 0.0;
-    if( transformIsBSpline )
-    {
-      for( unsigned int i = 0; i < outdim; ++i )
+    pool->ParallelForChunks( numberOfThreads, batchCount, Self::SamplesPerThreadPerBatch,
+      [ & ]( ThreadIdType slot, SizeValueType chunkBegin, SizeValueType chunkEnd )
       {
-        double temp = 0.0;
-        for( unsigned int j = 0; j < sizejacind; ++j )
+        PreconditionerPerThreadStruct & ptv      = perThreadVariables[ slot ];
+        JacobianType &                  jacj     = ptv.st_Jacobian;
+        JacobianType &                  jacjjacj = ptv.st_JacobianJacobian;
+        DerivativeType &                jacj_g   = ptv.st_JacobianGradient;
+
+        for( SizeValueType k = chunkBegin; k < chunkEnd; ++k )
         {
-          int pj = jacind[ j ];
-          temp += jacj( i, j ) * exactgradient( pj );
-        }
+          /** Read fixed coordinates and get Jacobian. */
+          NonZeroJacobianIndicesType & jacind = batchJacobianIndices[ k ];
+          const FixedImagePointType &  point
+            = sampleContainer->GetElement( batchBegin + k ).m_ImageCoordinates;
+          this->m_Transform->GetJacobian( point, jacj, jacind );
 
-        // Use the absolute value
-        jacj_g( i ) = vnl_math_abs( temp );
-      }
-      displacement2_j = jacj_g.magnitude();
-    }
+          /** Compute 1st part of JJ: ||J_j||_F^2. */
+          double JJ_j = vnl_math_sqr( jacj.frobenius_norm() );
 
-    /** Update all entries of the pre-conditioner. */
-    for( unsigned int j = 0; j < sizejacind; ++j )
-    {
-      const unsigned int pj = jacind[ j ];
-      double displacement_j = 0.0;
-      double jacj_current = 0.0;
-      for( unsigned int i = 0; i < outdim; ++i )
-      {
-        jacj_current += vnl_math_abs( jacj( i, j ) );
-      }
-      displacement_j = vnl_math_abs( jacj_current * exactgradient( pj ) );
+          /** Compute 2nd part of JJ: 2\sqrt{2} || J_j J_j^T ||_F. */
+          vnl_fastops::ABt( jacjjacj, jacj, jacj );
+          JJ_j += 2.0 * sqrt2 * jacjjacj.frobenius_norm();
 
-      if( transformIsBSpline )
-      {
-        displacement_j = displacement_j * this->m_RegularizationKappa
-          + ( 1.0 - this->m_RegularizationKappa ) * displacement2_j;
-      }
-      else
-      { // else for affine and rigid
-        double diff_jacobian = 0;
-        double weight = 0;
-        double sum_displacement = 0;
-        double sum_weight = 0;
-        double weight_sigma = 0.01;
-        double maxdiff = 0.0;
-        double mindiff = 0.0;
-        bool   mindiffCheck = true;
-
-        /** Obtain the maximum and minimum difference of absolute jacobian. */
-        for( unsigned int k = 0; k < sizejacind; ++k )
-        {
-          if( k != j )
+          /** Max_j [JJ_j]. */
+          ptv.st_MaxJJ = vnl_math_max( ptv.st_MaxJJ, JJ_j );
+
+          double displacement2_j = 0.0;
+          if( transformIsBSpline )
           {
-            double jacj_k = 0.0;
             for( unsigned int i = 0; i < outdim; ++i )
             {
-              jacj_k += vnl_math_abs( jacj( i, k ) );
-            }
-            diff_jacobian = vnl_math_abs( jacj_k - jacj_current );
-            if( diff_jacobian > 0 && mindiffCheck )
-            {
-              mindiff = diff_jacobian;
-              mindiffCheck = false;
+              double temp = 0.0;
+              for( unsigned int j = 0; j < sizejacind; ++j )
+              {
+                int pj = jacind[ j ];
+                temp += jacj( i, j ) * exactgradient( pj );
+              }
+
+              // Use the absolute value
+              jacj_g( i ) = vnl_math_abs( temp );
             }
-            if( diff_jacobian > 0 && !mindiffCheck )
-            {
-              mindiff = diff_jacobian < mindiff ? diff_jacobian : mindiff;
-            }
-            maxdiff = diff_jacobian > maxdiff ? diff_jacobian : maxdiff;
-          } // end if
-        } // end for
-
-        if( maxdiff > 0 )
-        {
-          weight_sigma = mindiff / maxdiff;
-        }
-        else
-        {
-          weight_sigma = 1e-9;
-        }
+            displacement2_j = jacj_g.magnitude();
+          }
 
-        /** To regularize the other entries using the neighborhood information. */
-        for( unsigned int k = 0; k < sizejacind; ++k )
-        {
-          const unsigned int pk = jacind[ k ];
-          if( k != j )
+          /** Compute the displacements of all entries of the pre-conditioner. */
+          for( unsigned int j = 0; j < sizejacind; ++j )
           {
-            double jacj_k = 0.0;
+            const unsigned int pj = jacind[ j ];
+            double displacement_j = 0.0;
+            double jacj_current = 0.0;
             for( unsigned int i = 0; i < outdim; ++i )
             {
-              jacj_k += vnl_math_abs( jacj( i, k ) );
+              jacj_current += vnl_math_abs( jacj( i, j ) );
             }
+            displacement_j = vnl_math_abs( jacj_current * exactgradient( pj ) );
 
-            diff_jacobian = vnl_math_abs( jacj_k - jacj_current );
-            weight = std::exp( -( vnl_math_sqr( diff_jacobian / weight_sigma ) / 2.0 ) );
-
-            sum_displacement += vnl_math_abs( jacj_k * exactgradient( pk ) ) * weight;
-            sum_weight += weight;
-          } // end if
-        } // end for loop regularization
+            if( transformIsBSpline )
+            {
+              displacement_j = displacement_j * this->m_RegularizationKappa
+                + ( 1.0 - this->m_RegularizationKappa ) * displacement2_j;
+            }
+            else
+            { // else for affine and rigid
+              double diff_jacobian = 0;
+              double weight = 0;
+              double sum_displacement = 0;
+              double sum_weight = 0;
+              double weight_sigma = 0.01;
+              double maxdiff = 0.0;
+              double mindiff = 0.0;
+              bool   mindiffCheck = true;
+
+              /** Obtain the maximum and minimum difference of absolute jacobian. */
+              for( unsigned int k2 = 0; k2 < sizejacind; ++k2 )
+              {
+                if( k2 != j )
+                {
+                  double jacj_k = 0.0;
+                  for( unsigned int i = 0; i < outdim; ++i )
+                  {
+                    jacj_k += vnl_math_abs( jacj( i, k2 ) );
+                  }
+                  diff_jacobian = vnl_math_abs( jacj_k - jacj_current );
+                  if( diff_jacobian > 0 && mindiffCheck )
+                  {
+                    mindiff = diff_jacobian;
+                    mindiffCheck = false;
+                  }
+                  if( diff_jacobian > 0 && !mindiffCheck )
+                  {
+                    mindiff = diff_jacobian < mindiff ? diff_jacobian : mindiff;
+                  }
+                  maxdiff = diff_jacobian > maxdiff ? diff_jacobian : maxdiff;
+                } // end if
+              } // end for
+
+              if( maxdiff > 0 )
+              {
+                weight_sigma = mindiff / maxdiff;
+              }
+              else
+              {
+                weight_sigma = 1e-9;
+              }
+
+              /** To regularize the other entries using the neighborhood information. */
+              for( unsigned int k2 = 0; k2 < sizejacind; ++k2 )
+              {
+                const unsigned int pk = jacind[ k2 ];
+                if( k2 != j )
+                {
+                  double jacj_k = 0.0;
+                  for( unsigned int i = 0; i < outdim; ++i )
+                  {
+                    jacj_k += vnl_math_abs( jacj( i, k2 ) );
+                  }
+
+                  diff_jacobian = vnl_math_abs( jacj_k - jacj_current );
+                  weight = std::exp( -( vnl_math_sqr( diff_jacobian / weight_sigma ) / 2.0 ) );
+
+                  sum_displacement += vnl_math_abs( jacj_k * exactgradient( pk ) ) * weight;
+                  sum_weight += weight;
+                } // end if
+              } // end for loop regularization
+
+              if( sum_weight > 0.0 )
+              {
+                sum_displacement /= sum_weight;
+
+                /** regularize. */
+                displacement_j = displacement_j * this->m_RegularizationKappa
+                  + ( 1.0 - this->m_RegularizationKappa ) * sum_displacement;
+              }
+            } // end else for affine and rigid
+
+            batchDisplacements[ k * sizejacind + j ] = displacement_j;
+          }
+        } // end loop over the samples of this chunk
+      } );
 
-        if( sum_weight > 0.0 )
+    /** Update all entries of the pre-conditioner with the displacement due
+     * to a change in this parameter.
+     * localStepSize keeps track of the mean displacement.
+     * localStepSizeSquared keeps track of the standard deviation.
+     */
+    pool->ParallelForSlots( numberOfThreads, [ & ]( ThreadIdType slot )
+      {
+        for( SizeValueType k = 0; k < batchCount; ++k )
         {
-          sum_displacement /= sum_weight;
+          const NonZeroJacobianIndicesType & jacind = batchJacobianIndices[ k ];
+          for( unsigned int j = 0; j < sizejacind; ++j )
+          {
+            const unsigned int pj = jacind[ j ];
+            if( pj % numberOfThreads != slot ) { continue; }
 
-          /** regularize. */
-          displacement_j = displacement_j * this->m_RegularizationKappa
-            + ( 1.0 - this->m_RegularizationKappa ) * sum_displacement;
+            const double displacement_j = batchDisplacements[ k * sizejacind + j ];
+            preconditioner[ pj ] += displacement_j;
+            localStepSizeSquared[ pj ] += displacement_j * displacement_j;
+            binCount[ pj ] += 1.0;
+          }
         }
-      } // end else for affine and rigid
+      } );
 
-      /** Compute the displacement due to a change in this parameter. */
-      /** localStepSize keeps track of the mean displacement.
-        * localStepSizeSquared keeps track of the standard deviation.
-        */
-      preconditioner[ pj ] += displacement_j;
-      localStepSizeSquared[ pj ] += displacement_j * displacement_j;
-      binCount[ pj ] += 1.0;
-    }
   } // end loop over sample container
 
+  /** Gather the maxJJ values from all threads. */
+  for( ThreadIdType t = 0; t < numberOfThreads; ++t )
+  {
+    maxJJ = vnl_math_max( maxJJ, perThreadVariables[ t ].st_MaxJJ );
+  }
+
 
   /** Compute the mean local step sizes and apply the 2 sigma rule. */
   double maxEigenvalue = -1e+9;
@@ -609,47 +672,81 @@ ComputePreconditionerUsingDisplacementDistribution< TFixedImage, TTransform >
   typename TransformType::Pointer transform = this->m_Transform;
   const unsigned int outdim = this->m_Transform->GetOutputSpaceDimension();
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator iter;
-  typename ImageSampleContainerType::ConstIterator begin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
+  /** The samples are processed in batches: the Jacobians are computed in
+   * parallel, and then added to the preconditioner in parallel, where each
+   * thread owns a fixed set of parameters. As in Compute(), the result does
+   * not depend on the number of threads.
+   */
+  const ThreadIdType numberOfThreads = this->m_UseMultiThread
+    ? std::max< ThreadIdType >( 1, this->m_Threader->GetNumberOfThreads() ) : 1;
+  const SizeValueType batchSize = numberOfThreads * Self::SamplesPerThreadPerBatch;
+  WorkStealingThreadPool::Pointer pool = WorkStealingThreadPool::GetInstance();
 
   /** Variables for nonzerojacobian indices and the Jacobian. */
   const SizeValueType sizejacind = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
   JacobianType jacj( outdim, sizejacind );
   jacj.Fill( 0.0 );
-  JacobianType          jacjjacj( outdim, outdim );
-  const double          sqrt2 = std::sqrt( static_cast< double >( 2.0 ) );
-  NonZeroJacobianIndicesType jacind( sizejacind );
+  std::vector< JacobianType >               batchJacobians( batchSize, jacj );
+  std::vector< NonZeroJacobianIndicesType > batchJacobianIndices(
+    batchSize, NonZeroJacobianIndicesType( sizejacind ) );
+  std::vector< JacobianType > jacjjacj( numberOfThreads, JacobianType( outdim, outdim ) );
+  std::vector< double >       maxJJPerThread( numberOfThreads, 0.0 );
+  const double                sqrt2 = std::sqrt( static_cast< double >( 2.0 ) );
   ParametersType binCount( P );
   binCount.Fill( 0.0 );
 
-  /** Loop over all voxels in the sample container. */
-  for( iter = begin; iter != end; ++iter )
+  /** Loop over all voxels in the sample container, in batches. */
+  for( SizeValueType batchBegin = 0; batchBegin < nrofsamples; batchBegin += batchSize )
   {
-    /** Read fixed coordinates and get Jacobian. */
-    const FixedImagePointType & point = ( *iter ).Value().m_ImageCoordinates;
-    this->m_Transform->GetJacobian( point, jacj, jacind );
+    const SizeValueType batchCount = std::min( batchSize, nrofsamples - batchBegin );
 
-    /** Compute 1st part of JJ: ||J_j||_F^2. */
-    double JJ_j = vnl_math_sqr( jacj.frobenius_norm() );
+    pool->ParallelForChunks( numberOfThreads, batchCount, Self::SamplesPerThreadPerBatch,
+      [ & ]( ThreadIdType slot, SizeValueType chunkBegin, SizeValueType chunkEnd )
+      {
+        for( SizeValueType k = chunkBegin; k < chunkEnd; ++k )
+        {
+          /** Read fixed coordinates and get Jacobian. */
+          const FixedImagePointType & point
+            = sampleContainer->GetElement( batchBegin + k ).m_ImageCoordinates;
+          this->m_Transform->GetJacobian( point, batchJacobians[ k ], batchJacobianIndices[ k ] );
 
-    /** Compute 2nd part of JJ: 2\sqrt{2} || J_j J_j^T ||_F. */
-    vnl_fastops::ABt( jacjjacj, jacj, jacj );
-    JJ_j += 2.0 * sqrt2 * jacjjacj.frobenius_norm();
+          /** Compute 1st part of JJ: ||J_j||_F^2. */
+          double JJ_j = vnl_math_sqr( batchJacobians[ k ].frobenius_norm() );
 
-    /** Max_j [JJ_j]. */
-    maxJJ = vnl_math_max( maxJJ, JJ_j );
+          /** Compute 2nd part of JJ: 2\sqrt{2} || J_j J_j^T ||_F. */
+          vnl_fastops::ABt( jacjjacj[ slot ], batchJacobians[ k ], batchJacobians[ k ] );
+          JJ_j += 2.0 * sqrt2 * jacjjacj[ slot ].frobenius_norm();
 
-    for( unsigned int i = 0; i < outdim; ++i )
-    {
-      for( unsigned int j = 0; j < sizejacind; ++j )
+          /** Max_j [JJ_j]. */
+          maxJJPerThread[ slot ] = vnl_math_max( maxJJPerThread[ slot ], JJ_j );
+        }
+      } );
+
+    pool->ParallelForSlots( numberOfThreads, [ & ]( ThreadIdType slot )
       {
-        const unsigned int pj = jacind[ j ];
-        preconditioner[ pj ] += vnl_math_sqr( jacj( i, j ) );
-        binCount[ pj ] += 1;
-      }
-    }
+        for( SizeValueType k = 0; k < batchCount; ++k )
+        {
+          const JacobianType &               jac    = batchJacobians[ k ];
+          const NonZeroJacobianIndicesType & jacind = batchJacobianIndices[ k ];
+          for( unsigned int i = 0; i < outdim; ++i )
+          {
+            for( unsigned int j = 0; j < sizejacind; ++j )
+            {
+              const unsigned int pj = jacind[ j ];
+              if( pj % numberOfThreads != slot ) { continue; }
+
+              preconditioner[ pj ] += vnl_math_sqr( jac( i, j ) );
+              binCount[ pj ] += 1;
+            }
+          }
+        }
+      } );
+  }
+
+  /** Gather the maxJJ values from all threads. */
+  for( ThreadIdType t = 0; t < numberOfThreads; ++t )
+  {
+    maxJJ = vnl_math_max( maxJJ, maxJJPerThread[ t ] );
   }
 
   double maxEigenvalue = -1e+9;
@@ -98,6 +98,25 @@ namespace itk
  * compute only single level of the pyramid via SetCurrentLevel() and
  * SetComputeOnlyForCurrentLevel() methods.
  *
+ * With SetComputeLevelsCascaded() the levels are computed from the finest to
+ * the coarsest, and a level is derived from the next finer level instead of
+ * from the input, whenever the schedules permit: the sigmas and shrink factors
+ * may not decrease, the finer level must be smoothed with a sigma of at least
+ * half its shrink factor (in voxels) wherever it is shrunk, and the shrinker
+ * needs integer ratios of the shrink factors. The extra smoothing is then
+ * sqrt( sigma_level^2 - sigma_finer^2 ), so the coarse levels only smooth
+ * small images. The result differs slightly from direct computation, near
+ * the image boundaries in particular. The finest level shares the buffer of
+ * the input when it is neither smoothed nor shrunk. Levels that are coarser
+ * than the current level are released, and not computed anymore.
+ *
+ * This mode only saves computation time, not memory. The coarsest level is
+ * used first, and it is derived from all finer levels, so all levels are
+ * computed at once and kept until they are used. The peak memory is that of
+ * the default mode, minus the finest level if it shares the input buffer, and
+ * more than that of SetComputeOnlyForCurrentLevel(), which is ignored in this
+ * mode, with a warning.
+ *
  * \author Denis P. Shamonin and Marius Staring. Division of Image Processing,
  * Department of Radiology, Leiden, The Netherlands
  *
@@ -220,6 +239,12 @@ public:
   itkGetConstMacro( ComputeOnlyForCurrentLevel, bool );
   itkBooleanMacro( ComputeOnlyForCurrentLevel );
 
+  /** Set a control on whether the levels are derived from each other. */
+  virtual void SetComputeLevelsCascaded( const bool _arg );
+
+  itkGetConstMacro( ComputeLevelsCascaded, bool );
+  itkBooleanMacro( ComputeLevelsCascaded );
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro( SameDimensionCheck,
@@ -265,6 +290,7 @@ protected:
   SmoothingScheduleType m_SmoothingSchedule;
   unsigned int          m_CurrentLevel;
   bool                  m_ComputeOnlyForCurrentLevel;
+  bool                  m_ComputeLevelsCascaded;
   bool                  m_SmoothingScheduleDefined;
 
 private:
@@ -284,6 +310,38 @@ private:
   typedef ImageToImageFilter< InputImageType, OutputImageType >
     ImageToImageFilterDifferentTypes;
 
+  /** Typedef for the smoother of a level that is derived from a finer level. */
+  typedef SmoothingRecursiveGaussianImageFilter<
+    OutputImageType, OutputImageType > CascadeSmootherType;
+
+  /** Compute the output of the level from the input. */
+  void GenerateLevelFromInput( const unsigned int level,
+    const InputImageConstPointer & input,
+    typename SmootherType::Pointer & smoother,
+    typename ImageToImageFilterSameTypes::Pointer & rescaleSameTypes,
+    typename ImageToImageFilterDifferentTypes::Pointer & rescaleDifferentTypes );
+
+  /** Compute the output of the level from the output of the next finer level. */
+  void GenerateLevelFromFinerLevel( const unsigned int level,
+    typename CascadeSmootherType::Pointer & smoother,
+    typename ImageToImageFilterSameTypes::Pointer & rescaler );
+
+  /** Generate the output data, with the levels derived from each other. */
+  void GenerateDataCascaded( void );
+
+  /** Returns true if the schedules permit to derive the level from the next
+   * finer level.
+   */
+  bool CanComputeFromFinerLevel( const unsigned int level ) const;
+
+  /** Returns true if the level is released by the cascaded computation. */
+  bool IsLevelReleased( const unsigned int level ) const;
+
+  /** Release the data of the level, keeping an empty buffered region that
+   * matches the requested region, so that the pipeline does not execute again.
+   */
+  void ReleaseLevel( const unsigned int level );
+
   /** Smooth image at current level. Returns true if performed.
    * This method does not perform execution.
    */
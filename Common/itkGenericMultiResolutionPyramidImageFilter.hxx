@@ -61,6 +61,7 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
 {
   this->m_CurrentLevel               = 0;
   this->m_ComputeOnlyForCurrentLevel = false;
+  this->m_ComputeLevelsCascaded      = false;
   SmoothingScheduleType temp( this->GetNumberOfLevels(), ImageDimension );
   temp.Fill( NumericTraits< ScalarRealType >::ZeroValue() );
   this->m_SmoothingSchedule        = temp;
@@ -110,8 +111,10 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
     }
     this->ReleaseOutputs();
 
-    /** Only set the modified flag for this filter if the output is computed per level. */
-    if( this->m_ComputeOnlyForCurrentLevel )
+    /** Only set the modified flag for this filter if the output is computed per level.
+     * The cascaded computation has computed all levels that are still needed.
+     */
+    if( this->m_ComputeOnlyForCurrentLevel && !this->m_ComputeLevelsCascaded )
     {
       this->Modified();
     }
@@ -138,6 +141,24 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
 } // end SetComputeOnlyForCurrentLevel()
 
 
+/**
+ * ******************* SetComputeLevelsCascaded ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+void
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::SetComputeLevelsCascaded( const bool _arg )
+{
+  itkDebugMacro( "setting ComputeLevelsCascaded to " << _arg );
+  if( this->m_ComputeLevelsCascaded != _arg )
+  {
+    this->m_ComputeLevelsCascaded = _arg;
+    this->Modified();
+  }
+} // end SetComputeLevelsCascaded()
+
+
 /**
  * ******************* SetSchedule ***********************
  */
@@ -295,6 +316,13 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
   // Pipeline also takes care of memory allocation for N'th output if
   // SetComputeOnlyForCurrentLevel has been set to true.
 
+  // The levels may be derived from each other
+  if( this->m_ComputeLevelsCascaded )
+  {
+    this->GenerateDataCascaded();
+    return;
+  }
+
   // Get the input and output pointers
   InputImageConstPointer input = this->GetInput();
 
@@ -343,45 +371,282 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
 
     if( this->ComputeForCurrentLevel( level ) )
     {
-      // Allocate memory for each output
+      this->GenerateLevelFromInput( level, input,
+        smoother, rescaleSameTypes, rescaleDifferentTypes );
+    }
+  } // end for ilevel
+} // end GenerateData()
+
+
+/**
+ * ******************* GenerateLevelFromInput ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+void
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::GenerateLevelFromInput( const unsigned int level,
+  const InputImageConstPointer & input,
+  typename SmootherType::Pointer & smoother,
+  typename ImageToImageFilterSameTypes::Pointer & rescaleSameTypes,
+  typename ImageToImageFilterDifferentTypes::Pointer & rescaleDifferentTypes )
+{
+  // Allocate memory for each output
+  OutputImagePointer outputPtr = this->GetOutput( level );
+  outputPtr->SetBufferedRegion( outputPtr->GetRequestedRegion() );
+  outputPtr->Allocate();
+
+  // Setup the smoother
+  const bool smootherIsUsed = this->SetupSmoother( level, smoother, input );
+
+  // Setup the shrinker or resampler
+  const int shrinkerOrResamplerIsUsed = this->SetupShrinkerOrResampler( level,
+    smoother, smootherIsUsed, input, outputPtr,
+    rescaleSameTypes, rescaleDifferentTypes );
+
+  // Update the pipeline and graft or copy results to this filters output
+  if( shrinkerOrResamplerIsUsed == 0 && smootherIsUsed )
+  {
+    UpdateAndGraft< Self, SmootherType, OutputImageType >(
+      this, smoother, outputPtr, level );
+  }
+  else if( shrinkerOrResamplerIsUsed == 0 )
+  {
+    ImageAlgorithm::Copy( input.GetPointer(), outputPtr.GetPointer(),
+      input->GetLargestPossibleRegion(), outputPtr->GetLargestPossibleRegion() );
+  }
+  else if( shrinkerOrResamplerIsUsed == 1 )
+  {
+    UpdateAndGraft< Self, ImageToImageFilterSameTypes, OutputImageType >(
+      this, rescaleSameTypes, outputPtr, level );
+  }
+  else if( shrinkerOrResamplerIsUsed == 2 )
+  {
+    UpdateAndGraft< Self, ImageToImageFilterDifferentTypes, OutputImageType >(
+      this, rescaleDifferentTypes, outputPtr, level );
+  }
+  // no else needed
+
+} // end GenerateLevelFromInput()
+
+
+/**
+ * ******************* GenerateDataCascaded ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+void
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::GenerateDataCascaded( void )
+{
+  InputImageConstPointer input = this->GetInput();
+
+  // All needed levels are computed at once, so computing only the current
+  // level is not possible in this mode
+  if( this->m_ComputeOnlyForCurrentLevel )
+  {
+    itkWarningMacro( << "ComputeOnlyForCurrentLevel is ignored, because ComputeLevelsCascaded "
+                     << "is set: all levels up to the current one are computed at once." );
+  }
+
+  // First check if smoothing schedule has been set
+  if( !this->m_SmoothingScheduleDefined )
+  {
+    this->SetSmoothingScheduleToDefault();
+  }
+
+  // The levels that are coarser than the current level are not needed anymore
+  for( unsigned int level = 0; level < this->m_CurrentLevel; ++level )
+  {
+    this->ReleaseLevel( level );
+  }
+
+  typename SmootherType::Pointer smoother;
+  typename CascadeSmootherType::Pointer cascadeSmoother;
+  typename ImageToImageFilterSameTypes::Pointer rescaleSameTypes;
+  typename ImageToImageFilterSameTypes::Pointer cascadeRescaler;
+  typename ImageToImageFilterDifferentTypes::Pointer rescaleDifferentTypes;
+
+  // Compute the levels from the finest to the coarsest needed one
+  const unsigned int numberOfLevelsToCompute = this->m_NumberOfLevels - this->m_CurrentLevel;
+  for( unsigned int i = 0; i < numberOfLevelsToCompute; ++i )
+  {
+    const unsigned int level = this->m_NumberOfLevels - 1 - i;
+    this->UpdateProgress( static_cast< float >( i )
+      / static_cast< float >( numberOfLevelsToCompute ) );
+
+    SigmaArrayType         sigmaArray;
+    RescaleFactorArrayType shrinkFactors;
+    this->GetSigma( level, sigmaArray );
+    this->GetShrinkFactors( level, shrinkFactors );
+
+    // An unchanged input is shared instead of copied, when the types allow
+    const OutputImageType * inputAsOutput
+      = dynamic_cast< const OutputImageType * >( input.GetPointer() );
+    if( inputAsOutput != NULL && this->AreSigmasAllZeros( sigmaArray )
+      && this->AreRescaleFactorsAllOnes( shrinkFactors ) )
+    {
       OutputImagePointer outputPtr = this->GetOutput( level );
-      outputPtr->SetBufferedRegion( outputPtr->GetRequestedRegion() );
-      outputPtr->Allocate();
+      outputPtr->Graft( inputAsOutput );
+    }
+    else if( this->CanComputeFromFinerLevel( level ) )
+    {
+      this->GenerateLevelFromFinerLevel( level, cascadeSmoother, cascadeRescaler );
+    }
+    else
+    {
+      this->GenerateLevelFromInput( level, input,
+        smoother, rescaleSameTypes, rescaleDifferentTypes );
+    }
 
-      // Setup the smoother
-      const bool smootherIsUsed = this->SetupSmoother( level, smoother, input );
+    // Release the intermediate images, which may be larger than this level
+    if( smoother.IsNotNull() ) { smoother->GetOutput()->ReleaseData(); }
+    if( cascadeSmoother.IsNotNull() ) { cascadeSmoother->GetOutput()->ReleaseData(); }
+    if( rescaleSameTypes.IsNotNull() ) { rescaleSameTypes->GetOutput()->ReleaseData(); }
+    if( cascadeRescaler.IsNotNull() ) { cascadeRescaler->GetOutput()->ReleaseData(); }
+    if( rescaleDifferentTypes.IsNotNull() ) { rescaleDifferentTypes->GetOutput()->ReleaseData(); }
+  }
 
-      // Setup the shrinker or resampler
-      const int shrinkerOrResamplerIsUsed = this->SetupShrinkerOrResampler( level,
-        smoother, smootherIsUsed, input, outputPtr,
-        rescaleSameTypes, rescaleDifferentTypes );
+} // end GenerateDataCascaded()
 
-      // Update the pipeline and graft or copy results to this filters output
-      if( shrinkerOrResamplerIsUsed == 0 && smootherIsUsed )
-      {
-        UpdateAndGraft< Self, SmootherType, OutputImageType >(
-          this, smoother, outputPtr, level );
-      }
-      else if( shrinkerOrResamplerIsUsed == 0 )
-      {
-        ImageAlgorithm::Copy( input.GetPointer(), outputPtr.GetPointer(),
-          input->GetLargestPossibleRegion(), outputPtr->GetLargestPossibleRegion() );
-      }
-      else if( shrinkerOrResamplerIsUsed == 1 )
-      {
-        UpdateAndGraft< Self, ImageToImageFilterSameTypes, OutputImageType >(
-          this, rescaleSameTypes, outputPtr, level );
-      }
-      else if( shrinkerOrResamplerIsUsed == 2 )
-      {
-        UpdateAndGraft< Self, ImageToImageFilterDifferentTypes, OutputImageType >(
-          this, rescaleDifferentTypes, outputPtr, level );
-      }
-      // no else needed
 
+/**
+ * ******************* GenerateLevelFromFinerLevel ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+void
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::GenerateLevelFromFinerLevel( const unsigned int level,
+  typename CascadeSmootherType::Pointer & smoother,
+  typename ImageToImageFilterSameTypes::Pointer & rescaler )
+{
+  // Allocate memory for the output
+  OutputImagePointer outputPtr = this->GetOutput( level );
+  outputPtr->SetBufferedRegion( outputPtr->GetRequestedRegion() );
+  outputPtr->Allocate();
+
+  // Use the finer level as input, disconnected from this filter
+  OutputImagePointer finerLevel = OutputImageType::New();
+  finerLevel->Graft( this->GetOutput( level + 1 ) );
+
+  // The additional smoothing, such that the variances add up to the
+  // variance of this level, and the remaining shrink factors
+  SigmaArrayType         sigmaArray;
+  SigmaArrayType         finerSigmaArray;
+  RescaleFactorArrayType shrinkFactors;
+  RescaleFactorArrayType finerShrinkFactors;
+  this->GetSigma( level, sigmaArray );
+  this->GetSigma( level + 1, finerSigmaArray );
+  this->GetShrinkFactors( level, shrinkFactors );
+  this->GetShrinkFactors( level + 1, finerShrinkFactors );
+
+  typename CascadeSmootherType::SigmaArrayType extraSigmaArray;
+  SigmaArrayType                               extraSigmas;
+  RescaleFactorArrayType                       relativeShrinkFactors;
+  for( unsigned int dim = 0; dim < ImageDimension; dim++ )
+  {
+    extraSigmas[ dim ] = std::sqrt( vnl_math_max( NumericTraits< ScalarRealType >::ZeroValue(),
+      sigmaArray[ dim ] * sigmaArray[ dim ] - finerSigmaArray[ dim ] * finerSigmaArray[ dim ] ) );
+    extraSigmaArray[ dim ]       = extraSigmas[ dim ];
+    relativeShrinkFactors[ dim ] = shrinkFactors[ dim ] / finerShrinkFactors[ dim ];
+  }
+
+  const bool smootherIsUsed = !this->AreSigmasAllZeros( extraSigmas );
+  if( smootherIsUsed )
+  {
+    if( smoother.IsNull() ) { smoother = CascadeSmootherType::New(); }
+    smoother->SetInput( finerLevel );
+    smoother->SetSigmaArray( extraSigmaArray );
+  }
+
+  if( this->AreRescaleFactorsAllOnes( relativeShrinkFactors ) )
+  {
+    if( smootherIsUsed )
+    {
+      UpdateAndGraft< Self, CascadeSmootherType, OutputImageType >(
+        this, smoother, outputPtr, level );
     }
-  } // end for ilevel
-} // end GenerateData()
+    else
+    {
+      ImageAlgorithm::Copy( finerLevel.GetPointer(), outputPtr.GetPointer(),
+        finerLevel->GetLargestPossibleRegion(), outputPtr->GetLargestPossibleRegion() );
+    }
+    return;
+  }
+
+  // Shrink or resample to the grid of this level
+  typename ImageToImageFilterDifferentTypes::Pointer unused;
+  this->DefineShrinkerOrResampler( true, relativeShrinkFactors, outputPtr,
+    rescaler, unused );
+  if( smootherIsUsed )
+  {
+    rescaler->SetInput( smoother->GetOutput() );
+  }
+  else
+  {
+    rescaler->SetInput( finerLevel );
+  }
+  UpdateAndGraft< Self, ImageToImageFilterSameTypes, OutputImageType >(
+    this, rescaler, outputPtr, level );
+
+} // end GenerateLevelFromFinerLevel()
+
+
+/**
+ * ******************* CanComputeFromFinerLevel ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+bool
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::CanComputeFromFinerLevel( const unsigned int level ) const
+{
+  if( level + 1 >= this->m_NumberOfLevels )
+  {
+    return false;
+  }
+
+  SigmaArrayType         sigmaArray;
+  SigmaArrayType         finerSigmaArray;
+  RescaleFactorArrayType shrinkFactors;
+  RescaleFactorArrayType finerShrinkFactors;
+  this->GetSigma( level, sigmaArray );
+  this->GetSigma( level + 1, finerSigmaArray );
+  this->GetShrinkFactors( level, shrinkFactors );
+  this->GetShrinkFactors( level + 1, finerShrinkFactors );
+  const SpacingType & spacing = this->GetInput()->GetSpacing();
+
+  for( unsigned int dim = 0; dim < ImageDimension; dim++ )
+  {
+    // Smoothing and shrinking can only be added to the finer level
+    if( sigmaArray[ dim ] < finerSigmaArray[ dim ]
+      || shrinkFactors[ dim ] < finerShrinkFactors[ dim ] )
+    {
+      return false;
+    }
+
+    // The shrinker only takes integer factors
+    const unsigned int factor      = static_cast< unsigned int >( shrinkFactors[ dim ] );
+    const unsigned int finerFactor = static_cast< unsigned int >( finerShrinkFactors[ dim ] );
+    if( this->GetUseShrinkImageFilter() && factor % finerFactor != 0 )
+    {
+      return false;
+    }
+
+    // A shrunk finer level must be smoothed enough to represent the image
+    // without aliasing, i.e. with at least half a voxel of its own grid. The
+    // default smoothing schedule does exactly that.
+    if( finerFactor > 1 && finerSigmaArray[ dim ]
+      < 0.499 * static_cast< double >( finerFactor ) * spacing[ dim ] )
+    {
+      return false;
+    }
+  }
+
+  return true;
+
+} // end CanComputeFromFinerLevel()
 
 
 /**
@@ -629,10 +894,16 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
     SuperSuperclass::GenerateOutputRequestedRegion( refOutput );
   }
 
-  // We have to set requestedRegion properly
+  // We have to set requestedRegion properly. A released level requests
+  // nothing, so that the pipeline does not compute it again.
   for( unsigned int level = 0; level < this->m_NumberOfLevels; level++ )
   {
     this->GetOutput( level )->SetRequestedRegionToLargestPossibleRegion();
+    if( this->IsLevelReleased( level ) )
+    {
+      this->GetOutput( level )->SetRequestedRegion(
+        this->GetOutput( level )->GetBufferedRegion() );
+    }
   }
 } // end GenerateOutputRequestedRegion()
 
@@ -690,7 +961,14 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
   // release the memories if already has been allocated
   for( unsigned int level = 0; level < this->m_NumberOfLevels; level++ )
   {
-    if( this->m_ComputeOnlyForCurrentLevel && level != this->m_CurrentLevel )
+    if( this->m_ComputeLevelsCascaded )
+    {
+      if( this->IsLevelReleased( level ) )
+      {
+        this->ReleaseLevel( level );
+      }
+    }
+    else if( this->m_ComputeOnlyForCurrentLevel && level != this->m_CurrentLevel )
     {
       this->GetOutput( level )->Initialize();
     }
@@ -698,6 +976,40 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
 } // end ReleaseOutputs()
 
 
+/**
+ * ******************* IsLevelReleased ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+bool
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::IsLevelReleased( const unsigned int level ) const
+{
+  return this->m_ComputeLevelsCascaded && level < this->m_CurrentLevel;
+} // end IsLevelReleased()
+
+
+/**
+ * ******************* ReleaseLevel ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+void
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::ReleaseLevel( const unsigned int level )
+{
+  OutputImagePointer output = this->GetOutput( level );
+  typename OutputImageType::RegionType emptyRegion = output->GetLargestPossibleRegion();
+  typename OutputImageType::SizeType   emptySize;
+  emptySize.Fill( 0 );
+  emptyRegion.SetSize( emptySize );
+
+  output->Initialize();
+  output->SetBufferedRegion( emptyRegion );
+  output->SetRequestedRegion( emptyRegion );
+} // end ReleaseLevel()
+
+
 /**
  * ******************* ComputeForCurrentLevel ***********************
  */
@@ -914,6 +1226,8 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
      << this->m_CurrentLevel << std::endl;
   os << indent << "ComputeOnlyForCurrentLevel: "
      << ( this->m_ComputeOnlyForCurrentLevel ? "true" : "false" ) << std::endl;
+  os << indent << "ComputeLevelsCascaded: "
+     << ( this->m_ComputeLevelsCascaded ? "true" : "false" ) << std::endl;
   os << indent << "SmoothingScheduleDefined: "
      << ( this->m_SmoothingScheduleDefined ? "true" : "false" ) << std::endl;
   os << indent << "Smoothing Schedule: ";
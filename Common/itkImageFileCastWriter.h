@@ -81,7 +81,9 @@ protected:
   /** Templated function that casts the input image and returns a
    * a pointer to the PixelBuffer. Assumes scalar singlecomponent images
    * The buffer data is valid until this->m_Caster is destroyed or assigned
-   * a new caster. The ImageIO's PixelType is also adapted by this function */
+   * a new caster. The ImageIO's PixelType is also adapted by this function.
+   * Only the IO region is cast, which may be a part of the buffered region,
+   * and of the largest possible region, when the image is written in pieces. */
   template< class OutputComponentType >
   void * ConvertScalarImage( const DataObject * inputImage,
     const OutputComponentType & itkNotUsed( dummy ) )
@@ -106,8 +108,16 @@ protected:
     localInputImage->Graft( inputImage );
 #endif
 
+    typename ScalarInputImageType::RegionType ioRegion;
+    ImageIORegionAdaptor< InputImageDimension >::Convert(
+      this->GetImageIO()->GetIORegion(), ioRegion,
+      localInputImage->GetLargestPossibleRegion().GetIndex() );
+
     caster->SetInput( localInputImage );
-    caster->Update();
+    caster->UpdateOutputInformation();
+    caster->GetOutput()->SetRequestedRegion( ioRegion );
+    caster->GetOutput()->PropagateRequestedRegion();
+    caster->GetOutput()->UpdateOutputData();
 
     /** return the pixel buffer of the casted image */
     OutputComponentType * pixelBuffer     = caster->GetOutput()->GetBufferPointer();
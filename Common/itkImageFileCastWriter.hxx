@@ -178,9 +178,9 @@ ImageFileCastWriter< TInputImage >
   }
   else
   {
-    /** No casting needed or possible, just write */
-    const void * dataPtr = (const void *)input->GetBufferPointer();
-    this->GetModifiableImageIO()->Write( dataPtr );
+    /** No casting needed or possible, just write. The superclass copies the
+     * IO region first if it differs from the buffered region. */
+    this->Superclass::GenerateData();
   }
 
 }
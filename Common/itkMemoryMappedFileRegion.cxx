@@ -0,0 +1,200 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMemoryMappedFileRegion_cxx
+#define __itkMemoryMappedFileRegion_cxx
+
+#include "itkMemoryMappedFileRegion.h"
+
+#if defined( _WIN32 )
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace itk
+{
+
+/**
+ * ****************** Constructor *********************************
+ */
+
+MemoryMappedFileRegion::MemoryMappedFileRegion()
+{
+  this->m_MappedAddress = 0;
+  this->m_MappedSize    = 0;
+  this->m_Pointer       = 0;
+  this->m_NumberOfBytes = 0;
+
+} // end Constructor
+
+
+/**
+ * ****************** Destructor *********************************
+ */
+
+MemoryMappedFileRegion::~MemoryMappedFileRegion()
+{
+  this->Unmap();
+
+} // end Destructor
+
+
+/**
+ * ****************** GetFileSize *********************************
+ */
+
+OffsetValueType
+MemoryMappedFileRegion::GetFileSize( const std::string & fileName )
+{
+#if defined( _WIN32 )
+  WIN32_FILE_ATTRIBUTE_DATA data;
+  if( !GetFileAttributesExA( fileName.c_str(), GetFileExInfoStandard, &data ) )
+  {
+    return -1;
+  }
+  LARGE_INTEGER size;
+  size.HighPart = data.nFileSizeHigh;
+  size.LowPart  = data.nFileSizeLow;
+  return static_cast< OffsetValueType >( size.QuadPart );
+#else
+  struct stat st;
+  if( stat( fileName.c_str(), &st ) != 0 )
+  {
+    return -1;
+  }
+  return static_cast< OffsetValueType >( st.st_size );
+#endif
+
+} // end GetFileSize()
+
+
+/**
+ * ****************** Map *********************************
+ */
+
+bool
+MemoryMappedFileRegion::Map( const std::string & fileName,
+  const SizeValueType offset, const SizeValueType numberOfBytes )
+{
+  this->Unmap();
+
+  /** Check that the file contains the region. */
+  const OffsetValueType fileSize = GetFileSize( fileName );
+  if( numberOfBytes == 0 || fileSize < 0
+    || static_cast< SizeValueType >( fileSize ) < offset + numberOfBytes )
+  {
+    return false;
+  }
+
+#if defined( _WIN32 )
+  /** Views start at a multiple of the allocation granularity. */
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo( &systemInfo );
+  const SizeValueType granularity   = systemInfo.dwAllocationGranularity;
+  const SizeValueType alignedOffset = offset - offset % granularity;
+  const SizeValueType mappedSize    = numberOfBytes + ( offset - alignedOffset );
+
+  HANDLE file = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ,
+    NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+  if( file == INVALID_HANDLE_VALUE )
+  {
+    return false;
+  }
+  HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_WRITECOPY, 0, 0, NULL );
+  CloseHandle( file );
+  if( mapping == NULL )
+  {
+    return false;
+  }
+
+  /** The view keeps the mapping object alive. */
+  void * address = MapViewOfFile( mapping, FILE_MAP_COPY,
+    static_cast< DWORD >( static_cast< unsigned long long >( alignedOffset ) >> 32 ),
+    static_cast< DWORD >( alignedOffset & 0xFFFFFFFFu ),
+    static_cast< SIZE_T >( mappedSize ) );
+  CloseHandle( mapping );
+  if( address == NULL )
+  {
+    return false;
+  }
+#else
+  /** Mappings start at a page boundary. */
+  const SizeValueType pageSize      = static_cast< SizeValueType >( sysconf( _SC_PAGESIZE ) );
+  const SizeValueType alignedOffset = offset - offset % pageSize;
+  const SizeValueType mappedSize    = numberOfBytes + ( offset - alignedOffset );
+
+  const int file = open( fileName.c_str(), O_RDONLY );
+  if( file < 0 )
+  {
+    return false;
+  }
+
+  /** A private mapping is copy-on-write, so it may be opened read-only.
+   * The mapping stays valid after closing the file.
+   */
+  void * address = mmap( 0, static_cast< size_t >( mappedSize ),
+    PROT_READ | PROT_WRITE, MAP_PRIVATE, file, static_cast< off_t >( alignedOffset ) );
+  close( file );
+  if( address == MAP_FAILED )
+  {
+    return false;
+  }
+#endif
+
+  this->m_MappedAddress = address;
+  this->m_MappedSize    = mappedSize;
+  this->m_Pointer       = static_cast< char * >( address ) + ( offset - alignedOffset );
+  this->m_NumberOfBytes = numberOfBytes;
+  return true;
+
+} // end Map()
+
+
+/**
+ * ****************** Unmap *********************************
+ */
+
+void
+MemoryMappedFileRegion::Unmap( void )
+{
+  if( this->m_MappedAddress != 0 )
+  {
+#if defined( _WIN32 )
+    UnmapViewOfFile( this->m_MappedAddress );
+#else
+    munmap( this->m_MappedAddress, static_cast< size_t >( this->m_MappedSize ) );
+#endif
+  }
+
+  this->m_MappedAddress = 0;
+  this->m_MappedSize    = 0;
+  this->m_Pointer       = 0;
+  this->m_NumberOfBytes = 0;
+
+} // end Unmap()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkMemoryMappedFileRegion_cxx
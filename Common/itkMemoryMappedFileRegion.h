@@ -0,0 +1,85 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMemoryMappedFileRegion_h
+#define __itkMemoryMappedFileRegion_h
+
+#include "itkIntTypes.h"
+
+#include <string>
+
+namespace itk
+{
+
+/** \class MemoryMappedFileRegion
+ *
+ * \brief A read-only view of a region of a file, mapped into memory.
+ *
+ * Map() maps the bytes [offset, offset + numberOfBytes) of a file, so that the
+ * pages are loaded by the operating system on first access, and are shared
+ * with its file cache. The mapping is private (copy-on-write): the pointer is
+ * writable, but writes never reach the file.
+ *
+ * The offset needs no alignment; the region is mapped from the enclosing page
+ * boundary. The mapping is released by Unmap() or by the destructor.
+ *
+ * \ingroup Common
+ */
+
+class MemoryMappedFileRegion
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef MemoryMappedFileRegion Self;
+
+  MemoryMappedFileRegion();
+  ~MemoryMappedFileRegion();
+
+  /** Map a region of a file. Returns false, without throwing, if the file can
+   * not be opened or mapped, or if it is smaller than offset + numberOfBytes.
+   */
+  bool Map( const std::string & fileName,
+    const SizeValueType offset, const SizeValueType numberOfBytes );
+
+  /** Release the mapping, if any. */
+  void Unmap( void );
+
+  /** Get a pointer to the first byte of the region, or NULL if not mapped. */
+  void * GetPointer( void ) const { return this->m_Pointer; }
+
+  /** Get the number of bytes of the region. */
+  SizeValueType GetNumberOfBytes( void ) const { return this->m_NumberOfBytes; }
+
+  /** Get the size of a file in bytes, or -1 if it does not exist. */
+  static OffsetValueType GetFileSize( const std::string & fileName );
+
+private:
+
+  MemoryMappedFileRegion( const Self & ); // purposely not implemented
+  void operator=( const Self & );         // purposely not implemented
+
+  void *        m_MappedAddress;
+  SizeValueType m_MappedSize;
+  void *        m_Pointer;
+  SizeValueType m_NumberOfBytes;
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkMemoryMappedFileRegion_h
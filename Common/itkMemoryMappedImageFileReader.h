@@ -0,0 +1,182 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMemoryMappedImageFileReader_h
+#define __itkMemoryMappedImageFileReader_h
+
+#include "itkImageFileReader.h"
+#include "itkImportImageContainer.h"
+#include "itkMemoryMappedFileRegion.h"
+
+namespace itk
+{
+
+/** \class MemoryMappedImageFileReader
+ *
+ * \brief An ImageFileReader that maps raw pixel data into memory instead of
+ * reading and converting it.
+ *
+ * The ImageFileReader reads the whole file into a buffer of the file pixel
+ * type, and then converts it to the output pixel type. For large images that
+ * doubles the peak memory usage, and costs a lot of I/O before anything else
+ * can be done. This reader avoids both, in two ways:
+ *
+ * \li If UseMemoryMapping is on, the data of the file is uncompressed and
+ *   contiguous (see RawImageDataLocator), and its pixel type and byte order
+ *   equal those of the output image, the file pages are mapped directly as the
+ *   pixel buffer of the output. Pages are then only loaded when they are
+ *   accessed. The mapping is private: modifications of the buffer are
+ *   allowed, but do not change the file.
+ * \li Otherwise, if UseStreamingConversion is on and the ImageIO supports
+ *   streamed reading, the file is read and converted in slabs of at most
+ *   MaximumConversionBufferSize bytes, so that only the output is allocated
+ *   in full.
+ *
+ * In all other cases the superclass reads the image. Only scalar images of
+ * which the whole image is requested are mapped or streamed.
+ *
+ * A mapped file must not be truncated or overwritten while the output exists,
+ * for example by writing a result image to the same file. The pages of the
+ * mapping would then vanish, and reading them raises SIGBUS instead of an
+ * exception. Check GetOutputIsMemoryMapped() before writing to an input file.
+ *
+ * \ingroup IOFilters
+ */
+
+template< class TOutputImage >
+class MemoryMappedImageFileReader : public ImageFileReader< TOutputImage >
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef MemoryMappedImageFileReader     Self;
+  typedef ImageFileReader< TOutputImage > Superclass;
+  typedef SmartPointer< Self >            Pointer;
+  typedef SmartPointer< const Self >      ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MemoryMappedImageFileReader, ImageFileReader );
+
+  /** Typedefs inherited from the superclass. */
+  typedef typename Superclass::OutputImageType  OutputImageType;
+  typedef typename Superclass::OutputImagePixelType OutputImagePixelType;
+  typedef typename OutputImageType::RegionType  RegionType;
+
+  /** The dimension of the output image. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TOutputImage::ImageDimension );
+
+  /** Set/get whether to map the pixel data into memory, if possible. Default: true. */
+  itkSetMacro( UseMemoryMapping, bool );
+  itkGetConstMacro( UseMemoryMapping, bool );
+  itkBooleanMacro( UseMemoryMapping );
+
+  /** Set/get whether to convert the pixel data in slabs, if it is not mapped. Default: true. */
+  itkSetMacro( UseStreamingConversion, bool );
+  itkGetConstMacro( UseStreamingConversion, bool );
+  itkBooleanMacro( UseStreamingConversion );
+
+  /** Set/get the maximum size in bytes of a slab of the streaming conversion. Default: 64 MB. */
+  itkSetMacro( MaximumConversionBufferSize, SizeValueType );
+  itkGetConstMacro( MaximumConversionBufferSize, SizeValueType );
+
+  /** Get whether the last output was mapped into memory. */
+  itkGetConstMacro( OutputIsMemoryMapped, bool );
+
+protected:
+
+  MemoryMappedImageFileReader();
+  ~MemoryMappedImageFileReader() override {}
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const override;
+
+  /** Map, stream, or let the superclass read the image. */
+  void GenerateData( void ) override;
+
+  /** Try to map the pixel data into memory. */
+  virtual bool GenerateDataUsingMemoryMapping( void );
+
+  /** Try to read and convert the pixel data in slabs. */
+  virtual bool GenerateDataUsingStreamingConversion( void );
+
+private:
+
+  MemoryMappedImageFileReader( const Self & ); // purposely not implemented
+  void operator=( const Self & );              // purposely not implemented
+
+  /** A pixel container that releases the mapping of its buffer. */
+  class MemoryMappedPixelContainer :
+    public ImportImageContainer< SizeValueType, OutputImagePixelType >
+  {
+public:
+
+    typedef MemoryMappedPixelContainer Self;
+    typedef ImportImageContainer< SizeValueType, OutputImagePixelType > Superclass;
+    typedef SmartPointer< Self > Pointer;
+
+    itkNewMacro( Self );
+    itkTypeMacro( MemoryMappedPixelContainer, ImportImageContainer );
+
+    /** Map the file region and import it as the buffer, without letting the
+     * superclass manage the memory.
+     */
+    bool Map( const std::string & fileName, const SizeValueType offset,
+      const SizeValueType numberOfPixels )
+    {
+      if( !this->m_FileRegion.Map( fileName, offset,
+        numberOfPixels * sizeof( OutputImagePixelType ) ) )
+      {
+        return false;
+      }
+      this->SetImportPointer( static_cast< OutputImagePixelType * >(
+        this->m_FileRegion.GetPointer() ), numberOfPixels, false );
+      return true;
+    }
+
+
+protected:
+
+    MemoryMappedPixelContainer() {}
+    ~MemoryMappedPixelContainer() override {}
+
+private:
+
+    MemoryMappedFileRegion m_FileRegion;
+  };
+
+  /** Convert a slab from the file component type to the output pixel type. */
+  template< class TInputComponent >
+  static void ConvertSlab( void * input, OutputImagePixelType * output,
+    const SizeValueType numberOfPixels );
+
+  bool          m_UseMemoryMapping;
+  bool          m_UseStreamingConversion;
+  SizeValueType m_MaximumConversionBufferSize;
+  bool          m_OutputIsMemoryMapped;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkMemoryMappedImageFileReader.hxx"
+#endif
+
+#endif // end #ifndef __itkMemoryMappedImageFileReader_h
@@ -0,0 +1,285 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMemoryMappedImageFileReader_hxx
+#define __itkMemoryMappedImageFileReader_hxx
+
+#include "itkMemoryMappedImageFileReader.h"
+#include "itkRawImageDataLocator.h"
+#include "itkByteSwapper.h"
+#include "itkConvertPixelBuffer.h"
+#include "itkDefaultConvertPixelTraits.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace itk
+{
+
+/**
+ * ****************** Constructor *********************************
+ */
+
+template< class TOutputImage >
+MemoryMappedImageFileReader< TOutputImage >
+::MemoryMappedImageFileReader()
+{
+  this->m_UseMemoryMapping            = true;
+  this->m_UseStreamingConversion      = true;
+  this->m_MaximumConversionBufferSize = 64 * 1024 * 1024;
+  this->m_OutputIsMemoryMapped        = false;
+
+} // end Constructor
+
+
+/**
+ * ****************** GenerateData *********************************
+ */
+
+template< class TOutputImage >
+void
+MemoryMappedImageFileReader< TOutputImage >
+::GenerateData( void )
+{
+  OutputImageType * output = this->GetOutput();
+
+  /** Do not let a previous mapping be reused as an allocated buffer. */
+  if( this->m_OutputIsMemoryMapped )
+  {
+    output->SetPixelContainer( OutputImageType::PixelContainer::New() );
+    this->m_OutputIsMemoryMapped = false;
+  }
+
+  /** Only scalar images, of which the whole image is requested, are mapped or streamed. */
+  const ImageIOBase * imageIO = this->GetImageIO();
+  bool                applicable = imageIO != 0
+    && DefaultConvertPixelTraits< OutputImagePixelType >::GetNumberOfComponents() == 1
+    && imageIO->GetNumberOfComponents() == 1
+    && imageIO->GetNumberOfDimensions() == ImageDimension
+    && output->GetRequestedRegion() == output->GetLargestPossibleRegion();
+  for( unsigned int d = 0; applicable && d < ImageDimension; ++d )
+  {
+    applicable = imageIO->GetDimensions( d ) == output->GetLargestPossibleRegion().GetSize()[ d ];
+  }
+
+  if( applicable && this->m_UseMemoryMapping && this->GenerateDataUsingMemoryMapping() )
+  {
+    this->m_OutputIsMemoryMapped = true;
+    return;
+  }
+  if( applicable && this->m_UseStreamingConversion && this->GenerateDataUsingStreamingConversion() )
+  {
+    return;
+  }
+
+  this->Superclass::GenerateData();
+
+} // end GenerateData()
+
+
+/**
+ * ****************** GenerateDataUsingMemoryMapping *********************************
+ */
+
+template< class TOutputImage >
+bool
+MemoryMappedImageFileReader< TOutputImage >
+::GenerateDataUsingMemoryMapping( void )
+{
+  const ImageIOBase * imageIO = this->GetImageIO();
+  OutputImageType *   output  = this->GetOutput();
+
+  /** The pixel type must match exactly. */
+  if( imageIO->GetComponentType() != ImageIOBase::MapPixelType< OutputImagePixelType >::CType
+    || imageIO->GetComponentSize() != sizeof( OutputImagePixelType ) )
+  {
+    return false;
+  }
+
+  /** Find the data, and check its byte order and alignment. */
+  const SizeValueType numberOfPixels = output->GetRequestedRegion().GetNumberOfPixels();
+  std::string         dataFileName;
+  SizeValueType       offset      = 0;
+  bool                isBigEndian = false;
+  if( !RawImageDataLocator::Locate( imageIO, this->GetFileName(),
+    numberOfPixels * sizeof( OutputImagePixelType ), dataFileName, offset, isBigEndian ) )
+  {
+    return false;
+  }
+  if( sizeof( OutputImagePixelType ) > 1
+    && isBigEndian != ByteSwapper< OutputImagePixelType >::SystemIsBigEndian() )
+  {
+    return false;
+  }
+  if( offset % sizeof( OutputImagePixelType ) != 0 )
+  {
+    return false;
+  }
+
+  /** Map the data and use it as the buffer of the output. */
+  typename MemoryMappedPixelContainer::Pointer container = MemoryMappedPixelContainer::New();
+  if( !container->Map( dataFileName, offset, numberOfPixels ) )
+  {
+    return false;
+  }
+  output->SetBufferedRegion( output->GetRequestedRegion() );
+  output->SetPixelContainer( container );
+
+  return true;
+
+} // end GenerateDataUsingMemoryMapping()
+
+
+/**
+ * ****************** GenerateDataUsingStreamingConversion *********************************
+ */
+
+template< class TOutputImage >
+bool
+MemoryMappedImageFileReader< TOutputImage >
+::GenerateDataUsingStreamingConversion( void )
+{
+  ImageIOBase *     imageIO = this->GetModifiableImageIO();
+  OutputImageType * output  = this->GetOutput();
+
+  /** Without conversion the superclass reads directly into the output.
+   * Streamed reading is only switched on for the slabs, so that it does not
+   * leak into the superclass when this function returns false.
+   */
+  if( imageIO->GetComponentType() == ImageIOBase::MapPixelType< OutputImagePixelType >::CType )
+  {
+    return false;
+  }
+  const bool useStreamedReading = imageIO->GetUseStreamedReading();
+  imageIO->SetUseStreamedReading( true );
+  if( !imageIO->CanStreamRead() )
+  {
+    imageIO->SetUseStreamedReading( useStreamedReading );
+    return false;
+  }
+
+  /** Determine the number of slices, in the last dimension, per slab. */
+  const RegionType    region           = output->GetRequestedRegion();
+  const unsigned int  lastDimension    = ImageDimension - 1;
+  const SizeValueType numberOfSlices   = region.GetSize()[ lastDimension ];
+  const SizeValueType pixelsPerSlice   = region.GetNumberOfPixels() / numberOfSlices;
+  const SizeValueType bytesPerSlice    = pixelsPerSlice * imageIO->GetComponentSize();
+  const SizeValueType slicesPerSlab    = std::min( numberOfSlices,
+    std::max< SizeValueType >( 1, this->m_MaximumConversionBufferSize / bytesPerSlice ) );
+
+  /** Allocate the output, and a buffer for one slab of the file. */
+  output->SetBufferedRegion( region );
+  output->Allocate();
+  std::vector< char > buffer( slicesPerSlab * bytesPerSlice );
+
+  /** Read and convert the slabs. The indices of the file start at 0. */
+  ImageIORegion ioRegion( ImageDimension );
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    ioRegion.SetIndex( d, 0 );
+    ioRegion.SetSize( d, region.GetSize()[ d ] );
+  }
+
+  for( SizeValueType slice = 0; slice < numberOfSlices; slice += slicesPerSlab )
+  {
+    const SizeValueType slabSize = std::min( slicesPerSlab, numberOfSlices - slice );
+    ioRegion.SetIndex( lastDimension, slice );
+    ioRegion.SetSize( lastDimension, slabSize );
+    imageIO->SetIORegion( ioRegion );
+    imageIO->Read( &buffer[ 0 ] );
+
+    OutputImagePixelType * slab           = output->GetBufferPointer() + slice * pixelsPerSlice;
+    const SizeValueType    numberOfPixels = slabSize * pixelsPerSlice;
+    switch( imageIO->GetComponentType() )
+    {
+      case ImageIOBase::UCHAR:
+        ConvertSlab< unsigned char >( &buffer[ 0 ], slab, numberOfPixels ); break;
+      case ImageIOBase::CHAR:
+        ConvertSlab< char >( &buffer[ 0 ], slab, numberOfPixels ); break;
+      case ImageIOBase::USHORT:
+        ConvertSlab< unsigned short >( &buffer[ 0 ], slab, numberOfPixels ); break;
+      case ImageIOBase::SHORT:
+        ConvertSlab< short >( &buffer[ 0 ], slab, numberOfPixels ); break;
+      case ImageIOBase::UINT:
+        ConvertSlab< unsigned int >( &buffer[ 0 ], slab, numberOfPixels ); break;
+      case ImageIOBase::INT:
+        ConvertSlab< int >( &buffer[ 0 ], slab, numberOfPixels ); break;
+      case ImageIOBase::ULONG:
+        ConvertSlab< unsigned long >( &buffer[ 0 ], slab, numberOfPixels ); break;
+      case ImageIOBase::LONG:
+        ConvertSlab< long >( &buffer[ 0 ], slab, numberOfPixels ); break;
+      case ImageIOBase::ULONGLONG:
+        ConvertSlab< unsigned long long >( &buffer[ 0 ], slab, numberOfPixels ); break;
+      case ImageIOBase::LONGLONG:
+        ConvertSlab< long long >( &buffer[ 0 ], slab, numberOfPixels ); break;
+      case ImageIOBase::FLOAT:
+        ConvertSlab< float >( &buffer[ 0 ], slab, numberOfPixels ); break;
+      case ImageIOBase::DOUBLE:
+        ConvertSlab< double >( &buffer[ 0 ], slab, numberOfPixels ); break;
+      default:
+        imageIO->SetUseStreamedReading( useStreamedReading );
+        itkExceptionMacro( << "Unsupported component type: "
+                           << ImageIOBase::GetComponentTypeAsString( imageIO->GetComponentType() ) );
+    }
+  }
+  imageIO->SetUseStreamedReading( useStreamedReading );
+
+  return true;
+
+} // end GenerateDataUsingStreamingConversion()
+
+
+/**
+ * ****************** ConvertSlab *********************************
+ */
+
+template< class TOutputImage >
+template< class TInputComponent >
+void
+MemoryMappedImageFileReader< TOutputImage >
+::ConvertSlab( void * input, OutputImagePixelType * output,
+  const SizeValueType numberOfPixels )
+{
+  ConvertPixelBuffer< TInputComponent, OutputImagePixelType,
+  DefaultConvertPixelTraits< OutputImagePixelType > >
+  ::Convert( static_cast< TInputComponent * >( input ), 1, output, numberOfPixels );
+
+} // end ConvertSlab()
+
+
+/**
+ * ****************** PrintSelf *********************************
+ */
+
+template< class TOutputImage >
+void
+MemoryMappedImageFileReader< TOutputImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "UseMemoryMapping: " << this->m_UseMemoryMapping << std::endl;
+  os << indent << "UseStreamingConversion: " << this->m_UseStreamingConversion << std::endl;
+  os << indent << "MaximumConversionBufferSize: " << this->m_MaximumConversionBufferSize << std::endl;
+  os << indent << "OutputIsMemoryMapped: " << this->m_OutputIsMemoryMapped << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkMemoryMappedImageFileReader_hxx
@@ -0,0 +1,140 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkPhiloxRandomNumberGenerator_h
+#define __itkPhiloxRandomNumberGenerator_h
+
+#include "itkIntTypes.h"
+
+namespace itk
+{
+
+/** \class PhiloxRandomNumberGenerator
+ *
+ * \brief A counter-based random number generator: Philox4x32-10.
+ *
+ * Unlike the MersenneTwisterRandomVariateGenerator, this generator has no
+ * state that advances with each draw. The random numbers are a pure function
+ * of a key and a counter, here the seed, a stream number, and the index of the
+ * number in the stream. Any thread can therefore compute any random number,
+ * and the results do not depend on the number of threads or on the order in
+ * which the numbers are computed.
+ *
+ * Each index gives a block of four 32 bit integers, or two uniform doubles.
+ * The algorithm is that of Salmon et al., "Parallel random numbers: as easy
+ * as 1, 2, 3", SC'11. With a zero key and counter it produces
+ * 0x6627e8d5 0xe169c58d 0xbc57ac4c 0x9b00dbd8.
+ *
+ * This is a lightweight copyable class, not an itk::Object.
+ *
+ * \ingroup Numerics
+ */
+
+class PhiloxRandomNumberGenerator
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef PhiloxRandomNumberGenerator Self;
+
+  /** Constructor. The seed is the key, the stream the upper half of the counter. */
+  PhiloxRandomNumberGenerator( const uint64_t seed = 0, const uint64_t stream = 0 )
+  {
+    this->m_Key[ 0 ]    = static_cast< uint32_t >( seed );
+    this->m_Key[ 1 ]    = static_cast< uint32_t >( seed >> 32 );
+    this->m_Stream[ 0 ] = static_cast< uint32_t >( stream );
+    this->m_Stream[ 1 ] = static_cast< uint32_t >( stream >> 32 );
+  }
+
+
+  /** Compute the block of four random integers with the given index. */
+  void GetIntegerBlock( const uint64_t index, uint32_t block[ 4 ] ) const
+  {
+    uint32_t counter[ 4 ] = {
+      static_cast< uint32_t >( index ), static_cast< uint32_t >( index >> 32 ),
+      this->m_Stream[ 0 ], this->m_Stream[ 1 ]
+    };
+    Self::Philox( counter, this->m_Key, block );
+  }
+
+
+  /** Get a uniform random double in [0,1). Each index gives two numbers,
+   * selected by component 0 or 1.
+   */
+  double GetUniformVariate( const uint64_t index, const unsigned int component ) const
+  {
+    uint32_t block[ 4 ];
+    this->GetIntegerBlock( index, block );
+    return Self::ToUniform( block[ 2 * component ], block[ 2 * component + 1 ] );
+  }
+
+
+  /** Get a uniform random double in [a,b). */
+  double GetUniformVariate( const uint64_t index, const unsigned int component,
+    const double a, const double b ) const
+  {
+    return a + ( b - a ) * this->GetUniformVariate( index, component );
+  }
+
+
+  /** Convert two random integers to a double in [0,1) with 53 random bits. */
+  static double ToUniform( const uint32_t a, const uint32_t b )
+  {
+    const uint64_t bits = ( static_cast< uint64_t >( a ) << 21 ) | ( b >> 11 );
+    return static_cast< double >( bits ) * ( 1.0 / 9007199254740992.0 );
+  }
+
+
+  /** The Philox4x32 bijection with 10 rounds. */
+  static void Philox( const uint32_t counter[ 4 ], const uint32_t key[ 2 ], uint32_t result[ 4 ] )
+  {
+    uint32_t c0 = counter[ 0 ];
+    uint32_t c1 = counter[ 1 ];
+    uint32_t c2 = counter[ 2 ];
+    uint32_t c3 = counter[ 3 ];
+    uint32_t k0 = key[ 0 ];
+    uint32_t k1 = key[ 1 ];
+    for( unsigned int round = 0; round < 10; ++round )
+    {
+      const uint64_t p0 = static_cast< uint64_t >( 0xD2511F53u ) * c0;
+      const uint64_t p1 = static_cast< uint64_t >( 0xCD9E8D57u ) * c2;
+      const uint32_t n0 = static_cast< uint32_t >( p1 >> 32 ) ^ c1 ^ k0;
+      const uint32_t n2 = static_cast< uint32_t >( p0 >> 32 ) ^ c3 ^ k1;
+      c1 = static_cast< uint32_t >( p1 );
+      c3 = static_cast< uint32_t >( p0 );
+      c0 = n0;
+      c2 = n2;
+      k0 += 0x9E3779B9u;
+      k1 += 0xBB67AE85u;
+    }
+    result[ 0 ] = c0;
+    result[ 1 ] = c1;
+    result[ 2 ] = c2;
+    result[ 3 ] = c3;
+  }
+
+
+private:
+
+  uint32_t m_Key[ 2 ];
+  uint32_t m_Stream[ 2 ];
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkPhiloxRandomNumberGenerator_h
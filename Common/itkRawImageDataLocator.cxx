@@ -0,0 +1,324 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRawImageDataLocator_cxx
+#define __itkRawImageDataLocator_cxx
+
+#include "itkRawImageDataLocator.h"
+#include "itkMemoryMappedFileRegion.h"
+#include "itkMetaDataObject.h"
+#include "itkByteSwapper.h"
+
+#include <itksys/SystemTools.hxx>
+
+#include <cstdlib>
+#include <fstream>
+
+namespace itk
+{
+
+/** Remove leading and trailing white space, including a carriage return. */
+static std::string
+RawImageDataLocatorTrim( const std::string & s )
+{
+  const std::string::size_type first = s.find_first_not_of( " \t\r\n" );
+  if( first == std::string::npos )
+  {
+    return std::string();
+  }
+  const std::string::size_type last = s.find_last_not_of( " \t\r\n" );
+  return s.substr( first, last - first + 1 );
+}
+
+
+/**
+ * ****************** Locate *********************************
+ */
+
+bool
+RawImageDataLocator::Locate( const ImageIOBase * imageIO, const std::string & fileName,
+  const SizeValueType numberOfBytes,
+  std::string & dataFileName, SizeValueType & offset, bool & isBigEndian )
+{
+  if( imageIO == 0 || numberOfBytes == 0 )
+  {
+    return false;
+  }
+
+  /** Parse the headers of the file formats that we know, and otherwise ask the ImageIO. */
+  const std::string className = imageIO->GetNameOfClass();
+  if( className == "MetaImageIO" )
+  {
+    return LocateMetaImage( fileName, numberOfBytes, dataFileName, offset, isBigEndian );
+  }
+  else if( className == "NrrdImageIO" )
+  {
+    return LocateNrrd( fileName, numberOfBytes, dataFileName, offset, isBigEndian );
+  }
+
+  if( !LocateFromMetaDataDictionary( imageIO, dataFileName, offset, isBigEndian ) )
+  {
+    return false;
+  }
+  return CheckDataRegion( dataFileName, static_cast< OffsetValueType >( offset ), numberOfBytes, offset );
+
+} // end Locate()
+
+
+/**
+ * ****************** LocateMetaImage *********************************
+ */
+
+bool
+RawImageDataLocator::LocateMetaImage( const std::string & fileName, const SizeValueType numberOfBytes,
+  std::string & dataFileName, SizeValueType & offset, bool & isBigEndian )
+{
+  std::ifstream header( fileName.c_str(), std::ios::in | std::ios::binary );
+  if( !header.is_open() )
+  {
+    return false;
+  }
+
+  /** Read the "Key = Value" lines; ElementDataFile is always the last one. */
+  OffsetValueType headerSize = 0;
+  isBigEndian = false;
+  std::string line;
+  while( std::getline( header, line ) )
+  {
+    const std::string::size_type pos = line.find( '=' );
+    if( pos == std::string::npos )
+    {
+      continue;
+    }
+    const std::string key   = RawImageDataLocatorTrim( line.substr( 0, pos ) );
+    const std::string value = RawImageDataLocatorTrim( line.substr( pos + 1 ) );
+
+    if( key == "CompressedData" && value != "False" )
+    {
+      return false;
+    }
+    else if( key == "BinaryData" && value != "True" )
+    {
+      return false;
+    }
+    else if( key == "ElementNumberOfChannels" && std::atoi( value.c_str() ) != 1 )
+    {
+      return false;
+    }
+    else if( key == "BinaryDataByteOrderMSB" || key == "ElementByteOrderMSB" )
+    {
+      isBigEndian = ( value == "True" );
+    }
+    else if( key == "HeaderSize" )
+    {
+      headerSize = std::atol( value.c_str() );
+    }
+    else if( key == "ElementDataFile" )
+    {
+      if( value == "LOCAL" )
+      {
+        /** The data follows the header. */
+        if( headerSize != 0 )
+        {
+          return false;
+        }
+        dataFileName = fileName;
+        headerSize   = static_cast< OffsetValueType >( header.tellg() );
+      }
+      else if( value.empty() || value.compare( 0, 4, "LIST" ) == 0
+        || value.find( '%' ) != std::string::npos )
+      {
+        /** Lists and patterns of files. */
+        return false;
+      }
+      else
+      {
+        dataFileName = GetDataFileName( fileName, value );
+      }
+      return CheckDataRegion( dataFileName, headerSize, numberOfBytes, offset );
+    }
+  }
+
+  return false;
+
+} // end LocateMetaImage()
+
+
+/**
+ * ****************** LocateNrrd *********************************
+ */
+
+bool
+RawImageDataLocator::LocateNrrd( const std::string & fileName, const SizeValueType numberOfBytes,
+  std::string & dataFileName, SizeValueType & offset, bool & isBigEndian )
+{
+  std::ifstream header( fileName.c_str(), std::ios::in | std::ios::binary );
+  if( !header.is_open() )
+  {
+    return false;
+  }
+
+  std::string line;
+  if( !std::getline( header, line ) || line.compare( 0, 4, "NRRD" ) != 0 )
+  {
+    return false;
+  }
+
+  /** Read the "field: value" lines, up to the empty line or the end of the file. */
+  OffsetValueType byteSkip = 0;
+  bool            encodingIsRaw = false;
+  isBigEndian  = ByteSwapper< char >::SystemIsBigEndian();
+  dataFileName = std::string();
+  while( std::getline( header, line ) )
+  {
+    line = RawImageDataLocatorTrim( line );
+    if( line.empty() )
+    {
+      break;
+    }
+    if( line[ 0 ] == '#' || line.find( ":=" ) != std::string::npos )
+    {
+      /** Comments and key/value pairs. */
+      continue;
+    }
+    const std::string::size_type pos = line.find( ": " );
+    if( pos == std::string::npos )
+    {
+      continue;
+    }
+    const std::string field = line.substr( 0, pos );
+    const std::string value = RawImageDataLocatorTrim( line.substr( pos + 2 ) );
+
+    if( field == "encoding" )
+    {
+      encodingIsRaw = ( value == "raw" );
+    }
+    else if( field == "endian" )
+    {
+      isBigEndian = ( value == "big" );
+    }
+    else if( field == "byte skip" || field == "byteskip" )
+    {
+      byteSkip = std::atol( value.c_str() );
+    }
+    else if( field == "line skip" || field == "lineskip" )
+    {
+      if( std::atol( value.c_str() ) != 0 )
+      {
+        return false;
+      }
+    }
+    else if( field == "data file" || field == "datafile" )
+    {
+      /** Lists and patterns of files. */
+      if( value.empty() || value.compare( 0, 4, "LIST" ) == 0
+        || value.find( '%' ) != std::string::npos )
+      {
+        return false;
+      }
+      dataFileName = GetDataFileName( fileName, value );
+    }
+  }
+
+  if( !encodingIsRaw )
+  {
+    return false;
+  }
+
+  /** The attached data follows the empty line. */
+  if( dataFileName.empty() )
+  {
+    if( !header.good() )
+    {
+      return false;
+    }
+    dataFileName = fileName;
+    if( byteSkip >= 0 )
+    {
+      byteSkip += static_cast< OffsetValueType >( header.tellg() );
+    }
+  }
+
+  return CheckDataRegion( dataFileName, byteSkip, numberOfBytes, offset );
+
+} // end LocateNrrd()
+
+
+/**
+ * ****************** LocateFromMetaDataDictionary *********************************
+ */
+
+bool
+RawImageDataLocator::LocateFromMetaDataDictionary( const ImageIOBase * imageIO,
+  std::string & dataFileName, SizeValueType & offset, bool & isBigEndian )
+{
+  const MetaDataDictionary & dictionary = imageIO->GetMetaDataDictionary();
+  if( !ExposeMetaData< std::string >( dictionary, "RawDataFileName", dataFileName )
+    || !ExposeMetaData< SizeValueType >( dictionary, "RawDataOffset", offset )
+    || !ExposeMetaData< bool >( dictionary, "RawDataIsBigEndian", isBigEndian ) )
+  {
+    return false;
+  }
+  return !dataFileName.empty();
+
+} // end LocateFromMetaDataDictionary()
+
+
+/**
+ * ****************** GetDataFileName *********************************
+ */
+
+std::string
+RawImageDataLocator::GetDataFileName( const std::string & headerFileName,
+  const std::string & dataFileName )
+{
+  if( itksys::SystemTools::FileIsFullPath( dataFileName.c_str() ) )
+  {
+    return dataFileName;
+  }
+  const std::string path = itksys::SystemTools::GetFilenamePath( headerFileName );
+  return path.empty() ? dataFileName : path + "/" + dataFileName;
+
+} // end GetDataFileName()
+
+
+/**
+ * ****************** CheckDataRegion *********************************
+ */
+
+bool
+RawImageDataLocator::CheckDataRegion( const std::string & dataFileName,
+  const OffsetValueType headerSize, const SizeValueType numberOfBytes,
+  SizeValueType & offset )
+{
+  const OffsetValueType fileSize = MemoryMappedFileRegion::GetFileSize( dataFileName );
+  if( fileSize < 0 || static_cast< SizeValueType >( fileSize ) < numberOfBytes )
+  {
+    return false;
+  }
+
+  offset = headerSize < 0
+    ? static_cast< SizeValueType >( fileSize ) - numberOfBytes
+    : static_cast< SizeValueType >( headerSize );
+  return offset + numberOfBytes <= static_cast< SizeValueType >( fileSize );
+
+} // end CheckDataRegion()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkRawImageDataLocator_cxx
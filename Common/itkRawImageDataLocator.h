@@ -0,0 +1,95 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRawImageDataLocator_h
+#define __itkRawImageDataLocator_h
+
+#include "itkImageIOBase.h"
+
+#include <string>
+
+namespace itk
+{
+
+/** \class RawImageDataLocator
+ *
+ * \brief Finds the raw pixel data of an image file, for memory mapping.
+ *
+ * Locate() determines whether the pixel data of an image file is stored
+ * uncompressed and contiguously in some file, and if so, in which file, at
+ * which offset, and in which byte order. It supports:
+ *
+ * \li MetaImage (.mhd/.mha), with ElementDataFile LOCAL or a single data file;
+ * \li NRRD (.nrrd/.nhdr), with raw encoding and attached or a single detached data file;
+ * \li any ImageIO that publishes the location in its MetaDataDictionary, with
+ *   the keys RawDataFileName (std::string), RawDataOffset (SizeValueType) and
+ *   RawDataIsBigEndian (bool). The MevisDicomTiffImageIO does so for
+ *   uncompressed TIFF files.
+ *
+ * Compressed, ASCII, and multi-file data, data with a line skip, and other
+ * file formats are not supported. Locate() then returns false.
+ *
+ * \ingroup Common
+ */
+
+class RawImageDataLocator
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef RawImageDataLocator Self;
+
+  /** Locate the raw data of fileName, of which imageIO has read the image
+   * information. The data should consist of numberOfBytes bytes.
+   */
+  static bool Locate( const ImageIOBase * imageIO, const std::string & fileName,
+    const SizeValueType numberOfBytes,
+    std::string & dataFileName, SizeValueType & offset, bool & isBigEndian );
+
+private:
+
+  RawImageDataLocator();   // purposely not implemented
+  ~RawImageDataLocator();  // purposely not implemented
+
+  /** Parse the header of a MetaImage. */
+  static bool LocateMetaImage( const std::string & fileName, const SizeValueType numberOfBytes,
+    std::string & dataFileName, SizeValueType & offset, bool & isBigEndian );
+
+  /** Parse the header of a NRRD file. */
+  static bool LocateNrrd( const std::string & fileName, const SizeValueType numberOfBytes,
+    std::string & dataFileName, SizeValueType & offset, bool & isBigEndian );
+
+  /** Read the location from the MetaDataDictionary of the ImageIO. */
+  static bool LocateFromMetaDataDictionary( const ImageIOBase * imageIO,
+    std::string & dataFileName, SizeValueType & offset, bool & isBigEndian );
+
+  /** Make a data file name relative to the directory of the header file. */
+  static std::string GetDataFileName( const std::string & headerFileName,
+    const std::string & dataFileName );
+
+  /** Check that the file contains numberOfBytes bytes at offset. A negative
+   * header size means that the data is at the end of the file.
+   */
+  static bool CheckDataRegion( const std::string & dataFileName,
+    const OffsetValueType headerSize, const SizeValueType numberOfBytes,
+    SizeValueType & offset );
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkRawImageDataLocator_h
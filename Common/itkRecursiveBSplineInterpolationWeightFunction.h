@@ -136,6 +136,17 @@ public:
   void Evaluate( const ContinuousIndexType & index,
     WeightsType & weights, IndexType & startIndex ) const override;
 
+  /** Evaluate the weights at a block of ContinousIndex positions.
+   * Per point SpaceDimension * ( SplineOrder + 1 ) weights are written to
+   * weights, in the same layout as the single point Evaluate(). The loop over
+   * the dimensions is the outer loop, so that the kernel is evaluated for all
+   * points of a block at once.
+   */
+  void Evaluate( const ContinuousIndexType * cindices,
+    const unsigned int numberOfPoints,
+    typename WeightsType::ValueType * weights,
+    IndexType * startIndices ) const;
+
   void EvaluateDerivative( const ContinuousIndexType & index,
     WeightsType & weights, const IndexType & startIndex ) const;
 
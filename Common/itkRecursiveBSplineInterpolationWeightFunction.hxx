@@ -111,6 +111,35 @@ RecursiveBSplineInterpolationWeightFunction< TCoordRep, VSpaceDimension, VSpline
 } // end Evaluate()
 
 
+/**
+ * ********************* Evaluate ****************************
+ */
+
+template< typename TCoordRep, unsigned int VSpaceDimension, unsigned int VSplineOrder >
+void
+RecursiveBSplineInterpolationWeightFunction< TCoordRep, VSpaceDimension, VSplineOrder >
+::Evaluate(
+  const ContinuousIndexType * cindices,
+  const unsigned int numberOfPoints,
+  typename WeightsType::ValueType * weights,
+  IndexType * startIndices ) const
+{
+  const unsigned int numberOfWeights = NumberOfWeights;
+  for( unsigned int i = 0; i < SpaceDimension; ++i )
+  {
+    typename WeightsType::ValueType * weightsPtr = weights + i * ( SplineOrder + 1 );
+    for( unsigned int p = 0; p < numberOfPoints; ++p )
+    {
+      startIndices[ p ][ i ] = Math::Floor< IndexValueType >( cindices[ p ][ i ] + 0.5 - SplineOrder / 2.0 );
+      double x = cindices[ p ][ i ] - static_cast< double >( startIndices[ p ][ i ] );
+      this->m_Kernel->Evaluate( x, weightsPtr );
+      weightsPtr += numberOfWeights;
+    }
+  }
+
+} // end Evaluate()
+
+
 /**
  * ********************* EvaluateDerivative ****************************
  */
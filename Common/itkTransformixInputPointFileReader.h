@@ -22,6 +22,7 @@
 #include "itkMeshFileReaderBase.h"
 
 #include <fstream>
+#include <ostream>
 
 namespace itk
 {
@@ -40,6 +41,22 @@ namespace itk
  *
  * The second word in the text file represents the number of points that
  * should be read.
+ *
+ * The numbers are parsed in large blocks, with a fast path for plain decimal
+ * numbers that gives exactly the same result as std::strtod().
+ *
+ * Alternatively, the points are given in a binary file, which starts with
+ * a header of 24 bytes:
+ * \li bytes 0-7: the characters "ELXPOINT";
+ * \li byte 8: the format version, 1;
+ * \li byte 9: the number of bytes per coordinate, 4 (float) or 8 (double);
+ * \li byte 10: the dimension of the points;
+ * \li byte 11: 1 if the points are indices, 0 if they are world coordinates;
+ * \li bytes 12-15: reserved, 0;
+ * \li bytes 16-23: the number of points, as a little-endian 64-bit integer.
+ *
+ * The coordinates follow, point after point, in little-endian byte order.
+ * A file is recognised as binary by its first eight characters.
  **/
 
 template< class TOutputMesh >
@@ -82,6 +99,25 @@ public:
    */
   itkGetConstMacro( NumberOfPoints, unsigned long );
 
+  /** Get whether the file is a binary point file. */
+  itkGetConstMacro( PointsAreBinary, bool );
+
+  /** Get the number of bytes per coordinate of a binary point file. */
+  itkGetConstMacro( BinaryComponentSize, unsigned int );
+
+  /** The size of the header of a binary point file. */
+  itkStaticConstMacro( BinaryHeaderSize, unsigned int, 24 );
+
+  /** Write the header of a binary point file, as described above. */
+  static void WriteBinaryHeader( std::ostream & output,
+    const unsigned int componentSize, const unsigned int dimension,
+    const bool pointsAreIndices, const unsigned long numberOfPoints );
+
+  /** Parse the number in [begin, end), which must be entirely numeric.
+   * Returns false if it is not a number.
+   */
+  static bool ParseNumber( const char * begin, const char * end, double & value );
+
   /** Prepare the allocation of the output mesh during the first back
    * propagation of the pipeline. Updates the PointsAreIndices and NumberOfPoints.
    */
@@ -95,8 +131,16 @@ protected:
   /** Fill the point container of the output. */
   void GenerateData( void ) override;
 
+  /** Read the coordinates from a text file. */
+  void ReadTextPoints( void );
+
+  /** Read the coordinates from a binary file. */
+  void ReadBinaryPoints( void );
+
   unsigned long m_NumberOfPoints;
   bool          m_PointsAreIndices;
+  bool          m_PointsAreBinary;
+  unsigned int  m_BinaryComponentSize;
 
   std::ifstream m_Reader;
 
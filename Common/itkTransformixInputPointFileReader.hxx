@@ -20,6 +20,14 @@
 #define __itkTransformixInputPointFileReader_hxx
 
 #include "itkTransformixInputPointFileReader.h"
+#include "itkByteSwapper.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
 
 namespace itk
 {
@@ -32,8 +40,10 @@ template< class TOutputMesh >
 TransformixInputPointFileReader< TOutputMesh >
 ::TransformixInputPointFileReader()
 {
-  this->m_NumberOfPoints   = 0;
-  this->m_PointsAreIndices = false;
+  this->m_NumberOfPoints      = 0;
+  this->m_PointsAreIndices    = false;
+  this->m_PointsAreBinary     = false;
+  this->m_BinaryComponentSize = 0;
 } // end constructor
 
 
@@ -69,7 +79,69 @@ TransformixInputPointFileReader< TOutputMesh >
   {
     this->m_Reader.close();
   }
-  this->m_Reader.open( this->m_FileName.c_str() );
+  this->m_Reader.open( this->m_FileName.c_str(), std::ios::in | std::ios::binary );
+
+  /** The size of the file, to check the number of points in the header against. */
+  this->m_Reader.seekg( 0, std::ios::end );
+  const std::uint64_t fileSize = static_cast< std::uint64_t >( this->m_Reader.tellg() );
+  this->m_Reader.seekg( 0 );
+
+  /** Check whether it is a binary point file. */
+  char header[ Self::BinaryHeaderSize ];
+  this->m_Reader.read( header, Self::BinaryHeaderSize );
+  this->m_PointsAreBinary
+    = this->m_Reader.gcount() == static_cast< std::streamsize >( Self::BinaryHeaderSize )
+    && std::strncmp( header, "ELXPOINT", 8 ) == 0;
+  if( this->m_PointsAreBinary )
+  {
+    const unsigned int version   = static_cast< unsigned char >( header[ 8 ] );
+    const unsigned int dimension = static_cast< unsigned char >( header[ 10 ] );
+    this->m_BinaryComponentSize = static_cast< unsigned char >( header[ 9 ] );
+    this->m_PointsAreIndices    = header[ 11 ] != 0;
+    std::uint64_t numberOfPoints = 0;
+    std::memcpy( &numberOfPoints, header + 16, sizeof( numberOfPoints ) );
+    ByteSwapper< std::uint64_t >::SwapFromSystemToLittleEndian( &numberOfPoints );
+    this->m_NumberOfPoints = static_cast< unsigned long >( numberOfPoints );
+
+    if( version != 1
+      || ( this->m_BinaryComponentSize != 4 && this->m_BinaryComponentSize != 8 )
+      || dimension != OutputMeshType::PointDimension )
+    {
+      std::ostringstream msg;
+      msg << "The binary point file has version " << version
+          << ", " << this->m_BinaryComponentSize << " bytes per coordinate and dimension "
+          << dimension << ", while version 1, 4 or 8 bytes per coordinate and dimension "
+          << OutputMeshType::PointDimension << " are supported."
+          << std::endl << "Filename: " << this->m_FileName
+          << std::endl;
+      MeshFileReaderException e( __FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION );
+      throw e;
+    }
+
+    /** Check the number of points against the file size, before any memory is
+     * allocated for them. The division avoids an overflow for a corrupt header.
+     */
+    const std::uint64_t pointSize = dimension * this->m_BinaryComponentSize;
+    if( numberOfPoints > ( fileSize - Self::BinaryHeaderSize ) / pointSize
+      || this->m_NumberOfPoints != numberOfPoints )
+    {
+      std::ostringstream msg;
+      msg << "The binary point file header specifies " << numberOfPoints
+          << " points, while the file has " << fileSize << " bytes, which is room for only "
+          << ( fileSize - Self::BinaryHeaderSize ) / pointSize << " points."
+          << std::endl << "Filename: " << this->m_FileName
+          << std::endl;
+      MeshFileReaderException e( __FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION );
+      throw e;
+    }
+
+    /** Leave the file open for the generate data method */
+    return;
+  }
+
+  /** It is a text file, so start reading it from the beginning. */
+  this->m_Reader.clear();
+  this->m_Reader.seekg( 0 );
 
   /** Read the first entry */
   std::string indexOrPoint;
@@ -95,6 +167,21 @@ TransformixInputPointFileReader< TOutputMesh >
     this->m_NumberOfPoints   = atoi( indexOrPoint.c_str() );
   }
 
+  /** Every point takes at least one character per coordinate, separated by
+   * white space, so a larger number of points cannot be in the file.
+   */
+  const std::uint64_t minimumPointSize = 2 * OutputMeshType::PointDimension - 1;
+  if( this->m_NumberOfPoints > fileSize / minimumPointSize )
+  {
+    std::ostringstream msg;
+    msg << "The point file specifies " << this->m_NumberOfPoints
+        << " points, while the file has only " << fileSize << " bytes."
+        << std::endl << "Filename: " << this->m_FileName
+        << std::endl;
+    MeshFileReaderException e( __FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION );
+    throw e;
+  }
+
   /** Leave the file open for the generate data method */
 
 } // end GenerateOutputInformation()
@@ -108,67 +195,343 @@ template< class TOutputMesh >
 void
 TransformixInputPointFileReader< TOutputMesh >
 ::GenerateData( void )
+{
+  if( !this->m_Reader.is_open() )
+  {
+    std::ostringstream msg;
+    msg << "The file has unexpectedly been closed. "
+        << std::endl << "Filename: " << this->m_FileName
+        << std::endl;
+    MeshFileReaderException e( __FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION );
+    throw e;
+  }
+
+  /** Read the file */
+  if( this->m_PointsAreBinary )
+  {
+    this->ReadBinaryPoints();
+  }
+  else
+  {
+    this->ReadTextPoints();
+  }
+
+  /** Close the reader */
+  this->m_Reader.close();
+
+  /** This indicates that the current BufferedRegion is equal to the
+   * requested region. This action prevents useless re-executions of
+   * the pipeline.
+   * (I copied this from the BinaryMaskToNarrowBandPointSetFilter) */
+  OutputMeshPointer output = this->GetOutput();
+  output->SetBufferedRegion( output->GetRequestedRegion() );
+
+} // end GenerateData()
+
+
+/**
+ * ***************ReadTextPoints ***********
+ */
+
+template< class TOutputMesh >
+void
+TransformixInputPointFileReader< TOutputMesh >
+::ReadTextPoints( void )
 {
   typedef typename OutputMeshType::PointsContainer PointsContainerType;
   typedef typename PointsContainerType::Pointer    PointsContainerPointer;
   typedef typename OutputMeshType::PointType       PointType;
+  typedef typename PointType::ValueType            CoordinateType;
   const unsigned int dimension = OutputMeshType::PointDimension;
 
   OutputMeshPointer      output = this->GetOutput();
   PointsContainerPointer points = PointsContainerType::New();
+  points->Reserve( this->m_NumberOfPoints );
 
-  /** Read the file */
-  if( this->m_Reader.is_open() )
+  /** The file is read in blocks. The data that is not parsed yet is
+   * in [begin, end) of the buffer.
+   */
+  std::vector< char > buffer( 1 << 20 );
+  std::size_t         begin     = 0;
+  std::size_t         end       = 0;
+  bool                endOfFile = false;
+
+  /** Move the remaining data to the front, and append the next block. */
+  const auto refill = [ & ]() -> bool
   {
-    for( unsigned int i = 0; i < this->m_NumberOfPoints; ++i )
+    if( endOfFile || ( begin == 0 && end == buffer.size() ) )
     {
-      // read point from textfile
-      PointType point;
-      for( unsigned int j = 0; j < dimension; j++ )
+      return false;
+    }
+    std::copy( buffer.begin() + begin, buffer.begin() + end, buffer.begin() );
+    end  -= begin;
+    begin = 0;
+    this->m_Reader.read( &buffer[ end ], buffer.size() - end );
+    const std::size_t numberOfBytesRead = static_cast< std::size_t >( this->m_Reader.gcount() );
+    end      += numberOfBytesRead;
+    endOfFile = numberOfBytesRead == 0;
+    return !endOfFile;
+  };
+
+  const auto isSpace = []( const char c ) -> bool
+  {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+  };
+
+  PointType point;
+  for( unsigned long i = 0; i < this->m_NumberOfPoints; ++i )
+  {
+    // read point from textfile
+    for( unsigned int j = 0; j < dimension; j++ )
+    {
+      /** Skip the white space before the number. */
+      bool foundNumber = false;
+      do
       {
-        if( !this->m_Reader.eof() )
+        while( begin < end && isSpace( buffer[ begin ] ) )
         {
-          this->m_Reader >> point[ j ];
+          ++begin;
         }
-        else
+        foundNumber = begin < end;
+      }
+      while( !foundNumber && refill() );
+
+      if( !foundNumber )
+      {
+        std::ostringstream msg;
+        msg << "The file is not large enough. "
+            << std::endl << "Filename: " << this->m_FileName
+            << std::endl;
+        MeshFileReaderException e( __FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION );
+        throw e;
+      }
+
+      /** Find the end of the number, which may be in the next block. */
+      std::size_t numberEnd = begin;
+      while( true )
+      {
+        while( numberEnd < end && !isSpace( buffer[ numberEnd ] ) )
         {
-          std::ostringstream msg;
-          msg << "The file is not large enough. "
-              << std::endl << "Filename: " << this->m_FileName
-              << std::endl;
-          MeshFileReaderException e( __FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION );
-          throw e;
-          return;
+          ++numberEnd;
         }
+        const std::size_t length = numberEnd - begin;
+        if( numberEnd < end || !refill() )
+        {
+          break;
+        }
+        numberEnd = begin + length;
       }
-      points->push_back( point );
+
+      double value = 0.0;
+      if( !Self::ParseNumber( &buffer[ begin ], &buffer[ 0 ] + numberEnd, value ) )
+      {
+        std::ostringstream msg;
+        msg << "The coordinate \"" << std::string( &buffer[ begin ], &buffer[ 0 ] + numberEnd )
+            << "\" of point " << i << " is not a number. "
+            << std::endl << "Filename: " << this->m_FileName
+            << std::endl;
+        MeshFileReaderException e( __FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION );
+        throw e;
+      }
+      point[ j ] = static_cast< CoordinateType >( value );
+      begin      = numberEnd;
     }
+    points->ElementAt( i ) = point;
   }
-  else
+
+  /** set in output */
+  output->Initialize();
+  output->SetPoints( points );
+
+} // end ReadTextPoints()
+
+
+/**
+ * ***************ReadBinaryPoints ***********
+ */
+
+template< class TOutputMesh >
+void
+TransformixInputPointFileReader< TOutputMesh >
+::ReadBinaryPoints( void )
+{
+  typedef typename OutputMeshType::PointsContainer PointsContainerType;
+  typedef typename PointsContainerType::Pointer    PointsContainerPointer;
+  typedef typename OutputMeshType::PointType       PointType;
+  typedef typename PointType::ValueType            CoordinateType;
+  const unsigned int dimension = OutputMeshType::PointDimension;
+
+  OutputMeshPointer      output = this->GetOutput();
+  PointsContainerPointer points = PointsContainerType::New();
+  points->Reserve( this->m_NumberOfPoints );
+
+  /** Read the coordinates in blocks of points. */
+  const unsigned long pointsPerBlock = 1 << 16;
+  const std::size_t   pointSize      = dimension * this->m_BinaryComponentSize;
+  std::vector< char > buffer( pointsPerBlock * pointSize );
+  PointType           point;
+  for( unsigned long first = 0; first < this->m_NumberOfPoints; first += pointsPerBlock )
   {
-    std::ostringstream msg;
-    msg << "The file has unexpectedly been closed. "
-        << std::endl << "Filename: " << this->m_FileName
-        << std::endl;
-    MeshFileReaderException e( __FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION );
-    throw e;
-    return;
+    const unsigned long numberOfPointsInBlock
+      = std::min( pointsPerBlock, this->m_NumberOfPoints - first );
+    this->m_Reader.read( &buffer[ 0 ], numberOfPointsInBlock * pointSize );
+    if( this->m_Reader.gcount() != static_cast< std::streamsize >( numberOfPointsInBlock * pointSize ) )
+    {
+      std::ostringstream msg;
+      msg << "The file is not large enough. "
+          << std::endl << "Filename: " << this->m_FileName
+          << std::endl;
+      MeshFileReaderException e( __FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION );
+      throw e;
+    }
+
+    const char * data = &buffer[ 0 ];
+    for( unsigned long i = 0; i < numberOfPointsInBlock; ++i )
+    {
+      for( unsigned int j = 0; j < dimension; ++j, data += this->m_BinaryComponentSize )
+      {
+        if( this->m_BinaryComponentSize == 4 )
+        {
+          float value;
+          std::memcpy( &value, data, sizeof( value ) );
+          ByteSwapper< float >::SwapFromSystemToLittleEndian( &value );
+          point[ j ] = static_cast< CoordinateType >( value );
+        }
+        else
+        {
+          double value;
+          std::memcpy( &value, data, sizeof( value ) );
+          ByteSwapper< double >::SwapFromSystemToLittleEndian( &value );
+          point[ j ] = static_cast< CoordinateType >( value );
+        }
+      }
+      points->ElementAt( first + i ) = point;
+    }
   }
 
   /** set in output */
   output->Initialize();
   output->SetPoints( points );
 
-  /** Close the reader */
-  this->m_Reader.close();
+} // end ReadBinaryPoints()
 
-  /** This indicates that the current BufferedRegion is equal to the
-   * requested region. This action prevents useless re-executions of
-   * the pipeline.
-   * (I copied this from the BinaryMaskToNarrowBandPointSetFilter) */
-  output->SetBufferedRegion( output->GetRequestedRegion() );
 
-} // end GenerateData()
+/**
+ * ***************WriteBinaryHeader ***********
+ */
+
+template< class TOutputMesh >
+void
+TransformixInputPointFileReader< TOutputMesh >
+::WriteBinaryHeader( std::ostream & output,
+  const unsigned int componentSize, const unsigned int dimension,
+  const bool pointsAreIndices, const unsigned long numberOfPoints )
+{
+  char header[ Self::BinaryHeaderSize ];
+  std::memset( header, 0, Self::BinaryHeaderSize );
+  std::memcpy( header, "ELXPOINT", 8 );
+  header[ 8 ]  = 1;
+  header[ 9 ]  = static_cast< char >( componentSize );
+  header[ 10 ] = static_cast< char >( dimension );
+  header[ 11 ] = pointsAreIndices ? 1 : 0;
+
+  std::uint64_t numberOfPoints64 = numberOfPoints;
+  ByteSwapper< std::uint64_t >::SwapFromSystemToLittleEndian( &numberOfPoints64 );
+  std::memcpy( header + 16, &numberOfPoints64, sizeof( numberOfPoints64 ) );
+
+  output.write( header, Self::BinaryHeaderSize );
+
+} // end WriteBinaryHeader()
+
+
+/**
+ * ***************ParseNumber ***********
+ */
+
+template< class TOutputMesh >
+bool
+TransformixInputPointFileReader< TOutputMesh >
+::ParseNumber( const char * begin, const char * end, double & value )
+{
+  /** Fast path for numbers like [+-]ddd[.ddd][(e|E)[+-]ddd]. When the decimal
+   * mantissa has at most 19 digits and is below 2^53, and the power of ten is
+   * at most 22, both are exact doubles. A single multiplication or division
+   * is then correctly rounded, and gives the same value as strtod.
+   */
+  static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const char * p        = begin;
+  bool         negative = false;
+  if( p != end && ( *p == '+' || *p == '-' ) )
+  {
+    negative = *p == '-';
+    ++p;
+  }
+
+  std::uint64_t mantissa          = 0;
+  unsigned int  numberOfDigits    = 0;
+  unsigned int  significantDigits = 0;
+  int           exponent          = 0;
+  for( ; p != end && *p >= '0' && *p <= '9'; ++p, ++numberOfDigits )
+  {
+    if( mantissa != 0 || *p != '0' )
+    {
+      mantissa = 10 * mantissa + static_cast< std::uint64_t >( *p - '0' );
+      ++significantDigits;
+    }
+  }
+  if( p != end && *p == '.' )
+  {
+    for( ++p; p != end && *p >= '0' && *p <= '9'; ++p, ++numberOfDigits )
+    {
+      if( mantissa != 0 || *p != '0' )
+      {
+        mantissa = 10 * mantissa + static_cast< std::uint64_t >( *p - '0' );
+        ++significantDigits;
+      }
+      --exponent;
+    }
+  }
+
+  bool fastPath = numberOfDigits > 0 && significantDigits <= 19;
+  if( fastPath && p != end && ( *p == 'e' || *p == 'E' ) )
+  {
+    ++p;
+    bool negativeExponent = false;
+    if( p != end && ( *p == '+' || *p == '-' ) )
+    {
+      negativeExponent = *p == '-';
+      ++p;
+    }
+    int exponentValue = 0;
+    fastPath = p != end && *p >= '0' && *p <= '9';
+    for( ; p != end && *p >= '0' && *p <= '9'; ++p )
+    {
+      exponentValue = std::min( 10 * exponentValue + ( *p - '0' ), 100000 );
+    }
+    exponent += negativeExponent ? -exponentValue : exponentValue;
+  }
+
+  const std::uint64_t maximumExactMantissa = static_cast< std::uint64_t >( 1 ) << 53;
+  if( fastPath && p == end && mantissa <= maximumExactMantissa
+    && exponent >= -22 && exponent <= 22 )
+  {
+    double result = static_cast< double >( mantissa );
+    result = exponent < 0 ? result / powersOfTen[ -exponent ] : result * powersOfTen[ exponent ];
+    value  = negative ? -result : result;
+    return true;
+  }
+
+  /** Otherwise, e.g. for many digits, large exponents, inf or nan. */
+  const std::string number( begin, end );
+  char *            numberEnd = nullptr;
+  value = std::strtod( number.c_str(), &numberEnd );
+  return !number.empty() && numberEnd == number.c_str() + number.size();
+
+} // end ParseNumber()
 
 
 } // end namespace itk
@@ -0,0 +1,134 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkWarmStartSymmetricEigenSystem_h
+#define __itkWarmStartSymmetricEigenSystem_h
+
+#include "vnl/vnl_matrix.h"
+#include "vnl/vnl_vector.h"
+
+namespace itk
+{
+
+/** \class WarmStartSymmetricEigenSystem
+ *
+ * \brief Computes all eigenvalues and eigenvectors of a series of slowly
+ * changing symmetric matrices.
+ *
+ * Metrics like the PCAMetric2 decompose a small correlation matrix in every
+ * iteration of the optimizer. Between two iterations the matrix hardly
+ * changes, and the eigenvectors of the previous iteration nearly diagonalize
+ * the new matrix. Compute() therefore transforms the matrix to the basis of
+ * the previous eigenvectors, and diagonalizes the result with cyclic Jacobi
+ * sweeps. Rotations of off-diagonal elements that are already negligible are
+ * skipped, so that for small changes only a few rotations are needed.
+ *
+ * The first call, a call with a matrix of another size, and a call for which
+ * the sweeps do not converge compute the decomposition from scratch, with
+ * vnl_symmetric_eigensystem. Like the latter, the eigenvalues are in
+ * ascending order, and the eigenvectors are the columns of the eigenvector
+ * matrix. The eigenvectors are only determined up to their sign, and up to a
+ * rotation within the eigenspace of a repeated eigenvalue, so they may differ
+ * from those of vnl_symmetric_eigensystem.
+ *
+ * This is a lightweight class, not an itk::Object.
+ *
+ * \ingroup Numerics
+ */
+
+template< class TRealType >
+class WarmStartSymmetricEigenSystem
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef WarmStartSymmetricEigenSystem Self;
+
+  /** Typedefs for the matrices and vectors. */
+  typedef TRealType                RealType;
+  typedef vnl_matrix< RealType >   MatrixType;
+  typedef vnl_vector< RealType >   VectorType;
+
+  /** Constructor. */
+  WarmStartSymmetricEigenSystem();
+
+  /** Set/Get the relative tolerance on the off-diagonal elements. The sweeps
+   * stop when the Frobenius norm of the off-diagonal part is below this
+   * tolerance times the Frobenius norm of the matrix. Default: 1e-12.
+   */
+  void SetRelativeTolerance( const double tolerance ) { this->m_RelativeTolerance = tolerance; }
+  double GetRelativeTolerance( void ) const { return this->m_RelativeTolerance; }
+
+  /** Set/Get the maximum number of Jacobi sweeps of a warm start, after which
+   * the decomposition is computed from scratch. Default: 10.
+   */
+  void SetMaximumNumberOfSweeps( const unsigned int sweeps ) { this->m_MaximumNumberOfSweeps = sweeps; }
+  unsigned int GetMaximumNumberOfSweeps( void ) const { return this->m_MaximumNumberOfSweeps; }
+
+  /** Compute the eigenvalues and eigenvectors of the symmetric matrix A,
+   * starting from the eigenvectors of the previous call if possible.
+   */
+  void Compute( const MatrixType & A );
+
+  /** Forget the eigenvectors of the previous call, so that the next call of
+   * Compute() starts from scratch.
+   */
+  void Reset( void );
+
+  /** Get the eigenvalues, in ascending order. */
+  const VectorType & GetEigenValues( void ) const { return this->m_EigenValues; }
+  RealType GetEigenValue( const unsigned int i ) const { return this->m_EigenValues[ i ]; }
+
+  /** Get the eigenvectors, as the columns of a matrix. */
+  const MatrixType & GetEigenVectors( void ) const { return this->m_EigenVectors; }
+  VectorType GetEigenVector( const unsigned int i ) const { return this->m_EigenVectors.get_column( i ); }
+
+  /** Get whether the last call of Compute() started from the previous
+   * eigenvectors, and how many sweeps it took.
+   */
+  bool GetLastComputeWasWarmStarted( void ) const { return this->m_LastComputeWasWarmStarted; }
+  unsigned int GetNumberOfSweeps( void ) const { return this->m_NumberOfSweeps; }
+
+private:
+
+  /** Compute the decomposition from scratch. */
+  void ComputeFromScratch( const MatrixType & A );
+
+  /** Orthonormalize the columns of the eigenvector matrix, to prevent the
+   * rounding errors of many warm starts from accumulating.
+   */
+  void OrthonormalizeEigenVectors( void );
+
+  /** Sort the eigenvalues and the eigenvectors in ascending order. */
+  void SortEigenValues( void );
+
+  double       m_RelativeTolerance;
+  unsigned int m_MaximumNumberOfSweeps;
+  VectorType   m_EigenValues;
+  MatrixType   m_EigenVectors;
+  bool         m_LastComputeWasWarmStarted;
+  unsigned int m_NumberOfSweeps;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkWarmStartSymmetricEigenSystem.hxx"
+#endif
+
+#endif // end #ifndef __itkWarmStartSymmetricEigenSystem_h
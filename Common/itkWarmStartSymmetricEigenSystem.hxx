@@ -0,0 +1,296 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkWarmStartSymmetricEigenSystem_hxx
+#define __itkWarmStartSymmetricEigenSystem_hxx
+
+#include "itkWarmStartSymmetricEigenSystem.h"
+
+#include "vnl/algo/vnl_symmetric_eigensystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template< class TRealType >
+WarmStartSymmetricEigenSystem< TRealType >
+::WarmStartSymmetricEigenSystem() :
+  m_RelativeTolerance( 1e-12 ),
+  m_MaximumNumberOfSweeps( 10 ),
+  m_LastComputeWasWarmStarted( false ),
+  m_NumberOfSweeps( 0 )
+{} // end Constructor
+
+
+/**
+ * ********************* Reset ****************************
+ */
+
+template< class TRealType >
+void
+WarmStartSymmetricEigenSystem< TRealType >
+::Reset( void )
+{
+  this->m_EigenValues.clear();
+  this->m_EigenVectors.clear();
+  this->m_LastComputeWasWarmStarted = false;
+  this->m_NumberOfSweeps            = 0;
+
+} // end Reset()
+
+
+/**
+ * ********************* Compute ****************************
+ */
+
+template< class TRealType >
+void
+WarmStartSymmetricEigenSystem< TRealType >
+::Compute( const MatrixType & A )
+{
+  const unsigned int n = A.rows();
+  if( n == 0 || this->m_MaximumNumberOfSweeps == 0
+    || this->m_EigenVectors.rows() != n || this->m_EigenVectors.cols() != n )
+  {
+    this->ComputeFromScratch( A );
+    return;
+  }
+
+  /** Transform A to the basis of the previous eigenvectors, B = V^T A V. */
+  this->OrthonormalizeEigenVectors();
+  MatrixType & V = this->m_EigenVectors;
+  MatrixType   B( V.transpose() * A * V );
+  for( unsigned int p = 0; p < n; ++p )
+  {
+    for( unsigned int q = p + 1; q < n; ++q )
+    {
+      const RealType bpq = 0.5 * ( B( p, q ) + B( q, p ) );
+      B( p, q ) = bpq;
+      B( q, p ) = bpq;
+    }
+  }
+
+  /** The sweeps stop when the squared norm of the off-diagonal part drops
+   * below offTolerance. An element is not rotated when it contributes less
+   * than its share of that tolerance, so that a sweep without rotations
+   * also means convergence.
+   */
+  const RealType normB           = B.frobenius_norm();
+  const RealType offTolerance    = this->m_RelativeTolerance * this->m_RelativeTolerance * normB * normB;
+  const RealType rotateTolerance = offTolerance / static_cast< RealType >( n * n );
+
+  bool         converged = false;
+  unsigned int sweep     = 0;
+  while( true )
+  {
+    RealType off = 0.0;
+    for( unsigned int p = 0; p < n; ++p )
+    {
+      for( unsigned int q = p + 1; q < n; ++q )
+      {
+        off += 2.0 * B( p, q ) * B( p, q );
+      }
+    }
+    if( off <= offTolerance )
+    {
+      converged = true;
+      break;
+    }
+    if( sweep == this->m_MaximumNumberOfSweeps )
+    {
+      break;
+    }
+    ++sweep;
+
+    /** One cyclic Jacobi sweep over the upper triangle. */
+    for( unsigned int p = 0; p < n; ++p )
+    {
+      for( unsigned int q = p + 1; q < n; ++q )
+      {
+        const RealType bpq = B( p, q );
+        if( bpq * bpq <= rotateTolerance )
+        {
+          continue;
+        }
+
+        /** The rotation that annihilates B(p,q): t is the smaller root of
+         * t^2 + 2 theta t - 1 = 0.
+         */
+        const RealType theta = ( B( q, q ) - B( p, p ) ) / ( 2.0 * bpq );
+        RealType       t;
+        if( std::abs( theta ) > 1e150 )
+        {
+          t = 0.5 / theta;
+        }
+        else
+        {
+          t = 1.0 / ( std::abs( theta ) + std::sqrt( theta * theta + 1.0 ) );
+          t = theta < 0.0 ? -t : t;
+        }
+        const RealType c = 1.0 / std::sqrt( t * t + 1.0 );
+        const RealType s = t * c;
+
+        /** B = J^T B J, with J the rotation in the (p,q) plane, and V = V J. */
+        for( unsigned int k = 0; k < n; ++k )
+        {
+          const RealType bkp = B( k, p );
+          const RealType bkq = B( k, q );
+          B( k, p ) = c * bkp - s * bkq;
+          B( k, q ) = s * bkp + c * bkq;
+        }
+        for( unsigned int k = 0; k < n; ++k )
+        {
+          const RealType bpk = B( p, k );
+          const RealType bqk = B( q, k );
+          B( p, k ) = c * bpk - s * bqk;
+          B( q, k ) = s * bpk + c * bqk;
+        }
+        B( p, q ) = 0.0;
+        B( q, p ) = 0.0;
+        for( unsigned int k = 0; k < n; ++k )
+        {
+          const RealType vkp = V( k, p );
+          const RealType vkq = V( k, q );
+          V( k, p ) = c * vkp - s * vkq;
+          V( k, q ) = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+
+  if( !converged )
+  {
+    this->ComputeFromScratch( A );
+    return;
+  }
+
+  this->m_EigenValues.set_size( n );
+  for( unsigned int i = 0; i < n; ++i )
+  {
+    this->m_EigenValues[ i ] = B( i, i );
+  }
+  this->SortEigenValues();
+  this->m_LastComputeWasWarmStarted = true;
+  this->m_NumberOfSweeps            = sweep;
+
+} // end Compute()
+
+
+/**
+ * ********************* ComputeFromScratch ****************************
+ */
+
+template< class TRealType >
+void
+WarmStartSymmetricEigenSystem< TRealType >
+::ComputeFromScratch( const MatrixType & A )
+{
+  vnl_symmetric_eigensystem< RealType > eig( A );
+  this->m_EigenValues               = eig.D.diagonal();
+  this->m_EigenVectors              = eig.V;
+  this->m_LastComputeWasWarmStarted = false;
+  this->m_NumberOfSweeps            = 0;
+
+} // end ComputeFromScratch()
+
+
+/**
+ * ********************* OrthonormalizeEigenVectors ****************************
+ */
+
+template< class TRealType >
+void
+WarmStartSymmetricEigenSystem< TRealType >
+::OrthonormalizeEigenVectors( void )
+{
+  /** Modified Gram-Schmidt on the columns. */
+  MatrixType &       V = this->m_EigenVectors;
+  const unsigned int n = V.rows();
+  for( unsigned int j = 0; j < n; ++j )
+  {
+    for( unsigned int i = 0; i < j; ++i )
+    {
+      RealType dot = 0.0;
+      for( unsigned int k = 0; k < n; ++k )
+      {
+        dot += V( k, i ) * V( k, j );
+      }
+      for( unsigned int k = 0; k < n; ++k )
+      {
+        V( k, j ) -= dot * V( k, i );
+      }
+    }
+    RealType norm = 0.0;
+    for( unsigned int k = 0; k < n; ++k )
+    {
+      norm += V( k, j ) * V( k, j );
+    }
+    norm = std::sqrt( norm );
+    if( norm > 0.0 )
+    {
+      for( unsigned int k = 0; k < n; ++k )
+      {
+        V( k, j ) /= norm;
+      }
+    }
+  }
+
+} // end OrthonormalizeEigenVectors()
+
+
+/**
+ * ********************* SortEigenValues ****************************
+ */
+
+template< class TRealType >
+void
+WarmStartSymmetricEigenSystem< TRealType >
+::SortEigenValues( void )
+{
+  const unsigned int          n = this->m_EigenValues.size();
+  std::vector< unsigned int > order( n );
+  for( unsigned int i = 0; i < n; ++i )
+  {
+    order[ i ] = i;
+  }
+  const VectorType & values = this->m_EigenValues;
+  std::stable_sort( order.begin(), order.end(),
+    [ &values ]( const unsigned int a, const unsigned int b ) { return values[ a ] < values[ b ]; } );
+
+  VectorType sortedValues( n );
+  MatrixType sortedVectors( n, n );
+  for( unsigned int i = 0; i < n; ++i )
+  {
+    sortedValues[ i ] = values[ order[ i ] ];
+    sortedVectors.set_column( i, this->m_EigenVectors.get_column( order[ i ] ) );
+  }
+  this->m_EigenValues  = sortedValues;
+  this->m_EigenVectors = sortedVectors;
+
+} // end SortEigenValues()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkWarmStartSymmetricEigenSystem_hxx
@@ -0,0 +1,399 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkWorkStealingThreadPool_cxx
+#define __itkWorkStealingThreadPool_cxx
+
+#include "itkWorkStealingThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace itk
+{
+
+/**
+ * ****************** Job *********************************
+ *
+ * A job is shared between the submitting thread and the worker threads
+ * that help executing it. The range of chunks of every slot is protected
+ * by its own lock, and padded to avoid false sharing.
+ */
+
+struct WorkStealingThreadPool::Job
+{
+  struct SlotRange
+  {
+    std::mutex    m_Mutex;
+    SizeValueType m_Front;
+    SizeValueType m_Back;
+    char          m_Padding[ 64 ];
+  };
+
+  Job( const ThreadIdType numberOfSlots, const SizeValueType size,
+    const SizeValueType chunkSize, const bool steal,
+    const ChunkFunctionType & function ) :
+    m_NumberOfSlots( numberOfSlots ),
+    m_Size( size ),
+    m_ChunkSize( chunkSize ),
+    m_Steal( steal ),
+    m_Function( function ),
+    m_Ranges( numberOfSlots ),
+    m_NextSlot( 0 ),
+    m_RemainingChunks( 0 ),
+    m_HelpersWanted( 0 )
+  {
+    /** Distribute the chunks evenly over the slots. */
+    const SizeValueType numberOfChunks = ( size + chunkSize - 1 ) / chunkSize;
+    for( ThreadIdType i = 0; i < numberOfSlots; ++i )
+    {
+      this->m_Ranges[ i ].m_Front = numberOfChunks * i / numberOfSlots;
+      this->m_Ranges[ i ].m_Back  = numberOfChunks * ( i + 1 ) / numberOfSlots;
+    }
+    this->m_RemainingChunks = numberOfChunks;
+  }
+
+
+  /** Take a chunk from the front of the slot, i.e. from its own work. */
+  bool PopFront( const ThreadIdType slot, SizeValueType & chunk )
+  {
+    SlotRange &                   range = this->m_Ranges[ slot ];
+    std::lock_guard< std::mutex > lock( range.m_Mutex );
+    if( range.m_Front == range.m_Back ) { return false; }
+    chunk = range.m_Front++;
+    return true;
+  }
+
+
+  /** Take a chunk from the back of the slot, i.e. steal work. */
+  bool PopBack( const ThreadIdType slot, SizeValueType & chunk )
+  {
+    SlotRange &                   range = this->m_Ranges[ slot ];
+    std::lock_guard< std::mutex > lock( range.m_Mutex );
+    if( range.m_Front == range.m_Back ) { return false; }
+    chunk = --range.m_Back;
+    return true;
+  }
+
+
+  /** Execute a single chunk on behalf of the given slot. */
+  void Process( const ThreadIdType slot, const SizeValueType chunk )
+  {
+    const SizeValueType begin = chunk * this->m_ChunkSize;
+    const SizeValueType end   = std::min( begin + this->m_ChunkSize, this->m_Size );
+    try
+    {
+      this->m_Function( slot, begin, end );
+    }
+    catch( ... )
+    {
+      std::lock_guard< std::mutex > lock( this->m_DoneMutex );
+      if( !this->m_Exception ) { this->m_Exception = std::current_exception(); }
+    }
+
+    /** Wake up the submitting thread when this was the last chunk. */
+    if( --this->m_RemainingChunks == 0 )
+    {
+      std::lock_guard< std::mutex > lock( this->m_DoneMutex );
+      this->m_DoneCondition.notify_all();
+    }
+  }
+
+
+  const ThreadIdType            m_NumberOfSlots;
+  const SizeValueType           m_Size;
+  const SizeValueType           m_ChunkSize;
+  const bool                    m_Steal;
+  const ChunkFunctionType       m_Function;
+  std::vector< SlotRange >      m_Ranges;
+  std::atomic< ThreadIdType >   m_NextSlot;
+  std::atomic< SizeValueType >  m_RemainingChunks;
+  ThreadIdType                  m_HelpersWanted; // guarded by the pool mutex
+  std::mutex                    m_DoneMutex;
+  std::condition_variable       m_DoneCondition;
+  std::exception_ptr            m_Exception;
+};
+
+
+/**
+ * ****************** Constructor *********************************
+ */
+
+WorkStealingThreadPool
+::WorkStealingThreadPool()
+{
+  this->m_Stop = false;
+
+} // end Constructor
+
+
+/**
+ * ****************** Destructor *********************************
+ */
+
+WorkStealingThreadPool
+::~WorkStealingThreadPool()
+{
+  {
+    std::lock_guard< std::mutex > lock( this->m_Mutex );
+    this->m_Stop = true;
+  }
+  this->m_Condition.notify_all();
+
+  for( std::size_t i = 0; i < this->m_WorkerThreads.size(); ++i )
+  {
+    this->m_WorkerThreads[ i ].join();
+  }
+
+} // end Destructor
+
+
+/**
+ * ****************** GetInstance *********************************
+ */
+
+WorkStealingThreadPool::Pointer
+WorkStealingThreadPool
+::GetInstance( void )
+{
+  /** Thread-safe initialization of the single elastix-wide instance. */
+  static const Pointer instance = []()
+    {
+      Pointer pool = new Self;
+      pool->UnRegister();
+      return pool;
+    } ();
+
+  return instance;
+
+} // end GetInstance()
+
+
+/**
+ * ****************** GetNumberOfWorkerThreads *********************************
+ */
+
+ThreadIdType
+WorkStealingThreadPool
+::GetNumberOfWorkerThreads( void ) const
+{
+  std::lock_guard< std::mutex > lock( this->m_Mutex );
+  return static_cast< ThreadIdType >( this->m_WorkerThreads.size() );
+
+} // end GetNumberOfWorkerThreads()
+
+
+/**
+ * ****************** EnsureNumberOfWorkerThreads *********************************
+ */
+
+void
+WorkStealingThreadPool
+::EnsureNumberOfWorkerThreads( const ThreadIdType numberOfThreads )
+{
+  std::lock_guard< std::mutex > lock( this->m_Mutex );
+  while( this->m_WorkerThreads.size() < numberOfThreads )
+  {
+    this->m_WorkerThreads.push_back( std::thread( &Self::WorkerLoop, this ) );
+  }
+
+} // end EnsureNumberOfWorkerThreads()
+
+
+/**
+ * ****************** ParallelForSlots *********************************
+ */
+
+void
+WorkStealingThreadPool
+::ParallelForSlots( const ThreadIdType numberOfSlots,
+  const SlotFunctionType & function )
+{
+  if( numberOfSlots == 0 ) { return; }
+
+  /** One chunk per slot, without stealing: each slot is called exactly once. */
+  const ChunkFunctionType chunkFunction
+    = [ &function ]( ThreadIdType slot, SizeValueType, SizeValueType )
+    {
+      function( slot );
+    };
+
+  this->Execute( std::make_shared< Job >(
+    numberOfSlots, numberOfSlots, 1, false, chunkFunction ) );
+
+} // end ParallelForSlots()
+
+
+/**
+ * ****************** ParallelForChunks *********************************
+ */
+
+void
+WorkStealingThreadPool
+::ParallelForChunks( const ThreadIdType numberOfSlots,
+  const SizeValueType size, const SizeValueType chunkSize,
+  const ChunkFunctionType & function )
+{
+  if( numberOfSlots == 0 || size == 0 ) { return; }
+
+  this->Execute( std::make_shared< Job >(
+    numberOfSlots, size, std::max< SizeValueType >( chunkSize, 1 ), true, function ) );
+
+} // end ParallelForChunks()
+
+
+/**
+ * ****************** Execute *********************************
+ */
+
+void
+WorkStealingThreadPool
+::Execute( const JobPointer & job )
+{
+  /** Ask the worker threads for help. */
+  const ThreadIdType numberOfHelpers = job->m_NumberOfSlots - 1;
+  if( numberOfHelpers > 0 )
+  {
+    this->EnsureNumberOfWorkerThreads( numberOfHelpers );
+    {
+      std::lock_guard< std::mutex > lock( this->m_Mutex );
+      job->m_HelpersWanted = numberOfHelpers;
+      this->m_PendingJobs.push_back( job );
+    }
+    this->m_Condition.notify_all();
+  }
+
+  /** The calling thread participates in its own job. */
+  RunJob( *job );
+
+  /** Wait for chunks that are still being processed by the helpers. */
+  {
+    std::unique_lock< std::mutex > lock( job->m_DoneMutex );
+    job->m_DoneCondition.wait( lock, [ &job ]() { return job->m_RemainingChunks == 0; } );
+  }
+
+  /** Helpers that did not show up are not needed anymore. */
+  if( numberOfHelpers > 0 )
+  {
+    std::lock_guard< std::mutex > lock( this->m_Mutex );
+    std::deque< JobPointer >::iterator it
+      = std::find( this->m_PendingJobs.begin(), this->m_PendingJobs.end(), job );
+    if( it != this->m_PendingJobs.end() )
+    {
+      this->m_PendingJobs.erase( it );
+    }
+  }
+
+  if( job->m_Exception )
+  {
+    std::rethrow_exception( job->m_Exception );
+  }
+
+} // end Execute()
+
+
+/**
+ * ****************** WorkerLoop *********************************
+ */
+
+void
+WorkStealingThreadPool
+::WorkerLoop( void )
+{
+  for(;; )
+  {
+    JobPointer job;
+    {
+      std::unique_lock< std::mutex > lock( this->m_Mutex );
+      this->m_Condition.wait( lock,
+        [ this ]() { return this->m_Stop || !this->m_PendingJobs.empty(); } );
+      if( this->m_Stop ) { return; }
+
+      job = this->m_PendingJobs.front();
+      if( --job->m_HelpersWanted == 0 )
+      {
+        this->m_PendingJobs.pop_front();
+      }
+    }
+
+    RunJob( *job );
+  }
+
+} // end WorkerLoop()
+
+
+/**
+ * ****************** RunJob *********************************
+ */
+
+void
+WorkStealingThreadPool
+::RunJob( Job & job )
+{
+  for(;; )
+  {
+    /** Claim a slot that is not yet in use by another thread. */
+    const ThreadIdType slot = job.m_NextSlot++;
+    if( slot >= job.m_NumberOfSlots ) { return; }
+
+    /** First process the own chunks, front to back. */
+    SizeValueType chunk;
+    while( job.PopFront( slot, chunk ) )
+    {
+      job.Process( slot, chunk );
+    }
+
+    /** Then steal from the back of the other slots. Ranges only shrink,
+     * so after a single pass over all victims there is nothing left.
+     */
+    if( job.m_Steal )
+    {
+      for( ThreadIdType i = 1; i < job.m_NumberOfSlots; ++i )
+      {
+        const ThreadIdType victim = ( slot + i ) % job.m_NumberOfSlots;
+        while( job.PopBack( victim, chunk ) )
+        {
+          job.Process( slot, chunk );
+        }
+      }
+      return;
+    }
+  }
+
+} // end RunJob()
+
+
+/**
+ * ****************** PrintSelf *********************************
+ */
+
+void
+WorkStealingThreadPool
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "NumberOfWorkerThreads: "
+     << this->GetNumberOfWorkerThreads() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkWorkStealingThreadPool_cxx
@@ -0,0 +1,144 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkWorkStealingThreadPool_h
+#define __itkWorkStealingThreadPool_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkIntTypes.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace itk
+{
+
+/** \class WorkStealingThreadPool
+ *
+ * \brief A persistent, elastix-wide pool of worker threads.
+ *
+ * The metrics used to launch a fresh set of threads for every call of
+ * GetValue() and GetValueAndDerivative(), i.e. thread creation and joining
+ * at every optimizer iteration. This class keeps a single set of worker
+ * threads alive for the lifetime of the process, so that it can be reused
+ * across iterations, resolutions and the sub-metrics of a combination metric.
+ *
+ * Work is submitted as a job consisting of a number of <em>slots</em>. A slot
+ * is the equivalent of a thread id in the classic ITK threader callbacks:
+ * per-thread variables are indexed by it, and at any moment a slot is used by
+ * at most one thread. Two ways to execute a job are provided:
+ *
+ * \li ParallelForSlots(): the function is called exactly once for each slot.
+ *   This is a drop-in replacement for MultiThreader::SingleMethodExecute().
+ * \li ParallelForChunks(): the range [0, size) is cut into chunks, which are
+ *   initially distributed evenly over the slots. A thread that runs out of
+ *   chunks in its own slot steals chunks from the back of the other slots.
+ *   This gives dynamic load balancing, for example when a mask makes the
+ *   cost per sample uneven. Note that the order in which the chunks are
+ *   accumulated then depends on thread scheduling.
+ *
+ * The calling thread always participates in the execution of its own job.
+ * Therefore a job always finishes, also when all worker threads are busy,
+ * and jobs may be submitted concurrently from several threads.
+ *
+ * \ingroup Common
+ */
+
+class WorkStealingThreadPool : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef WorkStealingThreadPool     Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( WorkStealingThreadPool, Object );
+
+  /** Get the elastix-wide instance of the thread pool. */
+  static Pointer GetInstance( void );
+
+  /** Typedefs for the functions executed by the pool. */
+  typedef std::function< void ( ThreadIdType ) > SlotFunctionType;
+  typedef std::function< void ( ThreadIdType, SizeValueType, SizeValueType ) > ChunkFunctionType;
+
+  /** Call function( slot ) for all slots in [0, numberOfSlots), in parallel.
+   * Blocks until all slots have been processed. Exceptions thrown by the
+   * function are rethrown in the calling thread.
+   */
+  void ParallelForSlots( const ThreadIdType numberOfSlots,
+    const SlotFunctionType & function );
+
+  /** Call function( slot, begin, end ) for all chunks [begin, end) of the
+   * range [0, size), with dynamic load balancing by means of work stealing.
+   * Blocks until the full range has been processed.
+   */
+  void ParallelForChunks( const ThreadIdType numberOfSlots,
+    const SizeValueType size, const SizeValueType chunkSize,
+    const ChunkFunctionType & function );
+
+  /** Get the number of worker threads that are currently alive.
+   * The pool grows on demand; the calling thread is not counted.
+   */
+  ThreadIdType GetNumberOfWorkerThreads( void ) const;
+
+protected:
+
+  WorkStealingThreadPool();
+  ~WorkStealingThreadPool() override;
+
+  void PrintSelf( std::ostream & os, Indent indent ) const override;
+
+private:
+
+  WorkStealingThreadPool( const Self & ); // purposely not implemented
+  void operator=( const Self & );         // purposely not implemented
+
+  struct Job;
+  typedef std::shared_ptr< Job > JobPointer;
+
+  /** Make sure that at least the given number of worker threads exist. */
+  void EnsureNumberOfWorkerThreads( const ThreadIdType numberOfThreads );
+
+  /** Submit a job, participate in it, and wait until it is finished. */
+  void Execute( const JobPointer & job );
+
+  /** The main loop of the worker threads. */
+  void WorkerLoop( void );
+
+  /** Process chunks of a job until no more work can be claimed. */
+  static void RunJob( Job & job );
+
+  std::vector< std::thread >  m_WorkerThreads;
+  std::deque< JobPointer >    m_PendingJobs;
+  mutable std::mutex          m_Mutex;
+  std::condition_variable     m_Condition;
+  bool                        m_Stop;
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkWorkStealingThreadPool_h
@@ -52,6 +52,12 @@ namespace elastix
  *    metric value and its derivative in each iteration. Must be given for each resolution.\n
  *    example: <tt>(NumberOfSpatialSamples 2048 2048 4000)</tt> \n
  *    The default is 5000.
+ * \parameter UseMaskIndex: Whether to draw the samples inside a mask from a precomputed
+ *    index of the voxels inside the mask, plus a random offset within the voxel, instead of
+ *    trying random points in the whole image until one is inside the mask. Much faster for
+ *    small masks. The index is built once per resolution. Not used with UseRandomSampleRegion.\n
+ *    example: <tt>(UseMaskIndex "true")</tt>\n
+ *    Default: false.
  * \parameter UseRandomSampleRegion: Defines whether to randomly select a subregion of the image
  *    in each iteration. When set to "true", also specify the SampleRegionSize.
  *    By setting this option to "true", in combination with the NewSamplesEveryIteration parameter,
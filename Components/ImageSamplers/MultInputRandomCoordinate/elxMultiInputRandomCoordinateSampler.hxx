@@ -42,6 +42,12 @@ MultiInputRandomCoordinateSampler< TElastix >
     "NumberOfSpatialSamples", this->GetComponentLabel(), level, 0 );
   this->SetNumberOfSamples( numberOfSpatialSamples );
 
+  /** Set whether to use the index of the voxels inside the mask. */
+  bool useMaskIndex = false;
+  this->GetConfiguration()->ReadParameter( useMaskIndex,
+    "UseMaskIndex", this->GetComponentLabel(), level, 0 );
+  this->SetUseMaskIndex( useMaskIndex );
+
   /** Set up the fixed image interpolator and set the SplineOrder, default value = 1. */
   typename DefaultInterpolatorType::Pointer fixedImageInterpolator
     = DefaultInterpolatorType::New();
@@ -44,6 +44,12 @@ namespace elastix
  *    metric value and its derivative in each iteration. Must be given for each resolution.\n
  *    example: <tt>(NumberOfSpatialSamples 2048 2048 4000)</tt> \n
  *    The default is 5000.
+ * \parameter UseCounterBasedRandomNumbers: Whether to compute the random numbers of sample i
+ *    from a counter-based generator, as a function of the random seed, the number of the
+ *    selection and i. The samples then do not depend on the number of threads, nor on the
+ *    -mts command line option, and can be computed by the threads in parallel.\n
+ *    example: <tt>(UseCounterBasedRandomNumbers "true")</tt>\n
+ *    Default: false, which gives the samples of previous elastix versions.
  *
  * \ingroup ImageSamplers
  */
@@ -42,6 +42,12 @@ RandomSampler< TElastix >
 
   this->SetNumberOfSamples( numberOfSpatialSamples );
 
+  /** Set whether to use counter-based random numbers. */
+  bool useCounterBasedRandomNumbers = false;
+  this->GetConfiguration()->ReadParameter( useCounterBasedRandomNumbers,
+    "UseCounterBasedRandomNumbers", this->GetComponentLabel(), level, 0 );
+  this->SetUseCounterBasedRandomNumbers( useCounterBasedRandomNumbers );
+
 } // end BeforeEachResolution
 
 
@@ -47,6 +47,18 @@ namespace elastix
  *    metric value and its derivative in each iteration. Must be given for each resolution.\n
  *    example: <tt>(NumberOfSpatialSamples 2048 2048 4000)</tt> \n
  *    The default is 5000.
+ * \parameter UseCounterBasedRandomNumbers: Whether to compute the random numbers of sample i
+ *    from a counter-based generator, as a function of the random seed, the number of the
+ *    selection and i. The samples then do not depend on the number of threads, nor on the
+ *    -mts command line option, and can be computed by the threads in parallel.\n
+ *    example: <tt>(UseCounterBasedRandomNumbers "true")</tt>\n
+ *    Default: false, which gives the samples of previous elastix versions.
+ * \parameter UseMaskIndex: Whether to draw the samples inside a mask from a precomputed
+ *    index of the voxels inside the mask, plus a random offset within the voxel, instead of
+ *    trying random points in the whole image until one is inside the mask. Much faster for
+ *    small masks. The index is built once per resolution. Not used with UseRandomSampleRegion.\n
+ *    example: <tt>(UseMaskIndex "true")</tt>\n
+ *    Default: false.
  * \parameter UseRandomSampleRegion: Defines whether to randomly select a subregion of the image
  *    in each iteration. When set to "true", also specify the SampleRegionSize.
  *    By setting this option to "true", in combination with the NewSamplesEveryIteration parameter,
@@ -42,6 +42,18 @@ RandomCoordinateSampler< TElastix >
     "NumberOfSpatialSamples", this->GetComponentLabel(), level, 0 );
   this->SetNumberOfSamples( numberOfSpatialSamples );
 
+  /** Set whether to use counter-based random numbers. */
+  bool useCounterBasedRandomNumbers = false;
+  this->GetConfiguration()->ReadParameter( useCounterBasedRandomNumbers,
+    "UseCounterBasedRandomNumbers", this->GetComponentLabel(), level, 0 );
+  this->SetUseCounterBasedRandomNumbers( useCounterBasedRandomNumbers );
+
+  /** Set whether to use the index of the voxels inside the mask. */
+  bool useMaskIndex = false;
+  this->GetConfiguration()->ReadParameter( useMaskIndex,
+    "UseMaskIndex", this->GetComponentLabel(), level, 0 );
+  this->SetUseMaskIndex( useMaskIndex );
+
   /** Set up the fixed image interpolator and set the SplineOrder, default value = 1. */
   unsigned int splineOrder = 1;
   this->GetConfiguration()->ReadParameter( splineOrder,
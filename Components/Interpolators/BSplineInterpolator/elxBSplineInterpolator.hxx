@@ -55,6 +55,12 @@ BSplineInterpolator< TElastix >
   /** Set the splineOrder. */
   this->SetSplineOrder( splineOrder );
 
+  /** Set whether to copy the coefficients to bricks, which takes effect at SetInputImage(). */
+  bool useBrickedCoefficients = false;
+  this->GetConfiguration()->ReadParameter( useBrickedCoefficients,
+    "UseBrickedBSplineCoefficients", this->GetComponentLabel(), level, 0 );
+  this->SetUseBrickedCoefficients( useBrickedCoefficients );
+
 } // end BeforeEachResolution()
 
 
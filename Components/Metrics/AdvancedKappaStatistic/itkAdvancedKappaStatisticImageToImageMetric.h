@@ -145,6 +145,12 @@ public:
     const TransformParametersType & parameters,
     MeasureType & Value, DerivativeType & Derivative ) const override;
 
+  /** Concurrent evaluation in a combination metric is supported. */
+  bool GetSupportsConcurrentGetValueAndDerivative( void ) const override
+  {
+    return true;
+  }
+
   /** Computes the moving gradient image dM/dx. */
   void ComputeGradient( void ) override;
 
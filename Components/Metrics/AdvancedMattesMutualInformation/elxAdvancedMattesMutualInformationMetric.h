@@ -91,6 +91,22 @@ namespace elastix
  *    B-spline grids.
  *    example: <tt>(UseFastAndLowMemoryVersion "false")</tt> \n
  *    The default is "true".
+ * \parameter JointHistogramReduction: How the joint histograms of the threads
+ *    are combined. "Serial" sums them in one thread. "Tree" lets every thread
+ *    sum a band of histogram rows, pairwise in a tree, which scales better
+ *    with many threads and few samples. Can be given for each resolution,
+ *    or for all resolutions at once. \n
+ *    example: <tt>(JointHistogramReduction "Tree")</tt> \n
+ *    The default is "Serial".
+ * \parameter SampleCacheMemoryBudget: The memory, in megabytes, that the fast and
+ *    low memory version may use to cache per sample the Parzen window values and the
+ *    product of the transform Jacobian and the moving image gradient, during the
+ *    first loop over the samples. If the cache of all samples fits, the second loop
+ *    does not evaluate the transform and the moving image again. It is not used in
+ *    combination with UseJacobianPreconditioning. Can be given for each resolution,
+ *    or for all resolutions at once. \n
+ *    example: <tt>(SampleCacheMemoryBudget 256)</tt> \n
+ *    The default is 0, which disables the cache.
  *
  * \sa ParzenWindowMutualInformationImageToImageMetric
  * \ingroup Metrics
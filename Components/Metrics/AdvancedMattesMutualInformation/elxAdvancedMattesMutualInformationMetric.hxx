@@ -125,6 +125,18 @@ AdvancedMattesMutualInformationMetric< TElastix >
     "UseFastAndLowMemoryVersion", this->GetComponentLabel(), level, 0 );
   this->SetUseExplicitPDFDerivatives( !useFastAndLowMemoryVersion );
 
+  /** Set how the joint histograms of the threads are combined. */
+  std::string jointHistogramReduction = "Serial";
+  this->GetConfiguration()->ReadParameter( jointHistogramReduction,
+    "JointHistogramReduction", this->GetComponentLabel(), level, 0 );
+  this->SetJointHistogramReductionByName( jointHistogramReduction );
+
+  /** Set the memory budget of the sample caches, in megabytes. */
+  unsigned long sampleCacheMemoryBudget = 0;
+  this->GetConfiguration()->ReadParameter( sampleCacheMemoryBudget,
+    "SampleCacheMemoryBudget", this->GetComponentLabel(), level, 0 );
+  this->SetSampleCacheMemoryBudget( sampleCacheMemoryBudget );
+
   /** Set whether to use Nick Tustison's preconditioning technique. */
   bool useJacobianPreconditioning = false;
   this->GetConfiguration()->ReadParameter( useJacobianPreconditioning,
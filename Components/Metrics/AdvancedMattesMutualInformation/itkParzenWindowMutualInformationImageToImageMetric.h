@@ -22,6 +22,8 @@
 
 #include "itkArray2D.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -157,6 +159,33 @@ public:
   itkGetConstMacro( UseJacobianPreconditioning, bool );
   itkSetMacro( UseJacobianPreconditioning, bool );
 
+  /** Set/get the memory budget of the sample caches, in megabytes; default: 0.
+   * The low memory version of GetValueAndDerivative loops twice over the samples.
+   * If the caches of all samples fit in this budget, the first loop also stores,
+   * per sample and in a buffer per thread, the Parzen window indices, the Parzen
+   * kernel values and the product of the transform Jacobian with the moving image
+   * gradient. The second loop then only gathers from the ratio of the joint and
+   * marginal pdfs and scatters into the derivative, without evaluating the
+   * transform and the moving image again. A budget of 0 disables the caches.
+   */
+  itkSetMacro( SampleCacheMemoryBudget, SizeValueType );
+  itkGetConstMacro( SampleCacheMemoryBudget, SizeValueType );
+
+  /** The analytic GetValueAndDerivative() follows the UseMetricSingleThreaded
+   * protocol, so it may run concurrently with other metrics. The finite
+   * difference version changes the transform parameters, so it may not.
+   */
+  bool GetSupportsConcurrentGetValueAndDerivative( void ) const override
+  {
+    return !this->GetUseFiniteDifferenceDerivative();
+  }
+
+  /** Initialize the Metric by calling the superclass, and let the image
+   * sampler store the samples as arrays only if the sample caches may be used.
+   */
+  void Initialize( void ) override;
+
+
 protected:
 
   /** The constructor. */
@@ -192,6 +221,12 @@ protected:
   typedef typename Superclass::ParzenValueContainerType            ParzenValueContainerType;
   typedef typename Superclass::KernelFunctionType                  KernelFunctionType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::NonZeroJacobianIndicesValueType     NonZeroJacobianIndicesValueType;
+  typedef typename Superclass::TransformMovingImageGradientType    TransformMovingImageGradientType;
+  typedef typename Superclass::ImageSampleStructureOfArraysType    ImageSampleStructureOfArraysType;
+
+  /** The number of samples that are processed as a block by the batch functions of the transform. */
+  itkStaticConstMacro( SampleBlockSize, unsigned int, Superclass::SampleBlockSize );
 
   /**  Get the value and analytic derivative.
    * Called by GetValueAndDerivative if UseFiniteDifferenceDerivative == false.
@@ -256,6 +291,15 @@ protected:
   /** Helper function to launch the threads. */
   void LaunchComputeDerivativeLowMemoryThreaderCallback( void ) const;
 
+  /** Multi-threaded version of ThreadedComputePDFs that also fills the sample cache of the thread. */
+  inline void ThreadedComputePDFsAndSampleCache( ThreadIdType threadId );
+
+  /** Multi-threaded version of ThreadedComputeDerivativeLowMemory that reads the sample cache of the thread. */
+  inline void ThreadedComputeDerivativeLowMemoryFromSampleCache( ThreadIdType threadId );
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_TYPE ComputePDFsAndSampleCacheThreaderCallback( void * arg );
+
 private:
 
   /** The private constructor. */
@@ -268,8 +312,32 @@ private:
   typedef Array2D< PRatioType > PRatioArrayType;
   mutable PRatioArrayType m_PRatioArray;
 
-  /** Setting */
-  bool m_UseJacobianPreconditioning;
+  /** Settings */
+  bool          m_UseJacobianPreconditioning;
+  SizeValueType m_SampleCacheMemoryBudget;
+
+  /** The sample cache of a thread. Per valid sample it stores the fixed and
+   * moving Parzen window indices, the fixed Parzen values divided by the moving
+   * bin size followed by the moving Parzen derivative values, and the nonzero
+   * part of the image Jacobian with its indices. The buffers only grow, so that
+   * they are allocated once.
+   */
+  struct SampleCacheType
+  {
+    SizeValueType                                  st_NumberOfSamples;
+    std::vector< int >                             st_ParzenWindowIndices;
+    std::vector< PDFValueType >                    st_ParzenValues;
+    std::vector< DerivativeValueType >             st_ImageJacobians;
+    std::vector< NonZeroJacobianIndicesValueType > st_NonZeroJacobianIndices;
+  };
+  mutable std::vector< SampleCacheType > m_SampleCaches;
+  mutable bool                           m_SampleCacheIsValid;
+
+  /** Compute the pdfs like ComputePDFs, and fill the sample caches if they fit in the budget. */
+  void ComputePDFsAndSampleCache( const ParametersType & parameters ) const;
+
+  /** The number of bytes that the sample caches need for the current samples. */
+  SizeValueType GetSampleCacheSize( void ) const;
 
   /** Helper function to compute the derivative for the low memory variant. */
   void ComputeDerivativeLowMemorySingleThreaded( DerivativeType & derivative ) const;
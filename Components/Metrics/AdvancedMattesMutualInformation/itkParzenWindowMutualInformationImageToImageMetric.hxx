@@ -27,6 +27,8 @@
 #include "vnl/vnl_inverse.h"
 #include "vnl/vnl_det.h"
 
+#include <algorithm>
+
 #ifdef ELASTIX_USE_OPENMP
 #include <omp.h>
 #endif
@@ -42,6 +44,8 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 ::ParzenWindowMutualInformationImageToImageMetric()
 {
   this->m_UseJacobianPreconditioning = false;
+  this->m_SampleCacheMemoryBudget    = 0;
+  this->m_SampleCacheIsValid         = false;
 
   /** Initialize the m_ParzenWindowHistogramThreaderParameters. */
   this->m_ParzenWindowMutualInformationThreaderParameters.m_Metric = this;
@@ -49,6 +53,27 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 } // end constructor
 
 
+/**
+ * ********************* Initialize ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::Initialize( void )
+{
+  /** Call the superclass. */
+  this->Superclass::Initialize();
+
+  /** Only the filling of the sample caches reads the samples as arrays, see
+   * ComputePDFsAndSampleCache(). Otherwise the arrays would only cost memory.
+   */
+  this->m_UseImageSampleStructureOfArrays = this->m_UseMultiThread
+    && this->m_SampleCacheMemoryBudget > 0 && !this->GetUseJacobianPreconditioning();
+
+} // end Initialize()
+
+
 /**
  * ********************* InitializeHistograms ******************************
  */
@@ -255,9 +280,10 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 {
   /** Construct the JointPDF and Alpha.
    * This function contains a loop over the samples.
-   * It executes multi-threadedly when m_UseMultiThread == true.
+   * It executes multi-threadedly when m_UseMultiThread == true,
+   * and then also fills the sample caches if they fit in the budget.
    */
-  this->ComputePDFs( parameters );
+  this->ComputePDFsAndSampleCache( parameters );
 
   /** Normalize the joint histogram by alpha. */
   this->NormalizeJointPDF( this->m_JointPDF, this->m_Alpha );
@@ -428,6 +454,9 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
   /** Launch multi-threading derivative computation. */
   this->LaunchComputeDerivativeLowMemoryThreaderCallback();
 
+  /** The sample caches belong to the current parameters only. */
+  this->m_SampleCacheIsValid = false;
+
   /** Gather the results from all threads. */
   this->AfterThreadedComputeDerivativeLowMemory( derivative );
 
@@ -443,6 +472,12 @@ void
 ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 ::ThreadedComputeDerivativeLowMemory( ThreadIdType threadId )
 {
+  /** Use the samples cached by ThreadedComputePDFsAndSampleCache(), if available. */
+  if( this->m_SampleCacheIsValid )
+  {
+    return this->ThreadedComputeDerivativeLowMemoryFromSampleCache( threadId );
+  }
+
   /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
   const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
   NonZeroJacobianIndicesType   nzji  = NonZeroJacobianIndicesType( nnzji );
@@ -630,9 +665,8 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
     this->m_ThreaderMetricParameters.st_DerivativePointer   = derivative.begin();
     this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0;
 
-    this->m_Threader->SetSingleMethod( this->AccumulateDerivativesThreaderCallback,
+    this->LaunchThreaderCallback( this->AccumulateDerivativesThreaderCallback,
       const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
-    this->m_Threader->SingleMethodExecute();
   }
 
 } // end AfterThreadedComputeDerivativeLowMemory()
@@ -673,17 +707,327 @@ void
 ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 ::LaunchComputeDerivativeLowMemoryThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->ComputeDerivativeLowMemoryThreaderCallback,
+  this->LaunchThreaderCallback( this->ComputeDerivativeLowMemoryThreaderCallback,
     const_cast< void * >( static_cast< const void * >(
       &this->m_ParzenWindowMutualInformationThreaderParameters ) ) );
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
-
 } // end LaunchComputeDerivativeLowMemoryThreaderCallback()
 
 
+/**
+ * ******************** GetSampleCacheSize *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+SizeValueType
+ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::GetSampleCacheSize( void ) const
+{
+  const SizeValueType numberOfSamples      = this->m_ImageSampleStructureOfArrays->Size();
+  const SizeValueType nnzji                = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  const SizeValueType numberOfParzenValues
+    = this->m_JointPDFWindow.GetSize()[ 0 ] + this->m_JointPDFWindow.GetSize()[ 1 ];
+
+  return numberOfSamples * ( 2 * sizeof( int )
+         + numberOfParzenValues * sizeof( PDFValueType )
+         + nnzji * ( sizeof( DerivativeValueType ) + sizeof( NonZeroJacobianIndicesValueType ) ) );
+
+} // end GetSampleCacheSize()
+
+
+/**
+ * ******************** ComputePDFsAndSampleCache *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputePDFsAndSampleCache( const ParametersType & parameters ) const
+{
+  this->m_SampleCacheIsValid = false;
+
+  /** The sample caches are only used multi-threadedly. They are not used in
+   * combination with the Jacobian preconditioning, which needs the full
+   * transform Jacobian of each sample in the second loop.
+   */
+  if( !this->m_UseMultiThread || this->m_SampleCacheMemoryBudget == 0
+    || this->GetUseJacobianPreconditioning() )
+  {
+    return this->ComputePDFs( parameters );
+  }
+
+  /** Call non-thread-safe stuff, see ComputePDFs(). */
+  this->BeforeThreadedGetValueAndDerivative( parameters );
+
+  /** Launch multi-threading JointPDF computation, filling the caches if they fit. */
+  if( this->GetSampleCacheSize() <= this->m_SampleCacheMemoryBudget * 1024 * 1024 )
+  {
+    this->m_SampleCaches.resize( Self::GetNumberOfThreads() );
+    this->LaunchThreaderCallback( this->ComputePDFsAndSampleCacheThreaderCallback,
+      const_cast< void * >( static_cast< const void * >(
+        &this->m_ParzenWindowMutualInformationThreaderParameters ) ) );
+    this->m_SampleCacheIsValid = true;
+  }
+  else
+  {
+    this->LaunchComputePDFsThreaderCallback();
+  }
+
+  /** Gather the results from all threads. */
+  this->AfterThreadedComputePDFs();
+
+} // end ComputePDFsAndSampleCache()
+
+
+/**
+ * ******************* ThreadedComputePDFsAndSampleCache *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedComputePDFsAndSampleCache( ThreadIdType threadId )
+{
+  /** Get a handle to the pre-allocated joint PDF for the current thread,
+   * and initialize it, see ThreadedComputePDFs().
+   */
+  JointPDFPointer & jointPDF = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ threadId ].st_JointPDF;
+  bool &            isZero   = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ threadId ].st_JointPDFIsZero;
+  if( !isZero )
+  {
+    jointPDF->FillBuffer( NumericTraits< PDFValueType >::ZeroValue() );
+  }
+  isZero = false;
+
+  /** Some sizes. */
+  const SizeValueType nnzji                      = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  const unsigned int  numberOfFixedParzenValues  = this->m_JointPDFWindow.GetSize()[ 1 ];
+  const unsigned int  numberOfMovingParzenValues = this->m_JointPDFWindow.GetSize()[ 0 ];
+  const unsigned int  numberOfParzenValues       = numberOfFixedParzenValues + numberOfMovingParzenValues;
+  const double        et                         = static_cast< double >( this->m_MovingImageBinSize );
+
+  /** Get a handle to the samples, stored as contiguous coordinate and value arrays. */
+  const ImageSampleStructureOfArraysType * samples             = this->m_ImageSampleStructureOfArrays;
+  const unsigned long                      sampleContainerSize = samples->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast< unsigned long >( std::ceil( static_cast< double >( sampleContainerSize )
+    / static_cast< double >( Self::GetNumberOfThreads() ) ) );
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
+  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
+  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
+
+  /** Get a handle to the cache of this thread, and make room for all its samples. */
+  SampleCacheType &   cache                  = this->m_SampleCaches[ threadId ];
+  const SizeValueType maximumNumberOfSamples = pos_end - pos_begin;
+  cache.st_ParzenWindowIndices.resize( 2 * maximumNumberOfSamples );
+  cache.st_ParzenValues.resize( numberOfParzenValues * maximumNumberOfSamples );
+  cache.st_ImageJacobians.resize( nnzji * maximumNumberOfSamples );
+  cache.st_NonZeroJacobianIndices.resize( nnzji * maximumNumberOfSamples );
+
+  /** Variables to store a block of samples. The valid samples are compacted
+   * to the front of the arrays.
+   */
+  FixedImagePointType              fixedPoints[ SampleBlockSize ];
+  MovingImagePointType             mappedPoints[ SampleBlockSize ];
+  TransformMovingImageGradientType movingImageDerivatives[ SampleBlockSize ];
+
+  /** Loop over the samples and compute their contribution to the pdfs. */
+  SizeValueType numberOfCachedSamples = 0;
+  for( SizeValueType blockBegin = pos_begin; blockBegin < pos_end; blockBegin += SampleBlockSize )
+  {
+    const SizeValueType blockSize
+      = std::min< SizeValueType >( SampleBlockSize, pos_end - blockBegin );
+
+    /** Read fixed coordinates and transform the whole block at once. */
+    samples->GetPoints( blockBegin, blockSize, fixedPoints );
+    this->TransformPoints( fixedPoints, mappedPoints, blockSize );
+
+    SizeValueType numberOfValidSamples = 0;
+    for( SizeValueType i = 0; i < blockSize; ++i )
+    {
+      RealType                  movingImageValue;
+      MovingImageDerivativeType movingImageDerivative;
+
+      /** Check if point is inside mask. */
+      bool sampleOk = this->IsInsideMovingMask( mappedPoints[ i ] );
+
+      /** Compute the moving image value and derivative, and check if the
+       * point is inside the moving image buffer.
+       */
+      if( sampleOk )
+      {
+        sampleOk = this->EvaluateMovingImageValueAndDerivative(
+          mappedPoints[ i ], movingImageValue, &movingImageDerivative );
+      }
+
+      if( !sampleOk ) { continue; }
+
+      /** Get the fixed image value. */
+      RealType fixedImageValue = static_cast< RealType >( samples->GetValue( blockBegin + i ) );
+
+      /** Make sure the values fall within the histogram range. */
+      fixedImageValue  = this->GetFixedImageLimiter()->Evaluate( fixedImageValue );
+      movingImageValue = this->GetMovingImageLimiter()
+        ->Evaluate( movingImageValue, movingImageDerivative );
+
+      /** Compute this sample's contribution to the joint distributions. */
+      this->UpdateJointPDFAndDerivatives(
+        fixedImageValue, movingImageValue, 0, 0,
+        jointPDF.GetPointer() );
+
+      /** Cache the Parzen window indices and values, see UpdateDerivativeLowMemory(). */
+      const SizeValueType sampleIndex = numberOfCachedSamples + numberOfValidSamples;
+      const double        fixedImageParzenWindowTerm
+        = fixedImageValue / this->m_FixedImageBinSize - this->m_FixedImageNormalizedMin;
+      const double movingImageParzenWindowTerm
+        = movingImageValue / this->m_MovingImageBinSize - this->m_MovingImageNormalizedMin;
+      const int fixedParzenWindowIndex
+        = static_cast< int >( std::floor(
+        fixedImageParzenWindowTerm + this->m_FixedParzenTermToIndexOffset ) );
+      const int movingParzenWindowIndex
+        = static_cast< int >( std::floor(
+        movingImageParzenWindowTerm + this->m_MovingParzenTermToIndexOffset ) );
+
+      cache.st_ParzenWindowIndices[ 2 * sampleIndex ]     = fixedParzenWindowIndex;
+      cache.st_ParzenWindowIndices[ 2 * sampleIndex + 1 ] = movingParzenWindowIndex;
+
+      PDFValueType * parzenValues = &cache.st_ParzenValues[ numberOfParzenValues * sampleIndex ];
+      this->m_FixedKernel->Evaluate(
+        static_cast< double >( fixedParzenWindowIndex ) - fixedImageParzenWindowTerm, parzenValues );
+      for( unsigned int f = 0; f < numberOfFixedParzenValues; ++f )
+      {
+        parzenValues[ f ] /= et;
+      }
+      this->m_DerivativeMovingKernel->Evaluate(
+        static_cast< double >( movingParzenWindowIndex ) - movingImageParzenWindowTerm,
+        parzenValues + numberOfFixedParzenValues );
+
+      fixedPoints[ numberOfValidSamples ]            = fixedPoints[ i ];
+      movingImageDerivatives[ numberOfValidSamples ] = movingImageDerivative;
+      ++numberOfValidSamples;
+    }
+
+    if( numberOfValidSamples == 0 ) { continue; }
+
+    /** Compute the inner products of the transform Jacobian dT/dmu and the
+     * moving image gradient dM/dx for all valid samples of the block,
+     * directly into the cache.
+     */
+    this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProducts(
+      fixedPoints, movingImageDerivatives, numberOfValidSamples,
+      &cache.st_ImageJacobians[ nnzji * numberOfCachedSamples ],
+      &cache.st_NonZeroJacobianIndices[ nnzji * numberOfCachedSamples ] );
+
+    numberOfCachedSamples += numberOfValidSamples;
+
+  } // end for loop over the blocks of the image sample container
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  cache.st_NumberOfSamples = numberOfCachedSamples;
+  this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfCachedSamples;
+
+} // end ThreadedComputePDFsAndSampleCache()
+
+
+/**
+ * ******************* ThreadedComputeDerivativeLowMemoryFromSampleCache *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedComputeDerivativeLowMemoryFromSampleCache( ThreadIdType threadId )
+{
+  /** Get a handle to the pre-allocated derivative for the current thread,
+   * see ThreadedComputeDerivativeLowMemory().
+   */
+  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Derivative;
+
+  /** Get a handle to the cache of this thread. */
+  const SampleCacheType & cache = this->m_SampleCaches[ threadId ];
+
+  /** Some sizes. */
+  const SizeValueType nnzji                      = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  const unsigned int  numberOfFixedParzenValues  = this->m_JointPDFWindow.GetSize()[ 1 ];
+  const unsigned int  numberOfMovingParzenValues = this->m_JointPDFWindow.GetSize()[ 0 ];
+  const unsigned int  numberOfParzenValues       = numberOfFixedParzenValues + numberOfMovingParzenValues;
+  const bool          useAllJacobians            = ( nnzji == this->GetNumberOfParameters() );
+  DerivativeValueType * derivit                  = derivative.begin();
+
+  /** Loop over the cached samples. */
+  for( SizeValueType s = 0; s < cache.st_NumberOfSamples; ++s )
+  {
+    const int *                 parzenWindowIndices          = &cache.st_ParzenWindowIndices[ 2 * s ];
+    const PDFValueType *        fixedParzenValues            = &cache.st_ParzenValues[ numberOfParzenValues * s ];
+    const PDFValueType *        derivativeMovingParzenValues = fixedParzenValues + numberOfFixedParzenValues;
+    const DerivativeValueType * imageJacobian                = &cache.st_ImageJacobians[ nnzji * s ];
+
+    /** Gather the pdf ratios in the Parzen window region, see UpdateDerivativeLowMemory().
+     * The rows of m_PRatioArray are contiguous, so that the inner loop vectorizes.
+     */
+    PDFValueType sum = 0.0;
+    for( unsigned int f = 0; f < numberOfFixedParzenValues; ++f )
+    {
+      const PRatioType * pRatio = this->m_PRatioArray[ parzenWindowIndices[ 0 ] + f ] + parzenWindowIndices[ 1 ];
+      PDFValueType       rowSum = 0.0;
+      for( unsigned int m = 0; m < numberOfMovingParzenValues; ++m )
+      {
+        rowSum += pRatio[ m ] * derivativeMovingParzenValues[ m ];
+      }
+      sum += fixedParzenValues[ f ] * rowSum;
+    }
+
+    /** Scatter derivative += sum * imageJacobian. */
+    if( useAllJacobians )
+    {
+      for( SizeValueType mu = 0; mu < nnzji; ++mu )
+      {
+        derivit[ mu ] += static_cast< DerivativeValueType >( imageJacobian[ mu ] * sum );
+      }
+    }
+    else
+    {
+      const NonZeroJacobianIndicesValueType * nzji = &cache.st_NonZeroJacobianIndices[ nnzji * s ];
+      for( SizeValueType i = 0; i < nnzji; ++i )
+      {
+        derivit[ nzji[ i ] ] += static_cast< DerivativeValueType >( imageJacobian[ i ] * sum );
+      }
+    }
+  } // end loop over the cached samples
+
+} // end ThreadedComputeDerivativeLowMemoryFromSampleCache()
+
+
+/**
+ * **************** ComputePDFsAndSampleCacheThreaderCallback *******
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputePDFsAndSampleCacheThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadId   = infoStruct->ThreadID;
+
+  ParzenWindowMutualInformationMultiThreaderParameterType * temp
+    = static_cast< ParzenWindowMutualInformationMultiThreaderParameterType * >( infoStruct->UserData );
+
+  temp->m_Metric->ThreadedComputePDFsAndSampleCache( threadId );
+
+#if ITK_VERSION_MAJOR >= 5
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+#else
+  return ITK_THREAD_RETURN_VALUE;
+#endif
+
+} // end ComputePDFsAndSampleCacheThreaderCallback()
+
+
 /**
  * ******************* ComputeValueAndPRatioArray *******************
  */
@@ -110,6 +110,8 @@ public:
   typedef typename Superclass::ImageSampleContainerType   ImageSampleContainerType;
   typedef typename
     Superclass::ImageSampleContainerPointer ImageSampleContainerPointer;
+  typedef typename
+    Superclass::ImageSampleStructureOfArraysType ImageSampleStructureOfArraysType;
   typedef typename Superclass::FixedImageLimiterType  FixedImageLimiterType;
   typedef typename Superclass::MovingImageLimiterType MovingImageLimiterType;
   typedef typename
@@ -150,6 +152,12 @@ public:
   void GetValueAndDerivative( const TransformParametersType & parameters,
     MeasureType & value, DerivativeType & derivative ) const override;
 
+  /** Both the single- and the multi-threaded GetValueAndDerivative() may run concurrently. */
+  bool GetSupportsConcurrentGetValueAndDerivative( void ) const override
+  {
+    return true;
+  }
+
   /** Experimental feature: compute SelfHessian */
   void GetSelfHessian( const TransformParametersType & parameters, HessianType & H ) const override;
 
@@ -208,6 +216,11 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::NonZeroJacobianIndicesValueType     NonZeroJacobianIndicesValueType;
+  typedef typename Superclass::TransformMovingImageGradientType    TransformMovingImageGradientType;
+
+  /** The number of samples processed as a block in the threaded functions. */
+  itkStaticConstMacro( SampleBlockSize, unsigned int, Superclass::SampleBlockSize );
 
   /** Protected typedefs for SelfHessian */
   typedef SmoothingRecursiveGaussianImageFilter<
@@ -246,6 +259,10 @@ protected:
   /** Get value and derivatives for each thread. */
   inline void ThreadedGetValueAndDerivative( ThreadIdType threadID ) override;
 
+  /** Get value and derivatives for the samples [begin, end), used for dynamic load balancing. */
+  inline void ThreadedGetValueAndDerivativeForSampleRange(
+    ThreadIdType threadID, SizeValueType begin, SizeValueType end ) override;
+
   /** Gather the values and derivatives from all threads. */
   inline void AfterThreadedGetValueAndDerivative(
     MeasureType & value, DerivativeType & derivative ) const override;
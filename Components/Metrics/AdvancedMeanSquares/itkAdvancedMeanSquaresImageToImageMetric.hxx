@@ -23,6 +23,9 @@
 #include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkComputeImageExtremaFilter.h"
 
+#include <algorithm>
+#include <vector>
+
 #ifdef ELASTIX_USE_OPENMP
 #include <omp.h>
 #endif
@@ -39,9 +42,13 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
 ::AdvancedMeanSquaresImageToImageMetric()
 {
   this->SetUseImageSampler( true );
+  this->m_UseImageSampleStructureOfArrays = true;
   this->SetUseFixedImageLimiter( false );
   this->SetUseMovingImageLimiter( false );
 
+  /** The sample loop can be split in arbitrary ranges. */
+  this->m_SupportsDynamicLoadBalancing = true;
+
   this->m_UseNormalization    = false;
   this->m_NormalizationFactor = 1.0;
 
@@ -406,8 +413,8 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
   const ThreadIdType numberOfThreads = Self::GetNumberOfThreads();
 
   /** Accumulate the number of pixels. */
-  this->m_NumberOfPixelsCounted = this->m_GetValueAndDerivativePerThreadVariables[ 0 ].st_NumberOfPixelsCounted;
-  for( ThreadIdType i = 1; i < numberOfThreads; ++i )
+  this->m_NumberOfPixelsCounted = 0;
+  for( ThreadIdType i = 0; i < numberOfThreads; ++i )
   {
     this->m_NumberOfPixelsCounted += this->m_GetValueAndDerivativePerThreadVariables[ i ].st_NumberOfPixelsCounted;
 
@@ -638,21 +645,8 @@ void
 AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
 ::ThreadedGetValueAndDerivative( ThreadIdType threadId )
 {
-  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
-  const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
-  NonZeroJacobianIndicesType   nzji  = NonZeroJacobianIndicesType( nnzji );
-  DerivativeType               imageJacobian( nnzji );
-
-  /** Get a handle to the pre-allocated derivative for the current thread.
-   * The initialization is performed at the beginning of each resolution in
-   * InitializeThreadingParameters(), and at the end of each iteration in
-   * AfterThreadedGetValueAndDerivative() and the accumulate functions.
-   */
-  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Derivative;
-
-  /** Get a handle to the sample container. */
-  ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
-  const unsigned long         sampleContainerSize = sampleContainer->Size();
+  /** Get the size of the sample container. */
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
 
   /** Get the samples for this thread. */
   const unsigned long nrOfSamplesPerThreads
@@ -664,81 +658,124 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
   pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
   pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator threader_fiter;
-  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator threader_fend   = sampleContainer->Begin();
+  this->ThreadedGetValueAndDerivativeForSampleRange( threadId, pos_begin, pos_end );
+
+} // end ThreadedGetValueAndDerivative()
 
-  threader_fbegin += (int)pos_begin;
-  threader_fend   += (int)pos_end;
+
+/**
+ * ******************* ThreadedGetValueAndDerivativeForSampleRange *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedGetValueAndDerivativeForSampleRange(
+  ThreadIdType threadId, SizeValueType pos_begin, SizeValueType pos_end )
+{
+  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices.
+   * The image Jacobians and indices of a whole block of samples are computed
+   * at once, and imageJacobian is pointed at the part of the current sample.
+   */
+  const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  NonZeroJacobianIndicesType   nzji  = NonZeroJacobianIndicesType( nnzji );
+  DerivativeType               imageJacobian;
+  std::vector< DerivativeValueType >             imageJacobians( SampleBlockSize * nnzji );
+  std::vector< NonZeroJacobianIndicesValueType > nonZeroJacobianIndices( SampleBlockSize * nnzji );
+
+  /** Get a handle to the pre-allocated derivative for the current thread.
+   * The initialization is performed at the beginning of each resolution in
+   * InitializeThreadingParameters(), and at the end of each iteration in
+   * AfterThreadedGetValueAndDerivative() and the accumulate functions.
+   */
+  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Derivative;
+
+  /** Get a handle to the samples, stored as contiguous coordinate and value arrays. */
+  const ImageSampleStructureOfArraysType * samples = this->m_ImageSampleStructureOfArrays;
+
+  /** Variables to store a block of samples. The valid samples are compacted
+   * to the front of the arrays.
+   */
+  FixedImagePointType              fixedPoints[ SampleBlockSize ];
+  MovingImagePointType             mappedPoints[ SampleBlockSize ];
+  RealType                         fixedImageValues[ SampleBlockSize ];
+  RealType                         movingImageValues[ SampleBlockSize ];
+  TransformMovingImageGradientType movingImageDerivatives[ SampleBlockSize ];
 
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
   MeasureType   measure               = NumericTraits< MeasureType >::Zero;
 
   /** Loop over the fixed image to calculate the mean squares. */
-  for( threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter )
+  for( SizeValueType blockBegin = pos_begin; blockBegin < pos_end; blockBegin += SampleBlockSize )
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = ( *threader_fiter ).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
-    MovingImageDerivativeType   movingImageDerivative;
+    const SizeValueType blockSize
+      = std::min< SizeValueType >( SampleBlockSize, pos_end - blockBegin );
 
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+    /** Read fixed coordinates and transform the whole block at once. */
+    samples->GetPoints( blockBegin, blockSize, fixedPoints );
+    this->TransformPoints( fixedPoints, mappedPoints, blockSize );
 
-    /** Check if point is inside mask. */
-    if( sampleOk )
+    SizeValueType numberOfValidSamples = 0;
+    for( SizeValueType i = 0; i < blockSize; ++i )
     {
-      sampleOk = this->IsInsideMovingMask( mappedPoint ); // thread-safe?
-    }
+      RealType                  movingImageValue;
+      MovingImageDerivativeType movingImageDerivative;
 
-    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
-     * the point is inside the moving image buffer.
-     */
-    if( sampleOk )
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(
-        mappedPoint, movingImageValue, &movingImageDerivative );
-    }
+      /** Check if point is inside mask. */
+      bool sampleOk = this->IsInsideMovingMask( mappedPoints[ i ] );
 
-    if( sampleOk )
-    {
-      numberOfPixelsCounted++;
+      /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
+       * the point is inside the moving image buffer.
+       */
+      if( sampleOk )
+      {
+        sampleOk = this->EvaluateMovingImageValueAndDerivative(
+          mappedPoints[ i ], movingImageValue, &movingImageDerivative );
+      }
 
-      /** Get the fixed image value. */
-      const RealType & fixedImageValue
-        = static_cast< RealType >( ( *threader_fiter ).Value().m_ImageValue );
+      if( sampleOk )
+      {
+        fixedPoints[ numberOfValidSamples ]            = fixedPoints[ i ];
+        fixedImageValues[ numberOfValidSamples ]       = static_cast< RealType >( samples->GetValue( blockBegin + i ) );
+        movingImageValues[ numberOfValidSamples ]      = movingImageValue;
+        movingImageDerivatives[ numberOfValidSamples ] = movingImageDerivative;
+        ++numberOfValidSamples;
+      }
+    }
 
-#if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
+    if( numberOfValidSamples == 0 ) { continue; }
+    numberOfPixelsCounted += numberOfValidSamples;
 
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-#else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji );
-#endif
+    /** Compute the inner products of the transform Jacobian dT/dmu and the
+     * moving image gradient dM/dx for all valid samples of the block.
+     */
+    this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProducts(
+      fixedPoints, movingImageDerivatives, numberOfValidSamples,
+      &imageJacobians[ 0 ], &nonZeroJacobianIndices[ 0 ] );
+
+    for( SizeValueType i = 0; i < numberOfValidSamples; ++i )
+    {
+      imageJacobian.SetData( &imageJacobians[ i * nnzji ], nnzji, false );
+      std::copy( &nonZeroJacobianIndices[ i * nnzji ],
+        &nonZeroJacobianIndices[ i * nnzji ] + nnzji, nzji.begin() );
 
       /** Compute this pixel's contribution to the measure and derivatives. */
       this->UpdateValueAndDerivativeTerms(
-        fixedImageValue, movingImageValue,
+        fixedImageValues[ i ], movingImageValues[ i ],
         imageJacobian, nzji,
         measure, derivative );
+    }
 
-    } // end if sampleOk
-
-  } // end for loop over the image sample container
+  } // end for loop over the blocks of the image sample container
 
-  /** Only update these variables at the end to prevent unnecessary "false sharing". */
-  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
-  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Value                 = measure;
+  /** Only update these variables at the end to prevent unnecessary "false sharing".
+   * A thread may process several sample ranges, so accumulate.
+   */
+  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted += numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Value                 += measure;
 
-} // end ThreadedGetValueAndDerivative()
+} // end ThreadedGetValueAndDerivativeForSampleRange()
 
 
 /**
@@ -754,8 +791,8 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
   const ThreadIdType numberOfThreads = Self::GetNumberOfThreads();
 
   /** Accumulate the number of pixels. */
-  this->m_NumberOfPixelsCounted = this->m_GetValueAndDerivativePerThreadVariables[ 0 ].st_NumberOfPixelsCounted;
-  for( ThreadIdType i = 1; i < numberOfThreads; ++i )
+  this->m_NumberOfPixelsCounted = 0;
+  for( ThreadIdType i = 0; i < numberOfThreads; ++i )
   {
     this->m_NumberOfPixelsCounted += this->m_GetValueAndDerivativePerThreadVariables[ i ].st_NumberOfPixelsCounted;
 
@@ -799,9 +836,8 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
     this->m_ThreaderMetricParameters.st_DerivativePointer   = derivative.begin();
     this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0 / normal_sum;
 
-    this->m_Threader->SetSingleMethod( this->AccumulateDerivativesThreaderCallback,
+    this->LaunchThreaderCallback( this->AccumulateDerivativesThreaderCallback,
       const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
-    this->m_Threader->SingleMethodExecute();
   }
 #ifdef ELASTIX_USE_OPENMP
   // compute multi-threadedly with openmp
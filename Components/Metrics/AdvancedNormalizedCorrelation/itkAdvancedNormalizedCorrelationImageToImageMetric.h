@@ -144,6 +144,8 @@ public:
   typedef typename Superclass::ImageSampleContainerType   ImageSampleContainerType;
   typedef typename
     Superclass::ImageSampleContainerPointer ImageSampleContainerPointer;
+  typedef typename
+    Superclass::ImageSampleStructureOfArraysType ImageSampleStructureOfArraysType;
   typedef typename Superclass::FixedImageLimiterType  FixedImageLimiterType;
   typedef typename Superclass::MovingImageLimiterType MovingImageLimiterType;
   typedef typename
@@ -180,6 +182,12 @@ public:
     const TransformParametersType & parameters,
     MeasureType & value, DerivativeType & derivative ) const override;
 
+  /** GetValueAndDerivative() only reads the transform, see the superclass. */
+  bool GetSupportsConcurrentGetValueAndDerivative( void ) const override
+  {
+    return true;
+  }
+
   /** Set/Get SubtractMean boolean. If true, the sample mean is subtracted
    * from the sample values in the cross-correlation formula and
    * typically results in narrower valleys in the cost function.
@@ -209,6 +217,11 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::NonZeroJacobianIndicesValueType     NonZeroJacobianIndicesValueType;
+  typedef typename Superclass::TransformMovingImageGradientType    TransformMovingImageGradientType;
+
+  /** The number of samples processed as a block in the threaded functions. */
+  itkStaticConstMacro( SampleBlockSize, unsigned int, Superclass::SampleBlockSize );
 
   /** Compute a pixel's contribution to the derivative terms;
    * Called by GetValueAndDerivative().
@@ -231,6 +244,10 @@ protected:
   /** Get value and derivatives for each thread. */
   inline void ThreadedGetValueAndDerivative( ThreadIdType threadID ) override;
 
+  /** Get value and derivatives for the samples [begin, end), used for dynamic load balancing. */
+  inline void ThreadedGetValueAndDerivativeForSampleRange(
+    ThreadIdType threadID, SizeValueType begin, SizeValueType end ) override;
+
   /** Gather the values and derivatives from all threads */
   inline void AfterThreadedGetValueAndDerivative(
     MeasureType & value, DerivativeType & derivative ) const override;
@@ -20,6 +20,9 @@
 
 #include "itkAdvancedNormalizedCorrelationImageToImageMetric.h"
 
+#include <algorithm>
+#include <vector>
+
 #ifdef ELASTIX_USE_OPENMP
 #include <omp.h>
 #endif
@@ -38,9 +41,13 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   this->m_SubtractMean = false;
 
   this->SetUseImageSampler( true );
+  this->m_UseImageSampleStructureOfArrays = true;
   this->SetUseFixedImageLimiter( false );
   this->SetUseMovingImageLimiter( false );
 
+  /** The sample loop can be split in arbitrary ranges. */
+  this->m_SupportsDynamicLoadBalancing = true;
+
   // Multi-threading structs
   this->m_CorrelationGetValueAndDerivativePerThreadVariables     = NULL;
   this->m_CorrelationGetValueAndDerivativePerThreadVariablesSize = 0;
@@ -531,10 +538,43 @@ void
 AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
 ::ThreadedGetValueAndDerivative( ThreadIdType threadId )
 {
-  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
+  /** Get the size of the sample container. */
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast< unsigned long >( std::ceil( static_cast< double >( sampleContainerSize )
+    / static_cast< double >( Self::GetNumberOfThreads() ) ) );
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
+  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
+  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
+
+  this->ThreadedGetValueAndDerivativeForSampleRange( threadId, pos_begin, pos_end );
+
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetValueAndDerivativeForSampleRange *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedGetValueAndDerivativeForSampleRange(
+  ThreadIdType threadId, SizeValueType pos_begin, SizeValueType pos_end )
+{
+  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices.
+   * The image Jacobians and indices of a whole block of samples are computed
+   * at once, and imageJacobian is pointed at the part of the current sample.
+   */
   const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
   NonZeroJacobianIndicesType   nzji  = NonZeroJacobianIndicesType( nnzji );
-  DerivativeType               imageJacobian( nzji.size() );
+  DerivativeType               imageJacobian;
+  std::vector< DerivativeValueType >             imageJacobians( SampleBlockSize * nnzji );
+  std::vector< NonZeroJacobianIndicesValueType > nonZeroJacobianIndices( SampleBlockSize * nnzji );
 
   /** Get handles to the pre-allocated derivatives for the current thread.
    * The initialization is performed at the beginning of each resolution in
@@ -545,27 +585,17 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   DerivativeType & derivativeM  = this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_DerivativeM;
   DerivativeType & differential = this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Differential;
 
-  /** Get a handle to the sample container. */
-  ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
-  const unsigned long         sampleContainerSize = sampleContainer->Size();
+  /** Get a handle to the samples, stored as contiguous coordinate and value arrays. */
+  const ImageSampleStructureOfArraysType * samples = this->m_ImageSampleStructureOfArrays;
 
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads
-    = static_cast< unsigned long >( std::ceil( static_cast< double >( sampleContainerSize )
-    / static_cast< double >( Self::GetNumberOfThreads() ) ) );
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
-  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
-  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator threader_fiter;
-  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator threader_fend   = sampleContainer->Begin();
-
-  threader_fbegin += (int)pos_begin;
-  threader_fend   += (int)pos_end;
+  /** Variables to store a block of samples. The valid samples are compacted
+   * to the front of the arrays.
+   */
+  FixedImagePointType              fixedPoints[ SampleBlockSize ];
+  MovingImagePointType             mappedPoints[ SampleBlockSize ];
+  RealType                         fixedImageValues[ SampleBlockSize ];
+  RealType                         movingImageValues[ SampleBlockSize ];
+  TransformMovingImageGradientType movingImageDerivatives[ SampleBlockSize ];
 
   /** Create variables to store intermediate results. */
   AccumulateType sff                   = NumericTraits< AccumulateType >::Zero;
@@ -575,53 +605,62 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   AccumulateType sm                    = NumericTraits< AccumulateType >::Zero;
   unsigned long  numberOfPixelsCounted = 0;
 
-  /** Loop over the fixed image to calculate the mean squares. */
-  for( threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter )
+  /** Loop over the fixed image to calculate the correlation. */
+  for( SizeValueType blockBegin = pos_begin; blockBegin < pos_end; blockBegin += SampleBlockSize )
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = ( *threader_fiter ).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
-    MovingImageDerivativeType   movingImageDerivative;
+    const SizeValueType blockSize
+      = std::min< SizeValueType >( SampleBlockSize, pos_end - blockBegin );
 
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+    /** Read fixed coordinates and transform the whole block at once. */
+    samples->GetPoints( blockBegin, blockSize, fixedPoints );
+    this->TransformPoints( fixedPoints, mappedPoints, blockSize );
 
-    /** Check if point is inside mask. */
-    if( sampleOk )
+    SizeValueType numberOfValidSamples = 0;
+    for( SizeValueType i = 0; i < blockSize; ++i )
     {
-      sampleOk = this->IsInsideMovingMask( mappedPoint );
-    }
+      RealType                  movingImageValue;
+      MovingImageDerivativeType movingImageDerivative;
 
-    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
-     * the point is inside the moving image buffer.
-     */
-    if( sampleOk )
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(
-        mappedPoint, movingImageValue, &movingImageDerivative );
+      /** Check if point is inside mask. */
+      bool sampleOk = this->IsInsideMovingMask( mappedPoints[ i ] );
+
+      /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
+       * the point is inside the moving image buffer.
+       */
+      if( sampleOk )
+      {
+        sampleOk = this->EvaluateMovingImageValueAndDerivative(
+          mappedPoints[ i ], movingImageValue, &movingImageDerivative );
+      }
+
+      if( sampleOk )
+      {
+        fixedPoints[ numberOfValidSamples ]            = fixedPoints[ i ];
+        fixedImageValues[ numberOfValidSamples ]       = static_cast< RealType >( samples->GetValue( blockBegin + i ) );
+        movingImageValues[ numberOfValidSamples ]      = movingImageValue;
+        movingImageDerivatives[ numberOfValidSamples ] = movingImageDerivative;
+        ++numberOfValidSamples;
+      }
     }
 
-    if( sampleOk )
-    {
-      numberOfPixelsCounted++;
+    if( numberOfValidSamples == 0 ) { continue; }
+    numberOfPixelsCounted += numberOfValidSamples;
 
-      /** Get the fixed image value. */
-      const RealType & fixedImageValue
-        = static_cast< RealType >( ( *threader_fiter ).Value().m_ImageValue );
+    /** Compute the inner products of the transform Jacobian dT/dmu and the
+     * moving image gradient dM/dx for all valid samples of the block.
+     */
+    this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProducts(
+      fixedPoints, movingImageDerivatives, numberOfValidSamples,
+      &imageJacobians[ 0 ], &nonZeroJacobianIndices[ 0 ] );
 
-#if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
+    for( SizeValueType i = 0; i < numberOfValidSamples; ++i )
+    {
+      const RealType & fixedImageValue  = fixedImageValues[ i ];
+      const RealType & movingImageValue = movingImageValues[ i ];
 
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-#else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji );
-#endif
+      imageJacobian.SetData( &imageJacobians[ i * nnzji ], nnzji, false );
+      std::copy( &nonZeroJacobianIndices[ i * nnzji ],
+        &nonZeroJacobianIndices[ i * nnzji ] + nnzji, nzji.begin() );
 
       /** Update some sums needed to calculate the value of NC. */
       sff += fixedImageValue  * fixedImageValue;
@@ -634,20 +673,21 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
       this->UpdateDerivativeTerms(
         fixedImageValue, movingImageValue, imageJacobian, nzji,
         derivativeF, derivativeM, differential );
+    }
 
-    } // end if sampleOk
-
-  } // end for loop over the image sample container
+  } // end for loop over the blocks of the image sample container
 
-  /** Only update these variables at the end to prevent unnecessary "false sharing". */
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Sff                   = sff;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Smm                   = smm;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Sfm                   = sfm;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Sf                    = sf;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Sm                    = sm;
+  /** Only update these variables at the end to prevent unnecessary "false sharing".
+   * A thread may process several sample ranges, so accumulate.
+   */
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted += numberOfPixelsCounted;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Sff                   += sff;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Smm                   += smm;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Sfm                   += sfm;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Sf                    += sf;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Sm                    += sm;
 
-} // end ThreadedGetValueAndDerivative()
+} // end ThreadedGetValueAndDerivativeForSampleRange()
 
 
 /**
@@ -663,9 +703,8 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   const ThreadIdType numberOfThreads = Self::GetNumberOfThreads();
 
   /** Accumulate the number of pixels. */
-  this->m_NumberOfPixelsCounted
-    = this->m_CorrelationGetValueAndDerivativePerThreadVariables[ 0 ].st_NumberOfPixelsCounted;
-  for( ThreadIdType i = 1; i < numberOfThreads; ++i )
+  this->m_NumberOfPixelsCounted = 0;
+  for( ThreadIdType i = 0; i < numberOfThreads; ++i )
   {
     this->m_NumberOfPixelsCounted
       += this->m_CorrelationGetValueAndDerivativePerThreadVariables[ i ].st_NumberOfPixelsCounted;
@@ -681,12 +720,12 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
 
   /** Accumulate values. */
   const AccumulateType zero = NumericTraits< AccumulateType >::Zero;
-  AccumulateType       sff  = this->m_CorrelationGetValueAndDerivativePerThreadVariables[ 0 ].st_Sff;
-  AccumulateType       smm  = this->m_CorrelationGetValueAndDerivativePerThreadVariables[ 0 ].st_Smm;
-  AccumulateType       sfm  = this->m_CorrelationGetValueAndDerivativePerThreadVariables[ 0 ].st_Sfm;
-  AccumulateType       sf   = this->m_CorrelationGetValueAndDerivativePerThreadVariables[ 0 ].st_Sf;
-  AccumulateType       sm   = this->m_CorrelationGetValueAndDerivativePerThreadVariables[ 0 ].st_Sm;
-  for( ThreadIdType i = 1; i < numberOfThreads; ++i )
+  AccumulateType       sff  = zero;
+  AccumulateType       smm  = zero;
+  AccumulateType       sfm  = zero;
+  AccumulateType       sf   = zero;
+  AccumulateType       sm   = zero;
+  for( ThreadIdType i = 0; i < numberOfThreads; ++i )
   {
     sff += this->m_CorrelationGetValueAndDerivativePerThreadVariables[ i ].st_Sff;
     smm += this->m_CorrelationGetValueAndDerivativePerThreadVariables[ i ].st_Smm;
@@ -771,8 +810,7 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
     temp->st_InvertedDenominator = 1.0 / denom;
     temp->st_DerivativePointer   = derivative.begin();
 
-    this->m_Threader->SetSingleMethod( AccumulateDerivativesThreaderCallback, temp );
-    this->m_Threader->SingleMethodExecute();
+    this->LaunchThreaderCallback( AccumulateDerivativesThreaderCallback, temp );
 
     delete temp;
   }
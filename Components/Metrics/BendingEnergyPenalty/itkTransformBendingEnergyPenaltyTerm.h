@@ -146,6 +146,12 @@ public:
     MeasureType & value,
     DerivativeType & derivative ) const override;
 
+  /** The penalty only evaluates the spatial Hessians, so it may run concurrently. */
+  bool GetSupportsConcurrentGetValueAndDerivative( void ) const override
+  {
+    return true;
+  }
+
   /** Get value and derivatives for each thread. */
   inline void ThreadedGetValueAndDerivative( ThreadIdType threadID ) override;
 
@@ -640,9 +640,8 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
     this->m_ThreaderMetricParameters.st_NormalizationFactor
       = static_cast< DerivativeValueType >( this->m_NumberOfPixelsCounted );
 
-    this->m_Threader->SetSingleMethod( this->AccumulateDerivativesThreaderCallback,
+    this->LaunchThreaderCallback( this->AccumulateDerivativesThreaderCallback,
       const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
-    this->m_Threader->SingleMethodExecute();
   }
 #ifdef ELASTIX_USE_OPENMP
   // compute multi-threadedly with openmp
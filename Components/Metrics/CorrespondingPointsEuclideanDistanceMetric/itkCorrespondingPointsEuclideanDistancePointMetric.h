@@ -90,6 +90,12 @@ public:
   void GetValueAndDerivative( const TransformParametersType & parameters,
     MeasureType & Value, DerivativeType & Derivative ) const override;
 
+  /** The point distances only evaluate the transform, so they may run concurrently. */
+  bool GetSupportsConcurrentGetValueAndDerivative( void ) const override
+  {
+    return true;
+  }
+
 protected:
 
   CorrespondingPointsEuclideanDistancePointMetric();
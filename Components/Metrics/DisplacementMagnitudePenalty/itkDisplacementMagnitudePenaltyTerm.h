@@ -117,6 +117,12 @@ public:
     MeasureType & value,
     DerivativeType & derivative ) const override;
 
+  /** The penalty only evaluates the transform, so it may run concurrently. */
+  bool GetSupportsConcurrentGetValueAndDerivative( void ) const override
+  {
+    return true;
+  }
+
 protected:
 
   /** Typedefs for indices and points. */
@@ -0,0 +1,199 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkFlatKDTree_h
+#define __itkFlatKDTree_h
+
+#include "itkBinaryTreeBase.h"
+#include "itkIntTypes.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/**
+ * \class FlatKDTree
+ *
+ * \brief A kd-tree that is stored in flat arrays, and that can be built and
+ * searched by several threads.
+ *
+ * The ANN trees are pointer based and the ANN search uses global variables,
+ * so an ANN tree can neither be built nor searched by multiple threads. This
+ * tree has the same interface as the ANN trees, for use by the
+ * KNNGraphAlphaMutualInformationImageToImageMetric, but:
+ *
+ * \li The nodes are stored in one array, in depth-first order, so that the
+ *   left child of a node directly follows it. The data points are copied
+ *   in the order of the leaves, so that the points of a bucket are
+ *   contiguous in memory.
+ * \li Every node splits its points at the median of the dimension with the
+ *   largest spread. The tree is therefore balanced, and the position of every
+ *   subtree in the node array is known beforehand. The subtrees below a
+ *   certain size are built in parallel, by NumberOfThreads threads.
+ * \li Search() is const and uses no global state, so it can be called by
+ *   several threads at the same time. SearchAllDataPoints() searches the
+ *   neighbours of all data points in parallel.
+ *
+ * The search is exact when the error bound is 0, and otherwise returns
+ * neighbours that are at most a factor (1 + errorBound) further away than
+ * the true neighbours, as in ANN. Points at the same distance may be returned
+ * in a different order than by ANN.
+ *
+ * \ingroup ANNwrap
+ */
+
+template< class TListSample >
+class FlatKDTree : public BinaryTreeBase< TListSample >
+{
+public:
+
+  /** Standard itk. */
+  typedef FlatKDTree                    Self;
+  typedef BinaryTreeBase< TListSample > Superclass;
+  typedef SmartPointer< Self >          Pointer;
+  typedef SmartPointer< const Self >    ConstPointer;
+
+  /** New method for creating an object using a factory. */
+  itkNewMacro( Self );
+
+  /** ITK type info. */
+  itkTypeMacro( FlatKDTree, BinaryTreeBase );
+
+  /** Typedef's from Superclass. */
+  typedef typename Superclass::SampleType                 SampleType;
+  typedef typename Superclass::MeasurementVectorType      MeasurementVectorType;
+  typedef typename Superclass::MeasurementVectorSizeType  MeasurementVectorSizeType;
+  typedef typename Superclass::TotalAbsoluteFrequencyType TotalAbsoluteFrequencyType;
+
+  /** Typedef's. */
+  typedef unsigned int BucketSizeType;
+  typedef int          IndexType;
+  typedef double       DistanceType;
+
+  /** Set and get the bucket size: the maximum number of points in a leaf. */
+  itkSetClampMacro( BucketSize, BucketSizeType, 1, NumericTraits< BucketSizeType >::max() );
+  itkGetConstMacro( BucketSize, BucketSizeType );
+
+  /** Set and get the number of threads used to build and search the tree. */
+  itkSetClampMacro( NumberOfThreads, ThreadIdType, 1, NumericTraits< ThreadIdType >::max() );
+  itkGetConstMacro( NumberOfThreads, ThreadIdType );
+
+  /** Generate the tree. */
+  void GenerateTree( void ) override;
+
+  /** Get the number of nodes of the tree. */
+  SizeValueType GetNumberOfNodes( void ) const
+  {
+    return this->m_Nodes.size();
+  }
+
+
+  /** Search the k nearest neighbours of the query point qp, which has the
+   * dimension of the data. The indices of the neighbours and their squared
+   * distances are written to the arrays of size k, ordered by increasing
+   * distance. When the tree has less than k points, the remaining indices
+   * are -1. Thread-safe.
+   */
+  void Search( const double * qp, const unsigned int k, const double errorBound,
+    IndexType * indices, DistanceType * squaredDistances ) const;
+
+  /** Search the k nearest neighbours of every data point, which includes the
+   * data point itself, in parallel. The results of data point i are written
+   * to the elements [i * k, (i + 1) * k) of the arrays, which should have
+   * the size k times the number of data points.
+   */
+  void SearchAllDataPoints( const unsigned int k, const double errorBound,
+    IndexType * indices, DistanceType * squaredDistances ) const;
+
+protected:
+
+  /** Constructor. */
+  FlatKDTree();
+
+  /** Destructor. */
+  ~FlatKDTree() override {}
+
+  /** PrintSelf. */
+  void PrintSelf( std::ostream & os, Indent indent ) const override;
+
+  /** A node of the tree. A leaf has split dimension -1. The left child of
+   * an inner node is the next node, the right child is at m_RightChild.
+   */
+  struct NodeType
+  {
+    int           m_SplitDimension;
+    DistanceType  m_SplitValue;
+    SizeValueType m_Begin;
+    SizeValueType m_End;
+    SizeValueType m_RightChild;
+  };
+
+  /** A subtree that remains to be built. */
+  struct SubtreeType
+  {
+    SizeValueType m_Node;
+    SizeValueType m_Begin;
+    SizeValueType m_End;
+  };
+
+  /** Member variables. */
+  BucketSizeType m_BucketSize;
+  ThreadIdType   m_NumberOfThreads;
+
+private:
+
+  FlatKDTree( const Self & );       // purposely not implemented
+  void operator=( const Self & );   // purposely not implemented
+
+  /** Get the number of nodes of a subtree with the given number of points. */
+  SizeValueType ComputeNumberOfNodes( const SizeValueType numberOfPoints ) const;
+
+  /** Build the subtree of the points [begin, end) at the given node. When
+   * subtrees is not null, the subtrees of at most maximumSubtreeSize points
+   * are not built, but added to subtrees.
+   */
+  void BuildSubtree( const SizeValueType node,
+    const SizeValueType begin, const SizeValueType end,
+    const SizeValueType maximumSubtreeSize,
+    std::vector< SubtreeType > * subtrees );
+
+  /** Search the subtree at the given node. offsets contains per dimension
+   * the distance of the query point to the cell of the node, and
+   * boxDistance their sum of squares.
+   */
+  void SearchSubtree( const SizeValueType node, const double * qp,
+    double * offsets, const double boxDistance, const double maximumError,
+    const unsigned int k, IndexType * indices, DistanceType * squaredDistances ) const;
+
+  /** The nodes, the data points in the order of the leaves, and per
+   * position in that order the index of the data point in the sample.
+   */
+  std::vector< NodeType >  m_Nodes;
+  std::vector< double >    m_Points;
+  std::vector< IndexType > m_PointIndices;
+  unsigned int             m_Dimension;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkFlatKDTree.hxx"
+#endif
+
+#endif // end #ifndef __itkFlatKDTree_h
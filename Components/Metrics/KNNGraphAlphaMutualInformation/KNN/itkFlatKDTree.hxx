@@ -0,0 +1,378 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkFlatKDTree_hxx
+#define __itkFlatKDTree_hxx
+
+#include "itkFlatKDTree.h"
+#include "itkWorkStealingThreadPool.h"
+#include "itkMultiThreader.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace itk
+{
+
+/**
+ * ************************ Constructor *************************
+ */
+
+template< class TListSample >
+FlatKDTree< TListSample >
+::FlatKDTree()
+{
+  this->m_BucketSize      = 1;
+  this->m_NumberOfThreads = MultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->m_Dimension       = 0;
+
+} // end Constructor()
+
+
+/**
+ * ************************ ComputeNumberOfNodes *************************
+ */
+
+template< class TListSample >
+SizeValueType
+FlatKDTree< TListSample >
+::ComputeNumberOfNodes( const SizeValueType numberOfPoints ) const
+{
+  if( numberOfPoints <= this->m_BucketSize )
+  {
+    return 1;
+  }
+  const SizeValueType leftSize = numberOfPoints / 2;
+  return 1 + this->ComputeNumberOfNodes( leftSize )
+         + this->ComputeNumberOfNodes( numberOfPoints - leftSize );
+
+} // end ComputeNumberOfNodes()
+
+
+/**
+ * ************************ GenerateTree *************************
+ */
+
+template< class TListSample >
+void
+FlatKDTree< TListSample >
+::GenerateTree( void )
+{
+  const SizeValueType numberOfPoints  = this->GetActualNumberOfDataPoints();
+  const unsigned int  dim             = this->GetDataDimension();
+  const ThreadIdType  numberOfThreads = this->m_NumberOfThreads;
+
+  this->m_Dimension = dim;
+  this->m_Nodes.clear();
+  this->m_Points.clear();
+  this->m_PointIndices.resize( numberOfPoints );
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    this->m_PointIndices[ i ] = static_cast< IndexType >( i );
+  }
+  if( numberOfPoints == 0 )
+  {
+    return;
+  }
+
+  /** The layout of the balanced tree only depends on the number of points. */
+  this->m_Nodes.resize( this->ComputeNumberOfNodes( numberOfPoints ) );
+
+  /** Build the top of the tree in this thread, and the subtrees below it in
+   * parallel. A few subtrees per thread balance the load.
+   */
+  WorkStealingThreadPool::Pointer threadPool = WorkStealingThreadPool::GetInstance();
+  if( numberOfThreads > 1 && numberOfPoints > 4 * this->m_BucketSize )
+  {
+    const SizeValueType maximumSubtreeSize = std::max< SizeValueType >(
+      this->m_BucketSize, numberOfPoints / ( 8 * numberOfThreads ) );
+    std::vector< SubtreeType > subtrees;
+    this->BuildSubtree( 0, 0, numberOfPoints, maximumSubtreeSize, &subtrees );
+
+    threadPool->ParallelForChunks( numberOfThreads, subtrees.size(), 1,
+      [ this, &subtrees ]( ThreadIdType, SizeValueType begin, SizeValueType end )
+      {
+        for( SizeValueType s = begin; s < end; ++s )
+        {
+          this->BuildSubtree( subtrees[ s ].m_Node,
+            subtrees[ s ].m_Begin, subtrees[ s ].m_End, 0, nullptr );
+        }
+      } );
+  }
+  else
+  {
+    this->BuildSubtree( 0, 0, numberOfPoints, 0, nullptr );
+  }
+
+  /** Copy the data points in the order of the leaves. */
+  const double * const * data = this->GetSample()->GetInternalContainer();
+  this->m_Points.resize( numberOfPoints * dim );
+  threadPool->ParallelForChunks( numberOfThreads, numberOfPoints, 4096,
+    [ this, data, dim ]( ThreadIdType, SizeValueType begin, SizeValueType end )
+    {
+      for( SizeValueType j = begin; j < end; ++j )
+      {
+        std::copy( data[ this->m_PointIndices[ j ] ],
+          data[ this->m_PointIndices[ j ] ] + dim, &this->m_Points[ j * dim ] );
+      }
+    } );
+
+} // end GenerateTree()
+
+
+/**
+ * ************************ BuildSubtree *************************
+ */
+
+template< class TListSample >
+void
+FlatKDTree< TListSample >
+::BuildSubtree( const SizeValueType node,
+  const SizeValueType begin, const SizeValueType end,
+  const SizeValueType maximumSubtreeSize,
+  std::vector< SubtreeType > * subtrees )
+{
+  const SizeValueType numberOfPoints = end - begin;
+  NodeType &          currentNode    = this->m_Nodes[ node ];
+  currentNode.m_Begin          = begin;
+  currentNode.m_End            = end;
+  currentNode.m_SplitDimension = -1;
+  currentNode.m_SplitValue     = 0.0;
+  currentNode.m_RightChild     = 0;
+
+  /** A leaf. */
+  if( numberOfPoints <= this->m_BucketSize )
+  {
+    return;
+  }
+
+  /** A subtree that is left to the threads. */
+  if( subtrees && numberOfPoints <= maximumSubtreeSize )
+  {
+    SubtreeType subtree;
+    subtree.m_Node  = node;
+    subtree.m_Begin = begin;
+    subtree.m_End   = end;
+    subtrees->push_back( subtree );
+    return;
+  }
+
+  /** Split along the dimension with the largest spread. */
+  const double * const * data           = this->GetSample()->GetInternalContainer();
+  IndexType *            indices        = &this->m_PointIndices[ 0 ];
+  unsigned int           splitDimension = 0;
+  double                 largestSpread  = -1.0;
+  for( unsigned int d = 0; d < this->m_Dimension; ++d )
+  {
+    double minimum = data[ indices[ begin ] ][ d ];
+    double maximum = minimum;
+    for( SizeValueType j = begin + 1; j < end; ++j )
+    {
+      const double value = data[ indices[ j ] ][ d ];
+      minimum = std::min( minimum, value );
+      maximum = std::max( maximum, value );
+    }
+    if( maximum - minimum > largestSpread )
+    {
+      largestSpread  = maximum - minimum;
+      splitDimension = d;
+    }
+  }
+
+  /** Split at the median. Ties are broken by the index of the point, so that
+   * the tree does not depend on the implementation of nth_element.
+   */
+  const SizeValueType middle = begin + numberOfPoints / 2;
+  std::nth_element( indices + begin, indices + middle, indices + end,
+    [ data, splitDimension ]( const IndexType a, const IndexType b )
+    {
+      const double va = data[ a ][ splitDimension ];
+      const double vb = data[ b ][ splitDimension ];
+      return va < vb || ( va == vb && a < b );
+    } );
+
+  const SizeValueType rightChild = node + 1 + this->ComputeNumberOfNodes( middle - begin );
+  currentNode.m_SplitDimension = static_cast< int >( splitDimension );
+  currentNode.m_SplitValue     = data[ indices[ middle ] ][ splitDimension ];
+  currentNode.m_RightChild     = rightChild;
+
+  this->BuildSubtree( node + 1, begin, middle, maximumSubtreeSize, subtrees );
+  this->BuildSubtree( rightChild, middle, end, maximumSubtreeSize, subtrees );
+
+} // end BuildSubtree()
+
+
+/**
+ * ************************ Search *************************
+ */
+
+template< class TListSample >
+void
+FlatKDTree< TListSample >
+::Search( const double * qp, const unsigned int k, const double errorBound,
+  IndexType * indices, DistanceType * squaredDistances ) const
+{
+  std::fill( indices, indices + k, -1 );
+  std::fill( squaredDistances, squaredDistances + k, std::numeric_limits< DistanceType >::max() );
+  if( this->m_Nodes.empty() || k == 0 )
+  {
+    return;
+  }
+
+  std::vector< double > offsets( this->m_Dimension, 0.0 );
+  const double          maximumError = ( 1.0 + errorBound ) * ( 1.0 + errorBound );
+  this->SearchSubtree( 0, qp, &offsets[ 0 ], 0.0, maximumError, k, indices, squaredDistances );
+
+} // end Search()
+
+
+/**
+ * ************************ SearchAllDataPoints *************************
+ */
+
+template< class TListSample >
+void
+FlatKDTree< TListSample >
+::SearchAllDataPoints( const unsigned int k, const double errorBound,
+  IndexType * indices, DistanceType * squaredDistances ) const
+{
+  if( this->m_Nodes.empty() || k == 0 )
+  {
+    return;
+  }
+
+  /** The query points are taken in the order of the leaves, so that
+   * consecutive queries visit mostly the same nodes. Every query writes
+   * its own part of the output, so the threads need no synchronisation.
+   */
+  const double maximumError = ( 1.0 + errorBound ) * ( 1.0 + errorBound );
+  WorkStealingThreadPool::GetInstance()->ParallelForChunks(
+    this->m_NumberOfThreads, this->m_PointIndices.size(), 256,
+    [ this, k, maximumError, indices, squaredDistances ]
+      ( ThreadIdType, SizeValueType begin, SizeValueType end )
+    {
+      std::vector< double > offsets( this->m_Dimension );
+      for( SizeValueType j = begin; j < end; ++j )
+      {
+        const SizeValueType i          = static_cast< SizeValueType >( this->m_PointIndices[ j ] );
+        IndexType *         indicesI   = indices + i * k;
+        DistanceType *      distancesI = squaredDistances + i * k;
+        std::fill( indicesI, indicesI + k, -1 );
+        std::fill( distancesI, distancesI + k, std::numeric_limits< DistanceType >::max() );
+        std::fill( offsets.begin(), offsets.end(), 0.0 );
+        this->SearchSubtree( 0, &this->m_Points[ j * this->m_Dimension ], &offsets[ 0 ],
+          0.0, maximumError, k, indicesI, distancesI );
+      }
+    } );
+
+} // end SearchAllDataPoints()
+
+
+/**
+ * ************************ SearchSubtree *************************
+ */
+
+template< class TListSample >
+void
+FlatKDTree< TListSample >
+::SearchSubtree( const SizeValueType node, const double * qp,
+  double * offsets, const double boxDistance, const double maximumError,
+  const unsigned int k, IndexType * indices, DistanceType * squaredDistances ) const
+{
+  const NodeType &   currentNode = this->m_Nodes[ node ];
+  const unsigned int dim         = this->m_Dimension;
+
+  /** In a leaf, check all points, and insert the close ones in the sorted list. */
+  if( currentNode.m_SplitDimension < 0 )
+  {
+    for( SizeValueType j = currentNode.m_Begin; j < currentNode.m_End; ++j )
+    {
+      const double * point     = &this->m_Points[ j * dim ];
+      const double   threshold = squaredDistances[ k - 1 ];
+      double         distance  = 0.0;
+      unsigned int   d         = 0;
+      for( ; d < dim; ++d )
+      {
+        const double diff = qp[ d ] - point[ d ];
+        distance += diff * diff;
+        if( distance > threshold )
+        {
+          break;
+        }
+      }
+      if( d < dim )
+      {
+        continue;
+      }
+
+      unsigned int p = k - 1;
+      for( ; p > 0 && squaredDistances[ p - 1 ] > distance; --p )
+      {
+        squaredDistances[ p ] = squaredDistances[ p - 1 ];
+        indices[ p ]          = indices[ p - 1 ];
+      }
+      squaredDistances[ p ] = distance;
+      indices[ p ]          = this->m_PointIndices[ j ];
+    }
+    return;
+  }
+
+  /** Visit the child that contains the query point first, and the other
+   * one only if its cell can contain closer points.
+   */
+  const unsigned int  splitDimension = static_cast< unsigned int >( currentNode.m_SplitDimension );
+  const double        diff           = qp[ splitDimension ] - currentNode.m_SplitValue;
+  const SizeValueType closeChild     = diff < 0.0 ? node + 1 : currentNode.m_RightChild;
+  const SizeValueType farChild       = diff < 0.0 ? currentNode.m_RightChild : node + 1;
+
+  this->SearchSubtree( closeChild, qp, offsets, boxDistance, maximumError,
+    k, indices, squaredDistances );
+
+  const double oldOffset      = offsets[ splitDimension ];
+  const double farBoxDistance = boxDistance + ( diff * diff - oldOffset * oldOffset );
+  if( farBoxDistance * maximumError < squaredDistances[ k - 1 ] )
+  {
+    offsets[ splitDimension ] = diff;
+    this->SearchSubtree( farChild, qp, offsets, farBoxDistance, maximumError,
+      k, indices, squaredDistances );
+    offsets[ splitDimension ] = oldOffset;
+  }
+
+} // end SearchSubtree()
+
+
+/**
+ * ************************ PrintSelf *************************
+ */
+
+template< class TListSample >
+void
+FlatKDTree< TListSample >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "BucketSize: " << this->m_BucketSize << std::endl;
+  os << indent << "NumberOfThreads: " << this->m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfNodes: " << this->m_Nodes.size() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkFlatKDTree_hxx
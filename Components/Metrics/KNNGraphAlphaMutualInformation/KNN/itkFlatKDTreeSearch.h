@@ -0,0 +1,106 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkFlatKDTreeSearch_h
+#define __itkFlatKDTreeSearch_h
+
+#include "itkBinaryTreeSearchBase.h"
+#include "itkFlatKDTree.h"
+
+namespace itk
+{
+
+/**
+ * \class FlatKDTreeSearch
+ *
+ * \brief Searches the k nearest neighbours in a FlatKDTree.
+ *
+ * The equivalent of the ANNStandardTreeSearch for the FlatKDTree. Besides
+ * the Search() of a single query point, it offers SearchAllDataPoints(),
+ * which searches the neighbours of all points of the tree in parallel.
+ *
+ * \ingroup ANNwrap
+ */
+
+template< class TListSample >
+class FlatKDTreeSearch : public BinaryTreeSearchBase< TListSample >
+{
+public:
+
+  /** Standard itk. */
+  typedef FlatKDTreeSearch                    Self;
+  typedef BinaryTreeSearchBase< TListSample > Superclass;
+  typedef SmartPointer< Self >                Pointer;
+  typedef SmartPointer< const Self >          ConstPointer;
+
+  /** New method for creating an object using a factory. */
+  itkNewMacro( Self );
+
+  /** ITK type info. */
+  itkTypeMacro( FlatKDTreeSearch, BinaryTreeSearchBase );
+
+  /** Typedefs from Superclass. */
+  typedef typename Superclass::ListSampleType        ListSampleType;
+  typedef typename Superclass::BinaryTreeType        BinaryTreeType;
+  typedef typename Superclass::MeasurementVectorType MeasurementVectorType;
+  typedef typename Superclass::IndexArrayType        IndexArrayType;
+  typedef typename Superclass::DistanceArrayType     DistanceArrayType;
+
+  /** The tree. */
+  typedef FlatKDTree< ListSampleType >          FlatKDTreeType;
+  typedef typename FlatKDTreeType::IndexType    IndexType;
+  typedef typename FlatKDTreeType::DistanceType DistanceType;
+
+  /** Set and get the error bound eps. */
+  itkSetClampMacro( ErrorBound, double, 0.0, 1e14 );
+  itkGetConstMacro( ErrorBound, double );
+
+  /** Set the binary tree, which should be a FlatKDTree. */
+  void SetBinaryTree( BinaryTreeType * tree ) override;
+
+  /** Search the nearest neighbours of a query point qp. */
+  void Search( const MeasurementVectorType & qp, IndexArrayType & ind,
+    DistanceArrayType & dists ) override;
+
+  /** Search the nearest neighbours of all data points of the tree, in
+   * parallel. See FlatKDTree::SearchAllDataPoints().
+   */
+  void SearchAllDataPoints( IndexType * indices, DistanceType * squaredDistances ) const;
+
+protected:
+
+  FlatKDTreeSearch();
+  ~FlatKDTreeSearch() override {}
+
+  /** Member variables. */
+  double                           m_ErrorBound;
+  typename FlatKDTreeType::Pointer m_BinaryTreeAsFlatKDTree;
+
+private:
+
+  FlatKDTreeSearch( const Self & ); // purposely not implemented
+  void operator=( const Self & );   // purposely not implemented
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkFlatKDTreeSearch.hxx"
+#endif
+
+#endif // end #ifndef __itkFlatKDTreeSearch_h
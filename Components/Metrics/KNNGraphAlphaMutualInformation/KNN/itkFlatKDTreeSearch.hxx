@@ -0,0 +1,117 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkFlatKDTreeSearch_hxx
+#define __itkFlatKDTreeSearch_hxx
+
+#include "itkFlatKDTreeSearch.h"
+
+namespace itk
+{
+
+/**
+ * ************************ Constructor *************************
+ */
+
+template< class TListSample >
+FlatKDTreeSearch< TListSample >
+::FlatKDTreeSearch()
+{
+  this->m_ErrorBound             = 0.0;
+  this->m_BinaryTreeAsFlatKDTree = 0;
+
+} // end Constructor
+
+
+/**
+ * ************************ SetBinaryTree *************************
+ */
+
+template< class TListSample >
+void
+FlatKDTreeSearch< TListSample >
+::SetBinaryTree( BinaryTreeType * tree )
+{
+  this->Superclass::SetBinaryTree( tree );
+  if( tree )
+  {
+    FlatKDTreeType * testPtr = dynamic_cast< FlatKDTreeType * >( tree );
+    if( !testPtr )
+    {
+      itkExceptionMacro( << "ERROR: The tree is not of type FlatKDTree." );
+    }
+    if( testPtr != this->m_BinaryTreeAsFlatKDTree )
+    {
+      this->m_BinaryTreeAsFlatKDTree = testPtr;
+      this->Modified();
+    }
+  }
+  else if( this->m_BinaryTreeAsFlatKDTree.IsNotNull() )
+  {
+    this->m_BinaryTreeAsFlatKDTree = 0;
+    this->Modified();
+  }
+
+} // end SetBinaryTree
+
+
+/**
+ * ************************ Search *************************
+ */
+
+template< class TListSample >
+void
+FlatKDTreeSearch< TListSample >
+::Search( const MeasurementVectorType & qp, IndexArrayType & ind,
+  DistanceArrayType & dists )
+{
+  const unsigned int k = this->m_KNearestNeighbors;
+  ind.SetSize( k );
+  dists.SetSize( k );
+
+  /** Copy the query point, since the MeasurementVectorType may not store doubles. */
+  const unsigned int    dim = this->m_BinaryTreeAsFlatKDTree->GetDataDimension();
+  std::vector< double > queryPoint( dim );
+  for( unsigned int i = 0; i < dim; ++i )
+  {
+    queryPoint[ i ] = qp[ i ];
+  }
+
+  this->m_BinaryTreeAsFlatKDTree->Search( &queryPoint[ 0 ], k, this->m_ErrorBound,
+    ind.data_block(), dists.data_block() );
+
+} // end Search
+
+
+/**
+ * ************************ SearchAllDataPoints *************************
+ */
+
+template< class TListSample >
+void
+FlatKDTreeSearch< TListSample >
+::SearchAllDataPoints( IndexType * indices, DistanceType * squaredDistances ) const
+{
+  this->m_BinaryTreeAsFlatKDTree->SearchAllDataPoints(
+    this->m_KNearestNeighbors, this->m_ErrorBound, indices, squaredDistances );
+
+} // end SearchAllDataPoints
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkFlatKDTreeSearch_hxx
@@ -37,7 +37,10 @@ namespace elastix
  *    Choose a value between 0.0 and 1.0. The default is 0.5.
  * \parameter TreeType: The type of the kNN binary tree. \n
  *    <tt>(TreeType "BDTree" "BruteForceTree")</tt> \n
- *    Choose one of { KDTree, BDTree, BruteForceTree }. \n
+ *    Choose one of { KDTree, BDTree, BruteForceTree, FlatKDTree }. \n
+ *    The FlatKDTree is a kd-tree that is built and searched by multiple threads,
+ *    and that splits at the median, so the SplittingRule does not apply to it.
+ *    Only the "Standard" TreeSearchType can be combined with it. \n
  *    The default is "KDTree" for all resolutions.
  * \parameter BucketSize: The maximum number of samples in one bucket. \n
  *    This parameter influences the calculation time only, and is not appropiate for the BruteForceTree. \n
@@ -31,11 +31,13 @@
 #include "itkANNkDTree.h"
 #include "itkANNbdTree.h"
 #include "itkANNBruteForceTree.h"
+#include "itkFlatKDTree.h"
 
 /** Supported tree searchers. */
 #include "itkANNStandardTreeSearch.h"
 #include "itkANNFixedRadiusTreeSearch.h"
 #include "itkANNPriorityTreeSearch.h"
+#include "itkFlatKDTreeSearch.h"
 
 /** Include for the spatial derivatives. */
 #include "itkArray2D.h"
@@ -56,6 +58,11 @@ namespace itk
  * the k-Nearest Neighbour (kNN) graph, using an implementation provided
  * by the Approximate Nearest Neighbour (ANN) software package.
  *
+ * The ANN trees are built and searched by one thread. Alternatively, the
+ * FlatKDTree and its FlatKDTreeSearch can be selected, which are built and
+ * searched in parallel. The derivative is then also accumulated by several
+ * threads, when UseMultiThread is on.
+ *
  * Note that the feature image are given beforehand, and that values
  * are calculated by interpolation on the transformed point. For some
  * features, it would be better (but slower) to first apply the transform
@@ -161,6 +168,7 @@ public:
   typedef ANNkDTree< ListSampleType >         ANNkDTreeType;
   typedef ANNbdTree< ListSampleType >         ANNbdTreeType;
   typedef ANNBruteForceTree< ListSampleType > ANNBruteForceTreeType;
+  typedef FlatKDTree< ListSampleType >        FlatKDTreeType;
 
   /** Typedefs for tree searchers. */
   typedef BinaryTreeSearchBase< ListSampleType >     BinaryKNNTreeSearchType;
@@ -168,6 +176,7 @@ public:
   typedef ANNStandardTreeSearch< ListSampleType >    ANNStandardTreeSearchType;
   typedef ANNFixedRadiusTreeSearch< ListSampleType > ANNFixedRadiusTreeSearchType;
   typedef ANNPriorityTreeSearch< ListSampleType >    ANNPriorityTreeSearchType;
+  typedef FlatKDTreeSearch< ListSampleType >         FlatKDTreeSearchType;
 
   typedef typename BinaryKNNTreeSearchType::IndexArrayType    IndexArrayType;
   typedef typename BinaryKNNTreeSearchType::DistanceArrayType DistanceArrayType;
@@ -177,7 +186,7 @@ public:
 
   /**
    * *** Set trees: ***
-   * Currently kd, bd, and brute force trees are supported.
+   * Currently kd, bd, brute force, and flat kd trees are supported.
    */
 
   /** Set ANNkDTree. */
@@ -200,9 +209,12 @@ public:
   /** Set ANNBruteForceTree. */
   void SetANNBruteForceTree( void );
 
+  /** Set FlatKDTree. It should be combined with the FlatKDTreeSearch. */
+  void SetFlatKDTree( unsigned int bucketSize );
+
   /**
    * *** Set tree searchers: ***
-   * Currently standard, fixed radius, and priority tree searchers are supported.
+   * Currently standard, fixed radius, priority, and flat kd tree searchers are supported.
    */
 
   /** Set ANNStandardTreeSearch. */
@@ -217,6 +229,10 @@ public:
   void SetANNPriorityTreeSearch( unsigned int kNearestNeighbors,
     double errorBound );
 
+  /** Set FlatKDTreeSearch. It can only search a FlatKDTree. */
+  void SetFlatKDTreeSearch( unsigned int kNearestNeighbors,
+    double errorBound );
+
   /**
    * *** Standard metric stuff: ***
    */
@@ -286,6 +302,10 @@ private:
   typedef Array2D< double >                         SpatialDerivativeType;
   typedef std::vector< SpatialDerivativeType >      SpatialDerivativeContainerType;
 
+  /** Typedef's for the neighbours of all samples: k per sample. */
+  typedef std::vector< int >    NeighbourIndicesContainerType;
+  typedef std::vector< double > NeighbourDistancesContainerType;
+
   /** This function takes the fixed image samples from the ImageSampler
    * and puts them in the listSampleFixed, together with the fixed feature
    * image samples. Also the corresponding moving image values and moving
@@ -306,6 +326,33 @@ private:
     TransformJacobianIndicesContainerType & jacobiansIndices,
     SpatialDerivativeContainerType & spatialDerivatives ) const;
 
+  /** This function searches the k nearest neighbours of all samples in
+   * a list sample, using the given searcher. The FlatKDTreeSearch does this
+   * in parallel; the ANN searchers one sample at a time.
+   */
+  virtual void ComputeNearestNeighbours(
+    BinaryKNNTreeSearchType * searcher,
+    const ListSamplePointer & listSample,
+    NeighbourIndicesContainerType & indices,
+    NeighbourDistancesContainerType & distances ) const;
+
+  /** This function computes the contributions of the samples [begin, end)
+   * to the sum of the G's and to the derivative, given their neighbours.
+   */
+  virtual void ComputeValueAndDerivativeContributions(
+    const SizeValueType begin, const SizeValueType end,
+    const ListSamplePointer & listSampleMoving,
+    const NeighbourIndicesContainerType & indices_M,
+    const NeighbourIndicesContainerType & indices_J,
+    const NeighbourDistancesContainerType & distances_F,
+    const NeighbourDistancesContainerType & distances_M,
+    const NeighbourDistancesContainerType & distances_J,
+    const TransformJacobianContainerType & jacobians,
+    const TransformJacobianIndicesContainerType & jacobiansIndices,
+    const SpatialDerivativeContainerType & spatialDerivatives,
+    double & sumG,
+    DerivativeType & contribution ) const;
+
   /** This function calculates the spatial derivative of the
    * featureNr feature image at the point mappedPoint.
    * \todo move this to base class.
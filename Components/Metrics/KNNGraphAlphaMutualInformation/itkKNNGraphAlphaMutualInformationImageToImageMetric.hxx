@@ -161,6 +161,30 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 } // end SetANNBruteForceTree()
 
 
+/**
+ * ************************ SetFlatKDTree *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::SetFlatKDTree( unsigned int bucketSize )
+{
+  typename FlatKDTreeType::Pointer tmpPtrF = FlatKDTreeType::New();
+  typename FlatKDTreeType::Pointer tmpPtrM = FlatKDTreeType::New();
+  typename FlatKDTreeType::Pointer tmpPtrJ = FlatKDTreeType::New();
+
+  tmpPtrF->SetBucketSize( bucketSize );
+  tmpPtrM->SetBucketSize( bucketSize );
+  tmpPtrJ->SetBucketSize( bucketSize );
+
+  this->m_BinaryKNNTreeFixed  = tmpPtrF;
+  this->m_BinaryKNNTreeMoving = tmpPtrM;
+  this->m_BinaryKNNTreeJoint  = tmpPtrJ;
+
+} // end SetFlatKDTree()
+
+
 /**
  * ************************ SetANNStandardTreeSearch *************************
  */
@@ -265,6 +289,39 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 } // end SetANNPriorityTreeSearch()
 
 
+/**
+ * ************************ SetFlatKDTreeSearch *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::SetFlatKDTreeSearch(
+  unsigned int kNearestNeighbors,
+  double errorBound )
+{
+  typename FlatKDTreeSearchType::Pointer tmpPtrF
+    = FlatKDTreeSearchType::New();
+  typename FlatKDTreeSearchType::Pointer tmpPtrM
+    = FlatKDTreeSearchType::New();
+  typename FlatKDTreeSearchType::Pointer tmpPtrJ
+    = FlatKDTreeSearchType::New();
+
+  tmpPtrF->SetKNearestNeighbors( kNearestNeighbors );
+  tmpPtrM->SetKNearestNeighbors( kNearestNeighbors );
+  tmpPtrJ->SetKNearestNeighbors( kNearestNeighbors );
+
+  tmpPtrF->SetErrorBound( errorBound );
+  tmpPtrM->SetErrorBound( errorBound );
+  tmpPtrJ->SetErrorBound( errorBound );
+
+  this->m_BinaryKNNTreeSearcherFixed  = tmpPtrF;
+  this->m_BinaryKNNTreeSearcherMoving = tmpPtrM;
+  this->m_BinaryKNNTreeSearcherJoint  = tmpPtrJ;
+
+} // end SetFlatKDTreeSearch()
+
+
 /**
  * ********************* Initialize *****************************
  */
@@ -289,6 +346,21 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
     itkExceptionMacro( << "ERROR: The kNN tree searcher is not set. " );
   }
 
+  /** The flat kd trees are built and searched with the threads of the metric. */
+  const ThreadIdType numberOfThreads
+    = this->m_UseMultiThread ? this->GetNumberOfThreads() : 1;
+  BinaryKNNTreeType * trees[ 3 ] = {
+    this->m_BinaryKNNTreeFixed, this->m_BinaryKNNTreeMoving, this->m_BinaryKNNTreeJoint
+  };
+  for( unsigned int i = 0; i < 3; ++i )
+  {
+    FlatKDTreeType * flatTree = dynamic_cast< FlatKDTreeType * >( trees[ i ] );
+    if( flatTree )
+    {
+      flatTree->SetNumberOfThreads( numberOfThreads );
+    }
+  }
+
 } // end Initialize()
 
 
@@ -389,12 +461,18 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
    * where d1 and d2 are the possibly different dimensions of the two feature sets.
    */
 
+  /** Search for the k nearest neighbours of all query points, i.e. all samples. */
+  NeighbourIndicesContainerType   indices_F, indices_M, indices_J;
+  NeighbourDistancesContainerType distances_F, distances_M, distances_J;
+  this->ComputeNearestNeighbours( this->m_BinaryKNNTreeSearcherFixed,
+    listSampleFixed, indices_F, distances_F );
+  this->ComputeNearestNeighbours( this->m_BinaryKNNTreeSearcherMoving,
+    listSampleMoving, indices_M, distances_M );
+  this->ComputeNearestNeighbours( this->m_BinaryKNNTreeSearcherJoint,
+    listSampleJoint, indices_J, distances_J );
+
   /** Temporary variables. */
   typedef typename NumericTraits< MeasureType >::AccumulateType AccumulateType;
-  MeasurementVectorType z_F, z_M, z_J;
-  IndexArrayType        indices_F, indices_M, indices_J;
-  DistanceArrayType     distances_F, distances_M, distances_J;
-
   MeasureType    H, G;
   AccumulateType sumG = NumericTraits< AccumulateType >::Zero;
 
@@ -410,16 +488,6 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
   /** Loop over all query points, i.e. all samples. */
   for( unsigned long i = 0; i < this->m_NumberOfPixelsCounted; i++ )
   {
-    /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(  i, z_F );
-    listSampleMoving->GetMeasurementVector( i, z_M );
-    listSampleJoint->GetMeasurementVector(  i, z_J );
-
-    /** Search for the K nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(  z_F, indices_F, distances_F );
-    this->m_BinaryKNNTreeSearcherMoving->Search( z_M, indices_M, distances_M );
-    this->m_BinaryKNNTreeSearcherJoint->Search(  z_J, indices_J, distances_J );
-
     /** Add the distances between the points to get the total graph length.
      * The outcommented implementation calculates: sum J/sqrt(F*M)
      *
@@ -446,9 +514,9 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
     /** Loop over the neighbours. */
     for( unsigned int p = 0; p < k; p++ )
     {
-      Gamma_F += std::sqrt( distances_F[ p ] );
-      Gamma_M += std::sqrt( distances_M[ p ] );
-      Gamma_J += std::sqrt( distances_J[ p ] );
+      Gamma_F += std::sqrt( distances_F[ i * k + p ] );
+      Gamma_M += std::sqrt( distances_M[ i * k + p ] );
+      Gamma_J += std::sqrt( distances_J[ i * k + p ] );
     } // end loop over the k neighbours
 
     /** Calculate the contribution of this query point. */
@@ -614,107 +682,69 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
    * where d1 and d2 are the possibly different dimensions of the two feature sets.
    */
 
+  /** Search for the k nearest neighbours of all query points, i.e. all samples. */
+  NeighbourIndicesContainerType   indices_F, indices_M, indices_J;
+  NeighbourDistancesContainerType distances_F, distances_M, distances_J;
+  this->ComputeNearestNeighbours( this->m_BinaryKNNTreeSearcherFixed,
+    listSampleFixed, indices_F, distances_F );
+  this->ComputeNearestNeighbours( this->m_BinaryKNNTreeSearcherMoving,
+    listSampleMoving, indices_M, distances_M );
+  this->ComputeNearestNeighbours( this->m_BinaryKNNTreeSearcherJoint,
+    listSampleJoint, indices_J, distances_J );
+
   /** Temporary variables. */
   typedef typename NumericTraits< MeasureType >::AccumulateType AccumulateType;
-  MeasurementVectorType z_F, z_M, z_J, z_M_ip, z_J_ip, diff_M, diff_J;
-  IndexArrayType        indices_F,   indices_M,   indices_J;
-  DistanceArrayType     distances_F, distances_M, distances_J;
-  MeasureType           distance_F,  distance_M,  distance_J;
-
-  MeasureType    H, G, Gpow;
   AccumulateType sumG = NumericTraits< AccumulateType >::Zero;
 
   DerivativeType contribution( this->GetNumberOfParameters() );
   contribution.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
-  DerivativeType dGamma_M( this->GetNumberOfParameters() );
-  DerivativeType dGamma_J( this->GetNumberOfParameters() );
 
   /** Get the size of the feature vectors. */
   unsigned int fixedSize  = this->GetNumberOfFixedImages();
   unsigned int movingSize = this->GetNumberOfMovingImages();
   unsigned int jointSize  = fixedSize + movingSize;
 
-  /** Get the number of neighbours and \gamma. */
-  unsigned int k        = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
-  double       twoGamma = jointSize * ( 1.0 - this->m_Alpha );
-
-  /** Loop over all query points, i.e. all samples. */
-  for( unsigned long i = 0; i < this->m_NumberOfPixelsCounted; i++ )
+  /** Loop over all query points, i.e. all samples. With multiple threads,
+   * every thread takes a fixed range of samples, with its own sum and
+   * contribution, which are added in the order of the threads.
+   */
+  const SizeValueType numberOfSamples = this->m_NumberOfPixelsCounted;
+  const ThreadIdType  numberOfThreads = this->m_UseMultiThread
+    ? static_cast< ThreadIdType >( std::min< SizeValueType >(
+    this->GetNumberOfThreads(), numberOfSamples ) ) : 1;
+  if( numberOfThreads > 1 )
   {
-    /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(  i, z_F );
-    listSampleMoving->GetMeasurementVector( i, z_M );
-    listSampleJoint->GetMeasurementVector(  i, z_J );
-
-    /** Search for the k nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(  z_F, indices_F, distances_F );
-    this->m_BinaryKNNTreeSearcherMoving->Search( z_M, indices_M, distances_M );
-    this->m_BinaryKNNTreeSearcherJoint->Search(  z_J, indices_J, distances_J );
-
-    /** Variables to compute the measure and its derivative. */
-    AccumulateType Gamma_F = NumericTraits< AccumulateType >::Zero;
-    AccumulateType Gamma_M = NumericTraits< AccumulateType >::Zero;
-    AccumulateType Gamma_J = NumericTraits< AccumulateType >::Zero;
-
-    SpatialDerivativeType D1sparse, D2sparse_M, D2sparse_J;
-    D1sparse = spatialDerivativesContainer[ i ] * jacobianContainer[ i ];
-
-    dGamma_M.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
-    dGamma_J.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
-
-    /** Loop over the neighbours. */
-    for( unsigned int p = 0; p < k; p++ )
-    {
-      /** Get the neighbour point z_ip^M. */
-      listSampleMoving->GetMeasurementVector( indices_M[ p ], z_M_ip );
-      listSampleMoving->GetMeasurementVector( indices_J[ p ], z_J_ip );
-
-      /** Get the distances. */
-      distance_F = std::sqrt( distances_F[ p ] );
-      distance_M = std::sqrt( distances_M[ p ] );
-      distance_J = std::sqrt( distances_J[ p ] );
-
-      /** Compute Gamma's. */
-      Gamma_F += distance_F;
-      Gamma_M += distance_M;
-      Gamma_J += distance_J;
-
-      /** Get the difference of z_ip^M with z_i^M. */
-      diff_M = z_M - z_M_ip;
-      diff_J = z_M - z_J_ip;
-
-      /** Compute derivatives. */
-      D2sparse_M = spatialDerivativesContainer[ indices_M[ p ] ]
-        * jacobianContainer[ indices_M[ p ] ];
-      D2sparse_J = spatialDerivativesContainer[ indices_J[ p ] ]
-        * jacobianContainer[ indices_J[ p ] ];
-
-      /** Update the dGamma's. */
-      this->UpdateDerivativeOfGammas(
-        D1sparse, D2sparse_M, D2sparse_J,
-        jacobianIndicesContainer[ i ],
-        jacobianIndicesContainer[ indices_M[ p ] ],
-        jacobianIndicesContainer[ indices_J[ p ] ],
-        diff_M, diff_J,
-        distance_M, distance_J,
-        dGamma_M, dGamma_J );
-
-    } // end loop over the k neighbours
-
-    /** Compute contributions. */
-    H = std::sqrt( Gamma_F * Gamma_M );
-    if( H > this->m_AvoidDivisionBy )
+    std::vector< double >         sumGs( numberOfThreads, 0.0 );
+    std::vector< DerivativeType > contributions( numberOfThreads );
+    WorkStealingThreadPool::GetInstance()->ParallelForSlots( numberOfThreads,
+      [ & ]( ThreadIdType slot )
+      {
+        contributions[ slot ].SetSize( this->GetNumberOfParameters() );
+        contributions[ slot ].Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+        this->ComputeValueAndDerivativeContributions(
+          numberOfSamples * slot / numberOfThreads,
+          numberOfSamples * ( slot + 1 ) / numberOfThreads,
+          listSampleMoving, indices_M, indices_J,
+          distances_F, distances_M, distances_J,
+          jacobianContainer, jacobianIndicesContainer, spatialDerivativesContainer,
+          sumGs[ slot ], contributions[ slot ] );
+      } );
+    for( ThreadIdType slot = 0; slot < numberOfThreads; ++slot )
     {
-      /** Compute some sums. */
-      G     = Gamma_J / H;
-      sumG += std::pow( G, twoGamma );
-
-      /** Compute the contribution to the derivative. */
-      Gpow          = std::pow( G, twoGamma - 1.0 );
-      contribution += ( Gpow / H ) * ( dGamma_J - ( 0.5 * Gamma_J / Gamma_M ) * dGamma_M );
+      sumG         += sumGs[ slot ];
+      contribution += contributions[ slot ];
     }
-
-  } // end looping over all query points
+  }
+  else
+  {
+    double sumGThisThread = 0.0;
+    this->ComputeValueAndDerivativeContributions( 0, numberOfSamples,
+      listSampleMoving, indices_M, indices_J,
+      distances_F, distances_M, distances_J,
+      jacobianContainer, jacobianIndicesContainer, spatialDerivativesContainer,
+      sumGThisThread, contribution );
+    sumG = sumGThisThread;
+  }
 
   /**
    * *************** Finally, calculate the metric value and derivative ******************
@@ -928,6 +958,170 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 } // end ComputeListSampleValuesAndDerivativePlusJacobian()
 
 
+/**
+ * ************************ ComputeNearestNeighbours *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeNearestNeighbours(
+  BinaryKNNTreeSearchType * searcher,
+  const ListSamplePointer & listSample,
+  NeighbourIndicesContainerType & indices,
+  NeighbourDistancesContainerType & distances ) const
+{
+  const SizeValueType numberOfSamples = this->m_NumberOfPixelsCounted;
+  const unsigned int  k               = searcher->GetKNearestNeighbors();
+  indices.resize( numberOfSamples * k );
+  distances.resize( numberOfSamples * k );
+  if( numberOfSamples == 0 || k == 0 )
+  {
+    return;
+  }
+
+  /** The flat kd tree searches all samples in parallel. */
+  FlatKDTreeSearchType * flatSearcher = dynamic_cast< FlatKDTreeSearchType * >( searcher );
+  if( flatSearcher )
+  {
+    flatSearcher->SearchAllDataPoints( &indices[ 0 ], &distances[ 0 ] );
+    return;
+  }
+
+  /** The ANN trees are searched one sample at a time. */
+  MeasurementVectorType z;
+  IndexArrayType        indices_i;
+  DistanceArrayType     distances_i;
+  for( SizeValueType i = 0; i < numberOfSamples; ++i )
+  {
+    listSample->GetMeasurementVector( i, z );
+    searcher->Search( z, indices_i, distances_i );
+    for( unsigned int p = 0; p < k; ++p )
+    {
+      indices[ i * k + p ]   = indices_i[ p ];
+      distances[ i * k + p ] = distances_i[ p ];
+    }
+  }
+
+} // end ComputeNearestNeighbours()
+
+
+/**
+ * ************************ ComputeValueAndDerivativeContributions *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeValueAndDerivativeContributions(
+  const SizeValueType begin, const SizeValueType end,
+  const ListSamplePointer & listSampleMoving,
+  const NeighbourIndicesContainerType & indices_M,
+  const NeighbourIndicesContainerType & indices_J,
+  const NeighbourDistancesContainerType & distances_F,
+  const NeighbourDistancesContainerType & distances_M,
+  const NeighbourDistancesContainerType & distances_J,
+  const TransformJacobianContainerType & jacobianContainer,
+  const TransformJacobianIndicesContainerType & jacobianIndicesContainer,
+  const SpatialDerivativeContainerType & spatialDerivativesContainer,
+  double & sumG,
+  DerivativeType & contribution ) const
+{
+  /** Temporary variables. */
+  typedef typename NumericTraits< MeasureType >::AccumulateType AccumulateType;
+  MeasurementVectorType z_M, z_M_ip, z_J_ip, diff_M, diff_J;
+  MeasureType           distance_F,  distance_M,  distance_J;
+  MeasureType           H, G, Gpow;
+
+  DerivativeType dGamma_M( this->GetNumberOfParameters() );
+  DerivativeType dGamma_J( this->GetNumberOfParameters() );
+
+  /** Get the size of the feature vectors. */
+  unsigned int fixedSize  = this->GetNumberOfFixedImages();
+  unsigned int movingSize = this->GetNumberOfMovingImages();
+  unsigned int jointSize  = fixedSize + movingSize;
+
+  /** Get the number of neighbours and \gamma. */
+  unsigned int k        = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
+  double       twoGamma = jointSize * ( 1.0 - this->m_Alpha );
+
+  /** Loop over the query points. */
+  for( SizeValueType i = begin; i < end; i++ )
+  {
+    /** Get the i-th query point. */
+    listSampleMoving->GetMeasurementVector( i, z_M );
+
+    /** Variables to compute the measure and its derivative. */
+    AccumulateType Gamma_F = NumericTraits< AccumulateType >::Zero;
+    AccumulateType Gamma_M = NumericTraits< AccumulateType >::Zero;
+    AccumulateType Gamma_J = NumericTraits< AccumulateType >::Zero;
+
+    SpatialDerivativeType D1sparse, D2sparse_M, D2sparse_J;
+    D1sparse = spatialDerivativesContainer[ i ] * jacobianContainer[ i ];
+
+    dGamma_M.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+    dGamma_J.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+
+    /** Loop over the neighbours. */
+    for( unsigned int p = 0; p < k; p++ )
+    {
+      const int index_M = indices_M[ i * k + p ];
+      const int index_J = indices_J[ i * k + p ];
+
+      /** Get the neighbour point z_ip^M. */
+      listSampleMoving->GetMeasurementVector( index_M, z_M_ip );
+      listSampleMoving->GetMeasurementVector( index_J, z_J_ip );
+
+      /** Get the distances. */
+      distance_F = std::sqrt( distances_F[ i * k + p ] );
+      distance_M = std::sqrt( distances_M[ i * k + p ] );
+      distance_J = std::sqrt( distances_J[ i * k + p ] );
+
+      /** Compute Gamma's. */
+      Gamma_F += distance_F;
+      Gamma_M += distance_M;
+      Gamma_J += distance_J;
+
+      /** Get the difference of z_ip^M with z_i^M. */
+      diff_M = z_M - z_M_ip;
+      diff_J = z_M - z_J_ip;
+
+      /** Compute derivatives. */
+      D2sparse_M = spatialDerivativesContainer[ index_M ]
+        * jacobianContainer[ index_M ];
+      D2sparse_J = spatialDerivativesContainer[ index_J ]
+        * jacobianContainer[ index_J ];
+
+      /** Update the dGamma's. */
+      this->UpdateDerivativeOfGammas(
+        D1sparse, D2sparse_M, D2sparse_J,
+        jacobianIndicesContainer[ i ],
+        jacobianIndicesContainer[ index_M ],
+        jacobianIndicesContainer[ index_J ],
+        diff_M, diff_J,
+        distance_M, distance_J,
+        dGamma_M, dGamma_J );
+
+    } // end loop over the k neighbours
+
+    /** Compute contributions. */
+    H = std::sqrt( Gamma_F * Gamma_M );
+    if( H > this->m_AvoidDivisionBy )
+    {
+      /** Compute some sums. */
+      G     = Gamma_J / H;
+      sumG += std::pow( G, twoGamma );
+
+      /** Compute the contribution to the derivative. */
+      Gpow          = std::pow( G, twoGamma - 1.0 );
+      contribution += ( Gpow / H ) * ( dGamma_J - ( 0.5 * Gamma_J / Gamma_M ) * dGamma_M );
+    }
+
+  } // end looping over the query points
+
+} // end ComputeValueAndDerivativeContributions()
+
+
 /**
  * ************************ EvaluateMovingFeatureImageDerivatives *************************
  */
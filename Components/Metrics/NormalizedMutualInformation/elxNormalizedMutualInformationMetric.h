@@ -64,6 +64,13 @@ namespace elastix
  *    useful if you use high order B-spline interpolator for the moving image.\n
  *    example: <tt>(MovingLimitRangeRatio 0.001 0.01 0.01)</tt> \n
  *    The default value is 0.01. Can be given for each resolution, or for all resolutions at once.
+ * \parameter JointHistogramReduction: How the joint histograms of the threads
+ *    are combined. "Serial" sums them in one thread. "Tree" lets every thread
+ *    sum a band of histogram rows, pairwise in a tree, which scales better
+ *    with many threads and few samples. Can be given for each resolution,
+ *    or for all resolutions at once. \n
+ *    example: <tt>(JointHistogramReduction "Tree")</tt> \n
+ *    The default is "Serial".
  *
  * \sa ParzenWindowNormalizedMutualInformationImageToImageMetric
  * \ingroup Metrics
@@ -102,6 +102,12 @@ NormalizedMutualInformationMetric< TElastix >
   this->SetFixedKernelBSplineOrder( fixedKernelBSplineOrder );
   this->SetMovingKernelBSplineOrder( movingKernelBSplineOrder );
 
+  /** Set how the joint histograms of the threads are combined. */
+  std::string jointHistogramReduction = "Serial";
+  this->GetConfiguration()->ReadParameter( jointHistogramReduction,
+    "JointHistogramReduction", this->GetComponentLabel(), level, 0 );
+  this->SetJointHistogramReductionByName( jointHistogramReduction );
+
 } // end BeforeEachResolution()
 
 
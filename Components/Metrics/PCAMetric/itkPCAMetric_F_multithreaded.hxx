@@ -963,17 +963,10 @@ void
 PCAMetric< TFixedImage, TMovingImage >
 ::LaunchGetSamplesThreaderCallback( void ) const
 {
-  /** Setup local threader. */
-  // \todo: is a global threader better performance-wise? check
-  typename ThreaderType::Pointer local_threader = ThreaderType::New();
-  local_threader->SetNumberOfThreads( Self::GetNumberOfThreads() );
-  local_threader->SetSingleMethod( this->GetSamplesThreaderCallback,
+  this->LaunchThreaderCallback( this->GetSamplesThreaderCallback,
     const_cast< void * >( static_cast< const void * >(
       &this->m_PCAMetricThreaderParameters ) ) );
 
-  /** Launch. */
-  local_threader->SingleMethodExecute();
-
 } // end LaunchGetSamplesThreaderCallback()
 
 
@@ -1177,17 +1170,10 @@ void
 PCAMetric< TFixedImage, TMovingImage >
 ::LaunchComputeDerivativeThreaderCallback( void ) const
 {
-  /** Setup local threader. */
-  // \todo: is a global threader better performance-wise? check
-  typename ThreaderType::Pointer local_threader = ThreaderType::New();
-  local_threader->SetNumberOfThreads( Self::GetNumberOfThreads() );
-  local_threader->SetSingleMethod( this->ComputeDerivativeThreaderCallback,
+  this->LaunchThreaderCallback( this->ComputeDerivativeThreaderCallback,
     const_cast< void * >( static_cast< const void * >(
       &this->m_PCAMetricThreaderParameters ) ) );
 
-  /** Launch. */
-  local_threader->SingleMethodExecute();
-
 } // end LaunchComputeDerivativeThreaderCallback()
 
 
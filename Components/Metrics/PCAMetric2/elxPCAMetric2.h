@@ -54,6 +54,15 @@ namespace elastix
  *    image, without using a fixed image. Possible values are "true" or "false".
  * \parameter NumEigenValues: number of eigenvalues used in the metric: sum(e) - e, where sum(e)
  *  is the sum of all eigenvalues and e is the sum of the first highest NumEigenValues eigenvalues.
+ * \parameter UseWarmStartEigenSolver: compute the eigenvalues of the correlation matrix
+ *    starting from the eigenvectors of the previous iteration. This is faster when the
+ *    matrix changes little between iterations. Can be defined for each resolution.\n
+ *    example: <tt>(UseWarmStartEigenSolver "true")</tt> \n
+ *    The default is "false".
+ *
+ * With <tt>(UseMultiThreadingForMetrics "true")</tt>, the loops over the samples are
+ * distributed over the threads. The derivative then differs by rounding for
+ * different numbers of threads.
  *
  * \ingroup RegistrationMetrics
  * \ingroup Metrics
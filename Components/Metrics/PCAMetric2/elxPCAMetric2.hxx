@@ -75,6 +75,12 @@ PCAMetric2< TElastix >
     this->GetComponentLabel(), 0, 0 );
   this->SetReducedDimensionIndex( reducedDimensionIndex );
 
+  /** Get and set if the eigen decomposition starts from the previous eigenvectors. */
+  bool useWarmStartEigenSolver = false;
+  this->GetConfiguration()->ReadParameter( useWarmStartEigenSolver,
+    "UseWarmStartEigenSolver", this->GetComponentLabel(), level, 0 );
+  this->SetUseWarmStartEigenSolver( useWarmStartEigenSolver );
+
   /** Set moving image derivative scales. */
   this->SetUseMovingImageDerivativeScales( false );
   MovingImageDerivativeScalesType movingImageDerivativeScales;
@@ -19,6 +19,7 @@
 #define __itkPCAMetric2_H__
 
 #include "itkAdvancedImageToImageMetric.h"
+#include "itkWarmStartSymmetricEigenSystem.h"
 
 #include "itkSmoothingRecursiveGaussianImageFilter.h"
 #include "itkImageRandomCoordinateSampler.h"
@@ -56,6 +57,13 @@ public:
   itkSetMacro( GridSize, FixedImageSizeType );
   itkSetMacro( TransformIsStackTransform, bool );
 
+  /** Set/Get whether the eigen decomposition of the correlation matrix starts
+   * from the eigenvectors of the previous evaluation, see the
+   * WarmStartSymmetricEigenSystem. Default: false.
+   */
+  itkSetMacro( UseWarmStartEigenSolver, bool );
+  itkGetConstMacro( UseWarmStartEigenSolver, bool );
+
   /** Typedefs from the superclass. */
   typedef typename
     Superclass::CoordinateRepresentationType              CoordinateRepresentationType;
@@ -147,6 +155,12 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::DerivativeValueType                 DerivativeValueType;
+
+  /** Typedefs for the matrices of the metric. */
+  typedef vnl_matrix< RealType >                     MatrixType;
+  typedef vnl_matrix< DerivativeValueType >          DerivativeMatrixType;
+  typedef WarmStartSymmetricEigenSystem< RealType >  EigenSystemType;
 
   /** Computes the innerproduct of transform Jacobian with moving image gradient.
    * The results are stored in imageJacobian, which is supposed
@@ -165,6 +179,38 @@ private:
   /** Sample n random numbers from 0..m and add them to the vector. */
   void SampleRandom( const int n, const int m, std::vector< int > & numbers ) const;
 
+  /** Compute the matrix A of the moving image values of the samples that map
+   * inside the moving image at all G time points, one row per sample, and
+   * store those samples in samplesOK. With multi-threading every thread takes
+   * a fixed range of samples, so that the order of the rows does not depend
+   * on the number of threads.
+   */
+  void ComputeSampleMatrix( const ImageSampleContainerType * sampleContainer,
+    const unsigned int G, MatrixType & A,
+    std::vector< FixedImagePointType > & samplesOK ) const;
+
+  /** Store the moving image values of the samples [begin, end) that are
+   * valid at all time points in the rows of the datablock, starting at row
+   * begin. Returns the number of valid samples.
+   */
+  unsigned int ComputeSampleMatrixRows( const ImageSampleContainerType * sampleContainer,
+    const unsigned int begin, const unsigned int end, const unsigned int G,
+    MatrixType & datablock, std::vector< FixedImagePointType > & samplesOK ) const;
+
+  /** Add the derivative contributions of the valid samples [begin, end). */
+  void ComputeDerivativeOfSamples(
+    const std::vector< FixedImagePointType > & samplesOK,
+    const unsigned int begin, const unsigned int end, const unsigned int G,
+    const MatrixType & Atmm, const DerivativeMatrixType & vSAtmm,
+    const DerivativeMatrixType & CSv, const DerivativeMatrixType & Sv,
+    const DerivativeMatrixType & vdSdmu_part1, DerivativeType & derivative ) const;
+
+  /** Compute the eigenvalues, in ascending order, and the eigenvectors of the
+   * correlation matrix K, warm started if requested.
+   */
+  void ComputeEigenSystem( const MatrixType & K,
+    vnl_vector< RealType > & eigenValues, MatrixType & eigenVectors ) const;
+
   /** Variables to control random sampling in last dimension. */
   unsigned int m_NumAdditionalSamplesFixed;
   unsigned int m_ReducedDimensionIndex;
@@ -178,6 +224,10 @@ private:
   /** Bool to indicate if the transform used is a stacktransform. Set by elx files. */
   bool m_TransformIsStackTransform;
 
+  /** The warm started eigen decomposition, which keeps the eigenvectors of the previous evaluation. */
+  bool                    m_UseWarmStartEigenSolver;
+  mutable EigenSystemType m_EigenSystem;
+
 };
 
 } // end namespace itk
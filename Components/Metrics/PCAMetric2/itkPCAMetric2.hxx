@@ -26,6 +26,7 @@
 #include "vnl/algo/vnl_svd.h"
 #include "vnl/vnl_trace.h"
 #include "vnl/algo/vnl_symmetric_eigensystem.h"
+#include <algorithm>
 #include <numeric>
 #include <fstream>
 
@@ -39,7 +40,8 @@ template< class TFixedImage, class TMovingImage >
 PCAMetric2< TFixedImage, TMovingImage >
 ::PCAMetric2() :
   m_SubtractMean( false ),
-  m_TransformIsStackTransform( false )
+  m_TransformIsStackTransform( false ),
+  m_UseWarmStartEigenSolver( false )
 {
   this->SetUseImageSampler( true );
   this->SetUseFixedImageLimiter( false );
@@ -63,6 +65,9 @@ PCAMetric2< TFixedImage, TMovingImage >
   //const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
   //const unsigned int G = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
 
+  /** Do not start the eigen decomposition from the eigenvectors of a previous resolution. */
+  this->m_EigenSystem.Reset();
+
 } // end Initialize()
 
 
@@ -76,6 +81,7 @@ PCAMetric2< TFixedImage, TMovingImage >
 ::PrintSelf( std::ostream & os, Indent indent ) const
 {
   Superclass::PrintSelf( os, indent );
+  os << indent << "UseWarmStartEigenSolver: " << this->m_UseWarmStartEigenSolver << std::endl;
 } // end PrintSelf()
 
 
@@ -147,74 +153,90 @@ PCAMetric2< TFixedImage, TMovingImage >
 
 
 /**
- * ******************* GetValue *******************
+ * ******************* ComputeSampleMatrix *******************
  */
 
 template< class TFixedImage, class TMovingImage >
-typename PCAMetric2< TFixedImage, TMovingImage >::MeasureType
+void
 PCAMetric2< TFixedImage, TMovingImage >
-::GetValue( const TransformParametersType & parameters ) const
+::ComputeSampleMatrix( const ImageSampleContainerType * sampleContainer,
+  const unsigned int G, MatrixType & A,
+  std::vector< FixedImagePointType > & samplesOK ) const
 {
-  itkDebugMacro( "GetValue( " << parameters << " ) " );
-  bool UseGetValueAndDerivative = false;
-
-  if( UseGetValueAndDerivative )
+  const unsigned int numberOfSamples = sampleContainer->Size();
+  MatrixType         datablock( numberOfSamples, G );
+  datablock.fill( NumericTraits< RealType >::Zero );
+  samplesOK.clear();
+
+  const ThreadIdType numberOfThreads = this->m_UseMultiThread
+    ? static_cast< ThreadIdType >( std::min< SizeValueType >(
+    this->GetNumberOfThreads(), numberOfSamples ) ) : 1;
+  unsigned int numberOfRows = 0;
+  if( numberOfThreads > 1 )
   {
-    typedef typename DerivativeType::ValueType DerivativeValueType;
-    const unsigned int P               = this->GetNumberOfParameters();
-    MeasureType        dummymeasure    = NumericTraits< MeasureType >::Zero;
-    DerivativeType     dummyderivative = DerivativeType( P );
-    dummyderivative.Fill( NumericTraits< DerivativeValueType >::Zero );
+    /** Every thread fills the rows of its own range of samples. */
+    std::vector< unsigned int > begins( numberOfThreads + 1 );
+    for( ThreadIdType slot = 0; slot <= numberOfThreads; ++slot )
+    {
+      begins[ slot ] = static_cast< unsigned int >(
+        static_cast< SizeValueType >( numberOfSamples ) * slot / numberOfThreads );
+    }
+    std::vector< unsigned int >                        numberOfRowsPerThread( numberOfThreads );
+    std::vector< std::vector< FixedImagePointType > > samplesOKPerThread( numberOfThreads );
+    WorkStealingThreadPool::GetInstance()->ParallelForSlots( numberOfThreads,
+      [ & ]( ThreadIdType slot )
+      {
+        numberOfRowsPerThread[ slot ] = this->ComputeSampleMatrixRows( sampleContainer,
+          begins[ slot ], begins[ slot + 1 ], G, datablock, samplesOKPerThread[ slot ] );
+      } );
 
-    this->GetValueAndDerivative( parameters, dummymeasure, dummyderivative );
-    return dummymeasure;
+    /** Move the rows of the threads together, in the order of the threads. */
+    for( ThreadIdType slot = 0; slot < numberOfThreads; ++slot )
+    {
+      for( unsigned int i = 0; i < numberOfRowsPerThread[ slot ]; ++i, ++numberOfRows )
+      {
+        if( numberOfRows != begins[ slot ] + i )
+        {
+          datablock.set_row( numberOfRows, datablock.get_row( begins[ slot ] + i ) );
+        }
+      }
+      samplesOK.insert( samplesOK.end(),
+        samplesOKPerThread[ slot ].begin(), samplesOKPerThread[ slot ].end() );
+    }
   }
+  else
+  {
+    numberOfRows = this->ComputeSampleMatrixRows( sampleContainer,
+      0, numberOfSamples, G, datablock, samplesOK );
+  }
+  this->m_NumberOfPixelsCounted = numberOfRows;
 
-  /** Make sure the transform parameters are up to date. */
-  this->SetTransformParameters( parameters );
-
-  /** Initialize some variables */
-  this->m_NumberOfPixelsCounted = 0;
-  MeasureType measure = NumericTraits< MeasureType >::Zero;
-
-  /** Update the imageSampler and get a handle to the sample container. */
-  this->GetImageSampler()->Update();
-  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->End();
-
-  /** Retrieve slowest varying dimension and its size. */
-  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
-  const unsigned int G       = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
-
-  typedef vnl_matrix< RealType > MatrixType;
+  /** Check if enough samples were valid. */
+  this->CheckNumberOfSamples( numberOfSamples, this->m_NumberOfPixelsCounted );
 
-  /** The rows of the ImageSampleMatrix contain the samples of the images of the stack */
-  const unsigned int numberOfSamples = sampleContainer->Size();
-  MatrixType         datablock( numberOfSamples, G );
+  A = datablock.extract( numberOfRows, G );
 
-  /** Vector containing last dimension positions to use: initialize on all positions when random sampling turned off. */
-  std::vector< int > lastDimPositions;
+} // end ComputeSampleMatrix()
 
-  /** Determine random last dimension positions if needed. */
-  for( unsigned int i = 0; i < G; ++i )
-  {
-    lastDimPositions.push_back( i );
-  }
 
-  /** Initialize dummy loop variable */
-  unsigned int pixelIndex = 0;
+/**
+ * ******************* ComputeSampleMatrixRows *******************
+ */
 
-  /** Initialize image sample matrix . */
-  datablock.fill( itk::NumericTraits< RealType >::Zero );
+template< class TFixedImage, class TMovingImage >
+unsigned int
+PCAMetric2< TFixedImage, TMovingImage >
+::ComputeSampleMatrixRows( const ImageSampleContainerType * sampleContainer,
+  const unsigned int begin, const unsigned int end, const unsigned int G,
+  MatrixType & datablock, std::vector< FixedImagePointType > & samplesOK ) const
+{
+  const unsigned int lastDim    = this->GetFixedImage()->GetImageDimension() - 1;
+  unsigned int       pixelIndex = begin;
 
-  for( fiter = fbegin; fiter != fend; ++fiter )
+  for( unsigned int s = begin; s < end; ++s )
   {
     /** Read fixed coordinates. */
-    FixedImagePointType fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
+    FixedImagePointType fixedPoint = sampleContainer->ElementAt( s ).m_ImageCoordinates;
 
     /** Transform sampled point to voxel coordinates. */
     FixedImageContinuousIndexType voxelCoord;
@@ -230,7 +252,7 @@ PCAMetric2< TFixedImage, TMovingImage >
       MovingImagePointType mappedPoint;
 
       /** Set fixed point's last dimension to lastDimPosition. */
-      voxelCoord[ lastDim ] = lastDimPositions[ d ];
+      voxelCoord[ lastDim ] = d;
 
       /** Transform sampled point back to world coordinates. */
       this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint( voxelCoord, fixedPoint );
@@ -256,20 +278,167 @@ PCAMetric2< TFixedImage, TMovingImage >
         datablock( pixelIndex, d ) = movingImageValue;
       }
 
-    } /** end loop over t */
+    } // end loop over t
 
     if( numSamplesOk == G )
     {
+      samplesOK.push_back( fixedPoint );
       pixelIndex++;
-      this->m_NumberOfPixelsCounted++;
     }
+  }
 
-  } /** end first loop over image sample container */
+  return pixelIndex - begin;
 
-  /** Check if enough samples were valid. */
-  this->CheckNumberOfSamples( numberOfSamples, this->m_NumberOfPixelsCounted );
+} // end ComputeSampleMatrixRows()
+
+
+/**
+ * ******************* ComputeDerivativeOfSamples *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PCAMetric2< TFixedImage, TMovingImage >
+::ComputeDerivativeOfSamples(
+  const std::vector< FixedImagePointType > & samplesOK,
+  const unsigned int begin, const unsigned int end, const unsigned int G,
+  const MatrixType & Atmm, const DerivativeMatrixType & vSAtmm,
+  const DerivativeMatrixType & CSv, const DerivativeMatrixType & Sv,
+  const DerivativeMatrixType & vdSdmu_part1, DerivativeType & derivative ) const
+{
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+
+  /** Create variables to store intermediate results in. */
+  TransformJacobianType      jacobian;
+  DerivativeType             imageJacobian( this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() );
+  NonZeroJacobianIndicesType nzji;
+
+  for( unsigned int pixelIndex = begin; pixelIndex < end; ++pixelIndex )
+  {
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = samplesOK[ pixelIndex ];
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
+
+    for( unsigned int d = 0; d < G; ++d )
+    {
+      /** Initialize some variables. */
+      RealType                  movingImageValue;
+      MovingImagePointType      mappedPoint;
+      MovingImageDerivativeType movingImageDerivative;
+
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[ lastDim ] = d;
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint( voxelCoord, fixedPoint );
+      this->TransformPoint( fixedPoint, mappedPoint );
+
+      this->EvaluateMovingImageValueAndDerivative(
+        mappedPoint, movingImageValue, &movingImageDerivative );
+
+      /** Get the TransformJacobian dT/dmu */
+      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
+
+      /** Compute the innerproduct (dM/dx)^T (dT/dmu). */
+      this->EvaluateTransformJacobianInnerProduct(
+        jacobian, movingImageDerivative, imageJacobian );
+
+      /** The sum over the eigenvalues does not depend on the parameter,
+       * so it is computed once per sample and time point.
+       */
+      DerivativeValueType weight = NumericTraits< DerivativeValueType >::Zero;
+      for( unsigned int z = 0; z < G; z++ )
+      {
+        weight += z * ( vSAtmm[ z ][ pixelIndex ] * Sv[ d ][ z ]
+          + vdSdmu_part1[ z ][ d ] * Atmm[ d ][ pixelIndex ] * CSv[ d ][ z ] );
+      }
+
+      /** build metric derivative components */
+      for( unsigned int p = 0; p < nzji.size(); ++p )
+      {
+        derivative[ nzji[ p ] ] += weight * imageJacobian[ p ];
+      }
+
+    } // end loop over last dimension
+
+  } // end loop over samples
+
+} // end ComputeDerivativeOfSamples()
+
+
+/**
+ * ******************* ComputeEigenSystem *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PCAMetric2< TFixedImage, TMovingImage >
+::ComputeEigenSystem( const MatrixType & K,
+  vnl_vector< RealType > & eigenValues, MatrixType & eigenVectors ) const
+{
+  if( this->m_UseWarmStartEigenSolver )
+  {
+    this->m_EigenSystem.Compute( K );
+    eigenValues  = this->m_EigenSystem.GetEigenValues();
+    eigenVectors = this->m_EigenSystem.GetEigenVectors();
+  }
+  else
+  {
+    vnl_symmetric_eigensystem< RealType > eig( K );
+    eigenValues  = eig.D.diagonal();
+    eigenVectors = eig.V;
+  }
+
+} // end ComputeEigenSystem()
+
+
+/**
+ * ******************* GetValue *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename PCAMetric2< TFixedImage, TMovingImage >::MeasureType
+PCAMetric2< TFixedImage, TMovingImage >
+::GetValue( const TransformParametersType & parameters ) const
+{
+  itkDebugMacro( "GetValue( " << parameters << " ) " );
+  bool UseGetValueAndDerivative = false;
+
+  if( UseGetValueAndDerivative )
+  {
+    typedef typename DerivativeType::ValueType DerivativeValueType;
+    const unsigned int P               = this->GetNumberOfParameters();
+    MeasureType        dummymeasure    = NumericTraits< MeasureType >::Zero;
+    DerivativeType     dummyderivative = DerivativeType( P );
+    dummyderivative.Fill( NumericTraits< DerivativeValueType >::Zero );
+
+    this->GetValueAndDerivative( parameters, dummymeasure, dummyderivative );
+    return dummymeasure;
+  }
+
+  /** Make sure the transform parameters are up to date. */
+  this->SetTransformParameters( parameters );
+
+  /** Initialize some variables */
+  this->m_NumberOfPixelsCounted = 0;
+  MeasureType measure = NumericTraits< MeasureType >::Zero;
+
+  /** Update the imageSampler and get a handle to the sample container. */
+  this->GetImageSampler()->Update();
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+
+  /** Retrieve slowest varying dimension and its size. */
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int G       = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
+
+  /** The rows of the sample matrix A contain the samples of the images of the stack. */
+  MatrixType                         A;
+  std::vector< FixedImagePointType > samplesOK;
+  this->ComputeSampleMatrix( sampleContainer, G, A, samplesOK );
   const unsigned int N = this->m_NumberOfPixelsCounted;
-  MatrixType         A( datablock.extract( N, G ) );
 
   /** Calculate mean of from columns */
   vnl_vector< RealType > mean( G );
@@ -308,8 +477,10 @@ PCAMetric2< TFixedImage, TMovingImage >
   /** Compute correlation matrix K */
   MatrixType K( S * C * S );
 
-  /** Compute first eigenvalue and eigenvector of K */
-  vnl_symmetric_eigensystem< RealType > eig( K );
+  /** Compute the eigenvalues and eigenvectors of K */
+  vnl_vector< RealType > eigenValues;
+  MatrixType             eigenVectors;
+  this->ComputeEigenSystem( K, eigenValues, eigenVectors );
 
   // The measure is the sum of weighted eigenvalues of the correlation matrix.
   // measure = sum_{i=1}^G i*lambda_i
@@ -327,7 +498,7 @@ PCAMetric2< TFixedImage, TMovingImage >
   RealType sumWeightedEigenValues = itk::NumericTraits< RealType >::Zero;
   for( unsigned int i = 0; i < G; i++ )
   {
-    sumWeightedEigenValues += ( i + 1 ) * eig.get_eigenvalue( G - i - 1 );
+    sumWeightedEigenValues += ( i + 1 ) * eigenValues[ G - i - 1 ];
   }
 
   measure = sumWeightedEigenValues;
@@ -370,10 +541,6 @@ PCAMetric2< TFixedImage, TMovingImage >
   MeasureType & value, DerivativeType & derivative ) const
 {
   itkDebugMacro( "GetValueAndDerivative( " << parameters << " ) " );
-  /** Define derivative and Jacobian types. */
-  typedef typename DerivativeType::ValueType DerivativeValueType;
-  //typedef typename TransformJacobianType::ValueType TransformJacobianValueType;
-
   /** Initialize some variables */
   const unsigned int P = this->GetNumberOfParameters();
   this->m_NumberOfPixelsCounted = 0;
@@ -388,100 +555,15 @@ PCAMetric2< TFixedImage, TMovingImage >
   this->GetImageSampler()->Update();
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->End();
-
   /** Retrieve slowest varying dimension and its size. */
   const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
   const unsigned int G       = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
 
-  typedef vnl_matrix< RealType >            MatrixType;
-  typedef vnl_matrix< DerivativeValueType > DerivativeMatrixType;
-
-  std::vector< FixedImagePointType > SamplesOK;
-
-  /** The rows of the ImageSampleMatrix contain the samples of the images of the stack */
-  const unsigned int numberOfSamples = sampleContainer->Size();
-  MatrixType         datablock( numberOfSamples, G );
-
-  /** Initialize dummy loop variables */
-  unsigned int pixelIndex = 0;
-
-  /** Initialize image sample matrix . */
-  datablock.fill( itk::NumericTraits< RealType >::Zero );
-
-  /** Determine random last dimension positions if needed. */
-  /** Vector containing last dimension positions to use: initialize on all positions when random sampling turned off. */
-  /** Vector containing last dimension positions to use: initialize on all positions when random sampling turned off. */
-  std::vector< int > lastDimPositions;
-
-  for( unsigned int i = 0; i < G; ++i )
-  {
-    lastDimPositions.push_back( i );
-  }
-
-  for( fiter = fbegin; fiter != fend; ++fiter )
-  {
-    /** Read fixed coordinates. */
-    FixedImagePointType fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
-
-    /** Transform sampled point to voxel coordinates. */
-    FixedImageContinuousIndexType voxelCoord;
-    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
-
-    unsigned int numSamplesOk = 0;
-
-    /** Loop over t */
-    for( unsigned int d = 0; d < G; ++d )
-    {
-      /** Initialize some variables. */
-      RealType             movingImageValue;
-      MovingImagePointType mappedPoint;
-
-      /** Set fixed point's last dimension to lastDimPosition. */
-      voxelCoord[ lastDim ] = lastDimPositions[ d ];
-
-      /** Transform sampled point back to world coordinates. */
-      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint( voxelCoord, fixedPoint );
-
-      /** Transform point and check if it is inside the B-spline support region. */
-      bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
-
-      /** Check if point is inside mask. */
-      if( sampleOk )
-      {
-        sampleOk = this->IsInsideMovingMask( mappedPoint );
-      }
-
-      if( sampleOk )
-
-      {
-        sampleOk = this->EvaluateMovingImageValueAndDerivative(
-          mappedPoint, movingImageValue, 0 );
-      }
-
-      if( sampleOk )
-      {
-        numSamplesOk++;
-        datablock( pixelIndex, d ) = movingImageValue;
-      } // end if sampleOk
-
-    } // end loop over gradient images
-    if( numSamplesOk == G )
-    {
-      SamplesOK.push_back( fixedPoint );
-      pixelIndex++;
-      this->m_NumberOfPixelsCounted++;
-    }
-  }
-
-  /** Check if enough samples were valid. */
-  this->CheckNumberOfSamples( sampleContainer->Size(), this->m_NumberOfPixelsCounted );
-  unsigned int N = this->m_NumberOfPixelsCounted;
-
-  MatrixType A( datablock.extract( N, G ) );
+  /** The rows of the sample matrix A contain the samples of the images of the stack. */
+  MatrixType                         A;
+  std::vector< FixedImagePointType > samplesOK;
+  this->ComputeSampleMatrix( sampleContainer, G, A, samplesOK );
+  const unsigned int N = this->m_NumberOfPixelsCounted;
 
   /** Calculate mean of columns */
   vnl_vector< RealType > mean( G );
@@ -521,35 +603,28 @@ PCAMetric2< TFixedImage, TMovingImage >
   /** Compute correlation matrix K */
   MatrixType K( S * C * S );
 
-  /** Compute first eigenvalue and eigenvector of K */
-  vnl_symmetric_eigensystem< RealType > eig( K );
+  /** Compute the eigenvalues and eigenvectors of K */
+  vnl_vector< RealType > eigenValues;
+  MatrixType             eigenVectors;
+  this->ComputeEigenSystem( K, eigenValues, eigenVectors );
 
   RealType sumWeightedEigenValues = itk::NumericTraits< RealType >::Zero;
   for( unsigned int i = 0; i < G; i++ )
   {
-    sumWeightedEigenValues += ( i + 1 ) * eig.get_eigenvalue( G - i - 1 );
+    sumWeightedEigenValues += ( i + 1 ) * eigenValues[ G - i - 1 ];
   }
 
   MatrixType eigenVectorMatrix( G, G );
   for( unsigned int i = 0; i < G; i++ )
   {
-    eigenVectorMatrix.set_column( i, ( eig.get_eigenvector( G - i - 1 ) ).normalize() );
+    eigenVectorMatrix.set_column( i, eigenVectors.get_column( G - i - 1 ).normalize() );
   }
 
   MatrixType eigenVectorMatrixTranspose( eigenVectorMatrix.transpose() );
 
-  /** Create variables to store intermediate results in. */
-  TransformJacobianType                     jacobian;
-  DerivativeType                            dMTdmu;
-  DerivativeType                            imageJacobian( this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() );
-  std::vector< NonZeroJacobianIndicesType > nzjis( G, NonZeroJacobianIndicesType() );
-
   /** Sub components of metric derivative */
   vnl_diag_matrix< DerivativeValueType > dSdmu_part1( G );
 
-  unsigned int startSamplesOK;
-  startSamplesOK = 0;
-
   for( unsigned int d = 0; d < G; d++ )
   {
     double S_sqr = S( d, d ) * S( d, d );
@@ -562,60 +637,38 @@ PCAMetric2< TFixedImage, TMovingImage >
   DerivativeMatrixType Sv( S * eigenVectorMatrix );
   DerivativeMatrixType vdSdmu_part1( eigenVectorMatrixTranspose * dSdmu_part1 );
 
-  /** Second loop over fixed image samples. */
-  for( pixelIndex = 0; pixelIndex < SamplesOK.size(); ++pixelIndex )
+  /** Second loop over the valid samples. With multiple threads, every thread
+   * adds the contributions of a fixed range of samples to its own derivative,
+   * and these are summed in the order of the threads. The ranges depend on
+   * the number of threads, and so does the rounding of the derivative.
+   */
+  const SizeValueType numberOfSamplesOK = samplesOK.size();
+  const ThreadIdType  numberOfThreads   = this->m_UseMultiThread
+    ? static_cast< ThreadIdType >( std::min< SizeValueType >(
+    this->GetNumberOfThreads(), numberOfSamplesOK ) ) : 1;
+  if( numberOfThreads > 1 )
   {
-    /** Read fixed coordinates. */
-    FixedImagePointType fixedPoint = SamplesOK[ startSamplesOK ];
-    startSamplesOK++;
-
-    /** Transform sampled point to voxel coordinates. */
-    FixedImageContinuousIndexType voxelCoord;
-    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
-
-    const unsigned int G = lastDimPositions.size();
-
-    for( unsigned int d = 0; d < G; ++d )
-    {
-      /** Initialize some variables. */
-      RealType                  movingImageValue;
-      MovingImagePointType      mappedPoint;
-      MovingImageDerivativeType movingImageDerivative;
-
-      /** Set fixed point's last dimension to lastDimPosition. */
-      voxelCoord[ lastDim ] = lastDimPositions[ d ];
-
-      /** Transform sampled point back to world coordinates. */
-      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint( voxelCoord, fixedPoint );
-      this->TransformPoint( fixedPoint, mappedPoint );
-
-      this->EvaluateMovingImageValueAndDerivative(
-        mappedPoint, movingImageValue, &movingImageDerivative );
-
-      /** Get the TransformJacobian dT/dmu */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzjis[ d ] );
-
-      /** Compute the innerproduct (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-
-      /** Store values. */
-      dMTdmu = imageJacobian;
-
-      /** build metric derivative components */
-      for( unsigned int p = 0; p < nzjis[ d ].size(); ++p )
+    std::vector< DerivativeType > derivatives( numberOfThreads );
+    WorkStealingThreadPool::GetInstance()->ParallelForSlots( numberOfThreads,
+      [ & ]( ThreadIdType slot )
       {
-        for( unsigned int z = 0; z < G; z++ )
-        {
-          derivative[ nzjis[ d ][ p ] ] += z * ( vSAtmm[ z ][ pixelIndex ] * dMTdmu[ p ] * Sv[ d ][ z ]
-            + vdSdmu_part1[ z ][ d ] * Atmm[ d ][ pixelIndex ] * dMTdmu[ p ] * CSv[ d ][ z ] );
-        } //end loop over eigenvalues
-
-      } //end loop over non-zero jacobian indices
-
-    } //end loop over last dimension
-
-  } // end second for loop over sample container
+        derivatives[ slot ].SetSize( P );
+        derivatives[ slot ].Fill( NumericTraits< DerivativeValueType >::Zero );
+        this->ComputeDerivativeOfSamples( samplesOK,
+          numberOfSamplesOK * slot / numberOfThreads,
+          numberOfSamplesOK * ( slot + 1 ) / numberOfThreads,
+          G, Atmm, vSAtmm, CSv, Sv, vdSdmu_part1, derivatives[ slot ] );
+      } );
+    for( ThreadIdType slot = 0; slot < numberOfThreads; ++slot )
+    {
+      derivative += derivatives[ slot ];
+    }
+  }
+  else
+  {
+    this->ComputeDerivativeOfSamples( samplesOK, 0, numberOfSamplesOK,
+      G, Atmm, vSAtmm, CSv, Sv, vdSdmu_part1, derivative );
+  }
 
   derivative *= ( 2.0 / ( DerivativeValueType( N ) - 1.0 ) ); //normalize
   measure     = sumWeightedEigenValues;
@@ -55,6 +55,10 @@ namespace elastix
  *    each parameter. This should be used when registration is performed directly on the moving
  *    image, without using a fixed image. Possible values are "true" or "false".
  *
+ * The loops over the samples use multiple threads when
+ * <tt>(UseMultiThreadingForMetrics "true")</tt>. The derivative then differs
+ * by rounding for different numbers of threads.
+ *
  * \ingroup RegistrationMetrics
  * \ingroup Metrics
  */
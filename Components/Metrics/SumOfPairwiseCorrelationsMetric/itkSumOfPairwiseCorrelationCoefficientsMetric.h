@@ -149,6 +149,11 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::DerivativeValueType                 DerivativeValueType;
+
+  /** Typedefs for the matrices of the metric. */
+  typedef vnl_matrix< RealType >            MatrixType;
+  typedef vnl_matrix< DerivativeValueType > DerivativeMatrixType;
 
   /** Computes the innerproduct of transform Jacobian with moving image gradient.
    * The results are stored in imageJacobian, which is supposed
@@ -166,6 +171,32 @@ private:
   /** Sample n random numbers from 0..m and add them to the vector. */
   void SampleRandom( const int n, const int m, std::vector< int > & numbers ) const;
 
+  /** Compute the matrix A of the moving image values of the samples that map
+   * inside the moving image at all G time points, one row per sample, and
+   * store those samples in samplesOK. The rows are in the order of the
+   * samples, also when multiple threads compute them.
+   */
+  void ComputeSampleMatrix( const ImageSampleContainerType * sampleContainer,
+    const unsigned int G, MatrixType & A,
+    std::vector< FixedImagePointType > & samplesOK ) const;
+
+  /** Store the moving image values of the samples [begin, end) that are
+   * valid at all time points in the rows of the datablock, starting at row
+   * begin. Returns the number of valid samples.
+   */
+  unsigned int ComputeSampleMatrixRows( const ImageSampleContainerType * sampleContainer,
+    const unsigned int begin, const unsigned int end, const unsigned int G,
+    MatrixType & datablock, std::vector< FixedImagePointType > & samplesOK ) const;
+
+  /** Add the derivative contributions of the valid samples [begin, end). */
+  void ComputeDerivativeOfSamples(
+    const std::vector< FixedImagePointType > & samplesOK,
+    const unsigned int begin, const unsigned int end, const unsigned int G,
+    const MatrixType & Atmm, const vnl_diag_matrix< RealType > & S,
+    const vnl_diag_matrix< DerivativeValueType > & dSdmu_part1,
+    const DerivativeMatrixType & KAtZscore, const DerivativeMatrixType & KAtZscoreAmm,
+    DerivativeType & derivative ) const;
+
   /** Variables to control random sampling in last dimension. */
   unsigned int m_NumAdditionalSamplesFixed;
   unsigned int m_ReducedDimensionIndex;
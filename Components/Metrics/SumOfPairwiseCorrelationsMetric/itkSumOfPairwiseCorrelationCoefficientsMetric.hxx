@@ -23,6 +23,7 @@
 #include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "vnl/algo/vnl_matrix_update.h"
 #include "itkImage.h"
+#include <algorithm>
 #include <numeric>
 
 namespace itk
@@ -139,52 +140,90 @@ SumOfPairwiseCorrelationCoefficientsMetric< TFixedImage, TMovingImage >
 
 
 /**
- * ******************* GetValue *******************
+ * ******************* ComputeSampleMatrix *******************
  */
 
 template< class TFixedImage, class TMovingImage >
-typename SumOfPairwiseCorrelationCoefficientsMetric< TFixedImage, TMovingImage >::MeasureType
+void
 SumOfPairwiseCorrelationCoefficientsMetric< TFixedImage, TMovingImage >
-::GetValue( const TransformParametersType & parameters ) const
+::ComputeSampleMatrix( const ImageSampleContainerType * sampleContainer,
+  const unsigned int G, MatrixType & A,
+  std::vector< FixedImagePointType > & samplesOK ) const
 {
-  itkDebugMacro( "GetValue( " << parameters << " ) " );
+  const unsigned int numberOfSamples = sampleContainer->Size();
+  MatrixType         datablock( numberOfSamples, G );
+  datablock.fill( NumericTraits< RealType >::Zero );
+  samplesOK.clear();
+
+  const ThreadIdType numberOfThreads = this->m_UseMultiThread
+    ? static_cast< ThreadIdType >( std::min< SizeValueType >(
+    this->GetNumberOfThreads(), numberOfSamples ) ) : 1;
+  unsigned int numberOfRows = 0;
+  if( numberOfThreads > 1 )
+  {
+    /** Every thread fills the rows of its own range of samples. */
+    std::vector< unsigned int > begins( numberOfThreads + 1 );
+    for( ThreadIdType slot = 0; slot <= numberOfThreads; ++slot )
+    {
+      begins[ slot ] = static_cast< unsigned int >(
+        static_cast< SizeValueType >( numberOfSamples ) * slot / numberOfThreads );
+    }
+    std::vector< unsigned int >                        numberOfRowsPerThread( numberOfThreads );
+    std::vector< std::vector< FixedImagePointType > > samplesOKPerThread( numberOfThreads );
+    WorkStealingThreadPool::GetInstance()->ParallelForSlots( numberOfThreads,
+      [ & ]( ThreadIdType slot )
+      {
+        numberOfRowsPerThread[ slot ] = this->ComputeSampleMatrixRows( sampleContainer,
+          begins[ slot ], begins[ slot + 1 ], G, datablock, samplesOKPerThread[ slot ] );
+      } );
 
-  /** Make sure the transform parameters are up to date. */
-  this->SetTransformParameters( parameters );
+    /** Move the rows of the threads together, in the order of the threads. */
+    for( ThreadIdType slot = 0; slot < numberOfThreads; ++slot )
+    {
+      for( unsigned int i = 0; i < numberOfRowsPerThread[ slot ]; ++i, ++numberOfRows )
+      {
+        if( numberOfRows != begins[ slot ] + i )
+        {
+          datablock.set_row( numberOfRows, datablock.get_row( begins[ slot ] + i ) );
+        }
+      }
+      samplesOK.insert( samplesOK.end(),
+        samplesOKPerThread[ slot ].begin(), samplesOKPerThread[ slot ].end() );
+    }
+  }
+  else
+  {
+    numberOfRows = this->ComputeSampleMatrixRows( sampleContainer,
+      0, numberOfSamples, G, datablock, samplesOK );
+  }
+  this->m_NumberOfPixelsCounted = numberOfRows;
 
-  /** Initialize some variables */
-  this->m_NumberOfPixelsCounted = 0;
-  MeasureType measure = NumericTraits< MeasureType >::Zero;
+  /** Check if enough samples were valid. */
+  this->CheckNumberOfSamples( numberOfSamples, this->m_NumberOfPixelsCounted );
 
-  /** Update the imageSampler and get a handle to the sample container. */
-  this->GetImageSampler()->Update();
-  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  A = datablock.extract( numberOfRows, G );
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->End();
+} // end ComputeSampleMatrix()
 
-  /** Retrieve slowest varying dimension and its size. */
-  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
-  const unsigned int G       = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
-
-  typedef vnl_matrix< RealType > MatrixType;
 
-  /** The rows of the ImageSampleMatrix contain the samples of the images of the stack */
-  unsigned int NumberOfSamples = sampleContainer->Size();
-  MatrixType   datablock( NumberOfSamples, G );
-
-  /** Initialize dummy loop variable */
-  unsigned int pixelIndex = 0;
+/**
+ * ******************* ComputeSampleMatrixRows *******************
+ */
 
-  /** Initialize image sample matrix . */
-  datablock.fill( itk::NumericTraits< RealType >::Zero );
+template< class TFixedImage, class TMovingImage >
+unsigned int
+SumOfPairwiseCorrelationCoefficientsMetric< TFixedImage, TMovingImage >
+::ComputeSampleMatrixRows( const ImageSampleContainerType * sampleContainer,
+  const unsigned int begin, const unsigned int end, const unsigned int G,
+  MatrixType & datablock, std::vector< FixedImagePointType > & samplesOK ) const
+{
+  const unsigned int lastDim    = this->GetFixedImage()->GetImageDimension() - 1;
+  unsigned int       pixelIndex = begin;
 
-  for( fiter = fbegin; fiter != fend; ++fiter )
+  for( unsigned int s = begin; s < end; ++s )
   {
     /** Read fixed coordinates. */
-    FixedImagePointType fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
+    FixedImagePointType fixedPoint = sampleContainer->ElementAt( s ).m_ImageCoordinates;
 
     /** Transform sampled point to voxel coordinates. */
     FixedImageContinuousIndexType voxelCoord;
@@ -226,22 +265,125 @@ SumOfPairwiseCorrelationCoefficientsMetric< TFixedImage, TMovingImage >
         datablock( pixelIndex, d ) = movingImageValue;
       }
 
-    } /** end loop over t */
+    } // end loop over t
 
     if( numSamplesOk == G )
     {
+      samplesOK.push_back( fixedPoint );
       pixelIndex++;
-      this->m_NumberOfPixelsCounted++;
     }
+  }
 
-  } /** end first loop over image sample container */
+  return pixelIndex - begin;
 
-  /** Check if enough samples were valid. */
-  this->CheckNumberOfSamples(
-    NumberOfSamples, this->m_NumberOfPixelsCounted );
-  unsigned int N = this->m_NumberOfPixelsCounted;
+} // end ComputeSampleMatrixRows()
+
+
+/**
+ * ******************* ComputeDerivativeOfSamples *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+SumOfPairwiseCorrelationCoefficientsMetric< TFixedImage, TMovingImage >
+::ComputeDerivativeOfSamples(
+  const std::vector< FixedImagePointType > & samplesOK,
+  const unsigned int begin, const unsigned int end, const unsigned int G,
+  const MatrixType & Atmm, const vnl_diag_matrix< RealType > & S,
+  const vnl_diag_matrix< DerivativeValueType > & dSdmu_part1,
+  const DerivativeMatrixType & KAtZscore, const DerivativeMatrixType & KAtZscoreAmm,
+  DerivativeType & derivative ) const
+{
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
 
-  MatrixType A( datablock.extract( N, G ) );
+  /** Create variables to store intermediate results in. */
+  TransformJacobianType      jacobian;
+  DerivativeType             imageJacobian( this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() );
+  NonZeroJacobianIndicesType nzji;
+
+  for( unsigned int pixelIndex = begin; pixelIndex < end; ++pixelIndex )
+  {
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = samplesOK[ pixelIndex ];
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
+
+    for( unsigned int d = 0; d < G; ++d )
+    {
+      /** Initialize some variables. */
+      RealType                  movingImageValue;
+      MovingImagePointType      mappedPoint;
+      MovingImageDerivativeType movingImageDerivative;
+
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[ lastDim ] = d;
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint( voxelCoord, fixedPoint );
+      this->TransformPoint( fixedPoint, mappedPoint );
+
+      this->EvaluateMovingImageValueAndDerivative(
+        mappedPoint, movingImageValue, &movingImageDerivative );
+
+      /** Get the TransformJacobian dT/dmu */
+      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
+
+      /** Compute the innerproduct (dM/dx)^T (dT/dmu). */
+      this->EvaluateTransformJacobianInnerProduct(
+        jacobian, movingImageDerivative, imageJacobian );
+
+      /** Both terms of the derivative scale dM/dmu by a factor that only
+       * depends on the sample and the time point.
+       */
+      const DerivativeValueType weight = KAtZscore[ d ][ pixelIndex ] * S( d, d )
+        + dSdmu_part1( d, d ) * Atmm[ d ][ pixelIndex ] * KAtZscoreAmm[ d ][ d ];
+
+      /** build metric derivative components */
+      for( unsigned int p = 0; p < nzji.size(); ++p )
+      {
+        derivative[ nzji[ p ] ] += weight * imageJacobian[ p ];
+      }
+
+    } // end loop over t
+
+  } // end loop over samples
+
+} // end ComputeDerivativeOfSamples()
+
+
+/**
+ * ******************* GetValue *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename SumOfPairwiseCorrelationCoefficientsMetric< TFixedImage, TMovingImage >::MeasureType
+SumOfPairwiseCorrelationCoefficientsMetric< TFixedImage, TMovingImage >
+::GetValue( const TransformParametersType & parameters ) const
+{
+  itkDebugMacro( "GetValue( " << parameters << " ) " );
+
+  /** Make sure the transform parameters are up to date. */
+  this->SetTransformParameters( parameters );
+
+  /** Initialize some variables */
+  this->m_NumberOfPixelsCounted = 0;
+  MeasureType measure = NumericTraits< MeasureType >::Zero;
+
+  /** Update the imageSampler and get a handle to the sample container. */
+  this->GetImageSampler()->Update();
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+
+  /** Retrieve slowest varying dimension and its size. */
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int G       = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
+
+  /** The rows of the sample matrix A contain the samples of the images of the stack. */
+  MatrixType                         A;
+  std::vector< FixedImagePointType > samplesOK;
+  this->ComputeSampleMatrix( sampleContainer, G, A, samplesOK );
+  unsigned int N = this->m_NumberOfPixelsCounted;
 
   /** Calculate mean of from columns */
   vnl_vector< RealType > mean( G );
@@ -321,10 +463,6 @@ SumOfPairwiseCorrelationCoefficientsMetric< TFixedImage, TMovingImage >
 {
   itkDebugMacro( "GetValueAndDerivative( " << parameters << " ) " );
 
-  /** Define derivative and Jacobian types. */
-  typedef typename DerivativeType::ValueType DerivativeValueType;
-  //typedef typename TransformJacobianType::ValueType TransformJacobianValueType;
-
   /** Initialize some variables */
   const unsigned int P = this->GetNumberOfParameters();
   this->m_NumberOfPixelsCounted = 0;
@@ -339,93 +477,16 @@ SumOfPairwiseCorrelationCoefficientsMetric< TFixedImage, TMovingImage >
   this->GetImageSampler()->Update();
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->End();
-
   /** Retrieve slowest varying dimension and its size. */
   const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
   const unsigned int G       = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
 
-  typedef vnl_matrix< RealType >            MatrixType;
-  typedef vnl_matrix< DerivativeValueType > DerivativeMatrixType;
-
-  std::vector< FixedImagePointType > SamplesOK;
-
-  /** The rows of the ImageSampleMatrix contain the samples of the images of the stack */
-  unsigned int NumberOfSamples = sampleContainer->Size();
-  MatrixType   datablock( NumberOfSamples, G );
-
-  /** Initialize dummy loop variables */
-  unsigned int pixelIndex = 0;
-
-  /** Initialize image sample matrix . */
-  datablock.fill( itk::NumericTraits< double >::Zero );
-
-  for( fiter = fbegin; fiter != fend; ++fiter )
-  {
-    /** Read fixed coordinates. */
-    FixedImagePointType fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
-
-    /** Transform sampled point to voxel coordinates. */
-    FixedImageContinuousIndexType voxelCoord;
-    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
-
-    unsigned int numSamplesOk = 0;
-
-    /** Loop over t */
-    for( unsigned int d = 0; d < G; ++d )
-    {
-      /** Initialize some variables. */
-      RealType             movingImageValue;
-      MovingImagePointType mappedPoint;
-
-      /** Set fixed point's last dimension to lastDimPosition. */
-      voxelCoord[ lastDim ] = d;
-
-      /** Transform sampled point back to world coordinates. */
-      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint( voxelCoord, fixedPoint );
-
-      /** Transform point and check if it is inside the B-spline support region. */
-      bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
-
-      /** Check if point is inside mask. */
-      if( sampleOk )
-      {
-        sampleOk = this->IsInsideMovingMask( mappedPoint );
-      }
-
-      if( sampleOk )
-      {
-        sampleOk = this->EvaluateMovingImageValueAndDerivative(
-          mappedPoint, movingImageValue, 0 );
-      }
-
-      if( sampleOk )
-      {
-        numSamplesOk++;
-        datablock( pixelIndex, d ) = movingImageValue;
-
-      } // end if sampleOk
-
-    } // end loop over t
-
-    if( numSamplesOk == G )
-    {
-      SamplesOK.push_back( fixedPoint );
-      pixelIndex++;
-      this->m_NumberOfPixelsCounted++;
-    }
-
-  } /** end first loop over image sample container */
-
-  /** Check if enough samples were valid. */
-  this->CheckNumberOfSamples( sampleContainer->Size(), this->m_NumberOfPixelsCounted );
+  /** The rows of the sample matrix A contain the samples of the images of the stack. */
+  MatrixType                         A;
+  std::vector< FixedImagePointType > samplesOK;
+  this->ComputeSampleMatrix( sampleContainer, G, A, samplesOK );
   unsigned int N = this->m_NumberOfPixelsCounted;
 
-  MatrixType A( datablock.extract( N, G ) );
-
   /** Calculate mean of from columns */
   vnl_vector< RealType > mean( G );
   mean.fill( NumericTraits< RealType >::Zero );
@@ -462,13 +523,6 @@ SumOfPairwiseCorrelationCoefficientsMetric< TFixedImage, TMovingImage >
 
   DerivativeMatrixType K( S * C * S );
 
-  /** Create variables to store intermediate results in. */
-  TransformJacobianType                     jacobian;
-  DerivativeType                            imageJacobian( this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() );
-  std::vector< NonZeroJacobianIndicesType > nzjis( G, NonZeroJacobianIndicesType() );
-
-  DerivativeType dMTdmu;
-
   /** Sub components of metric derivative */
   vnl_diag_matrix< DerivativeValueType > dSdmu_part1( G );
 
@@ -486,53 +540,38 @@ SumOfPairwiseCorrelationCoefficientsMetric< TFixedImage, TMovingImage >
   DerivativeMatrixType KAtZscore( K * ( Amm * S ).transpose() );
   DerivativeMatrixType KAtZscoreAmm( K * ( Amm * S ).transpose() * Amm );
 
-  /** Second loop over fixed image samples. */
-  for( pixelIndex = 0; pixelIndex < SamplesOK.size(); ++pixelIndex )
+  /** Second loop over the valid samples. With multiple threads, every thread
+   * adds the contributions of a fixed range of samples to its own derivative,
+   * and these are summed in the order of the threads. The ranges depend on
+   * the number of threads, and so does the rounding of the derivative.
+   */
+  const SizeValueType numberOfSamplesOK = samplesOK.size();
+  const ThreadIdType  numberOfThreads   = this->m_UseMultiThread
+    ? static_cast< ThreadIdType >( std::min< SizeValueType >(
+    this->GetNumberOfThreads(), numberOfSamplesOK ) ) : 1;
+  if( numberOfThreads > 1 )
   {
-    /** Read fixed coordinates. */
-    FixedImagePointType fixedPoint = SamplesOK[ pixelIndex ];
-
-    /** Transform sampled point to voxel coordinates. */
-    FixedImageContinuousIndexType voxelCoord;
-    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
-
-    for( unsigned int d = 0; d < G; ++d )
-    {
-      /** Initialize some variables. */
-      RealType                  movingImageValue;
-      MovingImagePointType      mappedPoint;
-      MovingImageDerivativeType movingImageDerivative;
-
-      /** Set fixed point's last dimension to lastDimPosition. */
-      voxelCoord[ lastDim ] = d;
-
-      /** Transform sampled point back to world coordinates. */
-      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint( voxelCoord, fixedPoint );
-      this->TransformPoint( fixedPoint, mappedPoint );
-
-      this->EvaluateMovingImageValueAndDerivative(
-        mappedPoint, movingImageValue, &movingImageDerivative );
-
-      /** Get the TransformJacobian dT/dmu */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzjis[ d ] );
-
-      /** Compute the innerproduct (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-
-      /** Store values. */
-      dMTdmu = imageJacobian;
-
-      /** build metric derivative components */
-      for( unsigned int p = 0; p < nzjis[ d ].size(); ++p )
+    std::vector< DerivativeType > derivatives( numberOfThreads );
+    WorkStealingThreadPool::GetInstance()->ParallelForSlots( numberOfThreads,
+      [ & ]( ThreadIdType slot )
       {
-        derivative[ nzjis[ d ][ p ] ] += KAtZscore[ d ][ pixelIndex ] * dMTdmu[ p ] * S( d, d );
-        derivative[ nzjis[ d ][ p ] ] += dSdmu_part1( d, d ) * Atmm[ d ][ pixelIndex ] * dMTdmu[ p ] * KAtZscoreAmm[ d ][ d ];
-      } //end loop over non-zero jacobian indices
-
-    } // end loop over t
-
-  } // end second for loop over sample container
+        derivatives[ slot ].SetSize( P );
+        derivatives[ slot ].Fill( NumericTraits< DerivativeValueType >::Zero );
+        this->ComputeDerivativeOfSamples( samplesOK,
+          numberOfSamplesOK * slot / numberOfThreads,
+          numberOfSamplesOK * ( slot + 1 ) / numberOfThreads,
+          G, Atmm, S, dSdmu_part1, KAtZscore, KAtZscoreAmm, derivatives[ slot ] );
+      } );
+    for( ThreadIdType slot = 0; slot < numberOfThreads; ++slot )
+    {
+      derivative += derivatives[ slot ];
+    }
+  }
+  else
+  {
+    this->ComputeDerivativeOfSamples( samplesOK, 0, numberOfSamplesOK,
+      G, Atmm, S, dSdmu_part1, KAtZscore, KAtZscoreAmm, derivative );
+  }
 
   derivative *= -static_cast< DerivativeValueType >( 2.0 )
     / ( static_cast< DerivativeValueType >( N
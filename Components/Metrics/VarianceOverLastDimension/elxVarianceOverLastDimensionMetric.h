@@ -59,6 +59,10 @@ namespace elastix
  *    each parameter. This should be used when registration is performed directly on the moving
  *    image, without using a fixed image. Possible values are "true" or "false".
  *
+ * With <tt>(UseMultiThreadingForMetrics "true")</tt>, the samples are divided over the
+ * threads. The time points of a number of samples are transformed together, which is
+ * fastest with a StackTransform.
+ *
  * \ingroup RegistrationMetrics
  * \ingroup Metrics
  */
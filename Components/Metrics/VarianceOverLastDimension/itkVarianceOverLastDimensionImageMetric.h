@@ -44,6 +44,14 @@ namespace itk
  * or by nearest neighbor interpolation of a precomputed central difference image.
  * \li A minimum number of samples that should map within the moving image (mask) can be specified.
  *
+ * The samples are processed in blocks. The points of a block at all positions in
+ * the last dimension are transformed with a single call to the batch functions of
+ * the transform, ordered by position, so that a StackTransform passes every sub
+ * transform all its points at once. With UseMultiThread, every thread takes a
+ * fixed range of samples, and the results of the threads are added in thread
+ * order. The random positions in the last dimension are drawn before the
+ * threads start, so the results do not depend on the number of threads.
+ *
  * \ingroup RegistrationMetrics
  * \ingroup Metrics
  */
@@ -173,6 +181,9 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::NonZeroJacobianIndicesValueType     NonZeroJacobianIndicesValueType;
+  typedef typename Superclass::TransformMovingImageGradientType    TransformMovingImageGradientType;
+  typedef typename Superclass::DerivativeValueType                 DerivativeValueType;
 
   /** Computes the innerproduct of transform Jacobian with moving image gradient.
    * The results are stored in imageJacobian, which is supposed
@@ -190,6 +201,25 @@ private:
   /** Sample n random numbers from 0..m and add them to the vector. */
   void SampleRandom( const int n, const int m, std::vector< int > & numbers ) const;
 
+  /** Compute the sum of the variances over the last dimension of all samples,
+   * and, if derivative is not null, the sum of their derivatives. Sets
+   * m_NumberOfPixelsCounted. Uses multiple threads if requested.
+   */
+  void ComputeSumOfVariances( MeasureType & measure, DerivativeType * derivative ) const;
+
+  /** Add the variances of the samples [begin, end), and, if derivative is not
+   * null, their derivatives. The positions in the last dimension are
+   * lastDimPositions, or, when sampling the last dimension randomly, the
+   * numberOfPositions values that start at sample * numberOfPositions.
+   */
+  void ComputeSumOfVariancesOfSamples(
+    const ImageSampleContainerType * sampleContainer,
+    const SizeValueType begin, const SizeValueType end,
+    const std::vector< int > & lastDimPositions,
+    const unsigned int numberOfPositions,
+    SizeValueType & numberOfPixelsCounted,
+    MeasureType & measure, DerivativeType * derivative ) const;
+
   /** Variables to control random sampling in last dimension. */
   bool         m_SampleLastDimensionRandomly;
   unsigned int m_NumSamplesLastDimension;
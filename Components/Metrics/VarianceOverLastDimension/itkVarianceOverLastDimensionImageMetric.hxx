@@ -21,6 +21,7 @@
 #include "itkVarianceOverLastDimensionImageMetric.h"
 #include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "vnl/algo/vnl_matrix_update.h"
+#include <algorithm>
 #include <numeric>
 
 namespace itk
@@ -193,52 +194,29 @@ VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
 
 
 /**
- * ******************* GetValue *******************
+ * ******************* ComputeSumOfVariances *******************
  */
 
 template< class TFixedImage, class TMovingImage >
-typename VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >::MeasureType
+void
 VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
-::GetValue( const TransformParametersType & parameters ) const
+::ComputeSumOfVariances( MeasureType & measure, DerivativeType * derivative ) const
 {
-  itkDebugMacro( "GetValue( " << parameters << " ) " );
-
-  /** Initialize some variables */
-  this->m_NumberOfPixelsCounted = 0;
-  MeasureType measure = NumericTraits< MeasureType >::Zero;
-
-  /** Call non-thread-safe stuff, such as:
-   *   this->SetTransformParameters( parameters );
-   *   this->GetImageSampler()->Update();
-   * Because of these calls GetValueAndDerivative itself is not thread-safe,
-   * so cannot be called multiple times simultaneously.
-   * This is however needed in the CombinationImageToImageMetric.
-   * In that case, you need to:
-   * - switch the use of this function to on, using m_UseMetricSingleThreaded = true
-   * - call BeforeThreadedGetValueAndDerivative once (single-threaded) before
-   *   calling GetValueAndDerivative
-   * - switch the use of this function to off, using m_UseMetricSingleThreaded = false
-   * - Now you can call GetValueAndDerivative multi-threaded.
-   */
-  this->BeforeThreadedGetValueAndDerivative( parameters );
-
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->End();
+  const SizeValueType         numberOfSamples = sampleContainer->Size();
 
   /** Retrieve slowest varying dimension and its size. */
-  const unsigned int lastDim           = this->GetFixedImage()->GetImageDimension() - 1;
-  const unsigned int lastDimSize       = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
-  const unsigned int numLastDimSamples = this->m_NumSamplesLastDimension;
+  const unsigned int lastDim     = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int lastDimSize = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
 
-  /** Vector containing last dimension positions to use:
-   * initialize on all positions when random sampling turned off.
+  /** Vector containing last dimension positions to use: all positions when
+   * random sampling is turned off. Otherwise the random positions of all
+   * samples are drawn here, in the order of the samples, because the random
+   * generator cannot be shared by the threads.
    */
   std::vector< int > lastDimPositions;
+  unsigned int       numberOfPositions = lastDimSize;
   if( !this->m_SampleLastDimensionRandomly )
   {
     for( unsigned int i = 0; i < lastDimSize; ++i )
@@ -246,81 +224,282 @@ VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
       lastDimPositions.push_back( i );
     }
   }
-
-  /** Loop over the fixed image samples to calculate the variance over time for every sample position. */
-  for( fiter = fbegin; fiter != fend; ++fiter )
+  else
   {
-    /** Read fixed coordinates. */
-    FixedImagePointType fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
+    numberOfPositions = this->m_NumSamplesLastDimension + this->m_NumAdditionalSamplesFixed;
+    lastDimPositions.resize( numberOfSamples * numberOfPositions );
+    std::vector< int > positions;
+    for( SizeValueType s = 0; s < numberOfSamples; ++s )
+    {
+      this->SampleRandom( this->m_NumSamplesLastDimension, lastDimSize, positions );
+      std::copy( positions.begin(), positions.end(), lastDimPositions.begin() + s * numberOfPositions );
+    }
+  }
 
-    /** Determine random last dimension positions if needed. */
-    if( this->m_SampleLastDimensionRandomly )
+  /** Loop over the fixed image samples. With multiple threads, every thread
+   * takes a fixed range of samples, with its own sums, which are added in
+   * the order of the threads.
+   */
+  SizeValueType      numberOfPixelsCounted = 0;
+  const ThreadIdType numberOfThreads       = this->m_UseMultiThread
+    ? static_cast< ThreadIdType >( std::min< SizeValueType >(
+    this->GetNumberOfThreads(), numberOfSamples ) ) : 1;
+  if( numberOfThreads > 1 )
+  {
+    std::vector< SizeValueType >  numberOfPixelsCountedPerThread( numberOfThreads, 0 );
+    std::vector< MeasureType >    measures( numberOfThreads, NumericTraits< MeasureType >::Zero );
+    std::vector< DerivativeType > derivatives( derivative ? numberOfThreads : 0 );
+    WorkStealingThreadPool::GetInstance()->ParallelForSlots( numberOfThreads,
+      [ & ]( ThreadIdType slot )
+      {
+        DerivativeType * derivativeOfThread = 0;
+        if( derivative )
+        {
+          derivatives[ slot ].SetSize( this->GetNumberOfParameters() );
+          derivatives[ slot ].Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+          derivativeOfThread = &derivatives[ slot ];
+        }
+        this->ComputeSumOfVariancesOfSamples( sampleContainer,
+          numberOfSamples * slot / numberOfThreads,
+          numberOfSamples * ( slot + 1 ) / numberOfThreads,
+          lastDimPositions, numberOfPositions,
+          numberOfPixelsCountedPerThread[ slot ], measures[ slot ], derivativeOfThread );
+      } );
+    for( ThreadIdType slot = 0; slot < numberOfThreads; ++slot )
     {
-      this->SampleRandom( numLastDimSamples, lastDimSize, lastDimPositions );
+      numberOfPixelsCounted += numberOfPixelsCountedPerThread[ slot ];
+      measure               += measures[ slot ];
+      if( derivative )
+      {
+        *derivative += derivatives[ slot ];
+      }
     }
+  }
+  else
+  {
+    this->ComputeSumOfVariancesOfSamples( sampleContainer, 0, numberOfSamples,
+      lastDimPositions, numberOfPositions, numberOfPixelsCounted, measure, derivative );
+  }
+  this->m_NumberOfPixelsCounted = numberOfPixelsCounted;
+
+  /** Check if enough samples were valid. */
+  this->CheckNumberOfSamples( numberOfSamples, this->m_NumberOfPixelsCounted );
 
-    /** Transform sampled point to voxel coordinates. */
-    FixedImageContinuousIndexType voxelCoord;
-    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
+} // end ComputeSumOfVariances()
 
-    /** Loop over the slowest varying dimension. */
-    float              sumValues               = 0.0;
-    float              sumValuesSquared        = 0.0;
-    unsigned int       numSamplesOk            = 0;
-    const unsigned int realNumLastDimPositions = lastDimPositions.size();
-    for( unsigned int d = 0; d < realNumLastDimPositions; ++d )
-    {
-      /** Initialize some variables. */
-      RealType             movingImageValue;
-      MovingImagePointType mappedPoint;
 
-      /** Set fixed point's last dimension to lastDimPosition. */
-      voxelCoord[ lastDim ] = lastDimPositions[ d ];
+/**
+ * ******************* ComputeSumOfVariancesOfSamples *******************
+ */
 
-      /** Transform sampled point back to world coordinates. */
-      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint( voxelCoord, fixedPoint );
+template< class TFixedImage, class TMovingImage >
+void
+VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
+::ComputeSumOfVariancesOfSamples(
+  const ImageSampleContainerType * sampleContainer,
+  const SizeValueType begin, const SizeValueType end,
+  const std::vector< int > & lastDimPositions,
+  const unsigned int numberOfPositions,
+  SizeValueType & numberOfPixelsCounted,
+  MeasureType & measure, DerivativeType * derivative ) const
+{
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
 
-      /** Transform point and check if it is inside the B-spline support region. */
-      bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+  /** A block holds samplesPerBlock samples at all positions in the last
+   * dimension, at most about SampleBlockSize points. The point of sample b
+   * at position d is stored at d * samplesPerBlock + b, so that the points
+   * at the same position are consecutive.
+   */
+  const SizeValueType samplesPerBlock = std::max< SizeValueType >( 1,
+    Superclass::SampleBlockSize / std::max< unsigned int >( 1, numberOfPositions ) );
+  const SizeValueType pointsPerBlock = samplesPerBlock * numberOfPositions;
+
+  std::vector< FixedImagePointType >              fixedPoints( pointsPerBlock );
+  std::vector< MovingImagePointType >             mappedPoints( pointsPerBlock );
+  std::vector< RealType >                         movingImageValues( pointsPerBlock );
+  std::vector< TransformMovingImageGradientType > movingImageDerivatives( pointsPerBlock );
+  std::vector< unsigned char >                    pointIsValid( pointsPerBlock );
+  std::vector< float >                            expectedValues( samplesPerBlock );
+  std::vector< unsigned int >                     numberOfValidPoints( samplesPerBlock );
+
+  /** Buffers for the image Jacobians of the valid points of a block. */
+  typename Superclass::NumberOfParametersType     nnzji = 0;
+  std::vector< FixedImagePointType >              validFixedPoints;
+  std::vector< TransformMovingImageGradientType > validMovingImageDerivatives;
+  std::vector< SizeValueType >                    validPointIndices;
+  std::vector< DerivativeValueType >              imageJacobians;
+  std::vector< NonZeroJacobianIndicesValueType >  nonZeroJacobianIndices;
+  if( derivative )
+  {
+    nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+    validFixedPoints.resize( pointsPerBlock );
+    validMovingImageDerivatives.resize( pointsPerBlock );
+    validPointIndices.resize( pointsPerBlock );
+    imageJacobians.resize( pointsPerBlock * nnzji );
+    nonZeroJacobianIndices.resize( pointsPerBlock * nnzji );
+  }
 
-      /** Check if point is inside mask. */
-      if( sampleOk )
+  for( SizeValueType blockBegin = begin; blockBegin < end; blockBegin += samplesPerBlock )
+  {
+    const SizeValueType blockSize = std::min< SizeValueType >( samplesPerBlock, end - blockBegin );
+
+    /** Compute the fixed points of the block at all positions in the last dimension. */
+    for( SizeValueType b = 0; b < blockSize; ++b )
+    {
+      const SizeValueType sample     = blockBegin + b;
+      FixedImagePointType fixedPoint = sampleContainer->ElementAt( sample ).m_ImageCoordinates;
+      const int *         positions  = this->m_SampleLastDimensionRandomly
+        ? &lastDimPositions[ sample * numberOfPositions ] : &lastDimPositions[ 0 ];
+
+      /** Transform sampled point to voxel coordinates. */
+      FixedImageContinuousIndexType voxelCoord;
+      this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
+
+      for( unsigned int d = 0; d < numberOfPositions; ++d )
       {
-        sampleOk = this->IsInsideMovingMask( mappedPoint );
+        /** Set fixed point's last dimension to lastDimPosition, and transform
+         * it back to world coordinates.
+         */
+        voxelCoord[ lastDim ] = positions[ d ];
+        this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(
+          voxelCoord, fixedPoints[ d * blockSize + b ] );
       }
+    }
 
-      /** Compute the moving image value and check if the point is
-       * inside the moving image buffer.
-       */
+    /** Transform the points of the whole block at once. The B-spline weights
+     * and support indices of a sample only depend on its spatial point, and
+     * the sub transforms of a BSplineStackTransform share one grid, so they
+     * could be shared over the positions in the last dimension. They are
+     * still computed per position, because the AdvancedTransform interface
+     * has no batched path that evaluates one point for several sub transforms.
+     */
+    const SizeValueType numberOfPoints = blockSize * numberOfPositions;
+    this->TransformPoints( &fixedPoints[ 0 ], &mappedPoints[ 0 ], numberOfPoints );
+
+    /** Compute the moving image values, and check if the points are inside
+     * the moving image mask and buffer.
+     */
+    for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+      MovingImageDerivativeType movingImageDerivative;
+      bool                      sampleOk = this->IsInsideMovingMask( mappedPoints[ i ] );
       if( sampleOk )
       {
-        sampleOk = this->EvaluateMovingImageValueAndDerivative(
-          mappedPoint, movingImageValue, 0 );
+        sampleOk = this->EvaluateMovingImageValueAndDerivative( mappedPoints[ i ],
+          movingImageValues[ i ], derivative ? &movingImageDerivative : 0 );
+      }
+      pointIsValid[ i ] = sampleOk;
+      if( sampleOk && derivative )
+      {
+        movingImageDerivatives[ i ] = movingImageDerivative;
       }
+    }
 
-      if( sampleOk )
+    /** Compute the variance over the last dimension for every sample. */
+    for( SizeValueType b = 0; b < blockSize; ++b )
+    {
+      float        sumValues        = 0.0;
+      float        sumValuesSquared = 0.0;
+      unsigned int numSamplesOk     = 0;
+      for( unsigned int d = 0; d < numberOfPositions; ++d )
       {
-        numSamplesOk++;
-        sumValues        += movingImageValue;
-        sumValuesSquared += movingImageValue * movingImageValue;
-      } // end if sampleOk
-    } // end for loop over last dimension
+        const SizeValueType i = d * blockSize + b;
+        if( pointIsValid[ i ] )
+        {
+          numSamplesOk++;
+          sumValues        += movingImageValues[ i ];
+          sumValuesSquared += movingImageValues[ i ] * movingImageValues[ i ];
+        }
+      }
+
+      numberOfValidPoints[ b ] = numSamplesOk;
+      if( numSamplesOk > 0 )
+      {
+        numberOfPixelsCounted++;
+
+        /** Add this variance to the variance sum. */
+        const float expectedValue        = sumValues / static_cast< float >( numSamplesOk );
+        const float expectedSquaredValue = sumValuesSquared / static_cast< float >( numSamplesOk );
+        measure           += expectedSquaredValue - expectedValue * expectedValue;
+        expectedValues[ b ] = expectedValue;
+      }
+    }
 
-    if( numSamplesOk > 0 )
+    if( !derivative ) { continue; }
+
+    /** Compute the inner products of the transform Jacobian dT/dmu and the
+     * moving image gradient dM/dx of all valid points of the block at once.
+     */
+    SizeValueType numberOfValidPointsInBlock = 0;
+    for( SizeValueType i = 0; i < numberOfPoints; ++i )
     {
-      this->m_NumberOfPixelsCounted++;
+      if( pointIsValid[ i ] )
+      {
+        validFixedPoints[ numberOfValidPointsInBlock ]            = fixedPoints[ i ];
+        validMovingImageDerivatives[ numberOfValidPointsInBlock ] = movingImageDerivatives[ i ];
+        validPointIndices[ numberOfValidPointsInBlock ]           = i;
+        ++numberOfValidPointsInBlock;
+      }
+    }
+    if( numberOfValidPointsInBlock == 0 ) { continue; }
+
+    this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProducts(
+      &validFixedPoints[ 0 ], &validMovingImageDerivatives[ 0 ], numberOfValidPointsInBlock,
+      &imageJacobians[ 0 ], &nonZeroJacobianIndices[ 0 ] );
 
-      /** Add this variance to the variance sum. */
-      const float expectedValue        = sumValues / static_cast< float >( numSamplesOk );
-      const float expectedSquaredValue = sumValuesSquared / static_cast< float >( numSamplesOk );
-      measure += expectedSquaredValue - expectedValue * expectedValue;
+    /** Update the derivative. */
+    for( SizeValueType v = 0; v < numberOfValidPointsInBlock; ++v )
+    {
+      const SizeValueType i            = validPointIndices[ v ];
+      const SizeValueType b            = i % blockSize;
+      const RealType      MT           = movingImageValues[ i ];
+      const float         numSamplesOk = static_cast< float >( numberOfValidPoints[ b ] );
+      const DerivativeValueType *             imageJacobian = &imageJacobians[ v * nnzji ];
+      const NonZeroJacobianIndicesValueType * nzji          = &nonZeroJacobianIndices[ v * nnzji ];
+      for( typename Superclass::NumberOfParametersType j = 0; j < nnzji; ++j )
+      {
+        ( *derivative )[ nzji[ j ] ] += ( 2.0 * ( MT - expectedValues[ b ] ) * imageJacobian[ j ] )
+          / numSamplesOk;
+      }
     }
 
-  } // end for loop over the image sample container
+  } // end for loop over the blocks of the image sample container
 
-  /** Check if enough samples were valid. */
-  this->CheckNumberOfSamples(
-    sampleContainer->Size(), this->m_NumberOfPixelsCounted );
+} // end ComputeSumOfVariancesOfSamples()
+
+
+/**
+ * ******************* GetValue *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >::MeasureType
+VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
+::GetValue( const TransformParametersType & parameters ) const
+{
+  itkDebugMacro( "GetValue( " << parameters << " ) " );
+
+  /** Initialize some variables */
+  this->m_NumberOfPixelsCounted = 0;
+  MeasureType measure = NumericTraits< MeasureType >::Zero;
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   * Because of these calls GetValueAndDerivative itself is not thread-safe,
+   * so cannot be called multiple times simultaneously.
+   * This is however needed in the CombinationImageToImageMetric.
+   * In that case, you need to:
+   * - switch the use of this function to on, using m_UseMetricSingleThreaded = true
+   * - call BeforeThreadedGetValueAndDerivative once (single-threaded) before
+   *   calling GetValueAndDerivative
+   * - switch the use of this function to off, using m_UseMetricSingleThreaded = false
+   * - Now you can call GetValueAndDerivative multi-threaded.
+   */
+  this->BeforeThreadedGetValueAndDerivative( parameters );
+
+  /** Compute the sum of the variances over the last dimension of all samples. */
+  this->ComputeSumOfVariances( measure, 0 );
 
   /** Compute average over variances. */
   measure /= static_cast< float >( this->m_NumberOfPixelsCounted );
@@ -366,9 +545,6 @@ VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
 {
   itkDebugMacro( "GetValueAndDerivative( " << parameters << " ) " );
 
-  /** Define derivative and Jacobian types. */
-  typedef typename DerivativeType::ValueType DerivativeValueType;
-
   /** Initialize some variables */
   this->m_NumberOfPixelsCounted = 0;
   MeasureType measure = NumericTraits< MeasureType >::Zero;
@@ -390,154 +566,16 @@ VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
    */
   this->BeforeThreadedGetValueAndDerivative( parameters );
 
-  /** Get a handle to the sample container. */
-  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->End();
+  /** Compute the sum of the variances over the last dimension of all samples,
+   * and the sum of their derivatives.
+   */
+  this->ComputeSumOfVariances( measure, &derivative );
 
   /** Retrieve slowest varying dimension and its size. */
   const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
   const unsigned int lastDimSize
     = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
 
-  /** Vector containing last dimension positions to use:
-   * initialize on all positions when random sampling turned off.
-   */
-  std::vector< int > lastDimPositions;
-  if( !this->m_SampleLastDimensionRandomly )
-  {
-    for( unsigned int i = 0; i < lastDimSize; ++i )
-    {
-      lastDimPositions.push_back( i );
-    }
-  }
-
-  /** Create variables to store intermediate results in. */
-  TransformJacobianType jacobian;
-  DerivativeType        imageJacobian( this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() );
-
-  /** Get real last dim samples. */
-  const unsigned int realNumLastDimPositions
-    = this->m_SampleLastDimensionRandomly
-    ? this->m_NumSamplesLastDimension + this->m_NumAdditionalSamplesFixed
-    : lastDimSize;
-
-  /** Variable to store and nzjis. */
-  std::vector< NonZeroJacobianIndicesType > nzjis(
-  realNumLastDimPositions, NonZeroJacobianIndicesType() );
-
-  std::vector< RealType >       MT( realNumLastDimPositions );
-  std::vector< DerivativeType > dMTdmu( realNumLastDimPositions );
-
-  /** Loop over the fixed image samples to calculate the variance over time for every sample position. */
-  for( fiter = fbegin; fiter != fend; ++fiter )
-  {
-    /** Read fixed coordinates. */
-    FixedImagePointType fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
-
-    /** Determine random last dimension positions if needed. */
-    if( this->m_SampleLastDimensionRandomly )
-    {
-      this->SampleRandom( this->m_NumSamplesLastDimension, lastDimSize, lastDimPositions );
-    }
-
-    /** Initialize MT vector. */
-    std::fill( MT.begin(), MT.end(), itk::NumericTraits< RealType >::ZeroValue() );
-
-    /** Transform sampled point to voxel coordinates. */
-    FixedImageContinuousIndexType voxelCoord;
-    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
-
-    /** Loop over the slowest varying dimension. */
-    float        sumValues        = 0.0;
-    float        sumValuesSquared = 0.0;
-    unsigned int numSamplesOk     = 0;
-
-    /** First loop over t: compute M(T(x,t)), dM(T(x,t))/dmu, nzji and store. */
-    for( unsigned int d = 0; d < realNumLastDimPositions; ++d )
-    {
-      /** Initialize some variables. */
-      RealType                  movingImageValue;
-      MovingImagePointType      mappedPoint;
-      MovingImageDerivativeType movingImageDerivative;
-
-      /** Set fixed point's last dimension to lastDimPosition. */
-      voxelCoord[ lastDim ] = lastDimPositions[ d ];
-      /** Transform sampled point back to world coordinates. */
-      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint( voxelCoord, fixedPoint );
-      /** Transform point and check if it is inside the B-spline support region. */
-      bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
-
-      /** Check if point is inside mask. */
-      if( sampleOk )
-      {
-        sampleOk = this->IsInsideMovingMask( mappedPoint );
-      }
-
-      /** Compute the moving image value and check if the point is
-      * inside the moving image buffer. */
-      if( sampleOk )
-      {
-        sampleOk = this->EvaluateMovingImageValueAndDerivative(
-          mappedPoint, movingImageValue, &movingImageDerivative );
-      }
-
-      if( sampleOk )
-      {
-        /** Update value terms **/
-        numSamplesOk++;
-        sumValues        += movingImageValue;
-        sumValuesSquared += movingImageValue * movingImageValue;
-
-        /** Get the TransformJacobian dT/dmu. */
-        this->EvaluateTransformJacobian( fixedPoint, jacobian, nzjis[ d ] );
-
-        /** Compute the innerproduct (dM/dx)^T (dT/dmu). */
-        this->EvaluateTransformJacobianInnerProduct(
-          jacobian, movingImageDerivative, imageJacobian );
-
-        /** Store values. */
-        MT[ d ]     = movingImageValue;
-        dMTdmu[ d ] = imageJacobian;
-      }
-      else
-      {
-        dMTdmu[ d ] = DerivativeType( this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() );
-        dMTdmu[ d ].Fill( itk::NumericTraits< DerivativeValueType >::ZeroValue() );
-        nzjis[ d ] = NonZeroJacobianIndicesType( this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices(), 0 );
-      } // end if sampleOk
-    }
-
-    if( numSamplesOk > 0 )
-    {
-      this->m_NumberOfPixelsCounted++;
-
-      /** Compute average intensity value. */
-      const float expectedValue = sumValues / static_cast< float >( numSamplesOk );
-      /** Add this variance to the variance sum. */
-      const float expectedSquaredValue = sumValuesSquared / static_cast< float >( numSamplesOk );
-      measure += expectedSquaredValue - expectedValue * expectedValue;
-
-      /** Second loop over t: update derivative. */
-      for( unsigned int d = 0; d < realNumLastDimPositions; ++d )
-      {
-        for( unsigned int j = 0; j < nzjis[ d ].size(); ++j )
-        {
-          derivative[ nzjis[ d ][ j ] ] += ( 2.0 * ( MT[ d ] - expectedValue ) * dMTdmu[ d ][ j ] )
-            / static_cast< float >( numSamplesOk );
-        }
-      }
-
-    }
-  } // end for loop over the image sample container
-
-  /** Check if enough samples were valid. */
-  this->CheckNumberOfSamples(
-    sampleContainer->Size(), this->m_NumberOfPixelsCounted );
-
   /** Compute average over variances and normalize with initial variance. */
   measure    /= static_cast< float >( this->m_NumberOfPixelsCounted * this->m_InitialVariance );
   derivative /= static_cast< float >( this->m_NumberOfPixelsCounted * this->m_InitialVariance );
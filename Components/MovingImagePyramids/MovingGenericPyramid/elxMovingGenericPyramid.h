@@ -61,6 +61,13 @@ namespace elastix
  *    at once, or per resolution. Latter saves memory.\n
  *    example: <tt>(ComputePyramidImagesPerResolution "true")</tt>\n
  *    Default false.
+ * \parameter ComputePyramidImagesCascaded: Flag to specify if each resolution level is computed
+ *    from the next finer level instead of from the original image. This is faster, but the
+ *    smoothing differs slightly near the image border. It only saves time, not memory: all
+ *    levels are computed at once and kept, as without this option, and
+ *    ComputePyramidImagesPerResolution is ignored. To save memory, use that option instead.\n
+ *    example: <tt>(ComputePyramidImagesCascaded "true")</tt>\n
+ *    Default false.
  * \parameter ImagePyramidUseShrinkImageFilter: Flag to specify if the ShrinkingImageFilter is used
  *    for rescaling the image, or the ResampleImageFilter. Shrinker is faster.\n
  *    example: <tt>(ImagePyramidUseShrinkImageFilter "true")</tt>\n
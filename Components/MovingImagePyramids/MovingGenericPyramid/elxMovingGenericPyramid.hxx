@@ -153,6 +153,21 @@ MovingGenericPyramid< TElastix >
     "ComputePyramidImagesPerResolution", 0, false );
   this->SetComputeOnlyForCurrentLevel( computeThisResolution );
 
+  /** Decide whether or not to compute each level from the next finer level,
+   * instead of from the input image. This is faster, at the cost of slightly
+   * different smoothing.
+   */
+  bool computeCascaded = false;
+  this->m_Configuration->ReadParameter( computeCascaded,
+    "ComputePyramidImagesCascaded", 0, false );
+  this->SetComputeLevelsCascaded( computeCascaded );
+  if( computeCascaded && computeThisResolution )
+  {
+    xl::xout[ "warning" ] << "WARNING: ComputePyramidImagesPerResolution is ignored, because "
+                          << "ComputePyramidImagesCascaded is true.\n";
+    xl::xout[ "warning" ] << "  All moving pyramid levels are computed at once." << std::endl;
+  }
+
 } // end SetMovingSchedule()
 
 
@@ -1424,7 +1424,10 @@ AdaptiveStochasticLBFGS<TElastix>
   double exactgg = 0.0;
   double diffgg = 0.0;
 
-  /** Compute gg for some random parameters. */
+  /** Compute gg for some random parameters. The measurements are sequential:
+   * each one sets its parameters on the shared transform, and switches the
+   * samplers of the metrics. The metric derivatives themselves are threaded.
+   */
   for( unsigned int i = 0 ; i < this->m_NumberOfGradientMeasurements; ++i )
   {
 #ifndef _ELASTIX_BUILD_LIBRARY
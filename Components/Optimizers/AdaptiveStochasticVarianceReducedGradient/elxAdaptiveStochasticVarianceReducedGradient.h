@@ -150,6 +150,10 @@ namespace elastix
   *   Default value: 0, which means that the value is automatically estimated.
   *   In principle, the more the better, but the slower. In practice N=10 is usually sufficient.
   *   But the automatic estimation achieved by N=0 also works good.
+  *   Each measurement computes the derivative of the metric once, or twice with a random
+  *   sampler, using all threads. The measurements run one after another, because they set
+  *   their parameters on the one transform of the registration, so the time of the
+  *   estimation grows linearly with N.
   *   The parameter has only influence when AutomaticParameterEstimation is used.
   * \parameter NumberOfJacobianMeasurements: The number of voxels M where the Jacobian is measured,
   *   which is used to estimate the covariance matrix.
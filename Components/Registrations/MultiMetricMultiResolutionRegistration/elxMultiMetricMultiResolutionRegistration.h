@@ -88,6 +88,14 @@ namespace elastix
  *    example: <tt>(Metric0Use "false" "true")</tt> \n
  *    example: <tt>(Metric1Use "true" "false")</tt> \n
  *    The default is "true".
+ * \parameter UseConcurrentMetricEvaluation: Whether the metrics that support it are
+ *    computed concurrently, sharing the threads of the elastix thread pool. This
+ *    does not change the results. Multi-threaded image metrics only take part with
+ *    (UseThreadPoolForMetrics "true"); otherwise they are computed one by one. Each
+ *    metric that runs concurrently needs a derivative buffer of its own, of the size of the
+ *    transform parameters, whereas the metrics computed one by one share one. \n
+ *    example: <tt>(UseConcurrentMetricEvaluation "false")</tt> \n
+ *    The default is "true".
  *
  * \ingroup Registrations
  */
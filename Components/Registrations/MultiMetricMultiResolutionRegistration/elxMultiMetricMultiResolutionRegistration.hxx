@@ -113,6 +113,12 @@ MultiMetricMultiResolutionRegistration< TElastix >
   }
   else { this->GetCombinationMetric()->SetUseMultiThread( false ); }
 
+  /** Compute the metrics concurrently or one by one. */
+  bool useConcurrentMetricEvaluation = true;
+  this->GetConfiguration()->ReadParameter( useConcurrentMetricEvaluation,
+    "UseConcurrentMetricEvaluation", 0 );
+  this->GetCombinationMetric()->SetUseConcurrentMetricEvaluation( useConcurrentMetricEvaluation );
+
 } // end BeforeRegistration()
 
 
@@ -50,6 +50,28 @@ namespace itk
  * why we chose to reimplement the Get{Transform,Interpolator}()
  * methods.
  *
+ * By default GetValueAndDerivative() runs the sub-metrics concurrently, as
+ * tasks on the elastix-wide WorkStealingThreadPool. The threads of the
+ * sub-metrics come from the same pool, so that cheap penalty terms and
+ * point set metrics use the threads that the expensive image metric leaves
+ * idle, without oversubscribing the processor. Only sub-metrics for which
+ * GetSupportsConcurrentGetValueAndDerivative() returns true take part, and
+ * of those only the ones that are single-threaded or run on the thread pool
+ * (SetUseThreadPool()). A metric that starts threads of its own would start
+ * them from every concurrent task. The others are computed one by one
+ * afterwards. The values, derivatives and computation times per metric are
+ * the same as when computed one by one.
+ *
+ * The sub-metrics write their derivatives into full vectors of P values, P
+ * being the number of parameters, because that is what their interface takes.
+ * Only the non-zero blocks of these are kept, and they are added up at the
+ * end. With C metrics running concurrently, C full vectors are in use at the
+ * same time; the metrics computed one by one share one. Besides the derivative
+ * of the caller, the buffers of the metrics themselves and the kept blocks,
+ * the peak memory of the derivatives is therefore P values when the metrics
+ * are computed one by one, and C * P values with concurrent evaluation. So the
+ * concurrent evaluation saves time, at the cost of memory.
+ *
  *
  * \ingroup RegistrationMetrics
  *
@@ -203,6 +225,13 @@ public:
   /** \todo: Temporary, should think about interface. */
   itkSetMacro( UseMultiThread, bool );
 
+  /** Select the concurrent computation of the sub-metrics in
+   * GetValueAndDerivative(). Default: true.
+   */
+  itkSetMacro( UseConcurrentMetricEvaluation, bool );
+  itkGetConstMacro( UseConcurrentMetricEvaluation, bool );
+  itkBooleanMacro( UseConcurrentMetricEvaluation );
+
   /** Select which metrics are used.
    * This is useful in case you want to compute a certain measure, but not
    * actually use it during the registration.
@@ -219,7 +248,11 @@ public:
   /** Get the last computed value for metric i. */
   MeasureType GetMetricValue( unsigned int pos ) const;
 
-  /** Get the last computed derivative for metric i. */
+  /** Get the last computed derivative for metric i.
+   * The derivatives are stored block sparse, see StoreMetricDerivative(),
+   * so this function expands the derivative into a full vector, which is
+   * kept until the next call for the same metric.
+   */
   const DerivativeType & GetMetricDerivative( unsigned int pos ) const;
 
   /** Get the last computed derivative magnitude for metric i. */
@@ -409,6 +442,16 @@ protected:
   ~CombinationImageToImageMetric() override {}
   void PrintSelf( std::ostream & os, Indent indent ) const override;
 
+  /** The derivative of a metric, of which only the non-zero blocks of
+   * DerivativeBlockSize parameters are stored. For each block, m_BlockOffsets
+   * holds the position of its values in m_Values, or -1 for a zero block.
+   */
+  struct BlockSparseDerivativeType
+  {
+    std::vector< OffsetValueType >     m_BlockOffsets;
+    std::vector< DerivativeValueType > m_Values;
+  };
+
   /** Store the metrics and the corresponding weights. */
   unsigned int                                   m_NumberOfMetrics;
   std::vector< SingleValuedCostFunctionPointer > m_Metrics;
@@ -417,9 +460,12 @@ protected:
   bool                                           m_UseRelativeWeights;
   std::vector< bool >                            m_UseMetric;
   mutable std::vector< MeasureType >             m_MetricValues;
+  mutable std::vector< BlockSparseDerivativeType > m_SparseMetricDerivatives;
   mutable std::vector< DerivativeType >          m_MetricDerivatives;
+  mutable std::vector< DerivativeType >          m_MetricDerivativeBuffers;
   mutable std::vector< double >                  m_MetricDerivativesMagnitude;
   mutable std::vector< double >                  m_MetricComputationTime;
+  bool                                           m_UseConcurrentMetricEvaluation;
 
   /** Dummy image region and derivatives. */
   FixedImageRegionType m_NullFixedImageRegion;
@@ -441,6 +487,35 @@ private:
    */
   double GetFinalMetricWeight( unsigned int pos ) const;
 
+  /** Get whether sub-metric pos supports concurrent GetValueAndDerivative(),
+   * and does not start threads of its own.
+   */
+  bool GetMetricSupportsConcurrentGetValueAndDerivative( unsigned int pos ) const;
+
+  /** Compute the value and derivative of sub-metric pos, and time it.
+   * The derivative is computed in the given buffer and then stored by
+   * StoreMetricDerivative(), so that the buffer can be reused.
+   */
+  void ComputeMetricValueAndDerivative( const ParametersType & parameters,
+    unsigned int pos, DerivativeType & buffer ) const;
+
+  /** The number of parameters per block of a stored metric derivative. */
+  itkStaticConstMacro( DerivativeBlockSize, unsigned int, 4096 );
+
+  /** Store the non-zero blocks of the derivative of metric pos, and compute
+   * its magnitude. The squared magnitudes are summed per block, and then over
+   * the blocks in a fixed order, so that the result does not depend on the
+   * number of threads.
+   */
+  void StoreMetricDerivative( const DerivativeType & metricDerivative,
+    unsigned int pos ) const;
+
+  /** Compute the weighted sum of the stored metric derivatives, per block
+   * and in parallel, directly into the output. Zero blocks, as are common
+   * for local penalty terms, are skipped.
+   */
+  void CombineMetricDerivatives( DerivativeType & derivative ) const;
+
 };
 
 } // end namespace itk
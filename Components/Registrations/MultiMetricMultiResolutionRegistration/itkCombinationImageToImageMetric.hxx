@@ -21,6 +21,10 @@
 #include "itkCombinationImageToImageMetric.h"
 #include "itkTimeProbe.h"
 #include "itkMath.h"
+#include "itkWorkStealingThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
 
 /** Macros to reduce some copy-paste work.
  * These macros provide the implementation of
@@ -163,6 +167,7 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
 {
   this->m_NumberOfMetrics    = 0;
   this->m_UseRelativeWeights = false;
+  this->m_UseConcurrentMetricEvaluation = true;
   this->ComputeGradientOff();
 
 } // end Constructor
@@ -194,6 +199,8 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
     os << indent << "UseMetric: " << ( this->m_UseMetric[ i ] ? "true\n" : "false\n" );
     os << indent << "MetricComputationTime: " << this->m_MetricComputationTime[ i ] << "\n";
   }
+  os << indent << "UseConcurrentMetricEvaluation: "
+     << ( this->m_UseConcurrentMetricEvaluation ? "true" : "false" ) << "\n";
 
 } // end PrintSelf()
 
@@ -279,6 +286,7 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
     this->m_MetricRelativeWeights.resize( count );
     this->m_UseMetric.resize( count );
     this->m_MetricValues.resize( count );
+    this->m_SparseMetricDerivatives.resize( count );
     this->m_MetricDerivatives.resize( count );
     this->m_MetricDerivativesMagnitude.resize( count );
     this->m_MetricComputationTime.resize( count );
@@ -523,7 +531,25 @@ const typename CombinationImageToImageMetric< TFixedImage, TMovingImage >
   }
   else
   {
-    return this->m_MetricDerivatives[ pos ];
+    /** Expand the stored blocks into a full vector. */
+    const BlockSparseDerivativeType & stored = this->m_SparseMetricDerivatives[ pos ];
+    const SizeValueType numberOfParameters = this->GetNumberOfParameters();
+    const SizeValueType blockSize          = Self::DerivativeBlockSize;
+    DerivativeType &    metricDerivative   = this->m_MetricDerivatives[ pos ];
+    metricDerivative.SetSize( numberOfParameters );
+    metricDerivative.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+    for( SizeValueType b = 0; b < stored.m_BlockOffsets.size(); ++b )
+    {
+      if( stored.m_BlockOffsets[ b ] >= 0 )
+      {
+        const SizeValueType begin = b * blockSize;
+        const SizeValueType end   = std::min( begin + blockSize, numberOfParameters );
+        std::copy( stored.m_Values.begin() + stored.m_BlockOffsets[ b ],
+          stored.m_Values.begin() + stored.m_BlockOffsets[ b ] + ( end - begin ),
+          metricDerivative.data_block() + begin );
+      }
+    }
+    return metricDerivative;
   }
 
 } // end GetMetricDerivative()
@@ -655,10 +681,13 @@ void
 CombinationImageToImageMetric< TFixedImage, TMovingImage >
 ::InitializeThreadingParameters( void ) const
 {
-  /** Initialize the derivatives. */
+  /** Drop the full derivatives of a previous GetMetricDerivative().
+   * The buffers in which the metrics compute their derivatives are
+   * sized when they are needed, in GetValueAndDerivative().
+   */
   for( ThreadIdType i = 0; i < this->GetNumberOfMetrics(); ++i )
   {
-    this->m_MetricDerivatives[ i ].SetSize( this->GetNumberOfParameters() );
+    this->m_MetricDerivatives[ i ].SetSize( 0 );
   }
 } // end InitializeThreadingParameters()
 
@@ -697,6 +726,58 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
 } // end GetFinalMetricWeight()
 
 
+/**
+ * ********* GetMetricSupportsConcurrentGetValueAndDerivative *********
+ */
+
+template< class TFixedImage, class TMovingImage >
+bool
+CombinationImageToImageMetric< TFixedImage, TMovingImage >
+::GetMetricSupportsConcurrentGetValueAndDerivative( unsigned int pos ) const
+{
+  const ImageMetricType * testPtr1
+    = dynamic_cast< const ImageMetricType * >( this->GetMetric( pos ) );
+  const PointSetMetricType * testPtr2
+    = dynamic_cast< const PointSetMetricType * >( this->GetMetric( pos ) );
+  if( testPtr1 )
+  {
+    /** A metric with threads of its own would oversubscribe the processor. */
+    return testPtr1->GetSupportsConcurrentGetValueAndDerivative()
+      && ( !testPtr1->GetUseMultiThread() || testPtr1->GetUseThreadPool() );
+  }
+  else if( testPtr2 )
+  {
+    return testPtr2->GetSupportsConcurrentGetValueAndDerivative();
+  }
+  return false;
+
+} // end GetMetricSupportsConcurrentGetValueAndDerivative()
+
+
+/**
+ * ********************* ComputeMetricValueAndDerivative ****************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+CombinationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeMetricValueAndDerivative( const ParametersType & parameters,
+  unsigned int pos, DerivativeType & buffer ) const
+{
+  /** Compute and time. */
+  itk::TimeProbe timer;
+  timer.Start();
+  this->m_Metrics[ pos ]->GetValueAndDerivative( parameters,
+    this->m_MetricValues[ pos ], buffer );
+  timer.Stop();
+
+  /** Store computation time and derivative. */
+  this->m_MetricComputationTime[ pos ] = timer.GetMean() * 1000.0;
+  this->StoreMetricDerivative( buffer, pos );
+
+} // end ComputeMetricValueAndDerivative()
+
+
 /**
  * ********************* GetValue ****************************
  */
@@ -785,16 +866,15 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
     timer.Stop();
 
     /** store ... */
-    this->m_MetricDerivatives[ i ]          = tmpDerivative;
-    this->m_MetricDerivativesMagnitude[ i ] = tmpDerivative.magnitude();
-    this->m_MetricComputationTime[ i ]      = timer.GetMean() * 1000.0;
+    this->StoreMetricDerivative( tmpDerivative, i );
+    this->m_MetricComputationTime[ i ] = timer.GetMean() * 1000.0;
 
     /** and combine. */
     if( this->m_UseMetric[ i ] )
     {
       if( !this->m_UseRelativeWeights )
       {
-        derivative += this->m_MetricWeights[ i ] * this->m_MetricDerivatives[ i ];
+        derivative += this->m_MetricWeights[ i ] * tmpDerivative;
       }
       else
       {
@@ -810,7 +890,7 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
           weight = this->m_MetricRelativeWeights[ i ]
             * this->m_MetricDerivativesMagnitude[ 0 ]
             / this->m_MetricDerivativesMagnitude[ i ];
-          derivative += weight * this->m_MetricDerivatives[ i ];
+          derivative += weight * tmpDerivative;
         }
       }
     }
@@ -831,9 +911,6 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
   MeasureType & value,
   DerivativeType & derivative ) const
 {
-  /** Declare timer. */
-  itk::TimeProbe timer;
-
   /** This function must be called before the multi-threaded code.
    * It calls all the non thread-safe stuff.
    */
@@ -858,26 +935,68 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
   /** Initialize some threading related parameters. */
   this->InitializeThreadingParameters();
 
-  /** Compute all metric values and derivatives. */
+  /** Split the metrics in those that run concurrently and the others. */
+  std::vector< unsigned int > concurrentMetrics;
+  std::vector< unsigned int > sequentialMetrics;
   for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
   {
-    /** Compute ... */
-    timer.Reset();
-    timer.Start();
-    this->m_Metrics[ i ]->GetValueAndDerivative( parameters,
-      this->m_MetricValues[ i ], this->m_MetricDerivatives[ i ] );
-    timer.Stop();
+    if( this->m_UseConcurrentMetricEvaluation
+      && this->GetMetricSupportsConcurrentGetValueAndDerivative( i ) )
+    {
+      concurrentMetrics.push_back( i );
+    }
+    else
+    {
+      sequentialMetrics.push_back( i );
+    }
+  }
 
-    /** Store computation time. */
-    this->m_MetricComputationTime[ i ] = timer.GetMean() * 1000.0;
+  /** The metrics compute their derivatives in full buffers, of which only
+   * the non-zero blocks are kept. Metrics that run concurrently need a buffer
+   * each; the others share the first one.
+   */
+  const std::size_t numberOfBuffers = std::max< std::size_t >( 1, concurrentMetrics.size() );
+  this->m_MetricDerivativeBuffers.resize( numberOfBuffers );
+  for( std::size_t i = 0; i < numberOfBuffers; ++i )
+  {
+    this->m_MetricDerivativeBuffers[ i ].SetSize( this->GetNumberOfParameters() );
   }
 
-  /** Compute the derivative magnitude. */
-  for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
+  /** Compute the metric values and derivatives, concurrently where possible.
+   * The calling thread takes the first metric, usually the expensive image
+   * metric, and the worker threads the others. The concurrent metrics are
+   * single-threaded or get their threads from the same pool.
+   */
+  if( concurrentMetrics.size() > 1 )
+  {
+    WorkStealingThreadPool::GetInstance()->ParallelForSlots(
+      static_cast< ThreadIdType >( concurrentMetrics.size() ),
+      [ this, &parameters, &concurrentMetrics ]( ThreadIdType slot )
+      {
+        this->ComputeMetricValueAndDerivative( parameters, concurrentMetrics[ slot ],
+          this->m_MetricDerivativeBuffers[ slot ] );
+      } );
+  }
+  else if( concurrentMetrics.size() == 1 )
+  {
+    this->ComputeMetricValueAndDerivative( parameters, concurrentMetrics[ 0 ],
+      this->m_MetricDerivativeBuffers[ 0 ] );
+  }
+
+  for( std::size_t i = 0; i < sequentialMetrics.size(); i++ )
   {
-    this->m_MetricDerivativesMagnitude[ i ] = this->m_MetricDerivatives[ i ].magnitude();
+    this->ComputeMetricValueAndDerivative( parameters, sequentialMetrics[ i ],
+      this->m_MetricDerivativeBuffers[ 0 ] );
   }
 
+  /** Release the buffers before the output is filled, so that at most the
+   * stored blocks and the output are in memory at the same time.
+   */
+  this->m_MetricDerivativeBuffers.clear();
+
+  /** Combine the stored metric derivatives. */
+  this->CombineMetricDerivatives( derivative );
+
   /** Combine the metric values. */
   value = NumericTraits< MeasureType >::Zero;
   for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
@@ -889,28 +1008,177 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
     }
   }
 
-  /** Combine the metric derivatives. First, the first derivative. */
-  if( this->m_UseMetric[ 0 ] )
+} // end GetValueAndDerivative()
+
+
+/**
+ * ********************* StoreMetricDerivative ****************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+CombinationImageToImageMetric< TFixedImage, TMovingImage >
+::StoreMetricDerivative( const DerivativeType & metricDerivative,
+  unsigned int pos ) const
+{
+  const SizeValueType numberOfParameters = this->GetNumberOfParameters();
+  const SizeValueType blockSize          = Self::DerivativeBlockSize;
+  const SizeValueType numberOfBlocks     = ( numberOfParameters + blockSize - 1 ) / blockSize;
+  const ThreadIdType  numberOfThreads    = std::max< ThreadIdType >( 1, this->GetNumberOfThreads() );
+  const DerivativeValueType * input      = metricDerivative.data_block();
+
+  /** Per block the squared magnitude, and whether it is non-zero. */
+  std::vector< double >        blockSquaredMagnitudes( numberOfBlocks, 0.0 );
+  std::vector< unsigned char > blockIsNonZero( numberOfBlocks, 0 );
+
+  WorkStealingThreadPool::GetInstance()->ParallelForChunks(
+    numberOfThreads, numberOfBlocks, 1,
+    [ input, numberOfParameters, blockSize, &blockSquaredMagnitudes, &blockIsNonZero ]
+      ( ThreadIdType, SizeValueType beginBlock, SizeValueType endBlock )
+    {
+      for( SizeValueType b = beginBlock; b < endBlock; ++b )
+      {
+        const SizeValueType begin   = b * blockSize;
+        const SizeValueType end     = std::min( begin + blockSize, numberOfParameters );
+        double              sum     = 0.0;
+        bool                nonZero = false;
+        for( SizeValueType j = begin; j < end; ++j )
+        {
+          const double d = input[ j ];
+          sum     += d * d;
+          nonZero |= ( d != 0.0 );
+        }
+        blockSquaredMagnitudes[ b ] = sum;
+        blockIsNonZero[ b ]         = nonZero;
+      }
+    } );
+
+  double sum = 0.0;
+  for( SizeValueType b = 0; b < numberOfBlocks; ++b )
   {
-    const double weight = this->GetFinalMetricWeight( 0 );
-    derivative = weight * this->m_MetricDerivatives[ 0 ];
+    sum += blockSquaredMagnitudes[ b ];
   }
-  else
+  this->m_MetricDerivativesMagnitude[ pos ] = std::sqrt( sum );
+
+  /** Assign the non-zero blocks their place, and copy them. The last block
+   * may be shorter than the others.
+   */
+  BlockSparseDerivativeType & stored = this->m_SparseMetricDerivatives[ pos ];
+  stored.m_BlockOffsets.assign( numberOfBlocks, -1 );
+  SizeValueType numberOfValues = 0;
+  for( SizeValueType b = 0; b < numberOfBlocks; ++b )
   {
-    derivative.Fill( 0 );
+    if( blockIsNonZero[ b ] )
+    {
+      stored.m_BlockOffsets[ b ] = static_cast< OffsetValueType >( numberOfValues );
+      numberOfValues += std::min( blockSize, numberOfParameters - b * blockSize );
+    }
   }
 
-  /** Then the remaining derivatives. */
-  for( unsigned int i = 1; i < this->m_NumberOfMetrics; i++ )
+  /** Release the memory of the previous iteration first, so that a metric
+   * that becomes sparser also takes less memory.
+   */
+  std::vector< DerivativeValueType >().swap( stored.m_Values );
+  stored.m_Values.resize( numberOfValues );
+
+  DerivativeValueType * values = stored.m_Values.data();
+  WorkStealingThreadPool::GetInstance()->ParallelForChunks(
+    numberOfThreads, numberOfBlocks, 1,
+    [ input, values, numberOfParameters, blockSize, &stored ]
+      ( ThreadIdType, SizeValueType beginBlock, SizeValueType endBlock )
+    {
+      for( SizeValueType b = beginBlock; b < endBlock; ++b )
+      {
+        if( stored.m_BlockOffsets[ b ] >= 0 )
+        {
+          const SizeValueType begin = b * blockSize;
+          const SizeValueType end   = std::min( begin + blockSize, numberOfParameters );
+          std::copy( input + begin, input + end, values + stored.m_BlockOffsets[ b ] );
+        }
+      }
+    } );
+
+} // end StoreMetricDerivative()
+
+
+/**
+ * ********************* CombineMetricDerivatives ****************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+CombinationImageToImageMetric< TFixedImage, TMovingImage >
+::CombineMetricDerivatives( DerivativeType & derivative ) const
+{
+  const unsigned int  numberOfMetrics    = this->m_NumberOfMetrics;
+  const SizeValueType numberOfParameters = this->GetNumberOfParameters();
+  const SizeValueType blockSize          = Self::DerivativeBlockSize;
+  const SizeValueType numberOfBlocks     = ( numberOfParameters + blockSize - 1 ) / blockSize;
+  const ThreadIdType  numberOfThreads    = std::max< ThreadIdType >( 1, this->GetNumberOfThreads() );
+
+  /** The weights depend on the magnitudes, in case of relative weights. */
+  std::vector< unsigned int > usedMetrics;
+  std::vector< double >       weights;
+  for( unsigned int i = 0; i < numberOfMetrics; ++i )
   {
     if( this->m_UseMetric[ i ] )
     {
-      const double weight = this->GetFinalMetricWeight( i );
-      derivative += weight * this->m_MetricDerivatives[ i ];
+      usedMetrics.push_back( i );
+      weights.push_back( this->GetFinalMetricWeight( i ) );
     }
   }
 
-} // end GetValueAndDerivative()
+  /** Per block the weighted sum of the non-zero derivatives,
+   * in the order of the metrics, written directly into the output.
+   */
+  derivative.SetSize( numberOfParameters );
+  DerivativeValueType * output = derivative.data_block();
+
+  WorkStealingThreadPool::GetInstance()->ParallelForChunks(
+    numberOfThreads, numberOfBlocks, 1,
+    [ this, numberOfParameters, blockSize, output, &usedMetrics, &weights ]
+      ( ThreadIdType, SizeValueType beginBlock, SizeValueType endBlock )
+    {
+      for( SizeValueType b = beginBlock; b < endBlock; ++b )
+      {
+        const SizeValueType begin = b * blockSize;
+        const SizeValueType end   = std::min( begin + blockSize, numberOfParameters );
+        bool                first = true;
+        for( std::size_t k = 0; k < usedMetrics.size(); ++k )
+        {
+          const BlockSparseDerivativeType & stored = this->m_SparseMetricDerivatives[ usedMetrics[ k ] ];
+          if( stored.m_BlockOffsets[ b ] < 0 )
+          {
+            continue;
+          }
+
+          const double                weight           = weights[ k ];
+          const DerivativeValueType * metricDerivative = stored.m_Values.data() + stored.m_BlockOffsets[ b ];
+          if( first )
+          {
+            for( SizeValueType j = begin; j < end; ++j )
+            {
+              output[ j ] = weight * metricDerivative[ j - begin ];
+            }
+            first = false;
+          }
+          else
+          {
+            for( SizeValueType j = begin; j < end; ++j )
+            {
+              output[ j ] += weight * metricDerivative[ j - begin ];
+            }
+          }
+        }
+
+        if( first )
+        {
+          std::fill( output + begin, output + end, NumericTraits< DerivativeValueType >::ZeroValue() );
+        }
+      }
+    } );
+
+} // end CombineMetricDerivatives()
 
 
 /**
@@ -366,6 +366,11 @@ protected:
   /** The destructor. */
   ~BSplineTransformWithDiffusion() override {}
 
+  /** TransformPoint() also adds the deformation field, so the chain of this
+   * transform can not be folded.
+   */
+  bool GetTransformChainIsFoldable( void ) const override { return false; }
+
   /** Member variables. */
   SpacingType m_GridSpacingFactor;
 
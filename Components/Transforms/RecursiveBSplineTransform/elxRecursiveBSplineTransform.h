@@ -76,6 +76,11 @@ namespace elastix
  *   <em>Nonrigid registration of dynamic medical imaging data using nD+t B-splines and a
  *   groupwise optimization approach</em>, C.T. Metz, S. Klein, M. Schaap, T. van Walsum and
  *   W.J. Niessen, Medical Image Analysis, in press.
+ * \parameter UseSIMDKernels: use vectorized code for the batch evaluation of cubic
+ *   B-splines in 3D with double precision. The results then depend slightly on
+ *   the instruction set of the processor. \n
+ *   example: <tt>(UseSIMDKernels "true")</tt> \n
+ *   The default is "false". Not used by the cyclic transform.
  *
  *
  * The transform parameters necessary for transformix, additionally defined by this class, are:
@@ -310,6 +315,7 @@ private:
   /** Variables to remember order and periodicity of B-spline transform. */
   unsigned int m_SplineOrder;
   bool         m_Cyclic;
+  bool         m_UseSIMDKernels;
 
   /** Initialize the right B-spline transform based on the spline order and periodicity. */
   unsigned int InitializeBSplineTransform();
@@ -84,7 +84,9 @@ RecursiveBSplineTransform< TElastix >
     }
     else if( this->m_SplineOrder == 3 )
     {
-      this->m_BSplineTransform = BSplineTransformCubicType::New();
+      typename BSplineTransformCubicType::Pointer cubicTransform = BSplineTransformCubicType::New();
+      cubicTransform->SetUseSIMDKernels( this->m_UseSIMDKernels );
+      this->m_BSplineTransform = cubicTransform;
     }
     else
     {
@@ -117,6 +119,9 @@ RecursiveBSplineTransform< TElastix >
   this->m_Cyclic = false;
   this->GetConfiguration()->ReadParameter( this->m_Cyclic,
     "UseCyclicTransform", this->GetComponentLabel(), 0, 0, true );
+  this->m_UseSIMDKernels = false;
+  this->GetConfiguration()->ReadParameter( this->m_UseSIMDKernels,
+    "UseSIMDKernels", this->GetComponentLabel(), 0, 0, true );
 
   return this->InitializeBSplineTransform();
 } // end BeforeAll()
@@ -496,6 +501,9 @@ RecursiveBSplineTransform< TElastix >
   m_Cyclic = false;
   this->GetConfiguration()->ReadParameter( m_Cyclic,
     "UseCyclicTransform", this->GetComponentLabel(), 0, 0 );
+  m_UseSIMDKernels = false;
+  this->GetConfiguration()->ReadParameter( m_UseSIMDKernels,
+    "UseSIMDKernels", this->GetComponentLabel(), 0, 0 );
   InitializeBSplineTransform();
 
   /** Read and Set the Grid: this is a BSplineTransform specific task. */
@@ -63,6 +63,19 @@ namespace elastix
  *    CheckNumberOfSamples. \n
  *    example: <tt>(RequiredRatioOfValidSamples 0.1)</tt> \n
  *    The default is 0.25.
+ * \parameter UseThreadPoolForMetrics: Whether the multi-threaded metrics run on
+ *    a persistent, elastix-wide thread pool, instead of creating new threads
+ *    at every evaluation. Can be given for each resolution. \n
+ *    example: <tt>(UseThreadPoolForMetrics "true")</tt> \n
+ *    The default is false.
+ * \parameter UseDynamicLoadBalancingForMetrics: Whether the image samples are
+ *    distributed dynamically over the threads, in chunks that idle threads
+ *    steal from busy threads. This helps when the cost per sample is uneven,
+ *    e.g. with masks, but makes the order of summation, and therefore the
+ *    last digits of the result, depend on thread scheduling. Only supported
+ *    by some metrics, and only in combination with the thread pool. \n
+ *    example: <tt>(UseDynamicLoadBalancingForMetrics "true")</tt> \n
+ *    The default is false.
  *
  * \ingroup Metrics
  * \ingroup ComponentBaseClasses
@@ -170,6 +170,17 @@ MetricBase< TElastix >
       "UseMultiThreadingForMetrics", this->GetComponentLabel(), level, 0 );
 
     thisAsAdvanced->SetUseMultiThread( useMultiThreading );
+
+    /** Should the metric use the persistent thread pool, and balance the load dynamically? */
+    bool useThreadPool = false;
+    this->GetConfiguration()->ReadParameter( useThreadPool,
+      "UseThreadPoolForMetrics", this->GetComponentLabel(), level, 0, false );
+    thisAsAdvanced->SetUseThreadPool( useThreadPool );
+
+    bool useDynamicLoadBalancing = false;
+    this->GetConfiguration()->ReadParameter( useDynamicLoadBalancing,
+      "UseDynamicLoadBalancingForMetrics", this->GetComponentLabel(), level, 0, false );
+    thisAsAdvanced->SetUseDynamicLoadBalancing( useDynamicLoadBalancing );
     if( useMultiThreading )
     {
       std::string tmp = this->m_Configuration->GetCommandLineArgument( "-threads" );
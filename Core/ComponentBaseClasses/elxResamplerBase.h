@@ -24,6 +24,8 @@
 #include "elxBaseComponentSE.h"
 #include "itkResampleImageFilter.h"
 #include "elxProgressCommand.h"
+#include "itkBackgroundTaskQueue.h"
+#include "itkImageIORegion.h"
 
 namespace elastix
 {
@@ -64,6 +66,41 @@ namespace elastix
  *    of the written image is desired.\n
  *    example: <tt>(CompressResultImage "true")</tt> \n
  *    The default is "false".
+ * \parameter FoldTransformChain: flag to determine if the chain of transforms,
+ *    i.e. the transform and its initial transforms, is folded before resampling.
+ *    Consecutive linear transforms are then multiplied into one affine map,
+ *    which makes resampling with long chains of transforms faster. The result
+ *    only differs by rounding. Choose from {"true", "false"} \n
+ *    example: <tt>(FoldTransformChain "false")</tt> \n
+ *    The default is "true".
+ * \parameter ResampleStreamingDivisions: the number of slabs, along the slowest
+ *    varying dimension, in which the result image is resampled and written. A slab
+ *    is written by a background thread while the next one is resampled. This
+ *    requires a file format that supports streamed writing, such as mha, mhd or nii,
+ *    and no compression. Otherwise the image is resampled and written at once.\n
+ *    example: <tt>(ResampleStreamingDivisions 16)</tt> \n
+ *    The default is 1, i.e. no streaming.
+ * \parameter ResampleStreamingMaximumMemory: the maximum memory, in megabytes, for
+ *    the slabs of the result image. The number of slabs is increased if necessary.
+ *    Note that the memory of the input image and the interpolator is not included.\n
+ *    example: <tt>(ResampleStreamingMaximumMemory 4096)</tt> \n
+ *    The default is 0, i.e. no maximum.
+ * \parameter WriteIntermediateResultImagesInBackground: flag to determine if the
+ *    result images of WriteResultImageAfterEachIteration and
+ *    WriteResultImageAfterEachResolution are resampled and written by a background
+ *    thread, with a copy of the transform, so that the registration continues
+ *    meanwhile. The background thread also gets its own resample interpolator; a
+ *    B-spline interpolator then computes its own coefficients, which temporarily
+ *    takes extra memory. The linear, nearest neighbour and B-spline resample
+ *    interpolators are supported. Choose from {"true", "false"} \n
+ *    example: <tt>(WriteIntermediateResultImagesInBackground "true")</tt> \n
+ *    The default is "false".
+ * \parameter IntermediateResultImageQueueSize: the maximum number of intermediate
+ *    result images that wait to be written in the background. When the queue is full,
+ *    the newest waiting image of an iteration is replaced, i.e. dropped. The images
+ *    of the resolutions are never dropped: registration waits until there is room.\n
+ *    example: <tt>(IntermediateResultImageQueueSize 4)</tt> \n
+ *    The default is 1.
  *
  * \ingroup Resamplers
  * \ingroup ComponentBaseClasses
@@ -191,6 +228,58 @@ protected:
   /** Method that sets the transform, the interpolator and the inputImage. */
   virtual void SetComponents( void );
 
+  /** Fold the chain of transforms before resampling, if the FoldTransformChain
+   * parameter allows it, or unfold it afterwards. See
+   * itk::AdvancedCombinationTransform::FoldTransformChain().
+   */
+  virtual void FoldTransformChain( const bool fold );
+
+  /** Throw an exception if the result image file is one of the input images
+   * or masks, and these may be mapped into memory, see the
+   * UseMemoryMappedImages parameter.
+   */
+  virtual void CheckResultImageIsNotAnInputImage( const char * filename ) const;
+
+  /** Get the number of slabs in which the result image is resampled and
+   * written, following the ResampleStreamingDivisions and
+   * ResampleStreamingMaximumMemory parameters. Returns 1 if streaming is not
+   * requested, or not possible for this file.
+   */
+  virtual unsigned int GetNumberOfResultImageSlabs( const char * filename );
+
+  /** Resample the result image slab by slab, and write the slabs on a
+   * background thread into the file.
+   */
+  virtual void ResampleAndWriteResultImageStreamed( const char * filename,
+    const unsigned int numberOfSlabs, const bool & showProgress );
+
+  /** Create a copy of the transform, including the chain of initial
+   * transforms, which the registration does not change. The copy is checked
+   * on some points of the output region. Returns null if the transform could
+   * not be copied faithfully.
+   */
+  virtual typename TransformType::Pointer CreateTransformSnapshot( void ) const;
+
+  /** Create a new resample interpolator of the same type and with the same
+   * settings, so that a background resampler does not share the pipeline
+   * state of the interpolator with the registration. Returns null for
+   * interpolator types that cannot be copied.
+   */
+  virtual typename InterpolatorType::Pointer CreateInterpolatorCopy( void ) const;
+
+  /** Push the resampling and writing of an intermediate result image, with a
+   * snapshot of the transform, to the background thread, if the
+   * WriteIntermediateResultImagesInBackground parameter asks for it. Returns
+   * false if the image should be written right away instead.
+   * \param mayBeDropped The image may be replaced by a newer one when the queue is full.
+   */
+  virtual bool PushIntermediateResultImage( const char * filename, const bool mayBeDropped );
+
+  /** Wait until the intermediate result images have been written. Reports
+   * errors of the background thread, but does not throw.
+   */
+  virtual void WaitForIntermediateResultImages( void );
+
   /** Variable that defines to print the progress or not. */
   bool m_ShowProgress;
 
@@ -204,6 +293,24 @@ private:
   /** Release memory. */
   void ReleaseMemory( void );
 
+  /** Write an image, or the region ioRegion of it if not null, as in
+   * WriteResultImage(). The settings are passed as arguments, so that this
+   * function can run on a background thread.
+   */
+  static void WriteImage( const OutputImageType * image,
+    const std::string & fileName, const std::string & resultImagePixelType,
+    const bool doCompression, const DirectionType & originalDirection,
+    const bool changeDirection, const itk::ImageIORegion * ioRegion );
+
+  /** The background thread for the intermediate result images. */
+  itk::BackgroundTaskQueue::Pointer m_IntermediateResultImageQueue;
+
+  /** Whether the transform or the interpolator could not be copied,
+   * which is reported once.
+   */
+  bool m_TransformSnapshotFailed;
+  bool m_InterpolatorCopyFailed;
+
 };
 
 } // end namespace elastix
@@ -23,7 +23,15 @@
 #include "itkImageFileCastWriter.h"
 #include "itkChangeInformationImageFilter.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkNearestNeighborInterpolateImageFunction.h"
 #include "itkTimeProbe.h"
+#include "itkImageIOFactory.h"
+#include <itksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <cmath>
 
 namespace elastix
 {
@@ -36,7 +44,9 @@ template< class TElastix >
 ResamplerBase< TElastix >
 ::ResamplerBase()
 {
-  this->m_ShowProgress = true;
+  this->m_ShowProgress            = true;
+  this->m_TransformSnapshotFailed = false;
+  this->m_InterpolatorCopyFailed  = false;
 } // end Constructor
 
 
@@ -115,6 +125,13 @@ ResamplerBase< TElastix >
       << ".R" << level
       << "." << resultImageFormat;
 
+    /** Leave it to the background thread, if requested. */
+    if( this->PushIntermediateResultImage( makeFileName.str().c_str(), false ) )
+    {
+      elxout << "Writing the result image of this resolution in the background ..." << std::endl;
+      return;
+    }
+
     /** Time the resampling. */
     itk::TimeProbe timer;
     timer.Start();
@@ -180,16 +197,19 @@ ResamplerBase< TElastix >
       << ".It" << std::setfill( '0' ) << std::setw( 7 ) << iter
       << "." << resultImageFormat;
 
-    /** Apply the final transform, and save the result. */
-    try
+    /** Apply the final transform, and save the result, possibly in the background. */
+    if( !this->PushIntermediateResultImage( makeFileName.str().c_str(), true ) )
     {
-      this->ResampleAndWriteResultImage( makeFileName.str().c_str(), false );
-    }
-    catch( itk::ExceptionObject & excp )
-    {
-      xl::xout[ "error" ] << "Exception caught: " << std::endl;
-      xl::xout[ "error" ] << excp
-                          << "Resuming elastix." << std::endl;
+      try
+      {
+        this->ResampleAndWriteResultImage( makeFileName.str().c_str(), false );
+      }
+      catch( itk::ExceptionObject & excp )
+      {
+        xl::xout[ "error" ] << "Exception caught: " << std::endl;
+        xl::xout[ "error" ] << excp
+                            << "Resuming elastix." << std::endl;
+      }
     }
 
   } // end if
@@ -206,6 +226,11 @@ void
 ResamplerBase< TElastix >
 ::AfterRegistrationBase( void )
 {
+  /** The intermediate result images use the resample interpolator and the
+   * moving image, so let them finish first.
+   */
+  this->WaitForIntermediateResultImages();
+
   /** Set the final transform parameters. */
   this->GetElastix()->GetElxTransformBase()->SetFinalParameters();
 
@@ -314,6 +339,39 @@ ResamplerBase< TElastix >
 } // end SetComponents()
 
 
+/**
+ * *********************** FoldTransformChain ************************
+ */
+
+template< class TElastix >
+void
+ResamplerBase< TElastix >
+::FoldTransformChain( const bool fold )
+{
+  typedef typename ElastixType::TransformBaseType::CombinationTransformType CombinationTransformType;
+  CombinationTransformType * transform
+    = this->m_Elastix->GetElxTransformBase()->GetAsCombinationTransform();
+  if( transform == 0 )
+  {
+    return;
+  }
+
+  /** Unfold, or fold if that is allowed. */
+  bool foldTransformChain = true;
+  this->m_Configuration->ReadParameter( foldTransformChain,
+    "FoldTransformChain", 0, false );
+  if( fold && foldTransformChain )
+  {
+    transform->FoldTransformChain();
+  }
+  else if( transform->GetTransformChainIsFolded() )
+  {
+    transform->UnfoldTransformChain();
+  }
+
+} // end FoldTransformChain()
+
+
 /**
  * ******************* ResampleAndWriteResultImage ********************
  */
@@ -323,6 +381,17 @@ void
 ResamplerBase< TElastix >
 ::ResampleAndWriteResultImage( const char * filename, const bool & showProgress )
 {
+  /** Do not overwrite an input image that may be mapped into memory. */
+  this->CheckResultImageIsNotAnInputImage( filename );
+
+  /** Resample and write in slabs, if requested and possible. */
+  const unsigned int numberOfSlabs = this->GetNumberOfResultImageSlabs( filename );
+  if( numberOfSlabs > 1 )
+  {
+    this->ResampleAndWriteResultImageStreamed( filename, numberOfSlabs, showProgress );
+    return;
+  }
+
   /** Make sure the resampler is updated. */
   this->GetAsITKBaseType()->Modified();
 
@@ -337,13 +406,16 @@ ResamplerBase< TElastix >
   }
 #endif
 
-  /** Do the resampling. */
+  /** Do the resampling, with the chain of transforms folded. */
+  this->FoldTransformChain( true );
   try
   {
     this->GetAsITKBaseType()->Update();
   }
   catch( itk::ExceptionObject & excp )
   {
+    this->FoldTransformChain( false );
+
     /** Add information to the exception. */
     excp.SetLocation( "ResamplerBase - WriteResultImage()" );
     std::string err_str = excp.GetDescription();
@@ -353,6 +425,7 @@ ResamplerBase< TElastix >
     /** Pass the exception to an higher level. */
     throw excp;
   }
+  this->FoldTransformChain( false );
 
   /** Perform the writing. */
   this->WriteResultImage( this->GetAsITKBaseType()->GetOutput(), filename, showProgress );
@@ -368,6 +441,284 @@ ResamplerBase< TElastix >
 } // end ResampleAndWriteResultImage()
 
 
+/**
+ * ******************* CheckResultImageIsNotAnInputImage ********************
+ */
+
+template< class TElastix >
+void
+ResamplerBase< TElastix >
+::CheckResultImageIsNotAnInputImage( const char * filename ) const
+{
+  /** An input image that is mapped into memory shares its pages with the
+   * file. Truncating or overwriting the file while it is mapped makes
+   * accesses to the image fail with a bus error, instead of an exception.
+   */
+  if( !this->GetElastix()->GetUseMemoryMappedImages()
+    || !itksys::SystemTools::FileExists( filename ) )
+  {
+    return;
+  }
+
+  typedef typename ElastixType::FileNameContainerType FileNameContainerType;
+  const FileNameContainerType * containers[ 4 ] = {
+    this->GetElastix()->GetFixedImageFileNameContainer(),
+    this->GetElastix()->GetMovingImageFileNameContainer(),
+    this->GetElastix()->GetFixedMaskFileNameContainer(),
+    this->GetElastix()->GetMovingMaskFileNameContainer()
+  };
+  for( unsigned int c = 0; c < 4; ++c )
+  {
+    if( containers[ c ] == 0 ) { continue; }
+    for( unsigned int i = 0; i < containers[ c ]->Size(); ++i )
+    {
+      if( itksys::SystemTools::SameFile( filename, containers[ c ]->ElementAt( i ) ) )
+      {
+        itkExceptionMacro( << "ERROR: the result image \"" << filename
+                           << "\" would overwrite the input image \"" << containers[ c ]->ElementAt( i )
+                           << "\", which may be mapped into memory. Choose another output "
+                           << "directory, or set (UseMemoryMappedImages \"false\")." );
+      }
+    }
+  }
+
+} // end CheckResultImageIsNotAnInputImage()
+
+
+/**
+ * ******************* GetNumberOfResultImageSlabs ********************
+ */
+
+template< class TElastix >
+unsigned int
+ResamplerBase< TElastix >
+::GetNumberOfResultImageSlabs( const char * filename )
+{
+  /** Read the streaming parameters. */
+  unsigned int numberOfSlabs = 1;
+  this->m_Configuration->ReadParameter( numberOfSlabs,
+    "ResampleStreamingDivisions", 0, false );
+  double maximumMemory = 0.0;
+  this->m_Configuration->ReadParameter( maximumMemory,
+    "ResampleStreamingMaximumMemory", 0, false );
+
+  /** Increase the number of slabs to stay within the maximum memory. At most
+   * three slabs exist at the same time: the one that is resampled, the one
+   * that waits to be written, and the one that is written. The writer may
+   * cast a slab to the result pixel type, which takes at most a double per pixel.
+   */
+  const SizeType size = this->GetAsITKBaseType()->GetSize();
+  if( maximumMemory > 0.0 )
+  {
+    double numberOfPixels = 1.0;
+    for( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+      numberOfPixels *= static_cast< double >( size[ i ] );
+    }
+    const double bytes = 3.0 * numberOfPixels
+      * static_cast< double >( sizeof( OutputPixelType ) + sizeof( double ) );
+    const double slabs = std::ceil( bytes / ( maximumMemory * 1024.0 * 1024.0 ) );
+    numberOfSlabs = std::max( numberOfSlabs, static_cast< unsigned int >(
+      std::min( slabs, static_cast< double >( size[ ImageDimension - 1 ] ) ) ) );
+  }
+  numberOfSlabs = std::min( numberOfSlabs,
+    static_cast< unsigned int >( size[ ImageDimension - 1 ] ) );
+  if( numberOfSlabs <= 1 )
+  {
+    return 1;
+  }
+
+  /** The RayCastResampleInterpolator changes the transform of the resampler
+   * before writing, which does not combine with resampling in slabs.
+   */
+  typedef itk::AdvancedRayCastInterpolateImageFunction<  InputImageType,
+    CoordRepType > RayCastInterpolatorType;
+  const bool isRayCast = dynamic_cast< const RayCastInterpolatorType * >(
+    this->GetAsITKBaseType()->GetInterpolator() ) != 0;
+
+  /** Check that the file format supports writing in slabs, which it generally
+   * does not with compression.
+   */
+  bool doCompression = false;
+  this->m_Configuration->ReadParameter(
+    doCompression, "CompressResultImage", 0, false );
+#if ( ITK_VERSION_MAJOR > 5 ) || ( ITK_VERSION_MAJOR == 5 && ITK_VERSION_MINOR >= 1 )
+  itk::ImageIOBase::Pointer imageIO = itk::ImageIOFactory::CreateImageIO(
+    filename, itk::IOFileModeEnum::WriteMode );
+#else
+  itk::ImageIOBase::Pointer imageIO = itk::ImageIOFactory::CreateImageIO(
+    filename, itk::ImageIOFactory::WriteMode );
+#endif
+  if( imageIO.IsNotNull() )
+  {
+    imageIO->SetFileName( filename );
+    imageIO->SetUseCompression( doCompression );
+  }
+
+  if( isRayCast || imageIO.IsNull() || !imageIO->CanStreamWrite() )
+  {
+    xl::xout[ "warning" ] << "WARNING: the result image cannot be written in slabs to "
+                          << filename << ".\n  It is resampled and written at once." << std::endl;
+    return 1;
+  }
+
+  return numberOfSlabs;
+
+} // end GetNumberOfResultImageSlabs()
+
+
+/**
+ * ******************* ResampleAndWriteResultImageStreamed ********************
+ */
+
+template< class TElastix >
+void
+ResamplerBase< TElastix >
+::ResampleAndWriteResultImageStreamed( const char * filename,
+  const unsigned int numberOfSlabs, const bool & showProgress )
+{
+  typedef typename OutputImageType::RegionType RegionType;
+
+  /** Read output pixeltype from parameter the file. Replace possible " " with "_". */
+  std::string resultImagePixelType = "short";
+  this->m_Configuration->ReadParameter( resultImagePixelType,
+    "ResultImagePixelType", 0, false );
+  std::basic_string< char >::size_type pos = resultImagePixelType.find( " " );
+  if( pos != std::basic_string< char >::npos ) { resultImagePixelType.replace( pos, 1, "_" ); }
+
+  /** Possibly change direction cosines to their original value, see WriteResultImage(). */
+  DirectionType originalDirection;
+  const bool    retdc           = this->GetElastix()->GetOriginalFixedImageDirection( originalDirection );
+  const bool    changeDirection = retdc & !this->GetElastix()->GetUseDirectionCosines();
+
+  /** The slabs are pasted into the file, so a file of a previous run has to go. */
+  const std::string fileName( filename );
+  itksys::SystemTools::RemoveFile( fileName.c_str() );
+
+  /** Make sure the resampler is updated, and determine the full output region. */
+  ITKBaseType * resampler = this->GetAsITKBaseType();
+  resampler->Modified();
+  resampler->UpdateOutputInformation();
+  const RegionType         largestRegion    = resampler->GetOutput()->GetLargestPossibleRegion();
+  const unsigned int       slowestDimension = ImageDimension - 1;
+  const itk::SizeValueType slowestSize      = largestRegion.GetSize( slowestDimension );
+
+#ifndef _ELASTIX_BUILD_LIBRARY
+  typename ProgressCommandType::Pointer progressObserver = ProgressCommandType::New();
+  if( showProgress )
+  {
+    progressObserver->SetStartString( "  Progress: " );
+    progressObserver->SetEndString( "%" );
+    progressObserver->PrintProgress( 0.0 );
+  }
+#endif
+
+  /** The writer thread takes one slab at a time. Resampling waits when the
+   * next slab is ready before the previous one has been taken.
+   */
+  itk::BackgroundTaskQueue::Pointer writerQueue = itk::BackgroundTaskQueue::New();
+  writerQueue->SetCapacity( 1 );
+
+  /** Resample the slabs, with the chain of transforms folded. */
+  this->FoldTransformChain( true );
+  try
+  {
+    for( unsigned int k = 0; k < numberOfSlabs; ++k )
+    {
+      /** The region of the slab along the slowest varying dimension. */
+      const itk::SizeValueType begin = slowestSize * k / numberOfSlabs;
+      const itk::SizeValueType end   = slowestSize * ( k + 1 ) / numberOfSlabs;
+      RegionType slabRegion = largestRegion;
+      slabRegion.SetIndex( slowestDimension, largestRegion.GetIndex( slowestDimension ) + begin );
+      slabRegion.SetSize( slowestDimension, end - begin );
+
+      /** Resample the slab, as in the itk::StreamingImageFilter. */
+      OutputImageType * output = resampler->GetOutput();
+      output->SetRequestedRegion( slabRegion );
+      output->PropagateRequestedRegion();
+      output->UpdateOutputData();
+
+      /** Move the buffer of the resampled slab to an image of its own, so that
+       * the resampler allocates a new buffer for the next slab.
+       */
+      typename OutputImageType::Pointer slab = OutputImageType::New();
+      slab->CopyInformation( output );
+      slab->SetRegions( slabRegion );
+      slab->SetLargestPossibleRegion( largestRegion );
+      slab->SetPixelContainer( output->GetPixelContainer() );
+      output->Initialize();
+
+      /** Write the slab into its region of the file, on the writer thread. */
+      itk::ImageIORegion ioRegion( ImageDimension );
+      for( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+        ioRegion.SetIndex( i, slabRegion.GetIndex( i ) - largestRegion.GetIndex( i ) );
+        ioRegion.SetSize( i, slabRegion.GetSize( i ) );
+      }
+      writerQueue->Push( [ slab, ioRegion, fileName, resultImagePixelType,
+        originalDirection, changeDirection ]()
+        {
+          Self::WriteImage( slab, fileName, resultImagePixelType, false,
+            originalDirection, changeDirection, &ioRegion );
+        } );
+
+#ifndef _ELASTIX_BUILD_LIBRARY
+      if( showProgress )
+      {
+        progressObserver->PrintProgress( static_cast< float >( k + 1 ) / numberOfSlabs );
+      }
+#endif
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    this->FoldTransformChain( false );
+
+    /** Let the writer thread finish the slabs that were pushed already. */
+    try
+    {
+      writerQueue->Wait();
+    }
+    catch( ... )
+    {
+    }
+
+    /** Add information to the exception. */
+    excp.SetLocation( "ResamplerBase - ResampleAndWriteResultImageStreamed()" );
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError occurred while resampling the image.\n";
+    excp.SetDescription( err_str );
+
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+  this->FoldTransformChain( false );
+
+  /** Wait for the last slab to be written. */
+  if( showProgress )
+  {
+    xl::xout[ "coutonly" ] << std::flush;
+    xl::xout[ "coutonly" ] << "\n  Writing image ..." << std::endl;
+  }
+  try
+  {
+    writerQueue->Wait();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    /** Add information to the exception. */
+    excp.SetLocation( "ResamplerBase - ResampleAndWriteResultImageStreamed()" );
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError occurred while writing resampled image.\n";
+    excp.SetDescription( err_str );
+
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+
+} // end ResampleAndWriteResultImageStreamed()
+
+
 /**
  * ******************* WriteResultImage ********************
  */
@@ -407,31 +758,12 @@ ResamplerBase< TElastix >
   this->m_Configuration->ReadParameter(
     doCompression, "CompressResultImage", 0, false );
 
-  /** Typedef's for writing the output image. */
-  typedef itk::ImageFileCastWriter< OutputImageType > WriterType;
-  typedef typename WriterType::Pointer                WriterPointer;
-  typedef itk::ChangeInformationImageFilter<
-    OutputImageType >                                 ChangeInfoFilterType;
-
   /** Possibly change direction cosines to their original value, as specified
    * in the tp-file, or by the fixed image. This is only necessary when
    * the UseDirectionCosines flag was set to false.
    */
-  typename ChangeInfoFilterType::Pointer infoChanger = ChangeInfoFilterType::New();
   DirectionType originalDirection;
   bool          retdc = this->GetElastix()->GetOriginalFixedImageDirection( originalDirection );
-  infoChanger->SetOutputDirection( originalDirection );
-  infoChanger->SetChangeDirection( retdc & !this->GetElastix()->GetUseDirectionCosines() );
-  infoChanger->SetInput( image );
-
-  /** Create writer. */
-  WriterPointer writer = WriterType::New();
-
-  /** Setup the pipeline. */
-  writer->SetInput( infoChanger->GetOutput() );
-  writer->SetFileName( filename );
-  writer->SetOutputComponentType( resultImagePixelType.c_str() );
-  writer->SetUseCompression( doCompression );
 
   /** Do the writing. */
   if( showProgress )
@@ -441,7 +773,8 @@ ResamplerBase< TElastix >
   }
   try
   {
-    writer->Update();
+    Self::WriteImage( image, filename, resultImagePixelType, doCompression,
+      originalDirection, retdc & !this->GetElastix()->GetUseDirectionCosines(), 0 );
   }
   catch( itk::ExceptionObject & excp )
   {
@@ -457,6 +790,356 @@ ResamplerBase< TElastix >
 } // end WriteResultImage()
 
 
+/**
+ * ******************* WriteImage ********************
+ */
+
+template< class TElastix >
+void
+ResamplerBase< TElastix >
+::WriteImage( const OutputImageType * image,
+  const std::string & fileName, const std::string & resultImagePixelType,
+  const bool doCompression, const DirectionType & originalDirection,
+  const bool changeDirection, const itk::ImageIORegion * ioRegion )
+{
+  /** Typedef's for writing the output image. */
+  typedef itk::ImageFileCastWriter< OutputImageType > WriterType;
+  typedef typename WriterType::Pointer                WriterPointer;
+  typedef itk::ChangeInformationImageFilter<
+    OutputImageType >                                 ChangeInfoFilterType;
+
+  /** Possibly change direction cosines to their original value. */
+  typename ChangeInfoFilterType::Pointer infoChanger = ChangeInfoFilterType::New();
+  infoChanger->SetOutputDirection( originalDirection );
+  infoChanger->SetChangeDirection( changeDirection );
+  infoChanger->SetInput( image );
+
+  /** Create writer. */
+  WriterPointer writer = WriterType::New();
+
+  /** Setup the pipeline. */
+  writer->SetInput( infoChanger->GetOutput() );
+  writer->SetFileName( fileName );
+  writer->SetOutputComponentType( resultImagePixelType.c_str() );
+  writer->SetUseCompression( doCompression );
+  if( ioRegion )
+  {
+    writer->SetIORegion( *ioRegion );
+  }
+
+  /** Do the writing. */
+  writer->Update();
+
+} // end WriteImage()
+
+
+/**
+ * ******************* CreateTransformSnapshot ********************
+ */
+
+template< class TElastix >
+typename ResamplerBase< TElastix >::TransformType::Pointer
+ResamplerBase< TElastix >
+::CreateTransformSnapshot( void ) const
+{
+  typedef typename ElastixType::TransformBaseType::CombinationTransformType CombinationTransformType;
+  typedef typename CombinationTransformType::CurrentTransformType           CurrentTransformType;
+
+  CombinationTransformType * transform
+    = this->m_Elastix->GetElxTransformBase()->GetAsCombinationTransform();
+  if( transform == 0 || transform->GetCurrentTransform() == 0 )
+  {
+    return nullptr;
+  }
+  const CurrentTransformType * currentTransform = transform->GetCurrentTransform();
+
+  /** Copy the current transform: a new instance of the same type, with a
+   * copy of the parameters. The initial transforms are shared.
+   */
+  typename CombinationTransformType::Pointer snapshot = CombinationTransformType::New();
+  try
+  {
+    itk::LightObject::Pointer another = currentTransform->CreateAnother();
+    typename CurrentTransformType::Pointer currentCopy
+      = dynamic_cast< CurrentTransformType * >( another.GetPointer() );
+    if( currentCopy.IsNull() )
+    {
+      return nullptr;
+    }
+    currentCopy->SetFixedParameters( currentTransform->GetFixedParameters() );
+    currentCopy->SetParametersByValue( currentTransform->GetParameters() );
+
+    snapshot->SetUseComposition( transform->GetUseComposition() );
+    snapshot->SetUseAddition( transform->GetUseAddition() );
+    snapshot->SetInitialTransform( transform->GetModifiableInitialTransform() );
+    snapshot->SetCurrentTransform( currentCopy );
+  }
+  catch( itk::ExceptionObject & )
+  {
+    return nullptr;
+  }
+
+  /** Not all state of a transform is in its parameters. So check that the
+   * copy maps the corners and the center of the output region to the same
+   * points as the transform.
+   */
+  const ITKBaseType * resampler = this->GetAsITKBaseType();
+  const SizeType      size      = resampler->GetSize();
+  const IndexType     start     = resampler->GetOutputStartIndex();
+  typedef itk::ContinuousIndex< CoordRepType, ImageDimension > ContinuousIndexType;
+  typedef typename TransformType::InputPointType               InputPointType;
+  typedef typename TransformType::OutputPointType              OutputPointType;
+  typename OutputImageType::Pointer grid = OutputImageType::New();
+  grid->SetOrigin( resampler->GetOutputOrigin() );
+  grid->SetSpacing( resampler->GetOutputSpacing() );
+  grid->SetDirection( resampler->GetOutputDirection() );
+
+  for( unsigned int c = 0; c <= ( 1u << ImageDimension ); ++c )
+  {
+    ContinuousIndexType cindex;
+    for( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+      const double last = static_cast< double >( start[ i ] + size[ i ] ) - 1.0;
+      cindex[ i ] = ( c == ( 1u << ImageDimension ) )
+        ? 0.5 * ( start[ i ] + last ) : ( ( c >> i ) & 1 ) ? last : start[ i ];
+    }
+    InputPointType point;
+    grid->TransformContinuousIndexToPhysicalPoint( cindex, point );
+
+    const OutputPointType expected = transform->TransformPoint( point );
+    const OutputPointType actual   = snapshot->TransformPoint( point );
+    for( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+      if( std::abs( expected[ i ] - actual[ i ] ) > 1e-6 * ( 1.0 + std::abs( expected[ i ] ) ) )
+      {
+        return nullptr;
+      }
+    }
+  }
+
+  return snapshot.GetPointer();
+
+} // end CreateTransformSnapshot()
+
+
+/**
+ * ******************* CreateInterpolatorCopy ********************
+ */
+
+template< class TElastix >
+typename ResamplerBase< TElastix >::InterpolatorType::Pointer
+ResamplerBase< TElastix >
+::CreateInterpolatorCopy( void ) const
+{
+  typedef itk::LinearInterpolateImageFunction<
+    InputImageType, CoordRepType >                          LinearInterpolatorType;
+  typedef itk::NearestNeighborInterpolateImageFunction<
+    InputImageType, CoordRepType >                          NearestNeighborInterpolatorType;
+  typedef itk::BSplineInterpolateImageFunction<
+    InputImageType, CoordRepType, double >                  BSplineInterpolatorType;
+  typedef itk::BSplineInterpolateImageFunction<
+    InputImageType, CoordRepType, float >                   BSplineInterpolatorFloatType;
+
+  const InterpolatorType * interpolator = this->GetAsITKBaseType()->GetInterpolator();
+  if( interpolator == 0 )
+  {
+    return nullptr;
+  }
+
+  /** Only copy the interpolators of which all settings are known. */
+  const BSplineInterpolatorType *      bspline      = dynamic_cast< const BSplineInterpolatorType * >( interpolator );
+  const BSplineInterpolatorFloatType * bsplineFloat = dynamic_cast< const BSplineInterpolatorFloatType * >( interpolator );
+  if( !bspline && !bsplineFloat
+    && !dynamic_cast< const LinearInterpolatorType * >( interpolator )
+    && !dynamic_cast< const NearestNeighborInterpolatorType * >( interpolator ) )
+  {
+    return nullptr;
+  }
+
+  itk::LightObject::Pointer           another = interpolator->CreateAnother();
+  typename InterpolatorType::Pointer copy    = dynamic_cast< InterpolatorType * >( another.GetPointer() );
+  if( copy.IsNull() )
+  {
+    return nullptr;
+  }
+
+  if( bspline )
+  {
+    dynamic_cast< BSplineInterpolatorType * >( copy.GetPointer() )
+    ->SetSplineOrder( bspline->GetSplineOrder() );
+  }
+  else if( bsplineFloat )
+  {
+    dynamic_cast< BSplineInterpolatorFloatType * >( copy.GetPointer() )
+    ->SetSplineOrder( bsplineFloat->GetSplineOrder() );
+  }
+
+  return copy;
+
+} // end CreateInterpolatorCopy()
+
+
+/**
+ * ******************* PushIntermediateResultImage ********************
+ */
+
+template< class TElastix >
+bool
+ResamplerBase< TElastix >
+::PushIntermediateResultImage( const char * filename, const bool mayBeDropped )
+{
+  /** Check if writing in the background is requested. */
+  bool inBackground = false;
+  this->m_Configuration->ReadParameter( inBackground,
+    "WriteIntermediateResultImagesInBackground", 0, false );
+  if( !inBackground )
+  {
+    return false;
+  }
+
+  /** The RayCastResampleInterpolator uses the transform of the registration itself. */
+  typedef itk::AdvancedRayCastInterpolateImageFunction<  InputImageType,
+    CoordRepType > RayCastInterpolatorType;
+  if( dynamic_cast< const RayCastInterpolatorType * >(
+    this->GetAsITKBaseType()->GetInterpolator() ) != 0 )
+  {
+    return false;
+  }
+
+  /** Copy the transform, as the registration goes on changing it. */
+  typename TransformType::Pointer snapshot = this->CreateTransformSnapshot();
+  if( snapshot.IsNull() )
+  {
+    if( !this->m_TransformSnapshotFailed )
+    {
+      xl::xout[ "warning" ] << "WARNING: the transform cannot be copied, so the "
+                            << "intermediate result images are written during registration."
+                            << std::endl;
+      this->m_TransformSnapshotFailed = true;
+    }
+    return false;
+  }
+
+  /** A copy of the interpolator, which stores its input image. */
+  typename InterpolatorType::Pointer interpolator = this->CreateInterpolatorCopy();
+  if( interpolator.IsNull() )
+  {
+    if( !this->m_InterpolatorCopyFailed )
+    {
+      xl::xout[ "warning" ] << "WARNING: the resample interpolator cannot be copied, so the "
+                            << "intermediate result images are written during registration."
+                            << std::endl;
+      this->m_InterpolatorCopyFailed = true;
+    }
+    return false;
+  }
+
+  /** Read the settings here, the background thread does not access the configuration. */
+  std::string resultImagePixelType = "short";
+  this->m_Configuration->ReadParameter( resultImagePixelType,
+    "ResultImagePixelType", 0, false );
+  std::basic_string< char >::size_type pos = resultImagePixelType.find( " " );
+  if( pos != std::basic_string< char >::npos ) { resultImagePixelType.replace( pos, 1, "_" ); }
+  bool doCompression = false;
+  this->m_Configuration->ReadParameter(
+    doCompression, "CompressResultImage", 0, false );
+  DirectionType originalDirection;
+  const bool    retdc           = this->GetElastix()->GetOriginalFixedImageDirection( originalDirection );
+  const bool    changeDirection = retdc & !this->GetElastix()->GetUseDirectionCosines();
+
+  /** A resampler of its own, with the snapshot and the interpolator copy.
+   * Its input is a shallow copy of the moving image: it shares the pixels,
+   * but the pipeline updates of the resampler do not touch the image that
+   * the registration reads. It runs on a single thread, to leave the other
+   * threads to the registration.
+   */
+  const ITKBaseType *                mainResampler = this->GetAsITKBaseType();
+  typename InputImageType::Pointer   movingImage   = InputImageType::New();
+  movingImage->Graft( mainResampler->GetInput() );
+  typename ITKBaseType::Pointer      resampler     = ITKBaseType::New();
+  resampler->SetInput( movingImage );
+  resampler->SetTransform( snapshot );
+  resampler->SetInterpolator( interpolator );
+  resampler->SetSize( mainResampler->GetSize() );
+  resampler->SetOutputStartIndex( mainResampler->GetOutputStartIndex() );
+  resampler->SetOutputOrigin( mainResampler->GetOutputOrigin() );
+  resampler->SetOutputSpacing( mainResampler->GetOutputSpacing() );
+  resampler->SetOutputDirection( mainResampler->GetOutputDirection() );
+  resampler->SetDefaultPixelValue( mainResampler->GetDefaultPixelValue() );
+#if ITK_VERSION_MAJOR >= 5
+  resampler->SetNumberOfWorkUnits( 1 );
+#else
+  resampler->SetNumberOfThreads( 1 );
+#endif
+
+  /** Create the queue at the first image. */
+  unsigned int queueSize = 1;
+  this->m_Configuration->ReadParameter( queueSize,
+    "IntermediateResultImageQueueSize", 0, false );
+  if( this->m_IntermediateResultImageQueue.IsNull() )
+  {
+    this->m_IntermediateResultImageQueue = itk::BackgroundTaskQueue::New();
+  }
+  this->m_IntermediateResultImageQueue->SetCapacity( queueSize );
+
+  const std::string fileName( filename );
+  const auto        task = [ resampler, fileName, resultImagePixelType, doCompression,
+    originalDirection, changeDirection ]()
+    {
+      resampler->Update();
+      Self::WriteImage( resampler->GetOutput(), fileName, resultImagePixelType,
+        doCompression, originalDirection, changeDirection, 0 );
+    };
+  if( mayBeDropped )
+  {
+    this->m_IntermediateResultImageQueue->PushOrReplaceNewest( task );
+  }
+  else
+  {
+    this->m_IntermediateResultImageQueue->Push( task );
+  }
+
+  return true;
+
+} // end PushIntermediateResultImage()
+
+
+/**
+ * ******************* WaitForIntermediateResultImages ********************
+ */
+
+template< class TElastix >
+void
+ResamplerBase< TElastix >
+::WaitForIntermediateResultImages( void )
+{
+  if( this->m_IntermediateResultImageQueue.IsNull() )
+  {
+    return;
+  }
+
+  try
+  {
+    this->m_IntermediateResultImageQueue->Wait();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    xl::xout[ "error" ] << "Exception caught while writing an intermediate result image: " << std::endl;
+    xl::xout[ "error" ] << excp << "Resuming elastix." << std::endl;
+  }
+
+  const itk::SizeValueType dropped
+    = this->m_IntermediateResultImageQueue->GetNumberOfDroppedTasks();
+  if( dropped > 0 )
+  {
+    elxout << "  " << dropped << " intermediate result images were skipped, "
+           << "because writing them could not keep up with the registration." << std::endl;
+  }
+  this->m_IntermediateResultImageQueue = nullptr;
+
+} // end WaitForIntermediateResultImages()
+
+
 /*
  * ******************* CreateItkResultImage ********************
  * \todo: avoid code duplication with WriteResultImage function
@@ -480,13 +1163,16 @@ ResamplerBase< TElastix >
   progressObserver->SetEndString( "%" );
 #endif
 
-  /** Do the resampling. */
+  /** Do the resampling, with the chain of transforms folded. */
+  this->FoldTransformChain( true );
   try
   {
     this->GetAsITKBaseType()->Update();
   }
   catch( itk::ExceptionObject & excp )
   {
+    this->FoldTransformChain( false );
+
     /** Add information to the exception. */
     excp.SetLocation( "ResamplerBase - WriteResultImage()" );
     std::string err_str = excp.GetDescription();
@@ -496,6 +1182,7 @@ ResamplerBase< TElastix >
     /** Pass the exception to an higher level. */
     throw excp;
   }
+  this->FoldTransformChain( false );
 
   /** Check if ResampleInterpolator is the RayCastResampleInterpolator */
   typedef itk::AdvancedRayCastInterpolateImageFunction<  InputImageType,
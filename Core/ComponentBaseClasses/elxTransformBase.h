@@ -24,6 +24,8 @@
 #include "elxBaseComponentSE.h"
 #include "itkAdvancedTransform.h"
 #include "itkAdvancedCombinationTransform.h"
+#include "itkAdvancedTransformToDisplacementFieldSource.h"
+#include "itkChangeInformationImageFilter.h"
 #include "elxComponentDatabase.h"
 #include "elxProgressCommand.h"
 
@@ -119,9 +121,20 @@ namespace elastix
  *    "point", depending if the user supplies voxel indices or real world coordinates.
  *    The second line should be the number of points that should be transformed. The
  *    third and following lines give the indices or points.\n
+ *    The input points may also be given in a binary file, as described in the
+ *    TransformixInputPointFileReader. The output points are then written in the same
+ *    binary format to outputpoints.bin, instead of the text file outputpoints.txt.
+ *    The points are transformed multi-threaded, in blocks.\n
  *    It is also possible to deform all points, thereby generating a deformation field
  *    image. This is done by:\n
  *    example: <tt>-def all</tt> \n
+ *    The deformation field, and the images of the options -jac and -jacmat, are computed
+ *    multi-threaded. They are generated and written in pieces along the last dimension
+ *    when the parameter ResampleStreamingDivisions is larger than 1, or when they would
+ *    not fit in ResampleStreamingMaximumMemory megabytes, see the ResamplerBase. The
+ *    file format should then support streamed writing, e.g. mhd or nii without compression.
+ *    If not, the image is written at once. When transformix is used as a library the
+ *    deformation field is always kept in memory, as it is returned.\n
  *
  * \ingroup Transforms
  * \ingroup ComponentBaseClasses
@@ -197,6 +210,10 @@ public:
     float, FixedImageDimension >                      VectorPixelType;
   typedef itk::Image<
     VectorPixelType, FixedImageDimension >            DeformationFieldImageType;
+  typedef itk::AdvancedTransformToDisplacementFieldSource<
+    DeformationFieldImageType, CoordRepType >         DeformationFieldGeneratorType;
+  typedef itk::ChangeInformationImageFilter<
+    DeformationFieldImageType >                       DeformationFieldInfoChangerType;
 
   /** Typedefs needed for AutomaticScalesEstimation function */
   typedef typename RegistrationType::ITKBaseType      ITKRegistrationType;
@@ -349,6 +366,25 @@ protected:
   void AutomaticScalesEstimationStackTransform(
     const unsigned int & numSubTransforms, ScalesType & scales ) const;
 
+  /** Get the number of pieces in which an output image of the given number
+   * of bytes per pixel is generated and written, following the
+   * ResampleStreamingDivisions and ResampleStreamingMaximumMemory parameters.
+   */
+  unsigned int GetNumberOfStreamDivisions( const std::size_t bytesPerPixel ) const;
+
+  /** Generate and write the deformation field piece by piece, so that the
+   * whole field is never in memory.
+   */
+  void WriteDeformationFieldImageStreamed( const unsigned int numberOfStreamDivisions ) const;
+
+  /** Set up the generator of the deformation field on the output grid of
+   * the resampler, followed by a filter that restores the original direction
+   * cosines when UseDirectionCosines is false. Returns that filter, the end
+   * of the pipeline.
+   */
+  typename DeformationFieldInfoChangerType::Pointer CreateDeformationFieldPipeline(
+    typename DeformationFieldGeneratorType::Pointer & defGenerator ) const;
+
   /** Member variables. */
   ParametersType * m_TransformParametersPointer;
   std::string      m_TransformParametersFileName;
@@ -26,7 +26,7 @@
 #include "vnl/vnl_math.h"
 #include <itksys/SystemTools.hxx>
 #include "itkVector.h"
-#include "itkTransformToDisplacementFieldFilter.h"
+#include "itkAdvancedTransformToDisplacementFieldSource.h"
 #include "itkTransformToDeterminantOfSpatialJacobianSource.h"
 #include "itkTransformToSpatialJacobianSource.h"
 #include "itkImageFileWriter.h"
@@ -37,6 +37,17 @@
 #include "itkMeshFileReader.h"
 #include "itkMeshFileWriter.h"
 #include "itkTransformMeshFilter.h"
+#include "itkBackgroundTaskQueue.h"
+#include "itkWorkStealingThreadPool.h"
+#include "itkMultiThreader.h"
+#include "itkByteSwapper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
 
 namespace itk
 {
@@ -1162,7 +1173,6 @@ TransformBase< TElastix >
     FixedImageDimension, MeshTraitsType >                PointSetType;
   typedef itk::TransformixInputPointFileReader<
     PointSetType >                                      IPPReaderType;
-  typedef itk::Vector< float, FixedImageDimension > DeformationVectorType;
 
   /** Construct an ipp-file reader. */
   typename IPPReaderType::Pointer ippReader = IPPReaderType::New();
@@ -1189,19 +1199,12 @@ TransformBase< TElastix >
   {
     elxout << "  Input points are specified in world coordinates." << std::endl;
   }
-  unsigned int nrofpoints = ippReader->GetNumberOfPoints();
-  elxout << "  Number of specified input points: " << nrofpoints << std::endl;
+  elxout << "  Number of specified input points: " << ippReader->GetNumberOfPoints() << std::endl;
 
   /** Get the set of input points. */
   typename PointSetType::Pointer inputPointSet = ippReader->GetOutput();
-
-  /** Create the storage classes. */
-  std::vector< FixedImageIndexType >   inputindexvec(  nrofpoints );
-  std::vector< InputPointType >        inputpointvec(  nrofpoints );
-  std::vector< OutputPointType >       outputpointvec( nrofpoints );
-  std::vector< FixedImageIndexType >   outputindexfixedvec( nrofpoints );
-  std::vector< MovingImageIndexType >  outputindexmovingvec( nrofpoints );
-  std::vector< DeformationVectorType > deformationvec( nrofpoints );
+  const typename PointSetType::PointsContainer * inputPoints = inputPointSet->GetPoints();
+  const unsigned long nrofpoints = inputPoints ? inputPoints->Size() : 0;
 
   /** Make a temporary image with the right region info,
    * which we can use to convert between points and indices.
@@ -1225,10 +1228,6 @@ TransformBase< TElastix >
   dummyImage->SetSpacing( spacing );
   dummyImage->SetDirection( direction );
 
-  /** Temp vars */
-  FixedImageContinuousIndexType  fixedcindex;
-  MovingImageContinuousIndexType movingcindex;
-
   /** Also output moving image indices if a moving image was supplied. */
   bool alsoMovingIndices = false;
   typename MovingImageType::Pointer movingImage = this->GetElastix()->GetMovingImage();
@@ -1237,135 +1236,206 @@ TransformBase< TElastix >
     alsoMovingIndices = true;
   }
 
-  /** Read the input points, as index or as point. */
-  if( !( ippReader->GetPointsAreIndices() ) )
-  {
-    for( unsigned int j = 0; j < nrofpoints; j++ )
-    {
-      /** Compute index of nearest voxel in fixed image. */
-      InputPointType point; point.Fill( 0.0f );
-      inputPointSet->GetPoint( j, &point );
-      inputpointvec[ j ] = point;
-      dummyImage->TransformPhysicalPointToContinuousIndex(
-        point, fixedcindex );
-      for( unsigned int i = 0; i < FixedImageDimension; i++ )
-      {
-        inputindexvec[ j ][ i ] = static_cast< FixedImageIndexValueType >(
-          itk::Math::Round< double >( fixedcindex[ i ] ) );
-      }
-    }
-  }
-  else //so: inputasindex
+  /** Create filename and file stream. The output of a binary input point
+   * file contains only the output points, in the same binary format.
+   */
+  const bool         binaryOutput  = ippReader->GetPointsAreBinary();
+  const unsigned int componentSize = ippReader->GetBinaryComponentSize();
+  std::string        outputPointsFileName = this->m_Configuration
+    ->GetCommandLineArgument( "-out" );
+  outputPointsFileName += binaryOutput ? "outputpoints.bin" : "outputpoints.txt";
+  /** A text file is opened in text mode, so that the line endings are those of the platform. */
+  std::ofstream outputPointsFile( outputPointsFileName.c_str(),
+    binaryOutput ? ( std::ios::out | std::ios::binary ) : std::ios::out );
+  elxout << "  The transformed points are saved in: "
+         <<  outputPointsFileName << std::endl;
+  if( binaryOutput )
   {
-    for( unsigned int j = 0; j < nrofpoints; j++ )
-    {
-      /** The read point from the inutPointSet is actually an index
-       * Cast to the proper type.
-       */
-      InputPointType point; point.Fill( 0.0f );
-      inputPointSet->GetPoint( j, &point );
-      for( unsigned int i = 0; i < FixedImageDimension; i++ )
-      {
-        inputindexvec[ j ][ i ] = static_cast< FixedImageIndexValueType >(
-          itk::Math::Round< double >( point[ i ] ) );
-      }
-      /** Compute the input point in physical coordinates. */
-      dummyImage->TransformIndexToPhysicalPoint(
-        inputindexvec[ j ], inputpointvec[ j ] );
-    }
+    IPPReaderType::WriteBinaryHeader( outputPointsFile, componentSize,
+      MovingImageDimension, false, nrofpoints );
   }
 
-  /** Apply the transform. */
+  /** The points are transformed and formatted in blocks, in parallel. A round
+   * of blocks is written on a background thread while the next round is
+   * processed, so that only two rounds of output are in memory.
+   */
+  const unsigned long       pointsPerBlock  = 4096;
+  const unsigned long       numberOfBlocks  = ( nrofpoints + pointsPerBlock - 1 ) / pointsPerBlock;
+  const itk::ThreadIdType   numberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  const unsigned long       blocksPerRound  = 4 * static_cast< unsigned long >( numberOfThreads );
+  itk::BackgroundTaskQueue::Pointer writeQueue = itk::BackgroundTaskQueue::New();
+
   elxout << "  The input points are transformed." << std::endl;
-  for( unsigned int j = 0; j < nrofpoints; j++ )
+  for( unsigned long firstBlock = 0; firstBlock < numberOfBlocks; firstBlock += blocksPerRound )
   {
-    /** Call TransformPoint. */
-    outputpointvec[ j ] = this->GetAsITKBaseType()->TransformPoint( inputpointvec[ j ] );
-
-    /** Transform back to index in fixed image domain. */
-    dummyImage->TransformPhysicalPointToContinuousIndex(
-      outputpointvec[ j ], fixedcindex );
-    for( unsigned int i = 0; i < FixedImageDimension; i++ )
-    {
-      outputindexfixedvec[ j ][ i ] = static_cast< FixedImageIndexValueType >(
-        itk::Math::Round< double >( fixedcindex[ i ] ) );
-    }
+    const unsigned long numberOfBlocksInRound = std::min( blocksPerRound, numberOfBlocks - firstBlock );
+    const std::shared_ptr< std::vector< std::string > > roundOutput
+      = std::make_shared< std::vector< std::string > >( numberOfBlocksInRound );
 
-    if( alsoMovingIndices )
-    {
-      /** Transform back to index in moving image domain. */
-      movingImage->TransformPhysicalPointToContinuousIndex(
-        outputpointvec[ j ], movingcindex );
-      for( unsigned int i = 0; i < MovingImageDimension; i++ )
+    itk::WorkStealingThreadPool::GetInstance()->ParallelForChunks(
+      numberOfThreads, numberOfBlocksInRound, 1,
+      [ & ]( itk::ThreadIdType, itk::SizeValueType beginBlock, itk::SizeValueType endBlock )
       {
-        outputindexmovingvec[ j ][ i ] = static_cast< MovingImageIndexValueType >(
-          itk::Math::Round< double >( movingcindex[ i ] ) );
-      }
-    }
-
-    /** Compute displacement. */
-    deformationvec[ j ].CastFrom( outputpointvec[ j ] - inputpointvec[ j ] );
+        std::vector< FixedImageIndexType > inputindexvec( pointsPerBlock );
+        std::vector< InputPointType >      inputpointvec( pointsPerBlock );
+        std::vector< OutputPointType >     outputpointvec( pointsPerBlock );
+        FixedImageContinuousIndexType      fixedcindex;
+        MovingImageContinuousIndexType     movingcindex;
+
+        for( itk::SizeValueType b = beginBlock; b < endBlock; ++b )
+        {
+          const unsigned long first  = ( firstBlock + b ) * pointsPerBlock;
+          const unsigned long number = std::min( pointsPerBlock, nrofpoints - first );
+
+          /** Read the input points, as index or as point. */
+          for( unsigned long j = 0; j < number; j++ )
+          {
+            const InputPointType & point = inputPoints->ElementAt( first + j );
+            if( !( ippReader->GetPointsAreIndices() ) )
+            {
+              /** Compute index of nearest voxel in fixed image. */
+              inputpointvec[ j ] = point;
+              dummyImage->TransformPhysicalPointToContinuousIndex(
+                point, fixedcindex );
+              for( unsigned int i = 0; i < FixedImageDimension; i++ )
+              {
+                inputindexvec[ j ][ i ] = static_cast< FixedImageIndexValueType >(
+                  itk::Math::Round< double >( fixedcindex[ i ] ) );
+              }
+            }
+            else
+            {
+              /** The read point is actually an index. Cast to the proper type. */
+              for( unsigned int i = 0; i < FixedImageDimension; i++ )
+              {
+                inputindexvec[ j ][ i ] = static_cast< FixedImageIndexValueType >(
+                  itk::Math::Round< double >( point[ i ] ) );
+              }
+              /** Compute the input point in physical coordinates. */
+              dummyImage->TransformIndexToPhysicalPoint(
+                inputindexvec[ j ], inputpointvec[ j ] );
+            }
+          }
+
+          /** Apply the transform to the whole block. */
+          this->GetAsITKBaseType()->TransformPoints(
+            &inputpointvec[ 0 ], &outputpointvec[ 0 ], number );
+
+          std::string & output = ( *roundOutput )[ b ];
+          if( binaryOutput )
+          {
+            /** Store the output points in little-endian byte order. */
+            output.resize( number * MovingImageDimension * componentSize );
+            char * data = &output[ 0 ];
+            for( unsigned long j = 0; j < number; j++ )
+            {
+              for( unsigned int i = 0; i < MovingImageDimension; i++, data += componentSize )
+              {
+                if( componentSize == 4 )
+                {
+                  float value = static_cast< float >( outputpointvec[ j ][ i ] );
+                  itk::ByteSwapper< float >::SwapFromSystemToLittleEndian( &value );
+                  std::memcpy( data, &value, sizeof( value ) );
+                }
+                else
+                {
+                  double value = static_cast< double >( outputpointvec[ j ][ i ] );
+                  itk::ByteSwapper< double >::SwapFromSystemToLittleEndian( &value );
+                  std::memcpy( data, &value, sizeof( value ) );
+                }
+              }
+            }
+            continue;
+          }
+
+          /** Format the results as text. The numbers are formatted like
+           * std::fixed of std::ostream, but without its per-call overhead.
+           */
+          char       buffer[ 64 ];
+          const auto appendInteger = [ &output, &buffer ]( const long long value )
+          {
+            output.append( buffer, std::snprintf( buffer, sizeof( buffer ), "%lld ", value ) );
+          };
+          const auto appendFloat = [ &output, &buffer ]( const double value )
+          {
+            output.append( buffer, std::snprintf( buffer, sizeof( buffer ), "%.6f ", value ) );
+          };
+          output.reserve( number * 256 );
+          for( unsigned long j = 0; j < number; j++ )
+          {
+            /** The input index. */
+            output.append( buffer, std::snprintf( buffer, sizeof( buffer ), "Point\t%lu", first + j ) );
+            output += "\t; InputIndex = [ ";
+            for( unsigned int i = 0; i < FixedImageDimension; i++ )
+            {
+              appendInteger( inputindexvec[ j ][ i ] );
+            }
+
+            /** The input point. */
+            output += "]\t; InputPoint = [ ";
+            for( unsigned int i = 0; i < FixedImageDimension; i++ )
+            {
+              appendFloat( inputpointvec[ j ][ i ] );
+            }
+
+            /** The output index in fixed image. */
+            output += "]\t; OutputIndexFixed = [ ";
+            dummyImage->TransformPhysicalPointToContinuousIndex(
+              outputpointvec[ j ], fixedcindex );
+            for( unsigned int i = 0; i < FixedImageDimension; i++ )
+            {
+              appendInteger( static_cast< FixedImageIndexValueType >(
+                itk::Math::Round< double >( fixedcindex[ i ] ) ) );
+            }
+
+            /** The output point. */
+            output += "]\t; OutputPoint = [ ";
+            for( unsigned int i = 0; i < FixedImageDimension; i++ )
+            {
+              appendFloat( outputpointvec[ j ][ i ] );
+            }
+
+            /** The output point minus the input point. */
+            output += "]\t; Deformation = [ ";
+            for( unsigned int i = 0; i < MovingImageDimension; i++ )
+            {
+              appendFloat( static_cast< float >( outputpointvec[ j ][ i ] - inputpointvec[ j ][ i ] ) );
+            }
+
+            if( alsoMovingIndices )
+            {
+              /** The output index in moving image. */
+              output += "]\t; OutputIndexMoving = [ ";
+              movingImage->TransformPhysicalPointToContinuousIndex(
+                outputpointvec[ j ], movingcindex );
+              for( unsigned int i = 0; i < MovingImageDimension; i++ )
+              {
+                appendInteger( static_cast< MovingImageIndexValueType >(
+                  itk::Math::Round< double >( movingcindex[ i ] ) ) );
+              }
+            }
+
+            output += "]\n";
+          } // end for points in block
+        } // end for blocks
+      } );
+
+    /** Write this round, while the next one is processed. */
+    writeQueue->Push( [ roundOutput, &outputPointsFile ]()
+      {
+        for( std::size_t b = 0; b < roundOutput->size(); ++b )
+        {
+          outputPointsFile.write( ( *roundOutput )[ b ].data(), ( *roundOutput )[ b ].size() );
+        }
+      } );
   }
+  writeQueue->Wait();
 
-  /** Create filename and file stream. */
-  std::string outputPointsFileName = this->m_Configuration
-    ->GetCommandLineArgument( "-out" );
-  outputPointsFileName += "outputpoints.txt";
-  std::ofstream outputPointsFile( outputPointsFileName.c_str() );
-  outputPointsFile << std::showpoint << std::fixed;
-  elxout << "  The transformed points are saved in: "
-         <<  outputPointsFileName << std::endl;
-
-  /** Print the results. */
-  for( unsigned int j = 0; j < nrofpoints; j++ )
+  if( !outputPointsFile )
   {
-    /** The input index. */
-    outputPointsFile << "Point\t" << j << "\t; InputIndex = [ ";
-    for( unsigned int i = 0; i < FixedImageDimension; i++ )
-    {
-      outputPointsFile << inputindexvec[ j ][ i ] << " ";
-    }
-
-    /** The input point. */
-    outputPointsFile << "]\t; InputPoint = [ ";
-    for( unsigned int i = 0; i < FixedImageDimension; i++ )
-    {
-      outputPointsFile << inputpointvec[ j ][ i ] << " ";
-    }
-
-    /** The output index in fixed image. */
-    outputPointsFile << "]\t; OutputIndexFixed = [ ";
-    for( unsigned int i = 0; i < FixedImageDimension; i++ )
-    {
-      outputPointsFile << outputindexfixedvec[ j ][ i ] << " ";
-    }
-
-    /** The output point. */
-    outputPointsFile << "]\t; OutputPoint = [ ";
-    for( unsigned int i = 0; i < FixedImageDimension; i++ )
-    {
-      outputPointsFile << outputpointvec[ j ][ i ] << " ";
-    }
-
-    /** The output point minus the input point. */
-    outputPointsFile << "]\t; Deformation = [ ";
-    for( unsigned int i = 0; i < MovingImageDimension; i++ )
-    {
-      outputPointsFile << deformationvec[ j ][ i ] << " ";
-    }
-
-    if( alsoMovingIndices )
-    {
-      /** The output index in moving image. */
-      outputPointsFile << "]\t; OutputIndexMoving = [ ";
-      for( unsigned int i = 0; i < MovingImageDimension; i++ )
-      {
-        outputPointsFile << outputindexmovingvec[ j ][ i ] << " ";
-      }
-    }
-
-    outputPointsFile << "]" << std::endl;
-  } // end for nrofpoints
+    itkExceptionMacro( << "ERROR: could not write the transformed points to "
+                       << outputPointsFileName );
+  }
 
 } // end TransformPointsSomePoints()
 
@@ -1469,6 +1539,19 @@ void
 TransformBase< TElastix >
 ::TransformPointsAllPoints( void ) const
 {
+#ifndef _ELASTIX_BUILD_LIBRARY
+  /** The executable does not return the deformation field, so it may be
+   * written piece by piece when it is large.
+   */
+  const unsigned int numberOfStreamDivisions = this->GetNumberOfStreamDivisions(
+    sizeof( typename DeformationFieldImageType::PixelType ) );
+  if( numberOfStreamDivisions > 1 )
+  {
+    this->WriteDeformationFieldImageStreamed( numberOfStreamDivisions );
+    return;
+  }
+#endif
+
   typename DeformationFieldImageType::Pointer deformationfield = this->GenerateDeformationFieldImage();
   //put deformation field in container
   this->m_Elastix->SetResultDeformationField( deformationfield.GetPointer() );
@@ -1493,37 +1576,10 @@ typename TransformBase< TElastix >::DeformationFieldImageType::Pointer
 TransformBase< TElastix >
 ::GenerateDeformationFieldImage( void ) const
 {
-  /** Typedef's. */
-  typedef typename FixedImageType::DirectionType FixedImageDirectionType;
-  typedef itk::TransformToDisplacementFieldFilter<
-    DeformationFieldImageType, CoordRepType >         DeformationFieldGeneratorType;
-  typedef itk::ChangeInformationImageFilter<
-    DeformationFieldImageType >                       ChangeInfoFilterType;
-
-  /** Create an setup deformation field generator. */
-  typename DeformationFieldGeneratorType::Pointer defGenerator
-    = DeformationFieldGeneratorType::New();
-  defGenerator->SetSize(
-    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetSize() );
-  defGenerator->SetOutputSpacing(
-    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputSpacing() );
-  defGenerator->SetOutputOrigin(
-    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputOrigin() );
-  defGenerator->SetOutputStartIndex(
-    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputStartIndex() );
-  defGenerator->SetOutputDirection(
-    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputDirection() );
-  defGenerator->SetTransform( const_cast< const ITKBaseType * >( this->GetAsITKBaseType() ) );
-
-  /** Possibly change direction cosines to their original value, as specified
-   * in the tp-file, or by the fixed image. This is only necessary when
-   * the UseDirectionCosines flag was set to false. */
-  typename ChangeInfoFilterType::Pointer infoChanger = ChangeInfoFilterType::New();
-  FixedImageDirectionType originalDirection;
-  bool                    retdc = this->GetElastix()->GetOriginalFixedImageDirection( originalDirection );
-  infoChanger->SetOutputDirection( originalDirection );
-  infoChanger->SetChangeDirection( retdc & !this->GetElastix()->GetUseDirectionCosines() );
-  infoChanger->SetInput( defGenerator->GetOutput() );
+  /** Create and setup the deformation field generator. */
+  typename DeformationFieldGeneratorType::Pointer   defGenerator;
+  typename DeformationFieldInfoChangerType::Pointer infoChanger
+    = this->CreateDeformationFieldPipeline( defGenerator );
 
   /** Track the progress of the generation of the deformation field. */
 #ifndef _ELASTIX_BUILD_LIBRARY
@@ -1599,6 +1655,151 @@ WriteDeformationFieldImage(
 } // end WriteDeformationFieldImage()
 
 
+/**
+ * ************** WriteDeformationFieldImageStreamed **********************
+ */
+
+template< class TElastix >
+void
+TransformBase< TElastix >
+::WriteDeformationFieldImageStreamed( const unsigned int numberOfStreamDivisions ) const
+{
+  /** Typedef's. */
+  typedef itk::ImageFileWriter<
+    DeformationFieldImageType >                       DeformationFieldWriterType;
+
+  /** Create and setup the deformation field generator. */
+  typename DeformationFieldGeneratorType::Pointer   defGenerator;
+  typename DeformationFieldInfoChangerType::Pointer infoChanger
+    = this->CreateDeformationFieldPipeline( defGenerator );
+
+  /** Create a name for the deformation field file. */
+  std::string resultImageFormat = "mhd";
+  this->m_Configuration->ReadParameter( resultImageFormat, "ResultImageFormat", 0, false );
+  std::ostringstream makeFileName( "" );
+  makeFileName << this->m_Configuration->GetCommandLineArgument( "-out" )
+               << "deformationField." << resultImageFormat;
+
+  /** Generate and write the field piece by piece. The writer generates it at
+   * once when the file format does not support streamed writing.
+   */
+  typename DeformationFieldWriterType::Pointer defWriter
+    = DeformationFieldWriterType::New();
+  defWriter->SetInput( infoChanger->GetOutput() );
+  defWriter->SetFileName( makeFileName.str().c_str() );
+  defWriter->SetNumberOfStreamDivisions( numberOfStreamDivisions );
+
+  /** Track the progress of the writer, which covers all pieces. */
+  typename ProgressCommandType::Pointer progressObserver = ProgressCommandType::New();
+  progressObserver->ConnectObserver( defWriter );
+  progressObserver->SetStartString( "  Progress: " );
+  progressObserver->SetEndString( "%" );
+
+  /** Do the writing. */
+  elxout << "  Computing and writing the deformation field in "
+         << numberOfStreamDivisions << " pieces ..." << std::endl;
+  try
+  {
+    defWriter->Update();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    /** Add information to the exception. */
+    excp.SetLocation( "TransformBase - WriteDeformationFieldImageStreamed()" );
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError occurred while writing deformation field image.\n";
+    excp.SetDescription( err_str );
+
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+
+} // end WriteDeformationFieldImageStreamed()
+
+
+/**
+ * ************** CreateDeformationFieldPipeline **********************
+ */
+
+template< class TElastix >
+typename TransformBase< TElastix >::DeformationFieldInfoChangerType::Pointer
+TransformBase< TElastix >
+::CreateDeformationFieldPipeline(
+  typename DeformationFieldGeneratorType::Pointer & defGenerator ) const
+{
+  /** Typedef's. */
+  typedef typename FixedImageType::DirectionType FixedImageDirectionType;
+
+  /** Create and setup the deformation field generator. */
+  defGenerator = DeformationFieldGeneratorType::New();
+  defGenerator->SetOutputSize(
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetSize() );
+  defGenerator->SetOutputSpacing(
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputSpacing() );
+  defGenerator->SetOutputOrigin(
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputOrigin() );
+  defGenerator->SetOutputIndex(
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputStartIndex() );
+  defGenerator->SetOutputDirection(
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputDirection() );
+  defGenerator->SetTransform( const_cast< const ITKBaseType * >( this->GetAsITKBaseType() ) );
+
+  /** Possibly change direction cosines to their original value, as specified
+   * in the tp-file, or by the fixed image. This is only necessary when
+   * the UseDirectionCosines flag was set to false. */
+  typename DeformationFieldInfoChangerType::Pointer infoChanger = DeformationFieldInfoChangerType::New();
+  FixedImageDirectionType originalDirection;
+  bool                    retdc = this->GetElastix()->GetOriginalFixedImageDirection( originalDirection );
+  infoChanger->SetOutputDirection( originalDirection );
+  infoChanger->SetChangeDirection( retdc & !this->GetElastix()->GetUseDirectionCosines() );
+  infoChanger->SetInput( defGenerator->GetOutput() );
+
+  return infoChanger;
+
+} // end CreateDeformationFieldPipeline()
+
+
+/**
+ * ************** GetNumberOfStreamDivisions **********************
+ */
+
+template< class TElastix >
+unsigned int
+TransformBase< TElastix >
+::GetNumberOfStreamDivisions( const std::size_t bytesPerPixel ) const
+{
+  /** Read the streaming parameters, shared with the resampler. */
+  unsigned int numberOfDivisions = 1;
+  this->m_Configuration->ReadParameter( numberOfDivisions,
+    "ResampleStreamingDivisions", 0, false );
+  double maximumMemory = 0.0;
+  this->m_Configuration->ReadParameter( maximumMemory,
+    "ResampleStreamingMaximumMemory", 0, false );
+
+  /** Only one piece is in memory at a time, as the generators and the
+   * ChangeInformationImageFilter do not copy their output.
+   */
+  const typename FixedImageType::SizeType size
+    = this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetSize();
+  if( maximumMemory > 0.0 )
+  {
+    double numberOfPixels = 1.0;
+    for( unsigned int i = 0; i < FixedImageDimension; ++i )
+    {
+      numberOfPixels *= static_cast< double >( size[ i ] );
+    }
+    const double bytes = numberOfPixels * static_cast< double >( bytesPerPixel );
+    const double divisions = std::ceil( bytes / ( maximumMemory * 1024.0 * 1024.0 ) );
+    numberOfDivisions = std::max( numberOfDivisions, static_cast< unsigned int >(
+      std::min( divisions, static_cast< double >( size[ FixedImageDimension - 1 ] ) ) ) );
+  }
+
+  return std::max( 1u, std::min( numberOfDivisions,
+    static_cast< unsigned int >( size[ FixedImageDimension - 1 ] ) ) );
+
+} // end GetNumberOfStreamDivisions()
+
+
 /**
  * ************** ComputeDeterminantOfSpatialJacobian **********************
  */
@@ -1680,6 +1881,8 @@ TransformBase< TElastix >
   typename JacobianWriterType::Pointer jacWriter = JacobianWriterType::New();
   jacWriter->SetInput( infoChanger->GetOutput() );
   jacWriter->SetFileName( makeFileName.str().c_str() );
+  jacWriter->SetNumberOfStreamDivisions( this->GetNumberOfStreamDivisions(
+    sizeof( typename JacobianImageType::PixelType ) ) );
 
   /** Do the writing. */
   elxout << "  Computing and writing the spatial Jacobian determinant..." << std::endl;
@@ -1783,6 +1986,8 @@ TransformBase< TElastix >
   typename JacobianWriterType::Pointer jacWriter = JacobianWriterType::New();
   jacWriter->SetInput( infoChanger->GetOutput() );
   jacWriter->SetFileName( makeFileName.str().c_str() );
+  jacWriter->SetNumberOfStreamDivisions( this->GetNumberOfStreamDivisions(
+    sizeof( typename JacobianImageType::PixelType ) ) );
   /** Hack to change the pixel type to vector. Not necessary for mhd. */
   typename PixelTypeChangeCommandType::Pointer jacStartWriteCommand
     = PixelTypeChangeCommandType::New();
@@ -149,8 +149,10 @@ Configuration
     return 1;
   }
 
-  /** Read the ParameterFile. */
+  /** Read the ParameterFile, through the parse cache if "-parcache" is given. */
   this->m_ParameterFileParser->SetParameterFileName( this->m_ParameterFileName );
+  this->m_ParameterFileParser->SetParseCacheDirectory(
+    this->GetCommandLineArgument( "-parcache" ) );
   try
   {
     xl::xout[ "standard" ] << "Reading the elastix parameters from file ...\n" << std::endl;
@@ -69,6 +69,8 @@ ElastixBase::ElastixBase()
    * backward compatability. From Elastix 4.8: set it to true by default.*/
   this->m_UseDirectionCosines = true;
 
+  this->m_UseMemoryMappedImages = true;
+
 } // end Constructor
 
 
@@ -234,6 +236,11 @@ ElastixBase::BeforeAllBase( void )
       << std::endl;
   }
 
+  /** Check whether input images may be mapped into memory. */
+  this->m_UseMemoryMappedImages = true;
+  this->GetConfiguration()->ReadParameter( this->m_UseMemoryMappedImages,
+    "UseMemoryMappedImages", 0, false );
+
   /** Set the random seed. Use 121212 as a default, which is the same as
    * the default in the MersenneTwister code.
    * Use silent parameter file readout, to avoid annoying warning when
@@ -331,6 +338,11 @@ ElastixBase::BeforeAllTransformixBase( void )
       << std::endl;
   }
 
+  /** Check whether input images may be mapped into memory. */
+  this->m_UseMemoryMappedImages = true;
+  this->GetConfiguration()->ReadParameter( this->m_UseMemoryMappedImages,
+    "UseMemoryMappedImages", 0, false );
+
   return returndummy;
 
 } // end BeforeAllTransformixBase()
@@ -467,6 +479,17 @@ ElastixBase::GetUseDirectionCosines( void ) const
 }
 
 
+/**
+ * ******************** GetUseMemoryMappedImages ********************
+ */
+
+bool
+ElastixBase::GetUseMemoryMappedImages( void ) const
+{
+  return this->m_UseMemoryMappedImages;
+}
+
+
 /**
  * ******************** SetOriginalFixedImageDirectionFlat ********************
  */
@@ -36,7 +36,7 @@
 #include "elxMacro.h"
 #include "xoutmain.h"
 #include "itkVectorContainer.h"
-#include "itkImageFileReader.h"
+#include "itkMemoryMappedImageFileReader.h"
 #include "itkChangeInformationImageFilter.h"
 
 #include <fstream>
@@ -348,6 +348,11 @@ public:
    * parameter. */
   virtual bool GetUseDirectionCosines( void ) const;
 
+  /** Get whether input images may be mapped into memory instead of read.
+   * This depends on the UseMemoryMappedImages parameter.
+   */
+  virtual bool GetUseMemoryMappedImages( void ) const;
+
   /** Set/Get the original fixed image direction as a flat array
    * (d11 d21 d31 d21 d22 etc ) */
   virtual void SetOriginalFixedImageDirectionFlat(
@@ -386,6 +391,12 @@ protected:
    * The useDirection option is built in as a means to ignore the direction
    * cosines. Set it to false to force the direction cosines to identity.
    * The original direction cosines are returned separately.
+   *
+   * The useMemoryMapping option lets the reader map uncompressed raw data,
+   * whose pixel type and byte order match the image type, directly into
+   * memory, and convert other images in slabs, see
+   * itk::MemoryMappedImageFileReader. Without it the image is read as by
+   * the itk::ImageFileReader.
    */
   template< class TImage >
   class MultipleImageLoader
@@ -394,7 +405,7 @@ public:
 
     typedef TImage                                         ImageType;
     typedef typename ImageType::Pointer                    ImagePointer;
-    typedef itk::ImageFileReader< ImageType >              ImageReaderType;
+    typedef itk::MemoryMappedImageFileReader< ImageType >  ImageReaderType;
     typedef typename ImageReaderType::Pointer              ImageReaderPointer;
     typedef typename ImageType::DirectionType              DirectionType;
     typedef itk::ChangeInformationImageFilter< ImageType > ChangeInfoFilterType;
@@ -402,7 +413,8 @@ public:
 
     static DataObjectContainerPointer GenerateImageContainer(
       FileNameContainerType * fileNameContainer, const std::string & imageDescription,
-      bool useDirectionCosines, DirectionType * originalDirectionCosines = NULL )
+      bool useDirectionCosines, DirectionType * originalDirectionCosines = NULL,
+      bool useMemoryMapping = false )
     {
       DataObjectContainerPointer imageContainer = DataObjectContainerType::New();
 
@@ -412,6 +424,8 @@ public:
         /** Setup reader. */
         ImageReaderPointer imageReader = ImageReaderType::New();
         imageReader->SetFileName( fileNameContainer->ElementAt( i ).c_str() );
+        imageReader->SetUseMemoryMapping( useMemoryMapping );
+        imageReader->SetUseStreamingConversion( useMemoryMapping );
         ChangeInfoFilterPointer infoChanger = ChangeInfoFilterType::New();
         DirectionType           direction;
         direction.SetIdentity();
@@ -546,6 +560,9 @@ private:
   /** Use or ignore direction cosines. */
   bool m_UseDirectionCosines;
 
+  /** Map input images into memory, if possible. */
+  bool m_UseMemoryMappedImages;
+
   /** Read a series of command line options that satisfy the following syntax:
    * {-f,-f0} \<filename0\> [-f1 \<filename1\> [ -f2 \<filename2\> ... ] ]
    *
@@ -106,6 +106,17 @@ namespace elastix
  *  image, which relates voxel coordinates to world coordinates. Ignoring it
  *  may easily lead to left/right swaps for example, which could skrew up a
  *  (medical) analysis.
+ * \parameter UseMemoryMappedImages: Controls whether input images may be
+ *    mapped into memory instead of read. This is done for uncompressed
+ *    MetaImage, NRRD and MevisDicomTiff files whose pixel type and byte order
+ *    match the internal pixel type. The file pages are then shared with the
+ *    file cache and loaded on demand, which lowers the peak memory usage and
+ *    the time to start. Other files are converted in slabs if the file format
+ *    supports it. With "false" all images are read as before, in one piece.
+ *    A mapped file must not be changed while elastix runs: a result image
+ *    that would overwrite an input image is refused.\n
+ *    example: <tt>(UseMemoryMappedImages "false")</tt>\n
+ *    Default value: "true".
  *
  * \ingroup Kernel
  */
@@ -256,12 +256,13 @@ ElastixTemplate< TFixedImage, TMovingImage >
 
   /** Read images and masks, if not set already. */
   const bool              useDirCos = this->GetUseDirectionCosines();
+  const bool              useMMap   = this->GetUseMemoryMappedImages();
   FixedImageDirectionType fixDirCos;
   if( this->GetFixedImage() == 0 )
   {
     this->SetFixedImageContainer(
       FixedImageLoaderType::GenerateImageContainer(
-      this->GetFixedImageFileNameContainer(), "Fixed Image", useDirCos, &fixDirCos ) );
+      this->GetFixedImageFileNameContainer(), "Fixed Image", useDirCos, &fixDirCos, useMMap ) );
     this->SetOriginalFixedImageDirection( fixDirCos );
   }
   else
@@ -281,19 +282,19 @@ ElastixTemplate< TFixedImage, TMovingImage >
   {
     this->SetMovingImageContainer(
       MovingImageLoaderType::GenerateImageContainer(
-      this->GetMovingImageFileNameContainer(), "Moving Image", useDirCos ) );
+      this->GetMovingImageFileNameContainer(), "Moving Image", useDirCos, NULL, useMMap ) );
   }
   if( this->GetFixedMask() == 0 )
   {
     this->SetFixedMaskContainer(
       FixedMaskLoaderType::GenerateImageContainer(
-      this->GetFixedMaskFileNameContainer(), "Fixed Mask", useDirCos ) );
+      this->GetFixedMaskFileNameContainer(), "Fixed Mask", useDirCos, NULL, useMMap ) );
   }
   if( this->GetMovingMask() == 0 )
   {
     this->SetMovingMaskContainer(
       MovingMaskLoaderType::GenerateImageContainer(
-      this->GetMovingMaskFileNameContainer(), "Moving Mask", useDirCos ) );
+      this->GetMovingMaskFileNameContainer(), "Moving Mask", useDirCos, NULL, useMMap ) );
   }
 
   /** Print the time spent on reading images. */
@@ -395,11 +396,12 @@ ElastixTemplate< TFixedImage, TMovingImage >
 
     /** Load the image from disk, if it wasn't set already by the user. */
     const bool useDirCos = this->GetUseDirectionCosines();
+    const bool useMMap   = this->GetUseMemoryMappedImages();
     if( this->GetMovingImage() == 0 )
     {
       this->SetMovingImageContainer(
         MovingImageLoaderType::GenerateImageContainer(
-        this->GetMovingImageFileNameContainer(), "Input Image", useDirCos ) );
+        this->GetMovingImageFileNameContainer(), "Input Image", useDirCos, NULL, useMMap ) );
     } // end if !moving image
 
     /** Tell the user. */
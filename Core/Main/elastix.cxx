@@ -364,7 +364,9 @@ PrintHelp( void )
   std::cout << "  -t0       parameter file for initial transform\n";
   std::cout << "  -priority set the process priority to high, abovenormal, normal (default),\n"
             << "            belownormal, or idle (Windows only option)\n";
-  std::cout << "  -threads  set the maximum number of threads of elastix\n"
+  std::cout << "  -threads  set the maximum number of threads of elastix\n";
+  std::cout << "  -parcache directory in which the parsed parameter files are cached,\n"
+            << "            to skip parsing them again in a next call\n"
             << std::endl;
 
   /** The parameter file.*/
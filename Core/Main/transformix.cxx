@@ -269,6 +269,8 @@ PrintHelp( void )
   std::cout << "  -priority set the process priority to high, abovenormal, normal (default),\n"
             << "            belownormal, or idle (Windows only option)\n";
   std::cout << "  -threads  set the maximum number of threads of transformix\n";
+  std::cout << "  -parcache directory in which the parsed parameter files are cached,\n"
+            << "            to skip parsing them again in a next call\n";
   std::cout << "\nAt least one of the options \"-in\", \"-def\", \"-jac\", or \"-jacmat\" should be given.\n"
             << std::endl;
 
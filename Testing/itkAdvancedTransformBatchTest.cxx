@@ -0,0 +1,378 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+/** \file
+ \brief Compare the batch functions of the advanced transforms with their single point versions,
+ and the folded chain of a combination transform with the original one.
+ */
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkRecursiveBSplineTransform.h"
+#include "itkAdvancedMatrixOffsetTransformBase.h"
+#include "itkAdvancedCombinationTransform.h"
+#include "itkAdvancedTranslationTransform.h"
+
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTimeProbe.h"
+
+#include <cmath>
+#include <iomanip>
+#include <vector>
+
+const unsigned int Dimension = 3;
+typedef double                                                   CoordinateRepresentationType;
+typedef itk::AdvancedTransform<
+  CoordinateRepresentationType, Dimension, Dimension >           AdvancedTransformType;
+typedef AdvancedTransformType::InputPointType                   InputPointType;
+typedef AdvancedTransformType::OutputPointType                  OutputPointType;
+typedef AdvancedTransformType::JacobianType                     JacobianType;
+typedef AdvancedTransformType::DerivativeType                   DerivativeType;
+typedef AdvancedTransformType::NonZeroJacobianIndicesType       NonZeroJacobianIndicesType;
+typedef AdvancedTransformType::NonZeroJacobianIndicesValueType  NonZeroJacobianIndicesValueType;
+typedef AdvancedTransformType::MovingImageGradientType          MovingImageGradientType;
+typedef AdvancedTransformType::ParametersValueType              ParametersValueType;
+typedef itk::Statistics::MersenneTwisterRandomVariateGenerator  MersenneTwisterType;
+
+//-------------------------------------------------------------------------------------
+
+// Compare the batch functions of a transform with the single point versions
+bool
+CompareBatch( const AdvancedTransformType * transform, const char * name,
+  const std::vector< InputPointType > & points,
+  const std::vector< MovingImageGradientType > & gradients )
+{
+  const double              tolerance = 1e-10;
+  const itk::SizeValueType  n         = points.size();
+  const itk::SizeValueType  nnzji     = transform->GetNumberOfNonZeroJacobianIndices();
+
+  /** Compute the batch results. */
+  std::vector< OutputPointType >                 outputPoints( n );
+  std::vector< ParametersValueType >             jacobians( n * Dimension * nnzji );
+  std::vector< NonZeroJacobianIndicesValueType > nzjis( n * nnzji );
+  std::vector< ParametersValueType >             imageJacobians( n * nnzji );
+  std::vector< NonZeroJacobianIndicesValueType > nzjis2( n * nnzji );
+
+  itk::TimeProbe timerBatch, timerSingle;
+  timerBatch.Start();
+  transform->TransformPoints( &points[ 0 ], &outputPoints[ 0 ], n );
+  transform->GetJacobians( &points[ 0 ], n, &jacobians[ 0 ], &nzjis[ 0 ] );
+  transform->EvaluateJacobianWithImageGradientProducts(
+    &points[ 0 ], &gradients[ 0 ], n, &imageJacobians[ 0 ], &nzjis2[ 0 ] );
+  timerBatch.Stop();
+
+  /** Compare with the single point versions. */
+  timerSingle.Start();
+  for( itk::SizeValueType i = 0; i < n; ++i )
+  {
+    const OutputPointType      outputPoint = transform->TransformPoint( points[ i ] );
+    JacobianType               jacobian( Dimension, nnzji );
+    DerivativeType             imageJacobian( nnzji );
+    NonZeroJacobianIndicesType nzji( nnzji ), nzji2( nnzji );
+    jacobian.Fill( 0.0 );
+    imageJacobian.Fill( 0.0 );
+    transform->GetJacobian( points[ i ], jacobian, nzji );
+    transform->EvaluateJacobianWithImageGradientProduct(
+      points[ i ], gradients[ i ], imageJacobian, nzji2 );
+
+    if( outputPoint.EuclideanDistanceTo( outputPoints[ i ] ) > tolerance )
+    {
+      std::cerr << "ERROR: " << name << " TransformPoints() differs at point " << i << std::endl;
+      return false;
+    }
+    for( itk::SizeValueType j = 0; j < Dimension * nnzji; ++j )
+    {
+      if( std::abs( jacobian.data_block()[ j ] - jacobians[ i * Dimension * nnzji + j ] ) > tolerance )
+      {
+        std::cerr << "ERROR: " << name << " GetJacobians() differs at point " << i << std::endl;
+        return false;
+      }
+    }
+    for( itk::SizeValueType j = 0; j < nnzji; ++j )
+    {
+      if( std::abs( imageJacobian[ j ] - imageJacobians[ i * nnzji + j ] ) > tolerance )
+      {
+        std::cerr << "ERROR: " << name << " EvaluateJacobianWithImageGradientProducts() differs at point " << i << std::endl;
+        return false;
+      }
+      if( nzji[ j ] != nzjis[ i * nnzji + j ] || nzji2[ j ] != nzjis2[ i * nnzji + j ] )
+      {
+        std::cerr << "ERROR: " << name << " nonzero Jacobian indices differ at point " << i << std::endl;
+        return false;
+      }
+    }
+  }
+  timerSingle.Stop();
+
+  /** The batch TransformPoints() should work in place. */
+  std::vector< OutputPointType > inPlace( points.begin(), points.end() );
+  transform->TransformPoints( &inPlace[ 0 ], &inPlace[ 0 ], n );
+  for( itk::SizeValueType i = 0; i < n; ++i )
+  {
+    if( inPlace[ i ].EuclideanDistanceTo( outputPoints[ i ] ) > tolerance )
+    {
+      std::cerr << "ERROR: " << name << " in place TransformPoints() differs at point " << i << std::endl;
+      return false;
+    }
+  }
+
+  std::cerr << std::fixed << std::setprecision( 3 )
+            << name << ": batch " << timerBatch.GetMean() * 1000.0
+            << " ms, single point (including checks) "
+            << timerSingle.GetMean() * 1000.0 << " ms" << std::endl;
+  return true;
+
+} // end CompareBatch()
+
+//-------------------------------------------------------------------------------------
+
+// Compare the folded chain of a combination transform with the original chain
+template< class TCombinationTransform >
+bool
+CompareFoldedChain( TCombinationTransform * transform, const char * name,
+  const itk::SizeValueType expectedNumberOfStages,
+  const std::vector< InputPointType > & points )
+{
+  const double             tolerance = 1e-8;
+  const itk::SizeValueType n         = points.size();
+
+  /** Transform the points with the original chain, fold it, and compare. */
+  std::vector< OutputPointType > outputPoints( n );
+  for( itk::SizeValueType i = 0; i < n; ++i )
+  {
+    outputPoints[ i ] = transform->TransformPoint( points[ i ] );
+  }
+
+  transform->FoldTransformChain();
+  if( !transform->GetTransformChainIsFolded()
+    || transform->GetNumberOfFoldedStages() != expectedNumberOfStages )
+  {
+    std::cerr << "ERROR: " << name << " folded into " << transform->GetNumberOfFoldedStages()
+              << " stages instead of " << expectedNumberOfStages << std::endl;
+    return false;
+  }
+
+  std::vector< OutputPointType > foldedPoints( n );
+  transform->TransformPoints( &points[ 0 ], &foldedPoints[ 0 ], n );
+  for( itk::SizeValueType i = 0; i < n; ++i )
+  {
+    if( transform->TransformPoint( points[ i ] ).EuclideanDistanceTo( outputPoints[ i ] ) > tolerance
+      || foldedPoints[ i ].EuclideanDistanceTo( outputPoints[ i ] ) > tolerance )
+    {
+      std::cerr << "ERROR: " << name << " folded chain differs at point " << i << std::endl;
+      return false;
+    }
+  }
+
+  /** Setting the parameters should unfold the chain. */
+  transform->SetParameters( transform->GetParameters() );
+  if( transform->GetTransformChainIsFolded() )
+  {
+    std::cerr << "ERROR: " << name << " is still folded after SetParameters()" << std::endl;
+    return false;
+  }
+
+  std::cerr << name << ": folded chain is good" << std::endl;
+  return true;
+
+} // end CompareFoldedChain()
+
+//-------------------------------------------------------------------------------------
+
+// A combination transform that overrides TransformPoint(), like the
+// DeformationFieldRegulizer, which adds an intermediary deformation field.
+class ShiftedCombinationTransform :
+  public itk::AdvancedCombinationTransform< CoordinateRepresentationType, Dimension >
+{
+public:
+
+  typedef ShiftedCombinationTransform    Self;
+  typedef itk::AdvancedCombinationTransform<
+    CoordinateRepresentationType, Dimension > Superclass;
+  typedef itk::SmartPointer< Self >      Pointer;
+
+  itkNewMacro( Self );
+  itkTypeMacro( ShiftedCombinationTransform, AdvancedCombinationTransform );
+
+  OutputPointType TransformPoint( const InputPointType & point ) const override
+  {
+    OutputPointType outputPoint = Superclass::TransformPoint( point );
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      outputPoint[ d ] += 1.5 + d;
+    }
+    return outputPoint;
+  }
+
+protected:
+
+  ShiftedCombinationTransform() {}
+  ~ShiftedCombinationTransform() override {}
+
+  bool GetTransformChainIsFoldable( void ) const override { return false; }
+
+};
+
+//-------------------------------------------------------------------------------------
+
+// Set up the grid and random coefficients of a B-spline transform
+template< class TBSplineTransform >
+void
+SetupBSplineTransform( TBSplineTransform * transform, MersenneTwisterType * randomGenerator )
+{
+  typename TBSplineTransform::RegionType    gridRegion;
+  typename TBSplineTransform::SizeType      gridSize;
+  typename TBSplineTransform::SpacingType   gridSpacing;
+  typename TBSplineTransform::OriginType    gridOrigin;
+  typename TBSplineTransform::DirectionType gridDirection;
+  gridSize.Fill( 12 );
+  gridRegion.SetSize( gridSize );
+  gridSpacing.Fill( 10.0 );
+  gridOrigin.Fill( -20.0 );
+  gridDirection.SetIdentity();
+  gridDirection( 0, 1 ) = 0.02;
+  gridDirection( 1, 2 ) = 0.05;
+
+  transform->SetGridRegion( gridRegion );
+  transform->SetGridSpacing( gridSpacing );
+  transform->SetGridOrigin( gridOrigin );
+  transform->SetGridDirection( gridDirection );
+
+  typename TBSplineTransform::ParametersType parameters( transform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+  {
+    parameters[ i ] = randomGenerator->GetUniformVariate( -3.0, 3.0 );
+  }
+  transform->SetParametersByValue( parameters );
+
+} // end SetupBSplineTransform()
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  typedef itk::AdvancedBSplineDeformableTransform<
+    CoordinateRepresentationType, Dimension, 3 >                BSplineTransformType;
+  typedef itk::RecursiveBSplineTransform<
+    CoordinateRepresentationType, Dimension, 3 >                RecursiveBSplineTransformType;
+  typedef itk::AdvancedMatrixOffsetTransformBase<
+    CoordinateRepresentationType, Dimension, Dimension >        AffineTransformType;
+  typedef itk::AdvancedCombinationTransform<
+    CoordinateRepresentationType, Dimension >                   CombinationTransformType;
+  typedef itk::AdvancedTranslationTransform<
+    CoordinateRepresentationType, Dimension >                   TranslationTransformType;
+
+  MersenneTwisterType::Pointer randomGenerator = MersenneTwisterType::GetInstance();
+  randomGenerator->SetSeed( 5678 );
+
+  /** Random points, partly outside the valid region of the B-spline grid,
+   * and random moving image gradients.
+   */
+  const unsigned int                     numberOfPoints = 1000;
+  std::vector< InputPointType >          points( numberOfPoints );
+  std::vector< MovingImageGradientType > gradients( numberOfPoints );
+  for( unsigned int i = 0; i < numberOfPoints; ++i )
+  {
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      points[ i ][ d ]    = randomGenerator->GetUniformVariate( -25.0, 105.0 );
+      gradients[ i ][ d ] = randomGenerator->GetUniformVariate( -1.0, 1.0 );
+    }
+  }
+
+  /** Create the transforms. */
+  BSplineTransformType::Pointer bsplineTransform = BSplineTransformType::New();
+  SetupBSplineTransform( bsplineTransform.GetPointer(), randomGenerator.GetPointer() );
+
+  RecursiveBSplineTransformType::Pointer recursiveTransform = RecursiveBSplineTransformType::New();
+  SetupBSplineTransform( recursiveTransform.GetPointer(), randomGenerator.GetPointer() );
+
+  AffineTransformType::Pointer affineTransform = AffineTransformType::New();
+  AffineTransformType::ParametersType affineParameters( affineTransform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < affineParameters.GetSize(); ++i )
+  {
+    affineParameters[ i ] = randomGenerator->GetUniformVariate( -0.2, 0.2 );
+  }
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    affineParameters[ d * Dimension + d ] += 1.0;
+  }
+  affineTransform->SetParameters( affineParameters );
+
+  CombinationTransformType::Pointer compositionTransform = CombinationTransformType::New();
+  compositionTransform->SetInitialTransform( affineTransform );
+  compositionTransform->SetCurrentTransform( recursiveTransform );
+  compositionTransform->SetUseComposition( true );
+
+  CombinationTransformType::Pointer additionTransform = CombinationTransformType::New();
+  additionTransform->SetInitialTransform( affineTransform );
+  additionTransform->SetCurrentTransform( bsplineTransform );
+  additionTransform->SetUseAddition( true );
+
+  /** The batch functions should use the TransformPoint() of the subclass. */
+  ShiftedCombinationTransform::Pointer shiftedTransform = ShiftedCombinationTransform::New();
+  shiftedTransform->SetInitialTransform( affineTransform );
+  shiftedTransform->SetCurrentTransform( recursiveTransform );
+  shiftedTransform->SetUseComposition( true );
+
+  /** A chain as read from transform parameter files:
+   * affine -> translation -> affine -> B-spline -> affine.
+   */
+  TranslationTransformType::Pointer translationTransform = TranslationTransformType::New();
+  TranslationTransformType::ParametersType translationParameters( Dimension );
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    translationParameters[ d ] = randomGenerator->GetUniformVariate( -5.0, 5.0 );
+  }
+  translationTransform->SetParameters( translationParameters );
+
+  AffineTransformType::Pointer affineTransform2 = AffineTransformType::New();
+  affineTransform2->SetParameters( affineParameters );
+  affineTransform2->SetCenter( points[ 0 ] );
+
+  std::vector< CombinationTransformType::Pointer > chain( 5 );
+  for( unsigned int i = 0; i < chain.size(); ++i )
+  {
+    chain[ i ] = CombinationTransformType::New();
+    if( i > 0 )
+    {
+      chain[ i ]->SetInitialTransform( chain[ i - 1 ] );
+    }
+  }
+  chain[ 0 ]->SetCurrentTransform( affineTransform );
+  chain[ 1 ]->SetCurrentTransform( translationTransform );
+  chain[ 2 ]->SetCurrentTransform( affineTransform2 );
+  chain[ 3 ]->SetCurrentTransform( recursiveTransform );
+  chain[ 4 ]->SetCurrentTransform( affineTransform );
+
+  /** Compare. */
+  if( !CompareFoldedChain( chain[ 2 ].GetPointer(), "Linear chain", 1, points ) ) { return 1; }
+  if( !CompareFoldedChain( chain[ 3 ].GetPointer(), "Linear chain with B-spline", 1, points ) ) { return 1; }
+  if( !CompareFoldedChain( chain[ 4 ].GetPointer(), "Chain with B-spline and affine", 2, points ) ) { return 1; }
+  if( !CompareBatch( bsplineTransform, "AdvancedBSplineDeformableTransform", points, gradients ) ) { return 1; }
+  if( !CompareBatch( recursiveTransform, "RecursiveBSplineTransform", points, gradients ) ) { return 1; }
+  if( !CompareBatch( affineTransform, "AdvancedMatrixOffsetTransformBase", points, gradients ) ) { return 1; }
+  if( !CompareBatch( compositionTransform, "AdvancedCombinationTransform (composition)", points, gradients ) ) { return 1; }
+  if( !CompareBatch( additionTransform, "AdvancedCombinationTransform (addition)", points, gradients ) ) { return 1; }
+  if( !CompareBatch( shiftedTransform, "AdvancedCombinationTransform (overridden TransformPoint)", points, gradients ) ) { return 1; }
+
+  std::cerr << "The results are good." << std::endl;
+
+  /** Return a value. */
+  return 0;
+
+} // end main
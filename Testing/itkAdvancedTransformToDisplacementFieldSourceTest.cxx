@@ -0,0 +1,219 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+/** \file
+ \brief Compare the AdvancedTransformToDisplacementFieldSource with the itk::TransformToDisplacementFieldFilter.
+ */
+
+#include "itkAdvancedTransformToDisplacementFieldSource.h"
+#include "itkTransformToDisplacementFieldFilter.h"
+#include "itkRecursiveBSplineTransform.h"
+#include "itkAdvancedMatrixOffsetTransformBase.h"
+#include "itkAdvancedCombinationTransform.h"
+
+#include "itkImage.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkStreamingImageFilter.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <cmath>
+
+const unsigned int Dimension = 3;
+typedef double                                                  CoordinateRepresentationType;
+typedef itk::Vector< float, Dimension >                         VectorPixelType;
+typedef itk::Image< VectorPixelType, Dimension >                DeformationFieldImageType;
+typedef itk::AdvancedTransform<
+  CoordinateRepresentationType, Dimension, Dimension >          AdvancedTransformType;
+typedef itk::AdvancedTransformToDisplacementFieldSource<
+  DeformationFieldImageType, CoordinateRepresentationType >     AdvancedSourceType;
+typedef itk::TransformToDisplacementFieldFilter<
+  DeformationFieldImageType, CoordinateRepresentationType >     ITKFilterType;
+typedef itk::Statistics::MersenneTwisterRandomVariateGenerator  MersenneTwisterType;
+
+//-------------------------------------------------------------------------------------
+
+// Compare two displacement fields: the geometry exactly, the vectors up to the
+// rounding of the incremental point computation of the advanced source.
+bool
+CompareFields( const DeformationFieldImageType * actual, const DeformationFieldImageType * expected,
+  const char * name )
+{
+  if( actual->GetLargestPossibleRegion() != expected->GetLargestPossibleRegion()
+    || actual->GetBufferedRegion() != expected->GetBufferedRegion()
+    || actual->GetOrigin() != expected->GetOrigin()
+    || actual->GetSpacing() != expected->GetSpacing()
+    || actual->GetDirection() != expected->GetDirection() )
+  {
+    std::cerr << "ERROR: the geometry of " << name << " differs from that of the ITK filter." << std::endl;
+    return false;
+  }
+
+  const double tolerance = 1e-4;
+  itk::ImageRegionConstIteratorWithIndex< DeformationFieldImageType > it(
+    expected, expected->GetBufferedRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const VectorPixelType a = actual->GetPixel( it.GetIndex() );
+    const VectorPixelType e = it.Get();
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      if( std::abs( a[ d ] - e[ d ] ) > tolerance * ( 1.0 + std::abs( e[ d ] ) ) )
+      {
+        std::cerr << "ERROR: " << name << " gives " << a << " at index " << it.GetIndex()
+                  << ", while the ITK filter gives " << e << "." << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+
+} // end CompareFields()
+
+//-------------------------------------------------------------------------------------
+
+// Compare the advanced source with the ITK filter for a transform, at once and streamed.
+bool
+CompareWithITK( const AdvancedTransformType * transform, const char * name )
+{
+  /** A grid with a non-zero start index, anisotropic spacing and a
+   * non-identity direction. The rows have an odd length.
+   */
+  DeformationFieldImageType::SizeType size;
+  size[ 0 ] = 37; size[ 1 ] = 21; size[ 2 ] = 13;
+  DeformationFieldImageType::IndexType start;
+  start[ 0 ] = 5; start[ 1 ] = -3; start[ 2 ] = 2;
+  DeformationFieldImageType::SpacingType spacing;
+  spacing[ 0 ] = 2.5; spacing[ 1 ] = 3.0; spacing[ 2 ] = 4.5;
+  DeformationFieldImageType::PointType origin;
+  origin[ 0 ] = -10.0; origin[ 1 ] = 7.0; origin[ 2 ] = 3.0;
+  DeformationFieldImageType::DirectionType direction;
+  const double angle = 0.3;
+  direction.SetIdentity();
+  direction( 0, 0 ) = std::cos( angle ); direction( 0, 1 ) = -std::sin( angle );
+  direction( 1, 0 ) = std::sin( angle ); direction( 1, 1 ) = std::cos( angle );
+
+  ITKFilterType::Pointer itkFilter = ITKFilterType::New();
+  itkFilter->SetTransform( transform );
+  itkFilter->SetSize( size );
+  itkFilter->SetOutputStartIndex( start );
+  itkFilter->SetOutputSpacing( spacing );
+  itkFilter->SetOutputOrigin( origin );
+  itkFilter->SetOutputDirection( direction );
+  itkFilter->Update();
+
+  AdvancedSourceType::Pointer source = AdvancedSourceType::New();
+  source->SetTransform( transform );
+  source->SetOutputSize( size );
+  source->SetOutputIndex( start );
+  source->SetOutputSpacing( spacing );
+  source->SetOutputOrigin( origin );
+  source->SetOutputDirection( direction );
+  source->Update();
+  if( !CompareFields( source->GetOutput(), itkFilter->GetOutput(), name ) )
+  {
+    return false;
+  }
+
+  /** Generate the field piece by piece, as the ImageFileWriter does. */
+  typedef itk::StreamingImageFilter<
+    DeformationFieldImageType, DeformationFieldImageType > StreamerType;
+  AdvancedSourceType::Pointer streamedSource = AdvancedSourceType::New();
+  streamedSource->SetTransform( transform );
+  streamedSource->SetOutputSize( size );
+  streamedSource->SetOutputIndex( start );
+  streamedSource->SetOutputSpacing( spacing );
+  streamedSource->SetOutputOrigin( origin );
+  streamedSource->SetOutputDirection( direction );
+  StreamerType::Pointer streamer = StreamerType::New();
+  streamer->SetInput( streamedSource->GetOutput() );
+  streamer->SetNumberOfStreamDivisions( 5 );
+  streamer->Update();
+
+  std::string streamedName( name );
+  streamedName += " (streamed)";
+  return CompareFields( streamer->GetOutput(), itkFilter->GetOutput(), streamedName.c_str() );
+
+} // end CompareWithITK()
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  typedef itk::RecursiveBSplineTransform<
+    CoordinateRepresentationType, Dimension, 3 >                BSplineTransformType;
+  typedef itk::AdvancedMatrixOffsetTransformBase<
+    CoordinateRepresentationType, Dimension, Dimension >        AffineTransformType;
+  typedef itk::AdvancedCombinationTransform<
+    CoordinateRepresentationType, Dimension >                   CombinationTransformType;
+
+  MersenneTwisterType::Pointer randomGenerator = MersenneTwisterType::GetInstance();
+  randomGenerator->SetSeed( 4321 );
+
+  /** A B-spline transform of which the grid covers part of the output. */
+  BSplineTransformType::Pointer bsplineTransform = BSplineTransformType::New();
+  BSplineTransformType::RegionType    gridRegion;
+  BSplineTransformType::SizeType      gridSize;
+  BSplineTransformType::SpacingType   gridSpacing;
+  BSplineTransformType::OriginType    gridOrigin;
+  BSplineTransformType::DirectionType gridDirection;
+  gridSize.Fill( 10 );
+  gridRegion.SetSize( gridSize );
+  gridSpacing.Fill( 12.0 );
+  gridOrigin.Fill( -30.0 );
+  gridDirection.SetIdentity();
+  gridDirection( 0, 2 ) = 0.04;
+  bsplineTransform->SetGridRegion( gridRegion );
+  bsplineTransform->SetGridSpacing( gridSpacing );
+  bsplineTransform->SetGridOrigin( gridOrigin );
+  bsplineTransform->SetGridDirection( gridDirection );
+  BSplineTransformType::ParametersType bsplineParameters( bsplineTransform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < bsplineParameters.GetSize(); ++i )
+  {
+    bsplineParameters[ i ] = randomGenerator->GetUniformVariate( -3.0, 3.0 );
+  }
+  bsplineTransform->SetParametersByValue( bsplineParameters );
+
+  /** An affine transform, and its composition with the B-spline. */
+  AffineTransformType::Pointer affineTransform = AffineTransformType::New();
+  AffineTransformType::ParametersType affineParameters( affineTransform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < affineParameters.GetSize(); ++i )
+  {
+    affineParameters[ i ] = randomGenerator->GetUniformVariate( -0.2, 0.2 );
+  }
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    affineParameters[ d * Dimension + d ] += 1.0;
+  }
+  affineTransform->SetParameters( affineParameters );
+
+  CombinationTransformType::Pointer compositionTransform = CombinationTransformType::New();
+  compositionTransform->SetInitialTransform( affineTransform );
+  compositionTransform->SetCurrentTransform( bsplineTransform );
+  compositionTransform->SetUseComposition( true );
+
+  /** Compare. */
+  if( !CompareWithITK( affineTransform, "AdvancedMatrixOffsetTransformBase" ) ) { return 1; }
+  if( !CompareWithITK( bsplineTransform, "RecursiveBSplineTransform" ) ) { return 1; }
+  if( !CompareWithITK( compositionTransform, "AdvancedCombinationTransform" ) ) { return 1; }
+
+  std::cerr << "The results are good." << std::endl;
+
+  /** Return a value. */
+  return 0;
+
+} // end main
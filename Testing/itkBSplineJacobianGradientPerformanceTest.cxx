@@ -18,6 +18,7 @@
 
 #include "itkAdvancedBSplineDeformableTransform.h" // original elastix
 #include "itkRecursiveBSplineTransform.h"          // recursive version
+#include "itkRecursiveBSplineTransformSIMDKernels.h"
 
 // Report timings
 #include "itkTimeProbe.h"
@@ -25,6 +26,8 @@
 
 #include <fstream>
 #include <iomanip>
+#include <string>
+#include <vector>
 
 //-------------------------------------------------------------------------------------
 
@@ -63,13 +66,16 @@ main( int argc, char * argv[] )
   typedef itk::RecursiveBSplineTransform<
     CoordinateRepresentationType, Dimension, SplineOrder >    RecursiveTransformType;
 
-  typedef TransformType::NumberOfParametersType     NumberOfParametersType;
-  typedef TransformType::InputPointType             InputPointType;
-  typedef TransformType::ParametersType             ParametersType;
-  typedef TransformType::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
-  typedef TransformType::DerivativeType             DerivativeType;
-  typedef TransformType::JacobianType               JacobianType;
-  typedef TransformType::MovingImageGradientType    MovingImageGradientType;
+  typedef TransformType::NumberOfParametersType          NumberOfParametersType;
+  typedef TransformType::InputPointType                  InputPointType;
+  typedef TransformType::ParametersType                  ParametersType;
+  typedef TransformType::NonZeroJacobianIndicesType      NonZeroJacobianIndicesType;
+  typedef TransformType::DerivativeType                  DerivativeType;
+  typedef TransformType::JacobianType                    JacobianType;
+  typedef TransformType::MovingImageGradientType         MovingImageGradientType;
+  typedef TransformType::ParametersValueType             ParametersValueType;
+  typedef TransformType::NonZeroJacobianIndicesValueType NonZeroJacobianIndicesValueType;
+  typedef itk::RecursiveBSplineTransformSIMDKernels      SIMDKernelsType;
 
   typedef itk::Image< CoordinateRepresentationType,
     Dimension >                                         InputImageType;
@@ -224,8 +230,52 @@ main( int argc, char * argv[] )
   }
   timeCollector.Stop( "JacobianGradient recursive new" );
 
+  /** Time the recursive batch version, in blocks of points around inputPoint,
+   * for every instruction set up to the maximum of this processor.
+   */
+  const unsigned int                             numberOfBatchPoints = 64;
+  std::vector< InputPointType >                  batchPoints( numberOfBatchPoints );
+  std::vector< MovingImageGradientType >         batchGradients( numberOfBatchPoints, movingImageGradient );
+  std::vector< ParametersValueType >             batchImageJacobians( numberOfBatchPoints * nnzji );
+  std::vector< NonZeroJacobianIndicesValueType > batchNzji( numberOfBatchPoints * nnzji );
+  for( unsigned int p = 0; p < numberOfBatchPoints; ++p )
+  {
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      batchPoints[ p ][ d ] = inputPoint[ d ] + 1.7 * ( ( p + d ) % 8 );
+    }
+  }
+
+  const SIMDKernelsType::InstructionSetType maximumInstructionSet = SIMDKernelsType::GetMaximumInstructionSet();
+  std::vector< double >                     batchTimes;
+  recursiveTransform->SetUseSIMDKernels( true );
+  for( unsigned int set = SIMDKernelsType::Scalar; set <= maximumInstructionSet; ++set )
+  {
+    const SIMDKernelsType::InstructionSetType instructionSet
+      = static_cast< SIMDKernelsType::InstructionSetType >( set );
+    SIMDKernelsType::SetInstructionSet( instructionSet );
+    const std::string name = std::string( "JacobianGradient recursive batch " )
+      + SIMDKernelsType::GetInstructionSetName( instructionSet );
+
+    timeCollector.Start( name.c_str() );
+    for( unsigned int i = 0; i < N; i += numberOfBatchPoints )
+    {
+      recursiveTransform->EvaluateJacobianWithImageGradientProducts(
+        &batchPoints[ 0 ], &batchGradients[ 0 ], numberOfBatchPoints,
+        &batchImageJacobians[ 0 ], &batchNzji[ 0 ] );
+
+      sum += batchImageJacobians[ 0 ]; // just to avoid compiler to optimize away
+    }
+    timeCollector.Stop( name.c_str() );
+    batchTimes.push_back( timeCollector.GetProbe( name.c_str() ).GetTotal() );
+  }
+  SIMDKernelsType::SetInstructionSet( maximumInstructionSet );
+  recursiveTransform->SetUseSIMDKernels( false );
+
   /** Report timings. */
   timeCollector.Report();
+  std::cerr << "Speedup of " << SIMDKernelsType::GetInstructionSetName( maximumInstructionSet )
+            << " over scalar batch: " << batchTimes.front() / batchTimes.back() << std::endl;
 
   // Avoid compiler optimizations, so use sum
   std::cerr << sum << std::endl; // works but ugly on screen
@@ -252,6 +302,31 @@ main( int argc, char * argv[] )
     return EXIT_FAILURE;
   }
 
+  /** Test the accuracy of the batch version, for every instruction set. */
+  batchPoints[ 0 ] = inputPoint;
+  recursiveTransform->SetUseSIMDKernels( true );
+  for( unsigned int set = SIMDKernelsType::Scalar; set <= maximumInstructionSet; ++set )
+  {
+    const SIMDKernelsType::InstructionSetType instructionSet
+      = static_cast< SIMDKernelsType::InstructionSetType >( set );
+    SIMDKernelsType::SetInstructionSet( instructionSet );
+    recursiveTransform->EvaluateJacobianWithImageGradientProducts(
+      &batchPoints[ 0 ], &batchGradients[ 0 ], numberOfBatchPoints,
+      &batchImageJacobians[ 0 ], &batchNzji[ 0 ] );
+
+    DerivativeType imageJacobian_batch( &batchImageJacobians[ 0 ], nnzji, false );
+    diffNorm = ( imageJacobian_old - imageJacobian_batch ).magnitude();
+    std::cerr << "Recursive B-spline batch (" << SIMDKernelsType::GetInstructionSetName( instructionSet )
+              << ") MSD with previous: " << diffNorm << std::endl;
+    if( diffNorm > 1e-5 )
+    {
+      std::cerr << "ERROR: Recursive B-spline EvaluateJacobianWithImageGradientProducts() returning incorrect result." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  SIMDKernelsType::SetInstructionSet( maximumInstructionSet );
+  recursiveTransform->SetUseSIMDKernels( false );
+
   /** Return a value. */
   return EXIT_SUCCESS;
 
@@ -16,6 +16,8 @@
  *
  *=========================================================================*/
 #include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkRecursiveBSplineTransform.h"
+#include "itkRecursiveBSplineTransformSIMDKernels.h"
 
 #include "itkImageRegionIterator.h"
 
@@ -24,6 +26,7 @@
 
 #include <fstream>
 #include <iomanip>
+#include <vector>
 
 //-------------------------------------------------------------------------------------
 // Create a class that inherits from the B-spline transform,
@@ -197,6 +200,9 @@ main( int argc, char * argv[] )
   /** Typedefs. */
   typedef itk::BSplineTransform_TEST<
     CoordinateRepresentationType, Dimension, SplineOrder >    TransformType;
+  typedef itk::RecursiveBSplineTransform<
+    CoordinateRepresentationType, Dimension, SplineOrder >    RecursiveTransformType;
+  typedef itk::RecursiveBSplineTransformSIMDKernels           SIMDKernelsType;
 
   typedef TransformType::InputPointType  InputPointType;
   typedef TransformType::OutputPointType OutputPointType;
@@ -211,8 +217,9 @@ main( int argc, char * argv[] )
   typedef InputImageType::PointType     OriginType;
   typedef InputImageType::DirectionType DirectionType;
 
-  /** Create the transform. */
-  TransformType::Pointer transform = TransformType::New();
+  /** Create the transforms. */
+  TransformType::Pointer          transform          = TransformType::New();
+  RecursiveTransformType::Pointer recursiveTransform = RecursiveTransformType::New();
 
   /** Setup the B-spline transform:
    * (GridSize 44 43 35)
@@ -243,6 +250,11 @@ main( int argc, char * argv[] )
   transform->SetGridRegion( gridRegion );
   transform->SetGridDirection( gridDirection );
 
+  recursiveTransform->SetGridOrigin( gridOrigin );
+  recursiveTransform->SetGridSpacing( gridSpacing );
+  recursiveTransform->SetGridRegion( gridRegion );
+  recursiveTransform->SetGridDirection( gridDirection );
+
   /** Now read the parameters as defined in the file par.txt. */
   ParametersType parameters( transform->GetNumberOfParameters() );
   std::ifstream  input( argv[ 1 ] );
@@ -260,6 +272,7 @@ main( int argc, char * argv[] )
     return 1;
   }
   transform->SetParameters( parameters );
+  recursiveTransform->SetParameters( parameters );
 
   /** Declare variables. */
   InputPointType  inputPoint; inputPoint.Fill( 4.1 );
@@ -286,6 +299,40 @@ main( int argc, char * argv[] )
   timeProbeNEW.Stop();
   const double newTime = timeProbeNEW.GetMean();
 
+  /** Time the batch TransformPoints of the recursive transform, in blocks
+   * of points around inputPoint, with the generic recursive implementation
+   * and with the SIMD kernels of the maximum instruction set of this processor.
+   */
+  const unsigned int             numberOfBatchPoints = 64;
+  std::vector< InputPointType >  batchPoints( numberOfBatchPoints );
+  std::vector< OutputPointType > batchOutputPoints( numberOfBatchPoints );
+  for( unsigned int p = 0; p < numberOfBatchPoints; ++p )
+  {
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      batchPoints[ p ][ d ] = inputPoint[ d ] + 1.7 * ( ( p + d ) % 8 );
+    }
+  }
+
+  const SIMDKernelsType::InstructionSetType maximumInstructionSet = SIMDKernelsType::GetMaximumInstructionSet();
+  itk::TimeProbe                            timeProbeBatch[ 2 ];
+  OutputPointType                           batchOutputPoint[ 2 ];
+  for( unsigned int k = 0; k < 2; ++k )
+  {
+    recursiveTransform->SetUseSIMDKernels( k == 1 );
+    timeProbeBatch[ k ].Start();
+    for( unsigned int i = 0; i < N; i += numberOfBatchPoints )
+    {
+      recursiveTransform->TransformPoints( &batchPoints[ 0 ], &batchOutputPoints[ 0 ], numberOfBatchPoints );
+      sum += batchOutputPoints[ 0 ][ 0 ]; sum += batchOutputPoints[ 0 ][ 1 ]; sum += batchOutputPoints[ 0 ][ 2 ];
+    }
+    timeProbeBatch[ k ].Stop();
+    batchOutputPoint[ k ] = batchOutputPoints[ 0 ];
+  }
+  recursiveTransform->SetUseSIMDKernels( false );
+  const double scalarBatchTime = timeProbeBatch[ 0 ].GetMean();
+  const double simdBatchTime   = timeProbeBatch[ 1 ].GetMean();
+
   // Avoid compiler optimizations, so use sum
   std::cerr << sum << std::endl; // works but ugly on screen
   //  volatile double a = sum; // works but gives unused variable warning
@@ -297,6 +344,29 @@ main( int argc, char * argv[] )
   std::cerr << "Time OLD = " << oldTime << " " << timeProbeOLD.GetUnit() << std::endl;
   std::cerr << "Time NEW = " << newTime << " " << timeProbeNEW.GetUnit() << std::endl;
   std::cerr << "Speedup factor = " << oldTime / newTime << std::endl;
+  std::cerr << "Time recursive batch generic = " << scalarBatchTime << " " << timeProbeBatch[ 0 ].GetUnit() << std::endl;
+  std::cerr << "Time recursive batch "
+            << SIMDKernelsType::GetInstructionSetName( maximumInstructionSet ) << " = "
+            << simdBatchTime << " " << timeProbeBatch[ 1 ].GetUnit() << std::endl;
+  std::cerr << "Speedup factor SIMD = " << scalarBatchTime / simdBatchTime << std::endl;
+
+  /** Check the batch results with the single point version. Without the
+   * SIMD kernels the batch result should be identical to it.
+   */
+  if( recursiveTransform->TransformPoint( batchPoints[ 0 ] ) != batchOutputPoint[ 0 ] )
+  {
+    std::cerr << "ERROR: Recursive B-spline TransformPoints() differs from TransformPoint()." << std::endl;
+    return 1;
+  }
+  outputPoint = transform->TransformPoint( batchPoints[ 0 ] );
+  for( unsigned int k = 0; k < 2; ++k )
+  {
+    if( outputPoint.EuclideanDistanceTo( batchOutputPoint[ k ] ) > 1e-5 )
+    {
+      std::cerr << "ERROR: Recursive B-spline TransformPoints() returning incorrect result." << std::endl;
+      return 1;
+    }
+  }
 
   /** Return a value. */
   return 0;
@@ -0,0 +1,203 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkBackgroundTaskQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  typedef itk::BackgroundTaskQueue QueueType;
+
+  /** Tasks should be executed exactly once, in the order of pushing. */
+  {
+    QueueType::Pointer queue = QueueType::New();
+    queue->SetCapacity( 2 );
+    std::vector< unsigned int > order;
+    for( unsigned int i = 0; i < 100; ++i )
+    {
+      queue->Push( [ &order, i ]() { order.push_back( i ); } );
+      if( queue->GetNumberOfPendingTasks() > 2 )
+      {
+        std::cerr << "ERROR: the queue holds more tasks than its capacity." << std::endl;
+        return 1;
+      }
+    }
+    queue->Wait();
+    for( unsigned int i = 0; i < order.size(); ++i )
+    {
+      if( order[ i ] != i )
+      {
+        std::cerr << "ERROR: task " << order[ i ] << " executed at position " << i << "." << std::endl;
+        return 1;
+      }
+    }
+    if( order.size() != 100 )
+    {
+      std::cerr << "ERROR: " << order.size() << " instead of 100 tasks executed." << std::endl;
+      return 1;
+    }
+  }
+
+  /** With PushOrReplaceNewest() a full queue should drop the newest pending
+   * task, and the last pushed task should always be executed.
+   */
+  {
+    QueueType::Pointer queue = QueueType::New();
+    std::atomic< bool > release( false );
+    std::vector< unsigned int > executed;
+    queue->Push( [ &release ]()
+      {
+        while( !release ) { std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) ); }
+      } );
+
+    /** Wait until the blocking task runs, so that the queue is empty. */
+    while( queue->GetNumberOfPendingTasks() > 0 )
+    {
+      std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+    unsigned int numberOfAccepted = 0;
+    for( unsigned int i = 0; i < 10; ++i )
+    {
+      numberOfAccepted += queue->PushOrReplaceNewest( [ &executed, i ]() { executed.push_back( i ); } );
+    }
+    release = true;
+    queue->Wait();
+
+    if( numberOfAccepted != 1 || queue->GetNumberOfDroppedTasks() != 9 )
+    {
+      std::cerr << "ERROR: " << numberOfAccepted << " tasks accepted and "
+                << queue->GetNumberOfDroppedTasks() << " dropped, instead of 1 and 9." << std::endl;
+      return 1;
+    }
+    if( executed.size() != 1 || executed[ 0 ] != 9 )
+    {
+      std::cerr << "ERROR: the newest task was not executed." << std::endl;
+      return 1;
+    }
+  }
+
+  /** PushOrReplaceNewest() should never drop a task of Push(). With only such
+   * tasks pending it should append, and otherwise drop the newest task that
+   * may be dropped, keeping the order of pushing.
+   */
+  {
+    QueueType::Pointer queue = QueueType::New();
+    queue->SetCapacity( 2 );
+    std::atomic< bool > release( false );
+    std::vector< unsigned int > executed;
+    queue->Push( [ &release ]()
+      {
+        while( !release ) { std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) ); }
+      } );
+    while( queue->GetNumberOfPendingTasks() > 0 )
+    {
+      std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+
+    /** The queue has room for 1 and 2, 3 drops 1, and 4 drops 3. */
+    bool accepted[ 4 ];
+    accepted[ 0 ] = queue->PushOrReplaceNewest( [ &executed ]() { executed.push_back( 1 ); } );
+    queue->Push( [ &executed ]() { executed.push_back( 2 ); } );
+    accepted[ 1 ] = queue->PushOrReplaceNewest( [ &executed ]() { executed.push_back( 3 ); } );
+    accepted[ 2 ] = queue->PushOrReplaceNewest( [ &executed ]() { executed.push_back( 4 ); } );
+    if( !accepted[ 0 ] || accepted[ 1 ] || accepted[ 2 ] || queue->GetNumberOfPendingTasks() != 2 )
+    {
+      std::cerr << "ERROR: the tasks that may be dropped are not replaced." << std::endl;
+      return 1;
+    }
+    release = true;
+    queue->Wait();
+    if( executed.size() != 2 || executed[ 0 ] != 2 || executed[ 1 ] != 4 )
+    {
+      std::cerr << "ERROR: tasks 2 and 4 should be executed, in that order." << std::endl;
+      return 1;
+    }
+
+    /** With only tasks of Push() pending, the task is appended. */
+    release = false;
+    executed.clear();
+    queue->SetCapacity( 1 );
+    queue->Push( [ &release ]()
+      {
+        while( !release ) { std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) ); }
+      } );
+    while( queue->GetNumberOfPendingTasks() > 0 )
+    {
+      std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+    queue->Push( [ &executed ]() { executed.push_back( 5 ); } );
+    accepted[ 3 ] = queue->PushOrReplaceNewest( [ &executed ]() { executed.push_back( 6 ); } );
+    queue->PushOrReplaceNewest( [ &executed ]() { executed.push_back( 7 ); } );
+    release = true;
+    queue->Wait();
+    if( !accepted[ 3 ] || executed.size() != 2 || executed[ 0 ] != 5 || executed[ 1 ] != 7 )
+    {
+      std::cerr << "ERROR: a task of Push() was dropped, or the task that may be dropped was "
+                << "not appended." << std::endl;
+      return 1;
+    }
+  }
+
+  /** Exceptions should be rethrown by Wait(), and only once. */
+  {
+    QueueType::Pointer queue = QueueType::New();
+    queue->Push( []() { throw std::runtime_error( "task" ); } );
+    bool caught = false;
+    try
+    {
+      queue->Wait();
+    }
+    catch( std::runtime_error & )
+    {
+      caught = true;
+    }
+    if( !caught )
+    {
+      std::cerr << "ERROR: the exception was not propagated." << std::endl;
+      return 1;
+    }
+    queue->Wait();
+  }
+
+  /** The destructor should finish the pending tasks. */
+  unsigned int count = 0;
+  {
+    QueueType::Pointer queue = QueueType::New();
+    queue->SetCapacity( 10 );
+    for( unsigned int i = 0; i < 10; ++i )
+    {
+      queue->Push( [ &count ]() { ++count; } );
+    }
+  }
+  if( count != 10 )
+  {
+    std::cerr << "ERROR: " << count << " instead of 10 tasks executed before destruction." << std::endl;
+    return 1;
+  }
+
+  /** Return a value. */
+  return 0;
+
+} // end main
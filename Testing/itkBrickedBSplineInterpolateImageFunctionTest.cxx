@@ -0,0 +1,247 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+/** \file
+ \brief Compare the bricked B-spline interpolator with the itk::BSplineInterpolateImageFunction.
+ */
+
+#include "itkBrickedBSplineInterpolateImageFunction.h"
+#include "itkBSplineInterpolateImageFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <cmath>
+#include <sstream>
+
+typedef itk::Statistics::MersenneTwisterRandomVariateGenerator MersenneTwisterType;
+
+//-------------------------------------------------------------------------------------
+
+// Check a value against the expected one, relative to its magnitude
+bool
+CheckValue( const double actual, const double expected, const double tolerance,
+  const std::string & what )
+{
+  if( std::abs( actual - expected ) > tolerance * ( 1.0 + std::abs( expected ) ) )
+  {
+    std::cerr << "ERROR: " << what << " gives " << actual
+              << ", while the BSplineInterpolateImageFunction gives " << expected << "." << std::endl;
+    return false;
+  }
+  return true;
+
+} // end CheckValue()
+
+//-------------------------------------------------------------------------------------
+
+// Test function templated over the dimension and the coefficient type
+template< unsigned int Dimension, class TCoefficient >
+bool
+TestInterpolator( const unsigned int splineOrder, const double tolerance )
+{
+  typedef itk::Image< float, Dimension >        InputImageType;
+  typedef typename InputImageType::SizeType      SizeType;
+  typedef typename InputImageType::IndexType     IndexType;
+  typedef typename InputImageType::SpacingType   SpacingType;
+  typedef typename InputImageType::PointType     PointType;
+  typedef typename InputImageType::RegionType    RegionType;
+  typedef typename InputImageType::DirectionType DirectionType;
+  typedef double                                 CoordRepType;
+
+  typedef itk::BSplineInterpolateImageFunction<
+    InputImageType, CoordRepType, TCoefficient >        InterpolatorType;
+  typedef itk::BrickedBSplineInterpolateImageFunction<
+    InputImageType, CoordRepType, TCoefficient >        BrickedInterpolatorType;
+  typedef typename InterpolatorType::ContinuousIndexType ContinuousIndexType;
+  typedef typename InterpolatorType::CovariantVectorType CovariantVectorType;
+  typedef typename InterpolatorType::OutputType          OutputType;
+
+  std::cerr << "Testing " << Dimension << "D, spline order " << splineOrder << ", "
+            << sizeof( TCoefficient ) << " byte coefficients." << std::endl;
+
+  /** An image with a non-zero start index, anisotropic spacing and a
+   * non-identity direction. The sizes span several bricks, and are not a
+   * multiple of the brick size.
+   */
+  SizeType    size;
+  IndexType   start;
+  SpacingType spacing;
+  PointType   origin;
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    size[ d ]    = 21 - 4 * d;
+    start[ d ]   = ( d % 2 == 0 ) ? 4 + d : -3;
+    spacing[ d ] = 0.7 + 0.45 * d;
+    origin[ d ]  = -5.0 + 3.0 * d;
+  }
+  DirectionType direction;
+  direction.SetIdentity();
+  const double angle = 0.4;
+  direction( 0, 0 ) = std::cos( angle ); direction( 0, 1 ) = -std::sin( angle );
+  direction( 1, 0 ) = std::sin( angle ); direction( 1, 1 ) = std::cos( angle );
+  if( Dimension > 2 )
+  {
+    DirectionType tilt;
+    tilt.SetIdentity();
+    tilt( 1, 1 ) = std::cos( 0.25 ); tilt( 1, 2 ) = -std::sin( 0.25 );
+    tilt( 2, 1 ) = std::sin( 0.25 ); tilt( 2, 2 ) = std::cos( 0.25 );
+    direction = direction * tilt;
+  }
+
+  typename InputImageType::Pointer image = InputImageType::New();
+  image->SetRegions( RegionType( start, size ) );
+  image->SetSpacing( spacing );
+  image->SetOrigin( origin );
+  image->SetDirection( direction );
+  image->Allocate();
+
+  MersenneTwisterType::Pointer randomGenerator = MersenneTwisterType::GetInstance();
+  randomGenerator->SetSeed( 1234 + splineOrder );
+  itk::ImageRegionIterator< InputImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    it.Set( static_cast< float >( randomGenerator->GetUniformVariate( -50.0, 100.0 ) ) );
+  }
+
+  /** The interpolators. */
+  typename InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetSplineOrder( splineOrder );
+  interpolator->SetInputImage( image );
+
+  typename BrickedInterpolatorType::Pointer bricked = BrickedInterpolatorType::New();
+  bricked->SetUseBrickedCoefficients( true );
+  bricked->SetSplineOrder( splineOrder );
+  bricked->SetInputImage( image );
+  if( !bricked->GetBrickedCoefficientsAreValid() )
+  {
+    std::cerr << "ERROR: the bricked coefficients are not used." << std::endl;
+    return false;
+  }
+
+  /** The points: random ones, random ones within half a voxel of the border
+   * in one dimension, where the mirror padding is read, and the corners of
+   * the buffer as seen by IsInsideBuffer().
+   */
+  const unsigned int numberOfPoints = 2000;
+  for( unsigned int i = 0; i < numberOfPoints + 2; ++i )
+  {
+    ContinuousIndexType cindex;
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      const double first = start[ d ] - 0.5;
+      const double last  = start[ d ] + size[ d ] - 0.5 - 1e-6;
+      if( i == numberOfPoints )
+      {
+        cindex[ d ] = first;
+      }
+      else if( i == numberOfPoints + 1 )
+      {
+        cindex[ d ] = last;
+      }
+      else
+      {
+        cindex[ d ] = randomGenerator->GetUniformVariate( first, last );
+      }
+    }
+    if( i % 2 == 1 && i < numberOfPoints )
+    {
+      const unsigned int d = ( i / 2 ) % Dimension;
+      const double       u = randomGenerator->GetUniformVariate( 0.0, 0.5 );
+      cindex[ d ] = ( i % 4 == 1 ) ? start[ d ] - 0.5 + u : start[ d ] + size[ d ] - 0.5 - u - 1e-6;
+    }
+
+    PointType point;
+    image->TransformContinuousIndexToPhysicalPoint( cindex, point );
+    if( !interpolator->IsInsideBuffer( point ) )
+    {
+      /** Rounding of the physical point may put a border point just outside. */
+      continue;
+    }
+    ContinuousIndexType pointIndex;
+    image->TransformPhysicalPointToContinuousIndex( point, pointIndex );
+
+    std::ostringstream where;
+    where << " at continuous index " << cindex;
+
+    /** Evaluate, at a point and at a continuous index. */
+    if( !CheckValue( bricked->Evaluate( point ), interpolator->Evaluate( point ),
+      tolerance, "Evaluate()" + where.str() ) )
+    {
+      return false;
+    }
+    if( !CheckValue( bricked->EvaluateAtContinuousIndex( cindex ),
+      interpolator->EvaluateAtContinuousIndex( cindex ),
+      tolerance, "EvaluateAtContinuousIndex()" + where.str() ) )
+    {
+      return false;
+    }
+
+    /** EvaluateDerivative() is that of the superclass, on the coefficient image. */
+    const CovariantVectorType derivative         = bricked->EvaluateDerivative( point );
+    const CovariantVectorType expectedDerivative = interpolator->EvaluateDerivative( point );
+
+    /** EvaluateValueAndDerivativeAtContinuousIndex() reads the bricks. */
+    OutputType          value, expectedValue;
+    CovariantVectorType valueDerivative, expectedValueDerivative;
+    bricked->EvaluateValueAndDerivativeAtContinuousIndex( pointIndex, value, valueDerivative );
+    interpolator->EvaluateValueAndDerivativeAtContinuousIndex( pointIndex, expectedValue, expectedValueDerivative );
+    if( !CheckValue( value, expectedValue, tolerance,
+      "EvaluateValueAndDerivativeAtContinuousIndex() value" + where.str() ) )
+    {
+      return false;
+    }
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      if( !CheckValue( derivative[ d ], expectedDerivative[ d ], tolerance,
+        "EvaluateDerivative()" + where.str() )
+        || !CheckValue( valueDerivative[ d ], expectedValueDerivative[ d ], tolerance,
+        "EvaluateValueAndDerivativeAtContinuousIndex() derivative" + where.str() )
+        || !CheckValue( valueDerivative[ d ], expectedDerivative[ d ], tolerance,
+        "EvaluateValueAndDerivativeAtContinuousIndex() derivative versus EvaluateDerivative()" + where.str() ) )
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+
+} // end TestInterpolator()
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  /** Spline orders 1 to 3, in 2D and 3D, with double coefficients. */
+  for( unsigned int splineOrder = 1; splineOrder <= 3; ++splineOrder )
+  {
+    if( !TestInterpolator< 2, double >( splineOrder, 1e-9 ) ) { return 1; }
+    if( !TestInterpolator< 3, double >( splineOrder, 1e-9 ) ) { return 1; }
+  }
+
+  /** Float coefficients, as in the BSplineInterpolatorFloat of elastix. */
+  if( !TestInterpolator< 3, float >( 3, 1e-5 ) ) { return 1; }
+
+  std::cerr << "The results are good." << std::endl;
+
+  /** Return a value. */
+  return 0;
+
+} // end main
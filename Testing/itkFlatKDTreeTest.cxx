@@ -0,0 +1,256 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+/** \file
+ \brief Compare the k nearest neighbours of the FlatKDTree with a brute force search.
+ */
+
+#include "itkFlatKDTree.h"
+#include "itkFlatKDTreeSearch.h"
+#include "itkListSampleCArray.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <algorithm>
+#include <vector>
+
+typedef itk::Array< double >                                            MeasurementVectorType;
+typedef itk::Statistics::ListSampleCArray< MeasurementVectorType, double > ListSampleType;
+typedef itk::FlatKDTree< ListSampleType >                               TreeType;
+typedef itk::FlatKDTreeSearch< ListSampleType >                         TreeSearchType;
+typedef TreeType::IndexType                                             IndexType;
+typedef TreeType::DistanceType                                          DistanceType;
+
+/** The squared distance of a query point to data point i, summed in the same
+ * order as the tree does.
+ */
+double
+SquaredDistance( const ListSampleType * sample, const double * qp, const unsigned long i )
+{
+  const unsigned int dim      = sample->GetMeasurementVectorSize();
+  double             distance = 0.0;
+  for( unsigned int d = 0; d < dim; ++d )
+  {
+    const double diff = qp[ d ] - sample->GetInternalContainer()[ i ][ d ];
+    distance += diff * diff;
+  }
+  return distance;
+
+} // end SquaredDistance()
+
+
+/** Check k neighbours against a brute force search. Points at the same
+ * distance may come in any order, so the sorted distances are compared,
+ * and the distances of the returned indices are checked.
+ */
+bool
+CheckNeighbours( const ListSampleType * sample, const double * qp,
+  const unsigned int k, const IndexType * indices, const DistanceType * squaredDistances )
+{
+  const unsigned long numberOfPoints = sample->Size();
+
+  std::vector< double > expected( numberOfPoints );
+  for( unsigned long i = 0; i < numberOfPoints; ++i )
+  {
+    expected[ i ] = SquaredDistance( sample, qp, i );
+  }
+  std::sort( expected.begin(), expected.end() );
+
+  std::vector< IndexType > seen;
+  for( unsigned int j = 0; j < k; ++j )
+  {
+    if( j >= numberOfPoints )
+    {
+      if( indices[ j ] != -1 )
+      {
+        std::cerr << "ERROR: neighbour " << j << " exists, while there are only "
+                  << numberOfPoints << " points." << std::endl;
+        return false;
+      }
+      continue;
+    }
+
+    if( indices[ j ] < 0 || static_cast< unsigned long >( indices[ j ] ) >= numberOfPoints )
+    {
+      std::cerr << "ERROR: neighbour " << j << " has the invalid index " << indices[ j ] << "." << std::endl;
+      return false;
+    }
+    if( std::find( seen.begin(), seen.end(), indices[ j ] ) != seen.end() )
+    {
+      std::cerr << "ERROR: point " << indices[ j ] << " is returned twice." << std::endl;
+      return false;
+    }
+    seen.push_back( indices[ j ] );
+
+    if( squaredDistances[ j ] != expected[ j ]
+      || SquaredDistance( sample, qp, indices[ j ] ) != squaredDistances[ j ] )
+    {
+      std::cerr << "ERROR: neighbour " << j << " is point " << indices[ j ] << " at squared distance "
+                << squaredDistances[ j ] << ", while the brute force search gives " << expected[ j ]
+                << "." << std::endl;
+      return false;
+    }
+  }
+  return true;
+
+} // end CheckNeighbours()
+
+
+/** Build a tree of the sample, and check the neighbours of the data points
+ * and of random query points against a brute force search, and those of
+ * SearchAllDataPoints() against Search().
+ */
+bool
+TestTree( ListSampleType * sample, const unsigned int bucketSize,
+  const unsigned int k, const itk::ThreadIdType numberOfThreads )
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+
+  std::cerr << "Testing " << sample->Size() << " points, bucket size " << bucketSize
+            << ", k = " << k << ", " << numberOfThreads << " threads." << std::endl;
+
+  TreeType::Pointer tree = TreeType::New();
+  tree->SetSample( sample );
+  tree->SetBucketSize( bucketSize );
+  tree->SetNumberOfThreads( numberOfThreads );
+  tree->GenerateTree();
+
+  TreeSearchType::Pointer treeSearch = TreeSearchType::New();
+  treeSearch->SetBinaryTree( tree );
+  treeSearch->SetKNearestNeighbors( k );
+  treeSearch->SetErrorBound( 0.0 );
+
+  const unsigned long numberOfPoints = sample->Size();
+  const unsigned int  dim            = sample->GetMeasurementVectorSize();
+
+  /** The neighbours of all data points at once. */
+  std::vector< IndexType >    allIndices( numberOfPoints * k );
+  std::vector< DistanceType > allDistances( numberOfPoints * k );
+  treeSearch->SearchAllDataPoints( &allIndices[ 0 ], &allDistances[ 0 ] );
+
+  TreeSearchType::IndexArrayType    indices;
+  TreeSearchType::DistanceArrayType distances;
+  MeasurementVectorType             qp( dim );
+  for( unsigned long i = 0; i < numberOfPoints; ++i )
+  {
+    sample->GetMeasurementVector( i, qp );
+    treeSearch->Search( qp, indices, distances );
+    if( !CheckNeighbours( sample, qp.data_block(), k, indices.data_block(), distances.data_block() ) )
+    {
+      std::cerr << "  for data point " << i << "." << std::endl;
+      return false;
+    }
+
+    /** The threaded search visits the same nodes, so the results are identical. */
+    for( unsigned int j = 0; j < k; ++j )
+    {
+      if( allIndices[ i * k + j ] != indices[ j ] || allDistances[ i * k + j ] != distances[ j ] )
+      {
+        std::cerr << "ERROR: SearchAllDataPoints() gives neighbour " << j << " of data point " << i
+                  << " as point " << allIndices[ i * k + j ] << " at " << allDistances[ i * k + j ]
+                  << ", while Search() gives point " << indices[ j ] << " at " << distances[ j ]
+                  << "." << std::endl;
+        return false;
+      }
+    }
+  }
+
+  /** Random query points, partly outside the data. */
+  RandomGeneratorType::Pointer generator = RandomGeneratorType::New();
+  generator->Initialize( 1234 );
+  for( unsigned int q = 0; q < 200; ++q )
+  {
+    for( unsigned int d = 0; d < dim; ++d )
+    {
+      qp[ d ] = generator->GetUniformVariate( -2.0, 12.0 );
+    }
+    treeSearch->Search( qp, indices, distances );
+    if( !CheckNeighbours( sample, qp.data_block(), k, indices.data_block(), distances.data_block() ) )
+    {
+      std::cerr << "  for query point " << qp << "." << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+
+} // end TestTree()
+
+
+int
+main( int argc, char * argv[] )
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+
+  /** Points on a coarse grid, so that many points have the same coordinates
+   * along a dimension, and many distances are equal. Every tenth point
+   * duplicates an earlier one.
+   */
+  const unsigned int  dim            = 3;
+  const unsigned long numberOfPoints = 1500;
+  ListSampleType::Pointer sample = ListSampleType::New();
+  sample->SetMeasurementVectorSize( dim );
+  sample->Resize( numberOfPoints );
+  sample->SetActualSize( numberOfPoints );
+
+  RandomGeneratorType::Pointer generator = RandomGeneratorType::New();
+  generator->Initialize( 5678 );
+  for( unsigned long i = 0; i < numberOfPoints; ++i )
+  {
+    for( unsigned int d = 0; d < dim; ++d )
+    {
+      const double value = ( i % 10 == 9 )
+        ? sample->GetInternalContainer()[ i / 2 ][ d ]
+        : 0.5 * generator->GetIntegerVariate( 20 );
+      sample->SetMeasurement( i, d, value );
+    }
+  }
+
+  /** Bucket size 1 and larger, k smaller and larger than a bucket,
+   * with one and with several threads.
+   */
+  bool ok = true;
+  ok &= TestTree( sample, 1, 1, 1 );
+  ok &= TestTree( sample, 1, 5, 4 );
+  ok &= TestTree( sample, 8, 3, 4 );
+  ok &= TestTree( sample, 8, 20, 4 );
+  ok &= TestTree( sample, 8, 20, 1 );
+
+  /** A tree with fewer points than neighbours. */
+  ListSampleType::Pointer smallSample = ListSampleType::New();
+  smallSample->SetMeasurementVectorSize( dim );
+  smallSample->Resize( 6 );
+  smallSample->SetActualSize( 6 );
+  for( unsigned long i = 0; i < 6; ++i )
+  {
+    for( unsigned int d = 0; d < dim; ++d )
+    {
+      smallSample->SetMeasurement( i, d, static_cast< double >( ( i * ( d + 1 ) ) % 4 ) );
+    }
+  }
+  ok &= TestTree( smallSample, 2, 9, 2 );
+
+  if( !ok )
+  {
+    return 1;
+  }
+
+  std::cerr << "The results are good." << std::endl;
+
+  /** Return a value. */
+  return 0;
+
+} // end main
@@ -0,0 +1,141 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkGenericMultiResolutionPyramidImageFilter.h"
+
+#include "itkImage.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+// This test compares the cascaded computation of the pyramid levels with the
+// computation of each level from the input image, and checks that the levels
+// that are no longer needed are released.
+
+int
+main( int argc, char * argv[] )
+{
+  const unsigned int Dimension = 3;
+  typedef itk::Image< float, Dimension >                                    ImageType;
+  typedef itk::GenericMultiResolutionPyramidImageFilter< ImageType, ImageType > PyramidType;
+  typedef itk::ImageRegionConstIterator< ImageType >                        ConstIteratorType;
+  typedef itk::ImageRegionIteratorWithIndex< ImageType >                    IteratorType;
+
+  /** Create a smooth input image. */
+  ImageType::SizeType size;
+  size.Fill( 48 );
+  ImageType::SpacingType spacing;
+  spacing[ 0 ] = 1.0; spacing[ 1 ] = 1.5; spacing[ 2 ] = 2.0;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( ImageType::RegionType( size ) );
+  image->SetSpacing( spacing );
+  image->Allocate();
+  for( IteratorType it( image, image->GetLargestPossibleRegion() ); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    it.Set( static_cast< float >( 100.0
+      + 20.0 * std::sin( 0.15 * index[ 0 ] ) * std::cos( 0.1 * index[ 1 ] )
+      + 0.5 * index[ 2 ] ) );
+  }
+
+  const unsigned int numberOfLevels = 3;
+  for( unsigned int useShrinker = 0; useShrinker < 2; ++useShrinker )
+  {
+    PyramidType::Pointer direct = PyramidType::New();
+    direct->SetNumberOfLevels( numberOfLevels );
+    direct->SetUseShrinkImageFilter( useShrinker == 1 );
+    direct->SetInput( image );
+
+    PyramidType::Pointer cascaded = PyramidType::New();
+    cascaded->SetNumberOfLevels( numberOfLevels );
+    cascaded->SetUseShrinkImageFilter( useShrinker == 1 );
+    cascaded->SetComputeLevelsCascaded( true );
+    cascaded->SetInput( image );
+
+    try
+    {
+      direct->Update();
+      cascaded->Update();
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      std::cerr << excp << std::endl;
+      return 1;
+    }
+
+    /** The finest level is the input itself, and is shared. */
+    if( cascaded->GetOutput( numberOfLevels - 1 )->GetBufferPointer() != image->GetBufferPointer() )
+    {
+      std::cerr << "ERROR: the finest level does not share the input buffer." << std::endl;
+      return 1;
+    }
+
+    /** The coarser levels approximate the directly computed levels, away from the border. */
+    for( unsigned int level = 0; level < numberOfLevels; ++level )
+    {
+      const ImageType * directLevel   = direct->GetOutput( level );
+      const ImageType * cascadedLevel = cascaded->GetOutput( level );
+      if( directLevel->GetLargestPossibleRegion() != cascadedLevel->GetLargestPossibleRegion() )
+      {
+        std::cerr << "ERROR: the regions of level " << level << " differ." << std::endl;
+        return 1;
+      }
+
+      ImageType::RegionType interior = directLevel->GetLargestPossibleRegion();
+      interior.ShrinkByRadius( interior.GetSize( 0 ) / 4 );
+      ConstIteratorType itD( directLevel, interior );
+      ConstIteratorType itC( cascadedLevel, interior );
+      double maxDifference = 0.0;
+      for( ; !itD.IsAtEnd(); ++itD, ++itC )
+      {
+        maxDifference = std::max( maxDifference,
+          static_cast< double >( std::abs( itD.Get() - itC.Get() ) ) );
+      }
+      std::cout << "level " << level << ( useShrinker ? " (shrinker)" : " (resampler)" )
+                << ": max difference " << maxDifference << std::endl;
+      if( maxDifference > 0.5 )
+      {
+        std::cerr << "ERROR: the cascaded level " << level << " differs too much." << std::endl;
+        return 1;
+      }
+    }
+
+    /** Moving to the next level releases the coarser level, without recomputation. */
+    const float * finestBuffer = cascaded->GetOutput( numberOfLevels - 1 )->GetBufferPointer();
+    const float * level1Buffer = cascaded->GetOutput( 1 )->GetBufferPointer();
+    cascaded->SetCurrentLevel( 1 );
+    cascaded->GetOutput( 1 )->Update();
+    if( cascaded->GetOutput( 0 )->GetBufferedRegion().GetNumberOfPixels() != 0 )
+    {
+      std::cerr << "ERROR: level 0 has not been released." << std::endl;
+      return 1;
+    }
+    if( cascaded->GetOutput( 1 )->GetBufferPointer() != level1Buffer
+      || cascaded->GetOutput( numberOfLevels - 1 )->GetBufferPointer() != finestBuffer )
+    {
+      std::cerr << "ERROR: the remaining levels have been recomputed." << std::endl;
+      return 1;
+    }
+  }
+
+  return 0;
+
+} // end main
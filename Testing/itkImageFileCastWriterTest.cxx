@@ -0,0 +1,232 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+/** \file
+ \brief Compare the streamed writing of images with the ImageFileCastWriter with writing at once.
+ */
+
+#include "itkImageFileCastWriter.h"
+
+#include "itkImage.h"
+#include "itkImageFileReader.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itksys/SystemTools.hxx"
+
+#include <string>
+
+const unsigned int Dimension = 3;
+typedef itk::Image< float, Dimension >             ImageType;
+typedef ImageType::RegionType                      RegionType;
+typedef itk::ImageFileCastWriter< ImageType >      WriterType;
+
+//-------------------------------------------------------------------------------------
+
+// Create an image with a non-zero start index and pixel values with fractions,
+// which change when they are cast
+ImageType::Pointer
+CreateTestImage( void )
+{
+  ImageType::SizeType size;
+  size[ 0 ] = 23; size[ 1 ] = 17; size[ 2 ] = 11;
+  ImageType::IndexType start;
+  start[ 0 ] = 3; start[ 1 ] = -2; start[ 2 ] = 4;
+  ImageType::SpacingType spacing;
+  spacing[ 0 ] = 0.5; spacing[ 1 ] = 1.5; spacing[ 2 ] = 2.0;
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( RegionType( start, size ) );
+  image->SetSpacing( spacing );
+  image->Allocate();
+
+  unsigned int                          value = 0;
+  itk::ImageRegionIterator< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it, ++value )
+  {
+    it.Set( static_cast< float >( ( value * 7 ) % 251 ) * 1.37f - 100.0f );
+  }
+  return image;
+
+} // end CreateTestImage()
+
+//-------------------------------------------------------------------------------------
+
+// Write the image at once
+void
+WriteAtOnce( const ImageType * image, const std::string & fileName, const std::string & componentType )
+{
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetFileName( fileName );
+  writer->SetOutputComponentType( componentType.c_str() );
+  writer->Update();
+
+} // end WriteAtOnce()
+
+//-------------------------------------------------------------------------------------
+
+// Write the image in slabs along the last dimension, as the ResamplerBase does:
+// each slab is an image with the largest possible region of the whole image,
+// of which only the slab is buffered, and it is pasted into the file
+void
+WriteInSlabs( const ImageType * image, const std::string & fileName,
+  const std::string & componentType, const unsigned int numberOfSlabs )
+{
+  itksys::SystemTools::RemoveFile( fileName.c_str() );
+
+  const RegionType         largestRegion    = image->GetLargestPossibleRegion();
+  const unsigned int       slowestDimension = Dimension - 1;
+  const itk::SizeValueType slowestSize      = largestRegion.GetSize( slowestDimension );
+  for( unsigned int k = 0; k < numberOfSlabs; ++k )
+  {
+    const itk::SizeValueType begin = slowestSize * k / numberOfSlabs;
+    const itk::SizeValueType end   = slowestSize * ( k + 1 ) / numberOfSlabs;
+    RegionType slabRegion = largestRegion;
+    slabRegion.SetIndex( slowestDimension, largestRegion.GetIndex( slowestDimension ) + begin );
+    slabRegion.SetSize( slowestDimension, end - begin );
+
+    ImageType::Pointer slab = ImageType::New();
+    slab->CopyInformation( image );
+    slab->SetRegions( slabRegion );
+    slab->SetLargestPossibleRegion( largestRegion );
+    slab->Allocate();
+    itk::ImageRegionConstIterator< ImageType > inIt( image, slabRegion );
+    itk::ImageRegionIterator< ImageType >      outIt( slab, slabRegion );
+    for( inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt )
+    {
+      outIt.Set( inIt.Get() );
+    }
+
+    itk::ImageIORegion ioRegion( Dimension );
+    for( unsigned int i = 0; i < Dimension; ++i )
+    {
+      ioRegion.SetIndex( i, slabRegion.GetIndex( i ) - largestRegion.GetIndex( i ) );
+      ioRegion.SetSize( i, slabRegion.GetSize( i ) );
+    }
+
+    WriterType::Pointer writer = WriterType::New();
+    writer->SetInput( slab );
+    writer->SetFileName( fileName );
+    writer->SetOutputComponentType( componentType.c_str() );
+    writer->SetIORegion( ioRegion );
+    writer->Update();
+  }
+
+} // end WriteInSlabs()
+
+//-------------------------------------------------------------------------------------
+
+// Write the fully buffered image with the streaming of the ImageFileWriter,
+// so that each written piece is a part of the buffered region
+void
+WriteStreamed( const ImageType * image, const std::string & fileName,
+  const std::string & componentType, const unsigned int numberOfDivisions )
+{
+  itksys::SystemTools::RemoveFile( fileName.c_str() );
+
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetFileName( fileName );
+  writer->SetOutputComponentType( componentType.c_str() );
+  writer->SetNumberOfStreamDivisions( numberOfDivisions );
+  writer->Update();
+
+} // end WriteStreamed()
+
+//-------------------------------------------------------------------------------------
+
+// Check that two files contain the same image
+template< class TDiskPixel >
+bool
+CompareFiles( const std::string & expectedFileName, const std::string & actualFileName )
+{
+  typedef itk::Image< TDiskPixel, Dimension >    DiskImageType;
+  typedef itk::ImageFileReader< DiskImageType > ReaderType;
+
+  typename ReaderType::Pointer expectedReader = ReaderType::New();
+  expectedReader->SetFileName( expectedFileName );
+  expectedReader->Update();
+  typename ReaderType::Pointer actualReader = ReaderType::New();
+  actualReader->SetFileName( actualFileName );
+  actualReader->Update();
+
+  const DiskImageType * expected = expectedReader->GetOutput();
+  const DiskImageType * actual   = actualReader->GetOutput();
+  if( actual->GetLargestPossibleRegion() != expected->GetLargestPossibleRegion()
+    || actual->GetSpacing() != expected->GetSpacing() )
+  {
+    std::cerr << "ERROR: the geometry of " << actualFileName << " differs from that of "
+              << expectedFileName << "." << std::endl;
+    return false;
+  }
+
+  itk::ImageRegionConstIterator< DiskImageType > expectedIt( expected, expected->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< DiskImageType > actualIt( actual, actual->GetLargestPossibleRegion() );
+  for( ; !expectedIt.IsAtEnd(); ++expectedIt, ++actualIt )
+  {
+    if( actualIt.Get() != expectedIt.Get() )
+    {
+      std::cerr << "ERROR: " << actualFileName << " has " << actualIt.Get() << " at index "
+                << expectedIt.GetIndex() << ", while " << expectedFileName << " has "
+                << expectedIt.Get() << "." << std::endl;
+      return false;
+    }
+  }
+  return true;
+
+} // end CompareFiles()
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  if( argc != 2 )
+  {
+    std::cerr << "ERROR: Usage: " << argv[ 0 ] << " outputDirectory" << std::endl;
+    return 1;
+  }
+  const std::string outputDirectory = argv[ 1 ];
+
+  ImageType::Pointer image = CreateTestImage();
+
+  /** Cast to short, as for the default ResultImagePixelType. */
+  const std::string shortAtOnce = outputDirectory + "/ImageFileCastWriterShortAtOnce.mha";
+  const std::string shortSlabs = outputDirectory + "/ImageFileCastWriterShortSlabs.mha";
+  const std::string shortStreamed = outputDirectory + "/ImageFileCastWriterShortStreamed.mha";
+  WriteAtOnce( image, shortAtOnce, "short" );
+  WriteInSlabs( image, shortSlabs, "short", 4 );
+  if( !CompareFiles< short >( shortAtOnce, shortSlabs ) ) { return 1; }
+  WriteStreamed( image, shortStreamed, "short", 3 );
+  if( !CompareFiles< short >( shortAtOnce, shortStreamed ) ) { return 1; }
+
+  /** Without a cast. */
+  const std::string floatAtOnce = outputDirectory + "/ImageFileCastWriterFloatAtOnce.mha";
+  const std::string floatSlabs = outputDirectory + "/ImageFileCastWriterFloatSlabs.mha";
+  const std::string floatStreamed = outputDirectory + "/ImageFileCastWriterFloatStreamed.mha";
+  WriteAtOnce( image, floatAtOnce, "float" );
+  WriteInSlabs( image, floatSlabs, "float", 4 );
+  if( !CompareFiles< float >( floatAtOnce, floatSlabs ) ) { return 1; }
+  WriteStreamed( image, floatStreamed, "float", 3 );
+  if( !CompareFiles< float >( floatAtOnce, floatStreamed ) ) { return 1; }
+
+  std::cerr << "The results are good." << std::endl;
+
+  /** Return a value. */
+  return 0;
+
+} // end main
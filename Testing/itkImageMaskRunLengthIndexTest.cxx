@@ -0,0 +1,130 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+/** \file
+ \brief Compare the ImageMaskRunLengthIndex with a plain enumeration of the voxels inside a mask.
+ */
+
+#include "itkImageMaskRunLengthIndex.h"
+
+#include "itkImage.h"
+#include "itkImageMaskSpatialObject.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <vector>
+
+int
+main( int argc, char * argv[] )
+{
+  const unsigned int Dimension = 3;
+  typedef itk::Image< short, Dimension >              ImageType;
+  typedef itk::Image< unsigned char, Dimension >      MaskImageType;
+  typedef itk::ImageMaskSpatialObject< Dimension >    MaskType;
+  typedef itk::ImageMaskRunLengthIndex< ImageType >   MaskIndexType;
+
+  /** Create an image and a mask with a sphere and a few isolated voxels. */
+  ImageType::SizeType size;
+  size[ 0 ] = 31; size[ 1 ] = 27; size[ 2 ] = 23;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  MaskImageType::Pointer maskImage = MaskImageType::New();
+  maskImage->SetRegions( size );
+  maskImage->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< MaskImageType > it( maskImage, maskImage->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType index = it.GetIndex();
+    double                     r2    = 0.0;
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      const double x = index[ d ] - 12.0;
+      r2 += x * x;
+    }
+    it.Set( r2 < 64.0 || ( index[ 0 ] == 30 && index[ 1 ] % 5 == 0 ) ? 1 : 0 );
+  }
+
+  MaskType::Pointer mask = MaskType::New();
+  mask->SetImage( maskImage );
+
+  /** Use a region that cuts the sphere. */
+  ImageType::RegionType region = image->GetLargestPossibleRegion();
+  ImageType::IndexType  start;
+  start[ 0 ] = 3; start[ 1 ] = 10; start[ 2 ] = 0;
+  ImageType::SizeType regionSize;
+  regionSize[ 0 ] = 28; regionSize[ 1 ] = 15; regionSize[ 2 ] = 20;
+  region.SetIndex( start );
+  region.SetSize( regionSize );
+
+  /** The expected voxels, in raster order. */
+  std::vector< ImageType::IndexType > expected;
+  itk::ImageRegionIteratorWithIndex< MaskImageType > rit( maskImage, region );
+  for( rit.GoToBegin(); !rit.IsAtEnd(); ++rit )
+  {
+    if( rit.Get() != 0 )
+    {
+      expected.push_back( rit.GetIndex() );
+    }
+  }
+
+  MaskIndexType::Pointer maskIndex = MaskIndexType::New();
+  maskIndex->Build( image, region, mask );
+  if( maskIndex->GetNumberOfVoxels() != expected.size() || expected.empty() )
+  {
+    std::cerr << "ERROR: the index has " << maskIndex->GetNumberOfVoxels()
+              << " voxels, while " << expected.size() << " are expected." << std::endl;
+    return 1;
+  }
+  for( std::size_t k = 0; k < expected.size(); ++k )
+  {
+    if( maskIndex->GetIndex( k ) != expected[ k ] )
+    {
+      std::cerr << "ERROR: voxel " << k << " of the index is " << maskIndex->GetIndex( k )
+                << ", while " << expected[ k ] << " is expected." << std::endl;
+      return 1;
+    }
+  }
+  if( maskIndex->GetIndexOfUniformVariate( 1.0 ) != expected.back() )
+  {
+    std::cerr << "ERROR: a uniform variate of 1 does not give the last voxel." << std::endl;
+    return 1;
+  }
+
+  /** A second build should be skipped, a changed mask should be indexed again. */
+  const itk::ModifiedTimeType buildTime = maskIndex->GetMTime();
+  maskIndex->Build( image, region, mask );
+  if( maskIndex->GetMTime() != buildTime )
+  {
+    std::cerr << "ERROR: the index was built again, without changes." << std::endl;
+    return 1;
+  }
+  maskImage->FillBuffer( 0 );
+  mask->SetImage( maskImage );
+  maskIndex->Build( image, region, mask );
+  if( maskIndex->GetNumberOfVoxels() != 0 )
+  {
+    std::cerr << "ERROR: the index was not built again for the empty mask." << std::endl;
+    return 1;
+  }
+
+  std::cerr << "The results are good." << std::endl;
+
+  /** Return a value. */
+  return 0;
+
+} // end main
@@ -0,0 +1,152 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+/** \file
+ \brief Check that the counter-based random samples do not depend on the number of threads.
+ */
+
+#include "itkImageRandomSampler.h"
+#include "itkImageRandomCoordinateSampler.h"
+#include "itkPhiloxRandomNumberGenerator.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIterator.h"
+
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+
+// Select the samples of the first iteration, with the given number of threads
+template< class TSampler >
+std::vector< typename TSampler::ImageSampleType >
+SelectSamples( TSampler * sampler, const bool useMultiThread, const unsigned int numberOfThreads )
+{
+  sampler->SetUseMultiThread( useMultiThread );
+  sampler->SetNumberOfThreads( numberOfThreads );
+  sampler->SetIteration( 0 );
+  sampler->Modified();
+  sampler->Update();
+
+  const typename TSampler::ImageSampleContainerType * container = sampler->GetOutput();
+  return std::vector< typename TSampler::ImageSampleType >( container->begin(), container->end() );
+
+} // end SelectSamples()
+
+//-------------------------------------------------------------------------------------
+
+// Compare the samples of the single-threaded and the multi-threaded versions
+template< class TSampler >
+bool
+CompareSamples( TSampler * sampler, const char * name )
+{
+  typedef typename TSampler::ImageSampleType SampleType;
+
+  sampler->UseCounterBasedRandomNumbersOn();
+  sampler->SetSeed( 1234 );
+  sampler->SetNumberOfSamples( 1001 );
+
+  const std::vector< SampleType > reference = SelectSamples( sampler, false, 1 );
+  if( reference.size() != 1001 )
+  {
+    std::cerr << "ERROR: " << name << " produced " << reference.size() << " samples." << std::endl;
+    return false;
+  }
+
+  const unsigned int numbersOfThreads[] = { 1, 3, 8 };
+  for( unsigned int t = 0; t < 3; ++t )
+  {
+    const std::vector< SampleType > samples = SelectSamples( sampler, true, numbersOfThreads[ t ] );
+    for( std::size_t i = 0; i < reference.size(); ++i )
+    {
+      if( i >= samples.size()
+        || samples[ i ].m_ImageCoordinates != reference[ i ].m_ImageCoordinates
+        || samples[ i ].m_ImageValue != reference[ i ].m_ImageValue )
+      {
+        std::cerr << "ERROR: " << name << " sample " << i << " differs with "
+                  << numbersOfThreads[ t ] << " threads." << std::endl;
+        return false;
+      }
+    }
+  }
+
+  /** The next iteration should give other samples. */
+  sampler->Modified();
+  sampler->Update();
+  if( sampler->GetIteration() != 2
+    || sampler->GetOutput()->ElementAt( 0 ).m_ImageCoordinates == reference[ 0 ].m_ImageCoordinates )
+  {
+    std::cerr << "ERROR: " << name << " did not select new samples." << std::endl;
+    return false;
+  }
+
+  return true;
+
+} // end CompareSamples()
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  /** Check the generator with the known answers of the Philox4x32-10 algorithm. */
+  const uint32_t counter[ 4 ] = { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 };
+  const uint32_t key[ 2 ]     = { 0xa4093822, 0x299f31d0 };
+  const uint32_t answer[ 4 ]  = { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 };
+  uint32_t       result[ 4 ];
+  itk::PhiloxRandomNumberGenerator::Philox( counter, key, result );
+  for( unsigned int i = 0; i < 4; ++i )
+  {
+    if( result[ i ] != answer[ i ] )
+    {
+      std::cerr << "ERROR: the Philox generator gives wrong numbers." << std::endl;
+      return 1;
+    }
+  }
+
+  /** Create an image with a different value for every pixel. */
+  typedef itk::Image< short, 3 >                         ImageType;
+  typedef itk::ImageRandomSampler< ImageType >           RandomSamplerType;
+  typedef itk::ImageRandomCoordinateSampler< ImageType > RandomCoordinateSamplerType;
+
+  ImageType::SizeType size;
+  size[ 0 ] = 20; size[ 1 ] = 21; size[ 2 ] = 22;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  itk::ImageRegionIterator< ImageType > it( image, image->GetLargestPossibleRegion() );
+  short value = 0;
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    it.Set( value++ );
+  }
+
+  RandomSamplerType::Pointer randomSampler = RandomSamplerType::New();
+  randomSampler->SetInput( image );
+  randomSampler->SetInputImageRegion( image->GetLargestPossibleRegion() );
+  if( !CompareSamples( randomSampler.GetPointer(), "ImageRandomSampler" ) ) { return 1; }
+
+  RandomCoordinateSamplerType::Pointer randomCoordinateSampler = RandomCoordinateSamplerType::New();
+  randomCoordinateSampler->SetInput( image );
+  randomCoordinateSampler->SetInputImageRegion( image->GetLargestPossibleRegion() );
+  if( !CompareSamples( randomCoordinateSampler.GetPointer(), "ImageRandomCoordinateSampler" ) ) { return 1; }
+
+  std::cerr << "The results are good." << std::endl;
+
+  /** Return a value. */
+  return 0;
+
+} // end main
@@ -0,0 +1,200 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+/** \file
+ \brief Compare the structure-of-arrays output of the image samplers with their ImageSample output.
+ */
+
+#include "itkImageFullSampler.h"
+#include "itkImageGridSampler.h"
+#include "itkImageRandomCoordinateSampler.h"
+#include "itkImageRandomSampler.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIterator.h"
+
+#include <cstdint>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+
+// Compare the two representations of the output of a sampler once
+template< class TSampler >
+bool
+CompareSamplesOnce( TSampler * sampler, const char * name )
+{
+  typedef typename TSampler::ImageSampleContainerType         ContainerType;
+  typedef typename TSampler::ImageSampleStructureOfArraysType StructureOfArraysType;
+  typedef typename StructureOfArraysType::PointType           PointType;
+  const unsigned int Dimension = StructureOfArraysType::Dimension;
+
+  sampler->Update();
+  const ContainerType *         container = sampler->GetOutput();
+  const StructureOfArraysType * samples   = sampler->GetOutputAsStructureOfArrays();
+
+  if( container->Size() == 0 || samples->Size() != container->Size() )
+  {
+    std::cerr << "ERROR: " << name << " produced " << container->Size()
+              << " samples, of which " << samples->Size() << " as arrays." << std::endl;
+    return false;
+  }
+
+  /** Check the alignment of the arrays. */
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    if( reinterpret_cast< std::uintptr_t >( samples->GetCoordinates( d ) ) % StructureOfArraysType::Alignment != 0 )
+    {
+      std::cerr << "ERROR: " << name << " coordinate array " << d << " is not aligned." << std::endl;
+      return false;
+    }
+  }
+  if( reinterpret_cast< std::uintptr_t >( samples->GetValues() ) % StructureOfArraysType::Alignment != 0 )
+  {
+    std::cerr << "ERROR: " << name << " value array is not aligned." << std::endl;
+    return false;
+  }
+
+  /** Check the contents. */
+  for( unsigned long i = 0; i < container->Size(); ++i )
+  {
+    PointType point;
+    samples->GetPoint( i, point );
+    if( point != container->ElementAt( i ).m_ImageCoordinates
+      || samples->GetValue( i ) != container->ElementAt( i ).m_ImageValue )
+    {
+      std::cerr << "ERROR: " << name << " sample " << i << " differs." << std::endl;
+      return false;
+    }
+  }
+
+  /** Gathering a block of points gives the same points. */
+  const unsigned long     begin = container->Size() / 3;
+  const unsigned long     count = container->Size() - begin;
+  std::vector< PointType > points( count );
+  samples->GetPoints( begin, count, &points[ 0 ] );
+  for( unsigned long i = 0; i < count; ++i )
+  {
+    if( points[ i ] != container->ElementAt( begin + i ).m_ImageCoordinates )
+    {
+      std::cerr << "ERROR: " << name << " gathered point " << begin + i << " differs." << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+
+} // end CompareSamplesOnce()
+
+
+// Compare the two representations of the output of a sampler. The arrays are
+// either filled by the sampler itself, or copied from its output container.
+template< class TSampler >
+bool
+CompareSamples( TSampler * sampler, const char * name )
+{
+  for( unsigned int generate = 0; generate < 2; ++generate )
+  {
+    sampler->SetGenerateStructureOfArrays( generate == 1 );
+    if( !CompareSamplesOnce( sampler, name ) ) { return false; }
+  }
+  return true;
+
+} // end CompareSamples()
+
+//-------------------------------------------------------------------------------------
+
+// Test function templated over the dimension
+template< unsigned int Dimension >
+bool
+TestSamplers( void )
+{
+  typedef itk::Image< short, Dimension >                  ImageType;
+  typedef itk::ImageFullSampler< ImageType >              FullSamplerType;
+  typedef itk::ImageGridSampler< ImageType >              GridSamplerType;
+  typedef itk::ImageRandomCoordinateSampler< ImageType >  RandomCoordinateSamplerType;
+  typedef itk::ImageRandomSampler< ImageType >            RandomSamplerType;
+
+  /** Create an image with a different value for every pixel. */
+  typename ImageType::SizeType size;
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    size[ d ] = 10 + d;
+  }
+  typename ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  itk::ImageRegionIterator< ImageType > it( image, image->GetLargestPossibleRegion() );
+  short value = 0;
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    it.Set( value++ );
+  }
+
+  typename FullSamplerType::Pointer fullSampler = FullSamplerType::New();
+  fullSampler->SetInput( image );
+  fullSampler->SetInputImageRegion( image->GetLargestPossibleRegion() );
+  if( !CompareSamples( fullSampler.GetPointer(), "ImageFullSampler" ) ) { return false; }
+
+  typename GridSamplerType::Pointer gridSampler = GridSamplerType::New();
+  gridSampler->SetInput( image );
+  gridSampler->SetInputImageRegion( image->GetLargestPossibleRegion() );
+  typename GridSamplerType::SampleGridSpacingType gridSpacing;
+  gridSpacing.Fill( 3 );
+  gridSampler->SetSampleGridSpacing( gridSpacing );
+  if( !CompareSamples( gridSampler.GetPointer(), "ImageGridSampler" ) ) { return false; }
+
+  /** The arrays should follow a new selection of samples. */
+  typename RandomCoordinateSamplerType::Pointer randomSampler = RandomCoordinateSamplerType::New();
+  randomSampler->SetInput( image );
+  randomSampler->SetInputImageRegion( image->GetLargestPossibleRegion() );
+  randomSampler->SetNumberOfSamples( 333 );
+  if( !CompareSamples( randomSampler.GetPointer(), "ImageRandomCoordinateSampler" ) ) { return false; }
+  randomSampler->SelectNewSamplesOnUpdate();
+  if( !CompareSamples( randomSampler.GetPointer(), "ImageRandomCoordinateSampler" ) ) { return false; }
+
+  /** The threads store their samples at the right position in the arrays. */
+  randomSampler->SetUseMultiThread( true );
+  randomSampler->SetNumberOfThreads( 3 );
+  if( !CompareSamples( randomSampler.GetPointer(), "threaded ImageRandomCoordinateSampler" ) ) { return false; }
+
+  typename RandomSamplerType::Pointer randomVoxelSampler = RandomSamplerType::New();
+  randomVoxelSampler->SetInput( image );
+  randomVoxelSampler->SetInputImageRegion( image->GetLargestPossibleRegion() );
+  randomVoxelSampler->SetNumberOfSamples( 101 );
+  if( !CompareSamples( randomVoxelSampler.GetPointer(), "ImageRandomSampler" ) ) { return false; }
+  randomVoxelSampler->SetUseMultiThread( true );
+  randomVoxelSampler->SetNumberOfThreads( 4 );
+  if( !CompareSamples( randomVoxelSampler.GetPointer(), "threaded ImageRandomSampler" ) ) { return false; }
+
+  return true;
+
+} // end TestSamplers()
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  if( !TestSamplers< 2 >() ) { return 1; }
+  if( !TestSamplers< 3 >() ) { return 1; }
+
+  std::cerr << "The results are good." << std::endl;
+
+  /** Return a value. */
+  return 0;
+
+} // end main
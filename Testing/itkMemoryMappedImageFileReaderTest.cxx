@@ -0,0 +1,234 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+/** \file
+ \brief Compare the memory mapped and the streamed reading of images with the ImageFileReader.
+ */
+
+#include "itkMemoryMappedImageFileReader.h"
+
+#include "itkImage.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkByteSwapper.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+
+// Write an image with a pattern of pixel values
+template< class TPixel >
+void
+WriteTestImage( const std::string & fileName )
+{
+  typedef itk::Image< TPixel, 3 >           ImageType;
+  typedef itk::ImageFileWriter< ImageType > WriterType;
+
+  typename ImageType::SizeType size;
+  size[ 0 ] = 37; size[ 1 ] = 21; size[ 2 ] = 13;
+  typename ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  unsigned int                          value = 0;
+  itk::ImageRegionIterator< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it, ++value )
+  {
+    it.Set( static_cast< TPixel >( ( value * 7 ) % 251 ) );
+  }
+
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetFileName( fileName );
+  writer->SetInput( image );
+  writer->Update();
+
+} // end WriteTestImage()
+
+//-------------------------------------------------------------------------------------
+
+// Write a float MetaImage with a detached data file by hand, with the same
+// pattern of pixel values, preceded by some junk bytes, in the given byte order
+void
+WriteDetachedMetaImage( const std::string & directory, const std::string & name,
+  const unsigned int numberOfJunkBytes, const bool headerSizeIsMinusOne, const bool bigEndian )
+{
+  const unsigned int    size[ 3 ] = { 37, 21, 13 };
+  const unsigned int    numberOfPixels = size[ 0 ] * size[ 1 ] * size[ 2 ];
+  std::vector< float >  pixels( numberOfPixels );
+  for( unsigned int i = 0; i < numberOfPixels; ++i )
+  {
+    pixels[ i ] = static_cast< float >( ( i * 7 ) % 251 );
+  }
+  if( bigEndian != itk::ByteSwapper< float >::SystemIsBigEndian() )
+  {
+    itk::ByteSwapper< float >::SwapRangeFromSystemToBigEndian( &pixels[ 0 ], numberOfPixels );
+  }
+
+  std::ofstream data( ( directory + "/" + name + ".raw" ).c_str(), std::ios::binary );
+  const std::vector< char > junk( numberOfJunkBytes, 'x' );
+  if( numberOfJunkBytes > 0 )
+  {
+    data.write( &junk[ 0 ], numberOfJunkBytes );
+  }
+  data.write( reinterpret_cast< const char * >( &pixels[ 0 ] ), numberOfPixels * sizeof( float ) );
+  data.close();
+
+  std::ofstream header( ( directory + "/" + name + ".mhd" ).c_str() );
+  header << "ObjectType = Image\n"
+         << "NDims = 3\n"
+         << "BinaryData = True\n"
+         << "BinaryDataByteOrderMSB = " << ( bigEndian ? "True" : "False" ) << "\n"
+         << "CompressedData = False\n"
+         << "DimSize = " << size[ 0 ] << " " << size[ 1 ] << " " << size[ 2 ] << "\n"
+         << "ElementSpacing = 1 1 1\n"
+         << "Offset = 0 0 0\n"
+         << "HeaderSize = " << ( headerSizeIsMinusOne ? -1 : static_cast< int >( numberOfJunkBytes ) ) << "\n"
+         << "ElementType = MET_FLOAT\n"
+         << "ElementDataFile = " << name << ".raw\n";
+  header.close();
+
+} // end WriteDetachedMetaImage()
+
+//-------------------------------------------------------------------------------------
+
+// Read an image as float with both readers, and compare
+bool
+CompareReaders( const std::string & fileName, const bool expectMapped,
+  const itk::SizeValueType maximumConversionBufferSize )
+{
+  typedef itk::Image< float, 3 >                        ImageType;
+  typedef itk::ImageFileReader< ImageType >             ReaderType;
+  typedef itk::MemoryMappedImageFileReader< ImageType > MappedReaderType;
+  typedef itk::ImageRegionConstIterator< ImageType >    IteratorType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( fileName );
+  MappedReaderType::Pointer mappedReader = MappedReaderType::New();
+  mappedReader->SetFileName( fileName );
+  mappedReader->SetMaximumConversionBufferSize( maximumConversionBufferSize );
+  try
+  {
+    reader->Update();
+    mappedReader->Update();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: reading " << fileName << " failed:\n" << excp << std::endl;
+    return false;
+  }
+
+  if( mappedReader->GetOutputIsMemoryMapped() != expectMapped )
+  {
+    std::cerr << "ERROR: " << fileName << " was " << ( expectMapped ? "not " : "" )
+              << "memory mapped." << std::endl;
+    return false;
+  }
+
+  const ImageType * image       = reader->GetOutput();
+  const ImageType * mappedImage = mappedReader->GetOutput();
+  if( mappedImage->GetLargestPossibleRegion() != image->GetLargestPossibleRegion()
+    || mappedImage->GetBufferedRegion() != image->GetBufferedRegion()
+    || mappedImage->GetSpacing() != image->GetSpacing()
+    || mappedImage->GetOrigin() != image->GetOrigin() )
+  {
+    std::cerr << "ERROR: the image information of " << fileName << " differs." << std::endl;
+    return false;
+  }
+
+  IteratorType it( image, image->GetBufferedRegion() );
+  IteratorType mit( mappedImage, mappedImage->GetBufferedRegion() );
+  for( ; !it.IsAtEnd(); ++it, ++mit )
+  {
+    if( it.Get() != mit.Get() )
+    {
+      std::cerr << "ERROR: the pixel values of " << fileName << " differ at "
+                << it.GetIndex() << ": " << it.Get() << " vs " << mit.Get() << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+
+} // end CompareReaders()
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  if( argc != 2 )
+  {
+    std::cerr << "ERROR: Usage: " << argv[ 0 ] << " outputDirectory" << std::endl;
+    return 1;
+  }
+  const std::string outputDirectory = argv[ 1 ];
+
+  /** Float images are mapped. */
+  const std::string rawFloat = outputDirectory + "/MemoryMappedImageFileReaderFloat.mhd";
+  WriteTestImage< float >( rawFloat );
+  if( !CompareReaders( rawFloat, true, 64 * 1024 * 1024 ) ) { return 1; }
+
+  /** Short images are converted, in slabs of a few slices. */
+  const std::string rawShort = outputDirectory + "/MemoryMappedImageFileReaderShort.mhd";
+  WriteTestImage< short >( rawShort );
+  if( !CompareReaders( rawShort, false, 5000 ) ) { return 1; }
+  if( !CompareReaders( rawShort, false, 1 ) ) { return 1; }
+
+  /** Raw NRRD files with attached data are mapped. */
+  const std::string nrrdFloat = outputDirectory + "/MemoryMappedImageFileReaderFloat.nrrd";
+  WriteTestImage< float >( nrrdFloat );
+  if( !CompareReaders( nrrdFloat, true, 64 * 1024 * 1024 ) ) { return 1; }
+
+  /** Detached data with a header of junk, given as HeaderSize -1 (data at
+   * the end of the file) or as the explicit size, is mapped.
+   */
+  const bool systemIsBigEndian = itk::ByteSwapper< float >::SystemIsBigEndian();
+  WriteDetachedMetaImage( outputDirectory, "MemoryMappedImageFileReaderHeaderSizeMinusOne", 123, true, systemIsBigEndian );
+  if( !CompareReaders( outputDirectory + "/MemoryMappedImageFileReaderHeaderSizeMinusOne.mhd", true, 64 * 1024 * 1024 ) ) { return 1; }
+  WriteDetachedMetaImage( outputDirectory, "MemoryMappedImageFileReaderHeaderSize", 8, false, systemIsBigEndian );
+  if( !CompareReaders( outputDirectory + "/MemoryMappedImageFileReaderHeaderSize.mhd", true, 64 * 1024 * 1024 ) ) { return 1; }
+
+  /** Data in the other byte order is not mapped, but read and swapped by the superclass. */
+  WriteDetachedMetaImage( outputDirectory, "MemoryMappedImageFileReaderSwapped", 0, false, !systemIsBigEndian );
+  if( !CompareReaders( outputDirectory + "/MemoryMappedImageFileReaderSwapped.mhd", false, 64 * 1024 * 1024 ) ) { return 1; }
+
+  /** Without memory mapping and streaming conversion, the superclass reads the image. */
+  {
+    typedef itk::Image< float, 3 >                        ImageType;
+    typedef itk::MemoryMappedImageFileReader< ImageType > MappedReaderType;
+    MappedReaderType::Pointer mappedReader = MappedReaderType::New();
+    mappedReader->SetFileName( rawFloat );
+    mappedReader->UseMemoryMappingOff();
+    mappedReader->UseStreamingConversionOff();
+    mappedReader->Update();
+    if( mappedReader->GetOutputIsMemoryMapped() )
+    {
+      std::cerr << "ERROR: the image was mapped while this was switched off." << std::endl;
+      return 1;
+    }
+  }
+
+  std::cerr << "The results are good." << std::endl;
+
+  /** Return a value. */
+  return 0;
+
+} // end main
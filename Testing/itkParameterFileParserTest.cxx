@@ -0,0 +1,309 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+/** \file
+ \brief Test the tokenizer and the parse cache of the ParameterFileParser,
+ and the cache of converted values of the ParameterMapInterface.
+ */
+
+#include "itkParameterFileParser.h"
+#include "itkParameterMapInterface.h"
+
+#include <itksys/Directory.hxx>
+#include <itksys/SystemTools.hxx>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+
+// Write a parameter file
+void
+WriteParameterFile( const std::string & fileName, const std::string & content )
+{
+  std::ofstream file( fileName.c_str(), std::ios_base::out | std::ios_base::binary );
+  file << content;
+
+} // end WriteParameterFile()
+
+//-------------------------------------------------------------------------------------
+
+// Parse a parameter file, and return whether an exception was thrown
+bool
+ParseThrows( const std::string & fileName, const std::string & content )
+{
+  WriteParameterFile( fileName, content );
+  itk::ParameterFileParser::Pointer parser = itk::ParameterFileParser::New();
+  parser->SetParameterFileName( fileName );
+  try
+  {
+    parser->ReadParameterFile();
+  }
+  catch( itk::ExceptionObject & )
+  {
+    return true;
+  }
+  return false;
+
+} // end ParseThrows()
+
+//-------------------------------------------------------------------------------------
+
+// Parse a parameter file with a parse cache, and return the cache files
+// that are in the cache directory afterwards
+std::vector< std::string >
+ParseWithCache( const std::string & fileName, const std::string & cacheDirectory,
+  itk::ParameterFileParser::Pointer & parser )
+{
+  parser = itk::ParameterFileParser::New();
+  parser->SetParameterFileName( fileName );
+  parser->SetParseCacheDirectory( cacheDirectory );
+  parser->ReadParameterFile();
+
+  std::vector< std::string > cacheFiles;
+  itksys::Directory          directory;
+  directory.Load( cacheDirectory.c_str() );
+  for( unsigned long i = 0; i < directory.GetNumberOfFiles(); ++i )
+  {
+    const std::string file = directory.GetFile( i );
+    if( file.size() > 4 && file.compare( file.size() - 4, 4, ".bin" ) == 0 )
+    {
+      cacheFiles.push_back( cacheDirectory + "/" + file );
+    }
+  }
+  return cacheFiles;
+
+} // end ParseWithCache()
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  if( argc != 2 )
+  {
+    std::cerr << "ERROR: usage: " << argv[ 0 ] << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string outputDirectory = argv[ 1 ];
+  const std::string fileName        = outputDirectory + "/ParameterFileParserTest.txt";
+
+  typedef itk::ParameterFileParser::ParameterMapType    ParameterMapType;
+  typedef itk::ParameterFileParser::ParameterValuesType ParameterValuesType;
+
+  /** A valid parameter file, with comments, tabs, quotes, and DOS line ends. */
+  const std::string content
+    = "// elastix parameter file\n"
+      "\n"
+      "(FixedImageDimension 3)   // the dimension\n"
+      "\t(Metric \"AdvancedMattesMutualInformation\")\r\n"
+      "  (GridSpacing 16.0\t8 4.5 )\n"
+      "(ResultImageFormat \"nii.gz\")\n"
+      "(Names \"a b\" \"c\"\"d\")\n"
+      "(Sign-Flip \"true\" \"false\")";
+  WriteParameterFile( fileName, content );
+
+  ParameterMapType expected;
+  expected[ "FixedImageDimension" ] = ParameterValuesType( 1, "3" );
+  expected[ "Metric" ]              = ParameterValuesType( 1, "AdvancedMattesMutualInformation" );
+  expected[ "GridSpacing" ].push_back( "16.0" );
+  expected[ "GridSpacing" ].push_back( "8" );
+  expected[ "GridSpacing" ].push_back( "4.5" );
+  expected[ "ResultImageFormat" ] = ParameterValuesType( 1, "nii.gz" );
+  expected[ "Names" ].push_back( "a b" );
+  expected[ "Names" ].push_back( "c" );
+  expected[ "Names" ].push_back( "d" );
+  expected[ "Sign-Flip" ].push_back( "true" );
+  expected[ "Sign-Flip" ].push_back( "false" );
+
+  itk::ParameterFileParser::Pointer parser = itk::ParameterFileParser::New();
+  parser->SetParameterFileName( fileName );
+  try
+  {
+    parser->ReadParameterFile();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+  if( parser->GetParameterMap() != expected )
+  {
+    std::cerr << "ERROR: the parsed parameter map differs from the expected map." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Invalid parameter files. */
+  const char * invalidContents[] = {
+    "FixedImageDimension 3\n",               // no brackets
+    "(FixedImageDimension)\n",               // no value
+    "(Metric \"AdvancedMattesMutualInformation)\n", // odd number of quotes
+    "(Fixed.ImageDimension 3)\n",            // invalid name
+    "(Fixed*ImageDimension 3)\n",            // invalid name, in the range &-+
+    "(FixedImageDimension 3;)\n",            // invalid value
+    "(FixedImageDimension 3)\n(FixedImageDimension 2)\n" // duplicate
+  };
+  for( unsigned int i = 0; i < sizeof( invalidContents ) / sizeof( invalidContents[ 0 ] ); ++i )
+  {
+    if( !ParseThrows( fileName, invalidContents[ i ] ) )
+    {
+      std::cerr << "ERROR: no exception for invalid parameter file " << i << ":\n"
+                << invalidContents[ i ] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /** The parse cache: the second parse should read the map from the cache. */
+  WriteParameterFile( fileName, content );
+  const std::string cacheDirectory = outputDirectory + "/ParameterFileParserTestCache";
+  for( unsigned int i = 0; i < 2; ++i )
+  {
+    itk::ParameterFileParser::Pointer cachedParser = itk::ParameterFileParser::New();
+    cachedParser->SetParameterFileName( fileName );
+    cachedParser->SetParseCacheDirectory( cacheDirectory );
+    try
+    {
+      cachedParser->ReadParameterFile();
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      std::cerr << excp << std::endl;
+      return EXIT_FAILURE;
+    }
+    if( cachedParser->GetParameterMap() != expected )
+    {
+      std::cerr << "ERROR: the map of parse " << i << " with the cache differs." << std::endl;
+      return EXIT_FAILURE;
+    }
+    if( i == 1 && !cachedParser->GetParameterMapIsReadFromCache() )
+    {
+      std::cerr << "ERROR: the map was not read from the parse cache." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /** A cache file with a matching name but another content, as after a hash
+   * collision, should not be used. Simulate it with a file of the same size.
+   */
+  {
+    std::string otherContent = content;
+    otherContent.replace( otherContent.find( "4.5" ), 3, "4.6" );
+    ParameterMapType otherExpected = expected;
+    otherExpected[ "GridSpacing" ][ 2 ] = "4.6";
+
+    const std::string collisionDirectory = outputDirectory + "/ParameterFileParserTestCollision";
+    itksys::SystemTools::RemoveADirectory( collisionDirectory );
+    itk::ParameterFileParser::Pointer collisionParser;
+    try
+    {
+      WriteParameterFile( fileName, content );
+      const std::vector< std::string > firstFiles
+        = ParseWithCache( fileName, collisionDirectory, collisionParser );
+      WriteParameterFile( fileName, otherContent );
+      const std::vector< std::string > bothFiles
+        = ParseWithCache( fileName, collisionDirectory, collisionParser );
+      if( firstFiles.size() != 1 || bothFiles.size() != 2 )
+      {
+        std::cerr << "ERROR: expected one cache file per parameter file." << std::endl;
+        return EXIT_FAILURE;
+      }
+      const std::string otherFile = bothFiles[ 0 ] == firstFiles[ 0 ] ? bothFiles[ 1 ] : bothFiles[ 0 ];
+      itksys::SystemTools::CopyFileAlways( firstFiles[ 0 ], otherFile );
+      ParseWithCache( fileName, collisionDirectory, collisionParser );
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      std::cerr << excp << std::endl;
+      return EXIT_FAILURE;
+    }
+    if( collisionParser->GetParameterMapIsReadFromCache()
+      || collisionParser->GetParameterMap() != otherExpected )
+    {
+      std::cerr << "ERROR: the parse cache returned the map of another parameter file." << std::endl;
+      return EXIT_FAILURE;
+    }
+    WriteParameterFile( fileName, content );
+  }
+
+  /** Repeated reads through the cache of converted values. */
+  itk::ParameterMapInterface::Pointer parameterMapInterface = itk::ParameterMapInterface::New();
+  parameterMapInterface->SetParameterMap( expected );
+  std::string errorMessage = "";
+  for( unsigned int i = 0; i < 3; ++i )
+  {
+    double       spacing   = 0.0;
+    unsigned int intValue  = 0;
+    std::string  name      = "";
+    bool         boolValue = false;
+    bool         found     = true;
+    found &= parameterMapInterface->ReadParameter( spacing, "GridSpacing", 2, errorMessage );
+    found &= parameterMapInterface->ReadParameter( intValue, "GridSpacing", 1, errorMessage );
+    found &= parameterMapInterface->ReadParameter( name, "Names", 0, errorMessage );
+    found &= parameterMapInterface->ReadParameter( boolValue, "Sign-Flip", 0, errorMessage );
+    if( !found || spacing != 4.5 || intValue != 8 || name != "a b" || !boolValue )
+    {
+      std::cerr << "ERROR: read " << spacing << ", " << intValue << ", \""
+                << name << "\", " << boolValue << " in iteration " << i << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    std::vector< double > spacings( 3, 0.0 );
+    if( !parameterMapInterface->ReadParameter( spacings, "GridSpacing", 0, 2, true, errorMessage )
+      || spacings[ 0 ] != 16.0 || spacings[ 1 ] != 8.0 || spacings[ 2 ] != 4.5 )
+    {
+      std::cerr << "ERROR: reading the range of GridSpacing failed." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /** A failing cast should keep failing. */
+  for( unsigned int i = 0; i < 2; ++i )
+  {
+    double metric = 0.0;
+    bool   thrown = false;
+    try
+    {
+      parameterMapInterface->ReadParameter( metric, "Metric", 0, errorMessage );
+    }
+    catch( itk::ExceptionObject & )
+    {
+      thrown = true;
+    }
+    if( !thrown )
+    {
+      std::cerr << "ERROR: casting a string to double did not throw." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /** A new map replaces the cached values. */
+  ParameterMapType newMap = expected;
+  newMap[ "GridSpacing" ][ 2 ] = "2.5";
+  parameterMapInterface->SetParameterMap( newMap );
+  double spacing = 0.0;
+  parameterMapInterface->ReadParameter( spacing, "GridSpacing", 2, errorMessage );
+  if( spacing != 2.5 )
+  {
+    std::cerr << "ERROR: the cache was not cleared by SetParameterMap()." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
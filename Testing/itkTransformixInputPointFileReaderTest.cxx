@@ -0,0 +1,201 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkTransformixInputPointFileReader.h"
+#include "itkPointSet.h"
+#include "itkDefaultStaticMeshTraits.h"
+#include "itkByteSwapper.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  if( argc != 2 )
+  {
+    std::cerr << "ERROR: Usage: " << argv[ 0 ] << " outputDirectory" << std::endl;
+    return 1;
+  }
+  const std::string outputDirectory = argv[ 1 ];
+
+  const unsigned int Dimension = 3;
+  typedef itk::DefaultStaticMeshTraits< unsigned char, Dimension, Dimension, double > MeshTraitsType;
+  typedef itk::PointSet< unsigned char, Dimension, MeshTraitsType >                   PointSetType;
+  typedef itk::TransformixInputPointFileReader< PointSetType >                        ReaderType;
+  typedef PointSetType::PointType                                                     PointType;
+
+  /** The fast path of the number parser should agree exactly with strtod. */
+  const char * numbers[] = {
+    "0", "-0", "1", "+1.5", "-3.25e-3", "0.1", "0.3", "4.35", "1e22", "1e23",
+    "9007199254740993", "123456789012345678901234", "1.7976931348623157e308",
+    "4.9e-324", "-12.000001", "1E5", "7.", "inf"
+  };
+  for( unsigned int i = 0; i < sizeof( numbers ) / sizeof( numbers[ 0 ] ); ++i )
+  {
+    double       value    = 0.0;
+    const double expected = std::strtod( numbers[ i ], 0 );
+    const char * end      = numbers[ i ] + std::strlen( numbers[ i ] );
+    if( !ReaderType::ParseNumber( numbers[ i ], end, value )
+      || std::memcmp( &value, &expected, sizeof( double ) ) != 0 )
+    {
+      std::cerr << "ERROR: \"" << numbers[ i ] << "\" is parsed as " << value << std::endl;
+      return 1;
+    }
+  }
+  const char * notNumbers[] = { "", "+", ".", "e5", "1e", "1,5", "1.2.3" };
+  for( unsigned int i = 0; i < sizeof( notNumbers ) / sizeof( notNumbers[ 0 ] ); ++i )
+  {
+    double value = 0.0;
+    if( ReaderType::ParseNumber( notNumbers[ i ], notNumbers[ i ] + std::strlen( notNumbers[ i ] ), value ) )
+    {
+      std::cerr << "ERROR: \"" << notNumbers[ i ] << "\" is accepted as a number." << std::endl;
+      return 1;
+    }
+  }
+
+  /** Create points, enough for several blocks of the text reader. */
+  const unsigned long numberOfPoints = 100000;
+  std::vector< PointType > points( numberOfPoints );
+  for( unsigned long i = 0; i < numberOfPoints; ++i )
+  {
+    for( unsigned int j = 0; j < Dimension; ++j )
+    {
+      points[ i ][ j ] = ( static_cast< double >( i ) - 5000.0 ) / ( j + 3.0 );
+    }
+  }
+
+  /** A text file, with the formatting of a typical input point file. */
+  const std::string textFileName = outputDirectory + "/TransformixInputPointFileReaderTest.txt";
+  {
+    std::ofstream file( textFileName.c_str() );
+    file << "point\n" << numberOfPoints << "\n";
+    file.precision( 17 );
+    for( unsigned long i = 0; i < numberOfPoints; ++i )
+    {
+      file << points[ i ][ 0 ] << "\t" << points[ i ][ 1 ] << "  " << points[ i ][ 2 ] << "\r\n";
+    }
+  }
+
+  /** Binary files, in single and double precision. */
+  const std::string binaryFileNames[ 2 ] = {
+    outputDirectory + "/TransformixInputPointFileReaderTest_float.bin",
+    outputDirectory + "/TransformixInputPointFileReaderTest_double.bin"
+  };
+  for( unsigned int k = 0; k < 2; ++k )
+  {
+    const unsigned int componentSize = k == 0 ? 4 : 8;
+    std::ofstream      file( binaryFileNames[ k ].c_str(), std::ios::out | std::ios::binary );
+    ReaderType::WriteBinaryHeader( file, componentSize, Dimension, true, numberOfPoints );
+    for( unsigned long i = 0; i < numberOfPoints; ++i )
+    {
+      for( unsigned int j = 0; j < Dimension; ++j )
+      {
+        float  valueFloat  = static_cast< float >( points[ i ][ j ] );
+        double valueDouble = points[ i ][ j ];
+        itk::ByteSwapper< float >::SwapFromSystemToLittleEndian( &valueFloat );
+        itk::ByteSwapper< double >::SwapFromSystemToLittleEndian( &valueDouble );
+        if( componentSize == 4 )
+        {
+          file.write( reinterpret_cast< const char * >( &valueFloat ), componentSize );
+        }
+        else
+        {
+          file.write( reinterpret_cast< const char * >( &valueDouble ), componentSize );
+        }
+      }
+    }
+  }
+
+  /** Read all files back. */
+  const std::string fileNames[ 3 ] = { textFileName, binaryFileNames[ 0 ], binaryFileNames[ 1 ] };
+  for( unsigned int k = 0; k < 3; ++k )
+  {
+    ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileName( fileNames[ k ].c_str() );
+    try
+    {
+      reader->Update();
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      std::cerr << "ERROR: reading " << fileNames[ k ] << " failed:\n" << excp << std::endl;
+      return 1;
+    }
+
+    const bool isBinary = k > 0;
+    if( reader->GetPointsAreBinary() != isBinary || reader->GetPointsAreIndices() != isBinary
+      || reader->GetNumberOfPoints() != numberOfPoints
+      || reader->GetOutput()->GetNumberOfPoints() != numberOfPoints )
+    {
+      std::cerr << "ERROR: wrong header information for " << fileNames[ k ] << std::endl;
+      return 1;
+    }
+
+    for( unsigned long i = 0; i < numberOfPoints; ++i )
+    {
+      const PointType point = reader->GetOutput()->GetPoints()->ElementAt( i );
+      for( unsigned int j = 0; j < Dimension; ++j )
+      {
+        const double expected = k == 1
+          ? static_cast< double >( static_cast< float >( points[ i ][ j ] ) ) : points[ i ][ j ];
+        if( point[ j ] != expected )
+        {
+          std::cerr << "ERROR: coordinate " << j << " of point " << i << " of " << fileNames[ k ]
+                    << " is " << point[ j ] << " instead of " << expected << std::endl;
+          return 1;
+        }
+      }
+    }
+  }
+
+  /** A truncated binary file should be reported. */
+  {
+    const std::string truncatedFileName = outputDirectory + "/TransformixInputPointFileReaderTest_truncated.bin";
+    std::ofstream     file( truncatedFileName.c_str(), std::ios::out | std::ios::binary );
+    ReaderType::WriteBinaryHeader( file, 8, Dimension, false, numberOfPoints );
+    file.close();
+
+    ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileName( truncatedFileName.c_str() );
+    bool exceptionCaught = false;
+    try
+    {
+      reader->Update();
+    }
+    catch( itk::ExceptionObject & )
+    {
+      exceptionCaught = true;
+    }
+    if( !exceptionCaught )
+    {
+      std::cerr << "ERROR: no exception for a truncated binary point file." << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "Test passed." << std::endl;
+  return 0;
+
+} // end main
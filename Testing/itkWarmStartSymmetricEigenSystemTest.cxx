@@ -0,0 +1,137 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+/** \file
+ \brief Compare the WarmStartSymmetricEigenSystem with vnl_symmetric_eigensystem, for a slowly changing matrix.
+ */
+
+#include "itkWarmStartSymmetricEigenSystem.h"
+
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "vnl/algo/vnl_symmetric_eigensystem.h"
+
+#include <cmath>
+#include <iostream>
+
+int
+main( int argc, char * argv[] )
+{
+  typedef itk::WarmStartSymmetricEigenSystem< double > EigenSystemType;
+  typedef EigenSystemType::MatrixType                  MatrixType;
+  typedef EigenSystemType::VectorType                  VectorType;
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+
+  RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::New();
+  randomGenerator->Initialize( 5489 );
+
+  /** A random symmetric matrix, that changes a little in every iteration,
+   * and a lot in iteration 10.
+   */
+  const unsigned int n = 20;
+  MatrixType         A( n, n );
+  for( unsigned int i = 0; i < n; ++i )
+  {
+    for( unsigned int j = 0; j <= i; ++j )
+    {
+      A( i, j ) = A( j, i ) = randomGenerator->GetNormalVariate();
+    }
+  }
+
+  EigenSystemType eigenSystem;
+  const double    tolerance = 1e-9;
+  for( unsigned int iteration = 0; iteration < 20; ++iteration )
+  {
+    const double change = iteration == 10 ? 1.0 : 1e-3;
+    for( unsigned int i = 0; i < n; ++i )
+    {
+      for( unsigned int j = 0; j <= i; ++j )
+      {
+        const double value = change * randomGenerator->GetNormalVariate();
+        A( i, j ) += value;
+        if( i != j ) { A( j, i ) += value; }
+      }
+    }
+
+    eigenSystem.Compute( A );
+    vnl_symmetric_eigensystem< double > eig( A );
+
+    if( eigenSystem.GetLastComputeWasWarmStarted() != ( iteration > 0 ) )
+    {
+      std::cerr << "ERROR: iteration " << iteration << " was "
+                << ( eigenSystem.GetLastComputeWasWarmStarted() ? "" : "not " )
+                << "warm started." << std::endl;
+      return 1;
+    }
+
+    /** Compare the eigenvalues, and check A v = lambda v and the orthonormality. */
+    const MatrixType & V = eigenSystem.GetEigenVectors();
+    for( unsigned int i = 0; i < n; ++i )
+    {
+      const double lambda = eigenSystem.GetEigenValue( i );
+      if( std::abs( lambda - eig.get_eigenvalue( i ) ) > tolerance )
+      {
+        std::cerr << "ERROR: in iteration " << iteration << " eigenvalue " << i << " is "
+                  << lambda << ", while " << eig.get_eigenvalue( i ) << " is expected." << std::endl;
+        return 1;
+      }
+
+      const VectorType v = eigenSystem.GetEigenVector( i );
+      const VectorType r = A * v - lambda * v;
+      if( r.inf_norm() > tolerance )
+      {
+        std::cerr << "ERROR: in iteration " << iteration << " eigenvector " << i
+                  << " has a residual of " << r.inf_norm() << "." << std::endl;
+        return 1;
+      }
+      for( unsigned int j = 0; j < n; ++j )
+      {
+        double dot = 0.0;
+        for( unsigned int k = 0; k < n; ++k )
+        {
+          dot += V( k, i ) * V( k, j );
+        }
+        if( std::abs( dot - ( i == j ? 1.0 : 0.0 ) ) > tolerance )
+        {
+          std::cerr << "ERROR: in iteration " << iteration << " the eigenvectors are not orthonormal." << std::endl;
+          return 1;
+        }
+      }
+    }
+
+    std::cerr << "Iteration " << iteration << ": "
+              << eigenSystem.GetNumberOfSweeps() << " sweeps." << std::endl;
+  }
+
+  /** A matrix of another size starts from scratch. */
+  MatrixType B( 3, 3 );
+  B.fill( 0.0 );
+  B( 0, 0 ) = 2.0; B( 1, 1 ) = -1.0; B( 2, 2 ) = 1.0;
+  eigenSystem.Compute( B );
+  if( eigenSystem.GetLastComputeWasWarmStarted()
+    || std::abs( eigenSystem.GetEigenValue( 0 ) + 1.0 ) > tolerance
+    || std::abs( eigenSystem.GetEigenValue( 2 ) - 2.0 ) > tolerance )
+  {
+    std::cerr << "ERROR: the decomposition of a matrix of another size is wrong." << std::endl;
+    return 1;
+  }
+
+  std::cerr << "The results are good." << std::endl;
+
+  /** Return a value. */
+  return 0;
+
+} // end main
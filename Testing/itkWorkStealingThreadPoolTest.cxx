@@ -0,0 +1,150 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkWorkStealingThreadPool.h"
+#include "itkMultiThreader.h"
+#include "itkTimeProbe.h"
+
+#include <iomanip>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+
+/** Callback for the comparison with the ITK threader, doing nothing. */
+ITK_THREAD_RETURN_TYPE
+EmptyThreaderCallback( void * )
+{
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  typedef itk::WorkStealingThreadPool PoolType;
+  PoolType::Pointer pool = PoolType::GetInstance();
+
+  /** The pool should be a single instance. */
+  if( pool.GetPointer() != PoolType::GetInstance().GetPointer() )
+  {
+    std::cerr << "ERROR: GetInstance() returned a different pool." << std::endl;
+    return 1;
+  }
+
+  const itk::ThreadIdType numberOfSlots = 8;
+  const unsigned int      repetitions   = 1000;
+
+  /** Check that every slot is executed exactly once. */
+  for( unsigned int r = 0; r < repetitions; ++r )
+  {
+    std::vector< unsigned int > counts( numberOfSlots, 0 );
+    pool->ParallelForSlots( numberOfSlots,
+      [ &counts ]( itk::ThreadIdType slot ) { ++counts[ slot ]; } );
+    for( itk::ThreadIdType i = 0; i < numberOfSlots; ++i )
+    {
+      if( counts[ i ] != 1 )
+      {
+        std::cerr << "ERROR: slot " << i << " executed " << counts[ i ] << " times." << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  /** Check that every element of a range is processed exactly once, with
+   * a deliberately uneven work load to trigger work stealing.
+   */
+  const itk::SizeValueType size      = 10007;
+  const itk::SizeValueType chunkSize = 37;
+  for( unsigned int r = 0; r < repetitions; ++r )
+  {
+    std::vector< unsigned char >      visited( size, 0 );
+    std::vector< itk::SizeValueType > perSlotSum( numberOfSlots, 0 );
+    pool->ParallelForChunks( numberOfSlots, size, chunkSize,
+      [ &visited, &perSlotSum ]( itk::ThreadIdType slot,
+      itk::SizeValueType begin, itk::SizeValueType end )
+      {
+        for( itk::SizeValueType i = begin; i < end; ++i )
+        {
+          ++visited[ i ];
+          perSlotSum[ slot ] += ( slot == 0 ) ? i % 7 : i;
+        }
+      } );
+
+    for( itk::SizeValueType i = 0; i < size; ++i )
+    {
+      if( visited[ i ] != 1 )
+      {
+        std::cerr << "ERROR: element " << i << " visited "
+                  << static_cast< unsigned int >( visited[ i ] ) << " times." << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  /** Exceptions should be propagated to the calling thread. */
+  bool caught = false;
+  try
+  {
+    pool->ParallelForSlots( numberOfSlots, []( itk::ThreadIdType slot )
+      {
+        if( slot == 3 ) { throw std::runtime_error( "slot 3" ); }
+      } );
+  }
+  catch( std::runtime_error & )
+  {
+    caught = true;
+  }
+  if( !caught )
+  {
+    std::cerr << "ERROR: the exception was not propagated." << std::endl;
+    return 1;
+  }
+
+  /** Compare the launch overhead with the ITK threader. */
+  itk::TimeProbe timerITK, timerPool;
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( numberOfSlots );
+#if ITK_VERSION_MAJOR < 5
+  threader->SetUseThreadPool( false );
+#endif
+  timerITK.Start();
+  for( unsigned int r = 0; r < repetitions; ++r )
+  {
+    threader->SetSingleMethod( EmptyThreaderCallback, 0 );
+    threader->SingleMethodExecute();
+  }
+  timerITK.Stop();
+
+  timerPool.Start();
+  for( unsigned int r = 0; r < repetitions; ++r )
+  {
+    pool->ParallelForSlots( numberOfSlots, []( itk::ThreadIdType ) {} );
+  }
+  timerPool.Stop();
+
+  std::cerr << std::fixed << std::setprecision( 3 );
+  std::cerr << "Launching " << repetitions << " times " << numberOfSlots << " threads took:\n"
+            << "  ITK threader: " << timerITK.GetMean() * 1000.0 << " ms\n"
+            << "  thread pool:  " << timerPool.GetMean() * 1000.0 << " ms" << std::endl;
+
+  std::cerr << "The results are good." << std::endl;
+
+  /** Return a value. */
+  return 0;
+
+} // end main